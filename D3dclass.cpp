@@ -31,9 +31,9 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	float screenDepth, float screenNear)
 {
 	HRESULT result;
-	std::shared_ptr<IDXGIFactory> factory;
-	std::shared_ptr<IDXGIAdapter> adapter;
-	std::shared_ptr<IDXGIOutput> adapterOutput;
+	IDXGIFactory* factory;
+	IDXGIAdapter* adapter;
+	IDXGIOutput* adapterOutput;
 	UINT numModes, numerator, denominator;
 	size_t stringLength;
 	std::unique_ptr<DXGI_MODE_DESC[]> displayModeList;
@@ -41,7 +41,7 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	int error;
 	DXGI_SWAP_CHAIN_DESC swapChainDesc;
 	D3D_FEATURE_LEVEL featureLevel;
-	std::shared_ptr<ID3D11Texture2D> backBufferPtr;
+	ID3D11Texture2D* backBufferPtr;
 	D3D11_TEXTURE2D_DESC depthBufferDesc;
 	D3D11_DEPTH_STENCIL_DESC depthStencilDesc;
 	D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc;
@@ -61,14 +61,14 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	}
 
 	// Use the factory to create an adapter for the primary graphics interface (video card).
-	result = factory->EnumAdapters(0, (IDXGIAdapter**)&adapter);
+	result = factory->EnumAdapters(0, &adapter);
 	if (FAILED(result))
 	{
 		return false;
 	}
 
 	// Enumerate the primary adapter output (monitor).
-	result = adapter->EnumOutputs(0, (IDXGIOutput**)&adapterOutput);
+	result = adapter->EnumOutputs(0, &adapterOutput);
 	if (FAILED(result))
 	{
 		return false;
@@ -135,11 +135,19 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	ofs.close();
 
 	// Release the display mode list
+	displayModeList.reset();
+
 	// Release the adapter output.
+	adapterOutput->Release();
+	adapterOutput = nullptr;
+
 	// Release the adapter.
-	// Release the factory.
+	adapter->Release();
+	adapter = nullptr;
 
-	//no need to release the above structures - smart pointer semantics innit
+	// Release the factory.
+	factory->Release();
+	factory = nullptr;
 
 	//first things we'll do is fill out description of swap chain. Swap chain is the front and back buffer - do all drawing
 	//to back buffer, then swap it to the front buffer
@@ -218,10 +226,10 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 											1,
 											D3D11_SDK_VERSION,
 											&swapChainDesc,
-											(IDXGISwapChain**)&m_swapChain,
-											(ID3D11Device**)&m_device,
+											&m_swapChain,
+											&m_device,
 											nullptr,
-											(ID3D11DeviceContext**)&m_deviceContext);
+											&m_deviceContext);
 
 	if (FAILED(result))
 	{
@@ -236,12 +244,16 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	}
 
 	// Create the render target view with the back buffer pointer.
-	result = m_device->CreateRenderTargetView(backBufferPtr.get(), NULL, (ID3D11RenderTargetView**)&m_renderTargetView);
+	result = m_device->CreateRenderTargetView(backBufferPtr, NULL, &m_renderTargetView);
 	if (FAILED(result))
 	{
 		return false;
 	}
 
+	// Release pointer to the back buffer as we no longer need it.
+	backBufferPtr->Release();
+	backBufferPtr = nullptr;
+
 	/*
 	We will also need to set up a depth buffer description.
 	We'll use this to create a depth buffer so that our polygons can be rendered properly in 3D space. 
@@ -273,7 +285,7 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	*/
 
 	// Create the texture for the depth buffer using the filled out description.
-	result = m_device->CreateTexture2D(&depthBufferDesc, nullptr, (ID3D11Texture2D**)&m_depthStencilBuffer);
+	result = m_device->CreateTexture2D(&depthBufferDesc, nullptr, &m_depthStencilBuffer);
 	if (FAILED(result))
 	{
 		return false;
@@ -304,14 +316,14 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	depthStencilDesc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
 
 	// Create the depth stencil state.
-	result = m_device->CreateDepthStencilState(&depthStencilDesc, (ID3D11DepthStencilState**)&m_depthStencilState);
+	result = m_device->CreateDepthStencilState(&depthStencilDesc, &m_depthStencilState);
 	if (FAILED(result))
 	{
 		return false;
 	}
 
 	//set DSS, with the device context
-	m_deviceContext->OMSetDepthStencilState(m_depthStencilState.get(), 1);
+	m_deviceContext->OMSetDepthStencilState(m_depthStencilState, 1);
 
 	//now need to create description of the view of the depth stencil buffer. We do this so
 	//Direct3D knows to use the depth buffer as a depth stencil texture After filling out the descripton we then 
@@ -327,7 +339,7 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	depthStencilViewDesc.Texture2D.MipSlice = 0;
 
 	// Create the depth stencil view.
-	result = m_device->CreateDepthStencilView(m_depthStencilBuffer.get(), &depthStencilViewDesc, (ID3D11DepthStencilView**)&m_depthStencilView);
+	result = m_device->CreateDepthStencilView(m_depthStencilBuffer, &depthStencilViewDesc, &m_depthStencilView);
 	if (FAILED(result))
 	{
 		return false;
@@ -340,7 +352,7 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	*/
 
 	// Bind the render target view and depth stencil buffer to the output render pipeline.
-	m_deviceContext->OMSetRenderTargets(1, (ID3D11RenderTargetView**)&m_renderTargetView, m_depthStencilView.get());
+	m_deviceContext->OMSetRenderTargets(1, &m_renderTargetView, m_depthStencilView);
 
 	/*
 	Now that the render targets are setup we can continue on to some extra functions that will give us more control over our scenes for future tutorials. 
@@ -362,14 +374,14 @@ bool D3DClass::Initialize(int screenWidth, int screenHeight, bool vsync, HWND hw
 	rasterDesc.SlopeScaledDepthBias = 0.0f;
 
 	// Create the rasterizer state from the description we just filled out.
-	result = m_device->CreateRasterizerState(&rasterDesc, (ID3D11RasterizerState**)&m_rasterState);
+	result = m_device->CreateRasterizerState(&rasterDesc, &m_rasterState);
 	if (FAILED(result))
 	{
 		return false;
 	}
 
 	// Now set the rasterizer state.
-	m_deviceContext->RSSetState(m_rasterState.get());
+	m_deviceContext->RSSetState(m_rasterState);
 
 	//The viewport also needs to be setup so that Direct3D can map clip space coordinates to the render target space.Set this to be the entire size of the window.
 
@@ -426,49 +438,49 @@ void D3DClass::Shutdown()
 	if (m_rasterState)
 	{
 		m_rasterState->Release();
-		//m_rasterState = 0;
+		m_rasterState = nullptr;
 	}
 
 	if (m_depthStencilView)
 	{
 		m_depthStencilView->Release();
-		//m_depthStencilView = 0;
+		m_depthStencilView = nullptr;
 	}
 
 	if (m_depthStencilState)
 	{
 		m_depthStencilState->Release();
-		//m_depthStencilState = 0;
+		m_depthStencilState = nullptr;
 	}
 
 	if (m_depthStencilBuffer)
 	{
 		m_depthStencilBuffer->Release();
-		//m_depthStencilBuffer = 0;
+		m_depthStencilBuffer = nullptr;
 	}
 
 	if (m_renderTargetView)
 	{
 		m_renderTargetView->Release();
-		//m_renderTargetView = 0;
+		m_renderTargetView = nullptr;
 	}
 
 	if (m_deviceContext)
 	{
 		m_deviceContext->Release();
-		//m_deviceContext = 0;
+		m_deviceContext = nullptr;
 	}
 
 	if (m_device)
 	{
 		m_device->Release();
-		//m_device = 0;
+		m_device = nullptr;
 	}
 
 	if (m_swapChain)
 	{
 		m_swapChain->Release();
-		//m_swapChain = 0;
+		m_swapChain = nullptr;
 	}
 
 	return;
@@ -488,10 +500,10 @@ void D3DClass::BeginScene(float red, float green, float blue, float alpha)
 	color[3] = alpha;
 
 	// Clear the back buffer.
-	m_deviceContext->ClearRenderTargetView(m_renderTargetView.get(), color);
+	m_deviceContext->ClearRenderTargetView(m_renderTargetView, color);
 
 	// Clear the depth buffer.
-	m_deviceContext->ClearDepthStencilView(m_depthStencilView.get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+	m_deviceContext->ClearDepthStencilView(m_depthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
 
 	return;
 }
@@ -513,13 +525,13 @@ void D3DClass::EndScene()
 	return;
 }
 
-std::shared_ptr<ID3D11Device> D3DClass::GetDevice()
+ID3D11Device* D3DClass::GetDevice()
 {
 	return m_device;
 }
 
 
-std::shared_ptr<ID3D11DeviceContext> D3DClass::GetDeviceContext()
+ID3D11DeviceContext* D3DClass::GetDeviceContext()
 {
 	return m_deviceContext;
 }
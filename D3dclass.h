@@ -37,8 +37,8 @@ public:
 	void BeginScene(float, float, float, float);
 	void EndScene();
 
-	std::shared_ptr<ID3D11Device> GetDevice();
-	std::shared_ptr<ID3D11DeviceContext> GetDeviceContext();
+	ID3D11Device* GetDevice();
+	ID3D11DeviceContext* GetDeviceContext();
 
 	void GetProjectionMatrix(DirectX::XMFLOAT4X4&);
 	void GetWorldMatrix(DirectX::XMFLOAT4X4&);
@@ -50,14 +50,14 @@ private:
 	bool m_vsync_enabled;
 	int m_videoCardMemory;
 	char m_videoCardDescription[128];
-	std::shared_ptr<IDXGISwapChain> m_swapChain;
-	std::shared_ptr<ID3D11Device> m_device;
-	std::shared_ptr<ID3D11DeviceContext> m_deviceContext;
-	std::shared_ptr<ID3D11RenderTargetView> m_renderTargetView;
-	std::shared_ptr<ID3D11Texture2D> m_depthStencilBuffer;
-	std::shared_ptr<ID3D11DepthStencilState> m_depthStencilState;
-	std::shared_ptr<ID3D11DepthStencilView> m_depthStencilView;
-	std::shared_ptr<ID3D11RasterizerState> m_rasterState;
+	IDXGISwapChain* m_swapChain;
+	ID3D11Device* m_device;
+	ID3D11DeviceContext* m_deviceContext;
+	ID3D11RenderTargetView* m_renderTargetView;
+	ID3D11Texture2D* m_depthStencilBuffer;
+	ID3D11DepthStencilState* m_depthStencilState;
+	ID3D11DepthStencilView* m_depthStencilView;
+	ID3D11RasterizerState* m_rasterState;
 	DirectX::XMFLOAT4X4 m_projectionMatrix;
 	DirectX::XMFLOAT4X4 m_worldMatrix;
 	DirectX::XMFLOAT4X4 m_orthoMatrix;
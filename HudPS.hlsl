@@ -0,0 +1,25 @@
+/////////////
+// GLOBALS //
+/////////////
+Texture2D shaderTexture;
+SamplerState SampleType;
+
+
+//////////////
+// TYPEDEFS //
+//////////////
+struct PixelInputType
+{
+	float4 position : SV_POSITION;
+	float2 tex : TEXCOORD0;
+	float4 color : COLOR;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Pixel Shader
+////////////////////////////////////////////////////////////////////////////////
+float4 HudPixelShader(PixelInputType input) : SV_TARGET
+{
+	// The atlas is white with the shape in its alpha, the vertex color tints it.
+	return shaderTexture.Sample(SampleType, input.tex) * input.color;
+}
\ No newline at end of file
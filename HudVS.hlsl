@@ -0,0 +1,49 @@
+/////////////
+// GLOBALS //
+/////////////
+cbuffer MatrixBuffer
+{
+	matrix worldMatrix;
+	matrix viewMatrix;
+	matrix projectionMatrix;
+};
+
+//////////////
+// TYPEDEFS //
+//////////////
+struct VertexInputType
+{
+	float2 position : POSITION;
+	float2 tex : TEXCOORD0;
+	float4 color : COLOR;
+};
+
+struct PixelInputType
+{
+	float4 position : SV_POSITION;
+	float2 tex : TEXCOORD0;
+	float4 color : COLOR;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Vertex Shader
+////////////////////////////////////////////////////////////////////////////////
+PixelInputType HudVertexShader(VertexInputType input)
+{
+	PixelInputType output;
+
+
+	// The quads are in screen pixels, the view matrix moves the origin to the top left corner.
+	output.position = float4(input.position, 0.0f, 1.0f);
+	output.position = mul(output.position, worldMatrix);
+	output.position = mul(output.position, viewMatrix);
+	output.position = mul(output.position, projectionMatrix);
+
+	// Keep the overlay on the near plane whatever the ortho depth range is.
+	output.position.z = 0.0f;
+
+	output.tex = input.tex;
+	output.color = input.color;
+
+	return output;
+}
\ No newline at end of file
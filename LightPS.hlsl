@@ -6,13 +6,36 @@ SamplerState SampleType;
 
 //2 vars inside the LightBuffer that hold diffuse color and direction of light. These will be set from the new LightClass object.
 
-cbuffer LightBuffer
+cbuffer LightBuffer : register(b0)
 {
 	float4 diffuseColor;
 	float3 lightDirection;
 	float  padding;
 };
 
+//The clustered variant reads its point and spot lights from three buffers ClusteredLightingClass fills every frame: the lights, the
+//offset and count of every cluster's run in the light index list, and the list itself. ClusterBuffer maps a pixel to its cluster.
+
+struct ClusteredLightType
+{
+	float3 position;
+	float range;
+	float3 color;
+	float spotCosine;
+	float3 direction;
+	float padding;
+};
+
+StructuredBuffer<ClusteredLightType> clusteredLights : register(t1);
+StructuredBuffer<uint2> lightClusters : register(t2);
+StructuredBuffer<uint> lightIndices : register(t3);
+
+cbuffer ClusterBuffer : register(b1)
+{
+	float4 clusterScale;
+	uint4 clusterGrid;
+};
+
 //////////////
 // TYPEDEFS //
 //////////////
@@ -23,6 +46,15 @@ struct PixelInputType
 	float3 normal : NORMAL;
 };
 
+struct ClusteredPixelInputType
+{
+	float4 position : SV_POSITION;
+	float2 tex : TEXCOORD0;
+	float3 normal : NORMAL;
+	float3 worldPosition : TEXCOORD1;
+	float viewDepth : TEXCOORD2;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // Pixel Shader
 ////////////////////////////////////////////////////////////////////////////////
@@ -51,4 +83,61 @@ float4 LightPixelShader(PixelInputType input) : SV_TARGET
 	color = color * textureColor;
 
 	return color;
-}
\ No newline at end of file
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Clustered Pixel Shader
+////////////////////////////////////////////////////////////////////////////////
+float4 ClusteredLightPixelShader(ClusteredPixelInputType input) : SV_TARGET
+{
+	float4 textureColor;
+	float3 normal;
+	float4 color;
+	uint3 cell;
+	uint2 cluster;
+	uint i;
+	ClusteredLightType light;
+	float3 toLight;
+	float lightDistance;
+	float attenuation;
+	float spot;
+
+
+	textureColor = shaderTexture.Sample(SampleType, input.tex);
+	normal = normalize(input.normal);
+
+	// The directional light, same as LightPixelShader.
+	color = diffuseColor * saturate(dot(normal, -lightDirection));
+
+	// Find the cluster: the tile from the pixel position and the slice from the log of the view depth.
+	cell.x = min((uint)(input.position.x * clusterScale.x), clusterGrid.x - 1);
+	cell.y = min((uint)(input.position.y * clusterScale.y), clusterGrid.y - 1);
+	cell.z = (uint)clamp(log(input.viewDepth) * clusterScale.z - clusterScale.w, 0.0f, (float)(clusterGrid.z - 1));
+	cluster = lightClusters[(cell.z * clusterGrid.y + cell.y) * clusterGrid.x + cell.x];
+
+	// Add every point and spot light listed for the cluster, falling off to nothing at the light's range.
+	for (i = 0; i < cluster.y; i++)
+	{
+		light = clusteredLights[lightIndices[cluster.x + i]];
+
+		toLight = light.position - input.worldPosition;
+		lightDistance = length(toLight);
+		toLight = toLight / max(lightDistance, 0.0001f);
+
+		attenuation = saturate(1.0f - lightDistance / light.range);
+		attenuation = attenuation * attenuation;
+
+		spot = 1.0f;
+		if (light.spotCosine > -1.0f)
+		{
+			spot = smoothstep(light.spotCosine, lerp(light.spotCosine, 1.0f, 0.2f), dot(-toLight, light.direction));
+		}
+
+		color.rgb += light.color * saturate(dot(normal, toLight)) * attenuation * spot;
+	}
+
+	color = saturate(color);
+	color = color * textureColor;
+
+	return color;
+}
@@ -27,6 +27,16 @@ struct PixelInputType
 	float3 normal : NORMAL;
 };
 
+//The clustered variant also needs the world position to light the pixel and the view depth to find its cluster.
+struct ClusteredPixelInputType
+{
+	float4 position : SV_POSITION;
+	float2 tex : TEXCOORD0;
+	float3 normal : NORMAL;
+	float3 worldPosition : TEXCOORD1;
+	float viewDepth : TEXCOORD2;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // Vertex Shader
 ////////////////////////////////////////////////////////////////////////////////
@@ -51,4 +61,32 @@ PixelInputType LightVertexShader(VertexInputType input)
 	output.normal = normalize(output.normal);
 
 	return output;
-}
\ No newline at end of file
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Clustered Vertex Shader
+////////////////////////////////////////////////////////////////////////////////
+ClusteredPixelInputType ClusteredLightVertexShader(VertexInputType input)
+{
+	ClusteredPixelInputType output;
+	float4 worldPosition;
+	float4 viewPosition;
+
+
+	input.position.w = 1.0f;
+
+	// Same transform as LightVertexShader, keeping the world and view space positions on the way.
+	worldPosition = mul(input.position, worldMatrix);
+	viewPosition = mul(worldPosition, viewMatrix);
+	output.position = mul(viewPosition, projectionMatrix);
+
+	output.worldPosition = worldPosition.xyz;
+	output.viewDepth = viewPosition.z;
+
+	output.tex = input.tex;
+
+	output.normal = mul(input.normal, (float3x3)worldMatrix);
+	output.normal = normalize(output.normal);
+
+	return output;
+}
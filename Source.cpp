@@ -1,22 +1,416 @@
 #include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#ifdef _WIN32
 #include "systemclass.h"
+#endif
+#include "framedriverclass.h"
+#include "profilerclass.h"
+#include "memorytrackerclass.h"
+#include "benchmarkclass.h"
 
+const int HEADLESS_FRAME_COUNT = 600;
+const int HEADLESS_WIDTH = 1280;
+const int HEADLESS_HEIGHT = 720;
 
+//the benchmarks --benchmark runs, at the sizes we usually measure with. A thread count of 0 goes up to one thread per core.
+struct BenchmarkType
+{
+	const char* name;
+	bool (*run)(BenchmarkClass&, std::ostream&);
+};
+
+static const BenchmarkType BENCHMARKS[] =
+{
+	{ "parallel-recording", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.ParallelRecording(out, 50000, 0, 10); } },
+	{ "snapshot-exchange", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.SnapshotExchange(out, 20000, 2); } },
+	{ "scene-graph", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.SceneGraph(out, 100000, 10.0f, 0, 20); } },
+	{ "spatial-queries", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.SpatialQueries(out, 10000, 10.0f, 1000); } },
+	{ "clustered-lighting", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.ClusteredLighting(out, 4096, 0, 5); } },
+	{ "job-system", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.JobSystem(out, 100000, 0); } },
+	{ "task-graph", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.TaskGraph(out, 200, 3); } },
+	{ "frame-arena", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.FrameArena(out, 100, 20000); } },
+	{ "resource-pool", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.ResourcePool(out, 10000, 10000000); } },
+	{ "geometry-pool", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.GeometryPool(out, 4096, 200000); } },
+	{ "dynamic-geometry", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.DynamicGeometry(out, 100, 2000); } },
+	{ "state-cache", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.StateCache(out, 100000); } },
+	{ "frame-pacing", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.FramePacing(out, 300, 60.0f); } },
+	{ "profiler", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.Profiler(out, 100000, 0); } },
+	{ "hitch-detection", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.HitchDetection(out, 1500, 2.0f); } },
+	{ "render-stats", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.RenderStats(out, 1000, 200); } },
+	{ "perf-hud", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.PerfHud(out, 2000); } },
+	{ "memory-tracking", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.MemoryTracking(out, 200000); } },
+	{ "input-latency", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.InputLatency(out, 200, 2.0f); } },
+	{ "input-queue", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.InputQueue(out, 2000000); } },
+	{ "parallel-startup", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.ParallelStartup(out, 0); } },
+	{ "software-rasterizer", [](BenchmarkClass& benchmark, std::ostream& out) { return benchmark.SoftwareRasterizer(out, 10); } },
+};
+
+/*
+RunBenchmarks runs the benchmark of the given name, or every one of them for "all", and writes their tables to the console. Every
+benchmark checks its own results, a failed one is named on the error output and makes the exit code 1.
+*/
+
+static int RunBenchmarks(const char* name)
+{
+	BenchmarkClass benchmark;
+	auto found = false;
+	auto failed = false;
+
+	for (auto& entry : BENCHMARKS)
+	{
+		if (strcmp(name, "all") != 0 && strcmp(name, entry.name) != 0)
+		{
+			continue;
+		}
+
+		found = true;
+		std::cout << entry.name << std::endl;
+		if (!entry.run(benchmark, std::cout))
+		{
+			std::cerr << "benchmark " << entry.name << " failed" << std::endl;
+			failed = true;
+		}
+		std::cout << std::endl;
+	}
+
+	if (!found)
+	{
+		std::cerr << "unknown benchmark " << name << ", one of all";
+		for (auto& entry : BENCHMARKS)
+		{
+			std::cerr << " " << entry.name;
+		}
+		std::cerr << std::endl;
+		return 1;
+	}
+
+	return failed ? 1 : 0;
+}
+
+/*
+RunHeadless runs the frames without a window and writes their stats, see FrameDriverClass. It takes
+--frames N, --camera path.txt, --csv stats.csv, --json stats.json, --trace trace.json, --hitches prefix, --render-stats file.csv,
+--hud, --latency latency.csv and --startup startup.csv, without --frames it runs HEADLESS_FRAME_COUNT frames or the length of the
+camera path, without --csv or --json it writes the csv to the console. --trace writes the profiler's Chrome trace of the run, --hitches
+turns on hitch detection with the dumps starting with the prefix, --render-stats logs the renderer's counters of every frame, --hud
+draws the performance overlay on every frame, so its cost is in the frame times, --latency writes the percentiles of the input to
+present latency and --startup the timeline of the tasks the scene was loaded with.
+--software renders the frames on the software rasterizer instead of the null device, the csv and json then have the rasterizer's time
+for every frame, and --save-frame frame.png (or .tga) writes the last frame it rendered.
+--memory snapshot.csv writes the memory tracker's snapshot after the last frame, and --memory-diff before.csv after.csv writes the
+changes between two snapshots to the console without running anything. Whatever is still tracked after the shutdown is listed on the
+error output.
+--benchmark name runs one of the BenchmarkClass benchmarks, or all of them, instead of the frames, see RunBenchmarks.
+An unknown option, or one without its value, prints the usage and runs nothing. Anything that fails is named on the error output, for
+the scene the step or startup task that failed, and the startup timeline is still written when the scene failed to load.
+*/
+
+static void PrintUsage(const char* program)
+{
+	std::cerr << "usage: " << program << " [--frames N] [--camera path.txt] [--csv stats.csv] [--json stats.json] [--trace trace.json]" << std::endl
+		<< "\t[--hitches prefix] [--render-stats file.csv] [--hud] [--latency latency.csv] [--startup startup.csv]" << std::endl
+		<< "\t[--memory snapshot.csv] [--software] [--save-frame frame.png|frame.tga]" << std::endl
+		<< "       " << program << " --memory-diff before.csv after.csv" << std::endl
+		<< "       " << program << " --benchmark name|all" << std::endl;
+
+	return;
+}
+
+static int RunHeadless(int argc, char* argv[])
+{
+	FrameDriverClass driver;
+	const char* cameraPath = nullptr;
+	const char* csvFile = nullptr;
+	const char* jsonFile = nullptr;
+	const char* traceFile = nullptr;
+	const char* renderStatsFile = nullptr;
+	const char* memoryFile = nullptr;
+	const char* latencyFile = nullptr;
+	const char* startupFile = nullptr;
+	const char* frameFile = nullptr;
+	auto hud = false;
+	auto software = false;
+	std::ofstream fout;
+	std::ifstream before, after;
+	std::ostringstream leaks;
+	char* end;
+	int frameCount = -1;
+	auto result = false;
+
+	for (auto i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			frameCount = (int)strtol(argv[++i], &end, 10);
+			if (*end != '\0' || frameCount < 0)
+			{
+				std::cerr << "--frames takes a number of frames, not " << argv[i] << std::endl;
+				PrintUsage(argv[0]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--camera") == 0 && i + 1 < argc)
+		{
+			cameraPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+		{
+			csvFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			jsonFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+		{
+			traceFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--hitches") == 0 && i + 1 < argc)
+		{
+			driver.SetHitchDetection(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--render-stats") == 0 && i + 1 < argc)
+		{
+			renderStatsFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--hud") == 0)
+		{
+			hud = true;
+		}
+		else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc)
+		{
+			latencyFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--startup") == 0 && i + 1 < argc)
+		{
+			startupFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--software") == 0)
+		{
+			software = true;
+		}
+		else if (strcmp(argv[i], "--save-frame") == 0 && i + 1 < argc)
+		{
+			frameFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc)
+		{
+			memoryFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--memory-diff") == 0 && i + 2 < argc)
+		{
+			before.open(argv[i + 1]);
+			after.open(argv[i + 2]);
+			if (before.fail() || after.fail())
+			{
+				std::cerr << "could not read " << (before.fail() ? argv[i + 1] : argv[i + 2]) << std::endl;
+				return 1;
+			}
+			return MemoryTrackerClass::DiffSnapshots(before, after, std::cout) ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+		{
+			return RunBenchmarks(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--headless") == 0)
+		{
+			//WinMain hands the whole command line over, the --headless it was started for included
+		}
+		else
+		{
+			std::cerr << argv[i] << " is not an option or is missing its value" << std::endl;
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (frameFile && !software)
+	{
+		std::cerr << "--save-frame needs --software, only the software rasterizer has a frame to save" << std::endl;
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	if (renderStatsFile && software)
+	{
+		std::cerr << "--render-stats needs the null device, the software rasterizer has no render stats" << std::endl;
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	if (frameCount < 0)
+	{
+		frameCount = cameraPath ? 0 : HEADLESS_FRAME_COUNT;
+	}
+
+	ProfilerClass::Initialize();
+	PROFILE_THREAD_NAME("main thread");
+	MemoryTrackerClass::LoadBudgets(MEMORY_BUDGET_FILE);
+
+	result = driver.Initialize(HEADLESS_WIDTH, HEADLESS_HEIGHT, software);
+	if (!result)
+	{
+		std::cerr << "could not initialize the scene";
+		if (driver.GetFailedStartupTask())
+		{
+			std::cerr << ", startup task " << driver.GetFailedStartupTask() << " failed";
+		}
+		else if (driver.GetFailedStep())
+		{
+			std::cerr << ", " << driver.GetFailedStep() << " failed";
+		}
+		std::cerr << std::endl;
+	}
+
+	//the timeline is most useful when the scene did not load, it shows which task failed and which were skipped for it
+	if (startupFile)
+	{
+		fout.open(startupFile);
+		driver.WriteStartup(fout);
+		fout.close();
+		if (fout.fail())
+		{
+			std::cerr << "could not write " << startupFile << std::endl;
+			result = false;
+		}
+	}
+
+	if (result && cameraPath)
+	{
+		result = driver.LoadCameraPath(cameraPath);
+		if (!result)
+		{
+			std::cerr << "could not load the camera path " << cameraPath << std::endl;
+		}
+	}
+	if (result && renderStatsFile)
+	{
+		result = driver.SetRenderStatsLog(renderStatsFile);
+		if (!result)
+		{
+			std::cerr << "could not open the render stats log " << renderStatsFile << std::endl;
+		}
+	}
+	if (result && hud)
+	{
+		result = driver.SetHudVisible(true);
+	}
+	if (result)
+	{
+		result = driver.Run(frameCount);
+		if (!result)
+		{
+			std::cerr << "a frame failed to run" << std::endl;
+		}
+	}
+
+	if (result && frameFile)
+	{
+		result = driver.SaveFrame(frameFile);
+		if (!result)
+		{
+			std::cerr << "could not save the frame to " << frameFile << std::endl;
+		}
+	}
+
+	if (result && csvFile)
+	{
+		fout.open(csvFile);
+		driver.WriteCSV(fout);
+		fout.close();
+		result = !fout.fail();
+		if (!result)
+		{
+			std::cerr << "could not write " << csvFile << std::endl;
+		}
+	}
+
+	if (result && jsonFile)
+	{
+		fout.open(jsonFile);
+		driver.WriteJSON(fout);
+		fout.close();
+		result = !fout.fail();
+		if (!result)
+		{
+			std::cerr << "could not write " << jsonFile << std::endl;
+		}
+	}
+
+	if (result && traceFile)
+	{
+		result = ProfilerClass::WriteTraceFile(traceFile);
+		if (!result)
+		{
+			std::cerr << "could not write " << traceFile << std::endl;
+		}
+	}
+
+	if (result && latencyFile)
+	{
+		fout.open(latencyFile);
+		driver.WriteLatency(fout);
+		fout.close();
+		result = !fout.fail();
+		if (!result)
+		{
+			std::cerr << "could not write " << latencyFile << std::endl;
+		}
+	}
+
+	if (result && memoryFile)
+	{
+		fout.open(memoryFile);
+		MemoryTrackerClass::WriteSnapshot(fout);
+		fout.close();
+		result = !fout.fail();
+		if (!result)
+		{
+			std::cerr << "could not write " << memoryFile << std::endl;
+		}
+	}
+
+	if (result && !csvFile && !jsonFile)
+	{
+		driver.WriteCSV(std::cout);
+	}
+
+	driver.Shutdown();
+
+	if (MemoryTrackerClass::WriteLeakReport(leaks) > 0)
+	{
+		std::cerr << leaks.str();
+	}
+
+	return result ? 0 : 1;
+}
+
+#ifdef _WIN32
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR pScmdline, int iCmdshow) {
-	
+
 	auto result = false;
 
+	//--headless runs the frame driver instead of opening a window
+	if (strstr(pScmdline, "--headless"))
+	{
+		return RunHeadless(__argc, __argv);
+	}
+
 	//create the system class
 	std::unique_ptr<SystemClass> System(new SystemClass());
 
-	if (System == nullptr) 
+	if (System == nullptr)
 	{
 		return 0;
 	}
 
-	//init the system 
+	//init the system
 	result = System->Initialize();
-	if (result) 
+	if (result)
 	{
 		System->Run();
 	}
@@ -26,4 +420,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR pScmdline,
 
 	return 0;
 }
-
+#else
+//there is no window to open anywhere else, the engine only runs headless
+int main(int argc, char* argv[])
+{
+	return RunHeadless(argc, argv);
+}
+#endif
@@ -0,0 +1,3873 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: benchmarkclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "benchmarkclass.h"
+#include "nullrenderdeviceclass.h"
+#include "parallelrecorderclass.h"
+#include "lightshaderclass.h"
+#include "snapshotexchangeclass.h"
+#include "scenegraphclass.h"
+#include "spatialindexclass.h"
+#include "clusteredlightingclass.h"
+#include "cameraclass.h"
+#include "jobsystemclass.h"
+#include "taskgraphclass.h"
+#include "framearenaclass.h"
+#include "resourcepoolclass.h"
+#include "geometrypoolclass.h"
+#include "immediategeometryclass.h"
+#include "statecacheclass.h"
+#include "framepacerclass.h"
+#include "profilerclass.h"
+#include "hitchdetectorclass.h"
+#include "renderstatsclass.h"
+#include "spritebatchclass.h"
+#include "perfhudclass.h"
+#include "memorytrackerclass.h"
+#include "gpumemoryclass.h"
+#include "latencytrackerclass.h"
+#include "eventqueueclass.h"
+#include "inputclass.h"
+#include "startupschedulerclass.h"
+#include "softwarerasterizerclass.h"
+#include <DirectXMath.h>
+#include <vector>
+#include <thread>
+#include <iomanip>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+using namespace DirectX;
+
+BenchmarkClass::BenchmarkClass()
+{
+}
+
+BenchmarkClass::BenchmarkClass(const BenchmarkClass& other)
+{
+}
+
+
+BenchmarkClass::~BenchmarkClass()
+{
+}
+
+/*
+ParallelRecording builds a synthetic scene of drawCount objects, every one with its own world matrix, and records it the way
+GraphicsClass::Render does: vertex and index buffer binds followed by the LightShaderClass draw with its two constant buffer updates.
+The same frames are recorded with a growing number of threads. Every thread count has to produce the exact same number of draws and
+uploaded bytes, otherwise the split lost or duplicated work and the benchmark fails. The binds differ since every slice binds its state
+again, but the binds the device got plus the ones the recorder's state filters dropped have to add up to the same number.
+*/
+
+bool BenchmarkClass::ParallelRecording(std::ostream& out, int drawCount, int maxThreads, int frameCount)
+{
+	NullRenderDeviceClass device;
+	StateCacheClass states;
+	LightShaderClass lightShader;
+	RenderBufferDesc bufferDesc;
+	RenderTextureDesc textureDesc;
+	RenderHandle vertexBuffer, indexBuffer, texture;
+	std::vector<XMFLOAT4X4> worldMatrices(drawCount);
+	std::vector<int> threadCounts;
+	NullRenderDeviceClass::CountersType baseline;
+	StateFilterContextClass::StatsType filterStats;
+	unsigned long long baselineRequested;
+	float baselineTime;
+	bool result;
+
+	if (maxThreads <= 0)
+	{
+		maxThreads = (int)std::thread::hardware_concurrency();
+		if (maxThreads <= 0)
+		{
+			maxThreads = 1;
+		}
+	}
+
+	// 1, 2, 4.. threads and always the full count at the end.
+	for (auto threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	device.Initialize();
+	states.Initialize(&device);
+
+	result = lightShader.Initialize(&device, &states);
+	if (!result)
+	{
+		return false;
+	}
+
+	// A 36 vertex cube like model.txt, the null device only looks at the sizes.
+	bufferDesc.usage = RENDER_USAGE_DEFAULT;
+	bufferDesc.byteWidth = 36 * 32;
+	bufferDesc.bindType = RENDER_BIND_VERTEX_BUFFER;
+	vertexBuffer = device.CreateBuffer(bufferDesc, nullptr);
+
+	bufferDesc.byteWidth = 36 * sizeof(unsigned int);
+	bufferDesc.bindType = RENDER_BIND_INDEX_BUFFER;
+	indexBuffer = device.CreateBuffer(bufferDesc, nullptr);
+
+	textureDesc.width = 256;
+	textureDesc.height = 256;
+	textureDesc.format = RENDER_FORMAT_R8G8B8A8_UNORM;
+	textureDesc.generateMips = true;
+	texture = device.CreateTexture2D(textureDesc, nullptr, 256 * 4);
+
+	// Spread the objects over a grid and give each one its own rotation.
+	for (auto i = 0; i < drawCount; i++)
+	{
+		XMMATRIX world = XMMatrixMultiply(XMMatrixRotationY((float)i * 0.01f), XMMatrixTranslation((float)(i % 250) * 4.0f, (float)(i / 250) * 4.0f, 0.0f));
+		XMStoreFloat4x4(&worldMatrices[i], world);
+	}
+
+	XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(500.0f, 400.0f, -600.0f, 1.0f), XMVectorSet(500.0f, 400.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PI / 4.0f, 800.0f / 600.0f, 0.1f, 1000.0f);
+	XMFLOAT3 lightDirection(0.0f, 0.0f, 1.0f);
+	XMFLOAT4 diffuseColor(1.0f, 1.0f, 1.0f, 1.0f);
+
+	auto record = [&](RenderContextClass* context, int first, int last)
+	{
+		for (auto i = first; i < last; i++)
+		{
+			context->SetVertexBuffer(0, vertexBuffer, 32, 0);
+			context->SetIndexBuffer(indexBuffer, RENDER_FORMAT_R32_UINT, 0);
+			context->SetPrimitiveTopology(RENDER_TOPOLOGY_TRIANGLELIST);
+			lightShader.Render(context, 36, 0, 0, XMLoadFloat4x4(&worldMatrices[i]), view, projection, texture, lightDirection, diffuseColor);
+		}
+	};
+
+	out << "parallel recording: " << drawCount << " draws, " << frameCount << " frames" << std::endl;
+	out << "threads  record ms  execute ms  total ms  speedup  binds/frame  filtered" << std::endl;
+
+	baselineTime = 0.0f;
+	baselineRequested = 0;
+	memset(&baseline, 0, sizeof(baseline));
+
+	for (auto threads : threadCounts)
+	{
+		JobSystemClass jobs;
+		ParallelRecorderClass recorder;
+		float recordTime, executeTime, totalTime;
+
+		result = jobs.Initialize(threads);
+		if (!result)
+		{
+			return false;
+		}
+
+		result = recorder.Initialize(&device, &jobs, 256);
+		if (!result)
+		{
+			jobs.Shutdown();
+			return false;
+		}
+
+		// One warm up frame so the command buffers have grown to their final size.
+		recorder.Record(drawCount, record);
+		device.ResetCounters();
+		recorder.ResetFilterStats();
+
+		recordTime = 0.0f;
+		executeTime = 0.0f;
+		for (auto frame = 0; frame < frameCount; frame++)
+		{
+			recorder.Record(drawCount, record);
+			recordTime += recorder.GetRecordTime();
+			executeTime += recorder.GetExecuteTime();
+		}
+		recordTime /= (float)frameCount;
+		executeTime /= (float)frameCount;
+		totalTime = recordTime + executeTime;
+
+		recorder.GetFilterStats(filterStats);
+		recorder.Shutdown();
+		jobs.Shutdown();
+
+		// Every thread count has to submit exactly the same work.
+		const NullRenderDeviceClass::CountersType& counters = device.GetCounters();
+		if (threads == 1)
+		{
+			baseline = counters;
+			baselineRequested = counters.binds + filterStats.filtered;
+			baselineTime = totalTime;
+		}
+		else if (counters.draws != baseline.draws || counters.binds + filterStats.filtered != baselineRequested ||
+			counters.bytesUploaded != baseline.bytesUploaded)
+		{
+			out << "threads " << threads << " submitted different work than 1 thread" << std::endl;
+			return false;
+		}
+
+		out << std::setw(7) << threads << std::fixed << std::setprecision(3)
+			<< std::setw(11) << recordTime << std::setw(12) << executeTime << std::setw(10) << totalTime
+			<< std::setprecision(2) << std::setw(8) << (totalTime > 0.0f ? baselineTime / totalTime : 0.0f) << "x"
+			<< std::setprecision(1) << std::setw(13) << (float)counters.binds / (float)frameCount
+			<< std::setw(9) << 100.0f * (float)filterStats.filtered / (float)(filterStats.issued + filterStats.filtered) << "%" << std::endl;
+	}
+
+	lightShader.Shutdown();
+	states.Shutdown();
+	device.Shutdown();
+
+	return true;
+}
+
+/*
+SnapshotExchange runs a producer and a consumer thread against one SnapshotExchangeClass like the simulation and render threads do,
+with a random amount of busy work on both sides so every interleaving gets hit. Each snapshot is a block of words derived from its
+frame number. The consumer checks that every snapshot it gets is complete (no word from another frame, so nothing was written into
+a slot it was reading), that frame numbers only go up, and that the producer never got more than depth frames ahead of it.
+*/
+
+struct StressSnapshotType
+{
+	unsigned long long frame;
+	unsigned int words[256];
+};
+
+static unsigned int StressWord(unsigned long long frame, int index)
+{
+	unsigned int x = (unsigned int)(frame * 2654435761ULL) ^ (unsigned int)(index * 40503);
+	x ^= x >> 15;
+	x *= 2246822519U;
+	x ^= x >> 13;
+	return x;
+}
+
+static void StressSpin(unsigned int& seed, unsigned int maxIterations)
+{
+	volatile unsigned int sink = 0;
+	unsigned int count;
+
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	count = seed % maxIterations;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		sink += i;
+	}
+
+	return;
+}
+
+bool BenchmarkClass::SnapshotExchange(std::ostream& out, int frameCount, int depth)
+{
+	std::unique_ptr<SnapshotExchangeClass<StressSnapshotType>> exchange;
+	std::atomic<bool> stop(false);
+	std::atomic<bool> failed(false);
+	unsigned long long consumed, lastFrame, maxLag;
+
+	exchange.reset(new SnapshotExchangeClass<StressSnapshotType>());
+	exchange->Initialize(depth);
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// The consumer, the render thread's side.
+	std::thread consumer([&]()
+	{
+		unsigned int seed = 0x9e3779b9;
+		const StressSnapshotType* snapshot;
+
+		consumed = 0;
+		lastFrame = 0;
+		maxLag = 0;
+
+		while (!failed && (!stop || exchange->GetCompletedFrame() != (unsigned long long)frameCount))
+		{
+			snapshot = exchange->WaitForSnapshot(stop);
+			if (!snapshot)
+			{
+				continue;
+			}
+
+			if (snapshot->frame != exchange->GetAcquiredFrame() || snapshot->frame <= lastFrame)
+			{
+				failed = true;
+			}
+
+			for (auto i = 0; i < 256; i++)
+			{
+				if (snapshot->words[i] != StressWord(snapshot->frame, i))
+				{
+					failed = true;
+					break;
+				}
+			}
+
+			if (exchange->GetPublishedFrame() - snapshot->frame > maxLag)
+			{
+				maxLag = exchange->GetPublishedFrame() - snapshot->frame;
+			}
+
+			StressSpin(seed, 4000);
+
+			lastFrame = snapshot->frame;
+			consumed++;
+			exchange->Complete();
+		}
+
+		// The producer may be asleep waiting for a frame that is not going to complete.
+		exchange->Notify();
+	});
+
+	// The producer, the simulation's side, runs on this thread.
+	unsigned int seed = 0x85ebca6b;
+	for (unsigned long long frame = 1; frame <= (unsigned long long)frameCount && !failed; frame++)
+	{
+		if (!exchange->WaitForConsumer(failed))
+		{
+			break;
+		}
+
+		// The consumer must have finished everything but the last depth - 1 frames.
+		if (depth > 0 && frame - 1 - exchange->GetCompletedFrame() >= (unsigned long long)depth)
+		{
+			failed = true;
+			break;
+		}
+
+		StressSnapshotType& snapshot = exchange->GetWriteSlot();
+		snapshot.frame = frame;
+		for (auto i = 0; i < 256; i++)
+		{
+			snapshot.words[i] = StressWord(frame, i);
+		}
+
+		StressSpin(seed, 4000);
+
+		exchange->Publish(frame);
+	}
+
+	stop = true;
+	exchange->Notify();
+	consumer.join();
+
+	if (failed)
+	{
+		out << "snapshot exchange depth " << depth << ": FAILED" << std::endl;
+		return false;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	float seconds = std::chrono::duration<float>(end - start).count();
+
+	out << "snapshot exchange depth " << depth << ": " << frameCount << " frames published, " << consumed << " rendered, "
+		<< frameCount - consumed << " replaced before rendering, max lag " << maxLag << ", "
+		<< std::fixed << std::setprecision(0) << (seconds > 0.0f ? (float)frameCount / seconds : 0.0f) << " frames/s" << std::endl;
+
+	return true;
+}
+
+/*
+SceneGraph builds a random hierarchy of nodeCount nodes (every node hangs below a random node in the first quarter of the ones added
+before it, which gives a bushy tree about ten levels deep) and moves a random dirtyPercent of them every frame. The incremental
+update is timed with 1, 2, 4.. up to maxThreads threads against the simple approach of recomputing every world matrix in creation
+order. After every frame the scene graph's world matrices have to match the full recompute bit for bit.
+*/
+
+bool BenchmarkClass::SceneGraph(std::ostream& out, int nodeCount, float dirtyPercent, int maxThreads, int frameCount)
+{
+	std::vector<int> parents(nodeCount), depths(nodeCount);
+	std::vector<XMFLOAT4X4> local(nodeCount), world(nodeCount);
+	std::vector<int> threadCounts;
+	std::mt19937 random(12345);
+	int dirtyCount, depth;
+	float fullTime;
+	bool result;
+
+	if (maxThreads <= 0)
+	{
+		maxThreads = (int)std::thread::hardware_concurrency();
+		if (maxThreads <= 0)
+		{
+			maxThreads = 1;
+		}
+	}
+
+	for (auto threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	dirtyCount = (int)((float)nodeCount * dirtyPercent / 100.0f);
+	if (dirtyCount < 1)
+	{
+		dirtyCount = 1;
+	}
+
+	// Node 0 is the only root, everybody else gets an older parent and a small offset from it.
+	parents[0] = -1;
+	depths[0] = 1;
+	depth = 1;
+	for (auto i = 1; i < nodeCount; i++)
+	{
+		parents[i] = (int)(random() % (unsigned int)((i + 3) / 4));
+		depths[i] = depths[parents[i]] + 1;
+		depth = depths[i] > depth ? depths[i] : depth;
+	}
+	for (auto i = 0; i < nodeCount; i++)
+	{
+		XMStoreFloat4x4(&local[i], XMMatrixMultiply(XMMatrixRotationZ((float)(i % 360) * 0.01f), XMMatrixTranslation(1.0f, 0.5f, 0.0f)));
+	}
+
+	// The frames, the same for every run: which nodes move and the rotation they get.
+	std::vector<int> dirtyNodes((size_t)dirtyCount * frameCount);
+	for (auto& node : dirtyNodes)
+	{
+		node = (int)(random() % (unsigned int)nodeCount);
+	}
+
+	out << "scene graph: " << nodeCount << " nodes in " << depth << " levels, " << dirtyCount << " moving per frame, " << frameCount << " frames" << std::endl;
+
+	// The reference: every node recomputed every frame, parents are always older than their children.
+	auto fullUpdate = [&]()
+	{
+		for (auto i = 0; i < nodeCount; i++)
+		{
+			XMMATRIX w = XMLoadFloat4x4(&local[i]);
+			if (parents[i] >= 0)
+			{
+				w = XMMatrixMultiply(w, XMLoadFloat4x4(&world[parents[i]]));
+			}
+			XMStoreFloat4x4(&world[i], w);
+		}
+	};
+
+	fullTime = 0.0f;
+	for (auto frame = 0; frame < frameCount; frame++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		fullUpdate();
+		auto end = std::chrono::high_resolution_clock::now();
+		fullTime += std::chrono::duration<float, std::milli>(end - start).count();
+	}
+	fullTime /= (float)frameCount;
+
+	out << "full recompute " << std::fixed << std::setprecision(3) << fullTime << " ms" << std::endl;
+	out << "threads  update ms  nodes updated  speedup" << std::endl;
+
+	for (auto threads : threadCounts)
+	{
+		JobSystemClass jobs;
+		SceneGraphClass graph;
+		std::vector<XMFLOAT4X4> frameLocal(local);
+		float updateTime;
+		long long updatedCount;
+
+		result = jobs.Initialize(threads);
+		if (!result)
+		{
+			return false;
+		}
+
+		result = graph.Initialize(&jobs);
+		if (!result)
+		{
+			jobs.Shutdown();
+			return false;
+		}
+
+		// Handles come out in creation order, so node i is handle i.
+		graph.Reserve(nodeCount);
+		for (auto i = 0; i < nodeCount; i++)
+		{
+			graph.AddNode(parents[i]);
+			graph.SetLocalTransform(i, XMLoadFloat4x4(&local[i]));
+		}
+		graph.Update();
+
+		updateTime = 0.0f;
+		updatedCount = 0;
+		for (auto frame = 0; frame < frameCount; frame++)
+		{
+			for (auto d = 0; d < dirtyCount; d++)
+			{
+				int node = dirtyNodes[(size_t)frame * dirtyCount + d];
+				XMStoreFloat4x4(&frameLocal[node], XMMatrixMultiply(XMMatrixRotationZ((float)frame * 0.1f), XMMatrixTranslation(1.0f, 0.5f, 0.0f)));
+				graph.SetLocalTransform(node, XMLoadFloat4x4(&frameLocal[node]));
+			}
+
+			graph.Update();
+			updateTime += graph.GetUpdateTime();
+			updatedCount += graph.GetUpdatedCount();
+		}
+		updateTime /= (float)frameCount;
+
+		// Check the final state against a full recompute of the same local transforms.
+		local.swap(frameLocal);
+		fullUpdate();
+		local.swap(frameLocal);
+
+		for (auto i = 0; i < nodeCount; i++)
+		{
+			XMFLOAT4X4 nodeWorld;
+			graph.GetWorldTransform(i, nodeWorld);
+			if (memcmp(&nodeWorld, &world[i], sizeof(XMFLOAT4X4)) != 0)
+			{
+				out << "threads " << threads << ": node " << i << " does not match the full recompute" << std::endl;
+				graph.Shutdown();
+				jobs.Shutdown();
+				return false;
+			}
+		}
+
+		graph.Shutdown();
+		jobs.Shutdown();
+
+		out << std::setw(7) << threads << std::fixed << std::setprecision(3) << std::setw(11) << updateTime
+			<< std::setw(15) << updatedCount / frameCount
+			<< std::setprecision(2) << std::setw(8) << (updateTime > 0.0f ? fullTime / updateTime : 0.0f) << "x" << std::endl;
+	}
+
+	return true;
+}
+
+/*
+SpatialQueries scatters objectCount boxes over a 2000 unit cube, mostly small with the odd large one, and makes dynamicPercent of them
+dynamic. Every round moves all the dynamic objects a little and then runs one query of each kind through the spatial index and
+through a brute force loop over all the boxes using the same tests. The two have to return exactly the same objects (and the same
+nearest hit for rays), then the average time per query is reported for both.
+
+The queries are aimed at objects so they never come back empty, two empty lists agreeing would prove nothing: the camera looks at a
+random object from QUERY_DISTANCE away and casts the ray straight through its center, the sphere and the box are centered on other
+random objects. A query that finds nothing fails the benchmark.
+*/
+
+bool BenchmarkClass::SpatialQueries(std::ostream& out, int objectCount, float dynamicPercent, int queryCount)
+{
+	const float QUERY_DISTANCE = 150.0f;
+	const float QUERY_SIZE = 100.0f;
+	SpatialIndexClass index;
+	std::vector<SpatialIndexClass::BoundsType> bounds(objectCount);
+	std::vector<int> handles(objectCount), dynamicObjects, results, expected;
+	std::mt19937 random(4242);
+	std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::uniform_int_distribution<int> object(0, std::max(objectCount - 1, 0));
+	float indexTime[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float bruteTime[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const char* names[4] = { "frustum", "sphere", "box", "ray" };
+	long long found[4] = { 0, 0, 0, 0 };
+	float buildTime, moveTime, distance, bestDistance, t;
+	int hit, bestHandle;
+	bool result;
+
+	if (objectCount <= 0 || queryCount <= 0)
+	{
+		return false;
+	}
+
+	result = index.Initialize(XMFLOAT3(0.0f, 0.0f, 0.0f), 1024.0f, 8);
+	if (!result)
+	{
+		return false;
+	}
+
+	auto makeBox = [&](XMFLOAT3 center, float size, SpatialIndexClass::BoundsType& box)
+	{
+		box.minimum = XMFLOAT3(center.x - size, center.y - size, center.z - size);
+		box.maximum = XMFLOAT3(center.x + size, center.y + size, center.z + size);
+	};
+
+	auto getCenter = [&](int i)
+	{
+		return XMFLOAT3((bounds[i].minimum.x + bounds[i].maximum.x) * 0.5f, (bounds[i].minimum.y + bounds[i].maximum.y) * 0.5f,
+			(bounds[i].minimum.z + bounds[i].maximum.z) * 0.5f);
+	};
+
+	// Build everything up front and time the first Update, which builds the BVH.
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto i = 0; i < objectCount; i++)
+	{
+		bool isDynamic = unit(random) * 100.0f < dynamicPercent;
+		float size = unit(random) < 0.01f ? 20.0f + unit(random) * 30.0f : 0.5f + unit(random) * 4.5f;
+
+		makeBox(XMFLOAT3(position(random), position(random), position(random)), size, bounds[i]);
+		handles[i] = index.Insert(bounds[i], !isDynamic);
+		if (isDynamic)
+		{
+			dynamicObjects.push_back(i);
+		}
+	}
+	index.Update();
+	auto end = std::chrono::high_resolution_clock::now();
+	buildTime = std::chrono::duration<float, std::milli>(end - start).count();
+
+	// The same test the index uses run over every box. Handles map one to one onto objects since nothing was removed.
+	auto bruteForce = [&](auto test)
+	{
+		expected.clear();
+		for (auto i = 0; i < objectCount; i++)
+		{
+			if (test(bounds[i]))
+			{
+				expected.push_back(handles[i]);
+			}
+		}
+	};
+
+	auto compare = [&](int kind) -> bool
+	{
+		std::sort(results.begin(), results.end());
+		std::sort(expected.begin(), expected.end());
+		found[kind] += (long long)expected.size();
+		if (expected.empty())
+		{
+			out << names[kind] << " query found nothing to compare" << std::endl;
+			return false;
+		}
+		if (results != expected)
+		{
+			out << names[kind] << " query returned " << results.size() << " objects, brute force " << expected.size() << std::endl;
+			return false;
+		}
+		return true;
+	};
+
+	auto timeIt = [](float& total, auto work)
+	{
+		auto workStart = std::chrono::high_resolution_clock::now();
+		work();
+		auto workEnd = std::chrono::high_resolution_clock::now();
+		total += std::chrono::duration<float, std::milli>(workEnd - workStart).count();
+	};
+
+	moveTime = 0.0f;
+	for (auto query = 0; query < queryCount; query++)
+	{
+		// Nudge every dynamic object, now and then one jumps somewhere else entirely.
+		timeIt(moveTime, [&]()
+		{
+			for (auto i : dynamicObjects)
+			{
+				XMFLOAT3 center = getCenter(i);
+				float size = (bounds[i].maximum.x - bounds[i].minimum.x) * 0.5f;
+				if (unit(random) < 0.01f)
+				{
+					center = XMFLOAT3(position(random), position(random), position(random));
+				}
+				else
+				{
+					center.x += unit(random) * 2.0f - 1.0f;
+					center.z += unit(random) * 2.0f - 1.0f;
+				}
+				makeBox(center, size, bounds[i]);
+				index.Move(handles[i], bounds[i]);
+			}
+			index.Update();
+		});
+
+		// A camera looking at a random object from a random direction, 300 units deep.
+		SpatialIndexClass::FrustumType frustum;
+		XMFLOAT3 eye, target = getCenter(object(random));
+		XMVECTOR direction = XMVector3Normalize(XMVectorSet(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f, 0.0f));
+		XMStoreFloat3(&eye, XMVectorSubtract(XMLoadFloat3(&target), XMVectorScale(direction, QUERY_DISTANCE)));
+		XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&eye), direction, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		SpatialIndexClass::ExtractFrustum(XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XM_PI / 3.0f, 16.0f / 9.0f, 0.1f, 300.0f)), frustum);
+
+		timeIt(indexTime[0], [&]() { index.QueryFrustum(frustum, results); });
+		timeIt(bruteTime[0], [&]() { bruteForce([&](const SpatialIndexClass::BoundsType& box) { return SpatialIndexClass::TestFrustum(frustum, box); }); });
+		if (!compare(0))
+		{
+			return false;
+		}
+
+		XMFLOAT3 center = getCenter(object(random));
+		timeIt(indexTime[1], [&]() { index.QuerySphere(center, QUERY_SIZE, results); });
+		timeIt(bruteTime[1], [&]() { bruteForce([&](const SpatialIndexClass::BoundsType& box) { return SpatialIndexClass::TestSphere(center, QUERY_SIZE, box); }); });
+		if (!compare(1))
+		{
+			return false;
+		}
+
+		SpatialIndexClass::BoundsType area;
+		makeBox(getCenter(object(random)), QUERY_SIZE, area);
+		timeIt(indexTime[2], [&]() { index.QueryBounds(area, results); });
+		timeIt(bruteTime[2], [&]() { bruteForce([&](const SpatialIndexClass::BoundsType& box) { return SpatialIndexClass::TestBounds(area, box); }); });
+		if (!compare(2))
+		{
+			return false;
+		}
+
+		// A picking ray from the camera through the object it looks at, brute force keeps the nearest hit with the same tie break as the
+		// index. Something nearer may be in the way, but the ray always hits.
+		SpatialIndexClass::RayType ray;
+		XMFLOAT3 rayDirection;
+		XMStoreFloat3(&rayDirection, direction);
+		SpatialIndexClass::MakeRay(eye, rayDirection, 2000.0f, ray);
+
+		timeIt(indexTime[3], [&]() { hit = index.QueryRay(ray, distance); });
+		timeIt(bruteTime[3], [&]()
+		{
+			bestHandle = -1;
+			bestDistance = FLT_MAX;
+			for (auto i = 0; i < objectCount; i++)
+			{
+				if (SpatialIndexClass::TestRay(ray, bounds[i], t) && (t < bestDistance || (t == bestDistance && handles[i] < bestHandle)))
+				{
+					bestDistance = t;
+					bestHandle = handles[i];
+				}
+			}
+		});
+		if (bestHandle < 0)
+		{
+			out << "ray query found nothing to compare" << std::endl;
+			return false;
+		}
+		if (hit != bestHandle || distance != bestDistance)
+		{
+			out << "ray query hit " << hit << ", brute force " << bestHandle << std::endl;
+			return false;
+		}
+		found[3]++;
+	}
+
+	out << "spatial index: " << objectCount << " objects, " << dynamicObjects.size() << " dynamic, " << index.GetBvhNodeCount() << " BVH nodes, "
+		<< index.GetOctreeNodeCount() << " octree nodes" << std::endl;
+	out << std::fixed << std::setprecision(3) << "build " << buildTime << " ms, moving the dynamic objects " << moveTime / (float)queryCount << " ms" << std::endl;
+	out << "query    index ms  brute ms  speedup  found" << std::endl;
+	for (auto kind = 0; kind < 4; kind++)
+	{
+		out << std::left << std::setw(7) << names[kind] << std::right << std::setprecision(4)
+			<< std::setw(10) << indexTime[kind] / (float)queryCount << std::setw(10) << bruteTime[kind] / (float)queryCount
+			<< std::setprecision(1) << std::setw(8) << (indexTime[kind] > 0.0f ? bruteTime[kind] / indexTime[kind] : 0.0f) << "x"
+			<< std::setw(7) << (float)found[kind] / (float)queryCount << std::endl;
+	}
+
+	index.Shutdown();
+
+	return true;
+}
+
+/*
+ClusteredLighting spreads lightCount lights (a third of them spot lights) through the space in front of the camera and builds the
+light clusters for a slowly turning CameraClass view every frame. Each thread count has to produce exactly the same index list, and the
+last frame is checked cluster by cluster against testing every light against every cluster. Upload goes to the null device to count
+the bytes a frame would send to the GPU.
+*/
+
+bool BenchmarkClass::ClusteredLighting(std::ostream& out, int lightCount, int maxThreads, int frameCount)
+{
+	NullRenderDeviceClass device;
+	CameraClass camera;
+	std::vector<ClusteredLightingClass::LightType> lights(lightCount);
+	std::vector<unsigned int> baseline;
+	std::vector<int> threadCounts;
+	std::mt19937 random(777);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	XMFLOAT4X4 viewMatrix;
+	float baselineTime;
+	bool result;
+
+	if (maxThreads <= 0)
+	{
+		maxThreads = (int)std::thread::hardware_concurrency();
+		if (maxThreads <= 0)
+		{
+			maxThreads = 1;
+		}
+	}
+
+	for (auto threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	for (auto& light : lights)
+	{
+		light.position = XMFLOAT3(unit(random) * 300.0f - 150.0f, unit(random) * 160.0f - 80.0f, unit(random) * 400.0f - 90.0f);
+		light.range = 3.0f + unit(random) * 12.0f;
+		light.color = XMFLOAT3(unit(random), unit(random), unit(random));
+		light.spotCosine = -2.0f;
+		light.direction = XMFLOAT3(0.0f, 0.0f, 1.0f);
+		light.padding = 0.0f;
+
+		if (unit(random) < 0.33f)
+		{
+			XMStoreFloat3(&light.direction, XMVector3Normalize(XMVectorSet(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f, 0.0f)));
+			light.spotCosine = cosf((15.0f + unit(random) * 30.0f) * XM_PI / 180.0f);
+		}
+	}
+
+	device.Initialize();
+	camera.SetPosition(0.0f, 0.0f, -100.0f);
+
+	XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PI / 4.0f, 1280.0f / 720.0f, 0.1f, 1000.0f);
+
+	out << "clustered lighting: " << lightCount << " lights, 16x9x24 clusters, " << frameCount << " frames" << std::endl;
+	out << "threads  build ms  indices  max/cluster  speedup" << std::endl;
+
+	baselineTime = 0.0f;
+	for (auto threads : threadCounts)
+	{
+		JobSystemClass jobs;
+		ClusteredLightingClass lighting;
+		unsigned int offset, count, maxCount;
+		float buildTime;
+
+		result = jobs.Initialize(threads);
+		if (!result)
+		{
+			return false;
+		}
+
+		result = lighting.Initialize(&device, &jobs, 16, 9, 24, lightCount, 16 * 9 * 24 * 256);
+		if (!result)
+		{
+			jobs.Shutdown();
+			return false;
+		}
+		lighting.SetProjection(projection, 0.1f, 1000.0f, 1280, 720);
+
+		buildTime = 0.0f;
+		for (auto frame = 0; frame < frameCount; frame++)
+		{
+			camera.SetRotation(0.0f, (float)frame * 0.5f, 0.0f);
+			camera.Render();
+			camera.GetViewMatrix(viewMatrix);
+
+			lighting.Build(XMLoadFloat4x4(&viewMatrix), lights);
+			buildTime += lighting.GetBuildTime();
+		}
+		buildTime /= (float)frameCount;
+
+		std::vector<unsigned int> indices(lighting.GetIndices(), lighting.GetIndices() + lighting.GetIndexCount());
+		maxCount = 0;
+		for (auto cluster = 0; cluster < lighting.GetClusterCount(); cluster++)
+		{
+			lighting.GetClusterLights(cluster, offset, count);
+			maxCount = std::max(maxCount, count);
+		}
+
+		if (threads == 1)
+		{
+			// Check the last frame against every light tested against every cluster.
+			std::vector<ClusteredLightingClass::LightType> viewLights(lights);
+			for (auto& light : viewLights)
+			{
+				XMStoreFloat3(&light.position, XMVector3TransformCoord(XMLoadFloat3(&light.position), XMLoadFloat4x4(&viewMatrix)));
+				XMStoreFloat3(&light.direction, XMVector3TransformNormal(XMLoadFloat3(&light.direction), XMLoadFloat4x4(&viewMatrix)));
+			}
+
+			for (auto cluster = 0; cluster < lighting.GetClusterCount(); cluster++)
+			{
+				std::vector<unsigned int> expected;
+				for (auto i = 0; i < lightCount; i++)
+				{
+					if (lighting.TestLight(cluster, viewLights[i]))
+					{
+						expected.push_back((unsigned int)i);
+					}
+				}
+
+				lighting.GetClusterLights(cluster, offset, count);
+				std::vector<unsigned int> found(indices.begin() + offset, indices.begin() + offset + count);
+				std::sort(found.begin(), found.end());
+				if (found != expected)
+				{
+					out << "cluster " << cluster << " has " << count << " lights, brute force finds " << expected.size() << std::endl;
+					lighting.Shutdown();
+					jobs.Shutdown();
+					return false;
+				}
+			}
+
+			baseline = indices;
+			baselineTime = buildTime;
+
+			device.ResetCounters();
+			lighting.Upload(device.GetImmediateContext());
+			out << "upload " << device.GetCounters().bytesUploaded << " bytes, " << lighting.GetDroppedCount() << " indices dropped" << std::endl;
+		}
+		else if (indices != baseline)
+		{
+			out << "threads " << threads << " built a different index list than 1 thread" << std::endl;
+			lighting.Shutdown();
+			jobs.Shutdown();
+			return false;
+		}
+
+		lighting.Shutdown();
+		jobs.Shutdown();
+
+		out << std::setw(7) << threads << std::fixed << std::setprecision(3) << std::setw(10) << buildTime << std::setw(9) << indices.size()
+			<< std::setw(13) << maxCount << std::setprecision(2) << std::setw(8) << (buildTime > 0.0f ? baselineTime / buildTime : 0.0f) << "x" << std::endl;
+	}
+
+	device.Shutdown();
+
+	return true;
+}
+
+static void EmptyJob(void* data, int begin, int end)
+{
+	return;
+}
+
+static float JobWork(int index)
+{
+	float value;
+
+	value = (float)index;
+	for (auto i = 0; i < 64; i++)
+	{
+		value = value * 0.999f + sqrtf(value + (float)i);
+	}
+
+	return value;
+}
+
+/*
+JobSystem measures what a job costs: jobCount empty jobs started one by one from the main thread, and an empty ParallelFor over
+jobCount items with a grain of 1 so every item is a job of its own. Then a ParallelFor with the automatic grain does some real work per
+item, followed by a job that only runs after it (through the ParallelFor's counter) and adds the results up. Every thread count has to
+give exactly the same results as a plain loop.
+*/
+
+bool BenchmarkClass::JobSystem(std::ostream& out, int jobCount, int maxThreads)
+{
+	std::vector<float> expected(jobCount), results(jobCount);
+	std::vector<int> threadCounts;
+	double expectedSum, sum;
+	float baselineTime;
+	bool result;
+
+	if (maxThreads <= 0)
+	{
+		maxThreads = (int)std::thread::hardware_concurrency();
+		if (maxThreads <= 0)
+		{
+			maxThreads = 1;
+		}
+	}
+
+	for (auto threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	expectedSum = 0.0;
+	for (auto i = 0; i < jobCount; i++)
+	{
+		expected[i] = JobWork(i);
+		expectedSum += expected[i];
+	}
+
+	out << "job system: " << jobCount << " jobs" << std::endl;
+	out << "threads  ns/job  ns/for item  work ms  speedup  steals" << std::endl;
+
+	baselineTime = 0.0f;
+	for (auto threads : threadCounts)
+	{
+		JobSystemClass jobs;
+		JobSystemClass::CounterType counter, sumCounter;
+		std::chrono::high_resolution_clock::time_point start;
+		float jobTime, forTime, workTime;
+
+		result = jobs.Initialize(threads);
+		if (!result)
+		{
+			return false;
+		}
+
+		start = std::chrono::high_resolution_clock::now();
+		for (auto i = 0; i < jobCount; i++)
+		{
+			jobs.Run(EmptyJob, nullptr, &counter);
+		}
+		jobs.Wait(&counter);
+		jobTime = std::chrono::duration<float, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (float)jobCount;
+
+		start = std::chrono::high_resolution_clock::now();
+		jobs.ParallelFor(jobCount, 1, EmptyJob, nullptr, &counter);
+		jobs.Wait(&counter);
+		forTime = std::chrono::duration<float, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (float)jobCount;
+
+		jobs.ResetCounters();
+		std::fill(results.begin(), results.end(), 0.0f);
+		sum = 0.0;
+
+		auto work = [&](int begin, int end)
+		{
+			for (auto i = begin; i < end; i++)
+			{
+				results[i] = JobWork(i);
+			}
+		};
+		auto add = [&](int begin, int end)
+		{
+			for (auto value : results)
+			{
+				sum += value;
+			}
+		};
+
+		start = std::chrono::high_resolution_clock::now();
+		jobs.ParallelFor(jobCount, 0, [](void* data, int begin, int end) { (*(decltype(work)*)data)(begin, end); }, &work, &counter);
+		jobs.Run([](void* data, int begin, int end) { (*(decltype(add)*)data)(begin, end); }, &add, &sumCounter, &counter);
+		jobs.Wait(&sumCounter);
+		workTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		if (threads == 1)
+		{
+			baselineTime = workTime;
+		}
+
+		out << std::setw(7) << threads << std::fixed << std::setprecision(1) << std::setw(8) << jobTime << std::setw(13) << forTime
+			<< std::setprecision(3) << std::setw(9) << workTime << std::setprecision(2) << std::setw(8)
+			<< (workTime > 0.0f ? baselineTime / workTime : 0.0f) << "x" << std::setw(8) << jobs.GetStealCount() << std::endl;
+
+		jobs.Shutdown();
+
+		if (results != expected || sum != expectedSum)
+		{
+			out << "threads " << threads << " computed different results than a plain loop" << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+TaskGraph builds the same stages and dependencies as GraphicsClass::InitializeFrameGraph, each one spinning for a fixed time, and runs
+frameCount frames through it. Every stage stamps when it started and ended from one shared counter, afterwards each stage has to have
+started after the stages it depends on ended and after its own run of the previous frame ended. With more frames in flight the frame
+time drops below the sum of the stages when there are cores to overlap them on.
+*/
+
+bool BenchmarkClass::TaskGraph(std::ostream& out, int frameCount, int maxFramesInFlight)
+{
+	const char* names[7] = { "camera", "transforms", "cull", "lod", "sort keys", "constants", "submit" };
+	const float durations[7] = { 0.1f, 0.6f, 0.4f, 0.2f, 0.3f, 0.3f, 0.8f };
+	const int dependencies[6][2] = { { 2, 0 }, { 2, 1 }, { 3, 2 }, { 4, 3 }, { 5, 4 }, { 6, 5 } };
+	JobSystemClass jobs;
+	std::atomic<int> clock;
+	std::vector<int> path;
+	float total, frameTime;
+	bool result;
+
+	result = jobs.Initialize(0);
+	if (!result)
+	{
+		return false;
+	}
+
+	total = 0.0f;
+	for (auto duration : durations)
+	{
+		total += duration;
+	}
+
+	out << "task graph: " << frameCount << " frames, " << jobs.GetThreadCount() << " threads, stages add up to " << total << " ms" << std::endl;
+	out << "in flight  ms/frame  critical path ms" << std::endl;
+
+	for (auto framesInFlight = 1; framesInFlight <= maxFramesInFlight; framesInFlight++)
+	{
+		TaskGraphClass graph;
+		std::vector<std::vector<int>> starts(7, std::vector<int>(frameCount + 1)), ends(7, std::vector<int>(frameCount + 1));
+		std::vector<int> frames(7, 0);
+
+		result = graph.Initialize(&jobs, framesInFlight);
+		if (!result)
+		{
+			return false;
+		}
+
+		clock = 0;
+		for (auto i = 0; i < 7; i++)
+		{
+			// Stages never overlap their own previous run, so a per stage count tells which frame this is.
+			graph.AddStage(names[i], [&, i](int slot)
+			{
+				int frame = ++frames[i];
+				starts[i][frame] = clock++;
+
+				auto start = std::chrono::high_resolution_clock::now();
+				while (std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() < durations[i])
+				{
+				}
+
+				ends[i][frame] = clock++;
+			});
+		}
+
+		for (auto& dependency : dependencies)
+		{
+			graph.AddDependency(dependency[0], dependency[1]);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (auto frame = 0; frame < frameCount; frame++)
+		{
+			graph.BeginFrame();
+		}
+		graph.Flush();
+		frameTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / (float)frameCount;
+
+		for (auto frame = 1; frame <= frameCount; frame++)
+		{
+			for (auto& dependency : dependencies)
+			{
+				if (starts[dependency[0]][frame] < ends[dependency[1]][frame])
+				{
+					out << "frame " << frame << ": " << names[dependency[0]] << " started before " << names[dependency[1]] << " ended" << std::endl;
+					return false;
+				}
+			}
+
+			for (auto i = 0; i < 7 && frame > 1; i++)
+			{
+				if (starts[i][frame] < ends[i][frame - 1])
+				{
+					out << "frame " << frame << ": " << names[i] << " overlapped the previous frame's" << std::endl;
+					return false;
+				}
+			}
+		}
+
+		out << std::setw(9) << framesInFlight << std::fixed << std::setprecision(3) << std::setw(10) << frameTime << std::setw(18)
+			<< graph.GetCriticalPath(path) << std::endl;
+
+		if (framesInFlight == maxFramesInFlight)
+		{
+			graph.WriteTimings(out);
+		}
+
+		graph.Shutdown();
+	}
+
+	jobs.Shutdown();
+
+	return true;
+}
+
+/*
+FrameArena runs frameCount frames that each make allocationsPerFrame allocations of 16 to 512 bytes, spread over the job system's
+threads, plus one FrameVectorType that grows to 4096 entries. The arena frames alternate between two buffers and reset the buffer
+before reusing it, the heap frames new and delete every block. Every block gets written to so both pay for touching the memory.
+After the first two frames the arena must not grow any more, and its hot path must not have called operator new (only counted when
+built with FRAMEARENA_CHECK_NEW).
+*/
+
+bool BenchmarkClass::FrameArena(std::ostream& out, int frameCount, int allocationsPerFrame)
+{
+	JobSystemClass jobs;
+	FrameArenaClass arena;
+	std::vector<int> sizes(allocationsPerFrame);
+	std::vector<unsigned char*> blocks(allocationsPerFrame);
+	std::mt19937 random(35);
+	std::atomic<bool> misaligned(false);
+	float arenaTime, heapTime;
+	int warmChunks, arenaHot, heapHot;
+	bool result;
+
+	for (auto& size : sizes)
+	{
+		size = 16 + (int)(random() % 497);
+	}
+
+	result = jobs.Initialize(0);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = arena.Initialize(2, 64 * 1024);
+	if (!result)
+	{
+		return false;
+	}
+
+	arenaTime = 0.0f;
+	warmChunks = 0;
+	arenaHot = 0;
+	for (auto frame = 0; frame < frameCount; frame++)
+	{
+		int buffer = frame % 2;
+
+		if (frame == 2)
+		{
+			warmChunks = arena.GetChunkCount();
+		}
+
+		// The frame two frames ago used this buffer and is done with it.
+		arena.Reset(buffer);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		jobs.ParallelFor(allocationsPerFrame, 0, [&](int begin, int end)
+		{
+			arena.BeginHotPath();
+			for (auto i = begin; i < end; i++)
+			{
+				blocks[i] = (unsigned char*)arena.Allocate(buffer, sizes[i], (i & 7) == 0 ? 64 : 16);
+				if (((size_t)blocks[i] & ((i & 7) == 0 ? 63 : 15)) != 0)
+				{
+					misaligned = true;
+				}
+				memset(blocks[i], i & 0xff, sizes[i]);
+			}
+			arena.EndHotPath(buffer);
+		});
+
+		arena.BeginHotPath();
+		FrameVectorType<int> list(FrameAllocatorType<int>(&arena, buffer));
+		for (auto i = 0; i < 4096; i++)
+		{
+			list.push_back(i);
+		}
+		arena.EndHotPath(buffer);
+		arenaTime += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		arenaHot += arena.GetHotAllocationCount(buffer);
+	}
+
+#ifdef FRAMEARENA_POISON
+	// The last frame's blocks are in buffer (frameCount - 1) % 2, resetting it has to poison them.
+	arena.Reset((frameCount - 1) % 2);
+	if (blocks[0][0] != 0xDD || blocks[allocationsPerFrame - 1][sizes[allocationsPerFrame - 1] - 1] != 0xDD)
+	{
+		out << "reset did not poison the frame's memory" << std::endl;
+		return false;
+	}
+#endif
+
+	heapTime = 0.0f;
+	heapHot = 0;
+	for (auto frame = 0; frame < frameCount; frame++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		jobs.ParallelFor(allocationsPerFrame, 0, [&](int begin, int end)
+		{
+			arena.BeginHotPath();
+			for (auto i = begin; i < end; i++)
+			{
+				blocks[i] = new unsigned char[sizes[i]];
+				memset(blocks[i], i & 0xff, sizes[i]);
+			}
+			arena.EndHotPath(0);
+		});
+
+		arena.BeginHotPath();
+		std::vector<int> list;
+		for (auto i = 0; i < 4096; i++)
+		{
+			list.push_back(i);
+		}
+		arena.EndHotPath(0);
+
+		jobs.ParallelFor(allocationsPerFrame, 0, [&](int begin, int end)
+		{
+			for (auto i = begin; i < end; i++)
+			{
+				delete[] blocks[i];
+			}
+		});
+		heapTime += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		heapHot += arena.GetHotAllocationCount(0);
+		arena.Reset(0);
+	}
+
+	out << "frame arena: " << frameCount << " frames, " << allocationsPerFrame << " allocations a frame, " << jobs.GetThreadCount()
+		<< " threads" << std::endl;
+	out << std::fixed << std::setprecision(3);
+	out << "arena " << arenaTime / (float)frameCount << " ms/frame, heap " << heapTime / (float)frameCount << " ms/frame" << std::endl;
+	out << "arena chunks " << arena.GetChunkCount() << " (" << warmChunks << " after 2 frames), " << arena.GetThreadCount()
+		<< " threads allocated" << std::endl;
+	out << "hot path operator new calls: arena " << arenaHot << ", heap " << heapHot << std::endl;
+
+	arena.Shutdown();
+	jobs.Shutdown();
+
+	if (misaligned)
+	{
+		out << "the arena returned a misaligned block" << std::endl;
+		return false;
+	}
+
+	if (frameCount > 2 && arena.GetChunkCount() != warmChunks)
+	{
+		out << "the arena kept growing after the first frames" << std::endl;
+		return false;
+	}
+
+	if (arenaHot > 0)
+	{
+		out << "the arena frames called operator new" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ResourcePool times lookupCount lookups of random handles in a pool of resourceCount resources against the same number of shared_ptr
+copies out of a vector, which is what handing out shared_ptrs to COM objects every frame cost. Then it releases every other resource and
+steps through the frames: the released handles have to keep working until RENDER_RELEASE_LATENCY frames later and be stale after that,
+and the resources created into the freed slots must get handles that differ from the old ones. The last check does the same through
+the NullRenderDeviceClass, whose EndScene retires the releases.
+*/
+
+bool BenchmarkClass::ResourcePool(std::ostream& out, int resourceCount, int lookupCount)
+{
+	ResourcePoolClass<int> pool;
+	NullRenderDeviceClass device;
+	RenderBufferDesc bufferDesc;
+	std::vector<RenderHandle> handles(resourceCount), order(lookupCount);
+	std::vector<std::shared_ptr<int>> pointers(resourceCount);
+	std::vector<int> indices(lookupCount);
+	std::mt19937 random(36);
+	float poolTime, pointerTime;
+	long long poolSum, pointerSum;
+	int destroyed, released;
+	bool result;
+
+	pool.Initialize(1);
+	for (auto i = 0; i < resourceCount; i++)
+	{
+		handles[i] = pool.Add(i);
+		pointers[i] = std::make_shared<int>(i);
+		if (handles[i] == RENDER_NULL_HANDLE)
+		{
+			out << "the pool ran out of slots" << std::endl;
+			return false;
+		}
+	}
+
+	for (auto i = 0; i < lookupCount; i++)
+	{
+		indices[i] = (int)(random() % resourceCount);
+		order[i] = handles[indices[i]];
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	poolSum = 0;
+	for (auto i = 0; i < lookupCount; i++)
+	{
+		poolSum += *pool.Get(order[i]);
+	}
+	poolTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	start = std::chrono::high_resolution_clock::now();
+	pointerSum = 0;
+	for (auto i = 0; i < lookupCount; i++)
+	{
+		std::shared_ptr<int> pointer = pointers[indices[i]];
+		pointerSum += *pointer;
+	}
+	pointerTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	if (poolSum != pointerSum)
+	{
+		out << "handle lookups returned the wrong resources" << std::endl;
+		return false;
+	}
+
+	// Release every other resource in frame 0 and step the frames until they are retired.
+	released = 0;
+	for (auto i = 0; i < resourceCount; i += 2)
+	{
+		pool.Release(handles[i], RENDER_RELEASE_LATENCY);
+		released++;
+	}
+
+	destroyed = 0;
+	for (unsigned long long frame = 1; frame <= RENDER_RELEASE_LATENCY; frame++)
+	{
+		if (!pool.IsValid(handles[0]) || destroyed != 0)
+		{
+			out << "a released resource was destroyed before its frame retired" << std::endl;
+			return false;
+		}
+
+		pool.Retire(frame, [&destroyed](int&) { destroyed++; });
+	}
+
+	if (destroyed != released || pool.IsValid(handles[0]) || pool.GetCount() != resourceCount - released)
+	{
+		out << "released resources were not destroyed when their frame retired" << std::endl;
+		return false;
+	}
+
+	for (auto i = 0; i < resourceCount; i += 2)
+	{
+		RenderHandle handle = pool.Add(-1);
+		if (handle == handles[i] || pool.IsValid(handles[i]) || *pool.Get(handle) != -1)
+		{
+			out << "a reused slot did not get a new generation" << std::endl;
+			return false;
+		}
+	}
+
+	pool.Clear([](int&) {});
+
+	// The same through the null device.
+	result = device.Initialize();
+	if (!result)
+	{
+		return false;
+	}
+
+	memset(&bufferDesc, 0, sizeof(bufferDesc));
+	bufferDesc.byteWidth = 64;
+	bufferDesc.usage = RENDER_USAGE_DEFAULT;
+	bufferDesc.bindType = RENDER_BIND_CONSTANT_BUFFER;
+
+	for (auto i = 0; i < 16; i++)
+	{
+		handles[i % resourceCount] = device.CreateBuffer(bufferDesc, nullptr);
+		device.ReleaseResource(handles[i % resourceCount]);
+	}
+
+	for (unsigned int i = 0; i < RENDER_RELEASE_LATENCY; i++)
+	{
+		if (device.GetCounters().resourcesDestroyed != 0)
+		{
+			out << "the device destroyed a released resource too early" << std::endl;
+			return false;
+		}
+
+		device.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+		device.EndScene();
+	}
+
+	if (device.GetCounters().resourcesDestroyed != device.GetCounters().resourcesReleased)
+	{
+		out << "the device did not destroy its released resources" << std::endl;
+		return false;
+	}
+
+	device.Shutdown();
+
+	out << "resource pool: " << resourceCount << " resources, " << lookupCount << " lookups" << std::endl;
+	out << std::fixed << std::setprecision(2);
+	out << "handle lookup " << poolTime * 1000000.0f / (float)lookupCount << " ns, shared_ptr copy "
+		<< pointerTime * 1000000.0f / (float)lookupCount << " ns" << std::endl;
+	out << released << " releases destroyed " << RENDER_RELEASE_LATENCY << " frames later, stale handles rejected" << std::endl;
+
+	return true;
+}
+
+//MeshWords fills in a test mesh for the geometry pool benchmark, every word of it depends on the tag so two meshes never look alike.
+//Vertices are 8 words (32 bytes, the size of a ModelClass vertex) and the indices walk the vertices in a tag dependent order.
+
+static void MeshWords(unsigned int tag, int vertexCount, int indexCount, std::vector<unsigned int>& vertices, std::vector<unsigned int>& indices)
+{
+	vertices.resize(vertexCount * 8);
+	indices.resize(indexCount);
+
+	for (auto i = 0; i < vertexCount * 8; i++)
+	{
+		vertices[i] = tag * 7919u + (unsigned int)i;
+	}
+
+	for (auto i = 0; i < indexCount; i++)
+	{
+		indices[i] = ((unsigned int)i * 31u + tag) % (unsigned int)vertexCount;
+	}
+
+	return;
+}
+
+static int MeshIndexCount(int vertexCount)
+{
+	return (vertexCount / 2 + 1) * 3;
+}
+
+/*
+GeometryPool churns a pool without a device with operationCount random adds and removes of meshes of 3 to 192 vertices, up to meshCount
+of them at a time, then checks that no two meshes share a range and that each still reads back what it was added with at its base vertex
+and start index. The same sequence of sizes is timed on a bare offset allocator against new and delete. Defragmenting must then leave the
+free space in one range per buffer with every mesh intact. Last it draws meshCount different meshes on the null device once out of buffers
+of their own and once out of a pool, and counts the input assembler binds each way needs.
+*/
+
+bool BenchmarkClass::GeometryPool(std::ostream& out, int meshCount, int operationCount)
+{
+	const int stride = 32;
+	const int maxVertices = 192;
+	GeometryPoolClass pool;
+	OffsetAllocatorClass allocator;
+	NullRenderDeviceClass device;
+	GeometryPoolClass::MeshType mesh;
+	RenderBufferDesc bufferDesc;
+	std::vector<int> opSize(operationCount), opSlot(operationCount);
+	std::vector<int> liveIds;
+	std::vector<unsigned int> liveTags;
+	std::vector<OffsetAllocatorClass::AllocationType> liveAllocations;
+	std::vector<unsigned char*> liveBlocks;
+	std::vector<unsigned int> vertices, indices;
+	std::vector<std::pair<int, int>> vertexRanges, indexRanges;
+	std::vector<RenderHandle> buffers;
+	std::mt19937 random(37);
+	float poolTime, allocatorTime, heapTime;
+	unsigned int tag;
+	unsigned long long separateBinds, pooledBinds;
+	int live, regionsBefore, moved, used, drawCount, id, meshesLeft;
+	bool result;
+
+	if (meshCount <= 0 || operationCount <= 0)
+	{
+		return false;
+	}
+
+	// Make up the sequence first so all three runs do exactly the same thing. A size of 0 removes the mesh in the given slot of the live
+	// list, anything else adds one.
+	live = 0;
+	for (auto i = 0; i < operationCount; i++)
+	{
+		if (live > 0 && (live >= meshCount || random() % 2 == 0))
+		{
+			opSize[i] = 0;
+			opSlot[i] = (int)(random() % live);
+			live--;
+		}
+		else
+		{
+			opSize[i] = 3 + (int)(random() % (maxVertices - 2));
+			live++;
+		}
+	}
+
+	// Twice the most the meshes can take up, so rounding and fragmentation never run it out of space.
+	result = pool.Initialize(nullptr, stride, meshCount * maxVertices * 2, meshCount * MeshIndexCount(maxVertices) * 2, meshCount);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Only the pool calls are timed, not making up the meshes.
+	tag = 0;
+	poolTime = 0.0f;
+	for (auto i = 0; i < operationCount; i++)
+	{
+		if (opSize[i] == 0)
+		{
+			auto removeStart = std::chrono::high_resolution_clock::now();
+			pool.RemoveMesh(liveIds[opSlot[i]]);
+			poolTime += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - removeStart).count();
+			liveIds[opSlot[i]] = liveIds.back();
+			liveTags[opSlot[i]] = liveTags.back();
+			liveIds.pop_back();
+			liveTags.pop_back();
+			continue;
+		}
+
+		MeshWords(++tag, opSize[i], MeshIndexCount(opSize[i]), vertices, indices);
+		auto addStart = std::chrono::high_resolution_clock::now();
+		id = pool.AddMesh(vertices.data(), opSize[i], indices.data(), MeshIndexCount(opSize[i]));
+		poolTime += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - addStart).count();
+		if (id < 0)
+		{
+			out << "the geometry pool ran out of space" << std::endl;
+			return false;
+		}
+
+		liveIds.push_back(id);
+		liveTags.push_back(tag);
+	}
+
+	// The bare allocator and the heap on the same sizes.
+	result = allocator.Initialize(meshCount * maxVertices * 2, meshCount * 2 + 2);
+	if (!result)
+	{
+		return false;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto i = 0; i < operationCount; i++)
+	{
+		if (opSize[i] == 0)
+		{
+			allocator.Free(liveAllocations[opSlot[i]]);
+			liveAllocations[opSlot[i]] = liveAllocations.back();
+			liveAllocations.pop_back();
+		}
+		else
+		{
+			liveAllocations.push_back(allocator.Allocate(opSize[i]));
+		}
+	}
+	allocatorTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	start = std::chrono::high_resolution_clock::now();
+	for (auto i = 0; i < operationCount; i++)
+	{
+		if (opSize[i] == 0)
+		{
+			delete[] liveBlocks[opSlot[i]];
+			liveBlocks[opSlot[i]] = liveBlocks.back();
+			liveBlocks.pop_back();
+		}
+		else
+		{
+			liveBlocks.push_back(new unsigned char[opSize[i] * stride]);
+		}
+	}
+	heapTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	for (auto block : liveBlocks)
+	{
+		delete[] block;
+	}
+
+	if (allocator.GetAllocationCount() != pool.GetMeshCount())
+	{
+		out << "the allocator lost track of its allocations" << std::endl;
+		return false;
+	}
+	allocator.Shutdown();
+
+	// Check the ranges and the contents, then defragment and check again.
+	regionsBefore = pool.GetFreeRegionCount();
+	moved = 0;
+	for (auto pass = 0; pass < 2; pass++)
+	{
+		vertexRanges.clear();
+		indexRanges.clear();
+		for (size_t i = 0; i < liveIds.size(); i++)
+		{
+			if (!pool.GetMesh(liveIds[i], mesh))
+			{
+				out << "a live mesh went missing" << std::endl;
+				return false;
+			}
+
+			vertexRanges.push_back(std::make_pair(mesh.baseVertex, mesh.vertexCount));
+			indexRanges.push_back(std::make_pair(mesh.startIndex, mesh.indexCount));
+
+			MeshWords(liveTags[i], mesh.vertexCount, mesh.indexCount, vertices, indices);
+			if (memcmp(pool.GetVertexData() + (size_t)mesh.baseVertex * stride, vertices.data(), (size_t)mesh.vertexCount * stride) != 0 ||
+				memcmp(pool.GetIndexData() + mesh.startIndex, indices.data(), (size_t)mesh.indexCount * sizeof(unsigned int)) != 0)
+			{
+				out << "a mesh does not read back what was added" << std::endl;
+				return false;
+			}
+		}
+
+		std::sort(vertexRanges.begin(), vertexRanges.end());
+		std::sort(indexRanges.begin(), indexRanges.end());
+		for (size_t i = 1; i < vertexRanges.size(); i++)
+		{
+			if (vertexRanges[i - 1].first + vertexRanges[i - 1].second > vertexRanges[i].first ||
+				indexRanges[i - 1].first + indexRanges[i - 1].second > indexRanges[i].first)
+			{
+				out << "two meshes share a range" << std::endl;
+				return false;
+			}
+		}
+
+		if (pass == 0)
+		{
+			moved = pool.Defragment();
+			continue;
+		}
+
+		// Packed means one free range per buffer and the last mesh ending where the free space begins.
+		used = (int)(meshCount * maxVertices * 2 - pool.GetFreeVertices());
+		if (pool.GetFreeRegionCount() != 2 || (!vertexRanges.empty() && vertexRanges.back().first + vertexRanges.back().second != used))
+		{
+			out << "defragmenting left " << pool.GetFreeRegionCount() << " free ranges" << std::endl;
+			return false;
+		}
+	}
+
+	meshesLeft = pool.GetMeshCount();
+	pool.Shutdown();
+
+	// IA binds for drawCount different meshes, out of buffers of their own and out of one pool.
+	drawCount = std::min(meshCount, 1024);
+
+	result = device.Initialize();
+	if (!result)
+	{
+		return false;
+	}
+
+	result = pool.Initialize(&device, stride, drawCount * maxVertices, drawCount * MeshIndexCount(maxVertices), drawCount);
+	if (!result)
+	{
+		return false;
+	}
+
+	memset(&bufferDesc, 0, sizeof(bufferDesc));
+	bufferDesc.usage = RENDER_USAGE_DEFAULT;
+	liveIds.clear();
+	for (auto i = 0; i < drawCount; i++)
+	{
+		MeshWords(i, 24, 36, vertices, indices);
+
+		bufferDesc.byteWidth = 24 * stride;
+		bufferDesc.bindType = RENDER_BIND_VERTEX_BUFFER;
+		buffers.push_back(device.CreateBuffer(bufferDesc, vertices.data()));
+		bufferDesc.byteWidth = 36 * sizeof(unsigned int);
+		bufferDesc.bindType = RENDER_BIND_INDEX_BUFFER;
+		buffers.push_back(device.CreateBuffer(bufferDesc, indices.data()));
+
+		liveIds.push_back(pool.AddMesh(vertices.data(), 24, indices.data(), 36));
+	}
+
+	result = pool.Upload(device.GetImmediateContext());
+	if (!result)
+	{
+		return false;
+	}
+
+	device.ResetCounters();
+	for (auto i = 0; i < drawCount; i++)
+	{
+		device.SetVertexBuffer(0, buffers[i * 2], stride, 0);
+		device.SetIndexBuffer(buffers[i * 2 + 1], RENDER_FORMAT_R32_UINT, 0);
+		device.DrawIndexed(36, 0, 0);
+	}
+	separateBinds = device.GetCounters().binds;
+
+	device.ResetCounters();
+	pool.Bind(&device);
+	for (auto i = 0; i < drawCount; i++)
+	{
+		pool.GetMesh(liveIds[i], mesh);
+		device.DrawIndexed(mesh.indexCount, mesh.startIndex, mesh.baseVertex);
+	}
+	pooledBinds = device.GetCounters().binds;
+
+	for (auto buffer : buffers)
+	{
+		device.ReleaseResource(buffer);
+	}
+	pool.Shutdown();
+	device.Shutdown();
+
+	out << "geometry pool: " << operationCount << " adds and removes, up to " << meshCount << " meshes" << std::endl;
+	out << std::fixed << std::setprecision(2);
+	out << "pool add/remove with copy " << poolTime * 1000000.0f / (float)operationCount << " ns, offset allocator "
+		<< allocatorTime * 1000000.0f / (float)operationCount << " ns, new/delete " << heapTime * 1000000.0f / (float)operationCount << " ns" << std::endl;
+	out << "defragment moved " << moved << " of " << meshesLeft << " meshes, free ranges " << regionsBefore << " -> 2, contents intact" << std::endl;
+	out << drawCount << " meshes: " << separateBinds << " binds with their own buffers, " << pooledBinds << " from the pool" << std::endl;
+
+	return true;
+}
+
+/*
+DynamicGeometry adds linesPerFrame lines and linesPerFrame / 16 triangles a frame, in pieces of one to eight, to an ImmediateGeometryClass
+on the null device and renders it, for frameCount frames. The rings are sized to hold 1, 2, 4 and 8 frames worth of data. With fewer
+frames than RENDER_RELEASE_LATENCY they wrap into data frames in flight may still read, which has to show up as wrap stalls, and from
+there on none may. Every run has to stream exactly what was added, in a handful of draws a frame, and the device has to accept every
+write (it checks the ranges against the buffer sizes). The same pieces drawn one UpdateBuffer and draw at a time are the comparison.
+*/
+
+bool BenchmarkClass::DynamicGeometry(std::ostream& out, int frameCount, int linesPerFrame)
+{
+	NullRenderDeviceClass device;
+	StateCacheClass states;
+	ImmediateGeometryClass geometry;
+	ImmediateGeometryClass::StatsType stats;
+	ImmediateGeometryClass::VertexType vertices[24];
+	RenderBufferDesc bufferDesc;
+	RenderHandle pieceBuffer;
+	unsigned int indices[24];
+	std::mt19937 random(38);
+	std::vector<int> pieces;
+	unsigned long long frameBytes, uploaded;
+	float streamTime, pieceTime;
+	int triangleCount, count, framesHeld;
+	bool result;
+
+	if (frameCount <= 0 || linesPerFrame <= 0)
+	{
+		return false;
+	}
+
+	for (auto i = 0; i < 24; i++)
+	{
+		vertices[i].position = XMFLOAT3((float)i, (float)(i * i), 1.0f);
+		vertices[i].color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+		indices[i] = (unsigned int)i;
+	}
+
+	// The pieces a frame is added in, the same every frame: a line count, then a negative triangle count.
+	for (auto lines = 0; lines < linesPerFrame; lines += count)
+	{
+		count = std::min(1 + (int)(random() % 8), linesPerFrame - lines);
+		pieces.push_back(count);
+	}
+	triangleCount = std::max(linesPerFrame / 16, 1);
+	for (auto triangles = 0; triangles < triangleCount; triangles += count)
+	{
+		count = std::min(1 + (int)(random() % 8), triangleCount - triangles);
+		pieces.push_back(-count);
+	}
+
+	frameBytes = (unsigned long long)linesPerFrame * 2 * (sizeof(ImmediateGeometryClass::VertexType) + sizeof(unsigned int)) +
+		(unsigned long long)triangleCount * 3 * (sizeof(ImmediateGeometryClass::VertexType) + sizeof(unsigned int));
+
+	result = device.Initialize() && states.Initialize(&device);
+	if (!result)
+	{
+		return false;
+	}
+
+	out << "dynamic geometry: " << frameCount << " frames, " << linesPerFrame << " lines and " << triangleCount << " triangles in "
+		<< pieces.size() << " pieces a frame, " << frameBytes << " bytes" << std::endl;
+	out << "ring frames,draws/frame,MB/frame,wraps,wrap stalls,ms/frame" << std::endl;
+	out << std::fixed << std::setprecision(3);
+
+	for (framesHeld = 1; framesHeld <= 8; framesHeld *= 2)
+	{
+		// Each ring holds framesHeld frames of its own part, plus a little for the alignment of the batches.
+		result = geometry.Initialize(&device, &states, (unsigned int)(framesHeld * linesPerFrame * 2 * sizeof(ImmediateGeometryClass::VertexType) +
+			framesHeld * triangleCount * 3 * sizeof(ImmediateGeometryClass::VertexType) + 4096), (unsigned int)(framesHeld * linesPerFrame * 2 *
+			sizeof(unsigned int) + framesHeld * triangleCount * 3 * sizeof(unsigned int) + 4096));
+		if (!result)
+		{
+			return false;
+		}
+
+		device.ResetCounters();
+		auto start = std::chrono::high_resolution_clock::now();
+		for (auto frame = 0; frame < frameCount; frame++)
+		{
+			device.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+
+			for (auto piece : pieces)
+			{
+				result = piece > 0 ? geometry.AddLines(vertices, piece * 2, indices, piece * 2) : geometry.AddTriangles(vertices, -piece * 3, indices, -piece * 3);
+				if (!result)
+				{
+					out << "a piece was dropped" << std::endl;
+					return false;
+				}
+			}
+
+			result = geometry.Render(&device, XMMatrixIdentity(), XMMatrixIdentity());
+			if (!result)
+			{
+				out << "streaming the frame failed with rings of " << framesHeld << " frames" << std::endl;
+				return false;
+			}
+
+			device.EndScene();
+		}
+		streamTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		geometry.GetStats(stats);
+		uploaded = device.GetCounters().bytesUploaded - (unsigned long long)frameCount * 192;
+		if (stats.bytesStreamed != frameBytes * frameCount || uploaded != stats.bytesStreamed)
+		{
+			out << "streamed " << stats.bytesStreamed << " bytes, the device got " << uploaded << ", expected " << frameBytes * frameCount << std::endl;
+			return false;
+		}
+
+		if ((framesHeld < (int)RENDER_RELEASE_LATENCY) != (stats.wrapStalls > 0) && frameCount > (int)RENDER_RELEASE_LATENCY * 8)
+		{
+			out << "rings of " << framesHeld << " frames had " << stats.wrapStalls << " wrap stalls" << std::endl;
+			return false;
+		}
+
+		out << framesHeld << "," << (float)stats.draws / (float)frameCount << "," << (float)stats.bytesStreamed / (float)frameCount / (1024.0f * 1024.0f)
+			<< "," << stats.wraps << "," << stats.wrapStalls << "," << streamTime / (float)frameCount << std::endl;
+
+		geometry.Shutdown();
+	}
+
+	// One UpdateBuffer and draw per piece through a small dynamic buffer.
+	memset(&bufferDesc, 0, sizeof(bufferDesc));
+	bufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	bufferDesc.byteWidth = sizeof(vertices);
+	bufferDesc.bindType = RENDER_BIND_VERTEX_BUFFER;
+
+	pieceBuffer = device.CreateBuffer(bufferDesc, nullptr);
+	if (pieceBuffer == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	device.ResetCounters();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto frame = 0; frame < frameCount; frame++)
+	{
+		device.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+
+		for (auto piece : pieces)
+		{
+			count = piece > 0 ? piece * 2 : -piece * 3;
+			device.UpdateBuffer(pieceBuffer, vertices, count * sizeof(ImmediateGeometryClass::VertexType));
+			device.SetVertexBuffer(0, pieceBuffer, sizeof(ImmediateGeometryClass::VertexType), 0);
+			device.SetPrimitiveTopology(piece > 0 ? RENDER_TOPOLOGY_LINELIST : RENDER_TOPOLOGY_TRIANGLELIST);
+			device.Draw(count, 0);
+		}
+
+		device.EndScene();
+	}
+	pieceTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	out << "one draw per piece: " << (float)device.GetCounters().draws / (float)frameCount << " draws/frame, " << pieceTime / (float)frameCount
+		<< " ms/frame" << std::endl;
+
+	device.ReleaseResource(pieceBuffer);
+	states.Shutdown();
+	device.Shutdown();
+
+	return true;
+}
+
+/*
+StateCache asks a state cache for requestCount random states out of 8 rasterizer, 8 depth stencil, 8 blend and 8 sampler descriptions and
+times it against creating and releasing each state on the device every time. Every description has to be created once and give the same
+handle on every later request, and an input layout built from copies of the semantic names has to be the same one. Then the cache saves
+a manifest, a second cache loads it, and the same requests on the second cache must all be hits.
+*/
+
+bool BenchmarkClass::StateCache(std::ostream& out, int requestCount)
+{
+	const int DESC_COUNT = 8;
+	const int KIND_COUNT = StateCacheClass::STATE_INPUT_LAYOUT;
+	const char* MANIFEST_FILE = "statecache_benchmark.txt";
+	NullRenderDeviceClass device;
+	StateCacheClass states, prewarmed;
+	StateCacheClass::StatsType stats;
+	RenderRasterizerDesc rasterizerDescs[DESC_COUNT];
+	RenderDepthStencilDesc depthStencilDescs[DESC_COUNT];
+	RenderBlendDesc blendDescs[DESC_COUNT];
+	RenderSamplerDesc samplerDescs[DESC_COUNT];
+	RenderInputElementDesc layout[2], layoutCopy[2];
+	RenderHandle first[KIND_COUNT][DESC_COUNT], handle, vertexShader;
+	std::string positionName("POSITION"), colorName("COLOR");
+	std::vector<int> order(requestCount);
+	std::mt19937 random(39);
+	float cacheTime, createTime;
+	unsigned long long requests, hits, creations;
+	int distinct;
+	bool result;
+
+	result = device.Initialize() && states.Initialize(&device) && prewarmed.Initialize(&device);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Each description differs from the others of its kind in a few fields, the floats are ones without an exact decimal form.
+	for (auto i = 0; i < DESC_COUNT; i++)
+	{
+		memset(&rasterizerDescs[i], 0, sizeof(rasterizerDescs[i]));
+		rasterizerDescs[i].fillMode = (RenderFillMode)(i & 1);
+		rasterizerDescs[i].cullMode = (RenderCullMode)((i >> 1) % 3);
+		rasterizerDescs[i].depthBias = i * 10;
+		rasterizerDescs[i].slopeScaledDepthBias = (float)i * 0.1f;
+		rasterizerDescs[i].depthClipEnable = true;
+
+		memset(&depthStencilDescs[i], 0, sizeof(depthStencilDescs[i]));
+		depthStencilDescs[i].depthEnable = true;
+		depthStencilDescs[i].depthWriteEnable = (i & 1) != 0;
+		depthStencilDescs[i].depthFunc = (RenderComparison)(i % 8);
+		depthStencilDescs[i].frontFace.stencilFunc = RENDER_COMPARISON_ALWAYS;
+		depthStencilDescs[i].backFace.stencilFunc = RENDER_COMPARISON_ALWAYS;
+
+		memset(&blendDescs[i], 0, sizeof(blendDescs[i]));
+		blendDescs[i].blendEnable = true;
+		blendDescs[i].srcBlend = (RenderBlend)(i % 10);
+		blendDescs[i].destBlend = RENDER_BLEND_INV_SRC_ALPHA;
+		blendDescs[i].blendOp = (RenderBlendOp)(i % 5);
+		blendDescs[i].srcBlendAlpha = RENDER_BLEND_ONE;
+		blendDescs[i].destBlendAlpha = RENDER_BLEND_ZERO;
+		blendDescs[i].writeMask = 0x0F;
+
+		memset(&samplerDescs[i], 0, sizeof(samplerDescs[i]));
+		samplerDescs[i].filter = (RenderFilter)(i % 3);
+		samplerDescs[i].addressU = (RenderTextureAddress)(i % 4);
+		samplerDescs[i].addressV = (RenderTextureAddress)(i % 4);
+		samplerDescs[i].addressW = RENDER_TEXTURE_ADDRESS_WRAP;
+		samplerDescs[i].mipLODBias = (float)i / 3.0f;
+		samplerDescs[i].maxAnisotropy = 1;
+		samplerDescs[i].comparisonFunc = RENDER_COMPARISON_ALWAYS;
+		samplerDescs[i].borderColor[0] = (float)i / 7.0f;
+		samplerDescs[i].maxLOD = FLT_MAX;
+	}
+
+	auto request = [&](StateCacheClass& cache, int kind, int desc) -> RenderHandle
+	{
+		switch (kind)
+		{
+		case StateCacheClass::STATE_RASTERIZER:
+			return cache.GetRasterizerState(rasterizerDescs[desc]);
+		case StateCacheClass::STATE_DEPTH_STENCIL:
+			return cache.GetDepthStencilState(depthStencilDescs[desc]);
+		case StateCacheClass::STATE_BLEND:
+			return cache.GetBlendState(blendDescs[desc]);
+		default:
+			return cache.GetSamplerState(samplerDescs[desc]);
+		}
+	};
+
+	auto create = [&](int kind, int desc) -> RenderHandle
+	{
+		switch (kind)
+		{
+		case StateCacheClass::STATE_RASTERIZER:
+			return device.CreateRasterizerState(rasterizerDescs[desc]);
+		case StateCacheClass::STATE_DEPTH_STENCIL:
+			return device.CreateDepthStencilState(depthStencilDescs[desc]);
+		case StateCacheClass::STATE_BLEND:
+			return device.CreateBlendState(blendDescs[desc]);
+		default:
+			return device.CreateSamplerState(samplerDescs[desc]);
+		}
+	};
+
+	// A request is its kind times DESC_COUNT plus its description.
+	for (auto& entry : order)
+	{
+		entry = (int)(random() % (KIND_COUNT * DESC_COUNT));
+	}
+
+	for (auto& kind : first)
+	{
+		for (auto& state : kind)
+		{
+			state = RENDER_NULL_HANDLE;
+		}
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto entry : order)
+	{
+		handle = request(states, entry / DESC_COUNT, entry % DESC_COUNT);
+		if (first[entry / DESC_COUNT][entry % DESC_COUNT] == RENDER_NULL_HANDLE)
+		{
+			first[entry / DESC_COUNT][entry % DESC_COUNT] = handle;
+		}
+		else if (handle != first[entry / DESC_COUNT][entry % DESC_COUNT])
+		{
+			out << "the same description gave a different state" << std::endl;
+			return false;
+		}
+	}
+	cacheTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// The device only has room for 65535 resources, so the releases are retired every 1024 requests like at the end of a frame.
+	start = std::chrono::high_resolution_clock::now();
+	for (auto i = 0; i < requestCount; i++)
+	{
+		device.ReleaseResource(create(order[i] / DESC_COUNT, order[i] % DESC_COUNT));
+		if (i % 1024 == 1023)
+		{
+			device.EndScene();
+		}
+	}
+	createTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	requests = hits = creations = 0;
+	for (auto kind = 0; kind < KIND_COUNT; kind++)
+	{
+		distinct = 0;
+		for (auto desc = 0; desc < DESC_COUNT; desc++)
+		{
+			distinct += first[kind][desc] != RENDER_NULL_HANDLE ? 1 : 0;
+		}
+
+		states.GetStats((StateCacheClass::StateKind)kind, stats);
+		if (stats.creations != (unsigned long long)distinct || stats.failures != 0 || states.GetStateCount((StateCacheClass::StateKind)kind) != distinct)
+		{
+			out << "the cache created " << stats.creations << " states for " << distinct << " descriptions" << std::endl;
+			return false;
+		}
+
+		requests += stats.requests;
+		hits += stats.hits;
+		creations += stats.creations;
+	}
+
+	if (requests != (unsigned long long)requestCount || hits + creations != requests)
+	{
+		out << requests << " requests counted, " << hits << " hits and " << creations << " creations" << std::endl;
+		return false;
+	}
+
+	// Two layouts alike in everything but where their semantic names are stored.
+	vertexShader = device.CreateVertexShader(L"VertexShader.hlsl", "ColorVertexShader");
+	layout[0].semanticName = "POSITION";
+	layout[0].semanticIndex = 0;
+	layout[0].format = RENDER_FORMAT_R32G32B32_FLOAT;
+	layout[0].inputSlot = 0;
+	layout[0].alignedByteOffset = 0;
+	layout[1].semanticName = "COLOR";
+	layout[1].semanticIndex = 0;
+	layout[1].format = RENDER_FORMAT_R32G32B32A32_FLOAT;
+	layout[1].inputSlot = 0;
+	layout[1].alignedByteOffset = RENDER_APPEND_ALIGNED_ELEMENT;
+	memcpy(layoutCopy, layout, sizeof(layout));
+	layoutCopy[0].semanticName = positionName.c_str();
+	layoutCopy[1].semanticName = colorName.c_str();
+
+	handle = states.GetInputLayout(layout, 2, vertexShader);
+	if (handle == RENDER_NULL_HANDLE || states.GetInputLayout(layoutCopy, 2, vertexShader) != handle)
+	{
+		out << "the same input layout gave a different state" << std::endl;
+		return false;
+	}
+
+	out << "state cache: " << requestCount << " requests for " << creations << " states" << std::endl;
+	out << std::fixed << std::setprecision(1);
+	out << "cache lookup " << cacheTime * 1000000.0f / (float)requestCount << " ns/request, create and release "
+		<< createTime * 1000000.0f / (float)requestCount << " ns/request on the null device" << std::endl;
+	states.WriteStats(out);
+
+	// Pre-warm a second cache from the manifest, every request on it has to be a hit.
+	result = states.SaveManifest(MANIFEST_FILE) && prewarmed.LoadManifest(MANIFEST_FILE);
+	std::remove(MANIFEST_FILE);
+	if (!result)
+	{
+		out << "the manifest could not be saved and loaded" << std::endl;
+		return false;
+	}
+
+	prewarmed.ResetStats();
+	for (auto entry : order)
+	{
+		request(prewarmed, entry / DESC_COUNT, entry % DESC_COUNT);
+	}
+
+	creations = 0;
+	for (auto kind = 0; kind < KIND_COUNT; kind++)
+	{
+		prewarmed.GetStats((StateCacheClass::StateKind)kind, stats);
+		creations += stats.creations;
+		if (prewarmed.GetStateCount((StateCacheClass::StateKind)kind) != states.GetStateCount((StateCacheClass::StateKind)kind))
+		{
+			out << "the manifest did not recreate every " << kind << " state" << std::endl;
+			return false;
+		}
+	}
+
+	if (creations != 0)
+	{
+		out << "the pre-warmed cache still created " << creations << " states" << std::endl;
+		return false;
+	}
+
+	out << "pre-warmed from the manifest: " << requestCount << " requests, 0 created" << std::endl;
+
+	prewarmed.Shutdown();
+	states.Shutdown();
+	device.ReleaseResource(vertexShader);
+	device.Shutdown();
+
+	return true;
+}
+
+/*
+FramePacing runs frameCount frames through a frame pacer limited to frameRate, each doing a random 20 to 60 percent of a frame of busy
+work, and every 64th frame stalling for three frames. It does so with each wait mode and reports how far the frame intervals were off,
+how the wait was split between sleeping and spinning, and how much of one core the process used. No frame may take more than the most
+steps, and the steps taken plus the ones dropped have to add up to the time that passed.
+*/
+
+bool BenchmarkClass::FramePacing(std::ostream& out, int frameCount, float frameRate)
+{
+	const int MAX_STEPS = 4;
+	const float STEP = 1.0f / 120.0f;
+	const char* MODE_NAMES[] = { "spin", "sleep", "sleep+spin" };
+	FramePacerClass pacer;
+	FramePacerClass::StatsType stats;
+	std::mt19937 random(41);
+	std::vector<float> work;
+	double wallTime, cpuTime, expected;
+	int steps;
+	bool result;
+
+	if (frameCount <= 1 || frameRate <= 0.0f)
+	{
+		return false;
+	}
+
+	// CPU time used by the whole process, clock() is wall time on Windows.
+	auto processSeconds = []() -> double
+	{
+#ifdef _WIN32
+		FILETIME creation, exit, kernel, user;
+		ULARGE_INTEGER kernelTime, userTime;
+
+		GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+		kernelTime.LowPart = kernel.dwLowDateTime;
+		kernelTime.HighPart = kernel.dwHighDateTime;
+		userTime.LowPart = user.dwLowDateTime;
+		userTime.HighPart = user.dwHighDateTime;
+
+		return (double)(kernelTime.QuadPart + userTime.QuadPart) / 10000000.0;
+#else
+		return (double)std::clock() / (double)CLOCKS_PER_SEC;
+#endif
+	};
+
+	// The same work for every mode, in seconds.
+	work.resize(frameCount);
+	for (auto i = 0; i < frameCount; i++)
+	{
+		work[i] = (i % 64 == 63 ? 3.0f : 0.2f + 0.4f * std::uniform_real_distribution<float>()(random)) / frameRate;
+	}
+
+	out << "frame pacing: " << frameCount << " frames at " << frameRate << " fps, " << STEP * 1000.0f << " ms steps" << std::endl;
+	out << "mode,ms/frame,jitter ms,worst error ms,sleep ms/frame,spin ms/frame,steps,dropped,cpu %" << std::endl;
+	out << std::fixed << std::setprecision(3);
+
+	for (auto mode = 0; mode < 3; mode++)
+	{
+		result = pacer.Initialize(STEP, frameRate, MAX_STEPS);
+		if (!result)
+		{
+			return false;
+		}
+		pacer.SetWaitMode((FramePacerClass::WaitMode)mode);
+
+		auto cpuStart = processSeconds();
+		auto start = std::chrono::steady_clock::now();
+		auto last = start;
+		for (auto frame = 0; frame < frameCount; frame++)
+		{
+			steps = pacer.BeginFrame();
+			last = std::chrono::steady_clock::now();
+			if (frame == 0)
+			{
+				start = last;
+			}
+
+			if (steps < 0 || steps > MAX_STEPS)
+			{
+				out << "a frame took " << steps << " steps" << std::endl;
+				return false;
+			}
+
+			while (std::chrono::duration<float>(std::chrono::steady_clock::now() - last).count() < work[frame])
+			{
+			}
+
+			pacer.EndFrame();
+		}
+		wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		cpuTime = processSeconds() - cpuStart;
+
+		// The first frame takes a step of its own, the rest is one step per STEP seconds between the first and the last BeginFrame.
+		pacer.GetStats(stats);
+		expected = std::chrono::duration<double>(last - start).count() / STEP + 1.0;
+		if (std::fabs((double)(stats.steps + stats.droppedSteps) - expected) > 2.0)
+		{
+			out << "took " << stats.steps << " steps and dropped " << stats.droppedSteps << ", expected " << expected << std::endl;
+			return false;
+		}
+
+		out << MODE_NAMES[mode] << "," << stats.averageFrameMs << "," << stats.jitterMs << "," << stats.worstErrorMs << ","
+			<< stats.sleepMs / (float)frameCount << "," << stats.spinMs / (float)frameCount << "," << stats.steps << "," << stats.droppedSteps
+			<< "," << (float)(cpuTime / wallTime * 100.0) << std::endl;
+
+		pacer.Shutdown();
+	}
+
+	return true;
+}
+
+/*
+Profiler times what a scope marker costs: scopeCount empty scopes on one thread, then on 1, 2, 4.. up to maxThreads threads at once
+while the main thread keeps writing the trace, which has to be safe while the rings are being written. Most of a scope is its two
+counter reads, so what one read costs on this machine is shown next to it. A ring keeps the last 65535 scopes of its thread, so the
+final trace has to hold exactly that many of the benchmark's scopes for every thread that recorded, or all of them when there were fewer.
+*/
+
+bool BenchmarkClass::Profiler(std::ostream& out, int scopeCount, int maxThreads)
+{
+	const char* SCOPE_NAME = "profiler benchmark scope";
+	const unsigned long long RING_EVENTS = 65535;
+	std::vector<int> threadCounts;
+	std::vector<std::thread> threads;
+	std::vector<float> threadTimes;
+	std::atomic<int> running;
+	std::ostringstream trace;
+	std::string text, pattern;
+	unsigned long long expected, found;
+	size_t position;
+	float scopeTime, readTime;
+	int traces, rings;
+
+	if (scopeCount <= 0)
+	{
+		return false;
+	}
+
+	if (maxThreads <= 0)
+	{
+		maxThreads = (int)std::thread::hardware_concurrency();
+		if (maxThreads <= 0)
+		{
+			maxThreads = 1;
+		}
+	}
+
+	for (auto count = 1; count < maxThreads; count *= 2)
+	{
+		threadCounts.push_back(count);
+	}
+	threadCounts.push_back(maxThreads);
+
+	// Returns nanoseconds per scope. The first scope on a thread makes its ring and is not timed.
+	auto record = [scopeCount, SCOPE_NAME]() -> float
+	{
+		{
+			ProfilerClass::ScopeType scope(SCOPE_NAME);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (auto i = 1; i < scopeCount; i++)
+		{
+			ProfilerClass::ScopeType scope(SCOPE_NAME);
+		}
+
+		return std::chrono::duration<float, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (float)std::max(scopeCount - 1, 1);
+	};
+
+	// Only what is recorded from here on is in the trace.
+	ProfilerClass::Initialize();
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto i = 0; i < scopeCount; i++)
+	{
+		ProfilerClass::GetTicks();
+	}
+	readTime = std::chrono::duration<float, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (float)scopeCount;
+
+	out << "profiler: " << scopeCount << " scopes a thread, " << std::fixed << std::setprecision(3) << readTime << " ns/counter read"
+		<< std::endl;
+	out << "threads,ns/scope,traces written" << std::endl;
+
+	scopeTime = record();
+	out << "main thread," << scopeTime << ",0" << std::endl;
+
+	rings = 1;
+	for (auto count : threadCounts)
+	{
+		running = count;
+		threadTimes.assign(count, 0.0f);
+		for (auto i = 0; i < count; i++)
+		{
+			threads.push_back(std::thread([&record, &running, &threadTimes, i]()
+			{
+				threadTimes[i] = record();
+				running--;
+			}));
+		}
+
+		traces = 0;
+		while (running > 0)
+		{
+			std::ostringstream partial;
+			ProfilerClass::WriteTrace(partial);
+			traces++;
+		}
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		threads.clear();
+
+		scopeTime = 0.0f;
+		for (auto time : threadTimes)
+		{
+			scopeTime += time / (float)count;
+		}
+
+		out << count << "," << scopeTime << "," << traces << std::endl;
+		rings += count;
+	}
+
+	// Every thread has a ring of its own, the ones that are gone included.
+	ProfilerClass::WriteTrace(trace);
+	text = trace.str();
+	pattern = std::string("\"name\":\"") + SCOPE_NAME + "\"";
+
+	found = 0;
+	for (position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1))
+	{
+		found++;
+	}
+
+	expected = (unsigned long long)rings * std::min((unsigned long long)scopeCount, RING_EVENTS);
+	if (found != expected)
+	{
+		out << "the trace holds " << found << " of the scopes, expected " << expected << std::endl;
+		return false;
+	}
+
+	out << "trace: " << text.size() / 1024 << " KB, " << ProfilerClass::GetEventCount() << " scopes" << std::endl;
+
+	return true;
+}
+
+/*
+HitchDetection runs frameCount frames of frameMs busy work against a hitch detector with a one second window. Three frames take far
+longer: one a third of the way in while something is loading, one a few frames after it, and one two thirds of the way in while
+something is compiling. All three have to be caught. The first and the last have to be dumped with their activity in the dump, the
+second falls into the first one's window and must not be. Other frames the detector flags are counted as false alarms, on a busy
+machine a frame can really take that long. A false alarm that was dumped holds off the dumps of the next second like any hitch, so a
+spike inside its window is not expected to be dumped either.
+*/
+
+bool BenchmarkClass::HitchDetection(std::ostream& out, int frameCount, float frameMs)
+{
+	const char* DUMP_PREFIX = "hitch_benchmark_";
+	const float WINDOW_SECONDS = 1.0f;
+	const float THRESHOLD_RATIO = 3.0f;
+	const float THRESHOLD_MS = 5.0f;
+	HitchDetectorClass hitches;
+	std::vector<std::string> dumps;
+	std::ifstream fin;
+	std::string text;
+	int spikes[3];
+	const char* details[3] = { "benchmark spike a", "benchmark spike b", "benchmark spike c" };
+	std::chrono::high_resolution_clock::time_point dumpTime;
+	bool quiet[3];
+	float spikeMs;
+	int falseAlarms, caught;
+	bool result, hitch, spike;
+
+	if (frameCount < 300 || frameMs <= 0.0f)
+	{
+		return false;
+	}
+
+	spikes[0] = frameCount / 3;
+	spikes[1] = frameCount / 3 + 5;
+	spikes[2] = frameCount * 2 / 3;
+	spikeMs = std::max(frameMs * THRESHOLD_RATIO * 2.0f, frameMs + THRESHOLD_MS * 4.0f);
+
+	result = hitches.Initialize(WINDOW_SECONDS, THRESHOLD_RATIO, THRESHOLD_MS, DUMP_PREFIX);
+	if (!result)
+	{
+		return false;
+	}
+
+	auto busy = [](float ms)
+	{
+		PROFILE_SCOPE("hitch benchmark frame");
+
+		auto start = std::chrono::high_resolution_clock::now();
+		while (std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() < ms)
+		{
+		}
+	};
+
+	falseAlarms = 0;
+	caught = 0;
+	for (auto frame = 0; frame < frameCount; frame++)
+	{
+		spike = false;
+		for (auto i = 0; i < 3; i++)
+		{
+			if (frame == spikes[i])
+			{
+				quiet[i] = !dumps.empty() && std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - dumpTime).count() <
+					WINDOW_SECONDS;
+
+				TRACK_ACTIVITY(i == 2 ? "compiling" : "loading", details[i]);
+				busy(spikeMs);
+				spike = true;
+			}
+		}
+
+		if (!spike)
+		{
+			busy(frameMs);
+		}
+
+		hitches.SetFrameStat("frame", (float)frame);
+		hitch = hitches.Frame();
+		if (hitch && spike)
+		{
+			caught++;
+		}
+		else if (hitch)
+		{
+			falseAlarms++;
+		}
+
+		// A dump that was just written belongs to this frame.
+		if (hitch && hitches.GetDumpCount() > dumps.size())
+		{
+			dumps.push_back(hitches.GetLastDump());
+			dumpTime = std::chrono::high_resolution_clock::now();
+			if (frame == spikes[1])
+			{
+				out << "the hitch right after another one was dumped" << std::endl;
+				result = false;
+			}
+		}
+	}
+
+	out << "hitch detection: " << frameCount << " frames of " << frameMs << " ms, spikes of " << spikeMs << " ms" << std::endl;
+	out << "caught " << caught << " of 3 spikes, " << falseAlarms << " false alarms, " << hitches.GetHitchCount() << " hitches, "
+		<< dumps.size() << " dumps" << std::endl;
+
+	if (caught != 3)
+	{
+		out << "a spike was not caught" << std::endl;
+		result = false;
+	}
+
+	// Every dump of a spike has to name the activity that was going on during it.
+	for (auto& dump : dumps)
+	{
+		fin.open(dump);
+		text.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+		fin.close();
+
+		for (auto i = 0; i < 3; i++)
+		{
+			if (dump == DUMP_PREFIX + std::to_string(spikes[i]) + ".json" && text.find(details[i]) == std::string::npos)
+			{
+				out << dump << " does not name its activity" << std::endl;
+				result = false;
+			}
+		}
+
+		out << dump << ": " << text.size() / 1024 << " KB" << std::endl;
+		std::remove(dump.c_str());
+	}
+
+	for (auto i = 0; i < 3; i += 2)
+	{
+		if (std::find(dumps.begin(), dumps.end(), DUMP_PREFIX + std::to_string(spikes[i]) + ".json") != dumps.end())
+		{
+			continue;
+		}
+
+		if (quiet[i])
+		{
+			out << "the spike at frame " << spikes[i] << " fell into a false alarm's dump window" << std::endl;
+		}
+		else
+		{
+			out << "a spike was not dumped" << std::endl;
+			result = false;
+		}
+	}
+
+	hitches.Shutdown();
+
+	return result;
+}
+
+/*
+RenderStats records the same frames twice, once straight on the null device's immediate context and once through a RenderStatsClass in
+front of it. A draw binds what a light shader draw binds, writes its constant buffer and draws a cube, and every frame also writes a
+vertex buffer and records a few draws on a deferred context. What the stats counted has to match what the device counted: the draws,
+triangles and binds of the frames, and the bytes uploaded, which the device counts all together. The CSV log has to have a line per
+frame. The difference in time between the two runs is what the counting costs, reported per call passed on.
+*/
+
+bool BenchmarkClass::RenderStats(std::ostream& out, int drawCount, int frameCount)
+{
+	const int DEFERRED_DRAWS = 4;
+	const int CALLS_PER_DRAW = 11;
+	const char* LOG_FILE = "renderstats_benchmark.csv";
+	NullRenderDeviceClass device;
+	RenderStatsClass stats;
+	RenderStatsClass::StatsType frameStats, totalStats;
+	NullRenderDeviceClass::CountersType before, after;
+	RenderBufferDesc bufferDesc;
+	RenderTextureDesc textureDesc;
+	RenderSamplerDesc samplerDesc;
+	RenderHandle vertexBuffer, indexBuffer, constantBuffer, texture, vertexShader, pixelShader, layout, sampler;
+	RenderContextClass* deferred;
+	std::vector<unsigned char> pixels(64 * 64 * 4, 255);
+	std::vector<float> vertices(24 * 8, 0.0f);
+	std::vector<unsigned int> indices(36, 0);
+	std::ifstream fin;
+	std::string line;
+	int logLines;
+	XMFLOAT4X4 constants;
+	unsigned long long binds;
+	float directTime, countedTime;
+	bool result;
+
+	result = device.Initialize() && stats.Initialize(&device);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Everything is created through the stats so they know which buffer is the constant buffer.
+	memset(&bufferDesc, 0, sizeof(bufferDesc));
+	bufferDesc.byteWidth = (unsigned int)(vertices.size() * sizeof(float));
+	bufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	bufferDesc.bindType = RENDER_BIND_VERTEX_BUFFER;
+	vertexBuffer = stats.CreateBuffer(bufferDesc, vertices.data());
+
+	bufferDesc.byteWidth = 36 * sizeof(unsigned int);
+	bufferDesc.usage = RENDER_USAGE_IMMUTABLE;
+	bufferDesc.bindType = RENDER_BIND_INDEX_BUFFER;
+	indexBuffer = stats.CreateBuffer(bufferDesc, indices.data());
+
+	bufferDesc.byteWidth = sizeof(XMFLOAT4X4);
+	bufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	bufferDesc.bindType = RENDER_BIND_CONSTANT_BUFFER;
+	constantBuffer = stats.CreateBuffer(bufferDesc, nullptr);
+
+	memset(&textureDesc, 0, sizeof(textureDesc));
+	textureDesc.width = 64;
+	textureDesc.height = 64;
+	textureDesc.format = RENDER_FORMAT_R8G8B8A8_UNORM;
+	texture = stats.CreateTexture2D(textureDesc, pixels.data(), 64 * 4);
+
+	memset(&samplerDesc, 0, sizeof(samplerDesc));
+	vertexShader = stats.CreateVertexShader(L"light.vs", "LightVertexShader");
+	pixelShader = stats.CreatePixelShader(L"light.ps", "LightPixelShader");
+	layout = stats.CreateInputLayout(nullptr, 0, vertexShader);
+	sampler = stats.CreateSamplerState(samplerDesc);
+
+	if (!vertexBuffer || !indexBuffer || !constantBuffer || !texture || !vertexShader || !pixelShader || !layout || !sampler)
+	{
+		out << "could not create the resources" << std::endl;
+		return false;
+	}
+
+	deferred = stats.CreateDeferredContext();
+	if (!deferred)
+	{
+		return false;
+	}
+
+	memset(&constants, 0, sizeof(constants));
+
+	auto draw = [&](RenderContextClass* context)
+	{
+		context->SetInputLayout(layout);
+		context->SetVertexBuffer(0, vertexBuffer, 32, 0);
+		context->SetIndexBuffer(indexBuffer, RENDER_FORMAT_R32_UINT, 0);
+		context->SetPrimitiveTopology(RENDER_TOPOLOGY_TRIANGLELIST);
+		context->SetVertexShader(vertexShader);
+		context->WriteBuffer(constantBuffer, 0, &constants, sizeof(constants), RENDER_MAP_WRITE_DISCARD);
+		context->SetVSConstantBuffer(0, constantBuffer);
+		context->SetPixelShader(pixelShader);
+		context->SetPSTexture(0, texture);
+		context->SetPSSampler(0, sampler);
+		context->DrawIndexed(36, 0, 0);
+	};
+
+	auto frame = [&](RenderDeviceClass* frameDevice)
+	{
+		RenderContextClass* context = frameDevice->GetImmediateContext();
+
+		frameDevice->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+		context->UpdateBuffer(vertexBuffer, vertices.data(), (unsigned int)(vertices.size() * sizeof(float)));
+		for (auto i = 0; i < drawCount; i++)
+		{
+			constants._11 = (float)i;
+			draw(context);
+		}
+		frameDevice->EndScene();
+	};
+
+	// Straight on the device first, then counted.
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto i = 0; i < frameCount; i++)
+	{
+		frame(&device);
+	}
+	directTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// The first counted frame also has the resources created above in it.
+	before = device.GetCounters();
+	start = std::chrono::high_resolution_clock::now();
+	for (auto i = 0; i < frameCount; i++)
+	{
+		frame(&stats);
+	}
+	countedTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// One more frame with a few draws recorded on the deferred context, and logged.
+	result = stats.OpenLog(LOG_FILE);
+	if (!result)
+	{
+		out << "could not open the log" << std::endl;
+		return false;
+	}
+
+	stats.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+	for (auto i = 0; i < DEFERRED_DRAWS; i++)
+	{
+		draw(deferred);
+	}
+	stats.ExecuteDeferredContext(deferred);
+	stats.CountObjects(DEFERRED_DRAWS, 1);
+	stats.EndScene();
+	stats.CloseLog();
+	after = device.GetCounters();
+
+	stats.GetFrameStats(frameStats);
+	stats.GetTotalStats(totalStats);
+
+	binds = 0;
+	for (auto kind = 0; kind < RenderStatsClass::STATE_KIND_COUNT; kind++)
+	{
+		binds += totalStats.stateChanges[kind];
+	}
+
+	result = true;
+	if (totalStats.frames != (unsigned long long)frameCount + 1 || totalStats.draws != after.draws - before.draws ||
+		totalStats.triangles != after.triangles - before.triangles || binds != after.binds - before.binds)
+	{
+		out << "the draws, triangles or binds counted do not match the device's" << std::endl;
+		result = false;
+	}
+
+	// The device's bytes leave out the resources, they were created before before was taken.
+	if (totalStats.constantBufferBytes + totalStats.bufferBytes + totalStats.textureBytes - (vertices.size() * sizeof(float) + 36 * sizeof(unsigned int)
+		+ pixels.size()) != after.bytesUploaded - before.bytesUploaded)
+	{
+		out << "the bytes counted do not match the device's" << std::endl;
+		result = false;
+	}
+
+	if (frameStats.frames != 1 || frameStats.draws != DEFERRED_DRAWS || frameStats.visibleObjects != DEFERRED_DRAWS || frameStats.culledObjects != 1 ||
+		frameStats.constantBufferBytes != DEFERRED_DRAWS * sizeof(constants) || totalStats.resourcesCreated != 8 || totalStats.textureBytes != pixels.size())
+	{
+		out << "the last frame or the totals are wrong" << std::endl;
+		result = false;
+	}
+
+	logLines = 0;
+	fin.open(LOG_FILE);
+	while (std::getline(fin, line))
+	{
+		logLines++;
+	}
+	fin.close();
+	std::remove(LOG_FILE);
+
+	if (logLines != 2)
+	{
+		out << "the log is not a header and the one logged frame" << std::endl;
+		result = false;
+	}
+
+	out << "render stats: " << frameCount << " frames of " << drawCount << " draws" << std::endl;
+	out << std::fixed << std::setprecision(2);
+	out << "direct " << directTime / (float)frameCount << " ms a frame, counted " << countedTime / (float)frameCount << " ms a frame, "
+		<< (countedTime - directTime) * 1000000.0f / ((float)frameCount * (float)drawCount * (float)CALLS_PER_DRAW) << " ns a call" << std::endl;
+	out << "per frame: " << totalStats.draws / totalStats.frames << " draws, " << totalStats.triangles / totalStats.frames << " triangles, "
+		<< binds / totalStats.frames << " state changes, " << totalStats.constantBufferBytes / totalStats.frames << " constant buffer bytes" << std::endl;
+
+	stats.ReleaseDeferredContext(deferred);
+	stats.Shutdown();
+	device.Shutdown();
+
+	return result;
+}
+
+/*
+PerfHud fills a PerfHudClass the way GraphicsClass does, with frame times around the target, the seven stages and the render counters,
+and builds and renders it on a sprite batch for frameCount frames. Before the first frame is drawn its layout is checked headlessly:
+every quad is four vertices, every vertex lies on the panel, and text has to end where MeasureText says. Every frame has to be one
+draw, with one more for a second atlas once a quad is added to one, and nothing may be dropped. A batch with room for a single quad has
+to drop the second. The time is the overlay's whole cost on the CPU, building the panel and recording its draw.
+*/
+
+bool BenchmarkClass::PerfHud(std::ostream& out, int frameCount)
+{
+	const char* STAGES[] = { "camera", "transforms", "cull", "lod", "sort keys", "constants", "submit" };
+	const float TARGET_MS = 1000.0f / 60.0f;
+	const float LEFT = 8.0f;
+	const float TOP = 8.0f;
+	NullRenderDeviceClass device;
+	StateCacheClass states;
+	SpriteBatchClass batch, smallBatch;
+	SpriteBatchClass::StatsType batchStats;
+	PerfHudClass hud;
+	NullRenderDeviceClass::CountersType before, after;
+	RenderTextureDesc textureDesc;
+	RenderHandle texture;
+	std::vector<unsigned char> pixels(4 * 4 * 4, 255);
+	std::mt19937 random(46);
+	XMMATRIX ortho;
+	float hudTime, textEnd;
+	int quads, atlas;
+	bool result;
+
+	if (frameCount <= 0)
+	{
+		return false;
+	}
+
+	result = device.Initialize() && states.Initialize(&device);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = batch.Initialize(&device, &states, 1280, 720, 4096) && smallBatch.Initialize(&device, &states, 1280, 720, 1) &&
+		hud.Initialize(120, TARGET_MS);
+	if (!result)
+	{
+		out << "could not initialize the sprite batch or the hud" << std::endl;
+		return false;
+	}
+
+	ortho = XMMatrixOrthographicLH(1280.0f, 720.0f, 0.1f, 1000.0f);
+
+	auto feed = [&]()
+	{
+		hud.AddFrameTime(TARGET_MS * (0.5f + std::uniform_real_distribution<float>()(random)));
+		for (auto stage = 0; stage < 7; stage++)
+		{
+			hud.SetStageTime(STAGES[stage], 0.01f * (float)(random() % 100));
+		}
+		hud.SetCounter("draws", 1000.0);
+		hud.SetCounter("triangles", 12000.0);
+		hud.SetCounter("state changes", 13000.0);
+		hud.SetCounter("cb bytes", 64000.0);
+	};
+
+	for (auto i = 0; i < 200; i++)
+	{
+		feed();
+	}
+	hud.SetMemory(PerfHudClass::GetProcessMemory());
+
+	// The layout, before anything is drawn.
+	hud.Build(&batch, LEFT, TOP);
+
+	result = true;
+	quads = 0;
+	for (atlas = 0; atlas < batch.GetAtlasCount(); atlas++)
+	{
+		const std::vector<SpriteBatchClass::VertexType>& vertices = batch.GetVertices(atlas);
+
+		quads += (int)vertices.size() / 4;
+		if (vertices.size() % 4 != 0)
+		{
+			result = false;
+		}
+
+		for (auto& vertex : vertices)
+		{
+			if (vertex.position.x < LEFT || vertex.position.y < TOP || vertex.position.x > LEFT + hud.GetWidth() ||
+				vertex.position.y > TOP + hud.GetHeight() || vertex.tex.x < 0.0f || vertex.tex.x > 1.0f || vertex.tex.y < 0.0f || vertex.tex.y > 1.0f)
+			{
+				result = false;
+			}
+		}
+	}
+
+	if (!result || quads != batch.GetQuadCount() || batch.GetAtlasCount() != 1)
+	{
+		out << "the hud's quads are not on its panel" << std::endl;
+		result = false;
+	}
+
+	batch.Clear();
+	textEnd = batch.AddText(0.0f, 0.0f, "frame 16.7 ms", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), 2.0f);
+	if (textEnd != SpriteBatchClass::MeasureText("frame 16.7 ms", 2.0f) || batch.GetQuadCount() != 11)
+	{
+		out << "the text does not end where it was measured or has a quad for a space" << std::endl;
+		result = false;
+	}
+	batch.Clear();
+
+	// One draw for the whole panel, then one more for a second atlas.
+	device.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+	before = device.GetCounters();
+	hud.Build(&batch, LEFT, TOP);
+	result = batch.Render(device.GetImmediateContext(), ortho) && result;
+	after = device.GetCounters();
+	device.EndScene();
+
+	if (after.draws - before.draws != 1)
+	{
+		out << "the hud took " << after.draws - before.draws << " draws" << std::endl;
+		result = false;
+	}
+
+	memset(&textureDesc, 0, sizeof(textureDesc));
+	textureDesc.width = 4;
+	textureDesc.height = 4;
+	textureDesc.format = RENDER_FORMAT_R8G8B8A8_UNORM;
+	texture = device.CreateTexture2D(textureDesc, pixels.data(), 4 * 4);
+	atlas = batch.AddAtlas(texture);
+
+	device.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+	before = device.GetCounters();
+	hud.Build(&batch, LEFT, TOP);
+	batch.AddQuad(atlas, 600.0f, 8.0f, 64.0f, 64.0f, XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+	result = batch.Render(device.GetImmediateContext(), ortho) && result;
+	after = device.GetCounters();
+	device.EndScene();
+
+	if (atlas != 1 || after.draws - before.draws != 2)
+	{
+		out << "two atlases did not take two draws" << std::endl;
+		result = false;
+	}
+
+	if (!smallBatch.AddRect(0.0f, 0.0f, 1.0f, 1.0f, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f)) || smallBatch.AddRect(0.0f, 0.0f, 1.0f, 1.0f, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f)))
+	{
+		out << "a full batch did not drop the quad" << std::endl;
+		result = false;
+	}
+	smallBatch.GetStats(batchStats);
+	if (batchStats.dropped != 1)
+	{
+		result = false;
+	}
+
+	// What the overlay costs a frame.
+	batch.ResetStats();
+	before = device.GetCounters();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto i = 0; i < frameCount; i++)
+	{
+		feed();
+		device.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+		hud.Build(&batch, LEFT, TOP);
+		if (!batch.Render(device.GetImmediateContext(), ortho))
+		{
+			result = false;
+		}
+		device.EndScene();
+	}
+	hudTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	after = device.GetCounters();
+
+	batch.GetStats(batchStats);
+	if (batchStats.draws != (unsigned long long)frameCount || after.draws - before.draws != (unsigned long long)frameCount || batchStats.dropped != 0)
+	{
+		out << "the hud frames did not take one draw each" << std::endl;
+		result = false;
+	}
+
+	out << "perf hud: " << frameCount << " frames, " << batchStats.quads / (unsigned long long)frameCount << " quads a frame, "
+		<< (after.bytesUploaded - before.bytesUploaded) / (unsigned long long)frameCount << " bytes uploaded a frame" << std::endl;
+	out << std::fixed << std::setprecision(4);
+	out << "build and render " << hudTime / (float)frameCount << " ms a frame" << std::endl;
+
+	device.ReleaseResource(texture);
+	smallBatch.Shutdown();
+	batch.Shutdown();
+	hud.Shutdown();
+	states.Shutdown();
+	device.Shutdown();
+
+	return result;
+}
+
+/*
+MemoryTracking checks the tracker's numbers against allocations of known sizes, on the CPU through NewArray and a tagged vector and on
+the GPU through a GpuMemoryClass in front of the null device, then that going over a budget is counted, that a snapshot diff only has
+the rows that changed and that a leak shows up in the leak report. The tracker is shared by the whole process, so everything is checked
+as a change from what was there before. Last it times allocationCount tracked allocations against plain new and delete.
+*/
+
+bool BenchmarkClass::MemoryTracking(std::ostream& out, int allocationCount)
+{
+	const unsigned long long BUFFER_BYTES = 512 * 1024;
+	NullRenderDeviceClass device;
+	GpuMemoryClass gpuMemory;
+	MemoryTrackerClass::UsageType before, after;
+	RenderBufferDesc bufferDesc;
+	RenderTextureDesc textureDesc;
+	RenderHandle buffers[3], texture;
+	std::stringstream first, second, diff, leaks;
+	std::string line;
+	std::vector<void*> pointers(allocationCount);
+	float trackedTime, plainTime;
+	int lines;
+	void* leak;
+	bool result;
+
+	if (allocationCount <= 0)
+	{
+		return false;
+	}
+
+	result = device.Initialize() && gpuMemory.Initialize(&device);
+	if (!result)
+	{
+		return false;
+	}
+
+	// CPU memory, the array and the vector count under the scope they were made in.
+	{
+		MEMORY_SCOPE(MEMORY_OTHER, "benchmark");
+
+		MemoryTrackerClass::GetUsage(MEMORY_CPU, MEMORY_OTHER, before);
+
+		MemoryTrackerClass::ArrayType<float> floats = MemoryTrackerClass::NewArray<float>(1000);
+		std::vector<int, TaggedAllocatorType<int>> ints;
+		ints.reserve(500);
+
+		MemoryTrackerClass::GetUsage(MEMORY_CPU, MEMORY_OTHER, after);
+		if (!floats || floats[999] != 0.0f || after.bytes - before.bytes != 1000 * sizeof(float) + 500 * sizeof(int) || after.count - before.count != 2)
+		{
+			out << "the tracked cpu memory is " << after.bytes - before.bytes << " bytes in " << after.count - before.count << " allocations" << std::endl;
+			result = false;
+		}
+	}
+
+	MemoryTrackerClass::GetUsage(MEMORY_CPU, MEMORY_OTHER, after);
+	if (after.bytes != before.bytes || after.count != before.count)
+	{
+		out << "the cpu memory was not untracked when it was freed" << std::endl;
+		result = false;
+	}
+
+	// GPU memory, a mip chain of a 256x256 texture is 4 / 3 of it less a little, and a budget crossed once is counted once.
+	memset(&bufferDesc, 0, sizeof(bufferDesc));
+	bufferDesc.byteWidth = (unsigned int)BUFFER_BYTES;
+	bufferDesc.usage = RENDER_USAGE_DEFAULT;
+	bufferDesc.bindType = RENDER_BIND_VERTEX_BUFFER;
+
+	memset(&textureDesc, 0, sizeof(textureDesc));
+	textureDesc.width = 256;
+	textureDesc.height = 256;
+	textureDesc.format = RENDER_FORMAT_R8G8B8A8_UNORM;
+	textureDesc.generateMips = true;
+
+	if (GpuMemoryClass::GetTextureBytes(textureDesc) != 349524)
+	{
+		out << "a 256x256 texture with mips is " << GpuMemoryClass::GetTextureBytes(textureDesc) << " bytes" << std::endl;
+		result = false;
+	}
+
+	{
+		MEMORY_SCOPE(MEMORY_GEOMETRY, "benchmark buffers");
+
+		MemoryTrackerClass::GetUsage(MEMORY_GPU, MEMORY_GEOMETRY, before);
+		MemoryTrackerClass::SetBudget(MEMORY_GPU, MEMORY_GEOMETRY, before.bytes + 2 * BUFFER_BYTES + BUFFER_BYTES / 2);
+
+		for (auto i = 0; i < 3; i++)
+		{
+			buffers[i] = gpuMemory.CreateBuffer(bufferDesc, nullptr);
+		}
+
+		MemoryTrackerClass::GetUsage(MEMORY_GPU, MEMORY_GEOMETRY, after);
+		if (after.bytes - before.bytes != 3 * BUFFER_BYTES || after.peak < after.bytes || after.overBudget - before.overBudget != 1)
+		{
+			out << "the buffers are " << after.bytes - before.bytes << " bytes, " << after.overBudget - before.overBudget << " times over budget" << std::endl;
+			result = false;
+		}
+
+		for (auto i = 0; i < 3; i++)
+		{
+			gpuMemory.ReleaseResource(buffers[i]);
+		}
+
+		MemoryTrackerClass::SetBudget(MEMORY_GPU, MEMORY_GEOMETRY, before.budget);
+	}
+
+	// A snapshot before and after the texture, only its tag and asset rows change.
+	MemoryTrackerClass::WriteSnapshot(first);
+	{
+		MEMORY_SCOPE(MEMORY_TEXTURE, "benchmark texture");
+		texture = gpuMemory.CreateTexture2D(textureDesc, nullptr, 256 * 4);
+	}
+	MemoryTrackerClass::WriteSnapshot(second);
+
+	if (!MemoryTrackerClass::DiffSnapshots(first, second, diff))
+	{
+		out << "the snapshots could not be diffed" << std::endl;
+		result = false;
+	}
+
+	lines = 0;
+	while (std::getline(diff, line))
+	{
+		lines++;
+	}
+
+	if (lines != 3 || diff.str().find("gpu,texture,benchmark texture,0,1,0,349524,+349524") == std::string::npos)
+	{
+		out << "the snapshot diff is" << std::endl << diff.str();
+		result = false;
+	}
+
+	gpuMemory.ReleaseResource(texture);
+
+	// A leak, it is in the report until it is freed.
+	{
+		MEMORY_SCOPE(MEMORY_OTHER, "benchmark leak");
+		leak = MemoryTrackerClass::Allocate(12345);
+	}
+
+	MemoryTrackerClass::WriteLeakReport(leaks);
+	if (leaks.str().find("cpu other benchmark leak 12345 bytes") == std::string::npos)
+	{
+		out << "the leak is not in the leak report" << std::endl;
+		result = false;
+	}
+	MemoryTrackerClass::Free(leak);
+
+	// What tracking costs an allocation.
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto i = 0; i < allocationCount; i++)
+	{
+		pointers[i] = MemoryTrackerClass::Allocate(64);
+	}
+	for (auto i = 0; i < allocationCount; i++)
+	{
+		MemoryTrackerClass::Free(pointers[i]);
+	}
+	trackedTime = std::chrono::duration<float, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+
+	start = std::chrono::high_resolution_clock::now();
+	for (auto i = 0; i < allocationCount; i++)
+	{
+		pointers[i] = new char[64];
+	}
+	for (auto i = 0; i < allocationCount; i++)
+	{
+		delete[] (char*)pointers[i];
+	}
+	plainTime = std::chrono::duration<float, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+
+	out << "memory tracking: " << allocationCount << " allocations" << std::endl;
+	out << std::fixed << std::setprecision(1);
+	out << "tracked " << trackedTime / (float)allocationCount << " ns, new and delete " << plainTime / (float)allocationCount
+		<< " ns an allocation and free" << std::endl;
+
+	gpuMemory.Shutdown();
+	device.Shutdown();
+
+	return result;
+}
+
+//what InputLatency's simulation hands its renderer, the frame and the input it acted on
+struct LatencySnapshotType
+{
+	unsigned long long frame;
+	unsigned long long inputTime;
+};
+
+//Spin keeps the thread busy for the given milliseconds, like a simulation or a render that takes that long.
+
+static void Spin(float ms)
+{
+	// The end is worked out in the clock's own ticks, a float time point would round it to far more than a millisecond.
+	auto end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(ms));
+
+	while (std::chrono::steady_clock::now() < end)
+	{
+	}
+
+	return;
+}
+
+/*
+InputLatency runs the simulation and render threads the way SystemClass does, through a snapshot exchange, with an input stamped at
+the start of every simulated frame. The simulation takes half of frameMs and the render all of it; with vsync the present then waits
+for the next refresh, every frameMs from the start. It reports the input to present latency at pipeline depths 1, 2 and 3 with vsync
+off and on, and checks that no input was presented before its frame could have been rendered.
+*/
+
+bool BenchmarkClass::InputLatency(std::ostream& out, int frameCount, float frameMs)
+{
+	SnapshotExchangeClass<LatencySnapshotType> exchange;
+	LatencyTrackerClass latency;
+	LatencyTrackerClass::SummaryType summary;
+	std::atomic<bool> stop, failed;
+	bool result, vsync;
+	int depth;
+
+	if (frameCount <= 0 || frameMs <= 0.0f)
+	{
+		return false;
+	}
+
+	result = latency.Initialize(frameCount);
+	if (!result)
+	{
+		return false;
+	}
+
+	out << "input latency: " << frameCount << " frames of " << frameMs << " ms" << std::endl;
+	out << "depth,vsync,samples,median ms,95th ms,99th ms,max ms,median frames,max frames" << std::endl;
+
+	for (auto run = 0; run < 6; run++)
+	{
+		depth = run % 3 + 1;
+		vsync = run >= 3;
+
+		exchange.Initialize(depth);
+		latency.Reset();
+		stop = false;
+		failed = false;
+
+		auto start = std::chrono::steady_clock::now();
+
+		// The render thread, with the present last.
+		std::thread renderer([&]()
+		{
+			const LatencySnapshotType* snapshot;
+			float elapsed;
+
+			while (!stop || exchange.GetCompletedFrame() != exchange.GetPublishedFrame())
+			{
+				snapshot = exchange.WaitForSnapshot(stop);
+				if (!snapshot)
+				{
+					continue;
+				}
+
+				Spin(frameMs);
+
+				if (vsync)
+				{
+					elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+					Spin(frameMs * std::ceil(elapsed / frameMs) - elapsed);
+				}
+
+				latency.Present(snapshot->inputTime);
+				exchange.Complete();
+			}
+		});
+
+		// The simulation, on this thread.
+		for (unsigned long long frame = 1; frame <= (unsigned long long)frameCount; frame++)
+		{
+			if (!exchange.WaitForConsumer(failed))
+			{
+				break;
+			}
+
+			LatencySnapshotType& snapshot = exchange.GetWriteSlot();
+			snapshot.frame = frame;
+			snapshot.inputTime = LatencyTrackerClass::GetTime();
+
+			Spin(0.5f * frameMs);
+
+			exchange.Publish(frame);
+		}
+
+		stop = true;
+		exchange.Notify();
+		renderer.join();
+
+		latency.GetSummary(summary);
+		if (summary.samples == 0 || summary.medianMs < 1.5f * frameMs || summary.medianFrames < 1.0f)
+		{
+			out << "depth " << depth << (vsync ? " with" : " without") << " vsync presented inputs too early" << std::endl;
+			result = false;
+		}
+
+		out << std::fixed << std::setprecision(3);
+		out << depth << "," << (vsync ? "on" : "off") << "," << summary.samples << "," << summary.medianMs << "," << summary.p95Ms << ","
+			<< summary.p99Ms << "," << summary.maxMs << "," << summary.medianFrames << "," << summary.maxFrames << std::endl;
+	}
+
+	latency.Shutdown();
+
+	return result;
+}
+
+/*
+InputQueue stress tests the input path in two parts. First QUEUE_PAIRS producer and consumer thread pairs all run at once, each pair
+on an event queue small enough to fill up all the time, the producer pushing eventCount numbers in order and retrying when the queue
+is full, and the consumer checking it gets every number once and in order. Then a message pump thread sends eventCount / 2 short key
+presses, a down and an up right away, to an InputClass whose frames run on another thread. Every press has to be counted by exactly one
+frame, no key may be left down and the last event time has to be the last one sent.
+*/
+
+bool BenchmarkClass::InputQueue(std::ostream& out, int eventCount)
+{
+	const int QUEUE_PAIRS = 4;
+	const unsigned int KEY_COUNT = 200;
+	std::vector<std::unique_ptr<EventQueueClass<unsigned long long, 64>>> queues(QUEUE_PAIRS);
+	std::vector<std::thread> threads;
+	std::atomic<bool> failed(false), pumpDone(false);
+	std::atomic<unsigned long long> full(0);
+	std::unique_ptr<InputClass> input;
+	unsigned long long presses, frames, lastTime, sentTime, retries, dropped;
+	float queueTime;
+	bool result;
+
+	if (eventCount <= 0)
+	{
+		return false;
+	}
+
+	// Every pair at once.
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto pair = 0; pair < QUEUE_PAIRS; pair++)
+	{
+		queues[pair].reset(new EventQueueClass<unsigned long long, 64>());
+		EventQueueClass<unsigned long long, 64>* queue = queues[pair].get();
+
+		threads.push_back(std::thread([&, queue]()
+		{
+			for (unsigned long long value = 1; value <= (unsigned long long)eventCount; value++)
+			{
+				while (!queue->Push(value))
+				{
+					full++;
+					std::this_thread::yield();
+				}
+			}
+		}));
+
+		threads.push_back(std::thread([&, queue]()
+		{
+			unsigned long long value, expected;
+
+			expected = 1;
+			while (expected <= (unsigned long long)eventCount && !failed)
+			{
+				if (!queue->Pop(value))
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				if (value != expected)
+				{
+					failed = true;
+				}
+				expected++;
+			}
+		}));
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	queueTime = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+	threads.clear();
+
+	result = !failed;
+	dropped = 0;
+	for (auto pair = 0; pair < QUEUE_PAIRS; pair++)
+	{
+		if (queues[pair]->GetCount() != 0)
+		{
+			result = false;
+		}
+		dropped += queues[pair]->GetDroppedCount();
+	}
+
+	if (dropped != full)
+	{
+		result = false;
+	}
+
+	if (!result)
+	{
+		out << "an event queue lost, repeated or reordered an event" << std::endl;
+	}
+
+	// The message pump and the frames.
+	input.reset(new InputClass());
+	input->Initialize();
+
+	presses = 0;
+	frames = 0;
+	lastTime = 0;
+	sentTime = 0;
+	retries = 0;
+
+	std::thread pump([&]()
+	{
+		unsigned long long time;
+		unsigned int key;
+
+		time = 0;
+		for (auto i = 0; i < eventCount / 2; i++)
+		{
+			key = (unsigned int)i % KEY_COUNT + 1;
+
+			time = LatencyTrackerClass::GetTime();
+			while (!input->KeyDown(key, time))
+			{
+				retries++;
+				std::this_thread::yield();
+			}
+
+			time = LatencyTrackerClass::GetTime();
+			while (!input->KeyUp(key, time))
+			{
+				retries++;
+				std::this_thread::yield();
+			}
+		}
+
+		sentTime = time;
+		pumpDone = true;
+	});
+
+	// The frames, on this thread. After the pump is done one more frame takes whatever it sent last.
+	auto done = false;
+	while (!done)
+	{
+		done = pumpDone;
+
+		if (input->Frame() == 0)
+		{
+			std::this_thread::yield();
+		}
+		frames++;
+
+		if (input->GetLastEventTime() < lastTime)
+		{
+			failed = true;
+		}
+		lastTime = input->GetLastEventTime();
+
+		for (unsigned int key = 0; key < 256; key++)
+		{
+			presses += input->GetPressCount(key);
+
+			// A key that went down twice went up in between, and one that went down is down for the frame.
+			if ((input->GetPressCount(key) > 1 && !input->WasKeyReleased(key)) || (input->GetPressCount(key) > 0 && !input->IsKeyDown(key)))
+			{
+				failed = true;
+			}
+		}
+	}
+	pump.join();
+
+	// Every press was released, after one more frame no key is down.
+	input->Frame();
+	for (unsigned int key = 0; key < 256; key++)
+	{
+		if (input->IsKeyDown(key))
+		{
+			failed = true;
+		}
+	}
+
+	if (failed || presses != (unsigned long long)(eventCount / 2) || lastTime != sentTime)
+	{
+		out << "the input frames counted " << presses << " of " << eventCount / 2 << " presses" << std::endl;
+		result = false;
+	}
+
+	out << "input queue: " << QUEUE_PAIRS << " queue pairs, " << eventCount << " events each, " << std::fixed << std::setprecision(1)
+		<< (float)(QUEUE_PAIRS * (unsigned long long)eventCount) / queueTime / 1000000.0f << " million events/s, " << full.load()
+		<< " pushes retried on a full queue" << std::endl;
+	out << "input frames: " << presses << " presses over " << frames << " frames, " << retries << " events retried on a full queue"
+		<< std::endl;
+
+	return result;
+}
+
+/*
+ParallelStartup builds the startup tasks of GraphicsClass::InitializeScene with the dependencies it gives them, each one spinning for
+about the time it takes on a D3D11 machine, a tenth of it so the benchmark stays short: creating the device and compiling the light
+shader are the long ones, then parsing the model and decoding its texture. Every task stamps when it started and ended from one shared
+counter, afterwards each task has to have started after the tasks it depends on ended, and no two device tasks may have overlapped or
+run on any thread but the calling one. The CPU tasks run on a job system of each thread count in turn. A second run has the model parse
+fail, which has to skip the tasks after it and only those.
+*/
+
+bool BenchmarkClass::ParallelStartup(std::ostream& out, int maxThreads)
+{
+	const int TASK_COUNT = 14;
+	const char* names[TASK_COUNT] = { "device", "model parse", "texture decode", "light shader compile", "immediate geometry compile",
+		"perf hud compile", "state cache", "recorder", "geometry pool", "model buffers", "geometry upload", "light shader", "immediate geometry",
+		"sprite batch" };
+	const float durations[TASK_COUNT] = { 12.0f, 2.5f, 1.5f, 6.0f, 2.5f, 2.0f, 0.5f, 0.2f, 0.3f, 1.5f, 0.2f, 0.5f, 0.2f, 0.3f };
+	const bool device[TASK_COUNT] = { true, false, false, false, false, false, true, true, true, true, true, true, true, true };
+	const std::vector<std::vector<int>> dependencies = { {}, {}, {}, {}, {}, {}, { 0 }, { 0 }, { 0 }, { 1, 2, 8 }, { 9 }, { 6, 3 }, { 6, 4 },
+		{ 6, 5 } };
+	std::vector<int> threadCounts, path;
+	std::thread::id mainThread;
+	float serialTime, baselineTime;
+	bool result;
+
+	if (maxThreads <= 0)
+	{
+		maxThreads = (int)std::thread::hardware_concurrency();
+		if (maxThreads <= 0)
+		{
+			maxThreads = 1;
+		}
+	}
+
+	for (auto threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	serialTime = 0.0f;
+	for (auto duration : durations)
+	{
+		serialTime += duration;
+	}
+
+	mainThread = std::this_thread::get_id();
+
+	out << "parallel startup: " << TASK_COUNT << " tasks adding up to " << std::fixed << std::setprecision(3) << serialTime << " ms" << std::endl;
+	out << "threads  first frame ms  critical path ms  speedup" << std::endl;
+
+	baselineTime = 0.0f;
+	for (auto threads : threadCounts)
+	{
+		JobSystemClass jobs;
+		StartupSchedulerClass startup;
+		std::vector<int> starts(TASK_COUNT, -1), ends(TASK_COUNT, -1);
+		std::atomic<int> clock(0), deviceTasks(0);
+		std::atomic<bool> failed(false);
+
+		result = jobs.Initialize(threads);
+		if (!result)
+		{
+			return false;
+		}
+
+		result = startup.Initialize(&jobs);
+		if (!result)
+		{
+			jobs.Shutdown();
+			return false;
+		}
+
+		for (auto i = 0; i < TASK_COUNT; i++)
+		{
+			auto task = [&, i]()
+			{
+				starts[i] = clock++;
+
+				if (device[i] && (deviceTasks++ > 0 || std::this_thread::get_id() != mainThread))
+				{
+					failed = true;
+				}
+
+				Spin(durations[i]);
+
+				if (device[i])
+				{
+					deviceTasks--;
+				}
+
+				ends[i] = clock++;
+				return true;
+			};
+
+			startup.AddTask(names[i], device[i] ? StartupSchedulerClass::LANE_DEVICE : StartupSchedulerClass::LANE_CPU, task, dependencies[i]);
+		}
+
+		result = startup.Run();
+		if (!result || failed)
+		{
+			out << threads << " threads: a device task ran next to another one or off the calling thread" << std::endl;
+			jobs.Shutdown();
+			return false;
+		}
+
+		for (auto i = 0; i < TASK_COUNT; i++)
+		{
+			for (auto dependency : dependencies[i])
+			{
+				if (starts[i] < ends[dependency])
+				{
+					out << threads << " threads: " << names[i] << " started before " << names[dependency] << " ended" << std::endl;
+					jobs.Shutdown();
+					return false;
+				}
+			}
+		}
+
+		if (threads == 1)
+		{
+			baselineTime = startup.GetTotalTime();
+		}
+
+		out << std::setw(7) << threads << std::setw(16) << startup.GetTotalTime() << std::setw(18) << startup.GetCriticalPath(path)
+			<< std::setw(9) << std::setprecision(2) << baselineTime / startup.GetTotalTime() << std::setprecision(3) << std::endl;
+
+		if (threads == maxThreads)
+		{
+			startup.WriteTimeline(out);
+		}
+
+		startup.Shutdown();
+		jobs.Shutdown();
+	}
+
+	// A failed task holds up what depends on it and nothing else.
+	{
+		JobSystemClass jobs;
+		StartupSchedulerClass startup;
+		std::atomic<int> ran(0);
+		int parse, decode, pool, buffers;
+
+		result = jobs.Initialize(maxThreads);
+		if (!result)
+		{
+			return false;
+		}
+
+		result = startup.Initialize(&jobs);
+		if (!result)
+		{
+			jobs.Shutdown();
+			return false;
+		}
+
+		parse = startup.AddTask("model parse", StartupSchedulerClass::LANE_CPU, [&]() { ran++; return false; });
+		decode = startup.AddTask("texture decode", StartupSchedulerClass::LANE_CPU, [&]() { ran++; return true; });
+		pool = startup.AddTask("geometry pool", StartupSchedulerClass::LANE_DEVICE, [&]() { ran++; return true; });
+		buffers = startup.AddTask("model buffers", StartupSchedulerClass::LANE_DEVICE, [&]() { ran++; return true; }, { parse, decode, pool });
+		startup.AddTask("geometry upload", StartupSchedulerClass::LANE_DEVICE, [&]() { ran++; return true; }, { buffers });
+		startup.AddTask("light shader", StartupSchedulerClass::LANE_DEVICE, [&]() { ran++; return true; }, { pool });
+
+		result = startup.Run();
+		if (result || ran != 4 || !startup.GetFailedTask() || strcmp(startup.GetFailedTask(), "model parse") != 0)
+		{
+			out << "a failed model parse ran " << ran.load() << " of 4 tasks" << std::endl;
+			jobs.Shutdown();
+			return false;
+		}
+
+		// A dependency on a task that is not there yet fails the run before anything runs.
+		if (startup.AddTask("sprite batch", StartupSchedulerClass::LANE_DEVICE, [&]() { return true; }, { 99 }) != -1 || startup.Run())
+		{
+			out << "a task depending on a task added after it was accepted" << std::endl;
+			jobs.Shutdown();
+			return false;
+		}
+
+		startup.Shutdown();
+		jobs.Shutdown();
+	}
+
+	return true;
+}
+
+//what SoftwareRasterizer draws, the same 32 byte layout as a ModelClass vertex
+struct RasterVertexType
+{
+	XMFLOAT3 position;
+	XMFLOAT2 texture;
+	XMFLOAT3 normal;
+};
+
+//AddRasterQuad adds the two triangles of a screen aligned quad facing the camera, wound clockwise on screen unless it is flipped.
+
+static void AddRasterQuad(std::vector<RasterVertexType>& vertices, float left, float top, float right, float bottom, float depth, bool flipped)
+{
+	RasterVertexType corners[4] =
+	{
+		{ XMFLOAT3(left, top, depth), XMFLOAT2(0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+		{ XMFLOAT3(right, top, depth), XMFLOAT2(1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+		{ XMFLOAT3(right, bottom, depth), XMFLOAT2(1.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+		{ XMFLOAT3(left, bottom, depth), XMFLOAT2(0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+	};
+	const int CLOCKWISE[6] = { 0, 1, 2, 0, 2, 3 };
+	const int COUNTER_CLOCKWISE[6] = { 0, 2, 1, 0, 3, 2 };
+
+	for (auto i = 0; i < 6; i++)
+	{
+		vertices.push_back(corners[flipped ? COUNTER_CLOCKWISE[i] : CLOCKWISE[i]]);
+	}
+
+	return;
+}
+
+/*
+SoftwareRasterizer draws four quads on a 256x256 target with an orthographic projection that maps one unit to one pixel and z straight
+to depth, with the back face culling and clockwise front faces GraphicsClass uses. A red quad at depth 0.625, a green one over part of
+it at 0.25, a blue one at 0.75 that the red one partly hides and a back facing one that has to be culled. The quad edges lie between
+pixel centers but each quad's diagonal runs through them, so a wrong fill rule leaves holes. Every pixel's depth and colour are then
+checked against what the quads must give, and the 31744 covered pixels counted. Last it times frameCount frames of 1280x720 covered
+four times over by 20x20 pixel quads, drawn back to front so every layer is shaded.
+*/
+
+bool BenchmarkClass::SoftwareRasterizer(std::ostream& out, int frameCount)
+{
+	const int SIZE = 256;
+	const int COVERED = 31744;
+	const unsigned int DEPTH_RED = 10485759;
+	const unsigned int DEPTH_GREEN = 4194304;
+	const unsigned int DEPTH_BLUE = 12582911;
+	const unsigned int DEPTH_CLEAR = 0xFFFFFF;
+	const int WIDTH = 1280;
+	const int HEIGHT = 720;
+	const int QUAD_SIZE = 20;
+	const float LAYERS[4] = { 0.8f, 0.6f, 0.4f, 0.2f };
+	const unsigned int DEPTH_FRONT = 3355443;
+	JobSystemClass jobs;
+	SoftwareRasterizerClass rasterizer, screen;
+	std::vector<RasterVertexType> red, green, blue, back, layer;
+	std::vector<unsigned char> white(4 * 4 * 4, 255);
+	XMMATRIX identity, projection;
+	XMFLOAT3 lightDirection(0.0f, 0.0f, 1.0f);
+	const unsigned int* depth;
+	const unsigned char* color;
+	float frameTime;
+	int covered, wrong, texture;
+	bool result;
+
+	if (frameCount <= 0)
+	{
+		return false;
+	}
+
+	result = jobs.Initialize(0);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = rasterizer.Initialize(SIZE, SIZE, &jobs) && screen.Initialize(WIDTH, HEIGHT, &jobs);
+	if (!result)
+	{
+		out << "could not initialize the rasterizer" << std::endl;
+		jobs.Shutdown();
+		return false;
+	}
+
+	rasterizer.SetRasterizerState(SoftwareRasterizerClass::CULL_BACK, false);
+	texture = rasterizer.CreateTexture(white.data(), 4, 4);
+
+	AddRasterQuad(red, 32.0f, 32.0f, 160.0f, 160.0f, 0.625f, false);
+	AddRasterQuad(green, 96.0f, 96.0f, 224.0f, 224.0f, 0.25f, false);
+	AddRasterQuad(blue, 0.0f, 0.0f, 64.0f, 64.0f, 0.75f, false);
+	AddRasterQuad(back, 0.0f, 192.0f, 64.0f, 256.0f, 0.1f, true);
+
+	identity = XMMatrixIdentity();
+	projection = XMMatrixOrthographicOffCenterLH(0.0f, (float)SIZE, (float)SIZE, 0.0f, 0.0f, 1.0f);
+
+	rasterizer.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+	rasterizer.Draw(red.data(), sizeof(RasterVertexType), (int)red.size(), texture, identity, identity, projection, lightDirection,
+		XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f));
+	rasterizer.Draw(green.data(), sizeof(RasterVertexType), (int)green.size(), texture, identity, identity, projection, lightDirection,
+		XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f));
+	rasterizer.Draw(blue.data(), sizeof(RasterVertexType), (int)blue.size(), texture, identity, identity, projection, lightDirection,
+		XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f));
+	rasterizer.Draw(back.data(), sizeof(RasterVertexType), (int)back.size(), texture, identity, identity, projection, lightDirection,
+		XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+	rasterizer.EndScene();
+
+	// Every pixel belongs to the nearest quad over its center, or to nothing.
+	depth = rasterizer.GetDepthBuffer();
+	color = rasterizer.GetColorBuffer();
+	covered = 0;
+	wrong = 0;
+	for (auto y = 0; y < SIZE; y++)
+	{
+		for (auto x = 0; x < SIZE; x++)
+		{
+			unsigned int expectedDepth = DEPTH_CLEAR;
+			unsigned char expectedColor[4] = { 0, 0, 0, 255 };
+
+			if (x >= 96 && x < 224 && y >= 96 && y < 224)
+			{
+				expectedDepth = DEPTH_GREEN;
+				expectedColor[1] = 255;
+			}
+			else if (x >= 32 && x < 160 && y >= 32 && y < 160)
+			{
+				expectedDepth = DEPTH_RED;
+				expectedColor[0] = 255;
+			}
+			else if (x < 64 && y < 64)
+			{
+				expectedDepth = DEPTH_BLUE;
+				expectedColor[2] = 255;
+			}
+
+			if (depth[y * SIZE + x] != DEPTH_CLEAR)
+			{
+				covered++;
+			}
+			if (depth[y * SIZE + x] != expectedDepth || memcmp(color + (y * SIZE + x) * 4, expectedColor, 4) != 0)
+			{
+				wrong++;
+			}
+		}
+	}
+
+	if (covered != COVERED || wrong != 0)
+	{
+		out << "the quads covered " << covered << " pixels instead of " << COVERED << ", " << wrong << " pixels have the wrong depth or colour"
+			<< std::endl;
+		result = false;
+	}
+
+	// A full screen four layers deep.
+	screen.SetRasterizerState(SoftwareRasterizerClass::CULL_BACK, false);
+	texture = screen.CreateTexture(white.data(), 4, 4);
+	projection = XMMatrixOrthographicOffCenterLH(0.0f, (float)WIDTH, (float)HEIGHT, 0.0f, 0.0f, 1.0f);
+
+	for (auto z : LAYERS)
+	{
+		for (auto y = 0; y < HEIGHT; y += QUAD_SIZE)
+		{
+			for (auto x = 0; x < WIDTH; x += QUAD_SIZE)
+			{
+				AddRasterQuad(layer, (float)x, (float)y, (float)(x + QUAD_SIZE), (float)(y + QUAD_SIZE), z, false);
+			}
+		}
+	}
+
+	frameTime = 0.0f;
+	for (auto i = 0; i < frameCount; i++)
+	{
+		screen.BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+		screen.Draw(layer.data(), sizeof(RasterVertexType), (int)layer.size(), texture, identity, identity, projection, lightDirection,
+			XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+		screen.EndScene();
+		frameTime += screen.GetFrameTime();
+	}
+
+	depth = screen.GetDepthBuffer();
+	wrong = 0;
+	for (auto i = 0; i < WIDTH * HEIGHT; i++)
+	{
+		if (depth[i] != DEPTH_FRONT)
+		{
+			wrong++;
+		}
+	}
+
+	if (wrong != 0)
+	{
+		out << wrong << " pixels of the full screen are not at the front layer's depth" << std::endl;
+		result = false;
+	}
+
+	out << "software rasterizer: " << jobs.GetThreadCount() << " threads, " << frameCount << " frames of " << WIDTH << "x" << HEIGHT << ", "
+		<< layer.size() / 3 << " triangles a frame" << std::endl;
+	out << std::fixed << std::setprecision(3);
+	out << frameTime / (float)frameCount << " ms a frame, " << (float)WIDTH * (float)HEIGHT * 4.0f * (float)frameCount / (frameTime * 1000.0f)
+		<< " million pixels shaded a second" << std::endl;
+
+	screen.Shutdown();
+	rasterizer.Shutdown();
+	jobs.Shutdown();
+
+	return result;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: benchmarkclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _BENCHMARKCLASS_H_
+#define _BENCHMARKCLASS_H_
+
+//The BenchmarkClass holds the synthetic workloads we use to measure the engine's CPU side. They all run on the NullRenderDeviceClass
+//so they need no window or video card, and each one writes a small plain text table of its results to the given stream.
+
+//////////////
+// INCLUDES //
+//////////////
+#include <ostream>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: BenchmarkClass
+////////////////////////////////////////////////////////////////////////////////
+class BenchmarkClass
+{
+public:
+	BenchmarkClass();
+	BenchmarkClass(const BenchmarkClass&);
+	~BenchmarkClass();
+
+	//records drawCount light shader draws with 1, 2, 4.. up to maxThreads threads (0 = one per core) and reports how recording scales
+	bool ParallelRecording(std::ostream&, int, int, int);
+
+	//hammers the simulation to render snapshot exchange for frameCount frames at the given pipeline depth and checks every snapshot
+	bool SnapshotExchange(std::ostream&, int, int);
+
+	//updates a nodeCount node scene graph with dirtyPercent of its nodes moving every frame, against recomputing every node
+	bool SceneGraph(std::ostream&, int, float, int, int);
+
+	//runs frustum, sphere, box and ray queries against a spatial index of objectCount objects and against brute force
+	bool SpatialQueries(std::ostream&, int, float, int);
+
+	//assigns lightCount point and spot lights to the clusters of a 16x9x24 grid with 1, 2, 4.. up to maxThreads threads
+	bool ClusteredLighting(std::ostream&, int, int, int);
+
+	//times jobCount empty jobs, an empty ParallelFor and a real one with 1, 2, 4.. up to maxThreads job system threads
+	bool JobSystem(std::ostream&, int, int);
+
+	//runs frameCount frames of a task graph shaped like GraphicsClass::Frame with 1 up to maxFramesInFlight frames in flight
+	bool TaskGraph(std::ostream&, int, int);
+
+	//makes allocationsPerFrame small allocations a frame across the job system from a double buffered frame arena and from the heap
+	bool FrameArena(std::ostream&, int, int);
+
+	//looks up random handles of a resourceCount resource pool lookupCount times against copying shared_ptrs, then checks deferred release
+	bool ResourcePool(std::ostream&, int, int);
+
+	//churns a geometry pool of up to meshCount meshes with operationCount adds and removes, defragments it and counts IA binds
+	bool GeometryPool(std::ostream&, int, int);
+
+	//streams linesPerFrame lines and a few triangle fans a frame through the immediate geometry with rings of 1, 2, 4 and 8 frames
+	bool DynamicGeometry(std::ostream&, int, int);
+
+	//asks a state cache requestCount times for random states out of a small set, then saves a manifest and pre-warms a new cache from it
+	bool StateCache(std::ostream&, int);
+
+	//paces frameCount frames of random CPU work at frameRate frames a second with every wait mode and reports jitter and CPU use
+	bool FramePacing(std::ostream&, int, float);
+
+	//records scopeCount profiler scopes on 1, 2, 4.. up to maxThreads threads at once while the trace is written, and times a scope
+	bool Profiler(std::ostream&, int, int);
+
+	//runs frameCount frames of frameMs busy work with a few much longer ones and checks the hitch detector dumps them with their activity
+	bool HitchDetection(std::ostream&, int, float);
+
+	//records frameCount frames of drawCount draws straight on the null device and through the render stats, checks the stats against the
+	//device's own counters and reports what counting costs a call
+	bool RenderStats(std::ostream&, int, int);
+
+	//builds and renders the performance overlay for frameCount frames on the null device, checks its layout and draws, and times it
+	bool PerfHud(std::ostream&, int);
+
+	//checks the memory tracker's CPU and GPU numbers, budgets, snapshot diffs and leak report, and times allocationCount tracked allocations
+	bool MemoryTracking(std::ostream&, int);
+
+	//runs frameCount frames of a simulation and render thread pair taking frameMs a frame at pipeline depths 1 to 3, with and without
+	//vsync, and reports the input to present latency percentiles of each
+	bool InputLatency(std::ostream&, int, float);
+
+	//runs producer and consumer pairs of event queues all at once and sends eventCount / 2 short key presses to an InputClass whose frames
+	//run on another thread, and checks no event is lost, repeated or reordered
+	bool InputQueue(std::ostream&, int);
+
+	//runs a startup task graph shaped like GraphicsClass::InitializeScene with 1, 2, 4.. up to maxThreads threads, checks the order the
+	//tasks ran in and that the device tasks stayed on the calling thread one at a time, and reports the time to the first frame
+	bool ParallelStartup(std::ostream&, int);
+
+	//renders a few overlapping quads with the software rasterizer and checks their coverage, depths and colours pixel for pixel, then
+	//times frameCount frames of a full screen of quads four layers deep
+	bool SoftwareRasterizer(std::ostream&, int);
+};
+
+#endif
@@ -0,0 +1,584 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: clusteredlightingclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "clusteredlightingclass.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define CLUSTEREDLIGHTING_SSE
+#include <xmmintrin.h>
+#endif
+
+/*
+LightTouchesCluster is the scalar form of the test, the SSE loop in BuildSlice does exactly the same operations in the same order so
+both give the same answer. A light reaches a cluster if its sphere overlaps the cluster's box, and for a spot light the cone also has
+to reach the cluster's bounding sphere: it must not be entirely outside the cone's angle, beyond its range or behind it.
+*/
+
+static bool LightTouchesCluster(const float* box, const float* sphere, float x, float y, float z, float radiusSquared, float range,
+	float directionX, float directionY, float directionZ, float cosine, float sine, bool spot)
+{
+	float dx, dy, dz, vx, vy, vz, lengthSquared, along, closest;
+
+	dx = std::max(std::max(box[0] - x, x - box[3]), 0.0f);
+	dy = std::max(std::max(box[1] - y, y - box[4]), 0.0f);
+	dz = std::max(std::max(box[2] - z, z - box[5]), 0.0f);
+	if (!(dx * dx + dy * dy + dz * dz <= radiusSquared))
+	{
+		return false;
+	}
+
+	if (!spot)
+	{
+		return true;
+	}
+
+	vx = sphere[0] - x;
+	vy = sphere[1] - y;
+	vz = sphere[2] - z;
+	lengthSquared = vx * vx + vy * vy + vz * vz;
+	along = vx * directionX + vy * directionY + vz * directionZ;
+	closest = cosine * sqrtf(std::max(lengthSquared - along * along, 0.0f)) - along * sine;
+
+	return !(closest > sphere[3] || along > sphere[3] + range || along < 0.0f - sphere[3]);
+}
+
+ClusteredLightingClass::ClusteredLightingClass()
+	: m_device(nullptr)
+	, m_lightBuffer(RENDER_NULL_HANDLE)
+	, m_clusterBuffer(RENDER_NULL_HANDLE)
+	, m_indexBuffer(RENDER_NULL_HANDLE)
+	, m_gridX(0)
+	, m_gridY(0)
+	, m_gridZ(0)
+	, m_maxLights(0)
+	, m_maxIndices(0)
+	, m_droppedCount(0)
+	, m_buildTime(0.0f)
+	, m_jobs(nullptr)
+{
+}
+
+ClusteredLightingClass::ClusteredLightingClass(const ClusteredLightingClass& other)
+{
+}
+
+
+ClusteredLightingClass::~ClusteredLightingClass()
+{
+}
+
+//Initialize sets up a gridX * gridY * gridZ cluster grid for up to maxLights lights and maxIndices light indices in total. The slices
+//are built on jobs, nullptr builds them on the calling thread.
+
+bool ClusteredLightingClass::Initialize(RenderDeviceClass* device, JobSystemClass* jobs, int gridX, int gridY, int gridZ, int maxLights,
+	int maxIndices)
+{
+	RenderBufferDesc bufferDesc;
+	int clusterCount;
+
+	if (gridX <= 0 || gridY <= 0 || gridZ <= 0 || maxLights <= 0 || maxIndices <= 0)
+	{
+		return false;
+	}
+
+	m_gridX = gridX;
+	m_gridY = gridY;
+	m_gridZ = gridZ;
+	m_maxLights = maxLights;
+	m_maxIndices = maxIndices;
+	clusterCount = gridX * gridY * gridZ;
+
+	m_minimumX.resize(clusterCount);
+	m_minimumY.resize(clusterCount);
+	m_minimumZ.resize(clusterCount);
+	m_maximumX.resize(clusterCount);
+	m_maximumY.resize(clusterCount);
+	m_maximumZ.resize(clusterCount);
+	m_centerX.resize(clusterCount);
+	m_centerY.resize(clusterCount);
+	m_centerZ.resize(clusterCount);
+	m_radius.resize(clusterCount);
+	m_clusters.assign(clusterCount * 2, 0);
+	m_sliceIndices.resize(gridZ);
+	m_sliceStart.assign(gridZ + 1, 0);
+	m_indices.reserve(maxIndices);
+
+	// The three structured buffers ClusteredLightPixelShader reads, rewritten every frame.
+	m_device = device;
+	if (m_device)
+	{
+		memset(&bufferDesc, 0, sizeof(bufferDesc));
+		bufferDesc.usage = RENDER_USAGE_DYNAMIC;
+		bufferDesc.bindType = RENDER_BIND_SHADER_RESOURCE;
+
+		bufferDesc.byteWidth = maxLights * sizeof(LightType);
+		bufferDesc.structureByteStride = sizeof(LightType);
+		m_lightBuffer = m_device->CreateBuffer(bufferDesc, nullptr);
+
+		bufferDesc.byteWidth = clusterCount * 2 * sizeof(unsigned int);
+		bufferDesc.structureByteStride = 2 * sizeof(unsigned int);
+		m_clusterBuffer = m_device->CreateBuffer(bufferDesc, nullptr);
+
+		bufferDesc.byteWidth = maxIndices * sizeof(unsigned int);
+		bufferDesc.structureByteStride = sizeof(unsigned int);
+		m_indexBuffer = m_device->CreateBuffer(bufferDesc, nullptr);
+
+		if (m_lightBuffer == RENDER_NULL_HANDLE || m_clusterBuffer == RENDER_NULL_HANDLE || m_indexBuffer == RENDER_NULL_HANDLE)
+		{
+			return false;
+		}
+	}
+
+	m_jobs = jobs;
+	m_scratch.resize(gridZ);
+
+	return true;
+}
+
+void ClusteredLightingClass::Shutdown()
+{
+	m_jobs = nullptr;
+	m_scratch.clear();
+
+	if (m_device)
+	{
+		m_device->ReleaseResource(m_lightBuffer);
+		m_device->ReleaseResource(m_clusterBuffer);
+		m_device->ReleaseResource(m_indexBuffer);
+	}
+	m_lightBuffer = RENDER_NULL_HANDLE;
+	m_clusterBuffer = RENDER_NULL_HANDLE;
+	m_indexBuffer = RENDER_NULL_HANDLE;
+	m_device = nullptr;
+
+	return;
+}
+
+/*
+SetProjection works out the view space box of every cluster. The depth slices are spaced exponentially between the near and far plane,
+slice k starting at near * (far / near)^(k / gridZ), which is what lets the shader find its slice with one log. A tile's box is the
+smallest box holding the four corners of the tile at both the slice's near and far depth.
+*/
+
+void ClusteredLightingClass::SetProjection(FXMMATRIX projection, float screenNear, float screenDepth, int screenWidth, int screenHeight)
+{
+	XMFLOAT4X4 matrix;
+	float logRatio, nearDepth, farDepth, tileLeft, tileRight, tileBottom, tileTop;
+	float x[4], y[4];
+	int cluster;
+
+	XMStoreFloat4x4(&matrix, projection);
+
+	logRatio = logf(screenDepth / screenNear);
+	m_parameters.scale = XMFLOAT4((float)m_gridX / (float)screenWidth, (float)m_gridY / (float)screenHeight, (float)m_gridZ / logRatio,
+		(float)m_gridZ * logf(screenNear) / logRatio);
+	m_parameters.gridSize[0] = m_gridX;
+	m_parameters.gridSize[1] = m_gridY;
+	m_parameters.gridSize[2] = m_gridZ;
+	m_parameters.gridSize[3] = 0;
+
+	for (auto slice = 0; slice < m_gridZ; slice++)
+	{
+		nearDepth = screenNear * powf(screenDepth / screenNear, (float)slice / (float)m_gridZ);
+		farDepth = screenNear * powf(screenDepth / screenNear, (float)(slice + 1) / (float)m_gridZ);
+
+		for (auto tileY = 0; tileY < m_gridY; tileY++)
+		{
+			// Tile rows go down the screen like pixel rows, so row 0 is the top of the view.
+			tileTop = 1.0f - 2.0f * (float)tileY / (float)m_gridY;
+			tileBottom = 1.0f - 2.0f * (float)(tileY + 1) / (float)m_gridY;
+
+			for (auto tileX = 0; tileX < m_gridX; tileX++)
+			{
+				tileLeft = -1.0f + 2.0f * (float)tileX / (float)m_gridX;
+				tileRight = -1.0f + 2.0f * (float)(tileX + 1) / (float)m_gridX;
+
+				x[0] = tileLeft * nearDepth / matrix._11;
+				x[1] = tileLeft * farDepth / matrix._11;
+				x[2] = tileRight * nearDepth / matrix._11;
+				x[3] = tileRight * farDepth / matrix._11;
+				y[0] = tileBottom * nearDepth / matrix._22;
+				y[1] = tileBottom * farDepth / matrix._22;
+				y[2] = tileTop * nearDepth / matrix._22;
+				y[3] = tileTop * farDepth / matrix._22;
+
+				cluster = (slice * m_gridY + tileY) * m_gridX + tileX;
+				m_minimumX[cluster] = *std::min_element(x, x + 4);
+				m_maximumX[cluster] = *std::max_element(x, x + 4);
+				m_minimumY[cluster] = *std::min_element(y, y + 4);
+				m_maximumY[cluster] = *std::max_element(y, y + 4);
+				m_minimumZ[cluster] = nearDepth;
+				m_maximumZ[cluster] = farDepth;
+
+				m_centerX[cluster] = (m_minimumX[cluster] + m_maximumX[cluster]) * 0.5f;
+				m_centerY[cluster] = (m_minimumY[cluster] + m_maximumY[cluster]) * 0.5f;
+				m_centerZ[cluster] = (nearDepth + farDepth) * 0.5f;
+				m_radius[cluster] = sqrtf((m_maximumX[cluster] - m_centerX[cluster]) * (m_maximumX[cluster] - m_centerX[cluster])
+					+ (m_maximumY[cluster] - m_centerY[cluster]) * (m_maximumY[cluster] - m_centerY[cluster])
+					+ (farDepth - m_centerZ[cluster]) * (farDepth - m_centerZ[cluster]));
+			}
+		}
+	}
+
+	return;
+}
+
+/*
+Build assigns the lights to the clusters for the given view matrix. The lights are moved into view space and sorted into the depth
+slices their sphere reaches, one slice of slack on either side so rounding in the log can never lose a light the box test would
+accept. Then the slices are built as jobs and merged into the compact list in slice order, so the result does not depend on the number
+of threads.
+*/
+
+void ClusteredLightingClass::Build(FXMMATRIX viewMatrix, const std::vector<LightType>& lights)
+{
+	std::vector<int> firstSlice, lastSlice;
+	int lightCount, first, last, clustersPerSlice, base, copied, offset, count, kept;
+	float depth;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	lightCount = std::min((int)lights.size(), m_maxLights);
+	m_lights.assign(lights.begin(), lights.begin() + lightCount);
+	m_viewLights.resize(lightCount);
+	firstSlice.resize(lightCount);
+	lastSlice.resize(lightCount);
+
+	auto sliceOf = [this](float z)
+	{
+		return z > 0.0f ? (int)floorf(logf(z) * m_parameters.scale.z - m_parameters.scale.w) : 0;
+	};
+
+	std::fill(m_sliceStart.begin(), m_sliceStart.end(), 0);
+	for (auto i = 0; i < lightCount; i++)
+	{
+		LightType& light = m_viewLights[i];
+
+		light = m_lights[i];
+		XMStoreFloat3(&light.position, XMVector3TransformCoord(XMLoadFloat3(&m_lights[i].position), viewMatrix));
+		XMStoreFloat3(&light.direction, XMVector3TransformNormal(XMLoadFloat3(&m_lights[i].direction), viewMatrix));
+
+		depth = light.position.z;
+		first = std::max(sliceOf(depth - light.range) - 1, 0);
+		last = std::min(sliceOf(depth + light.range) + 1, m_gridZ - 1);
+		if (depth + light.range < m_minimumZ.front() || depth - light.range > m_maximumZ.back())
+		{
+			first = 1;
+			last = 0;
+		}
+
+		firstSlice[i] = first;
+		lastSlice[i] = last;
+		for (auto slice = first; slice <= last; slice++)
+		{
+			m_sliceStart[slice + 1]++;
+		}
+	}
+
+	for (auto slice = 0; slice < m_gridZ; slice++)
+	{
+		m_sliceStart[slice + 1] += m_sliceStart[slice];
+	}
+	m_sliceLights.resize(m_sliceStart[m_gridZ]);
+	{
+		std::vector<int> fill(m_sliceStart.begin(), m_sliceStart.end() - 1);
+		for (auto i = 0; i < lightCount; i++)
+		{
+			for (auto slice = firstSlice[i]; slice <= lastSlice[i]; slice++)
+			{
+				m_sliceLights[fill[slice]++] = i;
+			}
+		}
+	}
+
+	// Assign the slices, one job each if there is a job system.
+	auto buildSlices = [this](int begin, int end)
+	{
+		for (auto slice = begin; slice < end; slice++)
+		{
+			BuildSlice(slice, m_scratch[slice]);
+		}
+	};
+
+	if (m_jobs)
+	{
+		m_jobs->ParallelFor(m_gridZ, 1, buildSlices);
+	}
+	else
+	{
+		buildSlices(0, m_gridZ);
+	}
+
+	// Merge the slices into one list. Whatever does not fit into maxIndices is dropped and counted.
+	m_indices.clear();
+	m_droppedCount = 0;
+	clustersPerSlice = m_gridX * m_gridY;
+	for (auto slice = 0; slice < m_gridZ; slice++)
+	{
+		base = (int)m_indices.size();
+		copied = std::min((int)m_sliceIndices[slice].size(), m_maxIndices - base);
+		m_indices.insert(m_indices.end(), m_sliceIndices[slice].begin(), m_sliceIndices[slice].begin() + copied);
+
+		for (auto cluster = slice * clustersPerSlice; cluster < (slice + 1) * clustersPerSlice; cluster++)
+		{
+			offset = std::min((int)m_clusters[cluster * 2], copied);
+			count = (int)m_clusters[cluster * 2 + 1];
+			kept = std::min(count, copied - offset);
+
+			m_clusters[cluster * 2] = (unsigned int)(base + offset);
+			m_clusters[cluster * 2 + 1] = (unsigned int)kept;
+			m_droppedCount += count - kept;
+		}
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	m_buildTime = std::chrono::duration<float, std::milli>(end - start).count();
+
+	return;
+}
+
+//Upload copies the result of the last Build into the buffers ClusteredLightPixelShader reads.
+
+bool ClusteredLightingClass::Upload(RenderContextClass* context)
+{
+	bool result;
+
+	if (!m_device)
+	{
+		return false;
+	}
+
+	result = context->UpdateBuffer(m_clusterBuffer, m_clusters.data(), (unsigned int)(m_clusters.size() * sizeof(unsigned int)));
+	if (!result)
+	{
+		return false;
+	}
+
+	// With no lights every cluster is empty and the shader never looks at the other two.
+	if (!m_lights.empty())
+	{
+		result = context->UpdateBuffer(m_lightBuffer, m_lights.data(), (unsigned int)(m_lights.size() * sizeof(LightType)));
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	if (!m_indices.empty())
+	{
+		result = context->UpdateBuffer(m_indexBuffer, m_indices.data(), (unsigned int)(m_indices.size() * sizeof(unsigned int)));
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+RenderHandle ClusteredLightingClass::GetLightBuffer()
+{
+	return m_lightBuffer;
+}
+
+RenderHandle ClusteredLightingClass::GetClusterBuffer()
+{
+	return m_clusterBuffer;
+}
+
+RenderHandle ClusteredLightingClass::GetIndexBuffer()
+{
+	return m_indexBuffer;
+}
+
+void ClusteredLightingClass::GetClusterParameters(ClusterParametersType& parameters)
+{
+	parameters = m_parameters;
+	return;
+}
+
+int ClusteredLightingClass::GetClusterCount()
+{
+	return m_gridX * m_gridY * m_gridZ;
+}
+
+int ClusteredLightingClass::GetLightCount()
+{
+	return (int)m_lights.size();
+}
+
+int ClusteredLightingClass::GetIndexCount()
+{
+	return (int)m_indices.size();
+}
+
+//GetDroppedCount returns how many light indices the last Build had to leave out because maxIndices was too small.
+
+int ClusteredLightingClass::GetDroppedCount()
+{
+	return m_droppedCount;
+}
+
+void ClusteredLightingClass::GetClusterLights(int cluster, unsigned int& offset, unsigned int& count)
+{
+	offset = m_clusters[cluster * 2];
+	count = m_clusters[cluster * 2 + 1];
+	return;
+}
+
+const unsigned int* ClusteredLightingClass::GetIndices()
+{
+	return m_indices.data();
+}
+
+float ClusteredLightingClass::GetBuildTime()
+{
+	return m_buildTime;
+}
+
+bool ClusteredLightingClass::TestLight(int cluster, const LightType& light)
+{
+	float box[6] = { m_minimumX[cluster], m_minimumY[cluster], m_minimumZ[cluster], m_maximumX[cluster], m_maximumY[cluster], m_maximumZ[cluster] };
+	float sphere[4] = { m_centerX[cluster], m_centerY[cluster], m_centerZ[cluster], m_radius[cluster] };
+	bool spot = light.spotCosine > -1.0f;
+
+	return LightTouchesCluster(box, sphere, light.position.x, light.position.y, light.position.z, light.range * light.range, light.range,
+		light.direction.x, light.direction.y, light.direction.z, spot ? light.spotCosine : 0.0f,
+		spot ? sqrtf(std::max(1.0f - light.spotCosine * light.spotCosine, 0.0f)) : 0.0f, spot);
+}
+
+/*
+BuildSlice gathers the slice's lights into structure of arrays form and tests them against each cluster of the slice, four lights per
+SSE instruction. Every cluster's lights go into the slice's list in one run, m_clusters gets the run's offset within the slice.
+*/
+
+void ClusteredLightingClass::BuildSlice(int slice, SliceLightsType& lights)
+{
+	std::vector<unsigned int>& indices = m_sliceIndices[slice];
+	int count, padded, cluster;
+
+	count = m_sliceStart[slice + 1] - m_sliceStart[slice];
+	padded = (count + 3) & ~3;
+
+	lights.x.resize(padded);
+	lights.y.resize(padded);
+	lights.z.resize(padded);
+	lights.radiusSquared.resize(padded);
+	lights.range.resize(padded);
+	lights.directionX.resize(padded);
+	lights.directionY.resize(padded);
+	lights.directionZ.resize(padded);
+	lights.cosine.resize(padded);
+	lights.sine.resize(padded);
+	lights.spot.resize(padded);
+	lights.index.resize(padded);
+
+	for (auto i = 0; i < padded; i++)
+	{
+		if (i >= count)
+		{
+			// Padding, a negative radius squared fails the sphere test.
+			lights.x[i] = lights.y[i] = lights.z[i] = 0.0f;
+			lights.radiusSquared[i] = -1.0f;
+			lights.range[i] = 0.0f;
+			lights.directionX[i] = lights.directionY[i] = lights.directionZ[i] = 0.0f;
+			lights.cosine[i] = lights.sine[i] = lights.spot[i] = 0.0f;
+			lights.index[i] = -1;
+			continue;
+		}
+
+		const LightType& light = m_viewLights[m_sliceLights[m_sliceStart[slice] + i]];
+		bool spot = light.spotCosine > -1.0f;
+		unsigned int spotMask = spot ? 0xffffffff : 0;
+
+		lights.x[i] = light.position.x;
+		lights.y[i] = light.position.y;
+		lights.z[i] = light.position.z;
+		lights.radiusSquared[i] = light.range * light.range;
+		lights.range[i] = light.range;
+		lights.directionX[i] = light.direction.x;
+		lights.directionY[i] = light.direction.y;
+		lights.directionZ[i] = light.direction.z;
+		lights.cosine[i] = spot ? light.spotCosine : 0.0f;
+		lights.sine[i] = spot ? sqrtf(std::max(1.0f - light.spotCosine * light.spotCosine, 0.0f)) : 0.0f;
+		memcpy(&lights.spot[i], &spotMask, sizeof(float));
+		lights.index[i] = m_sliceLights[m_sliceStart[slice] + i];
+	}
+
+	indices.clear();
+	for (auto tile = 0; tile < m_gridX * m_gridY; tile++)
+	{
+		cluster = slice * m_gridX * m_gridY + tile;
+		m_clusters[cluster * 2] = (unsigned int)indices.size();
+
+#ifdef CLUSTEREDLIGHTING_SSE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 minimumX = _mm_set1_ps(m_minimumX[cluster]), maximumX = _mm_set1_ps(m_maximumX[cluster]);
+		const __m128 minimumY = _mm_set1_ps(m_minimumY[cluster]), maximumY = _mm_set1_ps(m_maximumY[cluster]);
+		const __m128 minimumZ = _mm_set1_ps(m_minimumZ[cluster]), maximumZ = _mm_set1_ps(m_maximumZ[cluster]);
+		const __m128 centerX = _mm_set1_ps(m_centerX[cluster]), centerY = _mm_set1_ps(m_centerY[cluster]), centerZ = _mm_set1_ps(m_centerZ[cluster]);
+		const __m128 radius = _mm_set1_ps(m_radius[cluster]);
+		const __m128 negativeRadius = _mm_sub_ps(zero, radius);
+
+		for (auto i = 0; i < padded; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(&lights.x[i]);
+			__m128 y = _mm_loadu_ps(&lights.y[i]);
+			__m128 z = _mm_loadu_ps(&lights.z[i]);
+
+			// Sphere against box: the squared distance from the light to the nearest point of the box.
+			__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minimumX, x), _mm_sub_ps(x, maximumX)), zero);
+			__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minimumY, y), _mm_sub_ps(y, maximumY)), zero);
+			__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minimumZ, z), _mm_sub_ps(z, maximumZ)), zero);
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			__m128 pass = _mm_cmple_ps(distance, _mm_loadu_ps(&lights.radiusSquared[i]));
+			if (_mm_movemask_ps(pass) == 0)
+			{
+				continue;
+			}
+
+			// Cone against the cluster's bounding sphere, only counts for the spot lights.
+			__m128 vx = _mm_sub_ps(centerX, x);
+			__m128 vy = _mm_sub_ps(centerY, y);
+			__m128 vz = _mm_sub_ps(centerZ, z);
+			__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+			__m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(&lights.directionX[i])), _mm_mul_ps(vy, _mm_loadu_ps(&lights.directionY[i]))),
+				_mm_mul_ps(vz, _mm_loadu_ps(&lights.directionZ[i])));
+			__m128 closest = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&lights.cosine[i]), _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lengthSquared, _mm_mul_ps(along, along)), zero))),
+				_mm_mul_ps(along, _mm_loadu_ps(&lights.sine[i])));
+			__m128 cull = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(closest, radius), _mm_cmpgt_ps(along, _mm_add_ps(radius, _mm_loadu_ps(&lights.range[i])))),
+				_mm_cmplt_ps(along, negativeRadius));
+			pass = _mm_andnot_ps(_mm_and_ps(cull, _mm_loadu_ps(&lights.spot[i])), pass);
+
+			int mask = _mm_movemask_ps(pass);
+			for (auto lane = 0; lane < 4; lane++)
+			{
+				if (mask & (1 << lane))
+				{
+					indices.push_back((unsigned int)lights.index[i + lane]);
+				}
+			}
+		}
+#else
+		float box[6] = { m_minimumX[cluster], m_minimumY[cluster], m_minimumZ[cluster], m_maximumX[cluster], m_maximumY[cluster], m_maximumZ[cluster] };
+		float sphere[4] = { m_centerX[cluster], m_centerY[cluster], m_centerZ[cluster], m_radius[cluster] };
+
+		for (auto i = 0; i < count; i++)
+		{
+			if (LightTouchesCluster(box, sphere, lights.x[i], lights.y[i], lights.z[i], lights.radiusSquared[i], lights.range[i],
+				lights.directionX[i], lights.directionY[i], lights.directionZ[i], lights.cosine[i], lights.sine[i], lights.spot[i] != 0.0f))
+			{
+				indices.push_back((unsigned int)lights.index[i]);
+			}
+		}
+#endif
+
+		m_clusters[cluster * 2 + 1] = (unsigned int)indices.size() - m_clusters[cluster * 2];
+	}
+
+	return;
+}
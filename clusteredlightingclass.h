@@ -0,0 +1,138 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: clusteredlightingclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _CLUSTEREDLIGHTINGCLASS_H_
+#define _CLUSTEREDLIGHTINGCLASS_H_
+
+/*
+The ClusteredLightingClass works out which point and spot lights can reach which part of the screen so the pixel shader only has to
+loop over the few lights that matter instead of all of them. The camera's view frustum is cut into a grid of clusters ("froxels"):
+screen tiles in x and y and slices in depth, the slices getting thicker with distance so every cluster is roughly as deep as it is
+wide. Every cluster gets a view space box once per projection.
+
+Build then tests every light against every cluster box it could touch. The lights are sorted into the depth slices their sphere
+reaches first, then each slice becomes a job on the JobSystemClass, which tests four lights at a time against each of the slice's clusters
+with SSE: sphere against box for every light, and for spot lights also the cone against the cluster's bounding sphere. The lights
+that pass are written into one compact index list, each cluster gets the offset and count of its run in it.
+
+Upload copies the lights, the cluster offsets and the index list into three structured buffers for ClusteredLightPixelShader, which
+finds its cluster from the pixel position and depth and only shades the lights listed there.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <DirectXMath.h>
+#include "renderdeviceclass.h"
+#include "jobsystemclass.h"
+#include <vector>
+
+using namespace DirectX;
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ClusteredLightingClass
+////////////////////////////////////////////////////////////////////////////////
+class ClusteredLightingClass
+{
+public:
+	//one light in world space, laid out like ClusteredLightType in LightPS.hlsl. spotCosine is the cosine of the cone's half angle,
+	//-1 or below makes it a point light and direction is ignored.
+	struct LightType
+	{
+		XMFLOAT3 position;
+		float range;
+		XMFLOAT3 color;
+		float spotCosine;
+		XMFLOAT3 direction;
+		float padding;
+	};
+
+	//the ClusterBuffer constants ClusteredLightPixelShader needs to find its cluster: pixels to tiles in scale.xy, the log depth to
+	//slice mapping in scale.zw and the grid size
+	struct ClusterParametersType
+	{
+		XMFLOAT4 scale;
+		unsigned int gridSize[4];
+	};
+
+private:
+	//the lights of one slice as structure of arrays, padded to a multiple of 4 with lights that never pass
+	struct SliceLightsType
+	{
+		std::vector<float> x, y, z, radiusSquared, range;
+		std::vector<float> directionX, directionY, directionZ, cosine, sine, spot;
+		std::vector<int> index;
+	};
+
+public:
+	ClusteredLightingClass();
+	ClusteredLightingClass(const ClusteredLightingClass&);
+	~ClusteredLightingClass();
+
+	//device may be nullptr to only build on the CPU, jobs to build on the calling thread. The grid is gridX by gridY tiles and gridZ
+	//slices.
+	bool Initialize(RenderDeviceClass*, JobSystemClass*, int, int, int, int, int);
+	void Shutdown();
+
+	//the projection, its near and far planes and the screen size the clusters are laid over
+	void SetProjection(FXMMATRIX, float, float, int, int);
+
+	void Build(FXMMATRIX, const std::vector<LightType>&);
+	bool Upload(RenderContextClass*);
+
+	RenderHandle GetLightBuffer();
+	RenderHandle GetClusterBuffer();
+	RenderHandle GetIndexBuffer();
+	void GetClusterParameters(ClusterParametersType&);
+
+	int GetClusterCount();
+	int GetLightCount();
+	int GetIndexCount();
+	int GetDroppedCount();
+	void GetClusterLights(int, unsigned int&, unsigned int&);
+	const unsigned int* GetIndices();
+	float GetBuildTime();
+
+	//the test Build uses for one light against one cluster, lights in view space. Public so a brute force check can use it too.
+	bool TestLight(int, const LightType&);
+
+private:
+	void BuildSlice(int, SliceLightsType&);
+
+private:
+	RenderDeviceClass* m_device;
+	RenderHandle m_lightBuffer;
+	RenderHandle m_clusterBuffer;
+	RenderHandle m_indexBuffer;
+
+	int m_gridX, m_gridY, m_gridZ;
+	int m_maxLights;
+	int m_maxIndices;
+	ClusterParametersType m_parameters;
+
+	//the cluster boxes in view space as structure of arrays, plus their bounding spheres for the cone test
+	std::vector<float> m_minimumX, m_minimumY, m_minimumZ;
+	std::vector<float> m_maximumX, m_maximumY, m_maximumZ;
+	std::vector<float> m_centerX, m_centerY, m_centerZ, m_radius;
+
+	//the last Build: the lights in world space, which slices each one reaches and the view space copies the tests use
+	std::vector<LightType> m_lights;
+	std::vector<LightType> m_viewLights;
+	std::vector<int> m_sliceStart;
+	std::vector<int> m_sliceLights;
+
+	//per slice output, merged into m_clusters and m_indices once every slice is done
+	std::vector<std::vector<unsigned int>> m_sliceIndices;
+	std::vector<unsigned int> m_clusters;
+	std::vector<unsigned int> m_indices;
+	int m_droppedCount;
+	float m_buildTime;
+
+	//the slices are built as jobs, every slice has its own scratch space so the jobs share nothing
+	JobSystemClass* m_jobs;
+	std::vector<SliceLightsType> m_scratch;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "colorshaderclass.h"
+#include "profilerclass.h"
 
 ColorShaderClass::ColorShaderClass()
 	: m_vertexShader(nullptr)
@@ -73,25 +74,32 @@ bool ColorShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 {
 	HRESULT result;
 
-	std::shared_ptr<ID3D10Blob> errorMessage(nullptr);
-	std::shared_ptr<ID3D10Blob> vertexShaderBuffer(nullptr);
-	std::shared_ptr<ID3D10Blob> pixelShaderBuffer(nullptr);
+	ID3D10Blob* errorMessage;
+	ID3D10Blob* vertexShaderBuffer;
+	ID3D10Blob* pixelShaderBuffer;
 	D3D11_INPUT_ELEMENT_DESC polygonLayout[2];
 	UINT numElements;
 	D3D11_BUFFER_DESC matrixBufferDesc;
 
+	PROFILE_SCOPE("ColorShaderClass::InitializeShader");
+
+	// Initialize the pointers this function will use to null.
+	errorMessage = nullptr;
+	vertexShaderBuffer = nullptr;
+	pixelShaderBuffer = nullptr;
+
 	//here is where we compile the shader programs into buffers. We pass it the name of the file, the name of the shader, the shader version (5.0 in 11) and the buffer
 	//to compile the shader into. If it fails, we'll get an error in the error message string. 
 
 	//COMPILE THE VERTEX SHADER
-	result = D3DCompileFromFile(vsFilename, NULL, NULL, "ColorVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, (ID3D10Blob**)&vertexShaderBuffer, (ID3D10Blob**)&errorMessage);
+	result = D3DCompileFromFile(vsFilename, NULL, NULL, "ColorVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
 
 	if (FAILED(result))
 	{
 		// If the shader failed to compile it should have written something to the error message.
 		if (errorMessage)
 		{
-			OutputShaderErrorMessage(errorMessage.get(), hwnd, vsFilename);
+			OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
 		}
 		// If there was nothing in the error message then it simply could not find the shader file itself.
 		else
@@ -103,14 +111,14 @@ bool ColorShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 	}
 
 	//COMPILE THE PIXEL SHADER
-	result = D3DCompileFromFile(psFilename, NULL, NULL, "ColorPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, (ID3D10Blob**)&pixelShaderBuffer, (ID3D10Blob**)&errorMessage);
+	result = D3DCompileFromFile(psFilename, NULL, NULL, "ColorPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &pixelShaderBuffer, &errorMessage);
 
 	if (FAILED(result))
 	{
 		// If the shader failed to compile it should have written something to the error message.
 		if (errorMessage)
 		{
-			OutputShaderErrorMessage(errorMessage.get(), hwnd, psFilename);
+			OutputShaderErrorMessage(errorMessage, hwnd, psFilename);
 		}
 		// If there was nothing in the error message then it simply could not find the shader file itself.
 		else
@@ -125,14 +133,14 @@ bool ColorShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 	//We will use these pointers to interface with the vertex and pixel shader from this point forward.
 
 	//create the vertex shader from the buffer
-	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, (ID3D11VertexShader**)&m_vertexShader);
+	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &m_vertexShader);
 	if (FAILED(result))
 	{
 		return false;
 	}
 
 	// Create the pixel shader from the buffer.
-	result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, (ID3D11PixelShader**)&m_pixelShader);
+	result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &m_pixelShader);
 	if (FAILED(result))
 	{
 		return false;
@@ -167,7 +175,7 @@ bool ColorShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 	numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
 
 	//create the vertex input layout
-	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), (ID3D11InputLayout**)&m_layout);
+	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &m_layout);
 
 	if (FAILED(result))
 	{
@@ -191,7 +199,7 @@ bool ColorShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 	matrixBufferDesc.StructureByteStride = 0;
 
 	//create the constant buffer pointer so we can access the vertex shader constant buffer from within this class
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, (ID3D11Buffer**)&m_matrixBuffer);
+	result = device->CreateBuffer(&matrixBufferDesc, NULL, &m_matrixBuffer);
 	if (FAILED(result))
 	{
 		return false;
@@ -237,6 +245,8 @@ bool ColorShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, D
 	MatrixBufferType* dataPtr;
 	UINT bufferNumber;
 
+	PROFILE_SCOPE("ColorShaderClass::SetShaderParameters");
+
 	//Make sure to transpose matrices before sending them into the shader, this is a requirement for DirectX 11.
 	DirectX::XMMATRIX l_intermediateMatrix;
 	this->ConvertMatrixType(worldMatrix, l_intermediateMatrix);
@@ -253,7 +263,7 @@ bool ColorShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, D
 
 	//Lock the m_matrixBuffer, set the new matrices inside it, and then unlock it.
 
-	result = deviceContext->Map(m_matrixBuffer.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	result = deviceContext->Map(m_matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 	if (FAILED(result))
 	{
 		return false;
@@ -269,7 +279,7 @@ bool ColorShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, D
 	dataPtr->projection = projectionMatrix;
 
 	//unlock the cbuffer
-	deviceContext->Unmap(m_matrixBuffer.get(), 0);
+	deviceContext->Unmap(m_matrixBuffer, 0);
 
 	//now set the updated matrix in the HLSL vertex shader
 
@@ -277,7 +287,7 @@ bool ColorShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, D
 	bufferNumber = 0;
 
 	//finally set the cbuffer in the vertex shader with updated values
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, (ID3D11Buffer**)&m_matrixBuffer);
+	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_matrixBuffer);
 
 	return true;
 
@@ -295,11 +305,11 @@ Once the shaders are set we render the triangle by calling the DrawIndexed Direc
 void ColorShaderClass::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(m_layout.get());
+	deviceContext->IASetInputLayout(m_layout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(m_vertexShader.get(), NULL, 0);
-	deviceContext->PSSetShader(m_pixelShader.get(), NULL, 0);
+	deviceContext->VSSetShader(m_vertexShader, NULL, 0);
+	deviceContext->PSSetShader(m_pixelShader, NULL, 0);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
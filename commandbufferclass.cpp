@@ -0,0 +1,324 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: commandbufferclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "commandbufferclass.h"
+#include <cstring>
+
+CommandBufferClass::CommandBufferClass()
+	: m_commandCount(0)
+{
+}
+
+CommandBufferClass::CommandBufferClass(const CommandBufferClass& other)
+{
+}
+
+
+CommandBufferClass::~CommandBufferClass()
+{
+}
+
+//Execute plays every recorded command back on the given context in order. The buffer keeps its commands so it can be executed again,
+//call Reset to start recording a new frame.
+
+void CommandBufferClass::Execute(RenderContextClass* context)
+{
+	const unsigned int* command;
+	const unsigned int* end;
+	const CommandHeaderType* header;
+
+	command = m_commands.data();
+	end = command + m_commands.size();
+
+	while (command < end)
+	{
+		header = (const CommandHeaderType*)command;
+		const unsigned int* args = command + 2;
+
+		switch (header->type)
+		{
+		case COMMAND_UPDATE_BUFFER:
+			context->UpdateBuffer(args[0], args + 2, args[1]);
+			break;
+		case COMMAND_UPDATE_BUFFER_REGION:
+			context->UpdateBufferRegion(args[0], args[1], args + 3, args[2]);
+			break;
+		case COMMAND_WRITE_BUFFER:
+			context->WriteBuffer(args[0], args[1], args + 4, args[2], (RenderMap)args[3]);
+			break;
+		case COMMAND_SET_INPUT_LAYOUT:
+			context->SetInputLayout(args[0]);
+			break;
+		case COMMAND_SET_VERTEX_BUFFER:
+			context->SetVertexBuffer(args[0], args[1], args[2], args[3]);
+			break;
+		case COMMAND_SET_INDEX_BUFFER:
+			context->SetIndexBuffer(args[0], (RenderFormat)args[1], args[2]);
+			break;
+		case COMMAND_SET_PRIMITIVE_TOPOLOGY:
+			context->SetPrimitiveTopology((RenderTopology)args[0]);
+			break;
+		case COMMAND_SET_VERTEX_SHADER:
+			context->SetVertexShader(args[0]);
+			break;
+		case COMMAND_SET_VS_CONSTANT_BUFFER:
+			context->SetVSConstantBuffer(args[0], args[1]);
+			break;
+		case COMMAND_SET_PIXEL_SHADER:
+			context->SetPixelShader(args[0]);
+			break;
+		case COMMAND_SET_PS_CONSTANT_BUFFER:
+			context->SetPSConstantBuffer(args[0], args[1]);
+			break;
+		case COMMAND_SET_PS_TEXTURE:
+			context->SetPSTexture(args[0], args[1]);
+			break;
+		case COMMAND_SET_PS_SAMPLER:
+			context->SetPSSampler(args[0], args[1]);
+			break;
+		case COMMAND_SET_RASTERIZER_STATE:
+			context->SetRasterizerState(args[0]);
+			break;
+		case COMMAND_SET_DEPTH_STENCIL_STATE:
+			context->SetDepthStencilState(args[0], args[1]);
+			break;
+		case COMMAND_SET_BLEND_STATE:
+			context->SetBlendState(args[0]);
+			break;
+		case COMMAND_DRAW:
+			context->Draw(args[0], args[1]);
+			break;
+		case COMMAND_DRAW_INDEXED:
+			context->DrawIndexed(args[0], args[1], (int)args[2]);
+			break;
+		default:
+			break;
+		}
+
+		command += header->size / sizeof(unsigned int);
+	}
+
+	return;
+}
+
+//Reset throws the recorded commands away but keeps the memory, after the first few frames recording no longer allocates.
+
+void CommandBufferClass::Reset()
+{
+	m_commands.clear();
+	m_commandCount = 0;
+
+	return;
+}
+
+unsigned int CommandBufferClass::GetCommandCount()
+{
+	return m_commandCount;
+}
+
+size_t CommandBufferClass::GetSize()
+{
+	return m_commands.size() * sizeof(unsigned int);
+}
+
+//Allocate appends a command with room for argCount arguments plus extraBytes of data and returns a pointer to the first argument.
+
+unsigned int* CommandBufferClass::Allocate(CommandType type, unsigned int argCount, unsigned int extraBytes)
+{
+	CommandHeaderType header;
+	size_t start;
+	unsigned int words;
+
+	words = 2 + argCount + (extraBytes + sizeof(unsigned int) - 1) / sizeof(unsigned int);
+
+	header.type = type;
+	header.size = words * sizeof(unsigned int);
+
+	start = m_commands.size();
+	m_commands.resize(start + words);
+	memcpy(&m_commands[start], &header, sizeof(header));
+
+	m_commandCount++;
+
+	return &m_commands[start + 2];
+}
+
+void CommandBufferClass::Write1(CommandType type, unsigned int a)
+{
+	unsigned int* args = Allocate(type, 1, 0);
+	args[0] = a;
+	return;
+}
+
+void CommandBufferClass::Write2(CommandType type, unsigned int a, unsigned int b)
+{
+	unsigned int* args = Allocate(type, 2, 0);
+	args[0] = a;
+	args[1] = b;
+	return;
+}
+
+void CommandBufferClass::Write3(CommandType type, unsigned int a, unsigned int b, unsigned int c)
+{
+	unsigned int* args = Allocate(type, 3, 0);
+	args[0] = a;
+	args[1] = b;
+	args[2] = c;
+	return;
+}
+
+void CommandBufferClass::Write4(CommandType type, unsigned int a, unsigned int b, unsigned int c, unsigned int d)
+{
+	unsigned int* args = Allocate(type, 4, 0);
+	args[0] = a;
+	args[1] = b;
+	args[2] = c;
+	args[3] = d;
+	return;
+}
+
+//UpdateBuffer copies the data into the stream, the actual update happens when the buffer is executed.
+
+bool CommandBufferClass::UpdateBuffer(RenderHandle buffer, const void* data, unsigned int size)
+{
+	unsigned int* args;
+
+	if (buffer == RENDER_NULL_HANDLE || !data)
+	{
+		return false;
+	}
+
+	args = Allocate(COMMAND_UPDATE_BUFFER, 2, size);
+	args[0] = buffer;
+	args[1] = size;
+	memcpy(args + 2, data, size);
+
+	return true;
+}
+
+bool CommandBufferClass::UpdateBufferRegion(RenderHandle buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	unsigned int* args;
+
+	if (buffer == RENDER_NULL_HANDLE || !data)
+	{
+		return false;
+	}
+
+	args = Allocate(COMMAND_UPDATE_BUFFER_REGION, 3, size);
+	args[0] = buffer;
+	args[1] = offset;
+	args[2] = size;
+	memcpy(args + 3, data, size);
+
+	return true;
+}
+
+bool CommandBufferClass::WriteBuffer(RenderHandle buffer, unsigned int offset, const void* data, unsigned int size, RenderMap map)
+{
+	unsigned int* args;
+
+	if (buffer == RENDER_NULL_HANDLE || !data)
+	{
+		return false;
+	}
+
+	args = Allocate(COMMAND_WRITE_BUFFER, 4, size);
+	args[0] = buffer;
+	args[1] = offset;
+	args[2] = size;
+	args[3] = map;
+	memcpy(args + 4, data, size);
+
+	return true;
+}
+
+void CommandBufferClass::SetInputLayout(RenderHandle layout)
+{
+	Write1(COMMAND_SET_INPUT_LAYOUT, layout);
+	return;
+}
+
+void CommandBufferClass::SetVertexBuffer(unsigned int slot, RenderHandle buffer, unsigned int stride, unsigned int offset)
+{
+	Write4(COMMAND_SET_VERTEX_BUFFER, slot, buffer, stride, offset);
+	return;
+}
+
+void CommandBufferClass::SetIndexBuffer(RenderHandle buffer, RenderFormat format, unsigned int offset)
+{
+	Write3(COMMAND_SET_INDEX_BUFFER, buffer, format, offset);
+	return;
+}
+
+void CommandBufferClass::SetPrimitiveTopology(RenderTopology topology)
+{
+	Write1(COMMAND_SET_PRIMITIVE_TOPOLOGY, topology);
+	return;
+}
+
+void CommandBufferClass::SetVertexShader(RenderHandle shader)
+{
+	Write1(COMMAND_SET_VERTEX_SHADER, shader);
+	return;
+}
+
+void CommandBufferClass::SetVSConstantBuffer(unsigned int slot, RenderHandle buffer)
+{
+	Write2(COMMAND_SET_VS_CONSTANT_BUFFER, slot, buffer);
+	return;
+}
+
+void CommandBufferClass::SetPixelShader(RenderHandle shader)
+{
+	Write1(COMMAND_SET_PIXEL_SHADER, shader);
+	return;
+}
+
+void CommandBufferClass::SetPSConstantBuffer(unsigned int slot, RenderHandle buffer)
+{
+	Write2(COMMAND_SET_PS_CONSTANT_BUFFER, slot, buffer);
+	return;
+}
+
+void CommandBufferClass::SetPSTexture(unsigned int slot, RenderHandle texture)
+{
+	Write2(COMMAND_SET_PS_TEXTURE, slot, texture);
+	return;
+}
+
+void CommandBufferClass::SetPSSampler(unsigned int slot, RenderHandle sampler)
+{
+	Write2(COMMAND_SET_PS_SAMPLER, slot, sampler);
+	return;
+}
+
+void CommandBufferClass::SetRasterizerState(RenderHandle state)
+{
+	Write1(COMMAND_SET_RASTERIZER_STATE, state);
+	return;
+}
+
+void CommandBufferClass::SetDepthStencilState(RenderHandle state, unsigned int stencilRef)
+{
+	Write2(COMMAND_SET_DEPTH_STENCIL_STATE, state, stencilRef);
+	return;
+}
+
+void CommandBufferClass::SetBlendState(RenderHandle state)
+{
+	Write1(COMMAND_SET_BLEND_STATE, state);
+	return;
+}
+
+void CommandBufferClass::Draw(unsigned int vertexCount, unsigned int startVertex)
+{
+	Write2(COMMAND_DRAW, vertexCount, startVertex);
+	return;
+}
+
+void CommandBufferClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	Write3(COMMAND_DRAW_INDEXED, indexCount, startIndex, (unsigned int)baseVertex);
+	return;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: commandbufferclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _COMMANDBUFFERCLASS_H_
+#define _COMMANDBUFFERCLASS_H_
+
+//The CommandBufferClass is a render context that does not talk to a device at all, it encodes every call into a flat byte stream
+//instead. Any thread can record into its own command buffer and the submitting thread later plays the stream back on the immediate
+//context with Execute, in the order it was recorded. Buffer updates are copied into the stream so the caller's data can go away
+//right after the call, just like with Map/Unmap.
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+#include <vector>
+#include <cstddef>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: CommandBufferClass
+////////////////////////////////////////////////////////////////////////////////
+class CommandBufferClass : public RenderContextClass
+{
+private:
+	enum CommandType
+	{
+		COMMAND_UPDATE_BUFFER,
+		COMMAND_UPDATE_BUFFER_REGION,
+		COMMAND_WRITE_BUFFER,
+		COMMAND_SET_INPUT_LAYOUT,
+		COMMAND_SET_VERTEX_BUFFER,
+		COMMAND_SET_INDEX_BUFFER,
+		COMMAND_SET_PRIMITIVE_TOPOLOGY,
+		COMMAND_SET_VERTEX_SHADER,
+		COMMAND_SET_VS_CONSTANT_BUFFER,
+		COMMAND_SET_PIXEL_SHADER,
+		COMMAND_SET_PS_CONSTANT_BUFFER,
+		COMMAND_SET_PS_TEXTURE,
+		COMMAND_SET_PS_SAMPLER,
+		COMMAND_SET_RASTERIZER_STATE,
+		COMMAND_SET_DEPTH_STENCIL_STATE,
+		COMMAND_SET_BLEND_STATE,
+		COMMAND_DRAW,
+		COMMAND_DRAW_INDEXED
+	};
+
+	//every command starts with this header, size is the number of bytes of the whole command including the header
+	struct CommandHeaderType
+	{
+		unsigned int type;
+		unsigned int size;
+	};
+
+public:
+	CommandBufferClass();
+	CommandBufferClass(const CommandBufferClass&);
+	~CommandBufferClass();
+
+	void Execute(RenderContextClass*);
+	void Reset();
+
+	unsigned int GetCommandCount();
+	size_t GetSize();
+
+	bool UpdateBuffer(RenderHandle, const void*, unsigned int);
+	bool UpdateBufferRegion(RenderHandle, unsigned int, const void*, unsigned int);
+	bool WriteBuffer(RenderHandle, unsigned int, const void*, unsigned int, RenderMap);
+	void SetInputLayout(RenderHandle);
+	void SetVertexBuffer(unsigned int, RenderHandle, unsigned int, unsigned int);
+	void SetIndexBuffer(RenderHandle, RenderFormat, unsigned int);
+	void SetPrimitiveTopology(RenderTopology);
+	void SetVertexShader(RenderHandle);
+	void SetVSConstantBuffer(unsigned int, RenderHandle);
+	void SetPixelShader(RenderHandle);
+	void SetPSConstantBuffer(unsigned int, RenderHandle);
+	void SetPSTexture(unsigned int, RenderHandle);
+	void SetPSSampler(unsigned int, RenderHandle);
+	void SetRasterizerState(RenderHandle);
+	void SetDepthStencilState(RenderHandle, unsigned int);
+	void SetBlendState(RenderHandle);
+	void Draw(unsigned int, unsigned int);
+	void DrawIndexed(unsigned int, unsigned int, int);
+
+private:
+	unsigned int* Allocate(CommandType, unsigned int, unsigned int);
+	void Write1(CommandType, unsigned int);
+	void Write2(CommandType, unsigned int, unsigned int);
+	void Write3(CommandType, unsigned int, unsigned int, unsigned int);
+	void Write4(CommandType, unsigned int, unsigned int, unsigned int, unsigned int);
+
+private:
+	//the stream is kept as 32 bit words, every argument we encode is a 32 bit value and UpdateBuffer data is padded to a whole word
+	std::vector<unsigned int> m_commands;
+	unsigned int m_commandCount;
+};
+
+#endif
@@ -0,0 +1,1204 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: d3d11renderdeviceclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "d3d11renderdeviceclass.h"
+#include "hitchdetectorclass.h"
+#include "memorytrackerclass.h"
+#include <fstream>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+//the shaders PrecompileShader compiled and nobody asked for yet, by GetShaderKey
+static std::mutex s_precompiledMutex;
+static std::map<std::string, ID3D10Blob*> s_precompiled;
+
+//The engine's descriptions use their own enums so the rest of the code never includes the D3D headers, these turn them back into D3D values.
+
+static DXGI_FORMAT ConvertFormat(RenderFormat format)
+{
+	switch (format)
+	{
+	case RENDER_FORMAT_R32G32_FLOAT: return DXGI_FORMAT_R32G32_FLOAT;
+	case RENDER_FORMAT_R32G32B32_FLOAT: return DXGI_FORMAT_R32G32B32_FLOAT;
+	case RENDER_FORMAT_R32G32B32A32_FLOAT: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+	case RENDER_FORMAT_R8G8B8A8_UNORM: return DXGI_FORMAT_R8G8B8A8_UNORM;
+	case RENDER_FORMAT_R16_UINT: return DXGI_FORMAT_R16_UINT;
+	case RENDER_FORMAT_R32_UINT: return DXGI_FORMAT_R32_UINT;
+	default: return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+static D3D11_PRIMITIVE_TOPOLOGY ConvertTopology(RenderTopology topology)
+{
+	switch (topology)
+	{
+	case RENDER_TOPOLOGY_TRIANGLESTRIP: return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+	case RENDER_TOPOLOGY_LINELIST: return D3D11_PRIMITIVE_TOPOLOGY_LINELIST;
+	case RENDER_TOPOLOGY_POINTLIST: return D3D11_PRIMITIVE_TOPOLOGY_POINTLIST;
+	default: return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	}
+}
+
+static D3D11_FILTER ConvertFilter(RenderFilter filter)
+{
+	switch (filter)
+	{
+	case RENDER_FILTER_MIN_MAG_MIP_POINT: return D3D11_FILTER_MIN_MAG_MIP_POINT;
+	case RENDER_FILTER_ANISOTROPIC: return D3D11_FILTER_ANISOTROPIC;
+	default: return D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	}
+}
+
+static D3D11_TEXTURE_ADDRESS_MODE ConvertAddress(RenderTextureAddress address)
+{
+	switch (address)
+	{
+	case RENDER_TEXTURE_ADDRESS_MIRROR: return D3D11_TEXTURE_ADDRESS_MIRROR;
+	case RENDER_TEXTURE_ADDRESS_CLAMP: return D3D11_TEXTURE_ADDRESS_CLAMP;
+	case RENDER_TEXTURE_ADDRESS_BORDER: return D3D11_TEXTURE_ADDRESS_BORDER;
+	default: return D3D11_TEXTURE_ADDRESS_WRAP;
+	}
+}
+
+//the RenderComparison and RenderStencilOp values are in the same order as the D3D ones, which start at 1
+
+static D3D11_COMPARISON_FUNC ConvertComparison(RenderComparison comparison)
+{
+	return (D3D11_COMPARISON_FUNC)(comparison + D3D11_COMPARISON_NEVER);
+}
+
+static D3D11_STENCIL_OP ConvertStencilOp(RenderStencilOp op)
+{
+	return (D3D11_STENCIL_OP)(op + D3D11_STENCIL_OP_KEEP);
+}
+
+//so are RenderBlend and RenderBlendOp
+
+static D3D11_BLEND ConvertBlend(RenderBlend blend)
+{
+	return (D3D11_BLEND)(blend + D3D11_BLEND_ZERO);
+}
+
+static D3D11_BLEND_OP ConvertBlendOp(RenderBlendOp op)
+{
+	return (D3D11_BLEND_OP)(op + D3D11_BLEND_OP_ADD);
+}
+
+static D3D11_CULL_MODE ConvertCullMode(RenderCullMode cullMode)
+{
+	switch (cullMode)
+	{
+	case RENDER_CULL_NONE: return D3D11_CULL_NONE;
+	case RENDER_CULL_FRONT: return D3D11_CULL_FRONT;
+	default: return D3D11_CULL_BACK;
+	}
+}
+
+static D3D11_DEPTH_STENCILOP_DESC ConvertStencilOpDesc(const RenderStencilOpDesc& desc)
+{
+	D3D11_DEPTH_STENCILOP_DESC result;
+
+	result.StencilFailOp = ConvertStencilOp(desc.stencilFailOp);
+	result.StencilDepthFailOp = ConvertStencilOp(desc.stencilDepthFailOp);
+	result.StencilPassOp = ConvertStencilOp(desc.stencilPassOp);
+	result.StencilFunc = ConvertComparison(desc.stencilFunc);
+
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// D3D11RenderDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+
+D3D11RenderDeviceClass::D3D11RenderDeviceClass()
+	: m_D3D(nullptr)
+	, m_device(nullptr)
+	, m_hwnd(NULL)
+	, m_driverCommandLists(false)
+	, m_frame(0)
+{
+}
+
+D3D11RenderDeviceClass::D3D11RenderDeviceClass(const D3D11RenderDeviceClass& other)
+{
+}
+
+
+D3D11RenderDeviceClass::~D3D11RenderDeviceClass()
+{
+}
+
+//Initialize takes an already initialized D3DClass, the window handle is only used to report shader compile errors.
+
+bool D3D11RenderDeviceClass::Initialize(D3DClass* d3d, HWND hwnd)
+{
+	D3D11_FEATURE_DATA_THREADING threading;
+	HRESULT result;
+
+	if (!d3d)
+	{
+		return false;
+	}
+
+	m_D3D = d3d;
+	m_device = d3d->GetDevice();
+	m_hwnd = hwnd;
+
+	if (!m_device)
+	{
+		return false;
+	}
+
+	m_immediateContext.Initialize(this, d3d->GetDeviceContext());
+
+	m_frame = 0;
+	for (auto i = 0; i < RESOURCE_KIND_COUNT; i++)
+	{
+		m_resources[i].Initialize(i);
+	}
+
+	//the runtime emulates deferred contexts when the driver has no command list support, our own command buffers are cheaper than that
+	result = m_device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading));
+	m_driverCommandLists = SUCCEEDED(result) && threading.DriverCommandLists;
+
+	return true;
+}
+
+//Shutdown destroys everything still waiting for its deferred release along with anything the rest of the engine forgot to release.
+
+void D3D11RenderDeviceClass::Shutdown()
+{
+	while (!m_deferredContexts.empty())
+	{
+		ReleaseDeferredContext(m_deferredContexts.back().native ? (RenderContextClass*)m_deferredContexts.back().native.get() :
+			(RenderContextClass*)m_deferredContexts.back().encoded.get());
+	}
+
+	for (auto i = 0; i < RESOURCE_KIND_COUNT; i++)
+	{
+		m_resources[i].Clear(DestroyResource);
+	}
+
+	ReleasePrecompiledShaders();
+
+	m_device = nullptr;
+	m_D3D = nullptr;
+
+	return;
+}
+
+RenderHandle D3D11RenderDeviceClass::AddResource(ResourceKind kind, ID3D11DeviceChild* object, ID3D11ShaderResourceView* view, ID3D10Blob* bytecode,
+	RenderUsage usage)
+{
+	ResourceType resource;
+	RenderHandle handle;
+
+	resource.object = object;
+	resource.view = view;
+	resource.bytecode = bytecode;
+	resource.usage = usage;
+
+	//the bytecode kept with a vertex shader is memory of ours, the driver's copy of the shader is not counted
+	if (bytecode)
+	{
+		MemoryTrackerClass::Track(MEMORY_CPU, (unsigned long long)(uintptr_t)bytecode, bytecode->GetBufferSize());
+	}
+
+	handle = m_resources[kind].Add(resource);
+	if (handle == RENDER_NULL_HANDLE)
+	{
+		DestroyResource(resource);
+	}
+
+	return handle;
+}
+
+//Lookup returns nullptr for a handle of another kind without complaining, a stale handle of the right kind is caught by the pool.
+
+D3D11RenderDeviceClass::ResourceType* D3D11RenderDeviceClass::Lookup(RenderHandle handle, ResourceKind kind)
+{
+	if (handle == RENDER_NULL_HANDLE || ResourcePoolClass<ResourceType>::GetType(handle) != (unsigned int)kind)
+	{
+		return nullptr;
+	}
+
+	return m_resources[kind].Get(handle);
+}
+
+void D3D11RenderDeviceClass::DestroyResource(ResourceType& resource)
+{
+	if (resource.view)
+	{
+		resource.view->Release();
+	}
+
+	if (resource.bytecode)
+	{
+		MemoryTrackerClass::Untrack(MEMORY_CPU, (unsigned long long)(uintptr_t)resource.bytecode);
+		resource.bytecode->Release();
+	}
+
+	if (resource.object)
+	{
+		resource.object->Release();
+	}
+
+	return;
+}
+
+RenderHandle D3D11RenderDeviceClass::CreateBuffer(const RenderBufferDesc& desc, const void* initialData)
+{
+	D3D11_BUFFER_DESC bufferDesc;
+	D3D11_SUBRESOURCE_DATA data;
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+	ID3D11Buffer* buffer;
+	ID3D11ShaderResourceView* bufferView;
+	HRESULT result;
+
+	ZeroMemory(&bufferDesc, sizeof(bufferDesc));
+	bufferDesc.ByteWidth = desc.byteWidth;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	// Dynamic buffers are the ones the CPU rewrites every frame with Map/Unmap.
+	switch (desc.usage)
+	{
+	case RENDER_USAGE_DYNAMIC:
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		break;
+	case RENDER_USAGE_IMMUTABLE:
+		bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		bufferDesc.CPUAccessFlags = 0;
+		break;
+	default:
+		bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+		bufferDesc.CPUAccessFlags = 0;
+		break;
+	}
+
+	switch (desc.bindType)
+	{
+	case RENDER_BIND_VERTEX_BUFFER:
+		bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		break;
+	case RENDER_BIND_INDEX_BUFFER:
+		bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		break;
+	case RENDER_BIND_SHADER_RESOURCE:
+		if (desc.structureByteStride == 0)
+		{
+			return RENDER_NULL_HANDLE;
+		}
+		bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		bufferDesc.StructureByteStride = desc.structureByteStride;
+		break;
+	default:
+		bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		break;
+	}
+
+	data.pSysMem = initialData;
+	data.SysMemPitch = 0;
+	data.SysMemSlicePitch = 0;
+
+	result = m_device->CreateBuffer(&bufferDesc, initialData ? &data : NULL, &buffer);
+	if (FAILED(result))
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	// Shader resource buffers get a view over all their elements so they can be bound like a texture.
+	bufferView = nullptr;
+	if (desc.bindType == RENDER_BIND_SHADER_RESOURCE)
+	{
+		ZeroMemory(&srvDesc, sizeof(srvDesc));
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = desc.byteWidth / desc.structureByteStride;
+
+		result = m_device->CreateShaderResourceView(buffer, &srvDesc, &bufferView);
+		if (FAILED(result))
+		{
+			buffer->Release();
+			return RENDER_NULL_HANDLE;
+		}
+	}
+
+	return AddResource(RESOURCE_BUFFER, buffer, bufferView, nullptr, desc.usage);
+}
+
+/*
+CreateTexture2D creates the texture and its shader resource view in one go, this is what TextureClass::Initialize used to do itself.
+With generateMips set the texture gets a full mip chain: the top level is copied in with UpdateSubresource and GenerateMips fills in the rest.
+*/
+
+RenderHandle D3D11RenderDeviceClass::CreateTexture2D(const RenderTextureDesc& desc, const void* data, unsigned int rowPitch)
+{
+	D3D11_TEXTURE2D_DESC textureDesc;
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+	ID3D11Texture2D* texture;
+	ID3D11ShaderResourceView* textureView;
+	ID3D11DeviceContext* deviceContext;
+	HRESULT result;
+
+	// Setup the description of the texture.
+	textureDesc.Height = desc.height;
+	textureDesc.Width = desc.width;
+	textureDesc.MipLevels = desc.generateMips ? 0 : 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = ConvertFormat(desc.format);
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | (desc.generateMips ? D3D11_BIND_RENDER_TARGET : 0);
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = desc.generateMips ? D3D11_RESOURCE_MISC_GENERATE_MIPS : 0;
+
+	//create the empty texture
+	result = m_device->CreateTexture2D(&textureDesc, NULL, &texture);
+	if (FAILED(result))
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	deviceContext = m_immediateContext.GetDeviceContext();
+
+	// Copy the image data into the top level of the texture.
+	if (data)
+	{
+		deviceContext->UpdateSubresource(texture, 0, NULL, data, rowPitch, 0);
+	}
+
+	// Setup the shader resource view description.
+	srvDesc.Format = textureDesc.Format;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Texture2D.MipLevels = -1;
+
+	// Create the shader resource view for the texture.
+	result = m_device->CreateShaderResourceView(texture, &srvDesc, &textureView);
+	if (FAILED(result))
+	{
+		texture->Release();
+		return RENDER_NULL_HANDLE;
+	}
+
+	// Generate mipmaps for this texture.
+	if (desc.generateMips)
+	{
+		deviceContext->GenerateMips(textureView);
+	}
+
+	return AddResource(RESOURCE_TEXTURE, texture, textureView, nullptr, RENDER_USAGE_DEFAULT);
+}
+
+/*
+PrecompileShader compiles a shader into the cache that CompileShader takes it from. D3DCompileFromFile does not need the device and is
+safe to call from several threads, so the startup compiles shaders while the device is still being created and the model loaded. The
+cache holds each shader until it is asked for once, what is never asked for is released on Shutdown.
+*/
+
+bool D3D11RenderDeviceClass::PrecompileShader(const RenderShaderDesc& shader)
+{
+	ID3D10Blob* shaderBuffer;
+	ID3D10Blob* errorMessage;
+	const char* profile;
+	HRESULT result;
+	std::string key;
+
+	// The same profiles CreateVertexShader and CreatePixelShader compile with.
+	profile = shader.pixelShader ? "ps_5_0" : "vs_5_0";
+	key = GetShaderKey(shader.filename, shader.entryPoint, profile);
+	TRACK_ACTIVITY("precompiling", key);
+
+	shaderBuffer = nullptr;
+	errorMessage = nullptr;
+
+	result = D3DCompileFromFile(shader.filename, NULL, NULL, shader.entryPoint, profile, D3D10_SHADER_ENABLE_STRICTNESS, 0, &shaderBuffer, &errorMessage);
+
+	if (errorMessage)
+	{
+		errorMessage->Release();
+	}
+
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(s_precompiledMutex);
+
+	auto existing = s_precompiled.find(key);
+	if (existing != s_precompiled.end())
+	{
+		existing->second->Release();
+	}
+	s_precompiled[key] = shaderBuffer;
+
+	return true;
+}
+
+void D3D11RenderDeviceClass::ReleasePrecompiledShaders()
+{
+	std::lock_guard<std::mutex> lock(s_precompiledMutex);
+
+	for (auto& shader : s_precompiled)
+	{
+		shader.second->Release();
+	}
+	s_precompiled.clear();
+
+	return;
+}
+
+//The file names are plain ascii, that is enough to tell which shader it was.
+
+std::string D3D11RenderDeviceClass::GetShaderKey(const wchar_t* filename, const char* entryPoint, const char* profile)
+{
+	std::string key;
+
+	key = std::string(entryPoint) + " " + profile + " in ";
+	for (auto name = filename; *name; name++)
+	{
+		key += (char)*name;
+	}
+
+	return key;
+}
+
+//CompileShader compiles one entry point of an HLSL file, on failure the compiler output goes to shader-error.txt like it always has.
+
+ID3D10Blob* D3D11RenderDeviceClass::CompileShader(const wchar_t* filename, const char* entryPoint, const char* profile)
+{
+	ID3D10Blob* shaderBuffer;
+	ID3D10Blob* errorMessage;
+	HRESULT result;
+	std::string detail;
+
+	// A shader the startup compiled already only has to be taken out of the cache.
+	detail = GetShaderKey(filename, entryPoint, profile);
+	{
+		std::lock_guard<std::mutex> lock(s_precompiledMutex);
+
+		auto precompiled = s_precompiled.find(detail);
+		if (precompiled != s_precompiled.end())
+		{
+			shaderBuffer = precompiled->second;
+			s_precompiled.erase(precompiled);
+			return shaderBuffer;
+		}
+	}
+
+	TRACK_ACTIVITY("compiling", detail);
+
+	shaderBuffer = nullptr;
+	errorMessage = nullptr;
+
+	result = D3DCompileFromFile(filename, NULL, NULL, entryPoint, profile, D3D10_SHADER_ENABLE_STRICTNESS, 0, &shaderBuffer, &errorMessage);
+	if (FAILED(result))
+	{
+		// If the shader failed to compile it should have written something to the error message.
+		if (errorMessage)
+		{
+			OutputShaderErrorMessage(errorMessage, filename);
+		}
+		// If there was nothing in the error message then it simply could not find the shader file itself.
+		else
+		{
+			MessageBox(m_hwnd, filename, L"Missing Shader File", MB_OK);
+		}
+
+		return nullptr;
+	}
+
+	if (errorMessage)
+	{
+		errorMessage->Release();
+	}
+
+	return shaderBuffer;
+}
+
+void D3D11RenderDeviceClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, const wchar_t* shaderFilename)
+{
+	char* compileErrors;
+	SIZE_T bufferSize, i;
+	std::ofstream fout;
+
+	//get a pointer to the error message text buffer
+	compileErrors = (char*)(errorMessage->GetBufferPointer());
+
+	//get length
+	bufferSize = errorMessage->GetBufferSize();
+
+	//open a file to write the error to
+	fout.open("shader-error.txt");
+
+	//write out
+	for (i = 0; i < bufferSize; i++)
+	{
+		fout << compileErrors[i];
+	}
+
+	fout.close();
+
+	errorMessage->Release();
+
+	MessageBox(m_hwnd, L"Error compiling shader.  Check shader-error.txt for message.", shaderFilename, MB_OK);
+
+	return;
+}
+
+RenderHandle D3D11RenderDeviceClass::CreateVertexShader(const wchar_t* filename, const char* entryPoint)
+{
+	ID3D10Blob* vertexShaderBuffer;
+	ID3D11VertexShader* vertexShader;
+	HRESULT result;
+
+	vertexShaderBuffer = CompileShader(filename, entryPoint, "vs_5_0");
+	if (!vertexShaderBuffer)
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	//create the vertex shader from the buffer
+	result = m_device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &vertexShader);
+	if (FAILED(result))
+	{
+		vertexShaderBuffer->Release();
+		return RENDER_NULL_HANDLE;
+	}
+
+	// The bytecode is kept with the shader since CreateInputLayout needs it to validate the layout against the shader's input signature.
+	return AddResource(RESOURCE_VERTEX_SHADER, vertexShader, nullptr, vertexShaderBuffer, RENDER_USAGE_DEFAULT);
+}
+
+RenderHandle D3D11RenderDeviceClass::CreatePixelShader(const wchar_t* filename, const char* entryPoint)
+{
+	ID3D10Blob* pixelShaderBuffer;
+	ID3D11PixelShader* pixelShader;
+	HRESULT result;
+
+	pixelShaderBuffer = CompileShader(filename, entryPoint, "ps_5_0");
+	if (!pixelShaderBuffer)
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	// Create the pixel shader from the buffer.
+	result = m_device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &pixelShader);
+
+	//the pixel shader bytecode is not needed once the shader object exists
+	pixelShaderBuffer->Release();
+
+	if (FAILED(result))
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	return AddResource(RESOURCE_PIXEL_SHADER, pixelShader, nullptr, nullptr, RENDER_USAGE_DEFAULT);
+}
+
+RenderHandle D3D11RenderDeviceClass::CreateInputLayout(const RenderInputElementDesc* elements, unsigned int elementCount, RenderHandle vertexShader)
+{
+	std::vector<D3D11_INPUT_ELEMENT_DESC> polygonLayout(elementCount);
+	ID3D11InputLayout* layout;
+	ID3D10Blob* bytecode;
+	ResourceType* shader;
+	HRESULT result;
+
+	shader = Lookup(vertexShader, RESOURCE_VERTEX_SHADER);
+	if (!shader)
+	{
+		return RENDER_NULL_HANDLE;
+	}
+	bytecode = shader->bytecode;
+
+	for (unsigned int i = 0; i < elementCount; i++)
+	{
+		polygonLayout[i].SemanticName = elements[i].semanticName;
+		polygonLayout[i].SemanticIndex = elements[i].semanticIndex;
+		polygonLayout[i].Format = ConvertFormat(elements[i].format);
+		polygonLayout[i].InputSlot = elements[i].inputSlot;
+		polygonLayout[i].AlignedByteOffset = elements[i].alignedByteOffset == RENDER_APPEND_ALIGNED_ELEMENT ? D3D11_APPEND_ALIGNED_ELEMENT : elements[i].alignedByteOffset;
+		polygonLayout[i].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+		polygonLayout[i].InstanceDataStepRate = 0;
+	}
+
+	//create the vertex input layout
+	result = m_device->CreateInputLayout(polygonLayout.data(), elementCount, bytecode->GetBufferPointer(), bytecode->GetBufferSize(), &layout);
+	if (FAILED(result))
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	return AddResource(RESOURCE_INPUT_LAYOUT, layout, nullptr, nullptr, RENDER_USAGE_DEFAULT);
+}
+
+RenderHandle D3D11RenderDeviceClass::CreateSamplerState(const RenderSamplerDesc& desc)
+{
+	D3D11_SAMPLER_DESC samplerDesc;
+	ID3D11SamplerState* samplerState;
+	HRESULT result;
+
+	samplerDesc.Filter = ConvertFilter(desc.filter);
+	samplerDesc.AddressU = ConvertAddress(desc.addressU);
+	samplerDesc.AddressV = ConvertAddress(desc.addressV);
+	samplerDesc.AddressW = ConvertAddress(desc.addressW);
+	samplerDesc.MipLODBias = desc.mipLODBias;
+	samplerDesc.MaxAnisotropy = desc.maxAnisotropy;
+	samplerDesc.ComparisonFunc = ConvertComparison(desc.comparisonFunc);
+	samplerDesc.BorderColor[0] = desc.borderColor[0];
+	samplerDesc.BorderColor[1] = desc.borderColor[1];
+	samplerDesc.BorderColor[2] = desc.borderColor[2];
+	samplerDesc.BorderColor[3] = desc.borderColor[3];
+	samplerDesc.MinLOD = desc.minLOD;
+	samplerDesc.MaxLOD = desc.maxLOD;
+
+	result = m_device->CreateSamplerState(&samplerDesc, &samplerState);
+	if (FAILED(result))
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	return AddResource(RESOURCE_SAMPLER_STATE, samplerState, nullptr, nullptr, RENDER_USAGE_DEFAULT);
+}
+
+RenderHandle D3D11RenderDeviceClass::CreateRasterizerState(const RenderRasterizerDesc& desc)
+{
+	D3D11_RASTERIZER_DESC rasterDesc;
+	ID3D11RasterizerState* rasterState;
+	HRESULT result;
+
+	rasterDesc.AntialiasedLineEnable = desc.antialiasedLineEnable;
+	rasterDesc.CullMode = ConvertCullMode(desc.cullMode);
+	rasterDesc.DepthBias = desc.depthBias;
+	rasterDesc.DepthBiasClamp = desc.depthBiasClamp;
+	rasterDesc.DepthClipEnable = desc.depthClipEnable;
+	rasterDesc.FillMode = desc.fillMode == RENDER_FILL_WIREFRAME ? D3D11_FILL_WIREFRAME : D3D11_FILL_SOLID;
+	rasterDesc.FrontCounterClockwise = desc.frontCounterClockwise;
+	rasterDesc.MultisampleEnable = desc.multisampleEnable;
+	rasterDesc.ScissorEnable = desc.scissorEnable;
+	rasterDesc.SlopeScaledDepthBias = desc.slopeScaledDepthBias;
+
+	result = m_device->CreateRasterizerState(&rasterDesc, &rasterState);
+	if (FAILED(result))
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	return AddResource(RESOURCE_RASTERIZER_STATE, rasterState, nullptr, nullptr, RENDER_USAGE_DEFAULT);
+}
+
+RenderHandle D3D11RenderDeviceClass::CreateDepthStencilState(const RenderDepthStencilDesc& desc)
+{
+	D3D11_DEPTH_STENCIL_DESC depthStencilDesc;
+	ID3D11DepthStencilState* depthStencilState;
+	HRESULT result;
+
+	depthStencilDesc.DepthEnable = desc.depthEnable;
+	depthStencilDesc.DepthWriteMask = desc.depthWriteEnable ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
+	depthStencilDesc.DepthFunc = ConvertComparison(desc.depthFunc);
+	depthStencilDesc.StencilEnable = desc.stencilEnable;
+	depthStencilDesc.StencilReadMask = desc.stencilReadMask;
+	depthStencilDesc.StencilWriteMask = desc.stencilWriteMask;
+	depthStencilDesc.FrontFace = ConvertStencilOpDesc(desc.frontFace);
+	depthStencilDesc.BackFace = ConvertStencilOpDesc(desc.backFace);
+
+	result = m_device->CreateDepthStencilState(&depthStencilDesc, &depthStencilState);
+	if (FAILED(result))
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	return AddResource(RESOURCE_DEPTH_STENCIL_STATE, depthStencilState, nullptr, nullptr, RENDER_USAGE_DEFAULT);
+}
+
+RenderHandle D3D11RenderDeviceClass::CreateBlendState(const RenderBlendDesc& desc)
+{
+	D3D11_BLEND_DESC blendDesc;
+	ID3D11BlendState* blendState;
+	HRESULT result;
+
+	// Only render target 0 is ever bound, the others keep the default.
+	ZeroMemory(&blendDesc, sizeof(blendDesc));
+	blendDesc.AlphaToCoverageEnable = desc.alphaToCoverageEnable;
+	blendDesc.IndependentBlendEnable = false;
+	blendDesc.RenderTarget[0].BlendEnable = desc.blendEnable;
+	blendDesc.RenderTarget[0].SrcBlend = ConvertBlend(desc.srcBlend);
+	blendDesc.RenderTarget[0].DestBlend = ConvertBlend(desc.destBlend);
+	blendDesc.RenderTarget[0].BlendOp = ConvertBlendOp(desc.blendOp);
+	blendDesc.RenderTarget[0].SrcBlendAlpha = ConvertBlend(desc.srcBlendAlpha);
+	blendDesc.RenderTarget[0].DestBlendAlpha = ConvertBlend(desc.destBlendAlpha);
+	blendDesc.RenderTarget[0].BlendOpAlpha = ConvertBlendOp(desc.blendOpAlpha);
+	blendDesc.RenderTarget[0].RenderTargetWriteMask = desc.writeMask;
+
+	result = m_device->CreateBlendState(&blendDesc, &blendState);
+	if (FAILED(result))
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	return AddResource(RESOURCE_BLEND_STATE, blendState, nullptr, nullptr, RENDER_USAGE_DEFAULT);
+}
+
+void D3D11RenderDeviceClass::ReleaseResource(RenderHandle handle)
+{
+	unsigned int kind;
+
+	kind = ResourcePoolClass<ResourceType>::GetType(handle);
+	if (handle == RENDER_NULL_HANDLE || kind >= RESOURCE_KIND_COUNT)
+	{
+		return;
+	}
+
+	// Frames already submitted may still use it, it is destroyed by the EndScene RENDER_RELEASE_LATENCY frames from now.
+	m_resources[kind].Release(handle, m_frame + RENDER_RELEASE_LATENCY);
+
+	return;
+}
+
+RenderContextClass* D3D11RenderDeviceClass::GetImmediateContext()
+{
+	return &m_immediateContext;
+}
+
+RenderContextClass* D3D11RenderDeviceClass::CreateDeferredContext()
+{
+	DeferredContextType deferred;
+	ID3D11DeviceContext* deviceContext;
+	HRESULT result;
+
+	if (m_driverCommandLists)
+	{
+		result = m_device->CreateDeferredContext(0, &deviceContext);
+		if (SUCCEEDED(result))
+		{
+			deferred.native.reset(new D3D11RenderContextClass());
+			deferred.native->Initialize(this, deviceContext);
+			PrepareDeferredContext(deviceContext);
+
+			m_deferredContexts.push_back(std::move(deferred));
+			return m_deferredContexts.back().native.get();
+		}
+	}
+
+	deferred.encoded.reset(new CommandBufferClass());
+	m_deferredContexts.push_back(std::move(deferred));
+
+	return m_deferredContexts.back().encoded.get();
+}
+
+void D3D11RenderDeviceClass::ExecuteDeferredContext(RenderContextClass* context)
+{
+	ID3D11CommandList* commandList;
+	ID3D11DeviceContext* deviceContext;
+	HRESULT result;
+
+	for (auto& deferred : m_deferredContexts)
+	{
+		if (deferred.encoded.get() == context)
+		{
+			deferred.encoded->Execute(&m_immediateContext);
+			deferred.encoded->Reset();
+			return;
+		}
+
+		if (deferred.native.get() == context)
+		{
+			deviceContext = deferred.native->GetDeviceContext();
+
+			//finishing resets the deferred context to the default state, so it has to be prepared again for the next recording
+			result = deviceContext->FinishCommandList(FALSE, &commandList);
+			if (SUCCEEDED(result))
+			{
+				m_immediateContext.GetDeviceContext()->ExecuteCommandList(commandList, TRUE);
+				commandList->Release();
+			}
+			PrepareDeferredContext(deviceContext);
+			return;
+		}
+	}
+
+	return;
+}
+
+void D3D11RenderDeviceClass::ReleaseDeferredContext(RenderContextClass* context)
+{
+	for (size_t i = 0; i < m_deferredContexts.size(); i++)
+	{
+		if (m_deferredContexts[i].encoded.get() == context || m_deferredContexts[i].native.get() == context)
+		{
+			if (m_deferredContexts[i].native)
+			{
+				m_deferredContexts[i].native->GetDeviceContext()->Release();
+			}
+
+			m_deferredContexts.erase(m_deferredContexts.begin() + i);
+			break;
+		}
+	}
+
+	return;
+}
+
+/*
+A D3D11 deferred context starts out with the default pipeline state, which has no render target and no viewport. PrepareDeferredContext
+copies the output merger and rasterizer setup of the immediate context (the back buffer, depth buffer, viewport and the states D3DClass
+created) over to the deferred context so what is recorded on it draws to the same place as a draw on the immediate context would.
+*/
+
+void D3D11RenderDeviceClass::PrepareDeferredContext(ID3D11DeviceContext* deviceContext)
+{
+	ID3D11DeviceContext* immediateContext;
+	ID3D11RenderTargetView* renderTargetView;
+	ID3D11DepthStencilView* depthStencilView;
+	ID3D11RasterizerState* rasterState;
+	ID3D11DepthStencilState* depthStencilState;
+	D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+	UINT viewportCount, stencilRef;
+
+	immediateContext = m_immediateContext.GetDeviceContext();
+
+	immediateContext->OMGetRenderTargets(1, &renderTargetView, &depthStencilView);
+	deviceContext->OMSetRenderTargets(1, &renderTargetView, depthStencilView);
+
+	viewportCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+	immediateContext->RSGetViewports(&viewportCount, viewports);
+	deviceContext->RSSetViewports(viewportCount, viewports);
+
+	immediateContext->RSGetState(&rasterState);
+	deviceContext->RSSetState(rasterState);
+
+	immediateContext->OMGetDepthStencilState(&depthStencilState, &stencilRef);
+	deviceContext->OMSetDepthStencilState(depthStencilState, stencilRef);
+
+	// The Get functions add a reference to everything they return.
+	if (renderTargetView)
+	{
+		renderTargetView->Release();
+	}
+
+	if (depthStencilView)
+	{
+		depthStencilView->Release();
+	}
+
+	if (rasterState)
+	{
+		rasterState->Release();
+	}
+
+	if (depthStencilState)
+	{
+		depthStencilState->Release();
+	}
+
+	return;
+}
+
+void D3D11RenderDeviceClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	m_D3D->BeginScene(red, green, blue, alpha);
+	return;
+}
+
+void D3D11RenderDeviceClass::EndScene()
+{
+	m_D3D->EndScene();
+
+	m_frame++;
+	for (auto i = 0; i < RESOURCE_KIND_COUNT; i++)
+	{
+		m_resources[i].Retire(m_frame, DestroyResource);
+	}
+
+	return;
+}
+
+ID3D11Buffer* D3D11RenderDeviceClass::GetBuffer(RenderHandle handle)
+{
+	ResourceType* resource = Lookup(handle, RESOURCE_BUFFER);
+	return resource ? (ID3D11Buffer*)resource->object : nullptr;
+}
+
+bool D3D11RenderDeviceClass::IsDynamicBuffer(RenderHandle handle)
+{
+	ResourceType* resource = Lookup(handle, RESOURCE_BUFFER);
+	return resource && resource->usage == RENDER_USAGE_DYNAMIC;
+}
+
+ID3D11ShaderResourceView* D3D11RenderDeviceClass::GetShaderResourceView(RenderHandle handle)
+{
+	ResourceType* resource = Lookup(handle, RESOURCE_TEXTURE);
+	if (!resource)
+	{
+		resource = Lookup(handle, RESOURCE_BUFFER);
+	}
+
+	return resource ? resource->view : nullptr;
+}
+
+ID3D11VertexShader* D3D11RenderDeviceClass::GetVertexShader(RenderHandle handle)
+{
+	ResourceType* resource = Lookup(handle, RESOURCE_VERTEX_SHADER);
+	return resource ? (ID3D11VertexShader*)resource->object : nullptr;
+}
+
+ID3D11PixelShader* D3D11RenderDeviceClass::GetPixelShader(RenderHandle handle)
+{
+	ResourceType* resource = Lookup(handle, RESOURCE_PIXEL_SHADER);
+	return resource ? (ID3D11PixelShader*)resource->object : nullptr;
+}
+
+ID3D11InputLayout* D3D11RenderDeviceClass::GetInputLayout(RenderHandle handle)
+{
+	ResourceType* resource = Lookup(handle, RESOURCE_INPUT_LAYOUT);
+	return resource ? (ID3D11InputLayout*)resource->object : nullptr;
+}
+
+ID3D11SamplerState* D3D11RenderDeviceClass::GetSamplerState(RenderHandle handle)
+{
+	ResourceType* resource = Lookup(handle, RESOURCE_SAMPLER_STATE);
+	return resource ? (ID3D11SamplerState*)resource->object : nullptr;
+}
+
+ID3D11RasterizerState* D3D11RenderDeviceClass::GetRasterizerState(RenderHandle handle)
+{
+	ResourceType* resource = Lookup(handle, RESOURCE_RASTERIZER_STATE);
+	return resource ? (ID3D11RasterizerState*)resource->object : nullptr;
+}
+
+ID3D11DepthStencilState* D3D11RenderDeviceClass::GetDepthStencilState(RenderHandle handle)
+{
+	ResourceType* resource = Lookup(handle, RESOURCE_DEPTH_STENCIL_STATE);
+	return resource ? (ID3D11DepthStencilState*)resource->object : nullptr;
+}
+
+ID3D11BlendState* D3D11RenderDeviceClass::GetBlendState(RenderHandle handle)
+{
+	ResourceType* resource = Lookup(handle, RESOURCE_BLEND_STATE);
+	return resource ? (ID3D11BlendState*)resource->object : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// D3D11RenderContextClass
+////////////////////////////////////////////////////////////////////////////////
+
+D3D11RenderContextClass::D3D11RenderContextClass()
+	: m_device(nullptr)
+	, m_deviceContext(nullptr)
+{
+}
+
+D3D11RenderContextClass::D3D11RenderContextClass(const D3D11RenderContextClass& other)
+{
+}
+
+
+D3D11RenderContextClass::~D3D11RenderContextClass()
+{
+}
+
+void D3D11RenderContextClass::Initialize(D3D11RenderDeviceClass* device, ID3D11DeviceContext* deviceContext)
+{
+	m_device = device;
+	m_deviceContext = deviceContext;
+	return;
+}
+
+ID3D11DeviceContext* D3D11RenderContextClass::GetDeviceContext()
+{
+	return m_deviceContext;
+}
+
+//Dynamic buffers are locked with WRITE_DISCARD and filled, everything else goes through UpdateSubresource.
+
+bool D3D11RenderContextClass::UpdateBuffer(RenderHandle handle, const void* data, unsigned int size)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	ID3D11Buffer* buffer;
+	HRESULT result;
+
+	buffer = m_device->GetBuffer(handle);
+	if (!buffer || !data)
+	{
+		return false;
+	}
+
+	if (!m_device->IsDynamicBuffer(handle))
+	{
+		m_deviceContext->UpdateSubresource(buffer, 0, NULL, data, 0, 0);
+		return true;
+	}
+
+	//lock the buffer so it can be written to
+	result = m_deviceContext->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	memcpy(mappedResource.pData, data, size);
+
+	//unlock the buffer
+	m_deviceContext->Unmap(buffer, 0);
+
+	return true;
+}
+
+//UpdateBufferRegion copies into a box of the buffer, dynamic buffers can only be written with Map so they are refused.
+
+bool D3D11RenderContextClass::UpdateBufferRegion(RenderHandle handle, unsigned int offset, const void* data, unsigned int size)
+{
+	D3D11_BOX box;
+	ID3D11Buffer* buffer;
+
+	buffer = m_device->GetBuffer(handle);
+	if (!buffer || !data || m_device->IsDynamicBuffer(handle))
+	{
+		return false;
+	}
+
+	// Buffers are one dimensional, only left and right matter.
+	box.left = offset;
+	box.right = offset + size;
+	box.top = 0;
+	box.bottom = 1;
+	box.front = 0;
+	box.back = 1;
+
+	m_deviceContext->UpdateSubresource(buffer, 0, &box, data, 0, 0);
+
+	return true;
+}
+
+//WriteBuffer maps a dynamic buffer with the given map type and copies into it at the offset. A deferred context has to map a buffer
+//with WRITE_DISCARD before it can use NO_OVERWRITE on it, which is why streamed geometry is written on the immediate context.
+
+bool D3D11RenderContextClass::WriteBuffer(RenderHandle handle, unsigned int offset, const void* data, unsigned int size, RenderMap map)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	ID3D11Buffer* buffer;
+	HRESULT result;
+
+	buffer = m_device->GetBuffer(handle);
+	if (!buffer || !data || !m_device->IsDynamicBuffer(handle))
+	{
+		return false;
+	}
+
+	result = m_deviceContext->Map(buffer, 0, map == RENDER_MAP_WRITE_NO_OVERWRITE ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD, 0,
+		&mappedResource);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	memcpy((unsigned char*)mappedResource.pData + offset, data, size);
+
+	m_deviceContext->Unmap(buffer, 0);
+
+	return true;
+}
+
+void D3D11RenderContextClass::SetInputLayout(RenderHandle layout)
+{
+	m_deviceContext->IASetInputLayout(m_device->GetInputLayout(layout));
+	return;
+}
+
+void D3D11RenderContextClass::SetVertexBuffer(unsigned int slot, RenderHandle handle, unsigned int stride, unsigned int offset)
+{
+	ID3D11Buffer* buffer = m_device->GetBuffer(handle);
+	m_deviceContext->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+	return;
+}
+
+void D3D11RenderContextClass::SetIndexBuffer(RenderHandle handle, RenderFormat format, unsigned int offset)
+{
+	m_deviceContext->IASetIndexBuffer(m_device->GetBuffer(handle), ConvertFormat(format), offset);
+	return;
+}
+
+void D3D11RenderContextClass::SetPrimitiveTopology(RenderTopology topology)
+{
+	m_deviceContext->IASetPrimitiveTopology(ConvertTopology(topology));
+	return;
+}
+
+void D3D11RenderContextClass::SetVertexShader(RenderHandle shader)
+{
+	m_deviceContext->VSSetShader(m_device->GetVertexShader(shader), NULL, 0);
+	return;
+}
+
+void D3D11RenderContextClass::SetVSConstantBuffer(unsigned int slot, RenderHandle handle)
+{
+	ID3D11Buffer* buffer = m_device->GetBuffer(handle);
+	m_deviceContext->VSSetConstantBuffers(slot, 1, &buffer);
+	return;
+}
+
+void D3D11RenderContextClass::SetPixelShader(RenderHandle shader)
+{
+	m_deviceContext->PSSetShader(m_device->GetPixelShader(shader), NULL, 0);
+	return;
+}
+
+void D3D11RenderContextClass::SetPSConstantBuffer(unsigned int slot, RenderHandle handle)
+{
+	ID3D11Buffer* buffer = m_device->GetBuffer(handle);
+	m_deviceContext->PSSetConstantBuffers(slot, 1, &buffer);
+	return;
+}
+
+void D3D11RenderContextClass::SetPSTexture(unsigned int slot, RenderHandle texture)
+{
+	ID3D11ShaderResourceView* view = m_device->GetShaderResourceView(texture);
+	m_deviceContext->PSSetShaderResources(slot, 1, &view);
+	return;
+}
+
+void D3D11RenderContextClass::SetPSSampler(unsigned int slot, RenderHandle sampler)
+{
+	ID3D11SamplerState* samplerState = m_device->GetSamplerState(sampler);
+	m_deviceContext->PSSetSamplers(slot, 1, &samplerState);
+	return;
+}
+
+void D3D11RenderContextClass::SetRasterizerState(RenderHandle state)
+{
+	m_deviceContext->RSSetState(m_device->GetRasterizerState(state));
+	return;
+}
+
+void D3D11RenderContextClass::SetDepthStencilState(RenderHandle state, unsigned int stencilRef)
+{
+	m_deviceContext->OMSetDepthStencilState(m_device->GetDepthStencilState(state), stencilRef);
+	return;
+}
+
+//no blend factor (none of the RenderBlend values use it) and every sample written
+
+void D3D11RenderContextClass::SetBlendState(RenderHandle state)
+{
+	m_deviceContext->OMSetBlendState(m_device->GetBlendState(state), NULL, 0xffffffff);
+	return;
+}
+
+void D3D11RenderContextClass::Draw(unsigned int vertexCount, unsigned int startVertex)
+{
+	m_deviceContext->Draw(vertexCount, startVertex);
+	return;
+}
+
+void D3D11RenderContextClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	m_deviceContext->DrawIndexed(indexCount, startIndex, baseVertex);
+	return;
+}
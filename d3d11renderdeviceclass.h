@@ -0,0 +1,168 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: d3d11renderdeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _D3D11RENDERDEVICECLASS_H_
+#define _D3D11RENDERDEVICECLASS_H_
+
+//The Direct3D 11 backend of the RenderDeviceClass. D3DClass still owns the swap chain, back buffer and the device itself, this class
+//creates everything else on that device and keeps one ResourcePoolClass per kind of resource that maps a RenderHandle back to the D3D
+//object it stands for. The pools own the COM references, nothing else in the engine holds one.
+
+#pragma comment(lib, "D3DCompiler.lib")
+
+//////////////
+// INCLUDES //
+//////////////
+#include "d3dclass.h"
+#include "renderdeviceclass.h"
+#include "commandbufferclass.h"
+#include "resourcepoolclass.h"
+#include <d3dcompiler.h>
+#include <vector>
+#include <memory>
+#include <string>
+
+class D3D11RenderDeviceClass;
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: D3D11RenderContextClass
+////////////////////////////////////////////////////////////////////////////////
+class D3D11RenderContextClass : public RenderContextClass
+{
+public:
+	D3D11RenderContextClass();
+	D3D11RenderContextClass(const D3D11RenderContextClass&);
+	~D3D11RenderContextClass();
+
+	void Initialize(D3D11RenderDeviceClass*, ID3D11DeviceContext*);
+	ID3D11DeviceContext* GetDeviceContext();
+
+	bool UpdateBuffer(RenderHandle, const void*, unsigned int);
+	bool UpdateBufferRegion(RenderHandle, unsigned int, const void*, unsigned int);
+	bool WriteBuffer(RenderHandle, unsigned int, const void*, unsigned int, RenderMap);
+	void SetInputLayout(RenderHandle);
+	void SetVertexBuffer(unsigned int, RenderHandle, unsigned int, unsigned int);
+	void SetIndexBuffer(RenderHandle, RenderFormat, unsigned int);
+	void SetPrimitiveTopology(RenderTopology);
+	void SetVertexShader(RenderHandle);
+	void SetVSConstantBuffer(unsigned int, RenderHandle);
+	void SetPixelShader(RenderHandle);
+	void SetPSConstantBuffer(unsigned int, RenderHandle);
+	void SetPSTexture(unsigned int, RenderHandle);
+	void SetPSSampler(unsigned int, RenderHandle);
+	void SetRasterizerState(RenderHandle);
+	void SetDepthStencilState(RenderHandle, unsigned int);
+	void SetBlendState(RenderHandle);
+	void Draw(unsigned int, unsigned int);
+	void DrawIndexed(unsigned int, unsigned int, int);
+
+private:
+	D3D11RenderDeviceClass* m_device;
+	ID3D11DeviceContext* m_deviceContext;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: D3D11RenderDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+class D3D11RenderDeviceClass : public RenderDeviceClass
+{
+private:
+	//also the pool type in the top bits of the handles
+	enum ResourceKind
+	{
+		RESOURCE_BUFFER,
+		RESOURCE_TEXTURE,
+		RESOURCE_VERTEX_SHADER,
+		RESOURCE_PIXEL_SHADER,
+		RESOURCE_INPUT_LAYOUT,
+		RESOURCE_SAMPLER_STATE,
+		RESOURCE_RASTERIZER_STATE,
+		RESOURCE_DEPTH_STENCIL_STATE,
+		RESOURCE_BLEND_STATE,
+		RESOURCE_KIND_COUNT
+	};
+
+	//textures keep their shader resource view next to them and vertex shaders keep their bytecode for CreateInputLayout
+	struct ResourceType
+	{
+		ID3D11DeviceChild* object;
+		ID3D11ShaderResourceView* view;
+		ID3D10Blob* bytecode;
+		RenderUsage usage;
+	};
+
+	//a deferred context is either a real D3D11 deferred context or, when the driver does not support command lists, our own command buffer
+	struct DeferredContextType
+	{
+		std::unique_ptr<D3D11RenderContextClass> native;
+		std::unique_ptr<CommandBufferClass> encoded;
+	};
+
+public:
+	D3D11RenderDeviceClass();
+	D3D11RenderDeviceClass(const D3D11RenderDeviceClass&);
+	~D3D11RenderDeviceClass();
+
+	bool Initialize(D3DClass*, HWND);
+	void Shutdown();
+
+	//compiles a shader ahead of the device, on any thread. The bytecode waits until CreateVertexShader or CreatePixelShader asks for
+	//the same file, entry point and profile, a shader that fails here is compiled again there and reports its error like before.
+	static bool PrecompileShader(const RenderShaderDesc&);
+	static void ReleasePrecompiledShaders();
+
+	RenderHandle CreateBuffer(const RenderBufferDesc&, const void*);
+	RenderHandle CreateTexture2D(const RenderTextureDesc&, const void*, unsigned int);
+	RenderHandle CreateVertexShader(const wchar_t*, const char*);
+	RenderHandle CreatePixelShader(const wchar_t*, const char*);
+	RenderHandle CreateInputLayout(const RenderInputElementDesc*, unsigned int, RenderHandle);
+	RenderHandle CreateSamplerState(const RenderSamplerDesc&);
+	RenderHandle CreateRasterizerState(const RenderRasterizerDesc&);
+	RenderHandle CreateDepthStencilState(const RenderDepthStencilDesc&);
+	RenderHandle CreateBlendState(const RenderBlendDesc&);
+	void ReleaseResource(RenderHandle);
+
+	RenderContextClass* GetImmediateContext();
+	RenderContextClass* CreateDeferredContext();
+	void ExecuteDeferredContext(RenderContextClass*);
+	void ReleaseDeferredContext(RenderContextClass*);
+	void BeginScene(float, float, float, float);
+	void EndScene();
+
+	//used by the contexts to turn handles back into D3D objects
+	ID3D11Buffer* GetBuffer(RenderHandle);
+	bool IsDynamicBuffer(RenderHandle);
+	ID3D11ShaderResourceView* GetShaderResourceView(RenderHandle);
+	ID3D11VertexShader* GetVertexShader(RenderHandle);
+	ID3D11PixelShader* GetPixelShader(RenderHandle);
+	ID3D11InputLayout* GetInputLayout(RenderHandle);
+	ID3D11SamplerState* GetSamplerState(RenderHandle);
+	ID3D11RasterizerState* GetRasterizerState(RenderHandle);
+	ID3D11DepthStencilState* GetDepthStencilState(RenderHandle);
+	ID3D11BlendState* GetBlendState(RenderHandle);
+
+private:
+	RenderHandle AddResource(ResourceKind, ID3D11DeviceChild*, ID3D11ShaderResourceView*, ID3D10Blob*, RenderUsage);
+	ResourceType* Lookup(RenderHandle, ResourceKind);
+	static void DestroyResource(ResourceType&);
+	ID3D10Blob* CompileShader(const wchar_t*, const char*, const char*);
+	static std::string GetShaderKey(const wchar_t*, const char*, const char*);
+	void OutputShaderErrorMessage(ID3D10Blob*, const wchar_t*);
+	void PrepareDeferredContext(ID3D11DeviceContext*);
+
+private:
+	D3DClass* m_D3D;
+	ID3D11Device* m_device;
+	HWND m_hwnd;
+	D3D11RenderContextClass m_immediateContext;
+	bool m_driverCommandLists;
+	std::vector<DeferredContextType> m_deferredContexts;
+
+	//one pool per ResourceKind, m_frame counts EndScenes for the deferred releases
+	ResourcePoolClass<ResourceType> m_resources[RESOURCE_KIND_COUNT];
+	unsigned long long m_frame;
+};
+
+#endif
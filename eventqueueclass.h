@@ -0,0 +1,111 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: eventqueueclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _EVENTQUEUECLASS_H_
+#define _EVENTQUEUECLASS_H_
+
+/*
+The EventQueueClass passes events from one producer thread to one consumer thread in order, without locks. It is a ring of CAPACITY
+events, a power of two, with a running write index that only the producer moves and a running read index that only the consumer moves.
+Push writes the event and then publishes it by moving the write index with release order, Pop reads the write index with acquire order,
+so the consumer never sees an event before it is written. The two indices sit on cache lines of their own, so the threads do not fight
+over the line the other one writes.
+
+Nothing waits: Push returns false when the ring is full and Pop when it is empty, what to do then is up to the caller. Dropped events
+are counted on the producer side. The indices are 32 bits and wrap, the difference between them is still right as long as the ring is
+smaller than 2^31.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: EventQueueClass
+////////////////////////////////////////////////////////////////////////////////
+template <typename T, unsigned int CAPACITY>
+class EventQueueClass
+{
+private:
+	static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "the capacity has to be a power of two");
+	static const unsigned int MASK = CAPACITY - 1;
+
+public:
+	EventQueueClass()
+		: m_write(0)
+		, m_dropped(0)
+		, m_read(0)
+	{
+	}
+
+	//only while neither thread uses the queue
+	void Clear()
+	{
+		m_write.store(0);
+		m_read.store(0);
+		m_dropped = 0;
+		return;
+	}
+
+	//producer side: adds the event, returns false and drops it when the ring is full
+	bool Push(const T& event)
+	{
+		unsigned int write;
+
+		write = m_write.load(std::memory_order_relaxed);
+		if (write - m_read.load(std::memory_order_acquire) >= CAPACITY)
+		{
+			m_dropped++;
+			return false;
+		}
+
+		m_events[write & MASK] = event;
+		m_write.store(write + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	//producer side: how many events Push dropped
+	unsigned long long GetDroppedCount()
+	{
+		return m_dropped;
+	}
+
+	//consumer side: takes the oldest event, returns false when there is none
+	bool Pop(T& event)
+	{
+		unsigned int read;
+
+		read = m_read.load(std::memory_order_relaxed);
+		if (read == m_write.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		event = m_events[read & MASK];
+		m_read.store(read + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	//either side: the events waiting, already out of date by the time it returns
+	unsigned int GetCount()
+	{
+		return m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_acquire);
+	}
+
+private:
+	T m_events[CAPACITY];
+
+	//the producer's line
+	alignas(64) std::atomic<unsigned int> m_write;
+	unsigned long long m_dropped;
+
+	//the consumer's line
+	alignas(64) std::atomic<unsigned int> m_read;
+};
+
+#endif
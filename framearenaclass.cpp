@@ -0,0 +1,320 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framearenaclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "framearenaclass.h"
+#include <cstring>
+#include <cstdlib>
+#include <new>
+
+//every arena gets its own id so a thread's cached chunks are never mistaken for those of an arena that reused the same address
+static std::atomic<unsigned int> s_nextArenaId(1);
+
+//the calling thread's chunks of the arena it allocated from last
+static thread_local FrameArenaClass* t_arena = nullptr;
+static thread_local unsigned int t_arenaId = 0;
+static thread_local void* t_threadArena = nullptr;
+
+//BeginHotPath nesting depth of the calling thread and the operator new calls it made inside
+static thread_local int t_hotPath = 0;
+static thread_local int t_hotCount = 0;
+
+#ifdef FRAMEARENA_CHECK_NEW
+void* operator new(size_t size)
+{
+	void* pointer;
+
+	if (t_hotPath > 0)
+	{
+		t_hotCount++;
+	}
+
+	pointer = malloc(size > 0 ? size : 1);
+	if (!pointer)
+	{
+		throw std::bad_alloc();
+	}
+
+	return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete(void* pointer, size_t size) noexcept
+{
+	free(pointer);
+}
+#endif
+
+FrameArenaClass::FrameArenaClass()
+	: m_bufferCount(0)
+	, m_chunkSize(0)
+	, m_id(0)
+	, m_chunkCount(0)
+{
+}
+
+FrameArenaClass::FrameArenaClass(const FrameArenaClass& other)
+{
+}
+
+
+FrameArenaClass::~FrameArenaClass()
+{
+}
+
+bool FrameArenaClass::Initialize(int bufferCount, size_t chunkSize)
+{
+	if (bufferCount <= 0 || chunkSize == 0)
+	{
+		return false;
+	}
+
+	m_bufferCount = bufferCount;
+	m_chunkSize = chunkSize;
+	m_id = s_nextArenaId++;
+	m_chunkCount = 0;
+
+	m_hotAllocations.reset(new std::atomic<int>[bufferCount]);
+	for (auto i = 0; i < bufferCount; i++)
+	{
+		m_hotAllocations[i] = 0;
+	}
+
+	return true;
+}
+
+void FrameArenaClass::Shutdown()
+{
+	std::lock_guard<std::mutex> lock(m_threadMutex);
+
+	m_threads.clear();
+	m_hotAllocations.reset();
+	m_bufferCount = 0;
+	m_id = 0;
+
+	return;
+}
+
+/*
+Allocate bumps the offset in the calling thread's current chunk of the buffer. When the allocation does not fit it moves on to the next
+chunk, the ones after the current one are left over from bigger frames before, and only adds a new chunk once it runs out of them.
+*/
+
+void* FrameArenaClass::Allocate(int buffer, size_t size, size_t alignment)
+{
+	ThreadArenaType* thread;
+	unsigned char* base;
+	size_t start;
+
+	thread = GetThreadArena();
+	BufferType& data = thread->buffers[buffer];
+
+	if (size == 0)
+	{
+		size = 1;
+	}
+
+	while (true)
+	{
+		if (data.chunk < data.chunks.size())
+		{
+			ChunkType& chunk = data.chunks[data.chunk];
+
+			base = chunk.memory.get();
+			start = (((size_t)base + data.offset + alignment - 1) & ~(alignment - 1)) - (size_t)base;
+			if (start + size <= chunk.size)
+			{
+				data.offset = start + size;
+				data.used += size;
+				data.allocationCount++;
+#ifdef FRAMEARENA_POISON
+				memset(base + start, NEW_POISON, size);
+#endif
+				return base + start;
+			}
+
+			data.chunk++;
+			data.offset = 0;
+			continue;
+		}
+
+		AddChunk(data, size + alignment);
+	}
+}
+
+void FrameArenaClass::Reset(int buffer)
+{
+	std::lock_guard<std::mutex> lock(m_threadMutex);
+
+	for (auto& thread : m_threads)
+	{
+		BufferType& data = thread->buffers[buffer];
+
+#ifdef FRAMEARENA_POISON
+		for (size_t i = 0; i <= data.chunk && i < data.chunks.size(); i++)
+		{
+			memset(data.chunks[i].memory.get(), FREE_POISON, i < data.chunk ? data.chunks[i].size : data.offset);
+		}
+#endif
+
+		data.chunk = 0;
+		data.offset = 0;
+		data.used = 0;
+		data.allocationCount = 0;
+	}
+
+	m_hotAllocations[buffer] = 0;
+
+	return;
+}
+
+int FrameArenaClass::GetBufferCount()
+{
+	return m_bufferCount;
+}
+
+size_t FrameArenaClass::GetUsedBytes(int buffer)
+{
+	std::lock_guard<std::mutex> lock(m_threadMutex);
+	size_t used;
+
+	used = 0;
+	for (auto& thread : m_threads)
+	{
+		used += thread->buffers[buffer].used;
+	}
+
+	return used;
+}
+
+int FrameArenaClass::GetAllocationCount(int buffer)
+{
+	std::lock_guard<std::mutex> lock(m_threadMutex);
+	int count;
+
+	count = 0;
+	for (auto& thread : m_threads)
+	{
+		count += thread->buffers[buffer].allocationCount;
+	}
+
+	return count;
+}
+
+int FrameArenaClass::GetHotAllocationCount(int buffer)
+{
+	return m_hotAllocations[buffer];
+}
+
+int FrameArenaClass::GetChunkCount()
+{
+	return m_chunkCount;
+}
+
+int FrameArenaClass::GetThreadCount()
+{
+	std::lock_guard<std::mutex> lock(m_threadMutex);
+
+	return (int)m_threads.size();
+}
+
+void FrameArenaClass::BeginHotPath()
+{
+	if (t_hotPath == 0)
+	{
+		t_hotCount = 0;
+	}
+	t_hotPath++;
+
+	return;
+}
+
+void FrameArenaClass::EndHotPath(int buffer)
+{
+	t_hotPath--;
+	if (t_hotPath == 0 && t_hotCount > 0)
+	{
+		m_hotAllocations[buffer] += t_hotCount;
+	}
+
+	return;
+}
+
+//GetThreadArena finds the calling thread's chunks, registering the thread the first time. The arena's own heap use is not counted.
+
+FrameArenaClass::ThreadArenaType* FrameArenaClass::GetThreadArena()
+{
+	std::unique_ptr<ThreadArenaType> created;
+	ThreadArenaType* thread;
+	int hotPath;
+
+	if (t_arena == this && t_arenaId == m_id)
+	{
+		return (ThreadArenaType*)t_threadArena;
+	}
+
+	hotPath = t_hotPath;
+	t_hotPath = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_threadMutex);
+
+		thread = nullptr;
+		for (auto& existing : m_threads)
+		{
+			if (existing->thread == std::this_thread::get_id())
+			{
+				thread = existing.get();
+				break;
+			}
+		}
+
+		if (!thread)
+		{
+			created.reset(new ThreadArenaType);
+			created->thread = std::this_thread::get_id();
+			created->buffers.resize(m_bufferCount);
+			for (auto& data : created->buffers)
+			{
+				data.chunk = 0;
+				data.offset = 0;
+				data.used = 0;
+				data.allocationCount = 0;
+			}
+
+			thread = created.get();
+			m_threads.push_back(std::move(created));
+		}
+	}
+
+	t_hotPath = hotPath;
+
+	t_arena = this;
+	t_arenaId = m_id;
+	t_threadArena = thread;
+
+	return thread;
+}
+
+void FrameArenaClass::AddChunk(BufferType& data, size_t minimumSize)
+{
+	ChunkType chunk;
+	int hotPath;
+
+	hotPath = t_hotPath;
+	t_hotPath = 0;
+
+	chunk.size = minimumSize > m_chunkSize ? minimumSize : m_chunkSize;
+	chunk.memory.reset(new unsigned char[chunk.size]);
+
+	data.chunks.push_back(std::move(chunk));
+	data.offset = 0;
+	m_chunkCount++;
+
+	t_hotPath = hotPath;
+
+	return;
+}
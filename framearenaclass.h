@@ -0,0 +1,177 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framearenaclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FRAMEARENACLASS_H_
+#define _FRAMEARENACLASS_H_
+
+/*
+The FrameArenaClass hands out memory for data that only lives for one frame: draw lists, visible sets, sort keys, constant staging.
+Allocating is moving an offset forward in a big chunk and freeing is not done at all, the whole frame's memory is given back at once
+with Reset. Chunks are kept after a Reset, so once the arena has grown to what a frame needs it never goes to the heap again.
+
+Every thread allocates from its own chunks so threads never wait for each other. A thread gets its chunks the first time it allocates.
+
+The arena has one buffer per frame in flight (two for a double buffered pipeline). Everything allocated for a frame comes out of that
+frame's buffer, and the buffer is only Reset when the frame that used it is completely done, so a frame's data stays put while the
+next frame is already being built in the other buffer.
+
+FrameAllocatorType plugs a buffer into the standard containers, FrameVectorType is a std::vector that lives in it. Debug builds fill
+new memory with 0xCD and memory given back by Reset with 0xDD so anything still pointing into an old frame shows up quickly.
+
+Building with FRAMEARENA_CHECK_NEW defined replaces the global operator new with one that counts calls. Code between BeginHotPath and
+EndHotPath that still uses the heap then shows up in GetHotAllocationCount, and the frame can be failed for it. The arena growing its
+own chunks is not counted.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstddef>
+#include <type_traits>
+
+#if defined(_DEBUG) && !defined(FRAMEARENA_POISON)
+#define FRAMEARENA_POISON
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FrameArenaClass
+////////////////////////////////////////////////////////////////////////////////
+class FrameArenaClass
+{
+private:
+	static const unsigned char NEW_POISON = 0xCD;
+	static const unsigned char FREE_POISON = 0xDD;
+
+	struct ChunkType
+	{
+		std::unique_ptr<unsigned char[]> memory;
+		size_t size;
+	};
+
+	//one thread's chunks in one buffer, chunk and offset are where the next allocation goes
+	struct BufferType
+	{
+		std::vector<ChunkType> chunks;
+		size_t chunk;
+		size_t offset;
+		size_t used;
+		int allocationCount;
+	};
+
+	struct ThreadArenaType
+	{
+		std::thread::id thread;
+		std::vector<BufferType> buffers;
+	};
+
+public:
+	FrameArenaClass();
+	FrameArenaClass(const FrameArenaClass&);
+	~FrameArenaClass();
+
+	//bufferCount is the number of frames in flight, chunkSize how much a thread's buffer grows by at a time
+	bool Initialize(int, size_t);
+	void Shutdown();
+
+	//alignment has to be a power of two
+	void* Allocate(int, size_t, size_t);
+
+	//gives back everything allocated from the buffer on every thread, nobody may be allocating from it at the time
+	void Reset(int);
+
+	int GetBufferCount();
+
+	//statistics of one buffer since its last Reset, only exact while nobody allocates from it
+	size_t GetUsedBytes(int);
+	int GetAllocationCount(int);
+	int GetHotAllocationCount(int);
+
+	//chunks created over the arena's lifetime, stays put once every thread's buffers are big enough
+	int GetChunkCount();
+	int GetThreadCount();
+
+	//counts the operator new calls of the calling thread in between and adds them to the buffer's hot allocation count
+	void BeginHotPath();
+	void EndHotPath(int);
+
+private:
+	ThreadArenaType* GetThreadArena();
+	void AddChunk(BufferType&, size_t);
+
+private:
+	std::vector<std::unique_ptr<ThreadArenaType>> m_threads;
+	std::mutex m_threadMutex;
+	int m_bufferCount;
+	size_t m_chunkSize;
+	unsigned int m_id;
+	std::atomic<int> m_chunkCount;
+	std::unique_ptr<std::atomic<int>[]> m_hotAllocations;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FrameAllocatorType
+////////////////////////////////////////////////////////////////////////////////
+
+//Standard allocator on one buffer of a FrameArenaClass. deallocate does nothing, the memory comes back with the buffer's Reset.
+//A default constructed allocator has no arena and uses the heap, which is what containers get before a frame gives them one.
+template <typename T>
+struct FrameAllocatorType
+{
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	FrameAllocatorType() : arena(nullptr), buffer(0) {}
+	FrameAllocatorType(FrameArenaClass* frameArena, int frameBuffer) : arena(frameArena), buffer(frameBuffer) {}
+
+	template <typename U>
+	FrameAllocatorType(const FrameAllocatorType<U>& other) : arena(other.arena), buffer(other.buffer) {}
+
+	T* allocate(size_t count)
+	{
+		if (!arena)
+		{
+			return (T*)::operator new(count * sizeof(T));
+		}
+
+		return (T*)arena->Allocate(buffer, count * sizeof(T), alignof(T));
+	}
+
+	void deallocate(T* pointer, size_t count)
+	{
+		if (!arena)
+		{
+			::operator delete(pointer);
+		}
+
+		return;
+	}
+
+	template <typename U>
+	bool operator==(const FrameAllocatorType<U>& other) const
+	{
+		return arena == other.arena && buffer == other.buffer;
+	}
+
+	template <typename U>
+	bool operator!=(const FrameAllocatorType<U>& other) const
+	{
+		return !(*this == other);
+	}
+
+	FrameArenaClass* arena;
+	int buffer;
+};
+
+template <typename T>
+using FrameVectorType = std::vector<T, FrameAllocatorType<T>>;
+
+#endif
@@ -0,0 +1,450 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framedriverclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "framedriverclass.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+FrameDriverClass::FrameDriverClass()
+	: m_Device(nullptr)
+	, m_Graphics(nullptr)
+	, m_failedStep(nullptr)
+	, m_hitches(0)
+{
+}
+
+FrameDriverClass::FrameDriverClass(const FrameDriverClass& other)
+{
+}
+
+
+FrameDriverClass::~FrameDriverClass()
+{
+}
+
+bool FrameDriverClass::Initialize(int screenWidth, int screenHeight, bool software)
+{
+	auto result = false;
+
+	m_failedStep = nullptr;
+
+	m_Graphics.reset(new GraphicsClass());
+	if (!m_Graphics)
+	{
+		return false;
+	}
+
+	if (software)
+	{
+		// The rasterizer gets one job system thread per core.
+		result = m_Graphics->InitializeSoftware(screenWidth, screenHeight, 0);
+		if (!result)
+		{
+			m_failedStep = m_Graphics->GetFailedStep();
+			return false;
+		}
+	}
+	else
+	{
+		m_Device.reset(new NullRenderDeviceClass());
+		if (!m_Device)
+		{
+			return false;
+		}
+
+		result = m_Device->Initialize();
+		if (!result)
+		{
+			m_failedStep = "null device";
+			return false;
+		}
+
+		result = m_Graphics->Initialize(screenWidth, screenHeight, m_Device.get());
+		if (!result)
+		{
+			m_failedStep = m_Graphics->GetFailedStep();
+			return false;
+		}
+	}
+
+	m_stageNames.clear();
+	for (auto i = 0; i < m_Graphics->GetStageCount(); i++)
+	{
+		m_stageNames.push_back(m_Graphics->GetStageName(i));
+	}
+
+	return true;
+}
+
+void FrameDriverClass::Shutdown()
+{
+	if (m_Graphics)
+	{
+		m_Graphics->Shutdown();
+		m_Graphics.reset();
+	}
+
+	if (m_Device)
+	{
+		m_Device->Shutdown();
+		m_Device.reset();
+	}
+
+	return;
+}
+
+const char* FrameDriverClass::GetFailedStep()
+{
+	return m_failedStep;
+}
+
+const char* FrameDriverClass::GetFailedStartupTask()
+{
+	if (!m_Graphics || !m_Graphics->GetStartup())
+	{
+		return nullptr;
+	}
+
+	return m_Graphics->GetStartup()->GetFailedTask();
+}
+
+bool FrameDriverClass::LoadCameraPath(const char* filename)
+{
+	std::ifstream fin;
+	std::string line;
+	CameraKeyType key;
+
+	fin.open(filename);
+	if (fin.fail())
+	{
+		return false;
+	}
+
+	m_cameraPath.clear();
+	while (std::getline(fin, line))
+	{
+		std::istringstream in(line);
+
+		// Empty lines and # comments are skipped.
+		if (line.find_first_not_of(" \t\r") == std::string::npos || line[line.find_first_not_of(" \t\r")] == '#')
+		{
+			continue;
+		}
+
+		in >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.rotation.x >> key.rotation.y >> key.rotation.z;
+		if (in.fail())
+		{
+			m_cameraPath.clear();
+			return false;
+		}
+
+		// The keys have to come in order.
+		if (!m_cameraPath.empty() && key.time < m_cameraPath.back().time)
+		{
+			m_cameraPath.clear();
+			return false;
+		}
+
+		m_cameraPath.push_back(key);
+	}
+
+	return !m_cameraPath.empty();
+}
+
+void FrameDriverClass::SetHitchDetection(const char* dumpPrefix)
+{
+	m_hitchPrefix = dumpPrefix;
+	return;
+}
+
+bool FrameDriverClass::SetRenderStatsLog(const char* filename)
+{
+	if (!m_Graphics || !m_Graphics->GetRenderStats())
+	{
+		return false;
+	}
+
+	return m_Graphics->GetRenderStats()->OpenLog(filename);
+}
+
+bool FrameDriverClass::SetHudVisible(bool visible)
+{
+	if (!m_Graphics)
+	{
+		return false;
+	}
+
+	m_Graphics->SetHudVisible(visible);
+
+	return true;
+}
+
+/*
+Run drives the frames one at a time. Frame n is simulated at n fixed steps in and the camera is put where the path is at that time
+before the frame starts; without a frame count the run goes on until the frame that reaches the last key.
+*/
+
+bool FrameDriverClass::Run(int frameCount)
+{
+	NullRenderDeviceClass::CountersType before = {}, after = {};
+	FrameStatsType stats;
+	HitchDetectorClass hitches;
+	float time;
+	bool result;
+
+	if (!m_Graphics)
+	{
+		return false;
+	}
+
+	if (frameCount <= 0)
+	{
+		if (m_cameraPath.empty())
+		{
+			return false;
+		}
+
+		frameCount = (int)std::ceil(m_cameraPath.back().time / SIMULATION_STEP) + 1;
+	}
+
+	m_frames.clear();
+	m_stageTimes.clear();
+	m_frames.reserve(frameCount);
+	m_stageTimes.reserve((size_t)frameCount * m_stageNames.size());
+	m_hitches = 0;
+	m_Graphics->GetLatency()->Reset();
+
+	if (!m_hitchPrefix.empty())
+	{
+		result = hitches.Initialize(HITCH_WINDOW_SECONDS, HITCH_THRESHOLD_RATIO, HITCH_THRESHOLD_MS, m_hitchPrefix.c_str());
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	for (auto frame = 0; frame < frameCount; frame++)
+	{
+		time = (float)frame * SIMULATION_STEP;
+		MoveCamera(time);
+
+		if (m_Device)
+		{
+			before = m_Device->GetCounters();
+		}
+		auto start = std::chrono::high_resolution_clock::now();
+
+		m_Graphics->SetInputTime(LatencyTrackerClass::GetTime());
+		result = m_Graphics->Frame(1, 1.0f);
+		m_Graphics->Flush();
+
+		auto end = std::chrono::high_resolution_clock::now();
+		if (m_Device)
+		{
+			after = m_Device->GetCounters();
+		}
+
+		if (!result)
+		{
+			return false;
+		}
+
+		stats.frame = (unsigned long long)frame;
+		stats.time = time;
+		stats.frameMs = std::chrono::duration<float, std::milli>(end - start).count();
+		stats.draws = after.draws - before.draws;
+		stats.triangles = after.triangles - before.triangles;
+		stats.binds = after.binds - before.binds;
+		stats.bytesUploaded = after.bytesUploaded - before.bytesUploaded;
+		stats.softwareMs = m_Graphics->GetSoftwareFrameTime();
+		m_frames.push_back(stats);
+
+		for (auto i = 0; i < (int)m_stageNames.size(); i++)
+		{
+			m_stageTimes.push_back(m_Graphics->GetLastStageTime(i));
+		}
+
+		if (!m_hitchPrefix.empty())
+		{
+			hitches.SetFrameStat("draws", (float)stats.draws);
+			hitches.SetFrameStat("triangles", (float)stats.triangles);
+			hitches.SetFrameStat("binds", (float)stats.binds);
+			hitches.Frame();
+		}
+	}
+
+	m_hitches = hitches.GetHitchCount();
+	hitches.Shutdown();
+
+	return true;
+}
+
+bool FrameDriverClass::SaveFrame(const char* filename)
+{
+	if (!m_Graphics)
+	{
+		return false;
+	}
+
+	return m_Graphics->SaveFrame(filename);
+}
+
+void FrameDriverClass::WriteCSV(std::ostream& out)
+{
+	out << "frame,time,frame ms";
+	for (auto& name : m_stageNames)
+	{
+		out << "," << name << " ms";
+	}
+	out << ",draws,triangles,binds,bytes" << (m_Device ? "" : ",software ms") << std::endl;
+
+	out << std::fixed << std::setprecision(3);
+	for (auto i = 0; i < (int)m_frames.size(); i++)
+	{
+		out << m_frames[i].frame << "," << m_frames[i].time << "," << m_frames[i].frameMs;
+		for (auto j = 0; j < (int)m_stageNames.size(); j++)
+		{
+			out << "," << m_stageTimes[i * m_stageNames.size() + j];
+		}
+		out << "," << m_frames[i].draws << "," << m_frames[i].triangles << "," << m_frames[i].binds << "," << m_frames[i].bytesUploaded;
+		if (!m_Device)
+		{
+			out << "," << m_frames[i].softwareMs;
+		}
+		out << std::endl;
+	}
+
+	return;
+}
+
+void FrameDriverClass::WriteJSON(std::ostream& out)
+{
+	std::vector<float> times, softwareTimes;
+	LatencyTrackerClass::SummaryType latency;
+	float total;
+
+	total = 0.0f;
+	for (auto& frame : m_frames)
+	{
+		times.push_back(frame.frameMs);
+		softwareTimes.push_back(frame.softwareMs);
+		total += frame.frameMs;
+	}
+
+	m_Graphics->GetLatency()->GetSummary(latency);
+
+	out << std::fixed << std::setprecision(3);
+	out << "{" << std::endl;
+	out << "\t\"summary\": {\"frames\": " << m_frames.size() << ", \"average ms\": " << (m_frames.empty() ? 0.0f : total / (float)m_frames.size())
+		<< ", \"median ms\": " << GetPercentile(times, 0.5f) << ", \"95th ms\": " << GetPercentile(times, 0.95f) << ", \"99th ms\": "
+		<< GetPercentile(times, 0.99f) << ", \"max ms\": " << GetPercentile(times, 1.0f) << ", \"hitches\": " << m_hitches
+		<< ", \"latency median ms\": " << latency.medianMs << ", \"latency 99th ms\": " << latency.p99Ms << ", \"latency max frames\": "
+		<< latency.maxFrames;
+	if (m_Graphics->GetStartup())
+	{
+		out << ", \"startup ms\": " << m_Graphics->GetStartup()->GetTotalTime();
+	}
+	if (!m_Device)
+	{
+		out << ", \"software median ms\": " << GetPercentile(softwareTimes, 0.5f) << ", \"software 99th ms\": "
+			<< GetPercentile(softwareTimes, 0.99f);
+	}
+	out << "}," << std::endl;
+
+	out << "\t\"frames\": [" << std::endl;
+	for (auto i = 0; i < (int)m_frames.size(); i++)
+	{
+		out << "\t\t{\"frame\": " << m_frames[i].frame << ", \"time\": " << m_frames[i].time << ", \"frame ms\": " << m_frames[i].frameMs
+			<< ", \"stages\": {";
+		for (auto j = 0; j < (int)m_stageNames.size(); j++)
+		{
+			out << (j > 0 ? ", " : "") << "\"" << m_stageNames[j] << "\": " << m_stageTimes[i * m_stageNames.size() + j];
+		}
+		out << "}, \"draws\": " << m_frames[i].draws << ", \"triangles\": " << m_frames[i].triangles << ", \"binds\": " << m_frames[i].binds
+			<< ", \"bytes\": " << m_frames[i].bytesUploaded;
+		if (!m_Device)
+		{
+			out << ", \"software ms\": " << m_frames[i].softwareMs;
+		}
+		out << "}" << (i + 1 < (int)m_frames.size() ? "," : "") << std::endl;
+	}
+	out << "\t]" << std::endl;
+	out << "}" << std::endl;
+
+	return;
+}
+
+void FrameDriverClass::WriteLatency(std::ostream& out)
+{
+	if (m_Graphics)
+	{
+		m_Graphics->GetLatency()->WriteCSV(out);
+	}
+
+	return;
+}
+
+void FrameDriverClass::WriteStartup(std::ostream& out)
+{
+	if (m_Graphics && m_Graphics->GetStartup())
+	{
+		m_Graphics->GetStartup()->WriteTimeline(out);
+	}
+
+	return;
+}
+
+//MoveCamera puts the camera where the path is at the given time, in between two keys it is that far along the line from one to the next.
+
+void FrameDriverClass::MoveCamera(float time)
+{
+	std::shared_ptr<CameraClass> camera;
+	size_t next;
+	float t;
+
+	if (m_cameraPath.empty())
+	{
+		return;
+	}
+
+	next = 0;
+	while (next < m_cameraPath.size() && m_cameraPath[next].time <= time)
+	{
+		next++;
+	}
+
+	const CameraKeyType& to = m_cameraPath[std::min(next, m_cameraPath.size() - 1)];
+	const CameraKeyType& from = m_cameraPath[next > 0 ? next - 1 : 0];
+
+	t = to.time > from.time ? (time - from.time) / (to.time - from.time) : 0.0f;
+	t = std::max(0.0f, std::min(t, 1.0f));
+
+	camera = m_Graphics->GetCamera();
+	camera->SetPosition(from.position.x + (to.position.x - from.position.x) * t, from.position.y + (to.position.y - from.position.y) * t,
+		from.position.z + (to.position.z - from.position.z) * t);
+	camera->SetRotation(from.rotation.x + (to.rotation.x - from.rotation.x) * t, from.rotation.y + (to.rotation.y - from.rotation.y) * t,
+		from.rotation.z + (to.rotation.z - from.rotation.z) * t);
+
+	return;
+}
+
+//GetPercentile sorts the times and returns the one the given fraction of them is at or below.
+
+float FrameDriverClass::GetPercentile(std::vector<float>& times, float fraction)
+{
+	size_t index;
+
+	if (times.empty())
+	{
+		return 0.0f;
+	}
+
+	std::sort(times.begin(), times.end());
+	index = (size_t)std::ceil(fraction * (float)times.size());
+
+	return times[std::max(index, (size_t)1) - 1];
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framedriverclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FRAMEDRIVERCLASS_H_
+#define _FRAMEDRIVERCLASS_H_
+
+/*
+The FrameDriverClass runs the engine without a window, for benchmarking the whole CPU side of a frame on the build agents. It sets up
+the GraphicsClass scene on a NullRenderDeviceClass and drives it for a fixed number of frames, or for as long as a scripted camera path
+lasts, always with one fixed simulation step per frame. Nothing depends on the wall clock, so every run draws the exact same frames and
+the draw counts come out the same on every machine; only the times change.
+
+Each frame is flushed before the next one starts, so everything measured for a frame belongs to that frame: the time Frame and Flush
+took together, every task graph stage's time and what the frame sent to the device. WriteCSV writes one line per frame, WriteJSON the
+same frames plus a summary of the frame times.
+
+With hitch detection on, a HitchDetectorClass watches the frames with the frame's draws, triangles and binds as stats, and the JSON
+summary says how many hitches it found. SetRenderStatsLog writes the renderer's own per frame counters to a CSV file of their own, see
+RenderStatsClass. SetHudVisible draws the performance overlay on every frame, to see what it costs.
+
+Every frame acts on an input stamped right before it starts, as if a key went down just then, so the input to present latency of the
+frames is measured the same way the window measures a real key's, see LatencyTrackerClass. The JSON summary has its percentiles and
+WriteLatency writes them on their own.
+
+Initialize loads the scene with the same startup tasks the window does. The JSON summary has how long they took and WriteStartup writes
+their timeline, see StartupSchedulerClass.
+
+Initialized for software rendering the scene is drawn by the SoftwareRasterizerClass instead, see GraphicsClass::InitializeSoftware. There
+is no device then, so the draw, triangle, bind and byte counts are 0 and there is no startup timeline or render stats; instead the CSV
+and JSON have how long the rasterizer took for every frame, and SaveFrame writes the last frame to an image.
+
+A camera path is a text file with one key per line: the time in seconds, the position and the rotation as CameraClass takes them. The
+camera moves in a straight line from key to key and stays on the last one. Empty lines and # comments are skipped.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "graphicsclass.h"
+#include "nullrenderdeviceclass.h"
+#include "hitchdetectorclass.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <ostream>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FrameDriverClass
+////////////////////////////////////////////////////////////////////////////////
+class FrameDriverClass
+{
+private:
+	struct CameraKeyType
+	{
+		float time;
+		DirectX::XMFLOAT3 position;
+		DirectX::XMFLOAT3 rotation;
+	};
+
+	//the device counters are what this frame added to them
+	struct FrameStatsType
+	{
+		unsigned long long frame;
+		float time;
+		float frameMs;
+		unsigned long long draws;
+		unsigned long long triangles;
+		unsigned long long binds;
+		unsigned long long bytesUploaded;
+		float softwareMs;
+	};
+
+public:
+	FrameDriverClass();
+	FrameDriverClass(const FrameDriverClass&);
+	~FrameDriverClass();
+
+	//renders on the null device, or on the software rasterizer if the last argument is true
+	bool Initialize(int, int, bool);
+	void Shutdown();
+
+	//what the last Initialize failed at, nullptr if it did not fail, and the first startup task that failed if it was one of them
+	const char* GetFailedStep();
+	const char* GetFailedStartupTask();
+
+	//the path replaces the one loaded before, the camera stays where the scene put it without one
+	bool LoadCameraPath(const char*);
+
+	//turns hitch detection on for the next runs, with the dumps starting with the given prefix
+	void SetHitchDetection(const char*);
+
+	//logs every frame's render stats to the given file from the next run on, call it after Initialize
+	bool SetRenderStatsLog(const char*);
+
+	//shows or hides the performance overlay on the frames from the next run on, call it after Initialize
+	bool SetHudVisible(bool);
+
+	//runs frameCount frames, 0 runs until the end of the camera path
+	bool Run(int);
+
+	//writes the last frame to a .png or .tga file, software rendering only
+	bool SaveFrame(const char*);
+
+	void WriteCSV(std::ostream&);
+	void WriteJSON(std::ostream&);
+	void WriteLatency(std::ostream&);
+	void WriteStartup(std::ostream&);
+
+private:
+	void MoveCamera(float);
+	float GetPercentile(std::vector<float>&, float);
+
+private:
+	std::unique_ptr<NullRenderDeviceClass> m_Device;
+	std::unique_ptr<GraphicsClass> m_Graphics;
+	const char* m_failedStep;
+
+	std::vector<CameraKeyType> m_cameraPath;
+	std::string m_hitchPrefix;
+	unsigned long long m_hitches;
+
+	//the stage names and, for every frame, one time per stage
+	std::vector<std::string> m_stageNames;
+	std::vector<FrameStatsType> m_frames;
+	std::vector<float> m_stageTimes;
+};
+
+#endif
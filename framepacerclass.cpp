@@ -0,0 +1,287 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framepacerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "framepacerclass.h"
+#include <thread>
+#include <cmath>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+//Windows 10 1803 and up, older SDKs do not have the name
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+FramePacerClass::FramePacerClass()
+	: m_step(1.0 / 60.0)
+	, m_period(0.0)
+	, m_maxSteps(1)
+	, m_waitMode(WAIT_SLEEP_SPIN)
+	, m_started(false)
+	, m_accumulator(0.0)
+	, m_alpha(1.0f)
+	, m_sliceMean(0.0)
+	, m_sliceM2(0.0)
+	, m_sliceCount(0)
+	, m_sleepEstimate(0.0)
+	, m_intervalSum(0.0)
+	, m_intervalSquareSum(0.0)
+	, m_worstError(0.0)
+	, m_sleepTime(0.0)
+	, m_spinTime(0.0)
+	, m_frames(0)
+	, m_intervals(0)
+	, m_steps(0)
+	, m_droppedSteps(0)
+#ifdef _WIN32
+	, m_timer(nullptr)
+#endif
+{
+}
+
+FramePacerClass::FramePacerClass(const FramePacerClass& other)
+{
+}
+
+
+FramePacerClass::~FramePacerClass()
+{
+}
+
+bool FramePacerClass::Initialize(float step, float frameRateLimit, int maxSteps)
+{
+	if (step <= 0.0f || frameRateLimit < 0.0f || maxSteps < 1)
+	{
+		return false;
+	}
+
+	m_step = step;
+	m_period = frameRateLimit > 0.0f ? 1.0 / frameRateLimit : 0.0;
+	m_maxSteps = maxSteps;
+	m_started = false;
+	m_accumulator = 0.0;
+	m_alpha = 1.0f;
+
+	m_sliceMean = 0.0;
+	m_sliceM2 = 0.0;
+	m_sliceCount = 0;
+	m_sleepEstimate = INITIAL_ESTIMATE_MICROSECONDS / 1000000.0;
+
+#ifdef _WIN32
+	// A high resolution timer wakes up within a fraction of a millisecond, the fallback sleep is only as good as the system timer.
+	m_timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+
+	ResetStats();
+
+	return true;
+}
+
+void FramePacerClass::Shutdown()
+{
+#ifdef _WIN32
+	if (m_timer)
+	{
+		CloseHandle((HANDLE)m_timer);
+		m_timer = nullptr;
+	}
+#endif
+
+	return;
+}
+
+void FramePacerClass::SetWaitMode(WaitMode mode)
+{
+	m_waitMode = mode;
+	return;
+}
+
+/*
+BeginFrame adds the time since the last BeginFrame to the accumulator and takes whole steps out of it. The first frame has nothing to
+measure, it takes one step so there is a state to draw.
+*/
+
+int FramePacerClass::BeginFrame()
+{
+	ClockType::time_point now;
+	double interval, error;
+	int steps;
+
+	now = ClockType::now();
+
+	if (!m_started)
+	{
+		m_started = true;
+		m_lastFrame = now;
+		m_deadline = now;
+		m_accumulator = m_step;
+	}
+	else
+	{
+		interval = std::chrono::duration<double>(now - m_lastFrame).count();
+		m_lastFrame = now;
+		m_accumulator += interval;
+
+		m_intervalSum += interval;
+		m_intervalSquareSum += interval * interval;
+		m_intervals++;
+		if (m_period > 0.0)
+		{
+			error = std::fabs(interval - m_period);
+			m_worstError = std::max(m_worstError, error);
+		}
+	}
+
+	// Drop what does not fit into maxSteps steps.
+	if (m_accumulator > m_step * m_maxSteps)
+	{
+		m_droppedSteps += (unsigned long long)((m_accumulator - m_step * m_maxSteps) / m_step);
+		m_accumulator = m_step * m_maxSteps;
+	}
+
+	steps = (int)(m_accumulator / m_step);
+	m_accumulator -= steps * m_step;
+	m_alpha = (float)(m_accumulator / m_step);
+
+	m_steps += steps;
+	m_frames++;
+
+	return steps;
+}
+
+float FramePacerClass::GetAlpha()
+{
+	return m_alpha;
+}
+
+float FramePacerClass::GetStep()
+{
+	return (float)m_step;
+}
+
+void FramePacerClass::EndFrame()
+{
+	ClockType::time_point now, start;
+	double remaining;
+
+	if (m_period <= 0.0)
+	{
+		return;
+	}
+
+	// Deadlines follow each other a period apart, unless this frame is already more than a period late.
+	m_deadline += std::chrono::duration_cast<ClockType::duration>(std::chrono::duration<double>(m_period));
+	now = ClockType::now();
+	if (now > m_deadline + std::chrono::duration_cast<ClockType::duration>(std::chrono::duration<double>(m_period)))
+	{
+		m_deadline = now;
+		return;
+	}
+
+	remaining = std::chrono::duration<double>(m_deadline - now).count();
+
+	if (m_waitMode != WAIT_SPIN)
+	{
+		start = now;
+		while (remaining > 0.0 && (m_waitMode == WAIT_SLEEP || remaining > m_sleepEstimate))
+		{
+			SleepSlice();
+			now = ClockType::now();
+			remaining = std::chrono::duration<double>(m_deadline - now).count();
+		}
+		m_sleepTime += std::chrono::duration<double>(now - start).count();
+	}
+
+	start = now;
+	while (now < m_deadline)
+	{
+		std::this_thread::yield();
+		now = ClockType::now();
+	}
+	m_spinTime += std::chrono::duration<double>(now - start).count();
+
+	return;
+}
+
+void FramePacerClass::GetStats(StatsType& stats)
+{
+	double mean, variance;
+
+	mean = m_intervals > 0 ? m_intervalSum / m_intervals : 0.0;
+	variance = m_intervals > 0 ? m_intervalSquareSum / m_intervals - mean * mean : 0.0;
+
+	stats.frames = m_frames;
+	stats.steps = m_steps;
+	stats.droppedSteps = m_droppedSteps;
+	stats.averageFrameMs = (float)(mean * 1000.0);
+	stats.jitterMs = (float)(std::sqrt(std::max(variance, 0.0)) * 1000.0);
+	stats.worstErrorMs = (float)(m_worstError * 1000.0);
+	stats.sleepMs = (float)(m_sleepTime * 1000.0);
+	stats.spinMs = (float)(m_spinTime * 1000.0);
+
+	return;
+}
+
+void FramePacerClass::ResetStats()
+{
+	m_intervalSum = 0.0;
+	m_intervalSquareSum = 0.0;
+	m_worstError = 0.0;
+	m_sleepTime = 0.0;
+	m_spinTime = 0.0;
+	m_frames = 0;
+	m_intervals = 0;
+	m_steps = 0;
+	m_droppedSteps = 0;
+
+	return;
+}
+
+//SleepSlice sleeps for about a slice and feeds how long it really took into the estimate EndFrame stops sleeping at.
+
+void FramePacerClass::SleepSlice()
+{
+	ClockType::time_point start;
+
+	start = ClockType::now();
+
+#ifdef _WIN32
+	LARGE_INTEGER dueTime;
+
+	if (m_timer)
+	{
+		// Negative due times are relative, in 100 nanosecond units.
+		dueTime.QuadPart = -(LONGLONG)SLEEP_SLICE_MICROSECONDS * 10;
+		SetWaitableTimer((HANDLE)m_timer, &dueTime, 0, NULL, NULL, FALSE);
+		WaitForSingleObject((HANDLE)m_timer, INFINITE);
+	}
+	else
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds((int)SLEEP_SLICE_MICROSECONDS));
+	}
+#else
+	std::this_thread::sleep_for(std::chrono::microseconds((int)SLEEP_SLICE_MICROSECONDS));
+#endif
+
+	AddSliceTime(std::chrono::duration<double>(ClockType::now() - start).count());
+
+	return;
+}
+
+void FramePacerClass::AddSliceTime(double time)
+{
+	double delta;
+
+	m_sliceCount++;
+	delta = time - m_sliceMean;
+	m_sliceMean += delta / m_sliceCount;
+	m_sliceM2 += delta * (time - m_sliceMean);
+
+	m_sleepEstimate = m_sliceMean + (m_sliceCount > 1 ? std::sqrt(m_sliceM2 / (m_sliceCount - 1)) : 0.0);
+
+	return;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: framepacerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _FRAMEPACERCLASS_H_
+#define _FRAMEPACERCLASS_H_
+
+/*
+The FramePacerClass decouples the simulation from the frame rate and keeps the main loop from running flat out. BeginFrame measures the
+time since the last frame with the steady clock and adds it to an accumulator, then hands out as many fixed simulation steps as fit into
+it. What is left over, as a fraction of a step, is the interpolation factor: the frame is drawn that far between the state before the
+last step and the state after it, so motion stays smooth when the frame rate and the step rate do not line up. After a long stall the
+accumulator is capped at maxSteps steps and the rest of the time is dropped, so a slow frame cannot snowball into ever more steps.
+
+EndFrame waits for the frame's deadline when there is a frame rate limit. Sleeping is cheap but wakes up late by however coarse the OS
+timer is, spinning is exact but burns a core, so by default it sleeps in short slices for as long as the rest of the wait is longer than
+the slices are taking (their mean plus one standard deviation, measured as it goes) and spins the last bit. On Windows the slices are a
+high resolution waitable timer where there is one. A frame that misses its deadline by more than a whole frame starts the schedule over
+instead of rushing to catch up.
+
+Nothing in here needs a window, so the same pacing runs headless to measure its jitter and CPU use.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: FramePacerClass
+////////////////////////////////////////////////////////////////////////////////
+class FramePacerClass
+{
+public:
+	enum WaitMode
+	{
+		WAIT_SPIN,
+		WAIT_SLEEP,
+		WAIT_SLEEP_SPIN
+	};
+
+	//frame intervals are the times between BeginFrame calls, the error is how far one was off the frame rate limit
+	struct StatsType
+	{
+		unsigned long long frames;
+		unsigned long long steps;
+		unsigned long long droppedSteps;
+		float averageFrameMs;
+		float jitterMs;
+		float worstErrorMs;
+		float sleepMs;
+		float spinMs;
+	};
+
+private:
+	typedef std::chrono::steady_clock ClockType;
+
+	//how long a sleep slice asks for, and what the estimate starts out from before any slice was measured
+	static const int SLEEP_SLICE_MICROSECONDS = 1000;
+	static const int INITIAL_ESTIMATE_MICROSECONDS = 2000;
+
+public:
+	FramePacerClass();
+	FramePacerClass(const FramePacerClass&);
+	~FramePacerClass();
+
+	//the simulation step in seconds, the frame rate limit in frames per second (0 = no limit) and the most steps one frame may take
+	bool Initialize(float, float, int);
+	void Shutdown();
+	void SetWaitMode(WaitMode);
+
+	//returns how many simulation steps to run this frame, GetAlpha how far to interpolate past the state before the last one
+	int BeginFrame();
+	float GetAlpha();
+	float GetStep();
+
+	//waits for the next frame's deadline
+	void EndFrame();
+
+	void GetStats(StatsType&);
+	void ResetStats();
+
+private:
+	void SleepSlice();
+	void AddSliceTime(double);
+
+private:
+	double m_step;
+	double m_period;
+	int m_maxSteps;
+	WaitMode m_waitMode;
+
+	bool m_started;
+	ClockType::time_point m_lastFrame;
+	ClockType::time_point m_deadline;
+	double m_accumulator;
+	float m_alpha;
+
+	//running mean and variance of the sleep slices (Welford), in seconds
+	double m_sliceMean;
+	double m_sliceM2;
+	unsigned long long m_sliceCount;
+	double m_sleepEstimate;
+
+	//frame interval sums for the stats, in seconds
+	double m_intervalSum;
+	double m_intervalSquareSum;
+	double m_worstError;
+	double m_sleepTime;
+	double m_spinTime;
+	unsigned long long m_frames;
+	unsigned long long m_intervals;
+	unsigned long long m_steps;
+	unsigned long long m_droppedSteps;
+
+#ifdef _WIN32
+	void* m_timer;
+#endif
+};
+
+#endif
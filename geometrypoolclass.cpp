@@ -0,0 +1,365 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: geometrypoolclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "geometrypoolclass.h"
+#include <algorithm>
+#include <cstring>
+
+GeometryPoolClass::GeometryPoolClass()
+	: m_device(nullptr)
+	, m_vertexBuffer(RENDER_NULL_HANDLE)
+	, m_indexBuffer(RENDER_NULL_HANDLE)
+	, m_vertexStride(0)
+	, m_meshCount(0)
+	, m_maxMeshes(0)
+{
+	m_vertexDirty.begin = m_vertexDirty.end = 0;
+	m_indexDirty.begin = m_indexDirty.end = 0;
+}
+
+GeometryPoolClass::GeometryPoolClass(const GeometryPoolClass& other)
+{
+}
+
+
+GeometryPoolClass::~GeometryPoolClass()
+{
+}
+
+bool GeometryPoolClass::Initialize(RenderDeviceClass* device, int vertexStride, int vertexCapacity, int indexCapacity, int maxMeshes)
+{
+	RenderBufferDesc vertexBufferDesc, indexBufferDesc;
+	bool result;
+
+	if (vertexStride <= 0 || vertexCapacity <= 0 || indexCapacity <= 0 || maxMeshes <= 0)
+	{
+		return false;
+	}
+
+	m_device = device;
+	m_vertexStride = vertexStride;
+
+	// Every mesh can split a free range in two, so each allocator needs about two ranges per mesh.
+	result = m_vertexAllocator.Initialize((unsigned int)vertexCapacity, (unsigned int)maxMeshes * 2 + 2);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = m_indexAllocator.Initialize((unsigned int)indexCapacity, (unsigned int)maxMeshes * 2 + 2);
+	if (!result)
+	{
+		return false;
+	}
+
+	m_vertexData.reset(new unsigned char[(size_t)vertexCapacity * vertexStride]);
+	m_indexData.reset(new unsigned int[indexCapacity]);
+	memset(m_vertexData.get(), 0, (size_t)vertexCapacity * vertexStride);
+	memset(m_indexData.get(), 0, (size_t)indexCapacity * sizeof(unsigned int));
+
+	m_vertexDirty.begin = m_vertexDirty.end = 0;
+	m_indexDirty.begin = m_indexDirty.end = 0;
+
+	m_meshes.clear();
+	m_freeMeshes.clear();
+	m_meshCount = 0;
+	m_maxMeshes = maxMeshes;
+
+	if (!m_device)
+	{
+		return true;
+	}
+
+	// Default usage: the buffers only change when meshes are added or moved, and then only in the ranges that changed. They start out
+	// without data, Upload fills in what is used.
+	memset(&vertexBufferDesc, 0, sizeof(vertexBufferDesc));
+	vertexBufferDesc.usage = RENDER_USAGE_DEFAULT;
+	vertexBufferDesc.byteWidth = (unsigned int)vertexCapacity * vertexStride;
+	vertexBufferDesc.bindType = RENDER_BIND_VERTEX_BUFFER;
+
+	m_vertexBuffer = m_device->CreateBuffer(vertexBufferDesc, nullptr);
+	if (m_vertexBuffer == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	memset(&indexBufferDesc, 0, sizeof(indexBufferDesc));
+	indexBufferDesc.usage = RENDER_USAGE_DEFAULT;
+	indexBufferDesc.byteWidth = (unsigned int)indexCapacity * sizeof(unsigned int);
+	indexBufferDesc.bindType = RENDER_BIND_INDEX_BUFFER;
+
+	m_indexBuffer = m_device->CreateBuffer(indexBufferDesc, nullptr);
+	if (m_indexBuffer == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void GeometryPoolClass::Shutdown()
+{
+	if (m_device)
+	{
+		m_device->ReleaseResource(m_indexBuffer);
+		m_device->ReleaseResource(m_vertexBuffer);
+	}
+
+	m_indexBuffer = RENDER_NULL_HANDLE;
+	m_vertexBuffer = RENDER_NULL_HANDLE;
+	m_device = nullptr;
+
+	m_vertexAllocator.Shutdown();
+	m_indexAllocator.Shutdown();
+	m_vertexData.reset();
+	m_indexData.reset();
+	m_meshes.clear();
+	m_freeMeshes.clear();
+	m_meshCount = 0;
+
+	return;
+}
+
+int GeometryPoolClass::AddMesh(const void* vertices, int vertexCount, const unsigned int* indices, int indexCount)
+{
+	EntryType entry;
+	int id;
+
+	if (!vertices || !indices || vertexCount <= 0 || indexCount <= 0 || m_meshCount >= m_maxMeshes)
+	{
+		return -1;
+	}
+
+	// An index outside the mesh would read some other mesh's vertices.
+	for (auto i = 0; i < indexCount; i++)
+	{
+		if (indices[i] >= (unsigned int)vertexCount)
+		{
+			return -1;
+		}
+	}
+
+	entry.vertices = m_vertexAllocator.Allocate((unsigned int)vertexCount);
+	if (entry.vertices.offset == OffsetAllocatorClass::NO_SPACE)
+	{
+		return -1;
+	}
+
+	entry.indices = m_indexAllocator.Allocate((unsigned int)indexCount);
+	if (entry.indices.offset == OffsetAllocatorClass::NO_SPACE)
+	{
+		m_vertexAllocator.Free(entry.vertices);
+		return -1;
+	}
+
+	entry.used = true;
+	entry.vertexCount = vertexCount;
+	entry.indexCount = indexCount;
+
+	memcpy(m_vertexData.get() + (size_t)entry.vertices.offset * m_vertexStride, vertices, (size_t)vertexCount * m_vertexStride);
+	memcpy(m_indexData.get() + entry.indices.offset, indices, (size_t)indexCount * sizeof(unsigned int));
+	MarkDirty(m_vertexDirty, entry.vertices.offset, entry.vertices.offset + vertexCount);
+	MarkDirty(m_indexDirty, entry.indices.offset, entry.indices.offset + indexCount);
+
+	if (!m_freeMeshes.empty())
+	{
+		id = m_freeMeshes.back();
+		m_freeMeshes.pop_back();
+		m_meshes[id] = entry;
+	}
+	else
+	{
+		id = (int)m_meshes.size();
+		m_meshes.push_back(entry);
+	}
+
+	m_meshCount++;
+
+	return id;
+}
+
+void GeometryPoolClass::RemoveMesh(int id)
+{
+	if (id < 0 || id >= (int)m_meshes.size() || !m_meshes[id].used)
+	{
+		return;
+	}
+
+	m_vertexAllocator.Free(m_meshes[id].vertices);
+	m_indexAllocator.Free(m_meshes[id].indices);
+	m_meshes[id].used = false;
+	m_freeMeshes.push_back(id);
+	m_meshCount--;
+
+	return;
+}
+
+bool GeometryPoolClass::GetMesh(int id, MeshType& mesh)
+{
+	if (id < 0 || id >= (int)m_meshes.size() || !m_meshes[id].used)
+	{
+		return false;
+	}
+
+	mesh.indexCount = m_meshes[id].indexCount;
+	mesh.startIndex = (int)m_meshes[id].indices.offset;
+	mesh.baseVertex = (int)m_meshes[id].vertices.offset;
+	mesh.vertexCount = m_meshes[id].vertexCount;
+
+	return true;
+}
+
+bool GeometryPoolClass::Upload(RenderContextClass* context)
+{
+	bool result;
+
+	if (!m_device)
+	{
+		m_vertexDirty.begin = m_vertexDirty.end = 0;
+		m_indexDirty.begin = m_indexDirty.end = 0;
+		return true;
+	}
+
+	if (m_vertexDirty.end > m_vertexDirty.begin)
+	{
+		result = context->UpdateBufferRegion(m_vertexBuffer, m_vertexDirty.begin * m_vertexStride,
+			m_vertexData.get() + (size_t)m_vertexDirty.begin * m_vertexStride, (m_vertexDirty.end - m_vertexDirty.begin) * m_vertexStride);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	if (m_indexDirty.end > m_indexDirty.begin)
+	{
+		result = context->UpdateBufferRegion(m_indexBuffer, m_indexDirty.begin * sizeof(unsigned int), m_indexData.get() + m_indexDirty.begin,
+			(m_indexDirty.end - m_indexDirty.begin) * sizeof(unsigned int));
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	m_vertexDirty.begin = m_vertexDirty.end = 0;
+	m_indexDirty.begin = m_indexDirty.end = 0;
+
+	return true;
+}
+
+void GeometryPoolClass::Bind(RenderContextClass* context)
+{
+	context->SetVertexBuffer(0, m_vertexBuffer, (unsigned int)m_vertexStride, 0);
+	context->SetIndexBuffer(m_indexBuffer, RENDER_FORMAT_R32_UINT, 0);
+	return;
+}
+
+/*
+Defragment reallocates every mesh from a freshly reset allocator in the order the meshes already sit in the buffer. A reset allocator
+hands out ranges back to back from offset 0, so the meshes end up packed in the same order, each one at or before where it was. That
+means moving them front to back never overwrites a mesh that has not moved yet. Vertices and indices are packed separately.
+*/
+
+int GeometryPoolClass::Defragment()
+{
+	std::vector<int> order;
+	std::vector<bool> moved(m_meshes.size(), false);
+	OffsetAllocatorClass::AllocationType allocation;
+
+	for (auto i = 0; i < (int)m_meshes.size(); i++)
+	{
+		if (m_meshes[i].used)
+		{
+			order.push_back(i);
+		}
+	}
+
+	std::sort(order.begin(), order.end(), [this](int a, int b) { return m_meshes[a].vertices.offset < m_meshes[b].vertices.offset; });
+	m_vertexAllocator.Reset();
+	for (auto id : order)
+	{
+		EntryType& entry = m_meshes[id];
+
+		allocation = m_vertexAllocator.Allocate((unsigned int)entry.vertexCount);
+		if (allocation.offset != entry.vertices.offset)
+		{
+			memmove(m_vertexData.get() + (size_t)allocation.offset * m_vertexStride, m_vertexData.get() + (size_t)entry.vertices.offset * m_vertexStride,
+				(size_t)entry.vertexCount * m_vertexStride);
+			MarkDirty(m_vertexDirty, allocation.offset, allocation.offset + entry.vertexCount);
+			moved[id] = true;
+		}
+		entry.vertices = allocation;
+	}
+
+	std::sort(order.begin(), order.end(), [this](int a, int b) { return m_meshes[a].indices.offset < m_meshes[b].indices.offset; });
+	m_indexAllocator.Reset();
+	for (auto id : order)
+	{
+		EntryType& entry = m_meshes[id];
+
+		allocation = m_indexAllocator.Allocate((unsigned int)entry.indexCount);
+		if (allocation.offset != entry.indices.offset)
+		{
+			memmove(m_indexData.get() + allocation.offset, m_indexData.get() + entry.indices.offset, (size_t)entry.indexCount * sizeof(unsigned int));
+			MarkDirty(m_indexDirty, allocation.offset, allocation.offset + entry.indexCount);
+			moved[id] = true;
+		}
+		entry.indices = allocation;
+	}
+
+	return (int)std::count(moved.begin(), moved.end(), true);
+}
+
+int GeometryPoolClass::GetVertexStride()
+{
+	return m_vertexStride;
+}
+
+int GeometryPoolClass::GetMeshCount()
+{
+	return m_meshCount;
+}
+
+unsigned int GeometryPoolClass::GetFreeVertices()
+{
+	return m_vertexAllocator.GetFreeSpace();
+}
+
+unsigned int GeometryPoolClass::GetFreeIndices()
+{
+	return m_indexAllocator.GetFreeSpace();
+}
+
+unsigned int GeometryPoolClass::GetLargestFreeVertices()
+{
+	return m_vertexAllocator.GetLargestFreeRegion();
+}
+
+int GeometryPoolClass::GetFreeRegionCount()
+{
+	return m_vertexAllocator.GetFreeRegionCount() + m_indexAllocator.GetFreeRegionCount();
+}
+
+const unsigned char* GeometryPoolClass::GetVertexData()
+{
+	return m_vertexData.get();
+}
+
+const unsigned int* GeometryPoolClass::GetIndexData()
+{
+	return m_indexData.get();
+}
+
+void GeometryPoolClass::MarkDirty(DirtyRangeType& range, unsigned int begin, unsigned int end)
+{
+	if (range.end <= range.begin)
+	{
+		range.begin = begin;
+		range.end = end;
+		return;
+	}
+
+	range.begin = std::min(range.begin, begin);
+	range.end = std::max(range.end, end);
+
+	return;
+}
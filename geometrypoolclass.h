@@ -0,0 +1,118 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: geometrypoolclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _GEOMETRYPOOLCLASS_H_
+#define _GEOMETRYPOOLCLASS_H_
+
+/*
+The GeometryPoolClass keeps the vertices and indices of all static meshes in one big vertex buffer and one big index buffer. Every mesh
+gets a range of each from an OffsetAllocatorClass and is drawn with DrawIndexed using its start index and base vertex, so all meshes of
+the pool share one input assembler binding: Bind once, then draw any number of different meshes without touching the buffers again.
+
+The pool keeps a copy of both buffers in system memory. Adding a mesh writes into the copy and marks the range dirty, Upload sends the
+dirty ranges to the device. The copy is also what Defragment moves the meshes around in: it packs them to the front of the buffers so
+the free space is one range again, and the next Upload sends what moved. Mesh ids stay the same, their offsets do not, so look a mesh up
+with GetMesh when drawing it rather than keeping its offsets around.
+
+Without a device (Initialize with nullptr) the pool does everything except creating and uploading the buffers.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+#include "offsetallocatorclass.h"
+#include <vector>
+#include <memory>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: GeometryPoolClass
+////////////////////////////////////////////////////////////////////////////////
+class GeometryPoolClass
+{
+public:
+	//what DrawIndexed needs for one mesh
+	struct MeshType
+	{
+		int indexCount;
+		int startIndex;
+		int baseVertex;
+		int vertexCount;
+	};
+
+private:
+	struct EntryType
+	{
+		bool used;
+		OffsetAllocatorClass::AllocationType vertices;
+		OffsetAllocatorClass::AllocationType indices;
+		int vertexCount;
+		int indexCount;
+	};
+
+	//the lowest and highest element written since the last Upload
+	struct DirtyRangeType
+	{
+		unsigned int begin;
+		unsigned int end;
+	};
+
+public:
+	GeometryPoolClass();
+	GeometryPoolClass(const GeometryPoolClass&);
+	~GeometryPoolClass();
+
+	//device (may be nullptr), vertex stride in bytes, vertex capacity, index capacity and the most meshes the pool holds at once
+	bool Initialize(RenderDeviceClass*, int, int, int, int);
+	void Shutdown();
+
+	//returns the mesh id, or -1 when there is no room left. Indices are relative to the mesh's own first vertex.
+	int AddMesh(const void*, int, const unsigned int*, int);
+	void RemoveMesh(int);
+	bool GetMesh(int, MeshType&);
+
+	//sends everything written since the last Upload to the device, on the thread that owns the context
+	bool Upload(RenderContextClass*);
+
+	//binds the pool's vertex and index buffers, every mesh of the pool can be drawn after that
+	void Bind(RenderContextClass*);
+
+	//packs the meshes to the front of the buffers, returns how many of them moved. Needs an Upload before the next draw.
+	int Defragment();
+
+	int GetVertexStride();
+	int GetMeshCount();
+	unsigned int GetFreeVertices();
+	unsigned int GetFreeIndices();
+	unsigned int GetLargestFreeVertices();
+	int GetFreeRegionCount();
+
+	//the system memory copies, for checking what a draw would read
+	const unsigned char* GetVertexData();
+	const unsigned int* GetIndexData();
+
+private:
+	void MarkDirty(DirtyRangeType&, unsigned int, unsigned int);
+
+private:
+	RenderDeviceClass* m_device;
+	RenderHandle m_vertexBuffer;
+	RenderHandle m_indexBuffer;
+	int m_vertexStride;
+
+	OffsetAllocatorClass m_vertexAllocator;
+	OffsetAllocatorClass m_indexAllocator;
+	std::unique_ptr<unsigned char[]> m_vertexData;
+	std::unique_ptr<unsigned int[]> m_indexData;
+	DirtyRangeType m_vertexDirty;
+	DirtyRangeType m_indexDirty;
+
+	std::vector<EntryType> m_meshes;
+	std::vector<int> m_freeMeshes;
+	int m_meshCount;
+	int m_maxMeshes;
+};
+
+#endif
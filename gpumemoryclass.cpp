@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: gpumemoryclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "gpumemoryclass.h"
+#include <atomic>
+
+//every GpuMemoryClass gets its own number for the top half of its keys
+static std::atomic<unsigned int> s_nextDevice(1);
+
+GpuMemoryClass::GpuMemoryClass()
+	: m_device(nullptr)
+	, m_keyBase(0)
+{
+}
+
+GpuMemoryClass::GpuMemoryClass(const GpuMemoryClass& other)
+{
+}
+
+
+GpuMemoryClass::~GpuMemoryClass()
+{
+}
+
+bool GpuMemoryClass::Initialize(RenderDeviceClass* device)
+{
+	if (!device)
+	{
+		return false;
+	}
+
+	m_device = device;
+	m_keyBase = (unsigned long long)s_nextDevice++ << 32;
+
+	return true;
+}
+
+//Shutdown leaves the resources that were not released tracked, they are what the leak report lists.
+
+void GpuMemoryClass::Shutdown()
+{
+	m_device = nullptr;
+	return;
+}
+
+unsigned long long GpuMemoryClass::GetTextureBytes(const RenderTextureDesc& desc)
+{
+	unsigned long long bytes, pixelBytes;
+	unsigned int width, height;
+
+	switch (desc.format)
+	{
+	case RENDER_FORMAT_R32G32_FLOAT:
+		pixelBytes = 8;
+		break;
+	case RENDER_FORMAT_R32G32B32_FLOAT:
+		pixelBytes = 12;
+		break;
+	case RENDER_FORMAT_R32G32B32A32_FLOAT:
+		pixelBytes = 16;
+		break;
+	case RENDER_FORMAT_R16_UINT:
+		pixelBytes = 2;
+		break;
+	default:
+		pixelBytes = 4;
+		break;
+	}
+
+	// Every mip level down to 1x1, a mip chain adds about a third.
+	width = desc.width;
+	height = desc.height;
+	bytes = (unsigned long long)width * height * pixelBytes;
+	while (desc.generateMips && (width > 1 || height > 1))
+	{
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+		bytes += (unsigned long long)width * height * pixelBytes;
+	}
+
+	return bytes;
+}
+
+RenderHandle GpuMemoryClass::CreateBuffer(const RenderBufferDesc& desc, const void* data)
+{
+	return TrackCreated(m_device->CreateBuffer(desc, data), desc.byteWidth);
+}
+
+RenderHandle GpuMemoryClass::CreateTexture2D(const RenderTextureDesc& desc, const void* data, unsigned int rowPitch)
+{
+	return TrackCreated(m_device->CreateTexture2D(desc, data, rowPitch), GetTextureBytes(desc));
+}
+
+RenderHandle GpuMemoryClass::CreateVertexShader(const wchar_t* filename, const char* entryPoint)
+{
+	return TrackCreated(m_device->CreateVertexShader(filename, entryPoint), 0);
+}
+
+RenderHandle GpuMemoryClass::CreatePixelShader(const wchar_t* filename, const char* entryPoint)
+{
+	return TrackCreated(m_device->CreatePixelShader(filename, entryPoint), 0);
+}
+
+RenderHandle GpuMemoryClass::CreateInputLayout(const RenderInputElementDesc* elements, unsigned int elementCount, RenderHandle vertexShader)
+{
+	return TrackCreated(m_device->CreateInputLayout(elements, elementCount, vertexShader), 0);
+}
+
+RenderHandle GpuMemoryClass::CreateSamplerState(const RenderSamplerDesc& desc)
+{
+	return TrackCreated(m_device->CreateSamplerState(desc), 0);
+}
+
+RenderHandle GpuMemoryClass::CreateRasterizerState(const RenderRasterizerDesc& desc)
+{
+	return TrackCreated(m_device->CreateRasterizerState(desc), 0);
+}
+
+RenderHandle GpuMemoryClass::CreateDepthStencilState(const RenderDepthStencilDesc& desc)
+{
+	return TrackCreated(m_device->CreateDepthStencilState(desc), 0);
+}
+
+RenderHandle GpuMemoryClass::CreateBlendState(const RenderBlendDesc& desc)
+{
+	return TrackCreated(m_device->CreateBlendState(desc), 0);
+}
+
+void GpuMemoryClass::ReleaseResource(RenderHandle handle)
+{
+	if (handle == RENDER_NULL_HANDLE)
+	{
+		return;
+	}
+
+	MemoryTrackerClass::Untrack(MEMORY_GPU, m_keyBase | handle);
+	m_device->ReleaseResource(handle);
+
+	return;
+}
+
+RenderContextClass* GpuMemoryClass::GetImmediateContext()
+{
+	return m_device->GetImmediateContext();
+}
+
+RenderContextClass* GpuMemoryClass::CreateDeferredContext()
+{
+	return m_device->CreateDeferredContext();
+}
+
+void GpuMemoryClass::ExecuteDeferredContext(RenderContextClass* context)
+{
+	m_device->ExecuteDeferredContext(context);
+	return;
+}
+
+void GpuMemoryClass::ReleaseDeferredContext(RenderContextClass* context)
+{
+	m_device->ReleaseDeferredContext(context);
+	return;
+}
+
+void GpuMemoryClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	m_device->BeginScene(red, green, blue, alpha);
+	return;
+}
+
+void GpuMemoryClass::EndScene()
+{
+	m_device->EndScene();
+	return;
+}
+
+RenderHandle GpuMemoryClass::TrackCreated(RenderHandle handle, unsigned long long bytes)
+{
+	if (handle != RENDER_NULL_HANDLE)
+	{
+		MemoryTrackerClass::Track(MEMORY_GPU, m_keyBase | handle, bytes);
+	}
+
+	return handle;
+}
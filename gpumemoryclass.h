@@ -0,0 +1,70 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: gpumemoryclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _GPUMEMORYCLASS_H_
+#define _GPUMEMORYCLASS_H_
+
+/*
+The GpuMemoryClass accounts for the GPU memory the engine's resources take. Like the RenderStatsClass it is a render device in front of
+the real one that passes every call on; the resources it creates are tracked in the MemoryTrackerClass's GPU pool under the creating
+thread's MEMORY_SCOPE, and untracked when they are released. A buffer takes its byte width and a texture its pixels, with the whole mip
+chain when it has one. Shaders, input layouts and state objects are tracked at 0 bytes, the interface does not say what the driver
+makes of them, so they still show up in the counts and in the leak report.
+
+The contexts are the real device's, nothing is counted while drawing. Keys are the handle and a number per GpuMemoryClass, so two
+devices never mix up their resources.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+#include "memorytrackerclass.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: GpuMemoryClass
+////////////////////////////////////////////////////////////////////////////////
+class GpuMemoryClass : public RenderDeviceClass
+{
+public:
+	GpuMemoryClass();
+	GpuMemoryClass(const GpuMemoryClass&);
+	~GpuMemoryClass();
+
+	//the device the calls are passed on to, it has to outlive this one
+	bool Initialize(RenderDeviceClass*);
+	void Shutdown();
+
+	//the bytes a texture of the given description takes
+	static unsigned long long GetTextureBytes(const RenderTextureDesc&);
+
+	//RenderDeviceClass
+	RenderHandle CreateBuffer(const RenderBufferDesc&, const void*);
+	RenderHandle CreateTexture2D(const RenderTextureDesc&, const void*, unsigned int);
+	RenderHandle CreateVertexShader(const wchar_t*, const char*);
+	RenderHandle CreatePixelShader(const wchar_t*, const char*);
+	RenderHandle CreateInputLayout(const RenderInputElementDesc*, unsigned int, RenderHandle);
+	RenderHandle CreateSamplerState(const RenderSamplerDesc&);
+	RenderHandle CreateRasterizerState(const RenderRasterizerDesc&);
+	RenderHandle CreateDepthStencilState(const RenderDepthStencilDesc&);
+	RenderHandle CreateBlendState(const RenderBlendDesc&);
+	void ReleaseResource(RenderHandle);
+
+	RenderContextClass* GetImmediateContext();
+	RenderContextClass* CreateDeferredContext();
+	void ExecuteDeferredContext(RenderContextClass*);
+	void ReleaseDeferredContext(RenderContextClass*);
+	void BeginScene(float, float, float, float);
+	void EndScene();
+
+private:
+	RenderHandle TrackCreated(RenderHandle, unsigned long long);
+
+private:
+	RenderDeviceClass* m_device;
+	unsigned long long m_keyBase;
+};
+
+#endif
@@ -1,14 +1,57 @@
 #include "graphicsclass.h"
+#include "profilerclass.h"
+#include <cstring>
+#include <cfloat>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <strings.h>
+#define _stricmp strcasecmp
+#endif
 
 
 
 GraphicsClass::GraphicsClass()
+#ifdef _WIN32
 	: m_D3D(nullptr)
-	, m_Model(nullptr)
+	, m_D3DDevice(nullptr)
 	, m_TextureShader(nullptr)
+	, m_Device(nullptr)
+#else
+	: m_Device(nullptr)
+#endif
+	, m_GpuMemory(nullptr)
+	, m_RenderStats(nullptr)
+	, m_Recorder(nullptr)
+	, m_SceneGraph(nullptr)
+	, m_GeometryPool(nullptr)
+	, m_Model(nullptr)
 	, m_Camera(nullptr)
 	, m_LightShader(nullptr)
 	, m_Light(nullptr)
+	, m_ImmediateGeometry(nullptr)
+	, m_SpriteBatch(nullptr)
+	, m_PerfHud(nullptr)
+	, m_hudVisible(PERF_HUD_VISIBLE)
+	, m_hudWasVisible(false)
+	, m_hudFrames(0)
+	, m_hudMs(0.0f)
+	, m_JobSystem(nullptr)
+	, m_TaskGraph(nullptr)
+	, m_FrameArena(nullptr)
+	, m_cameraStage(-1)
+	, m_frameFailed(false)
+	, m_Software(nullptr)
+	, m_softwareTexture(-1)
+	, m_failedStep(nullptr)
+	, m_rotation(0.0f)
+	, m_previousRotation(0.0f)
+	, m_turntableNode(-1)
+	, m_modelNode(-1)
+	, m_frame(0)
+	, m_inputTime(0)
+	, m_Latency(nullptr)
+	, m_Startup(nullptr)
 {
 }
 
@@ -23,82 +66,357 @@ GraphicsClass::~GraphicsClass()
 }
 
 
+#ifdef _WIN32
 bool GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 {
 	auto result = false;
 
-	//create the Direct3D object
-	m_D3D.reset(new D3DClass());
-	if (!m_D3D)
+	//Direct3D is created by the scene's first startup task, so the model and shaders load while the driver sets up the device
+	auto createDevice = [this, screenWidth, screenHeight, hwnd]()
+	{
+		auto result = false;
+
+		//create the Direct3D object
+		m_D3D.reset(new D3DClass());
+		if (!m_D3D)
+		{
+			return false;
+		}
+
+		//initialize direct3d object
+		result = m_D3D->Initialize(screenWidth, screenHeight, VSYNC_ENABLED, hwnd, FULL_SCREEN, SCREEN_DEPTH, SCREEN_NEAR);
+		if (!result)
+		{
+			MessageBox(hwnd, L"Could not initialize Direct3D", L"Error", MB_OK);
+			return false;
+		}
+
+		//create the render device that creates and draws everything else on the Direct3D device
+		m_D3DDevice.reset(new D3D11RenderDeviceClass());
+		if (!m_D3DDevice)
+		{
+			return false;
+		}
+
+		result = m_D3DDevice->Initialize(m_D3D.get(), hwnd);
+		if (!result)
+		{
+			MessageBox(hwnd, L"Could not initialize the render device.", L"Error", MB_OK);
+			return false;
+		}
+
+		m_Device = m_D3DDevice.get();
+
+		return true;
+	};
+
+	/*
+
+	// Create the texture shader object.
+	m_TextureShader.reset(new TextureShaderClass());
+	if (!m_TextureShader)
 	{
 		return false;
 	}
+	//init the texture shader object
+	result = m_TextureShader->Initialize(m_D3D->GetDevice(), hwnd);
+	if (!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the color shader object.", L"Error", MB_OK);
+		return false;
+	}
+	*/
 
-	//initialize direct3d object
-	result = m_D3D->Initialize(screenWidth, screenHeight, VSYNC_ENABLED, hwnd, FULL_SCREEN, SCREEN_DEPTH, SCREEN_NEAR);
+	result = InitializeScene(screenWidth, screenHeight, createDevice);
 	if (!result)
 	{
-		MessageBox(hwnd, L"Could not initialize Direct3D", L"Error", MB_OK);
+		MessageBox(hwnd, L"Could not initialize the scene.", L"Error", MB_OK);
 		return false;
 	}
 
+	//the overlay is drawn with the Direct3D object's own ortho matrix
+	m_D3D->GetOrthoMatrix(m_orthoMatrix);
+
+	return true;
+}
+#endif
 
+//This Initialize renders the scene on a device created by the caller, such as a NullRenderDeviceClass. The device has to outlive the GraphicsClass.
 
-	//create the camera object
-	m_Camera.reset(new CameraClass());
-	if (!m_Camera)
+bool GraphicsClass::Initialize(int screenWidth, int screenHeight, RenderDeviceClass* device)
+{
+	if (!device)
 	{
 		return false;
 	}
 
-	//set the initial position of the camera
-	m_Camera->SetPosition(0.0f, 0.0f, -100.0f);
-	m_Camera->SetRotation(0.0f, 0.0f, 0.0f);
+	m_Device = device;
 
-	//create the model object
+	return InitializeScene(screenWidth, screenHeight, nullptr);
+}
+
+/*
+InitializeScene creates the camera, model, shader and light on m_Device. It only talks to the device through the RenderDeviceClass
+interface. createDevice, when there is one, creates the device and sets m_Device.
+
+The loading is a set of startup tasks. The model file is parsed, its texture decoded and the shaders compiled as separate jobs on the
+job system while the device is created. Everything that creates something on the device runs on this thread one task at a time after the
+device task, see StartupSchedulerClass: the state cache, recorder and geometry pool wait for the device alone, the model's buffers and
+texture for the pool, the model parse and the texture decode, the upload for the model, and every shader for the state cache and its own compile. Each task
+sets its own memory scope since a scope only covers the thread it was opened on.
+*/
+
+bool GraphicsClass::InitializeScene(int screenWidth, int screenHeight, const StartupSchedulerClass::TaskFunctionType& createDevice)
+{
+	int device, modelParse, textureDecode, lightCompile, immediateCompile, hudCompile, stateCache, geometryPool, modelBuffers;
+	bool precompile;
+	auto result = false;
+
+	//same world, projection and ortho matrices D3DClass creates
+	DirectX::XMStoreFloat4x4(&m_worldMatrix, DirectX::XMMatrixIdentity());
+	DirectX::XMMATRIX lmatrix = DirectX::XMMatrixPerspectiveFovLH((float)DirectX::XM_PI / 4.0f, (float)screenWidth / (float)screenHeight, SCREEN_NEAR, SCREEN_DEPTH);
+	DirectX::XMStoreFloat4x4(&m_projectionMatrix, lmatrix);
+	DirectX::XMStoreFloat4x4(&m_orthoMatrix, DirectX::XMMatrixOrthographicLH((float)screenWidth, (float)screenHeight, SCREEN_NEAR, SCREEN_DEPTH));
+
+	result = InitializeJobSystem(0);
+	if (!result)
+	{
+		m_failedStep = "job system";
+		return false;
+	}
+
+	m_Startup.reset(new StartupSchedulerClass());
+	if (!m_Startup)
+	{
+		return false;
+	}
+
+	result = m_Startup->Initialize(m_JobSystem.get());
+	if (!result)
+	{
+		m_failedStep = "startup scheduler";
+		return false;
+	}
+
+	//create the model object, it is there before the tasks so the load and the pool can both get at it
 	m_Model.reset(new ModelClass());
 	if (!m_Model)
 	{
 		return false;
 	}
 
-	//init the model object
-	result = m_Model->Initialize(m_D3D->GetDevice().get(), m_D3D->GetDeviceContext().get(), "uv_checker.tga", "model.txt");
+	device = m_Startup->AddTask("device", StartupSchedulerClass::LANE_DEVICE, [this, createDevice]()
+	{
+		auto result = false;
+
+		if (createDevice)
+		{
+			result = createDevice();
+			if (!result)
+			{
+				return false;
+			}
+		}
+
+		//the memory accounting goes right next to the device, so every resource the scene creates is tracked whoever asks for it
+		if (MEMORY_TRACKING_ENABLED)
+		{
+			m_GpuMemory.reset(new GpuMemoryClass());
+			if (!m_GpuMemory)
+			{
+				return false;
+			}
+
+			result = m_GpuMemory->Initialize(m_Device);
+			if (!result)
+			{
+				return false;
+			}
+
+			m_Device = m_GpuMemory.get();
+		}
+
+		//put the stats in front of the device before anything is created, so everything from here on is counted
+		if (RENDER_STATS_ENABLED)
+		{
+			m_RenderStats.reset(new RenderStatsClass());
+			if (!m_RenderStats)
+			{
+				return false;
+			}
+
+			result = m_RenderStats->Initialize(m_Device);
+			if (!result)
+			{
+				return false;
+			}
+
+			m_Device = m_RenderStats.get();
+
+			if (RENDER_STATS_LOG_ENABLED)
+			{
+				m_RenderStats->OpenLog(RENDER_STATS_LOG_FILE);
+			}
+		}
+
+		return true;
+	});
+
+	//parse the model and decode its texture side by side, no GPU resources are created yet
+	modelParse = m_Startup->AddTask("model parse", StartupSchedulerClass::LANE_CPU, [this]()
+	{
+		return m_Model->LoadModelData("model.txt");
+	});
+
+	textureDecode = m_Startup->AddTask("texture decode", StartupSchedulerClass::LANE_CPU, [this]()
+	{
+		return m_Model->LoadTextureData("uv_checker.tga");
+	});
+
+	//compiling needs no device, the D3D11 backend keeps what is compiled here until the shader is created. A device passed in by the
+	//caller compiles its shaders itself, if at all.
+#ifdef _WIN32
+	precompile = createDevice != nullptr;
+#else
+	precompile = false;
+#endif
+	auto compileTask = [precompile](const RenderShaderDesc* (*getShaders)(int&))
+	{
+		return [precompile, getShaders]()
+		{
+#ifdef _WIN32
+			const RenderShaderDesc* shaders;
+			int count;
+
+			// A shader that does not compile here is compiled again when it is created, which reports the error.
+			shaders = getShaders(count);
+			for (auto i = 0; i < count && precompile; i++)
+			{
+				D3D11RenderDeviceClass::PrecompileShader(shaders[i]);
+			}
+#endif
+			return true;
+		};
+	};
+
+	lightCompile = m_Startup->AddTask("light shader compile", StartupSchedulerClass::LANE_CPU, compileTask(&LightShaderClass::GetShaders));
+	immediateCompile = m_Startup->AddTask("immediate geometry compile", StartupSchedulerClass::LANE_CPU,
+		compileTask(&ImmediateGeometryClass::GetShaders));
+	hudCompile = m_Startup->AddTask("perf hud compile", StartupSchedulerClass::LANE_CPU, compileTask(&SpriteBatchClass::GetShaders));
+
+	//every shader gets its state objects from the cache. The manifest is missing on the first run, which only means nothing is created early.
+	stateCache = m_Startup->AddTask("state cache", StartupSchedulerClass::LANE_DEVICE, [this]()
+	{
+		//what the scene creates is the renderer's, unless a narrower scope or the model and texture say otherwise
+		MEMORY_SCOPE(MEMORY_RENDERER, nullptr);
+
+		m_StateCache.reset(new StateCacheClass());
+		if (!m_StateCache || !m_StateCache->Initialize(m_Device))
+		{
+			return false;
+		}
+
+		m_StateCache->LoadManifest(STATE_MANIFEST_FILE);
+
+		return true;
+	}, { device });
+
+	//create the recorder that spreads the draw list over the cores, slices shorter than 256 draws are not worth a thread
+	m_Startup->AddTask("recorder", StartupSchedulerClass::LANE_DEVICE, [this]()
+	{
+		MEMORY_SCOPE(MEMORY_RENDERER, nullptr);
+
+		m_Recorder.reset(new ParallelRecorderClass());
+		return m_Recorder && m_Recorder->Initialize(m_Device, m_JobSystem.get(), 256);
+	}, { device });
+
+	//the static geometry lives in one pool so every draw shares the same vertex and index buffer binding
+	geometryPool = m_Startup->AddTask("geometry pool", StartupSchedulerClass::LANE_DEVICE, [this]()
+	{
+		MEMORY_SCOPE(MEMORY_GEOMETRY, "geometry pool");
+
+		m_GeometryPool.reset(new GeometryPoolClass());
+		return m_GeometryPool && m_GeometryPool->Initialize(m_Device, m_Model->GetVertexStride(), GEOMETRY_POOL_VERTICES, GEOMETRY_POOL_INDICES, GEOMETRY_POOL_MESHES);
+	}, { device });
+
+	//add the model to the pool and create its texture and mipmaps
+	modelBuffers = m_Startup->AddTask("model buffers", StartupSchedulerClass::LANE_DEVICE, [this]()
+	{
+		return m_Model->InitializeDevice(m_Device, m_GeometryPool.get());
+	}, { modelParse, textureDecode, geometryPool });
+
+	//send the meshes added so far to the device
+	m_Startup->AddTask("geometry upload", StartupSchedulerClass::LANE_DEVICE, [this]()
+	{
+		MEMORY_SCOPE(MEMORY_GEOMETRY, "geometry pool");
+
+		return m_GeometryPool->Upload(m_Device->GetImmediateContext());
+	}, { modelBuffers });
+
+	m_Startup->AddTask("light shader", StartupSchedulerClass::LANE_DEVICE, [this]()
+	{
+		MEMORY_SCOPE(MEMORY_SHADER, "light shader");
+
+		m_LightShader.reset(new LightShaderClass());
+		return m_LightShader && m_LightShader->Initialize(m_Device, m_StateCache.get());
+	}, { stateCache, lightCompile });
+
+	//lines and other geometry made up during the frame are streamed through the immediate geometry's ring buffers
+	m_Startup->AddTask("immediate geometry", StartupSchedulerClass::LANE_DEVICE, [this]()
+	{
+		MEMORY_SCOPE(MEMORY_RENDERER, nullptr);
+
+		m_ImmediateGeometry.reset(new ImmediateGeometryClass());
+		return m_ImmediateGeometry && m_ImmediateGeometry->Initialize(m_Device, m_StateCache.get(), IMMEDIATE_VERTEX_BYTES, IMMEDIATE_INDEX_BYTES);
+	}, { stateCache, immediateCompile });
+
+	//the batch the performance overlay is drawn with, created whether or not it is visible so F3 can show it at any time
+	m_Startup->AddTask("sprite batch", StartupSchedulerClass::LANE_DEVICE, [this, screenWidth, screenHeight]()
+	{
+		MEMORY_SCOPE(MEMORY_UI, "perf hud");
+
+		m_SpriteBatch.reset(new SpriteBatchClass());
+		return m_SpriteBatch && m_SpriteBatch->Initialize(m_Device, m_StateCache.get(), screenWidth, screenHeight, PERF_HUD_MAX_QUADS);
+	}, { stateCache, hudCompile });
+
+	result = m_Startup->Run();
 	if (!result)
 	{
-		MessageBox(hwnd, L"Could not initialize the model object.", L"Error", MB_OK);
+		m_failedStep = "startup tasks";
 		return false;
 	}
 
-	/*
+	//the rest is quick and has no device work, it follows on this thread
+	MEMORY_SCOPE(MEMORY_RENDERER, nullptr);
 
-	// Create the texture shader object.
-	m_TextureShader.reset(new TextureShaderClass());
-	if (!m_TextureShader)
+	result = InitializeSceneGraph();
+	if (!result)
 	{
+		m_failedStep = "scene graph";
 		return false;
 	}
-	//init the texture shader object
-	result = m_TextureShader->Initialize(m_D3D->GetDevice().get(), hwnd);
-	if (!result)
+
+	//create the camera object
+	m_Camera.reset(new CameraClass());
+	if (!m_Camera)
 	{
-		MessageBox(hwnd, L"Could not initialize the color shader object.", L"Error", MB_OK);
 		return false;
 	}
-	*/
 
-	// Create the light shader object.
-	m_LightShader.reset(new LightShaderClass());
-	if (!m_LightShader)
+	//set the initial position of the camera
+	m_Camera->SetPosition(0.0f, 0.0f, -100.0f);
+	m_Camera->SetRotation(0.0f, 0.0f, 0.0f);
+
+	m_PerfHud.reset(new PerfHudClass());
+	if (!m_PerfHud)
 	{
 		return false;
 	}
 
-	// Initialize the light shader object.
-	result = m_LightShader->Initialize(m_D3D->GetDevice().get(), hwnd);
+	result = m_PerfHud->Initialize(PERF_HUD_FRAMES, FRAME_RATE_LIMIT > 0.0f ? 1000.0f / FRAME_RATE_LIMIT : 1000.0f * SIMULATION_STEP);
 	if (!result)
 	{
-		MessageBox(hwnd, L"Could not initialize the light shader object.", L"Error", MB_OK);
+		m_failedStep = "perf hud";
 		return false;
 	}
 
@@ -117,56 +435,142 @@ bool GraphicsClass::Initialize(int screenWidth, int screenHeight, HWND hwnd)
 	m_Light->SetDiffuseColor(1.0f, 1.0f, 1.0f, 1.0f);
 	m_Light->SetDirection(0.0f, 0.0f, 1.0f);
 
+	result = InitializeFrameGraph();
+	if (!result)
+	{
+		m_failedStep = "frame graph";
+		return false;
+	}
+
 	return true;
 }
 
+/*
+InitializeSoftware sets up the same scene as Initialize but renders it with the SoftwareRasterizerClass instead of Direct3D, so there is no
+window and no video card involved. This is what the build agents use to produce and time frames, SaveFrame writes the result to disk.
+*/
 
-void GraphicsClass::Shutdown()
+bool GraphicsClass::InitializeSoftware(int screenWidth, int screenHeight, int threadCount)
 {
-	// Release the color shader object.
-	if (m_TextureShader)
+	auto result = false;
+	int textureWidth, textureHeight;
+	unsigned char* textureData;
+
+	//the rasterizer's passes are jobs, threadCount job system threads or one per core if it is 0
+	result = InitializeJobSystem(threadCount);
+	if (!result)
 	{
-		m_TextureShader->Shutdown();
+		m_failedStep = "job system";
+		return false;
 	}
 
-	// Release the model object.
-	if (m_Model)
+	//create the software rasterizer object
+	m_Software.reset(new SoftwareRasterizerClass());
+	if (!m_Software)
 	{
-		m_Model->Shutdown();
+		return false;
+	}
+
+	//initialize the software rasterizer
+	result = m_Software->Initialize(screenWidth, screenHeight, m_JobSystem.get());
+	if (!result)
+	{
+		m_failedStep = "software rasterizer";
+		return false;
 	}
 
+	//same rasterizer state D3DClass creates: solid fill, back face culling, clockwise front faces
+	m_Software->SetRasterizerState(SoftwareRasterizerClass::CULL_BACK, false);
 
-	if (m_D3D)
+	//same world and projection matrices D3DClass creates
+	DirectX::XMStoreFloat4x4(&m_worldMatrix, DirectX::XMMatrixIdentity());
+	DirectX::XMMATRIX lmatrix = DirectX::XMMatrixPerspectiveFovLH((float)DirectX::XM_PI / 4.0f, (float)screenWidth / (float)screenHeight, SCREEN_NEAR, SCREEN_DEPTH);
+	DirectX::XMStoreFloat4x4(&m_projectionMatrix, lmatrix);
+
+	result = InitializeSceneGraph();
+	if (!result)
 	{
-		m_D3D->Shutdown();
+		m_failedStep = "scene graph";
+		return false;
 	}
 
-	if (m_LightShader)
+	//create the camera object
+	m_Camera.reset(new CameraClass());
+	if (!m_Camera)
 	{
-		m_LightShader->Shutdown();
+		return false;
 	}
 
-	return;
+	//set the initial position of the camera
+	m_Camera->SetPosition(0.0f, 0.0f, -100.0f);
+	m_Camera->SetRotation(0.0f, 0.0f, 0.0f);
+
+	//create the model object
+	m_Model.reset(new ModelClass());
+	if (!m_Model)
+	{
+		return false;
+	}
+
+	//load the model and texture data, no GPU buffers are created. The steps are named like the startup tasks that do the same.
+	result = m_Model->LoadModelData("model.txt");
+	if (!result)
+	{
+		m_failedStep = "model parse";
+		return false;
+	}
+
+	result = m_Model->LoadTextureData("uv_checker.tga");
+	if (!result)
+	{
+		m_failedStep = "texture decode";
+		return false;
+	}
+
+	//hand the texture over to the rasterizer, it builds the mip chain the same way GenerateMips does
+	textureData = m_Model->GetTextureData(textureWidth, textureHeight);
+	m_softwareTexture = m_Software->CreateTexture(textureData, textureWidth, textureHeight);
+	if (m_softwareTexture < 0)
+	{
+		m_failedStep = "texture";
+		return false;
+	}
+
+	// Create the light object.
+	m_Light.reset(new LightClass());
+	if (!m_Light)
+	{
+		return false;
+	}
+
+	// Initialize the light object.
+	m_Light->SetDiffuseColor(1.0f, 1.0f, 1.0f, 1.0f);
+	m_Light->SetDirection(0.0f, 0.0f, 1.0f);
+
+	result = InitializeFrameGraph();
+	if (!result)
+	{
+		m_failedStep = "frame graph";
+		return false;
+	}
+
+	return true;
 }
 
+//InitializeJobSystem starts the job system everything that runs in parallel shares, the recorder, the scene graph, the rasterizer and
+//the frame stages, so there are never more busy threads than cores.
 
-bool GraphicsClass::Frame()
+bool GraphicsClass::InitializeJobSystem(int threadCount)
 {
-	//We add a new static variable to hold an updated rotation value each frame that will be passed into the Render function.
-	static float rotation = 0.0f;
+	auto result = false;
 
-	//update the rotation variable each frame
-	rotation += (float)DirectX::XM_PI * 0.01f;
-	if (rotation > 360.0f)
+	m_JobSystem.reset(new JobSystemClass());
+	if (!m_JobSystem)
 	{
-		rotation -= 360.0f;
+		return false;
 	}
-	
-	
 
-	auto result = false;
-	//render the graphics scene
-	result = Render(rotation);
+	result = m_JobSystem->Initialize(threadCount);
 	if (!result)
 	{
 		return false;
@@ -175,65 +579,848 @@ bool GraphicsClass::Frame()
 	return true;
 }
 
-std::shared_ptr<CameraClass> GraphicsClass::GetCamera()
+//InitializeSceneGraph builds the transform hierarchy: a turntable node that Update spins, with the model sitting on it at m_worldMatrix.
+//The scene is a couple of nodes, far below the level size the graph hands to the job system, so it updates on the calling thread.
+
+bool GraphicsClass::InitializeSceneGraph()
 {
-	return m_Camera;
+	auto result = false;
+
+	m_SceneGraph.reset(new SceneGraphClass());
+	if (!m_SceneGraph)
+	{
+		return false;
+	}
+
+	result = m_SceneGraph->Initialize(m_JobSystem.get());
+	if (!result)
+	{
+		return false;
+	}
+
+	m_turntableNode = m_SceneGraph->AddNode(-1);
+	m_modelNode = m_SceneGraph->AddNode(m_turntableNode);
+	m_SceneGraph->SetLocalTransform(m_modelNode, XMLoadFloat4x4(&m_worldMatrix));
+
+	//lay the nodes out now, an Update that changes the structure allocates and the frames should not have to
+	m_SceneGraph->Update();
+
+	return true;
 }
 
+/*
+InitializeFrameGraph sets up the stages Frame runs and their dependencies:
 
-bool GraphicsClass::Render(float rotation)
-{
-	DirectX::XMFLOAT4X4  viewMatrix, projectionMatrix, worldMatrix;
-	bool result;
+	camera     transforms
+	      \    /
+	       cull -> lod -> sort keys -> constants -> submit
 
-	//clear the buffers to begin the scene
-	m_D3D->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+The camera and transform stages do not depend on each other and run side by side. Each stage only waits for its own run of the previous
+frame, so the camera and transforms of the next frame go ahead while this frame is still being culled or submitted. Every stage works on
+its frame's FrameDataType and the simulation state it owns (the camera stage the frame counter, the transform stage the rotation), so no
+two stages running at the same time touch the same data.
+*/
 
-	//generate the view matrix based on the camera's position
-	m_Camera->Render();
+bool GraphicsClass::InitializeFrameGraph()
+{
+	const unsigned char* vertex;
+	XMFLOAT3 position;
+	int framesInFlight, cameraStage, transformStage, cullStage, lodStage, sortStage, constantStage, submitStage;
+	auto result = false;
 
-	//get the world, view and projection matrices from the camera and d3d objects
-	m_Camera->GetViewMatrix(viewMatrix);
-	m_D3D->GetWorldMatrix(worldMatrix);
-	m_D3D->GetProjectionMatrix(projectionMatrix);
+	//the model's bounding box, for culling
+	m_modelBounds.minimum = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	m_modelBounds.maximum = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	vertex = (const unsigned char*)m_Model->GetVertexData();
+	for (auto i = 0; i < m_Model->GetIndexCount(); i++)
+	{
+		memcpy(&position, vertex + i * m_Model->GetVertexStride(), sizeof(XMFLOAT3));
+		XMStoreFloat3(&m_modelBounds.minimum, XMVectorMin(XMLoadFloat3(&m_modelBounds.minimum), XMLoadFloat3(&position)));
+		XMStoreFloat3(&m_modelBounds.maximum, XMVectorMax(XMLoadFloat3(&m_modelBounds.maximum), XMLoadFloat3(&position)));
+	}
 
-	//put the model vertex and index buffers on the graphics pipeline to prepare them for drawing
-	m_Model->Render(m_D3D->GetDeviceContext().get());
+	//both backends present from the submit stage, whichever thread started the frame, the latency is measured there
+	m_Latency.reset(new LatencyTrackerClass());
+	if (!m_Latency)
+	{
+		return false;
+	}
 
-	//render the model using the color shader
-	/*
-	result = m_ColorShader->Render(m_D3D->GetDeviceContext().get(), m_Model->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix);
+	result = m_Latency->Initialize(LATENCY_SAMPLES);
 	if (!result)
 	{
 		return false;
 	}
-	*/
 
-	//The texture shader is called now instead of the color shader to render the model.Notice it also takes the texture resource pointer from the model,
-	//so the texture shader has access to the texture from the model object.
+	//the frames in flight are the same pipeline depth the render thread uses, with no limit there it is two here
+	framesInFlight = FRAME_PIPELINE_DEPTH > 0 ? FRAME_PIPELINE_DEPTH : 2;
+	m_frameData.resize(framesInFlight);
 
-	// Render the model using the texture shader.
-	XMMATRIX w;
-	XMMATRIX v;
-	XMMATRIX p;
+	//one arena buffer per frame in flight, the stages' lists come out of it
+	m_FrameArena.reset(new FrameArenaClass());
+	if (!m_FrameArena)
+	{
+		return false;
+	}
 
-	w = XMLoadFloat4x4(&worldMatrix);
-	v = XMLoadFloat4x4(&viewMatrix);
-	p = XMLoadFloat4x4(&projectionMatrix);
+	result = m_FrameArena->Initialize(framesInFlight, 64 * 1024);
+	if (!result)
+	{
+		return false;
+	}
 
-	//here we rotate the WORLD matrix by the rotation value so when we render the primitive using this updated world matrix it will spin it by the rot amount
-	w = DirectX::XMMatrixMultiply(w, DirectX::XMMatrixRotationY(rotation));
+	m_TaskGraph.reset(new TaskGraphClass());
+	if (!m_TaskGraph)
+	{
+		return false;
+	}
 
-	result = m_LightShader->Render(m_D3D->GetDeviceContext().get(), m_Model->GetIndexCount(), w, v, p, m_Model->GetTexture(),
-		m_Light->GetDirection(), m_Light->GetDiffuseColor());
+	result = m_TaskGraph->Initialize(m_JobSystem.get(), framesInFlight);
 	if (!result)
 	{
 		return false;
 	}
 
+	//everything up to submitting is hot path that must not touch the heap, the device and the recorder are left out of the check
+	auto hotStage = [this](void (GraphicsClass::*stage)(int))
+	{
+		return [this, stage](int slot)
+		{
+			m_FrameArena->BeginHotPath();
+			(this->*stage)(slot);
+			m_FrameArena->EndHotPath(slot);
+		};
+	};
+
+	cameraStage = m_TaskGraph->AddStage("camera", hotStage(&GraphicsClass::CameraStage));
+	transformStage = m_TaskGraph->AddStage("transforms", hotStage(&GraphicsClass::TransformStage));
+	cullStage = m_TaskGraph->AddStage("cull", hotStage(&GraphicsClass::CullStage));
+	lodStage = m_TaskGraph->AddStage("lod", hotStage(&GraphicsClass::LodStage));
+	sortStage = m_TaskGraph->AddStage("sort keys", hotStage(&GraphicsClass::SortStage));
+	constantStage = m_TaskGraph->AddStage("constants", hotStage(&GraphicsClass::ConstantStage));
+	submitStage = m_TaskGraph->AddStage("submit", [this](int slot) { SubmitStage(slot); });
+
+	m_TaskGraph->AddDependency(cullStage, cameraStage);
+	m_TaskGraph->AddDependency(cullStage, transformStage);
+	m_TaskGraph->AddDependency(lodStage, cullStage);
+	m_TaskGraph->AddDependency(sortStage, lodStage);
+	m_TaskGraph->AddDependency(constantStage, sortStage);
+	m_TaskGraph->AddDependency(submitStage, constantStage);
 
-	// Present the rendered scene to the screen.
-	m_D3D->EndScene();
+	m_cameraStage = cameraStage;
+	m_frameFailed = false;
 
 	return true;
+}
+
+void GraphicsClass::Shutdown()
+{
+	//let the frames in flight finish before anything they use goes away
+	if (m_TaskGraph)
+	{
+		m_TaskGraph->Shutdown();
+	}
+
+	if (m_JobSystem)
+	{
+		m_JobSystem->Shutdown();
+	}
+
+	//nothing presents any more
+	if (m_Latency)
+	{
+		m_Latency->Shutdown();
+	}
+
+	//the frame data's lists point into the arena, they go first
+	m_frameData.clear();
+	if (m_FrameArena)
+	{
+		m_FrameArena->Shutdown();
+	}
+
+#ifdef _WIN32
+	// Release the color shader object.
+	if (m_TextureShader)
+	{
+		m_TextureShader->Shutdown();
+	}
+#endif
+
+	// Release the model object.
+	if (m_Model)
+	{
+		m_Model->Shutdown();
+	}
+
+	if (m_GeometryPool)
+	{
+		m_GeometryPool->Shutdown();
+	}
+
+	if (m_LightShader)
+	{
+		m_LightShader->Shutdown();
+	}
+
+	if (m_ImmediateGeometry)
+	{
+		m_ImmediateGeometry->Shutdown();
+	}
+
+	if (m_PerfHud)
+	{
+		m_PerfHud->Shutdown();
+	}
+
+	if (m_SpriteBatch)
+	{
+		m_SpriteBatch->Shutdown();
+	}
+
+	//after the shaders, they only hold on to the cache's states
+	if (m_StateCache)
+	{
+		m_StateCache->SaveManifest(STATE_MANIFEST_FILE);
+		m_StateCache->Shutdown();
+	}
+
+	if (m_Recorder)
+	{
+		m_Recorder->Shutdown();
+	}
+
+	if (m_SceneGraph)
+	{
+		m_SceneGraph->Shutdown();
+	}
+
+	//everything that could still go through the stats is gone, the device behind them goes next
+	if (m_RenderStats)
+	{
+		m_RenderStats->Shutdown();
+		m_RenderStats.reset();
+	}
+
+	//whatever is still tracked stays tracked, it shows up in the leak report
+	if (m_GpuMemory)
+	{
+		m_GpuMemory->Shutdown();
+		m_GpuMemory.reset();
+	}
+
+#ifdef _WIN32
+	//the render device goes before the D3DClass it was created on
+	if (m_D3DDevice)
+	{
+		m_D3DDevice->Shutdown();
+	}
+
+	if (m_D3D)
+	{
+		m_D3D->Shutdown();
+	}
+#endif
+	m_Device = nullptr;
+
+	if (m_Software)
+	{
+		m_Software->Shutdown();
+	}
+
+	if (m_Startup)
+	{
+		m_Startup->Shutdown();
+	}
+
+	return;
+}
+
+
+/*
+Frame starts the next frame on the task graph. It returns false once a submit stage failed, which shows up a frame or two later, or
+when built with FRAMEARENA_CHECK_NEW once a frame's hot path stages called operator new.
+*/
+
+bool GraphicsClass::Frame(int steps, float alpha)
+{
+	int slot;
+
+	PROFILE_SCOPE("GraphicsClass::Frame");
+
+	slot = StartFrame(steps, alpha, nullptr);
+	if (slot < 0)
+	{
+		return false;
+	}
+
+	//the caller moves the camera between frames, so the camera stage has to be done with it before we return
+	m_TaskGraph->WaitStage(slot, m_cameraStage);
+
+	return !m_frameFailed;
+}
+
+/*
+StartFrame starts the next frame on the task graph and returns its slot, -1 when it could not. Without a snapshot the transform stage
+runs the simulation steps, it is the one stage that touches the simulation state. With one the frame draws the snapshot as it is.
+*/
+
+int GraphicsClass::StartFrame(int steps, float alpha, const SnapshotType* snapshot)
+{
+	int slot;
+
+	if (m_frameFailed)
+	{
+		return -1;
+	}
+
+	//the frame that used the slot before has to be done before its arena buffer can be reset for the new one
+	slot = m_TaskGraph->GetNextSlot();
+	m_TaskGraph->WaitFrame(slot);
+	if (m_FrameArena->GetHotAllocationCount(slot) > 0)
+	{
+		m_frameFailed = true;
+		return -1;
+	}
+	m_FrameArena->Reset(slot);
+
+	FrameDataType& data = m_frameData[slot];
+	data.simulated = snapshot != nullptr;
+	data.steps = steps;
+	data.alpha = alpha;
+	if (snapshot)
+	{
+		data.snapshot = *snapshot;
+	}
+	else
+	{
+		data.snapshot.inputTime = m_inputTime;
+	}
+
+	return m_TaskGraph->BeginFrame();
+}
+
+void GraphicsClass::Flush()
+{
+	if (m_TaskGraph)
+	{
+		m_TaskGraph->Flush();
+	}
+
+	return;
+}
+
+void GraphicsClass::WriteFrameTimings(std::ostream& out)
+{
+	if (m_TaskGraph)
+	{
+		m_TaskGraph->WriteTimings(out);
+	}
+
+	return;
+}
+
+void GraphicsClass::WriteStateStats(std::ostream& out)
+{
+	StateFilterContextClass::StatsType filterStats;
+
+	if (m_StateCache)
+	{
+		m_StateCache->WriteStats(out);
+	}
+
+	if (m_Recorder)
+	{
+		m_Recorder->GetFilterStats(filterStats);
+		out << "binds,issued,filtered" << std::endl;
+		out << "total," << filterStats.issued << "," << filterStats.filtered << std::endl;
+	}
+
+	return;
+}
+
+//CameraStage takes the view matrix and the light for the frame, the state the rest of the frame is drawn from.
+
+void GraphicsClass::CameraStage(int slot)
+{
+	FrameDataType& data = m_frameData[slot];
+
+	if (data.simulated)
+	{
+		return;
+	}
+
+	m_frame++;
+	data.snapshot.frame = m_frame;
+
+	m_Camera->Render();
+	m_Camera->GetViewMatrix(data.snapshot.viewMatrix);
+
+	data.snapshot.lightDirection = m_Light->GetDirection();
+	data.snapshot.diffuseColor = m_Light->GetDiffuseColor();
+
+	return;
+}
+
+//TransformStage spins the turntable and propagates the transforms down the scene graph, same as Update.
+
+void GraphicsClass::TransformStage(int slot)
+{
+	FrameDataType& data = m_frameData[slot];
+
+	if (data.simulated)
+	{
+		return;
+	}
+
+	Simulate(data.steps, data.alpha, data.snapshot.worldMatrix);
+
+	return;
+}
+
+//CullStage tests the model's world space box against the view frustum and starts the draw list with what is visible.
+
+void GraphicsClass::CullStage(int slot)
+{
+	FrameDataType& data = m_frameData[slot];
+	SpatialIndexClass::BoundsType bounds;
+	DrawItemType draw;
+	XMVECTOR corner, center;
+	XMMATRIX world, view;
+
+	world = XMLoadFloat4x4(&data.snapshot.worldMatrix);
+	view = XMLoadFloat4x4(&data.snapshot.viewMatrix);
+	SpatialIndexClass::ExtractFrustum(XMMatrixMultiply(view, XMLoadFloat4x4(&m_projectionMatrix)), data.frustum);
+
+	bounds.minimum = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	bounds.maximum = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (auto i = 0; i < 8; i++)
+	{
+		corner = XMVectorSet((i & 1) ? m_modelBounds.maximum.x : m_modelBounds.minimum.x, (i & 2) ? m_modelBounds.maximum.y : m_modelBounds.minimum.y,
+			(i & 4) ? m_modelBounds.maximum.z : m_modelBounds.minimum.z, 1.0f);
+		corner = XMVector3TransformCoord(corner, world);
+		XMStoreFloat3(&bounds.minimum, XMVectorMin(XMLoadFloat3(&bounds.minimum), corner));
+		XMStoreFloat3(&bounds.maximum, XMVectorMax(XMLoadFloat3(&bounds.maximum), corner));
+	}
+
+	data.draws = FrameVectorType<DrawItemType>(FrameAllocatorType<DrawItemType>(m_FrameArena.get(), slot));
+	data.visible = 0;
+	data.culled = 0;
+	if (!SpatialIndexClass::TestFrustum(data.frustum, bounds))
+	{
+		data.culled++;
+		return;
+	}
+
+	data.visible++;
+
+	center = XMVectorScale(XMVectorAdd(XMLoadFloat3(&bounds.minimum), XMLoadFloat3(&bounds.maximum)), 0.5f);
+	draw.sortKey = 0;
+	draw.lod = 0;
+	draw.depth = XMVectorGetZ(XMVector3TransformCoord(center, view));
+	draw.radius = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&bounds.maximum), center)));
+	data.draws.push_back(draw);
+
+	return;
+}
+
+//LodStage picks every draw's level of detail from how much of the screen height its bounding sphere covers.
+
+void GraphicsClass::LodStage(int slot)
+{
+	float coverage, threshold;
+
+	for (auto& draw : m_frameData[slot].draws)
+	{
+		coverage = draw.radius * m_projectionMatrix._22 / std::max(draw.depth, SCREEN_NEAR);
+
+		draw.lod = 0;
+		threshold = LOD_COVERAGE;
+		while (draw.lod < LOD_LEVELS - 1 && coverage < threshold)
+		{
+			draw.lod++;
+			threshold *= 0.5f;
+		}
+	}
+
+	return;
+}
+
+//SortStage orders the draw list by level of detail, then texture, then front to back. A positive float's bits sort like the float.
+
+void GraphicsClass::SortStage(int slot)
+{
+	FrameVectorType<DrawItemType>& draws = m_frameData[slot].draws;
+	unsigned int depthBits;
+	float depth;
+
+	for (auto& draw : draws)
+	{
+		depth = std::max(draw.depth, 0.0f);
+		memcpy(&depthBits, &depth, sizeof(depthBits));
+		draw.sortKey = ((unsigned long long)draw.lod << 56) | ((unsigned long long)(m_Model->GetTexture() & 0xffffff) << 32) | depthBits;
+	}
+
+	std::sort(draws.begin(), draws.end(), [](const DrawItemType& a, const DrawItemType& b) { return a.sortKey < b.sortKey; });
+
+	return;
+}
+
+//ConstantStage lays the per draw constants out in draw order so submitting only walks one array.
+
+void GraphicsClass::ConstantStage(int slot)
+{
+	FrameDataType& data = m_frameData[slot];
+
+	data.constants = FrameVectorType<XMFLOAT4X4>(FrameAllocatorType<XMFLOAT4X4>(m_FrameArena.get(), slot));
+	data.constants.resize(data.draws.size());
+	for (size_t i = 0; i < data.draws.size(); i++)
+	{
+		data.constants[i] = data.snapshot.worldMatrix;
+	}
+
+	return;
+}
+
+//SubmitStage draws the frame's draw list on the device or the software rasterizer.
+
+void GraphicsClass::SubmitStage(int slot)
+{
+	FrameDataType& data = m_frameData[slot];
+	std::atomic<bool> failed(false);
+	XMMATRIX v, p;
+
+	v = XMLoadFloat4x4(&data.snapshot.viewMatrix);
+	p = XMLoadFloat4x4(&m_projectionMatrix);
+
+	if (m_Software)
+	{
+		m_Software->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+
+		for (auto& world : data.constants)
+		{
+			m_Software->Draw(m_Model->GetVertexData(), m_Model->GetVertexStride(), m_Model->GetIndexCount(), m_softwareTexture,
+				XMLoadFloat4x4(&world), v, p, data.snapshot.lightDirection, data.snapshot.diffuseColor);
+		}
+
+		m_Software->EndScene();
+		m_Latency->Present(data.snapshot.inputTime);
+
+		return;
+	}
+
+	m_Device->BeginScene(0.0f, 0.0f, 0.0f, 1.0f);
+
+	m_Recorder->Record((int)data.constants.size(), [&](RenderContextClass* context, int first, int last)
+	{
+		//all draws come out of the geometry pool, so the buffers are bound once per chunk
+		m_Model->Render(context);
+
+		for (auto i = first; i < last; i++)
+		{
+			if (!m_LightShader->Render(context, m_Model->GetIndexCount(), m_Model->GetStartIndex(), m_Model->GetBaseVertex(),
+				XMLoadFloat4x4(&data.constants[i]), v, p, m_Model->GetTexture(),
+				data.snapshot.lightDirection, data.snapshot.diffuseColor))
+			{
+				failed = true;
+			}
+		}
+	});
+
+	//the frame's transient geometry goes last, through the immediate context and its state filter
+	for (size_t i = 0; DEBUG_BOUNDS_ENABLED && i < data.constants.size(); i++)
+	{
+		AddBoundsGeometry(data.constants[i]);
+	}
+
+	if (!m_ImmediateGeometry->Render(m_Recorder->GetImmediateContext(), v, p))
+	{
+		failed = true;
+	}
+
+	if (!RenderHud(m_Recorder->GetImmediateContext()))
+	{
+		failed = true;
+	}
+
+	if (m_RenderStats)
+	{
+		m_RenderStats->CountObjects(data.visible, data.culled);
+	}
+
+	m_Device->EndScene();
+	m_Latency->Present(data.snapshot.inputTime);
+
+	if (failed)
+	{
+		m_frameFailed = true;
+	}
+
+	return;
+}
+
+std::shared_ptr<CameraClass> GraphicsClass::GetCamera()
+{
+	return m_Camera;
+}
+
+std::shared_ptr<RenderStatsClass> GraphicsClass::GetRenderStats()
+{
+	return m_RenderStats;
+}
+
+void GraphicsClass::SetHudVisible(bool visible)
+{
+	m_hudVisible = visible;
+	return;
+}
+
+bool GraphicsClass::IsHudVisible()
+{
+	return m_hudVisible;
+}
+
+std::shared_ptr<PerfHudClass> GraphicsClass::GetPerfHud()
+{
+	return m_PerfHud;
+}
+
+void GraphicsClass::SetInputTime(unsigned long long time)
+{
+	m_inputTime = time;
+	return;
+}
+
+std::shared_ptr<LatencyTrackerClass> GraphicsClass::GetLatency()
+{
+	return m_Latency;
+}
+
+std::shared_ptr<StartupSchedulerClass> GraphicsClass::GetStartup()
+{
+	return m_Startup;
+}
+
+const char* GraphicsClass::GetFailedStep()
+{
+	return m_failedStep;
+}
+
+int GraphicsClass::GetStageCount()
+{
+	return m_TaskGraph ? m_TaskGraph->GetStageCount() : 0;
+}
+
+const char* GraphicsClass::GetStageName(int stage)
+{
+	return m_TaskGraph->GetStageName(stage);
+}
+
+float GraphicsClass::GetLastStageTime(int stage)
+{
+	return m_TaskGraph->GetLastStageTime(stage);
+}
+
+//Update advances the simulation by one frame and writes everything the renderer needs into the snapshot.
+
+void GraphicsClass::Update(SnapshotType& snapshot, int steps, float alpha)
+{
+	m_frame++;
+	snapshot.frame = m_frame;
+
+	//generate the view matrix based on the camera's position
+	m_Camera->Render();
+	m_Camera->GetViewMatrix(snapshot.viewMatrix);
+
+	//here we rotate the turntable, the model sits on it so its WORLD matrix becomes m_worldMatrix spun by the rot amount
+	Simulate(steps, alpha, snapshot.worldMatrix);
+
+	snapshot.lightDirection = m_Light->GetDirection();
+	snapshot.diffuseColor = m_Light->GetDiffuseColor();
+	snapshot.inputTime = m_inputTime;
+
+	return;
+}
+
+//Render draws a snapshot Update made by running it through the frame's task graph, where the camera and transform stages pass it on as
+//it is, and returns once the frame is presented. It does not touch any of the simulation state so it can run on its own thread.
+
+bool GraphicsClass::Render(const SnapshotType& snapshot)
+{
+	int slot;
+
+	PROFILE_SCOPE("GraphicsClass::Render");
+
+	slot = StartFrame(0, 0.0f, &snapshot);
+	if (slot < 0)
+	{
+		return false;
+	}
+
+	m_TaskGraph->WaitFrame(slot);
+
+	return !m_frameFailed;
+}
+
+void GraphicsClass::SetRenderThread(std::thread::id thread)
+{
+	if (m_JobSystem)
+	{
+		m_JobSystem->SetMainThread(thread);
+	}
+
+	return;
+}
+
+/*
+Simulate runs the given number of fixed steps and writes the model's world matrix for a rotation alpha of the way from the one before
+the last step to the one after it. The rotation wraps at a full turn, both values at once so the interpolation never goes the long way.
+*/
+
+void GraphicsClass::Simulate(int steps, float alpha, DirectX::XMFLOAT4X4& worldMatrix)
+{
+	float rotation;
+
+	for (auto i = 0; i < steps; i++)
+	{
+		m_previousRotation = m_rotation;
+		m_rotation += TURNTABLE_SPEED * SIMULATION_STEP;
+		if (m_rotation > DirectX::XM_2PI)
+		{
+			m_rotation -= DirectX::XM_2PI;
+			m_previousRotation -= DirectX::XM_2PI;
+		}
+	}
+
+	rotation = m_previousRotation + (m_rotation - m_previousRotation) * alpha;
+
+	m_SceneGraph->SetLocalTransform(m_turntableNode, DirectX::XMMatrixRotationY(rotation));
+	m_SceneGraph->Update();
+	m_SceneGraph->GetWorldTransform(m_modelNode, worldMatrix);
+
+	return;
+}
+
+//AddBoundsGeometry adds the twelve edges of the model's bounding box placed with the given world matrix to the immediate geometry.
+
+void GraphicsClass::AddBoundsGeometry(const XMFLOAT4X4& world)
+{
+	static const unsigned int edges[24] = { 0, 1, 2, 3, 4, 5, 6, 7, 0, 2, 1, 3, 4, 6, 5, 7, 0, 4, 1, 5, 2, 6, 3, 7 };
+	ImmediateGeometryClass::VertexType corners[8];
+	XMMATRIX w;
+
+	w = XMLoadFloat4x4(&world);
+	for (auto i = 0; i < 8; i++)
+	{
+		XMStoreFloat3(&corners[i].position, XMVector3TransformCoord(XMVectorSet((i & 1) ? m_modelBounds.maximum.x : m_modelBounds.minimum.x,
+			(i & 2) ? m_modelBounds.maximum.y : m_modelBounds.minimum.y, (i & 4) ? m_modelBounds.maximum.z : m_modelBounds.minimum.z, 1.0f), w));
+		corners[i].color = XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
+	}
+
+	m_ImmediateGeometry->AddLines(corners, 8, edges, 24);
+
+	return;
+}
+
+/*
+RenderHud feeds the overlay what the frame before this one measured and draws it on the given context, before EndScene closes the
+frame. The frame time is the time since the last frame the HUD was drawn on, the stage times come from the task graph and the counters
+from the render stats of the last finished frame. The HUD's own build and render time is shown with the stages, a frame late.
+*/
+
+bool GraphicsClass::RenderHud(RenderContextClass* context)
+{
+	std::chrono::steady_clock::time_point start;
+	RenderStatsClass::StatsType stats;
+	unsigned long long stateChanges;
+	bool result;
+
+	if (!m_hudVisible || !m_PerfHud || !m_SpriteBatch)
+	{
+		m_hudWasVisible = false;
+		return true;
+	}
+
+	PROFILE_SCOPE("GraphicsClass::RenderHud");
+
+	start = std::chrono::steady_clock::now();
+
+	//the first frame after the overlay was shown has nothing to measure against
+	if (m_hudWasVisible)
+	{
+		m_PerfHud->AddFrameTime(std::chrono::duration<float, std::milli>(start - m_hudLastFrame).count());
+	}
+	m_hudWasVisible = true;
+	m_hudLastFrame = start;
+
+	for (auto stage = 0; stage < GetStageCount(); stage++)
+	{
+		m_PerfHud->SetStageTime(GetStageName(stage), GetLastStageTime(stage));
+	}
+	m_PerfHud->SetStageTime("hud", m_hudMs);
+
+	if (m_RenderStats)
+	{
+		m_RenderStats->GetFrameStats(stats);
+
+		stateChanges = 0;
+		for (auto kind = 0; kind < RenderStatsClass::STATE_KIND_COUNT; kind++)
+		{
+			stateChanges += stats.stateChanges[kind];
+		}
+
+		m_PerfHud->SetCounter("draws", (double)stats.draws);
+		m_PerfHud->SetCounter("triangles", (double)stats.triangles);
+		m_PerfHud->SetCounter("state changes", (double)stateChanges);
+		m_PerfHud->SetCounter("cb bytes", (double)stats.constantBufferBytes);
+		m_PerfHud->SetCounter("visible", (double)stats.visibleObjects);
+		m_PerfHud->SetCounter("culled", (double)stats.culledObjects);
+	}
+
+	m_PerfHud->SetCounter("latency ms", m_Latency->GetLastLatency());
+
+	if (m_GpuMemory)
+	{
+		m_PerfHud->SetCounter("gpu memory kb", (double)MemoryTrackerClass::GetTotal(MEMORY_GPU) / 1024.0);
+	}
+
+	//reading the process memory is a system call, a few times a second is plenty
+	if (m_hudFrames++ % PERF_HUD_MEMORY_INTERVAL == 0)
+	{
+		m_PerfHud->SetMemory(PerfHudClass::GetProcessMemory());
+	}
+
+	m_PerfHud->Build(m_SpriteBatch.get(), 8.0f, 8.0f);
+	result = m_SpriteBatch->Render(context, XMLoadFloat4x4(&m_orthoMatrix));
+
+	m_hudMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	return result;
+}
+
+//SaveFrame writes the last software rendered frame, a .png extension writes a png and anything else a targa.
+
+bool GraphicsClass::SaveFrame(const char* filename)
+{
+	size_t length;
+
+	if (!m_Software || !filename)
+	{
+		return false;
+	}
+
+	length = strlen(filename);
+	if (length > 4 && _stricmp(filename + length - 4, ".png") == 0)
+	{
+		return m_Software->SavePng(filename);
+	}
+
+	return m_Software->SaveTarga(filename);
+}
+
+//GetSoftwareFrameTime returns how many milliseconds the software rasterizer took for the last frame.
+
+float GraphicsClass::GetSoftwareFrameTime()
+{
+	return m_Software ? m_Software->GetFrameTime() : 0.0f;
 }
\ No newline at end of file
@@ -10,13 +10,38 @@
 //////////////
 // INCLUDES //
 //////////////
+#ifdef _WIN32
 #include "d3dclass.h"
-#include "modelclass.h"
+#include "d3d11renderdeviceclass.h"
 #include "textureshaderclass.h"
+#endif
+#include "renderdeviceclass.h"
+#include "renderstatsclass.h"
+#include "gpumemoryclass.h"
+#include "parallelrecorderclass.h"
+#include "scenegraphclass.h"
+#include "modelclass.h"
+#include "geometrypoolclass.h"
+#include "immediategeometryclass.h"
+#include "statecacheclass.h"
 #include "cameraclass.h"
 #include "lightshaderclass.h"
 #include "lightclass.h"
+#include "softwarerasterizerclass.h"
+#include "spatialindexclass.h"
+#include "jobsystemclass.h"
+#include "taskgraphclass.h"
+#include "framearenaclass.h"
+#include "spritebatchclass.h"
+#include "perfhudclass.h"
+#include "latencytrackerclass.h"
+#include "startupschedulerclass.h"
 #include <memory>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <ostream>
 
 /////////////
 // GLOBALS //
@@ -27,6 +52,76 @@ const float SCREEN_DEPTH = 1000.0f;
 const float SCREEN_NEAR = 0.1f;
 const bool FULL_SCREEN = false;
 
+//the simulation runs on the main thread and the rest of the frame's task graph is started from the render thread, FRAME_PIPELINE_DEPTH
+//is how many frames the simulation may get ahead of the last frame that finished rendering (0 = no limit, the renderer just takes the
+//newest snapshot)
+const bool RENDER_THREAD_ENABLED = true;
+const int FRAME_PIPELINE_DEPTH = 2;
+
+//the simulation advances in fixed steps of SIMULATION_STEP seconds, at most MAX_SIMULATION_STEPS a frame, and the main loop is held to
+//FRAME_RATE_LIMIT frames a second (0 = no limit), see FramePacerClass. The turntable turns TURNTABLE_SPEED radians a second, which is
+//the 0.01 pi a frame it used to turn at 60 frames a second.
+const float SIMULATION_STEP = 1.0f / 60.0f;
+const int MAX_SIMULATION_STEPS = 8;
+const float FRAME_RATE_LIMIT = 60.0f;
+const float TURNTABLE_SPEED = DirectX::XM_PI * 0.6f;
+
+//level of detail: a draw covering less than LOD_COVERAGE of the screen height drops a level, and another one every time it halves.
+//The model only has one level so far.
+const float LOD_COVERAGE = 0.25f;
+const int LOD_LEVELS = 1;
+
+//size of the shared vertex and index buffers all static meshes are suballocated from, and the most meshes they hold
+const int GEOMETRY_POOL_VERTICES = 262144;
+const int GEOMETRY_POOL_INDICES = 262144;
+const int GEOMETRY_POOL_MESHES = 1024;
+
+//ring buffer sizes for the geometry made up every frame, and whether every draw's bounding box is drawn with it
+const unsigned int IMMEDIATE_VERTEX_BYTES = 4 * 1024 * 1024;
+const unsigned int IMMEDIATE_INDEX_BYTES = 1024 * 1024;
+const bool DEBUG_BOUNDS_ENABLED = false;
+
+//the state objects used by the last run, created at startup before the first frame needs them and written again at shutdown
+const char* const STATE_MANIFEST_FILE = "states.txt";
+
+//where the profiler's Chrome trace is written at shutdown, see ProfilerClass
+const char* const PROFILE_TRACE_FILE = "trace.json";
+
+//a frame taking HITCH_THRESHOLD_RATIO times the average of the last HITCH_WINDOW_SECONDS and HITCH_THRESHOLD_MS more than it dumps the
+//window to HITCH_DUMP_PREFIX<frame>.json, see HitchDetectorClass
+const bool HITCH_DETECTION_ENABLED = true;
+const float HITCH_WINDOW_SECONDS = 5.0f;
+const float HITCH_THRESHOLD_RATIO = 2.0f;
+const float HITCH_THRESHOLD_MS = 10.0f;
+const char* const HITCH_DUMP_PREFIX = "hitch_";
+
+//every frame's draws, state changes, uploads and culling are counted by a RenderStatsClass in front of the device, and with
+//RENDER_STATS_LOG_ENABLED written to RENDER_STATS_LOG_FILE as they finish
+const bool RENDER_STATS_ENABLED = true;
+const bool RENDER_STATS_LOG_ENABLED = false;
+const char* const RENDER_STATS_LOG_FILE = "render_stats.csv";
+
+//the performance overlay, toggled with F3: PERF_HUD_FRAMES frames in its graph, at most PERF_HUD_MAX_QUADS quads of overlay a frame,
+//and the process memory is read every PERF_HUD_MEMORY_INTERVAL frames, see PerfHudClass
+const bool PERF_HUD_VISIBLE = false;
+const int PERF_HUD_FRAMES = 120;
+const int PERF_HUD_MAX_QUADS = 4096;
+const int PERF_HUD_MEMORY_INTERVAL = 30;
+
+//the GPU memory every resource takes is tracked by a GpuMemoryClass next to the device, against the budgets in MEMORY_BUDGET_FILE when
+//there is one, and whatever is still around at shutdown is written to MEMORY_LEAK_FILE, see MemoryTrackerClass
+const bool MEMORY_TRACKING_ENABLED = true;
+const char* const MEMORY_BUDGET_FILE = "memory_budgets.txt";
+const char* const MEMORY_LEAK_FILE = "memory_leaks.txt";
+
+//input to photon latency is measured over the last LATENCY_SAMPLES inputs that were presented, and its percentiles are written to
+//LATENCY_FILE at shutdown, see LatencyTrackerClass
+const int LATENCY_SAMPLES = 1024;
+const char* const LATENCY_FILE = "latency.csv";
+
+//when each of the tasks the scene loads with ran is written to STARTUP_TIMELINE_FILE, see StartupSchedulerClass
+const char* const STARTUP_TIMELINE_FILE = "startup.csv";
+
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -34,26 +129,180 @@ const bool FULL_SCREEN = false;
 ////////////////////////////////////////////////////////////////////////////////
 class GraphicsClass
 {
+public:
+	//Everything the renderer needs to draw one frame. Update fills one in on the simulation thread and Render only ever reads from it,
+	//so the simulation can go on changing the camera and the scene while the renderer is still busy with the previous snapshot.
+	struct SnapshotType
+	{
+		unsigned long long frame;
+		DirectX::XMFLOAT4X4 viewMatrix;
+		DirectX::XMFLOAT4X4 worldMatrix;
+		DirectX::XMFLOAT3 lightDirection;
+		DirectX::XMFLOAT4 diffuseColor;
+		//the newest input the simulation had seen, on the LatencyTrackerClass clock, 0 for none
+		unsigned long long inputTime;
+	};
+
+private:
+	//one entry of a frame's draw list, the sort key orders it by level of detail, texture and then front to back
+	struct DrawItemType
+	{
+		unsigned long long sortKey;
+		int lod;
+		float depth;
+		float radius;
+	};
+
+	//what the task graph stages of one frame in flight hand each other, Frame keeps one per frame slot. The lists live in the slot's
+	//frame arena buffer. A frame started by Render is simulated already, its camera and transform stages leave the snapshot as it is.
+	struct FrameDataType
+	{
+		bool simulated;
+		int steps;
+		float alpha;
+		SnapshotType snapshot;
+		SpatialIndexClass::FrustumType frustum;
+		unsigned int visible;
+		unsigned int culled;
+		FrameVectorType<DrawItemType> draws;
+		FrameVectorType<DirectX::XMFLOAT4X4> constants;
+	};
+
 public:
 	GraphicsClass();
 	GraphicsClass(const GraphicsClass&);
 	~GraphicsClass();
 
+#ifdef _WIN32
 	bool Initialize(int, int, HWND);
+#endif
+	bool Initialize(int, int, RenderDeviceClass*);
+	bool InitializeSoftware(int, int, int);
 	void Shutdown();
-	bool Frame();
+
+	//Frame runs the frame as a task graph on the job system and returns once the camera stage is done, with up to FRAME_PIPELINE_DEPTH
+	//frames in flight. It takes the number of simulation steps to run and how far to interpolate past the state before the last one,
+	//see FramePacerClass. Flush waits for all of them, WriteFrameTimings writes the per stage timings and the critical path.
+	bool Frame(int, float);
+	void Flush();
+	void WriteFrameTimings(std::ostream&);
+	//the state cache's requests, hits and creations per kind of state, and the binds the state filters passed on and dropped
+	void WriteStateStats(std::ostream&);
 	std::shared_ptr<CameraClass> GetCamera();
+	//the per frame renderer counters, nullptr with RENDER_STATS_ENABLED off or on the software rasterizer
+	std::shared_ptr<RenderStatsClass> GetRenderStats();
+
+	//the performance overlay, it is drawn over the next frames rendered on the device
+	void SetHudVisible(bool);
+	bool IsHudVisible();
+	std::shared_ptr<PerfHudClass> GetPerfHud();
+
+	//the frame's task graph stages and how long each took in the last finished frame, in milliseconds
+	int GetStageCount();
+	const char* GetStageName(int);
+	float GetLastStageTime(int);
+
+	//the time of the newest input event, the frames started from here on carry it until they are presented
+	void SetInputTime(unsigned long long);
+	//input to photon latency of the presented frames
+	std::shared_ptr<LatencyTrackerClass> GetLatency();
+
+	//the tasks the scene was loaded with and when they ran, nullptr on the software rasterizer
+	std::shared_ptr<StartupSchedulerClass> GetStartup();
+	//the step the scene failed to initialize at, nullptr if it did not fail. For "startup tasks" GetStartup has the task that failed.
+	const char* GetFailedStep();
+
+	//Frame split in two for running the simulation and the renderer on different threads, Update takes the same steps and alpha as Frame.
+	//Render runs the snapshot through the rest of the frame's task graph and returns once it is presented. SetRenderThread names the thread
+	//that is going to call Render, before its first call, so the job system spreads the stages over all cores from that thread.
+	void Update(SnapshotType&, int, float);
+	bool Render(const SnapshotType&);
+	void SetRenderThread(std::thread::id);
+
+	//only valid when running on the software rasterizer
+	bool SaveFrame(const char*);
+	float GetSoftwareFrameTime();
 
 private:
-	bool Render(float);
+	bool InitializeScene(int, int, const StartupSchedulerClass::TaskFunctionType&);
+	bool InitializeJobSystem(int);
+	bool InitializeSceneGraph();
+	bool InitializeFrameGraph();
+	int StartFrame(int, float, const SnapshotType*);
+	void CameraStage(int);
+	void TransformStage(int);
+	void CullStage(int);
+	void LodStage(int);
+	void SortStage(int);
+	void ConstantStage(int);
+	void SubmitStage(int);
+	void AddBoundsGeometry(const DirectX::XMFLOAT4X4&);
+	bool RenderHud(RenderContextClass*);
+	void Simulate(int, float, DirectX::XMFLOAT4X4&);
 
 private:
+#ifdef _WIN32
 	std::shared_ptr<D3DClass> m_D3D;
-	std::shared_ptr<ModelClass> m_Model;
+	std::shared_ptr<D3D11RenderDeviceClass> m_D3DDevice;
 	std::shared_ptr<TextureShaderClass> m_TextureShader;
+#endif
+	//the device the scene renders on, either m_D3DDevice or one that was passed in, behind m_GpuMemory and m_RenderStats when they are on
+	RenderDeviceClass* m_Device;
+	std::shared_ptr<GpuMemoryClass> m_GpuMemory;
+	std::shared_ptr<RenderStatsClass> m_RenderStats;
+	std::shared_ptr<StateCacheClass> m_StateCache;
+	std::shared_ptr<ParallelRecorderClass> m_Recorder;
+	std::shared_ptr<SceneGraphClass> m_SceneGraph;
+	std::shared_ptr<GeometryPoolClass> m_GeometryPool;
+	std::shared_ptr<ModelClass> m_Model;
 	std::shared_ptr<CameraClass> m_Camera;
 	std::shared_ptr<LightShaderClass> m_LightShader;
 	std::shared_ptr<LightClass> m_Light;
+	std::shared_ptr<ImmediateGeometryClass> m_ImmediateGeometry;
+
+	//the overlay, only touched by the thread rendering apart from the visible flag. The HUD measures its own build and render time.
+	std::shared_ptr<SpriteBatchClass> m_SpriteBatch;
+	std::shared_ptr<PerfHudClass> m_PerfHud;
+	std::atomic<bool> m_hudVisible;
+	bool m_hudWasVisible;
+	std::chrono::steady_clock::time_point m_hudLastFrame;
+	unsigned long long m_hudFrames;
+	float m_hudMs;
+
+	//the frame's stages and the threads they run on, the thread calling Initialize is one of them
+	std::shared_ptr<JobSystemClass> m_JobSystem;
+	std::shared_ptr<TaskGraphClass> m_TaskGraph;
+	std::shared_ptr<FrameArenaClass> m_FrameArena;
+	std::vector<FrameDataType> m_frameData;
+	SpatialIndexClass::BoundsType m_modelBounds;
+	int m_cameraStage;
+	std::atomic<bool> m_frameFailed;
+
+	//headless rendering, replaces m_D3D when the scene is initialized with InitializeSoftware
+	std::shared_ptr<SoftwareRasterizerClass> m_Software;
+	int m_softwareTexture;
+
+	const char* m_failedStep;
+
+	//same world, projection and ortho matrices D3DClass creates, kept here so they do not depend on the backend
+	DirectX::XMFLOAT4X4 m_projectionMatrix;
+	DirectX::XMFLOAT4X4 m_worldMatrix;
+	DirectX::XMFLOAT4X4 m_orthoMatrix;
+
+	//simulation state, only touched by Update or the transform stage. The rotation before the last step is kept for interpolating.
+	float m_rotation;
+	float m_previousRotation;
+	int m_turntableNode;
+	int m_modelNode;
+	unsigned long long m_frame;
+	unsigned long long m_inputTime;
+	SnapshotType m_snapshot;
+
+	//fed at every present with the input time of the frame presented
+	std::shared_ptr<LatencyTrackerClass> m_Latency;
+
+	//kept after startup for its timeline
+	std::shared_ptr<StartupSchedulerClass> m_Startup;
 
 
 };
@@ -0,0 +1,355 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: hitchdetectorclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "hitchdetectorclass.h"
+#include <mutex>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdio>
+
+//how many finished activities are kept around, besides the ones still going on
+static const size_t MAX_FINISHED_ACTIVITIES = 256;
+
+static std::mutex s_activityMutex;
+static std::deque<HitchDetectorClass::ActivityRecordType> s_activities;
+static unsigned long long s_nextActivity = 1;
+
+HitchDetectorClass::ActivityType::ActivityType(const char* category, const std::string& detail)
+	: m_id(0)
+#ifdef PROFILER_ENABLED
+	, m_scope(category)
+#endif
+{
+	ActivityRecordType record;
+
+	record.category = category;
+	record.detail = detail;
+	record.startTicks = ProfilerClass::GetTicks();
+	record.endTicks = 0;
+
+	std::lock_guard<std::mutex> lock(s_activityMutex);
+	record.id = s_nextActivity++;
+	m_id = record.id;
+	s_activities.push_back(record);
+}
+
+HitchDetectorClass::ActivityType::~ActivityType()
+{
+	unsigned long long ticks;
+	size_t finished;
+
+	ticks = ProfilerClass::GetTicks();
+
+	std::lock_guard<std::mutex> lock(s_activityMutex);
+
+	finished = 0;
+	for (auto& record : s_activities)
+	{
+		if (record.id == m_id)
+		{
+			record.endTicks = ticks;
+		}
+		if (record.endTicks != 0)
+		{
+			finished++;
+		}
+	}
+
+	// Forget the oldest finished one, the ones still going on are always kept.
+	if (finished > MAX_FINISHED_ACTIVITIES)
+	{
+		for (auto record = s_activities.begin(); record != s_activities.end(); ++record)
+		{
+			if (record->endTicks != 0)
+			{
+				s_activities.erase(record);
+				break;
+			}
+		}
+	}
+}
+
+HitchDetectorClass::HitchDetectorClass()
+	: m_windowSeconds(0.0f)
+	, m_thresholdRatio(0.0f)
+	, m_thresholdMs(0.0f)
+	, m_windowSum(0.0)
+	, m_quietUntil(0.0)
+	, m_hitches(0)
+	, m_dumps(0)
+{
+	memset(&m_current, 0, sizeof(m_current));
+}
+
+HitchDetectorClass::HitchDetectorClass(const HitchDetectorClass& other)
+{
+}
+
+
+HitchDetectorClass::~HitchDetectorClass()
+{
+}
+
+bool HitchDetectorClass::Initialize(float windowSeconds, float thresholdRatio, float thresholdMs, const char* dumpPrefix)
+{
+	if (windowSeconds <= 0.0f || thresholdRatio < 1.0f || thresholdMs < 0.0f || !dumpPrefix)
+	{
+		return false;
+	}
+
+	m_windowSeconds = windowSeconds;
+	m_thresholdRatio = thresholdRatio;
+	m_thresholdMs = thresholdMs;
+	m_dumpPrefix = dumpPrefix;
+	m_lastDump.clear();
+
+	m_frames.clear();
+	m_statNames.clear();
+	m_windowSum = 0.0;
+	m_quietUntil = 0.0;
+	m_hitches = 0;
+	m_dumps = 0;
+
+	// The first frame starts now.
+	m_startTime = std::chrono::steady_clock::now();
+	memset(&m_current, 0, sizeof(m_current));
+	m_current.startTicks = ProfilerClass::GetTicks();
+
+	return true;
+}
+
+void HitchDetectorClass::Shutdown()
+{
+	m_frames.clear();
+	return;
+}
+
+bool HitchDetectorClass::SetFrameStat(const char* name, float value)
+{
+	size_t stat;
+
+	for (stat = 0; stat < m_statNames.size(); stat++)
+	{
+		if (m_statNames[stat] == name)
+		{
+			break;
+		}
+	}
+
+	if (stat == m_statNames.size())
+	{
+		if (stat >= MAX_FRAME_STATS)
+		{
+			return false;
+		}
+
+		m_statNames.push_back(name);
+	}
+
+	m_current.stats[stat] = value;
+
+	return true;
+}
+
+/*
+Frame finishes the frame that is going on. It is held against the window as it was before the frame, then added to it and the frames
+that are now older than the window length are dropped.
+*/
+
+bool HitchDetectorClass::Frame()
+{
+	FrameType frame;
+	float average;
+	bool hitch;
+
+	frame = m_current;
+	frame.end = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+	frame.endTicks = ProfilerClass::GetTicks();
+	frame.ms = (float)((frame.end - frame.start) * 1000.0);
+
+	hitch = false;
+	if ((int)m_frames.size() >= MIN_WINDOW_FRAMES)
+	{
+		average = (float)(m_windowSum / (double)m_frames.size());
+		hitch = frame.ms > average * m_thresholdRatio && frame.ms > average + m_thresholdMs;
+
+		if (hitch)
+		{
+			m_hitches++;
+
+			// One dump per window, the frames of the last one would be most of the next one anyway.
+			if (frame.end >= m_quietUntil && WriteDump(frame, average))
+			{
+				m_dumps++;
+				m_quietUntil = frame.end + m_windowSeconds;
+			}
+		}
+	}
+
+	m_frames.push_back(frame);
+	m_windowSum += frame.ms;
+	while (!m_frames.empty() && m_frames.front().end < frame.end - m_windowSeconds)
+	{
+		m_windowSum -= m_frames.front().ms;
+		m_frames.pop_front();
+	}
+
+	// The next frame starts where this one ended.
+	memset(&m_current, 0, sizeof(m_current));
+	m_current.frame = frame.frame + 1;
+	m_current.start = frame.end;
+	m_current.startTicks = frame.endTicks;
+
+	return hitch;
+}
+
+unsigned long long HitchDetectorClass::GetHitchCount()
+{
+	return m_hitches;
+}
+
+unsigned long long HitchDetectorClass::GetDumpCount()
+{
+	return m_dumps;
+}
+
+const std::string& HitchDetectorClass::GetLastDump()
+{
+	return m_lastDump;
+}
+
+void HitchDetectorClass::GetActivities(unsigned long long startTicks, unsigned long long endTicks, std::vector<ActivityRecordType>& activities)
+{
+	std::lock_guard<std::mutex> lock(s_activityMutex);
+
+	activities.clear();
+	for (auto& record : s_activities)
+	{
+		if (record.startTicks <= endTicks && (record.endTicks == 0 || record.endTicks >= startTicks))
+		{
+			activities.push_back(record);
+		}
+	}
+
+	return;
+}
+
+/*
+WriteDump writes the window and the hitch as a Chrome trace. The frame times and stats are counters set at the start of each frame,
+the activities go on a track of their own, and the profiler adds its scopes from the start of the window on.
+*/
+
+bool HitchDetectorClass::WriteDump(const FrameType& hitch, float average)
+{
+	std::vector<ActivityRecordType> activities, windowActivities;
+	std::ofstream fout;
+	std::string filename, list;
+	unsigned long long windowTicks, endTicks;
+	char number[32];
+
+	snprintf(number, sizeof(number), "%llu", hitch.frame);
+	filename = m_dumpPrefix + number + ".json";
+
+	fout.open(filename);
+	if (fout.fail())
+	{
+		return false;
+	}
+
+	windowTicks = m_frames.empty() ? hitch.startTicks : m_frames.front().startTicks;
+	GetActivities(hitch.startTicks, hitch.endTicks, activities);
+	GetActivities(windowTicks, hitch.endTicks, windowActivities);
+
+	fout << std::fixed << std::setprecision(3);
+	fout << "{\"displayTimeUnit\":\"ms\"," << std::endl;
+	fout << "\"otherData\":{\"frame\":" << hitch.frame << ",\"frame ms\":" << hitch.ms << ",\"average ms\":" << average
+		<< ",\"window frames\":" << m_frames.size() << ",\"activities\":";
+
+	// The activities of the hitch frame as one line of text, trace viewers show otherData as it is.
+	for (auto& activity : activities)
+	{
+		list += (list.empty() ? "" : ", ") + std::string(activity.category) + " " + activity.detail + (activity.endTicks == 0 ? " (going on)" : "");
+	}
+	WriteString(fout, list);
+	fout << "}," << std::endl;
+
+	fout << "\"traceEvents\":[" << std::endl;
+	fout << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"DXEngine\"}}";
+
+	for (auto& frame : m_frames)
+	{
+		WriteCounters(fout, frame);
+	}
+	WriteCounters(fout, hitch);
+
+	fout << "," << std::endl << "{\"name\":\"hitch\",\"ph\":\"X\",\"pid\":1,\"tid\":-1,\"ts\":" << ProfilerClass::GetTraceTime(hitch.startTicks)
+		<< ",\"dur\":" << hitch.ms * 1000.0f << ",\"args\":{\"frame\":" << hitch.frame << ",\"average ms\":" << average << "}}";
+	fout << "," << std::endl << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":-1,\"args\":{\"name\":\"hitches\"}}";
+	fout << "," << std::endl << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":-2,\"args\":{\"name\":\"activities\"}}";
+
+	for (auto& activity : windowActivities)
+	{
+		endTicks = activity.endTicks != 0 ? activity.endTicks : hitch.endTicks;
+		fout << "," << std::endl << "{\"name\":";
+		WriteString(fout, std::string(activity.category) + " " + activity.detail);
+		fout << ",\"ph\":\"X\",\"pid\":1,\"tid\":-2,\"ts\":" << ProfilerClass::GetTraceTime(activity.startTicks) << ",\"dur\":"
+			<< ProfilerClass::GetTraceTime(endTicks) - ProfilerClass::GetTraceTime(activity.startTicks) << "}";
+	}
+
+	ProfilerClass::WriteEvents(fout, windowTicks);
+
+	fout << std::endl << "]}" << std::endl;
+	fout.close();
+	if (fout.fail())
+	{
+		return false;
+	}
+
+	m_lastDump = filename;
+
+	return true;
+}
+
+void HitchDetectorClass::WriteCounters(std::ostream& out, const FrameType& frame)
+{
+	out << "," << std::endl << "{\"name\":\"frame ms\",\"ph\":\"C\",\"pid\":1,\"ts\":" << ProfilerClass::GetTraceTime(frame.startTicks)
+		<< ",\"args\":{\"ms\":" << frame.ms;
+	for (size_t stat = 0; stat < m_statNames.size(); stat++)
+	{
+		out << ",";
+		WriteString(out, m_statNames[stat]);
+		out << ":" << frame.stats[stat];
+	}
+	out << "}}";
+
+	return;
+}
+
+//WriteString writes a JSON string, file names on Windows are full of backslashes
+
+void HitchDetectorClass::WriteString(std::ostream& out, const std::string& text)
+{
+	char escape[8];
+
+	out << "\"";
+	for (auto c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			out << '\\' << c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			snprintf(escape, sizeof(escape), "\\u%04x", (unsigned int)(unsigned char)c);
+			out << escape;
+		}
+		else
+		{
+			out << c;
+		}
+	}
+	out << "\"";
+
+	return;
+}
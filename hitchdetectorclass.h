@@ -0,0 +1,135 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: hitchdetectorclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _HITCHDETECTORCLASS_H_
+#define _HITCHDETECTORCLASS_H_
+
+/*
+The HitchDetectorClass catches the odd frame that takes much longer than the ones around it and writes down what happened around it,
+so a hitch can be looked into after the fact without anyone running a profiler at the time. Frame is called once a frame and measures
+the time since the call before. It keeps the frames of the last few seconds, with their times and whatever stats were set for them
+with SetFrameStat. A frame is a hitch when it takes thresholdRatio times the average of the window and at least thresholdMs more than
+it; the window has to hold MIN_WINDOW_FRAMES frames before anything counts.
+
+A hitch dumps the window to a Chrome trace file named after the dump prefix and the frame number: the frame times and stats as
+counters, the hitch itself, the activities that were going on and every profiler scope of the window (the profiler rings hold the last
+65535 scopes of each thread, seconds' worth at the frame rates we run at). The hitch's activities are also listed in the trace's
+otherData. After a dump, hitches are still counted but not dumped until the window has moved past the dumped one, so a bad patch gives
+one dump.
+
+Activities are the slow things that do not happen every frame, loading a file, compiling a shader, creating a state object. They are
+marked with TRACK_ACTIVITY(category, detail) in the scope that does them. The category has to stay valid for as long as the program
+runs and is also the scope's profiler name, the detail is copied. Marking takes a lock, so it is not meant for anything that happens
+many times a frame. Activities are kept track of whether or not there is a detector.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "profilerclass.h"
+#include <deque>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <ostream>
+
+#define TRACK_ACTIVITY(category, detail) HitchDetectorClass::ActivityType PROFILER_CONCAT(activity, __LINE__)(category, detail)
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: HitchDetectorClass
+////////////////////////////////////////////////////////////////////////////////
+class HitchDetectorClass
+{
+public:
+	//marks an activity from its construction to its destruction, use TRACK_ACTIVITY instead of making one
+	class ActivityType
+	{
+	public:
+		ActivityType(const char*, const std::string&);
+		~ActivityType();
+
+	private:
+		ActivityType(const ActivityType&);
+		ActivityType& operator=(const ActivityType&);
+
+	private:
+		unsigned long long m_id;
+#ifdef PROFILER_ENABLED
+		ProfilerClass::ScopeType m_scope;
+#endif
+	};
+
+	//an activity that overlapped a frame, end is 0 while it is still going on
+	struct ActivityRecordType
+	{
+		unsigned long long id;
+		const char* category;
+		std::string detail;
+		unsigned long long startTicks;
+		unsigned long long endTicks;
+	};
+
+private:
+	static const int MIN_WINDOW_FRAMES = 30;
+	static const int MAX_FRAME_STATS = 8;
+
+	//times are in seconds since Initialize, the ticks are profiler counter values
+	struct FrameType
+	{
+		unsigned long long frame;
+		double start;
+		double end;
+		unsigned long long startTicks;
+		unsigned long long endTicks;
+		float ms;
+		float stats[MAX_FRAME_STATS];
+	};
+
+public:
+	HitchDetectorClass();
+	HitchDetectorClass(const HitchDetectorClass&);
+	~HitchDetectorClass();
+
+	//the window length in seconds, the ratio and milliseconds a frame has to be over the average, and what the dump files start with
+	bool Initialize(float, float, float, const char*);
+	void Shutdown();
+
+	//sets a stat of the frame that is going on, there is room for MAX_FRAME_STATS of them
+	bool SetFrameStat(const char*, float);
+
+	//ends the frame that is going on and starts the next one, true when the frame was a hitch
+	bool Frame();
+
+	unsigned long long GetHitchCount();
+	unsigned long long GetDumpCount();
+	const std::string& GetLastDump();
+
+	//the activities that overlapped the given counter values
+	static void GetActivities(unsigned long long, unsigned long long, std::vector<ActivityRecordType>&);
+
+private:
+	bool WriteDump(const FrameType&, float);
+	void WriteCounters(std::ostream&, const FrameType&);
+	static void WriteString(std::ostream&, const std::string&);
+
+private:
+	float m_windowSeconds;
+	float m_thresholdRatio;
+	float m_thresholdMs;
+	std::string m_dumpPrefix;
+	std::string m_lastDump;
+
+	std::chrono::steady_clock::time_point m_startTime;
+	FrameType m_current;
+	std::deque<FrameType> m_frames;
+	double m_windowSum;
+	double m_quietUntil;
+
+	std::vector<std::string> m_statNames;
+	unsigned long long m_hitches;
+	unsigned long long m_dumps;
+};
+
+#endif
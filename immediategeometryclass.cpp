@@ -0,0 +1,384 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: immediategeometryclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "immediategeometryclass.h"
+#include <cstring>
+
+using namespace DirectX;
+
+//the vertex and pixel shader Initialize creates
+static const RenderShaderDesc s_shaders[] =
+{
+	{ L"VertexShader.hlsl", "ColorVertexShader", false },
+	{ L"PixelShader.hlsl", "ColorPixelShader", true },
+};
+
+ImmediateGeometryClass::ImmediateGeometryClass()
+	: m_device(nullptr)
+	, m_vertexShader(RENDER_NULL_HANDLE)
+	, m_pixelShader(RENDER_NULL_HANDLE)
+	, m_layout(RENDER_NULL_HANDLE)
+	, m_matrixBuffer(RENDER_NULL_HANDLE)
+	, m_rasterizerState(RENDER_NULL_HANDLE)
+	, m_depthStencilState(RENDER_NULL_HANDLE)
+	, m_blendState(RENDER_NULL_HANDLE)
+	, m_batchVertices(0)
+	, m_batchIndices(0)
+	, m_draws(0)
+	, m_dropped(0)
+{
+	m_streams[STREAM_LINES].topology = RENDER_TOPOLOGY_LINELIST;
+	m_streams[STREAM_TRIANGLES].topology = RENDER_TOPOLOGY_TRIANGLELIST;
+}
+
+ImmediateGeometryClass::ImmediateGeometryClass(const ImmediateGeometryClass& other)
+{
+}
+
+
+ImmediateGeometryClass::~ImmediateGeometryClass()
+{
+}
+
+bool ImmediateGeometryClass::Initialize(RenderDeviceClass* device, StateCacheClass* states, unsigned int vertexBytes, unsigned int indexBytes)
+{
+	RenderInputElementDesc polygonLayout[2];
+	RenderBufferDesc matrixBufferDesc;
+	RenderRasterizerDesc rasterizerDesc;
+	RenderDepthStencilDesc depthStencilDesc;
+	RenderBlendDesc blendDesc;
+	bool result;
+
+	m_device = device;
+	m_draws = 0;
+	m_dropped = 0;
+
+	m_vertexShader = device->CreateVertexShader(s_shaders[0].filename, s_shaders[0].entryPoint);
+	if (m_vertexShader == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	m_pixelShader = device->CreatePixelShader(s_shaders[1].filename, s_shaders[1].entryPoint);
+	if (m_pixelShader == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	//position and color, the same as VertexType
+	polygonLayout[0].semanticName = "POSITION";
+	polygonLayout[0].semanticIndex = 0;
+	polygonLayout[0].format = RENDER_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[0].inputSlot = 0;
+	polygonLayout[0].alignedByteOffset = 0;
+
+	polygonLayout[1].semanticName = "COLOR";
+	polygonLayout[1].semanticIndex = 0;
+	polygonLayout[1].format = RENDER_FORMAT_R32G32B32A32_FLOAT;
+	polygonLayout[1].inputSlot = 0;
+	polygonLayout[1].alignedByteOffset = RENDER_APPEND_ALIGNED_ELEMENT;
+
+	m_layout = states->GetInputLayout(polygonLayout, 2, m_vertexShader);
+	if (m_layout == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	memset(&rasterizerDesc, 0, sizeof(rasterizerDesc));
+	rasterizerDesc.fillMode = RENDER_FILL_SOLID;
+	rasterizerDesc.cullMode = RENDER_CULL_NONE;
+	rasterizerDesc.depthClipEnable = true;
+
+	m_rasterizerState = states->GetRasterizerState(rasterizerDesc);
+	if (m_rasterizerState == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	//less equal so lines drawn on top of a surface are not lost to depth fighting
+	memset(&depthStencilDesc, 0, sizeof(depthStencilDesc));
+	depthStencilDesc.depthEnable = true;
+	depthStencilDesc.depthWriteEnable = false;
+	depthStencilDesc.depthFunc = RENDER_COMPARISON_LESS_EQUAL;
+	depthStencilDesc.frontFace.stencilFunc = RENDER_COMPARISON_ALWAYS;
+	depthStencilDesc.backFace.stencilFunc = RENDER_COMPARISON_ALWAYS;
+
+	m_depthStencilState = states->GetDepthStencilState(depthStencilDesc);
+	if (m_depthStencilState == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	memset(&blendDesc, 0, sizeof(blendDesc));
+	blendDesc.blendEnable = true;
+	blendDesc.srcBlend = RENDER_BLEND_SRC_ALPHA;
+	blendDesc.destBlend = RENDER_BLEND_INV_SRC_ALPHA;
+	blendDesc.blendOp = RENDER_BLEND_OP_ADD;
+	blendDesc.srcBlendAlpha = RENDER_BLEND_ONE;
+	blendDesc.destBlendAlpha = RENDER_BLEND_INV_SRC_ALPHA;
+	blendDesc.blendOpAlpha = RENDER_BLEND_OP_ADD;
+	blendDesc.writeMask = 0x0F;
+
+	m_blendState = states->GetBlendState(blendDesc);
+	if (m_blendState == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	memset(&matrixBufferDesc, 0, sizeof(matrixBufferDesc));
+	matrixBufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	matrixBufferDesc.byteWidth = sizeof(MatrixBufferType);
+	matrixBufferDesc.bindType = RENDER_BIND_CONSTANT_BUFFER;
+
+	m_matrixBuffer = device->CreateBuffer(matrixBufferDesc, nullptr);
+	if (m_matrixBuffer == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	result = m_vertexRing.Initialize(device, RENDER_BIND_VERTEX_BUFFER, vertexBytes);
+	if (!result)
+	{
+		return false;
+	}
+
+	result = m_indexRing.Initialize(device, RENDER_BIND_INDEX_BUFFER, indexBytes);
+	if (!result)
+	{
+		return false;
+	}
+
+	// A batch never takes more than a quarter of a ring, so it fits whatever is left after a wrap.
+	m_batchVertices = (int)(vertexBytes / sizeof(VertexType) / 4);
+	m_batchIndices = (int)(indexBytes / sizeof(unsigned int) / 4);
+	if (m_batchVertices < 3 || m_batchIndices < 3)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+const RenderShaderDesc* ImmediateGeometryClass::GetShaders(int& count)
+{
+	count = sizeof(s_shaders) / sizeof(s_shaders[0]);
+	return s_shaders;
+}
+
+void ImmediateGeometryClass::Shutdown()
+{
+	m_vertexRing.Shutdown();
+	m_indexRing.Shutdown();
+
+	for (auto& stream : m_streams)
+	{
+		stream.vertices.clear();
+		stream.indices.clear();
+		stream.batches.clear();
+	}
+
+	if (!m_device)
+	{
+		return;
+	}
+
+	m_device->ReleaseResource(m_matrixBuffer);
+	m_matrixBuffer = RENDER_NULL_HANDLE;
+
+	//the layout and the pipeline states belong to the state cache
+	m_layout = RENDER_NULL_HANDLE;
+	m_rasterizerState = RENDER_NULL_HANDLE;
+	m_depthStencilState = RENDER_NULL_HANDLE;
+	m_blendState = RENDER_NULL_HANDLE;
+
+	m_device->ReleaseResource(m_pixelShader);
+	m_pixelShader = RENDER_NULL_HANDLE;
+
+	m_device->ReleaseResource(m_vertexShader);
+	m_vertexShader = RENDER_NULL_HANDLE;
+
+	m_device = nullptr;
+
+	return;
+}
+
+bool ImmediateGeometryClass::AddLine(const XMFLOAT3& from, const XMFLOAT3& to, const XMFLOAT4& color)
+{
+	VertexType vertices[2];
+	unsigned int indices[2] = { 0, 1 };
+
+	vertices[0].position = from;
+	vertices[0].color = color;
+	vertices[1].position = to;
+	vertices[1].color = color;
+
+	return Add(STREAM_LINES, vertices, 2, indices, 2);
+}
+
+bool ImmediateGeometryClass::AddTriangle(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c, const XMFLOAT4& color)
+{
+	VertexType vertices[3];
+	unsigned int indices[3] = { 0, 1, 2 };
+
+	vertices[0].position = a;
+	vertices[1].position = b;
+	vertices[2].position = c;
+	vertices[0].color = vertices[1].color = vertices[2].color = color;
+
+	return Add(STREAM_TRIANGLES, vertices, 3, indices, 3);
+}
+
+bool ImmediateGeometryClass::AddLines(const VertexType* vertices, int vertexCount, const unsigned int* indices, int indexCount)
+{
+	return Add(STREAM_LINES, vertices, vertexCount, indices, indexCount);
+}
+
+bool ImmediateGeometryClass::AddTriangles(const VertexType* vertices, int vertexCount, const unsigned int* indices, int indexCount)
+{
+	return Add(STREAM_TRIANGLES, vertices, vertexCount, indices, indexCount);
+}
+
+/*
+Render writes every batch into the rings and draws it where it landed: the vertex offset divided by the vertex size is the base vertex
+and the index offset divided by 4 the start index, so the batch's indices need no changing. The rings are bound once for all batches,
+a wrap in between gives the same buffers fresh memory without unbinding them.
+*/
+
+bool ImmediateGeometryClass::Render(RenderContextClass* context, XMMATRIX viewMatrix, XMMATRIX projectionMatrix)
+{
+	MatrixBufferType matrixData;
+	unsigned int vertexOffset, indexOffset;
+	bool result, empty;
+
+	empty = true;
+	for (auto& stream : m_streams)
+	{
+		empty = empty && stream.batches.empty();
+	}
+
+	result = true;
+	if (!empty)
+	{
+		matrixData.world = XMMatrixIdentity();
+		matrixData.view = XMMatrixTranspose(viewMatrix);
+		matrixData.projection = XMMatrixTranspose(projectionMatrix);
+
+		result = context->UpdateBuffer(m_matrixBuffer, &matrixData, sizeof(matrixData));
+
+		context->SetVSConstantBuffer(0, m_matrixBuffer);
+		context->SetInputLayout(m_layout);
+		context->SetVertexShader(m_vertexShader);
+		context->SetPixelShader(m_pixelShader);
+		context->SetRasterizerState(m_rasterizerState);
+		context->SetDepthStencilState(m_depthStencilState, 0);
+		context->SetBlendState(m_blendState);
+		context->SetVertexBuffer(0, m_vertexRing.GetBuffer(), sizeof(VertexType), 0);
+		context->SetIndexBuffer(m_indexRing.GetBuffer(), RENDER_FORMAT_R32_UINT, 0);
+	}
+
+	for (auto& stream : m_streams)
+	{
+		if (result && !stream.batches.empty())
+		{
+			context->SetPrimitiveTopology(stream.topology);
+		}
+
+		for (auto& batch : stream.batches)
+		{
+			if (!result)
+			{
+				break;
+			}
+
+			result = m_vertexRing.Write(context, &stream.vertices[batch.firstVertex], batch.vertexCount * sizeof(VertexType), sizeof(VertexType),
+				vertexOffset) && m_indexRing.Write(context, &stream.indices[batch.firstIndex], batch.indexCount * sizeof(unsigned int),
+				sizeof(unsigned int), indexOffset);
+			if (result)
+			{
+				context->DrawIndexed(batch.indexCount, indexOffset / sizeof(unsigned int), vertexOffset / sizeof(VertexType));
+				m_draws++;
+			}
+		}
+
+		stream.vertices.clear();
+		stream.indices.clear();
+		stream.batches.clear();
+	}
+
+	m_vertexRing.EndFrame();
+	m_indexRing.EndFrame();
+
+	return result;
+}
+
+void ImmediateGeometryClass::GetStats(StatsType& stats)
+{
+	const RingBufferClass::StatsType& vertexStats = m_vertexRing.GetStats();
+	const RingBufferClass::StatsType& indexStats = m_indexRing.GetStats();
+
+	stats.bytesStreamed = vertexStats.bytesStreamed + indexStats.bytesStreamed;
+	stats.wraps = vertexStats.wraps + indexStats.wraps;
+	stats.wrapStalls = vertexStats.wrapStalls + indexStats.wrapStalls;
+	stats.draws = m_draws;
+	stats.dropped = m_dropped;
+
+	return;
+}
+
+void ImmediateGeometryClass::ResetStats()
+{
+	m_vertexRing.ResetStats();
+	m_indexRing.ResetStats();
+	m_draws = 0;
+	m_dropped = 0;
+
+	return;
+}
+
+//Add appends to the stream's last batch, or starts a new one when this would take the batch over a quarter of a ring.
+
+bool ImmediateGeometryClass::Add(StreamKind kind, const VertexType* vertices, int vertexCount, const unsigned int* indices, int indexCount)
+{
+	StreamType& stream = m_streams[kind];
+	BatchType batch;
+	int base;
+
+	if (!vertices || !indices || vertexCount <= 0 || indexCount <= 0 || vertexCount > m_batchVertices || indexCount > m_batchIndices)
+	{
+		m_dropped++;
+		return false;
+	}
+
+	for (auto i = 0; i < indexCount; i++)
+	{
+		if (indices[i] >= (unsigned int)vertexCount)
+		{
+			m_dropped++;
+			return false;
+		}
+	}
+
+	if (stream.batches.empty() || stream.batches.back().vertexCount + vertexCount > m_batchVertices ||
+		stream.batches.back().indexCount + indexCount > m_batchIndices)
+	{
+		batch.firstVertex = (int)stream.vertices.size();
+		batch.vertexCount = 0;
+		batch.firstIndex = (int)stream.indices.size();
+		batch.indexCount = 0;
+		stream.batches.push_back(batch);
+	}
+
+	BatchType& last = stream.batches.back();
+	base = last.vertexCount;
+
+	stream.vertices.insert(stream.vertices.end(), vertices, vertices + vertexCount);
+	for (auto i = 0; i < indexCount; i++)
+	{
+		stream.indices.push_back(indices[i] + (unsigned int)base);
+	}
+
+	last.vertexCount += vertexCount;
+	last.indexCount += indexCount;
+
+	return true;
+}
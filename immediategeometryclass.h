@@ -0,0 +1,131 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: immediategeometryclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _IMMEDIATEGEOMETRYCLASS_H_
+#define _IMMEDIATEGEOMETRYCLASS_H_
+
+/*
+The ImmediateGeometryClass draws geometry the CPU makes up during the frame: debug lines, particles, deformed meshes. Anything can call
+the Add functions during the frame, they only append to a system memory batch per primitive type with the indices moved up to the
+batch's vertices. Render streams each batch through a vertex and an index RingBufferClass and draws it with one DrawIndexed, so a
+frame's transient geometry takes a draw or two however many pieces it was added in. Batches are capped at a quarter of a ring so they
+always fit, a frame with more than that just gets more batches.
+
+The vertices are a position and a color, drawn with the color shader in VertexShader.hlsl and PixelShader.hlsl. The positions are in
+world space. Both sides of triangles are drawn, alpha blended and depth tested against the scene without writing depth, so the colors'
+alpha makes them see through. The Add functions are not thread safe, Render has to run on the immediate context once per frame.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <DirectXMath.h>
+#include "renderdeviceclass.h"
+#include "ringbufferclass.h"
+#include "statecacheclass.h"
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ImmediateGeometryClass
+////////////////////////////////////////////////////////////////////////////////
+class ImmediateGeometryClass
+{
+public:
+	struct VertexType
+	{
+		DirectX::XMFLOAT3 position;
+		DirectX::XMFLOAT4 color;
+	};
+
+	struct StatsType
+	{
+		unsigned long long bytesStreamed;
+		unsigned long long wraps;
+		unsigned long long wrapStalls;
+		unsigned long long draws;
+		unsigned long long dropped;
+	};
+
+private:
+	enum StreamKind
+	{
+		STREAM_LINES,
+		STREAM_TRIANGLES,
+		STREAM_COUNT
+	};
+
+	struct MatrixBufferType
+	{
+		DirectX::XMMATRIX world;
+		DirectX::XMMATRIX view;
+		DirectX::XMMATRIX projection;
+	};
+
+	//a run of vertices and indices drawn with one DrawIndexed, its indices count from its own first vertex
+	struct BatchType
+	{
+		int firstVertex;
+		int vertexCount;
+		int firstIndex;
+		int indexCount;
+	};
+
+	struct StreamType
+	{
+		RenderTopology topology;
+		std::vector<VertexType> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<BatchType> batches;
+	};
+
+public:
+	ImmediateGeometryClass();
+	ImmediateGeometryClass(const ImmediateGeometryClass&);
+	~ImmediateGeometryClass();
+
+	//device, the state cache the input layout and pipeline states come from, then the size of the vertex and the index ring in bytes
+	bool Initialize(RenderDeviceClass*, StateCacheClass*, unsigned int, unsigned int);
+	void Shutdown();
+
+	//the shaders Initialize creates, so they can be compiled before the device is there
+	static const RenderShaderDesc* GetShaders(int&);
+
+	bool AddLine(const DirectX::XMFLOAT3&, const DirectX::XMFLOAT3&, const DirectX::XMFLOAT4&);
+	bool AddTriangle(const DirectX::XMFLOAT3&, const DirectX::XMFLOAT3&, const DirectX::XMFLOAT3&, const DirectX::XMFLOAT4&);
+
+	//indexed line and triangle lists, the indices count from the first of the given vertices
+	bool AddLines(const VertexType*, int, const unsigned int*, int);
+	bool AddTriangles(const VertexType*, int, const unsigned int*, int);
+
+	//streams and draws everything added since the last Render with the given view and projection matrices
+	bool Render(RenderContextClass*, DirectX::XMMATRIX, DirectX::XMMATRIX);
+
+	void GetStats(StatsType&);
+	void ResetStats();
+
+private:
+	bool Add(StreamKind, const VertexType*, int, const unsigned int*, int);
+
+private:
+	RenderDeviceClass* m_device;
+	RenderHandle m_vertexShader;
+	RenderHandle m_pixelShader;
+	RenderHandle m_layout;
+	RenderHandle m_matrixBuffer;
+	RenderHandle m_rasterizerState;
+	RenderHandle m_depthStencilState;
+	RenderHandle m_blendState;
+
+	RingBufferClass m_vertexRing;
+	RingBufferClass m_indexRing;
+	int m_batchVertices;
+	int m_batchIndices;
+
+	StreamType m_streams[STREAM_COUNT];
+	unsigned long long m_draws;
+	unsigned long long m_dropped;
+};
+
+#endif
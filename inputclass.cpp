@@ -25,29 +25,121 @@ void InputClass::Initialize()
 	for (auto i = 0; i < 256; i++)
 	{
 		m_keys[i] = false;
+		m_pressCounts[i] = 0;
+		m_released[i] = false;
 	}
 
+	m_events.Clear();
+	m_lastEventTime = 0;
+
 	return;
 }
 
-void InputClass::KeyDown(unsigned int input)
+bool InputClass::KeyDown(unsigned int input, unsigned long long time)
 {
-	// If a key is pressed then save that state in the key array.
-	m_keys[input] = true;
-	return;
+	EventType event;
+
+	// If a key is pressed then queue that for the next frame.
+	event.key = input;
+	event.down = true;
+	event.time = time;
+
+	return m_events.Push(event);
 }
 
 
-void InputClass::KeyUp(unsigned int input)
+bool InputClass::KeyUp(unsigned int input, unsigned long long time)
 {
-	// If a key is released then clear that state in the key array.
-	m_keys[input] = false;
-	return;
+	EventType event;
+
+	// If a key is released then queue that for the next frame.
+	event.key = input;
+	event.down = false;
+	event.time = time;
+
+	return m_events.Push(event);
+}
+
+
+unsigned long long InputClass::GetDroppedCount()
+{
+	return m_events.GetDroppedCount();
+}
+
+
+/*
+Frame starts the frame's key state from where the last frame left the keys and plays the queued events over it. A key can go down and
+up again any number of times in one frame, it is counted every time it goes down, so nothing pressed between two frames goes unseen.
+Keys outside of the 256 virtual key codes are taken out of the queue and ignored.
+*/
+
+int InputClass::Frame()
+{
+	EventType event;
+	int count;
+
+	for (auto i = 0; i < 256; i++)
+	{
+		m_pressCounts[i] = 0;
+		m_released[i] = false;
+	}
+
+	count = 0;
+	while (m_events.Pop(event))
+	{
+		count++;
+		m_lastEventTime = event.time;
+
+		if (event.key >= 256)
+		{
+			continue;
+		}
+
+		if (event.down)
+		{
+			// Key repeat sends more downs while the key is held, only a key that was up is pressed again.
+			if (!m_keys[event.key] && m_pressCounts[event.key] < 255)
+			{
+				m_pressCounts[event.key]++;
+			}
+			m_keys[event.key] = true;
+		}
+		else
+		{
+			m_keys[event.key] = false;
+			m_released[event.key] = true;
+		}
+	}
+
+	return count;
 }
 
 
 bool InputClass::IsKeyDown(unsigned int key)
 {
-	// Return what state the key is in (pressed/not pressed).
-	return m_keys[key];
+	if (key >= 256)
+	{
+		return false;
+	}
+
+	// Return whether the key is down or went down during the frame.
+	return m_keys[key] || m_pressCounts[key] > 0;
+}
+
+
+int InputClass::GetPressCount(unsigned int key)
+{
+	return key < 256 ? m_pressCounts[key] : 0;
+}
+
+
+bool InputClass::WasKeyReleased(unsigned int key)
+{
+	return key < 256 && m_released[key];
+}
+
+
+unsigned long long InputClass::GetLastEventTime()
+{
+	return m_lastEventTime;
 }
\ No newline at end of file
@@ -6,12 +6,37 @@
 #ifndef _INPUTCLASS_H_
 #define _INPUTCLASS_H_
 
+/*
+The InputClass keeps the state of the keyboard as the window's message handler reports it. Every key event comes with the time it was
+handled, on the LatencyTrackerClass clock, and goes into an EventQueueClass ring instead of straight into the key state, so the message
+pump and the simulation can be on different threads and a key pressed and released between two frames is not lost.
+
+KeyDown and KeyUp are the producer side, they only push. Frame is the consumer side: once a frame it takes every event queued so far,
+in order, and works out the frame's key state from them. IsKeyDown is true for a key that is down or went down during the frame, so a
+short press is seen for one frame; GetPressCount and WasKeyReleased say what happened during the frame. Everything but KeyDown and
+KeyUp belongs to the thread calling Frame. A full ring drops the new event, QUEUE_SIZE events are far more than a frame gets.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "eventqueueclass.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: InputClass
 ////////////////////////////////////////////////////////////////////////////////
 class InputClass
 {
+private:
+	static const unsigned int QUEUE_SIZE = 256;
+
+	struct EventType
+	{
+		unsigned int key;
+		bool down;
+		unsigned long long time;
+	};
+
 public:
 	InputClass();
 	InputClass(const InputClass&);
@@ -19,13 +44,29 @@ public:
 
 	void Initialize();
 
-	void KeyDown(unsigned int);
-	void KeyUp(unsigned int);
+	//the key and when its message was handled, false when the event was dropped
+	bool KeyDown(unsigned int, unsigned long long);
+	bool KeyUp(unsigned int, unsigned long long);
+	unsigned long long GetDroppedCount();
+
+	//takes the events queued since the last call and returns how many there were
+	int Frame();
 
 	bool IsKeyDown(unsigned int);
+	int GetPressCount(unsigned int);
+	bool WasKeyReleased(unsigned int);
+
+	//the time of the newest key event Frame took, 0 before the first one
+	unsigned long long GetLastEventTime();
 
 private:
+	EventQueueClass<EventType, QUEUE_SIZE> m_events;
+
+	//the frame's key state: down at the end of the frame, how often it went down and whether it went up during the frame
 	bool m_keys[256];
+	unsigned char m_pressCounts[256];
+	bool m_released[256];
+	unsigned long long m_lastEventTime;
 };
 
 #endif
\ No newline at end of file
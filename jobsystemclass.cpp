@@ -0,0 +1,615 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobsystemclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "jobsystemclass.h"
+#include "profilerclass.h"
+#include <string>
+
+//the job system and worker index of the current thread, only set for the worker threads, worker 0 is told apart by its thread id
+static thread_local JobSystemClass* t_jobSystem = nullptr;
+static thread_local int t_workerIndex = -1;
+
+JobSystemClass::JobSystemClass()
+	: m_threadCount(0)
+	, m_mainThread(std::thread::id())
+	, m_sleepingCount(0)
+	, m_shutdown(false)
+{
+}
+
+JobSystemClass::JobSystemClass(const JobSystemClass& other)
+{
+}
+
+
+JobSystemClass::~JobSystemClass()
+{
+}
+
+//Initialize starts the worker threads, a threadCount of 0 uses one thread per core and 1 runs everything on the calling thread.
+
+bool JobSystemClass::Initialize(int threadCount)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+		if (threadCount <= 0)
+		{
+			threadCount = 1;
+		}
+	}
+
+	m_threadCount = threadCount;
+	for (auto i = 0; i < threadCount; i++)
+	{
+		std::unique_ptr<WorkerType> worker(new WorkerType);
+
+		worker->top = 0;
+		worker->bottom = 0;
+		worker->deque.reset(new std::atomic<JobType*>[DEQUE_SIZE]);
+		worker->jobs.reset(new JobType[JOB_POOL_SIZE]);
+		for (auto j = 0; j < JOB_POOL_SIZE; j++)
+		{
+			worker->jobs[j].finished = true;
+		}
+		worker->nextJob = 0;
+		worker->random = 2654435761u * (unsigned int)(i + 1);
+		worker->executedCount = 0;
+		worker->stealCount = 0;
+
+		m_workerData.push_back(std::move(worker));
+	}
+
+	m_mainThread = std::this_thread::get_id();
+
+	m_shutdown = false;
+	m_sleepingCount = 0;
+	for (auto i = 1; i < threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystemClass::WorkerThread, this, i));
+	}
+
+	return true;
+}
+
+//Shutdown expects every job to be finished, anything still queued is dropped.
+
+void JobSystemClass::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_shutdown = true;
+	}
+	m_workCondition.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+	m_workerData.clear();
+	m_threadCount = 0;
+	m_mainThread = std::thread::id();
+
+	return;
+}
+
+void JobSystemClass::SetMainThread(std::thread::id thread)
+{
+	m_mainThread = thread;
+	return;
+}
+
+void JobSystemClass::Run(JobFunctionType function, void* data, CounterType* counter, CounterType* dependency)
+{
+	JobType* job;
+	int worker;
+
+	worker = GetWorkerIndex();
+	if (worker < 0)
+	{
+		WaitForDependency(dependency);
+		function(data, 0, 1);
+		return;
+	}
+
+	if (counter)
+	{
+		counter->value.fetch_add(1);
+	}
+
+	job = AllocateJob(worker);
+	job->function = function;
+	job->data = data;
+	job->begin = 0;
+	job->end = 1;
+	job->grain = 0;
+	job->counter = counter;
+
+	Submit(worker, job, dependency);
+
+	return;
+}
+
+/*
+ParallelFor starts a single job for the whole range, Execute does the splitting. That way the range is only cut up as far as there are
+idle workers stealing pieces: with everyone busy a worker just walks down its own deque.
+*/
+
+void JobSystemClass::ParallelFor(int count, int grain, JobFunctionType function, void* data, CounterType* counter, CounterType* dependency)
+{
+	JobType* job;
+	int worker;
+
+	if (count <= 0)
+	{
+		return;
+	}
+
+	worker = GetWorkerIndex();
+	if (worker < 0)
+	{
+		WaitForDependency(dependency);
+		function(data, 0, count);
+		return;
+	}
+
+	if (grain <= 0)
+	{
+		grain = count / (m_threadCount * GRAIN_SPLITS);
+		if (grain < 1)
+		{
+			grain = 1;
+		}
+	}
+
+	if (counter)
+	{
+		counter->value.fetch_add(1);
+	}
+
+	job = AllocateJob(worker);
+	job->function = function;
+	job->data = data;
+	job->begin = 0;
+	job->end = count;
+	job->grain = grain;
+	job->counter = counter;
+
+	Submit(worker, job, dependency);
+
+	return;
+}
+
+/*
+Wait is where the calling thread helps out: it runs its own jobs and steals others until the counter is done. The last Finish drops
+the counter to zero while holding its mutex, so taking the mutex once more at the end makes sure nobody still touches the counter
+after Wait returns and the caller is free to destroy it.
+*/
+
+void JobSystemClass::Wait(CounterType* counter)
+{
+	JobType* job;
+	int worker;
+
+	worker = GetWorkerIndex();
+	while (counter->value.load(std::memory_order_acquire) > 0)
+	{
+		if (worker >= 0)
+		{
+			job = FindJob(worker);
+			if (job)
+			{
+				Execute(worker, job);
+				continue;
+			}
+		}
+
+		std::this_thread::yield();
+	}
+
+	std::lock_guard<std::mutex> lock(counter->mutex);
+
+	return;
+}
+
+void JobSystemClass::Increment(CounterType* counter, int count)
+{
+	counter->value.fetch_add(count);
+	return;
+}
+
+void JobSystemClass::Decrement(CounterType* counter)
+{
+	Finish(GetWorkerIndex(), counter);
+	return;
+}
+
+int JobSystemClass::GetThreadCount()
+{
+	return m_threadCount;
+}
+
+int JobSystemClass::GetExecutedCount()
+{
+	int count;
+
+	count = 0;
+	for (auto& worker : m_workerData)
+	{
+		count += worker->executedCount.load(std::memory_order_relaxed);
+	}
+
+	return count;
+}
+
+int JobSystemClass::GetStealCount()
+{
+	int count;
+
+	count = 0;
+	for (auto& worker : m_workerData)
+	{
+		count += worker->stealCount.load(std::memory_order_relaxed);
+	}
+
+	return count;
+}
+
+void JobSystemClass::ResetCounters()
+{
+	for (auto& worker : m_workerData)
+	{
+		worker->executedCount.store(0, std::memory_order_relaxed);
+		worker->stealCount.store(0, std::memory_order_relaxed);
+	}
+
+	return;
+}
+
+int JobSystemClass::GetWorkerIndex()
+{
+	if (t_jobSystem == this)
+	{
+		return t_workerIndex;
+	}
+
+	return m_mainThread.load(std::memory_order_relaxed) == std::this_thread::get_id() ? 0 : -1;
+}
+
+/*
+AllocateJob hands out the worker's jobs round robin, so the next job in line is the oldest one and nearly always finished. When it is
+not, the worker has started JOB_POOL_SIZE jobs faster than they get done and runs queued jobs itself until it is free, which empties
+its deque and makes the following allocations cheap again. Only when there is nothing to run (the job waits on a dependency) does it
+look through the whole pool for any free job.
+*/
+
+JobSystemClass::JobType* JobSystemClass::AllocateJob(int worker)
+{
+	WorkerType& data = *m_workerData[worker];
+	JobType* job;
+
+	while (true)
+	{
+		job = &data.jobs[data.nextJob];
+		if (job->finished.load(std::memory_order_acquire))
+		{
+			data.nextJob = (data.nextJob + 1) & (JOB_POOL_SIZE - 1);
+			job->finished.store(false, std::memory_order_relaxed);
+			return job;
+		}
+
+		job = FindJob(worker);
+		if (job)
+		{
+			Execute(worker, job);
+			continue;
+		}
+
+		for (auto i = 0; i < JOB_POOL_SIZE; i++)
+		{
+			job = &data.jobs[i];
+			if (job->finished.load(std::memory_order_acquire))
+			{
+				job->finished.store(false, std::memory_order_relaxed);
+				return job;
+			}
+		}
+
+		std::this_thread::yield();
+	}
+}
+
+//Submit queues the job, or parks it on the dependency counter if that one has not reached zero yet. Finish queues it from there.
+
+void JobSystemClass::Submit(int worker, JobType* job, CounterType* dependency)
+{
+	if (dependency)
+	{
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if (dependency->value.load() > 0)
+		{
+			dependency->waiting.push_back(job);
+			return;
+		}
+	}
+
+	Push(worker, job);
+
+	return;
+}
+
+//threads outside the pool cannot run other jobs, so they just wait for the dependency to finish
+
+void JobSystemClass::WaitForDependency(CounterType* dependency)
+{
+	if (dependency)
+	{
+		Wait(dependency);
+	}
+
+	return;
+}
+
+/*
+Push, Pop and Steal are the Chase-Lev work stealing deque. The owner moves bottom, thieves move top with a compare and swap, and the only
+time the two can want the same job is when one job is left, then the owner takes part in the compare and swap too. The bottom and top
+accesses that decide this are sequentially consistent so the owner and a thief can never both miss each other's update.
+A full deque runs the job straight away instead of growing.
+*/
+
+void JobSystemClass::Push(int worker, JobType* job)
+{
+	WorkerType& data = *m_workerData[worker];
+	long long bottom, top;
+
+	bottom = data.bottom.load(std::memory_order_relaxed);
+	top = data.top.load(std::memory_order_acquire);
+	if (bottom - top >= DEQUE_SIZE)
+	{
+		Execute(worker, job);
+		return;
+	}
+
+	data.deque[bottom & (DEQUE_SIZE - 1)].store(job, std::memory_order_relaxed);
+	data.bottom.store(bottom + 1);
+
+	// Pairs with the sleeping worker raising m_sleepingCount before it looks at the deques one last time.
+	if (m_sleepingCount.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_workCondition.notify_one();
+	}
+
+	return;
+}
+
+JobSystemClass::JobType* JobSystemClass::Pop(int worker)
+{
+	WorkerType& data = *m_workerData[worker];
+	JobType* job;
+	long long bottom, top;
+
+	bottom = data.bottom.load(std::memory_order_relaxed) - 1;
+	data.bottom.store(bottom);
+	top = data.top.load();
+
+	if (top > bottom)
+	{
+		data.bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	job = data.deque[bottom & (DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		if (!data.top.compare_exchange_strong(top, top + 1))
+		{
+			job = nullptr;
+		}
+		data.bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+JobSystemClass::JobType* JobSystemClass::Steal(int worker)
+{
+	WorkerType& data = *m_workerData[worker];
+	JobType* job;
+	long long bottom, top;
+	int victim;
+
+	// xorshift so the workers do not all go for the same victim
+	data.random ^= data.random << 13;
+	data.random ^= data.random >> 17;
+	data.random ^= data.random << 5;
+
+	for (auto i = 0; i < m_threadCount; i++)
+	{
+		victim = (int)((data.random + (unsigned int)i) % (unsigned int)m_threadCount);
+		if (victim == worker)
+		{
+			continue;
+		}
+
+		WorkerType& victimData = *m_workerData[victim];
+		top = victimData.top.load();
+		bottom = victimData.bottom.load();
+		if (top < bottom)
+		{
+			job = victimData.deque[top & (DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+			if (victimData.top.compare_exchange_strong(top, top + 1))
+			{
+				data.stealCount.store(data.stealCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+	}
+
+	return nullptr;
+}
+
+JobSystemClass::JobType* JobSystemClass::FindJob(int worker)
+{
+	JobType* job;
+
+	job = Pop(worker);
+	if (!job)
+	{
+		job = Steal(worker);
+	}
+
+	return job;
+}
+
+bool JobSystemClass::HasQueuedJobs()
+{
+	for (auto& worker : m_workerData)
+	{
+		if (worker->bottom.load() > worker->top.load())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+Execute first splits a ParallelFor job: the upper half of the range goes back onto the deque as a new job until the rest is no bigger
+than the grain. Each split adds one to the counter, so the counter only reaches zero once every piece is done.
+*/
+
+void JobSystemClass::Execute(int worker, JobType* job)
+{
+	WorkerType& data = *m_workerData[worker];
+	CounterType* counter;
+	JobType* split;
+	int middle;
+
+	while (job->grain > 0 && job->end - job->begin > job->grain)
+	{
+		middle = job->begin + (job->end - job->begin) / 2;
+
+		if (job->counter)
+		{
+			job->counter->value.fetch_add(1);
+		}
+
+		split = AllocateJob(worker);
+		split->function = job->function;
+		split->data = job->data;
+		split->begin = middle;
+		split->end = job->end;
+		split->grain = job->grain;
+		split->counter = job->counter;
+		Push(worker, split);
+
+		job->end = middle;
+	}
+
+	job->function(job->data, job->begin, job->end);
+	data.executedCount.store(data.executedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+	counter = job->counter;
+	job->finished.store(true, std::memory_order_release);
+
+	if (counter)
+	{
+		Finish(worker, counter);
+	}
+
+	return;
+}
+
+/*
+Finish counts a job off. Only the step down to zero takes the counter's mutex, which is also what Submit holds while it decides whether
+a job has to wait, so a job either sees the counter above zero and gets parked or sees zero and runs, never neither.
+*/
+
+void JobSystemClass::Finish(int worker, CounterType* counter)
+{
+	std::vector<JobType*> waiting;
+	CounterType* jobCounter;
+	int value;
+
+	value = counter->value.load();
+	while (value > 1)
+	{
+		if (counter->value.compare_exchange_weak(value, value - 1))
+		{
+			return;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		if (counter->value.fetch_sub(1) == 1)
+		{
+			waiting.swap(counter->waiting);
+		}
+	}
+
+	// Threads outside the pool have no deque, they run the jobs that were waiting themselves.
+	for (auto job : waiting)
+	{
+		if (worker >= 0)
+		{
+			Push(worker, job);
+		}
+		else
+		{
+			job->function(job->data, job->begin, job->end);
+			jobCounter = job->counter;
+			job->finished.store(true, std::memory_order_release);
+			if (jobCounter)
+			{
+				Finish(-1, jobCounter);
+			}
+		}
+	}
+
+	return;
+}
+
+//Worker threads look for jobs, spin a little when there are none and then go to sleep until Push wakes them.
+
+void JobSystemClass::WorkerThread(int index)
+{
+	JobType* job;
+	int spins;
+
+	t_jobSystem = this;
+	t_workerIndex = index;
+	PROFILE_THREAD_NAME(("job worker " + std::to_string(index)).c_str());
+
+	spins = 0;
+	while (!m_shutdown.load(std::memory_order_acquire))
+	{
+		job = FindJob(index);
+		if (job)
+		{
+			Execute(index, job);
+			spins = 0;
+			continue;
+		}
+
+		if (++spins < SPIN_COUNT)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_workMutex);
+		m_sleepingCount.fetch_add(1);
+		if (!m_shutdown && !HasQueuedJobs())
+		{
+			m_workCondition.wait(lock);
+		}
+		m_sleepingCount.fetch_sub(1);
+		spins = 0;
+	}
+
+	return;
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobsystemclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _JOBSYSTEMCLASS_H_
+#define _JOBSYSTEMCLASS_H_
+
+/*
+The JobSystemClass runs small pieces of work (jobs) on a fixed set of worker threads, one per core by default. The thread that calls
+Initialize counts as worker 0 and takes part whenever it waits for something, so no core sits idle while the main thread blocks. When
+another thread is going to be the one waiting for the jobs, like a render thread, SetMainThread hands worker 0 over to it.
+
+Every worker has its own Chase-Lev deque of jobs. A worker pushes and pops jobs at the bottom of its own deque without taking a lock,
+and when it runs dry it steals from the top of a random other worker's deque. The owner works on the newest job (the one whose data is
+still in its cache) while thieves take the oldest, which for split up work is also the biggest piece.
+
+Jobs report to a CounterType when they finish. Wait keeps running jobs until the counter reaches zero, and a job can be started after
+another counter instead of straight away, which is how dependencies between groups of jobs are expressed without ever blocking a
+worker. ParallelFor splits a range in halves on the fly: a job keeps handing the upper half of its range to its deque until what is
+left is no bigger than the grain, so idle workers always find big pieces to steal. A grain of 0 picks one that gives each worker
+about GRAIN_SPLITS pieces.
+
+Jobs can only be started from the pool's own threads. Any other thread runs its jobs straight away.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: JobSystemClass
+////////////////////////////////////////////////////////////////////////////////
+class JobSystemClass
+{
+public:
+	//a job gets its data pointer and the part of the range it should do, plain jobs get 0 and 1
+	typedef void (*JobFunctionType)(void*, int, int);
+
+private:
+	//every worker has a deque of DEQUE_SIZE entries and JOB_POOL_SIZE jobs to hand out, both must be powers of two
+	static const int DEQUE_SIZE = 4096;
+	static const int JOB_POOL_SIZE = 4096;
+	static const int GRAIN_SPLITS = 4;
+	static const int SPIN_COUNT = 64;
+
+	struct JobType;
+
+public:
+	//counts the jobs that have not finished yet, jobs started after the counter run once it drops to zero
+	struct CounterType
+	{
+		CounterType() : value(0) {}
+
+		std::atomic<int> value;
+		std::mutex mutex;
+		std::vector<JobType*> waiting;
+	};
+
+private:
+	struct JobType
+	{
+		JobFunctionType function;
+		void* data;
+		int begin;
+		int end;
+		int grain;
+		CounterType* counter;
+		std::atomic<bool> finished;
+	};
+
+	//one worker's deque and job pool. top is only moved by thieves and the owner's last pop, bottom only by the owner.
+	struct WorkerType
+	{
+		alignas(64) std::atomic<long long> top;
+		alignas(64) std::atomic<long long> bottom;
+		std::unique_ptr<std::atomic<JobType*>[]> deque;
+		std::unique_ptr<JobType[]> jobs;
+		int nextJob;
+		unsigned int random;
+		std::atomic<int> executedCount;
+		std::atomic<int> stealCount;
+	};
+
+public:
+	JobSystemClass();
+	JobSystemClass(const JobSystemClass&);
+	~JobSystemClass();
+
+	bool Initialize(int);
+	void Shutdown();
+
+	//makes the given thread worker 0 in place of the one that called Initialize, which runs its jobs straight away from then on like
+	//any other thread. Only while no jobs are queued, and before the new thread starts or waits for its first job.
+	void SetMainThread(std::thread::id);
+
+	//counter and dependency may be nullptr. The job runs once the dependency counter is at zero.
+	void Run(JobFunctionType, void*, CounterType*, CounterType* = nullptr);
+
+	//calls the function with pieces of [0, count) of at most grain items each
+	void ParallelFor(int, int, JobFunctionType, void*, CounterType*, CounterType* = nullptr);
+
+	//runs jobs on the calling thread until the counter reaches zero
+	void Wait(CounterType*);
+
+	//a counter can also stand for work that is not a job: Increment raises it by hand and every Decrement counts one piece off
+	void Increment(CounterType*, int);
+	void Decrement(CounterType*);
+
+	//ParallelFor for any callable taking a begin and end index, returns once the whole range is done
+	template <typename FunctionType>
+	void ParallelFor(int count, int grain, const FunctionType& function)
+	{
+		CounterType counter;
+
+		ParallelFor(count, grain, [](void* data, int begin, int end) { (*(const FunctionType*)data)(begin, end); }, (void*)&function,
+			&counter);
+		Wait(&counter);
+
+		return;
+	}
+
+	int GetThreadCount();
+	int GetExecutedCount();
+	int GetStealCount();
+	void ResetCounters();
+
+private:
+	int GetWorkerIndex();
+	JobType* AllocateJob(int);
+	void Submit(int, JobType*, CounterType*);
+	void WaitForDependency(CounterType*);
+	void Push(int, JobType*);
+	JobType* Pop(int);
+	JobType* Steal(int);
+	JobType* FindJob(int);
+	bool HasQueuedJobs();
+	void Execute(int, JobType*);
+	void Finish(int, CounterType*);
+	void WorkerThread(int);
+
+private:
+	std::vector<std::unique_ptr<WorkerType>> m_workerData;
+	std::vector<std::thread> m_workers;
+	int m_threadCount;
+
+	//worker 0 is not one of m_workers, it is whichever thread this is
+	std::atomic<std::thread::id> m_mainThread;
+
+	//idle workers sleep on m_workCondition once every deque is empty, Push only takes the lock when someone is asleep
+	std::atomic<int> m_sleepingCount;
+	std::mutex m_workMutex;
+	std::condition_variable m_workCondition;
+	std::atomic<bool> m_shutdown;
+};
+
+#endif
@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: latencytrackerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "latencytrackerclass.h"
+#include <algorithm>
+#include <iomanip>
+#include <cmath>
+
+LatencyTrackerClass::LatencyTrackerClass()
+	: m_maxSamples(0)
+	, m_nextSample(0)
+	, m_sampleCount(0)
+	, m_lastLatency(0.0f)
+	, m_lastInputTime(0)
+	, m_nextPresent(0)
+{
+	for (auto i = 0; i < PRESENT_HISTORY; i++)
+	{
+		m_presentTimes[i] = 0;
+	}
+}
+
+LatencyTrackerClass::LatencyTrackerClass(const LatencyTrackerClass& other)
+{
+}
+
+
+LatencyTrackerClass::~LatencyTrackerClass()
+{
+}
+
+bool LatencyTrackerClass::Initialize(int maxSamples)
+{
+	if (maxSamples <= 0)
+	{
+		return false;
+	}
+
+	m_maxSamples = maxSamples;
+	m_latencies.reserve(maxSamples);
+	m_frames.reserve(maxSamples);
+	Reset();
+
+	return true;
+}
+
+void LatencyTrackerClass::Shutdown()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_latencies.clear();
+	m_frames.clear();
+	m_maxSamples = 0;
+
+	return;
+}
+
+/*
+Present keeps the time of the present and, when the frame carries a stamp it has not seen yet, adds a sample. The frames are the
+presents since the input, this one included; an input older than all of the kept presents counts as PRESENT_HISTORY frames.
+*/
+
+void LatencyTrackerClass::Present(unsigned long long inputTime)
+{
+	unsigned long long now;
+	int frames;
+
+	now = GetTime();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_presentTimes[m_nextPresent] = now;
+	m_nextPresent = (m_nextPresent + 1) % PRESENT_HISTORY;
+
+	if (inputTime == 0 || inputTime <= m_lastInputTime || m_maxSamples == 0)
+	{
+		return;
+	}
+	m_lastInputTime = inputTime;
+
+	frames = 0;
+	for (auto i = 0; i < PRESENT_HISTORY; i++)
+	{
+		if (m_presentTimes[i] >= inputTime)
+		{
+			frames++;
+		}
+	}
+
+	m_lastLatency = (float)(now - inputTime) / 1000000.0f;
+
+	if ((int)m_latencies.size() < m_maxSamples)
+	{
+		m_latencies.push_back(m_lastLatency);
+		m_frames.push_back((float)frames);
+	}
+	else
+	{
+		m_latencies[m_nextSample] = m_lastLatency;
+		m_frames[m_nextSample] = (float)frames;
+	}
+	m_nextSample = (m_nextSample + 1) % m_maxSamples;
+	m_sampleCount++;
+
+	return;
+}
+
+void LatencyTrackerClass::GetSummary(SummaryType& summary)
+{
+	std::vector<float> latencies, frames;
+	float total;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		latencies = m_latencies;
+		frames = m_frames;
+		summary.samples = m_sampleCount;
+	}
+
+	total = 0.0f;
+	for (auto latency : latencies)
+	{
+		total += latency;
+	}
+
+	summary.averageMs = latencies.empty() ? 0.0f : total / (float)latencies.size();
+	summary.medianMs = GetPercentile(latencies, 0.5f);
+	summary.p90Ms = GetPercentile(latencies, 0.9f);
+	summary.p95Ms = GetPercentile(latencies, 0.95f);
+	summary.p99Ms = GetPercentile(latencies, 0.99f);
+	summary.maxMs = GetPercentile(latencies, 1.0f);
+	summary.medianFrames = GetPercentile(frames, 0.5f);
+	summary.maxFrames = GetPercentile(frames, 1.0f);
+
+	return;
+}
+
+float LatencyTrackerClass::GetLastLatency()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_lastLatency;
+}
+
+void LatencyTrackerClass::Reset()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_latencies.clear();
+	m_frames.clear();
+	m_nextSample = 0;
+	m_sampleCount = 0;
+	m_lastLatency = 0.0f;
+
+	// The stamps already presented stay presented, so a reset does not count them again.
+	for (auto i = 0; i < PRESENT_HISTORY; i++)
+	{
+		m_presentTimes[i] = 0;
+	}
+	m_nextPresent = 0;
+
+	return;
+}
+
+void LatencyTrackerClass::WriteCSV(std::ostream& out)
+{
+	const char* NAMES[] = { "50", "90", "95", "99", "100" };
+	const float FRACTIONS[] = { 0.5f, 0.9f, 0.95f, 0.99f, 1.0f };
+	std::vector<float> latencies, frames;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		latencies = m_latencies;
+		frames = m_frames;
+	}
+
+	out << "percentile,latency ms,frames" << std::endl;
+	out << std::fixed << std::setprecision(3);
+	for (auto i = 0; i < 5; i++)
+	{
+		out << NAMES[i] << "," << GetPercentile(latencies, FRACTIONS[i]) << "," << GetPercentile(frames, FRACTIONS[i]) << std::endl;
+	}
+
+	return;
+}
+
+//GetPercentile sorts the values and returns the one the given fraction of them is at or below, like the frame driver's.
+
+float LatencyTrackerClass::GetPercentile(std::vector<float>& values, float fraction)
+{
+	size_t index;
+
+	if (values.empty())
+	{
+		return 0.0f;
+	}
+
+	std::sort(values.begin(), values.end());
+	index = (size_t)std::ceil(fraction * (float)values.size());
+
+	return values[std::max(index, (size_t)1) - 1];
+}
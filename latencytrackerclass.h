@@ -0,0 +1,100 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: latencytrackerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _LATENCYTRACKERCLASS_H_
+#define _LATENCYTRACKERCLASS_H_
+
+/*
+The LatencyTrackerClass measures input to photon latency: the time from an input event reaching the message handler to the present of
+the first frame that was simulated after it. The input is stamped with GetTime where it comes in, the simulation carries the newest
+stamp it has seen into the frame's snapshot, and whoever presents the frame calls Present with the snapshot's stamp right after
+EndScene. A stamp newer than the last one presented is a sample, an older or equal one was already counted, so a snapshot the renderer
+skipped does not lose its input as long as a later frame carries the same stamp.
+
+Every sample has the latency in milliseconds and in frames, the number of presents from the input up to and including the one showing
+it, counted from the last PRESENT_HISTORY presents. The last maxSamples samples are kept, GetSummary and WriteCSV give their
+percentiles so the effect of the pipeline depth, the frame rate limit and vsync can be compared between runs. The presented time is
+when EndScene returns, which with vsync on includes the wait for the flip but not the display's own scan out.
+
+Present and the getters take a lock, they can be called from any thread.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <ostream>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: LatencyTrackerClass
+////////////////////////////////////////////////////////////////////////////////
+class LatencyTrackerClass
+{
+private:
+	static const int PRESENT_HISTORY = 16;
+
+public:
+	//the percentiles of the samples kept, in milliseconds and frames
+	struct SummaryType
+	{
+		unsigned long long samples;
+		float averageMs;
+		float medianMs;
+		float p90Ms;
+		float p95Ms;
+		float p99Ms;
+		float maxMs;
+		float medianFrames;
+		float maxFrames;
+	};
+
+public:
+	LatencyTrackerClass();
+	LatencyTrackerClass(const LatencyTrackerClass&);
+	~LatencyTrackerClass();
+
+	//how many of the last samples the percentiles are taken over
+	bool Initialize(int);
+	void Shutdown();
+
+	//the clock input events are stamped with, in nanoseconds, 0 is never a time
+	static unsigned long long GetTime()
+	{
+		return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() + 1;
+	}
+
+	//a frame was presented that had seen input up to the given stamp, 0 when it had seen none
+	void Present(unsigned long long);
+
+	void GetSummary(SummaryType&);
+	float GetLastLatency();
+	void Reset();
+
+	//one line per percentile with the latency in milliseconds and frames
+	void WriteCSV(std::ostream&);
+
+private:
+	float GetPercentile(std::vector<float>&, float);
+
+private:
+	std::mutex m_mutex;
+
+	//the samples are a ring of the last m_maxSamples
+	std::vector<float> m_latencies;
+	std::vector<float> m_frames;
+	int m_maxSamples;
+	int m_nextSample;
+	unsigned long long m_sampleCount;
+	float m_lastLatency;
+
+	//the newest stamp presented, and the times of the last presents for counting frames
+	unsigned long long m_lastInputTime;
+	unsigned long long m_presentTimes[PRESENT_HISTORY];
+	int m_nextPresent;
+};
+
+#endif
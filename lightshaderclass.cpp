@@ -2,15 +2,33 @@
 // Filename: textureshaderclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "lightshaderclass.h"
+#include "profilerclass.h"
+#include <cstring>
+
+//the entry points InitializeShader creates from the files Initialize passes it
+static const RenderShaderDesc s_shaders[] =
+{
+	{ L"LightVS.hlsl", "LightVertexShader", false },
+	{ L"LightPS.hlsl", "LightPixelShader", true },
+	{ L"LightVS.hlsl", "ClusteredLightVertexShader", false },
+	{ L"LightPS.hlsl", "ClusteredLightPixelShader", true },
+};
 
 
 LightShaderClass::LightShaderClass()
-	: m_vertexShader(nullptr)
-	, m_pixelShader(nullptr)
-	, m_layout(nullptr)
-	, m_matrixBuffer(nullptr)
-	, m_sampleState(nullptr)
-	, m_lightBuffer(nullptr)
+	: m_device(nullptr)
+	, m_vertexShader(RENDER_NULL_HANDLE)
+	, m_pixelShader(RENDER_NULL_HANDLE)
+	, m_layout(RENDER_NULL_HANDLE)
+	, m_matrixBuffer(RENDER_NULL_HANDLE)
+	, m_sampleState(RENDER_NULL_HANDLE)
+	, m_lightBuffer(RENDER_NULL_HANDLE)
+	, m_rasterizerState(RENDER_NULL_HANDLE)
+	, m_depthStencilState(RENDER_NULL_HANDLE)
+	, m_blendState(RENDER_NULL_HANDLE)
+	, m_clusteredVertexShader(RENDER_NULL_HANDLE)
+	, m_clusteredPixelShader(RENDER_NULL_HANDLE)
+	, m_clusterBuffer(RENDER_NULL_HANDLE)
 {
 
 }
@@ -26,12 +44,12 @@ LightShaderClass::~LightShaderClass()
 
 //The Initialize function will call the initialization function for the shaders.We pass in the name of the HLSL shader files
 
-bool LightShaderClass::Initialize(ID3D11Device * device, HWND hwnd)
+bool LightShaderClass::Initialize(RenderDeviceClass* device, StateCacheClass* states)
 {
 	bool result;
 
 	//init the vertex and pixel shaders
-	result = this->InitializeShader(device, hwnd, L"LightVS.hlsl", L"LightPS.hlsl");
+	result = this->InitializeShader(device, states, L"LightVS.hlsl", L"LightPS.hlsl");
 	if (!result)
 	{
 		return false;   
@@ -39,6 +57,12 @@ bool LightShaderClass::Initialize(ID3D11Device * device, HWND hwnd)
 	return true;
 }
 
+const RenderShaderDesc* LightShaderClass::GetShaders(int& count)
+{
+	count = sizeof(s_shaders) / sizeof(s_shaders[0]);
+	return s_shaders;
+}
+
 //The Shutdown function will call the shutdown of the shader.
 
 void LightShaderClass::Shutdown()
@@ -50,337 +74,357 @@ void LightShaderClass::Shutdown()
 }
 
 /*
-The Render function now takes a new parameter called texture which is the pointer to the texture resource. 
+The Render function now takes a new parameter called texture which is the handle of the texture resource. 
 This is then sent into the SetShaderParameters function so that the texture can be set in the shader and then used for rendering.
 */
 
 //The Render function now takes in the light direction and light diffuse color as inputs. 
 //These variables are then sent into the SetShaderParameters function and finally set inside the shader itself.
 
-bool LightShaderClass::Render(ID3D11DeviceContext* deviceContext, int indexCount, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
-	XMMATRIX projectionMatrix, ID3D11ShaderResourceView* texture, XMFLOAT3 lightDirection, XMFLOAT4 diffuseColor)
+bool LightShaderClass::Render(RenderContextClass* context, int indexCount, int startIndex, int baseVertex, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
+	XMMATRIX projectionMatrix, RenderHandle texture, XMFLOAT3 lightDirection, XMFLOAT4 diffuseColor)
 {
 	bool result;
 
 
 	//set the shader params to use for rendering
-	result = SetShaderParameters(deviceContext, worldMatrix, viewMatrix, projectionMatrix, texture, lightDirection, diffuseColor);
+	result = SetShaderParameters(context, worldMatrix, viewMatrix, projectionMatrix, texture, lightDirection, diffuseColor);
 	if (!result)
 	{
 		return false;
 	}
 
 	//now render the prepared buffers with the shader
-	this->RenderShader(deviceContext, indexCount);
+	this->RenderShader(context, indexCount, startIndex, baseVertex);
 
 	return true;
 
 }
 
-//One of the most important functions > InitializeShader(). Loads the shader files and makes it useable to DirectX and teh GPU. 
+/*
+RenderClustered sets the same matrices, texture and directional light as Render, then the cluster constants and the three light buffers
+from the ClusteredLightingClass (Upload has to have been called on it this frame) and draws with the clustered shader pair.
+*/
+
+bool LightShaderClass::RenderClustered(RenderContextClass* context, int indexCount, int startIndex, int baseVertex, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
+	XMMATRIX projectionMatrix, RenderHandle texture, XMFLOAT3 lightDirection, XMFLOAT4 diffuseColor, ClusteredLightingClass* lighting)
+{
+	bool result;
+	ClusteredLightingClass::ClusterParametersType parameters;
+	ClusterBufferType clusterData;
+
+
+	result = SetShaderParameters(context, worldMatrix, viewMatrix, projectionMatrix, texture, lightDirection, diffuseColor);
+	if (!result)
+	{
+		return false;
+	}
+
+	lighting->GetClusterParameters(parameters);
+	clusterData.clusterScale = parameters.scale;
+	memcpy(clusterData.clusterGrid, parameters.gridSize, sizeof(clusterData.clusterGrid));
+
+	result = context->UpdateBuffer(m_clusterBuffer, &clusterData, sizeof(clusterData));
+	if (!result)
+	{
+		return false;
+	}
+
+	// The cluster constants go in b1 next to the light buffer, the light buffers in t1 to t3 next to the texture.
+	context->SetPSConstantBuffer(1, m_clusterBuffer);
+	context->SetPSTexture(1, lighting->GetLightBuffer());
+	context->SetPSTexture(2, lighting->GetClusterBuffer());
+	context->SetPSTexture(3, lighting->GetIndexBuffer());
+
+	context->SetInputLayout(m_layout);
+	context->SetVertexShader(m_clusteredVertexShader);
+	context->SetPixelShader(m_clusteredPixelShader);
+	context->SetPSSampler(0, m_sampleState);
+	SetStates(context);
+
+	context->DrawIndexed(indexCount, startIndex, baseVertex);
+
+	return true;
+}
+
+//One of the most important functions > InitializeShader(). Loads the shader files and makes it useable to the render device and teh GPU. 
 //Also setup of the layout and how the vertex buffer data is going to look on the graphics pipeline in the GPU. The layout will need to match
 //the VertexType in the modelclass.h as well as the one defined in the vertex shader file.
 
-bool LightShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR* vsFilename, WCHAR* psFilename)
+bool LightShaderClass::InitializeShader(RenderDeviceClass* device, StateCacheClass* states, const wchar_t* vsFilename, const wchar_t* psFilename)
 {
-	HRESULT result;
-
-	std::shared_ptr<ID3D10Blob> errorMessage(nullptr);
-	std::shared_ptr<ID3D10Blob> vertexShaderBuffer(nullptr);
-	std::shared_ptr<ID3D10Blob> pixelShaderBuffer(nullptr);
 	//the poly layout variable now has 3 elements to accomodate a normal vector
-	D3D11_INPUT_ELEMENT_DESC polygonLayout[3];
-	UINT numElements;
-	D3D11_SAMPLER_DESC samplerDesc;
-	D3D11_BUFFER_DESC matrixBufferDesc;
+	RenderInputElementDesc polygonLayout[3];
+	unsigned int numElements;
+	RenderSamplerDesc samplerDesc;
+	RenderRasterizerDesc rasterizerDesc;
+	RenderDepthStencilDesc depthStencilDesc;
+	RenderBlendDesc blendDesc;
+	RenderBufferDesc matrixBufferDesc;
 	//adding light CBUFFER desc
-	D3D11_BUFFER_DESC lightBufferDesc;
+	RenderBufferDesc lightBufferDesc;
+	RenderBufferDesc clusterBufferDesc;
 
-	//here is where we compile the shader programs into buffers. We pass it the name of the file, the name of the shader, the shader version (5.0 in 11) and the buffer
-	//to compile the shader into. If it fails, we'll get an error in the error message string. 
+	PROFILE_SCOPE("LightShaderClass::InitializeShader");
 
-	//COMPILE THE VERTEX SHADER
-	result = D3DCompileFromFile(vsFilename, NULL, NULL, "LightVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, (ID3D10Blob**)&vertexShaderBuffer, (ID3D10Blob**)&errorMessage);
+	m_device = device;
 
-	if (FAILED(result))
-	{
-		// If the shader failed to compile it should have written something to the error message.
-		if (errorMessage)
-		{
-			OutputShaderErrorMessage(errorMessage.get(), hwnd, vsFilename);
-		}
-		// If there was nothing in the error message then it simply could not find the shader file itself.
-		else
-		{
-			MessageBox(hwnd, vsFilename, L"Missing Shader File", MB_OK);
-		}
+	//here is where we compile the shader programs. We pass the device the name of the file and the name of the shader, it compiles
+	//them for whatever the device runs on. If it fails the device reports the compile errors and we get a null handle back.
 
+	//COMPILE THE VERTEX SHADER
+	m_vertexShader = device->CreateVertexShader(vsFilename, "LightVertexShader");
+	if (m_vertexShader == RENDER_NULL_HANDLE)
+	{
 		return false;
 	}
 
 	//COMPILE THE PIXEL SHADER
-	result = D3DCompileFromFile(psFilename, NULL, NULL, "LightPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, (ID3D10Blob**)&pixelShaderBuffer, (ID3D10Blob**)&errorMessage);
-
-	if (FAILED(result))
+	m_pixelShader = device->CreatePixelShader(psFilename, "LightPixelShader");
+	if (m_pixelShader == RENDER_NULL_HANDLE)
 	{
-		// If the shader failed to compile it should have written something to the error message.
-		if (errorMessage)
-		{
-			OutputShaderErrorMessage(errorMessage.get(), hwnd, psFilename);
-		}
-		// If there was nothing in the error message then it simply could not find the shader file itself.
-		else
-		{
-			MessageBox(hwnd, psFilename, L"Missing Shader File", MB_OK);
-		}
-
 		return false;
 	}
 
-	//Once the vertex shader and pixel shader code has successfully compiled into buffers we then use those buffers to create the shader objects themselves. 
-	//We will use these pointers to interface with the vertex and pixel shader from this point forward.
-
-	//create the vertex shader from the buffer
-  	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, (ID3D11VertexShader**)&m_vertexShader);
-	if (FAILED(result))
+	//the clustered lighting pair lives in the same files, its vertex shader takes the same input so it can share the layout
+	m_clusteredVertexShader = device->CreateVertexShader(vsFilename, "ClusteredLightVertexShader");
+	if (m_clusteredVertexShader == RENDER_NULL_HANDLE)
 	{
 		return false;
 	}
 
-	// Create the pixel shader from the buffer.
-	result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, (ID3D11PixelShader**)&m_pixelShader);
-	if (FAILED(result))
+	m_clusteredPixelShader = device->CreatePixelShader(psFilename, "ClusteredLightPixelShader");
+	if (m_clusteredPixelShader == RENDER_NULL_HANDLE)
 	{
 		return false;
 	}
 
 	/*
 	The input layout has changed as we now have a texture element instead of color. The first position element stays unchanged but the SemanticName and Format of the second element have been changed 
-	to TEXCOORD and DXGI_FORMAT_R32G32_FLOAT. These two changes will now align this layout with our new VertexType in both the ModelClass definition and the typedefs in the shader files.
+	to TEXCOORD and RENDER_FORMAT_R32G32_FLOAT. These two changes will now align this layout with our new VertexType in both the ModelClass definition and the typedefs in the shader files.
 	*/
 
 	//Create vertex input layout desctiption. Needs to match the VertexType struct in the model class and the HLSL
-	polygonLayout[0].SemanticName = "POSITION";
-	polygonLayout[0].SemanticIndex = 0;
-	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	polygonLayout[0].InputSlot = 0;
-	polygonLayout[0].AlignedByteOffset = 0;
-	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[0].InstanceDataStepRate = 0;
-
-	polygonLayout[1].SemanticName = "TEXCOORD";
-	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32_FLOAT;
-	polygonLayout[1].InputSlot = 0;
-	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[1].InstanceDataStepRate = 0;
+	polygonLayout[0].semanticName = "POSITION";
+	polygonLayout[0].semanticIndex = 0;
+	polygonLayout[0].format = RENDER_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[0].inputSlot = 0;
+	polygonLayout[0].alignedByteOffset = 0;
+
+	polygonLayout[1].semanticName = "TEXCOORD";
+	polygonLayout[1].semanticIndex = 0;
+	polygonLayout[1].format = RENDER_FORMAT_R32G32_FLOAT;
+	polygonLayout[1].inputSlot = 0;
+	polygonLayout[1].alignedByteOffset = RENDER_APPEND_ALIGNED_ELEMENT;
 
 	//add the description for normal to the layout (NORMAL)
-	polygonLayout[2].SemanticName = "NORMAL";
-	polygonLayout[2].SemanticIndex = 0;
-	polygonLayout[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	polygonLayout[2].InputSlot = 0;
-	polygonLayout[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-	polygonLayout[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[2].InstanceDataStepRate = 0;
+	polygonLayout[2].semanticName = "NORMAL";
+	polygonLayout[2].semanticIndex = 0;
+	polygonLayout[2].format = RENDER_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[2].inputSlot = 0;
+	polygonLayout[2].alignedByteOffset = RENDER_APPEND_ALIGNED_ELEMENT;
 
 
-	//Once the layout description has been setup we can get the size of it and then create the input layout using the D3D device.
-	//Also release the vertex and pixel shader buffers since they are no longer needed once the layout has been created.
+	//Once the layout description has been setup we can get the size of it and then create the input layout using the render device.
+	//The layout is checked against the vertex shader's inputs so we pass the vertex shader along with it.
 
 	numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
 
-	//create the vertex input layout
-	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), (ID3D11InputLayout**)&m_layout);
-
-	if (FAILED(result))
+	//create the vertex input layout, or get the one already made for the same elements
+	m_layout = states->GetInputLayout(polygonLayout, numElements, m_vertexShader);
+	if (m_layout == RENDER_NULL_HANDLE)
 	{
 		return false;
 	}
 
-	//release the buffers
-	vertexShaderBuffer->Release();
-	pixelShaderBuffer->Release();
-
 	//final thing to setup is the constant buffer. In the vertex shader program we only have one cbuffer, so only need to setup one here so we can interface with the shader
-	//the buffer usage needs to be set to dynamic since we'll be updating it each frame. The bind flags indicate it will be a constant buffer. The CPU access flags need to match up
-	//with the usage so it is set to D3D11_CPU_ACCESS_WRITE
+	//the buffer usage needs to be set to dynamic since we'll be updating it each frame. The bind type indicates it will be a constant buffer.
 
 	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	matrixBufferDesc.MiscFlags = 0;
-	matrixBufferDesc.StructureByteStride = 0;
-
-	//create the constant buffer pointer so we can access the vertex shader constant buffer from within this class
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, (ID3D11Buffer**)&m_matrixBuffer);
-	if (FAILED(result))
+	matrixBufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	matrixBufferDesc.byteWidth = sizeof(MatrixBufferType);
+	matrixBufferDesc.bindType = RENDER_BIND_CONSTANT_BUFFER;
+
+	//create the constant buffer so we can access the vertex shader constant buffer from within this class
+	m_matrixBuffer = device->CreateBuffer(matrixBufferDesc, nullptr);
+	if (m_matrixBuffer == RENDER_NULL_HANDLE)
 	{
 		return false;
 	}
 
 	/*
 	The sampler state description is setup here and can then be passed to the pixel shader. The most important element of texture sampler description is filter. 
-	Filter will determine which pixels are used or combined to create final look on the poly face. Here we use D3D11_FILTER_MIN_MAG_MIP_LINEAR
+	Filter will determine which pixels are used or combined to create final look on the poly face. Here we use RENDER_FILTER_MIN_MAG_MIP_LINEAR
 	which is more expensive but gives best look - uses linear interp for 
 	minification, magnification, and mip-level sampling.
 	*/
 
-	//create texture sampler state description
 	// Create a texture sampler state description.
-	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.MipLODBias = 0.0f;
-	samplerDesc.MaxAnisotropy = 1;
-	samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
-	samplerDesc.BorderColor[0] = 0;
-	samplerDesc.BorderColor[1] = 0;
-	samplerDesc.BorderColor[2] = 0;
-	samplerDesc.BorderColor[3] = 0;
-	samplerDesc.MinLOD = 0;
-	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	memset(&samplerDesc, 0, sizeof(samplerDesc));
+	samplerDesc.filter = RENDER_FILTER_MIN_MAG_MIP_LINEAR;
+	samplerDesc.addressU = RENDER_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.addressV = RENDER_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.addressW = RENDER_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.mipLODBias = 0.0f;
+	samplerDesc.maxAnisotropy = 1;
+	samplerDesc.comparisonFunc = RENDER_COMPARISON_ALWAYS;
+	samplerDesc.minLOD = 0;
+	samplerDesc.maxLOD = RENDER_FLOAT32_MAX;
 
 	// Create the texture sampler state.
-	result = device->CreateSamplerState(&samplerDesc, (ID3D11SamplerState**)&m_sampleState);
-
-	if (FAILED(result))
+	m_sampleState = states->GetSamplerState(samplerDesc);
+	if (m_sampleState == RENDER_NULL_HANDLE)
 	{
 		return false;
 	}
 
-	//setup the light constant buffer description which will handle the diffuse light color and light direction. Pay attn to the buffer size - if not multiples of 16
-	//the createbuffer function will fail. Here we pad 28 bytes with 4 = 32
+	//the pipeline states are the ones D3DClass sets up at startup: solid fill with back face culling, a less than depth test that writes
+	//depth and the stencil counting depth failures, and no blending. Setting them here keeps the shader right after anything else changed them.
+	memset(&rasterizerDesc, 0, sizeof(rasterizerDesc));
+	rasterizerDesc.fillMode = RENDER_FILL_SOLID;
+	rasterizerDesc.cullMode = RENDER_CULL_BACK;
+	rasterizerDesc.depthClipEnable = true;
 
-	// Setup the description of the light dynamic constant buffer that is in the pixel shader.
-	// Note that ByteWidth always needs to be a multiple of 16 if using D3D11_BIND_CONSTANT_BUFFER or CreateBuffer will fail.
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
-
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&lightBufferDesc, NULL, (ID3D11Buffer**)&m_lightBuffer);
-	if (FAILED(result))
+	m_rasterizerState = states->GetRasterizerState(rasterizerDesc);
+	if (m_rasterizerState == RENDER_NULL_HANDLE)
 	{
 		return false;
 	}
 
+	memset(&depthStencilDesc, 0, sizeof(depthStencilDesc));
+	depthStencilDesc.depthEnable = true;
+	depthStencilDesc.depthWriteEnable = true;
+	depthStencilDesc.depthFunc = RENDER_COMPARISON_LESS;
+	depthStencilDesc.stencilEnable = true;
+	depthStencilDesc.stencilReadMask = 0xFF;
+	depthStencilDesc.stencilWriteMask = 0xFF;
+	depthStencilDesc.frontFace.stencilFailOp = RENDER_STENCIL_OP_KEEP;
+	depthStencilDesc.frontFace.stencilDepthFailOp = RENDER_STENCIL_OP_INCR;
+	depthStencilDesc.frontFace.stencilPassOp = RENDER_STENCIL_OP_KEEP;
+	depthStencilDesc.frontFace.stencilFunc = RENDER_COMPARISON_ALWAYS;
+	depthStencilDesc.backFace.stencilFailOp = RENDER_STENCIL_OP_KEEP;
+	depthStencilDesc.backFace.stencilDepthFailOp = RENDER_STENCIL_OP_DECR;
+	depthStencilDesc.backFace.stencilPassOp = RENDER_STENCIL_OP_KEEP;
+	depthStencilDesc.backFace.stencilFunc = RENDER_COMPARISON_ALWAYS;
+
+	m_depthStencilState = states->GetDepthStencilState(depthStencilDesc);
+	if (m_depthStencilState == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
 
-	return true;
-}
-
-void LightShaderClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, HWND hwnd, WCHAR* shaderFilename)
-{
-	char* compileErrors;
-	ULONG bufferSize, i;
-	std::ofstream fout;
-
-	//get a pointer to the error message text buffer
-	compileErrors = (char*)(errorMessage->GetBufferPointer());
-
-	//get length
-	bufferSize = errorMessage->GetBufferSize();
+	memset(&blendDesc, 0, sizeof(blendDesc));
+	blendDesc.blendEnable = false;
+	blendDesc.srcBlend = RENDER_BLEND_ONE;
+	blendDesc.destBlend = RENDER_BLEND_ZERO;
+	blendDesc.blendOp = RENDER_BLEND_OP_ADD;
+	blendDesc.srcBlendAlpha = RENDER_BLEND_ONE;
+	blendDesc.destBlendAlpha = RENDER_BLEND_ZERO;
+	blendDesc.blendOpAlpha = RENDER_BLEND_OP_ADD;
+	blendDesc.writeMask = 0x0F;
+
+	m_blendState = states->GetBlendState(blendDesc);
+	if (m_blendState == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
 
-	//open a file to write the error to
-	fout.open("shader-error.txt");
+	//setup the light constant buffer description which will handle the diffuse light color and light direction. Pay attn to the buffer size - if not multiples of 16
+	//the createbuffer function will fail. Here we pad 28 bytes with 4 = 32
 
-	//write out
-	for (i = 0; i < bufferSize; i++)
+	// Setup the description of the light dynamic constant buffer that is in the pixel shader.
+	// Note that byteWidth always needs to be a multiple of 16 if using RENDER_BIND_CONSTANT_BUFFER or CreateBuffer will fail.
+	lightBufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	lightBufferDesc.byteWidth = sizeof(LightBufferType);
+	lightBufferDesc.bindType = RENDER_BIND_CONSTANT_BUFFER;
+
+	// Create the constant buffer so we can access the pixel shader constant buffer from within this class.
+	m_lightBuffer = device->CreateBuffer(lightBufferDesc, nullptr);
+	if (m_lightBuffer == RENDER_NULL_HANDLE)
 	{
-		fout << compileErrors[i];
+		return false;
 	}
 
-	fout.close();
+	// The cluster constants of the clustered pixel shader, 32 bytes.
+	clusterBufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	clusterBufferDesc.byteWidth = sizeof(ClusterBufferType);
+	clusterBufferDesc.bindType = RENDER_BIND_CONSTANT_BUFFER;
 
-	errorMessage->Release();
+	m_clusterBuffer = device->CreateBuffer(clusterBufferDesc, nullptr);
+	if (m_clusterBuffer == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
 
-	MessageBox(hwnd, L"Error compiling shader.  Check shader-error.txt for message.", shaderFilename, MB_OK);
 
-	return;
+	return true;
 }
 
 /*
-SetShaderParameters function now takes in a pointer to a texture resource and then assigns it to the shader using the new texture resource pointer. 
+SetShaderParameters function now takes in a handle to a texture resource and then assigns it to the shader. 
 Note that the texture has to be set before rendering of the buffer occurs.
 */
 
-bool LightShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
-	XMMATRIX projectionMatrix, ID3D11ShaderResourceView* texture, XMFLOAT3 lightDirection, XMFLOAT4 diffuseColor)
+bool LightShaderClass::SetShaderParameters(RenderContextClass* context, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
+	XMMATRIX projectionMatrix, RenderHandle texture, XMFLOAT3 lightDirection, XMFLOAT4 diffuseColor)
 {
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	MatrixBufferType* dataPtr;
-	LightBufferType* dataPtr2;
-	UINT bufferNumber;
+	bool result;
+	MatrixBufferType matrixData;
+	LightBufferType lightData;
+	unsigned int bufferNumber;
+
+	PROFILE_SCOPE("LightShaderClass::SetShaderParameters");
 
 	//Make sure to transpose matrices before sending them into the shader, this is a requirement for DirectX 11.
 	worldMatrix = XMMatrixTranspose(worldMatrix);
 	viewMatrix = XMMatrixTranspose(viewMatrix);
 	projectionMatrix = XMMatrixTranspose(projectionMatrix);
 
-	//Lock the m_matrixBuffer, set the new matrices inside it, and then unlock it.
+	//Fill in the new matrices and replace the contents of m_matrixBuffer with them.
 
-	result = deviceContext->Map(m_matrixBuffer.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
+	//copy the matrices into the constant buffer
+	matrixData.world = worldMatrix;
+	matrixData.view = viewMatrix;
+	matrixData.projection = projectionMatrix;
+
+	result = context->UpdateBuffer(m_matrixBuffer, &matrixData, sizeof(matrixData));
+	if (!result)
 	{
 		return false;
 	}
 
-	//get a pointer to the data in the constant buffer
-	dataPtr = (MatrixBufferType*)mappedResource.pData;
-
-	//copy the matrices into the constant buffer
-	dataPtr->world = worldMatrix;
-	dataPtr->view = viewMatrix;
-	dataPtr->projection = projectionMatrix;
-
-	//unlock the cbuffer
-	deviceContext->Unmap(m_matrixBuffer.get(), 0);
-
 	//now set the updated matrix in the HLSL vertex shader
 
 	//set the postion of the constant buffer in the shader
 	bufferNumber = 0;
 
 	//finally set the cbuffer in the vertex shader with updated values
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, (ID3D11Buffer**)&m_matrixBuffer);
+	context->SetVSConstantBuffer(bufferNumber, m_matrixBuffer);
 
 	// Set shader texture resource in the pixel shader.
-	deviceContext->PSSetShaderResources(0, 1, &texture);
+	context->SetPSTexture(0, texture);
 
 	/*
-	The light constant buffer is setup the same way as the matrix constant buffer. We first lock the buffer and get a pointer to it. After that we set the diffuse color and light direction using that pointer. 
-	Once the data is set we unlock the buffer and then set it in the pixel shader. Note that we use the PSSetConstantBuffers function instead of VSSetConstantBuffers since this is a pixel shader buffer we are setting.
+	The light constant buffer is setup the same way as the matrix constant buffer. We fill in the diffuse color and light direction and replace the buffer contents with them. 
+	Once the data is set we set it in the pixel shader. Note that we use SetPSConstantBuffer instead of SetVSConstantBuffer since this is a pixel shader buffer we are setting.
 	*/
 
-	result = deviceContext->Map(m_lightBuffer.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
+	//copy the lighting variables into the cbuffer
+	lightData.diffuseColor = diffuseColor;
+	lightData.lightDirection = lightDirection;
+	lightData.padding = 0.0f;
+
+	result = context->UpdateBuffer(m_lightBuffer, &lightData, sizeof(lightData));
+	if (!result)
 	{
 		return false;
 	}
 
-	//get a pointer to data in the cbuffer
-	dataPtr2 = (LightBufferType*)mappedResource.pData;
-	//copy the lighting variables into the cbuffer
-	dataPtr2->diffuseColor = diffuseColor;
-	dataPtr2->lightDirection = lightDirection;
-	dataPtr2->padding = 0.0f;
-
-	// Unlock the constant buffer.
-	deviceContext->Unmap(m_lightBuffer.get(), 0);
-
 	// Set the position of the light constant buffer in the pixel shader.
 	bufferNumber = 0;
 
 	// Finally set the light constant buffer in the pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, (ID3D11Buffer**)&m_lightBuffer);
+	context->SetPSConstantBuffer(bufferNumber, m_lightBuffer);
 
 	return true;
 
@@ -391,71 +435,84 @@ RenderShader is the second function called in the Render function. SetShaderPara
 
 The first step in this function is to set our input layout to active in the input assembler. This lets the GPU know the format of the data in the vertex buffer. 
 The second step is to set the vertex shader and pixel shader we will be using to render this vertex buffer. 
-Once the shaders are set we render the triangle by calling the DrawIndexed DirectX 11 function using the D3D device context. Once this function is called it will render the green triangle
+Once the shaders are set we render the triangle by calling DrawIndexed on the render context. Once this function is called it will render the green triangle
 
 */
 
-void LightShaderClass::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
+void LightShaderClass::RenderShader(RenderContextClass* context, int indexCount, int startIndex, int baseVertex)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(m_layout.get());
+	context->SetInputLayout(m_layout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(m_vertexShader.get(), NULL, 0);
-	deviceContext->PSSetShader(m_pixelShader.get(), NULL, 0);
+	context->SetVertexShader(m_vertexShader);
+	context->SetPixelShader(m_pixelShader);
 
 	//The RenderShader function has been changed to include setting the sample state in the pixel shader before rendering.
-	deviceContext->PSSetSamplers(0, 1, (ID3D11SamplerState**)&m_sampleState);
+	context->SetPSSampler(0, m_sampleState);
+	SetStates(context);
 
-	//draw tri
-	deviceContext->DrawIndexed(indexCount, 0, 0);
+	//draw tri, the mesh may sit anywhere in a shared geometry pool buffer
+	context->DrawIndexed(indexCount, startIndex, baseVertex);
 
 	return;
 
 }
 
+void LightShaderClass::SetStates(RenderContextClass* context)
+{
+	context->SetRasterizerState(m_rasterizerState);
+	context->SetDepthStencilState(m_depthStencilState, 1);
+	context->SetBlendState(m_blendState);
+
+	return;
+}
+
 void LightShaderClass::ConvertMatrixType(const DirectX::XMFLOAT4X4 & inMatrix, DirectX::XMMATRIX & outMatrix)
 {
-	ZeroMemory(&outMatrix, sizeof(outMatrix));
 	outMatrix = DirectX::XMLoadFloat4x4(&inMatrix);
 
 }
 
 void LightShaderClass::ShutdownShader()
 {
-	// Release the matrix constant buffer.
-	if (m_matrixBuffer)
+	if (!m_device)
 	{
-		m_matrixBuffer->Release();
-		
+		return;
 	}
 
-	if (m_lightBuffer)
-	{
-		m_lightBuffer->Release();
-	}
+	// Release the matrix constant buffer.
+	m_device->ReleaseResource(m_matrixBuffer);
+	m_matrixBuffer = RENDER_NULL_HANDLE;
 
-	// Release the layout.
-	if (m_layout)
-	{
-		m_layout->Release();
-		
-	}
+	m_device->ReleaseResource(m_lightBuffer);
+	m_lightBuffer = RENDER_NULL_HANDLE;
+
+	m_device->ReleaseResource(m_clusterBuffer);
+	m_clusterBuffer = RENDER_NULL_HANDLE;
+
+	m_device->ReleaseResource(m_clusteredPixelShader);
+	m_clusteredPixelShader = RENDER_NULL_HANDLE;
+
+	m_device->ReleaseResource(m_clusteredVertexShader);
+	m_clusteredVertexShader = RENDER_NULL_HANDLE;
+
+	// The sampler, layout and pipeline states belong to the state cache.
+	m_sampleState = RENDER_NULL_HANDLE;
+	m_layout = RENDER_NULL_HANDLE;
+	m_rasterizerState = RENDER_NULL_HANDLE;
+	m_depthStencilState = RENDER_NULL_HANDLE;
+	m_blendState = RENDER_NULL_HANDLE;
 
 	// Release the pixel shader.
-	if (m_pixelShader)
-	{
-		m_pixelShader->Release();
-	
-	}
+	m_device->ReleaseResource(m_pixelShader);
+	m_pixelShader = RENDER_NULL_HANDLE;
 
 	// Release the vertex shader.
-	if (m_vertexShader)
-	{
-		m_vertexShader->Release();
-	}
+	m_device->ReleaseResource(m_vertexShader);
+	m_vertexShader = RENDER_NULL_HANDLE;
+
+	m_device = nullptr;
 
 	return;
 }
-
-
@@ -9,15 +9,10 @@
 // INCLUDES //
 //////////////
 
-
-
-#pragma comment(lib, "D3DCompiler.lib")
-
-#include <d3d11.h>
-#include <d3dcompiler.h>
 #include <DirectXMath.h>
-#include <fstream>
-#include <memory>
+#include "renderdeviceclass.h"
+#include "clusteredlightingclass.h"
+#include "statecacheclass.h"
 
 using namespace DirectX;
 
@@ -42,35 +37,61 @@ private:
 			
 	};
 
+	//the clustered pixel shader's second cbuffer, how to find a pixel's cluster
+	struct ClusterBufferType
+	{
+		XMFLOAT4 clusterScale;
+		unsigned int clusterGrid[4];
+	};
+
 public:
 	LightShaderClass();
 	LightShaderClass(const LightShaderClass&);
 	~LightShaderClass();
 
-	bool Initialize(ID3D11Device*, HWND);
+	//the sampler, input layout and pipeline states come from the state cache, which owns them
+	bool Initialize(RenderDeviceClass*, StateCacheClass*);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext*, int, XMMATRIX, XMMATRIX, XMMATRIX, ID3D11ShaderResourceView*, XMFLOAT3, XMFLOAT4);
+
+	//the shaders Initialize creates, so they can be compiled before the device is there
+	static const RenderShaderDesc* GetShaders(int&);
+	//index count, start index and base vertex of the mesh, then the matrices, texture and light
+	bool Render(RenderContextClass*, int, int, int, XMMATRIX, XMMATRIX, XMMATRIX, RenderHandle, XMFLOAT3, XMFLOAT4);
+
+	//same as Render plus every point and spot light ClusteredLightingClass assigned to the pixel's cluster
+	bool RenderClustered(RenderContextClass*, int, int, int, XMMATRIX, XMMATRIX, XMMATRIX, RenderHandle, XMFLOAT3, XMFLOAT4, ClusteredLightingClass*);
 
 
 private:
-	bool InitializeShader(ID3D11Device*, HWND, WCHAR*, WCHAR*);
+	bool InitializeShader(RenderDeviceClass*, StateCacheClass*, const wchar_t*, const wchar_t*);
 	void ShutdownShader();
-	void OutputShaderErrorMessage(ID3D10Blob*, HWND, WCHAR*);
 
-	bool SetShaderParameters(ID3D11DeviceContext*, XMMATRIX, XMMATRIX, XMMATRIX, ID3D11ShaderResourceView*, XMFLOAT3, XMFLOAT4);
-	void RenderShader(ID3D11DeviceContext*, int);
+	bool SetShaderParameters(RenderContextClass*, XMMATRIX, XMMATRIX, XMMATRIX, RenderHandle, XMFLOAT3, XMFLOAT4);
+	void RenderShader(RenderContextClass*, int, int, int);
+	void SetStates(RenderContextClass*);
 
 	//utils
 	void ConvertMatrixType(const DirectX::XMFLOAT4X4&, DirectX::XMMATRIX&);
 
 private:
-	std::shared_ptr<ID3D11VertexShader> m_vertexShader;
-	std::shared_ptr<ID3D11PixelShader> m_pixelShader;
-	std::shared_ptr<ID3D11InputLayout> m_layout;
-	std::shared_ptr<ID3D11Buffer> m_matrixBuffer;
-	std::shared_ptr<ID3D11SamplerState> m_sampleState;
+	RenderDeviceClass* m_device;
+	RenderHandle m_vertexShader;
+	RenderHandle m_pixelShader;
+	RenderHandle m_layout;
+	RenderHandle m_matrixBuffer;
+	RenderHandle m_sampleState;
 	//There is a new private constant buffer for the light information (color and direction). The light buffer will be used by this class to set the global light variables inside the HLSL pixel shader.
-	std::shared_ptr<ID3D11Buffer> m_lightBuffer;
+	RenderHandle m_lightBuffer;
+
+	//solid back face culled opaque geometry with the same depth stencil setup as D3DClass
+	RenderHandle m_rasterizerState;
+	RenderHandle m_depthStencilState;
+	RenderHandle m_blendState;
+
+	//the clustered lighting variant, it shares the input layout, sampler and cbuffers above
+	RenderHandle m_clusteredVertexShader;
+	RenderHandle m_clusteredPixelShader;
+	RenderHandle m_clusterBuffer;
 };
 
 #endif
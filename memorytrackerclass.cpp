@@ -0,0 +1,394 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: memorytrackerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "memorytrackerclass.h"
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+//one tracked allocation, the asset points into s_assets
+struct MemoryRecordType
+{
+	MemoryTag tag;
+	const char* asset;
+	unsigned long long bytes;
+};
+
+static std::mutex s_mutex;
+static std::unordered_map<unsigned long long, MemoryRecordType> s_records[MEMORY_POOL_COUNT];
+static MemoryTrackerClass::UsageType s_usage[MEMORY_POOL_COUNT][MEMORY_TAG_COUNT];
+static std::unordered_set<std::string> s_assets;
+
+static thread_local MemoryTag s_scopeTag = MEMORY_OTHER;
+static thread_local const char* s_scopeAsset = nullptr;
+
+MemoryTrackerClass::ScopeType::ScopeType(MemoryTag tag, const char* asset)
+	: m_previousTag(s_scopeTag)
+	, m_previousAsset(s_scopeAsset)
+{
+	s_scopeTag = tag;
+	s_scopeAsset = asset;
+}
+
+MemoryTrackerClass::ScopeType::~ScopeType()
+{
+	s_scopeTag = m_previousTag;
+	s_scopeAsset = m_previousAsset;
+}
+
+void* MemoryTrackerClass::Allocate(size_t bytes)
+{
+	void* pointer;
+
+	pointer = ::operator new(bytes, std::nothrow);
+	if (!pointer)
+	{
+		return nullptr;
+	}
+
+	Track(MEMORY_CPU, (unsigned long long)(uintptr_t)pointer, bytes);
+
+	return pointer;
+}
+
+void MemoryTrackerClass::Free(void* pointer)
+{
+	if (!pointer)
+	{
+		return;
+	}
+
+	Untrack(MEMORY_CPU, (unsigned long long)(uintptr_t)pointer);
+	::operator delete(pointer);
+
+	return;
+}
+
+/*
+Track adds an allocation to its pool under the thread's scope. The asset name is copied into a set of names once, so the records only
+hold a pointer to it and an asset loaded again and again does not add up. Going over the budget is counted when the bytes cross it.
+*/
+
+void MemoryTrackerClass::Track(MemoryPool pool, unsigned long long key, unsigned long long bytes)
+{
+	MemoryRecordType record;
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	// A key tracked twice is the same memory handed out again without being untracked, the old record goes.
+	auto existing = s_records[pool].find(key);
+	if (existing != s_records[pool].end())
+	{
+		s_usage[pool][existing->second.tag].bytes -= existing->second.bytes;
+		s_usage[pool][existing->second.tag].count--;
+		s_records[pool].erase(existing);
+	}
+
+	record.tag = s_scopeTag;
+	record.asset = s_assets.insert(s_scopeAsset ? s_scopeAsset : "").first->c_str();
+	record.bytes = bytes;
+	s_records[pool][key] = record;
+
+	UsageType& usage = s_usage[pool][record.tag];
+	if (usage.budget > 0 && usage.bytes <= usage.budget && usage.bytes + bytes > usage.budget)
+	{
+		usage.overBudget++;
+	}
+
+	usage.bytes += bytes;
+	usage.count++;
+	usage.peak = std::max(usage.peak, usage.bytes);
+
+	return;
+}
+
+void MemoryTrackerClass::Untrack(MemoryPool pool, unsigned long long key)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	auto record = s_records[pool].find(key);
+	if (record == s_records[pool].end())
+	{
+		return;
+	}
+
+	s_usage[pool][record->second.tag].bytes -= record->second.bytes;
+	s_usage[pool][record->second.tag].count--;
+	s_records[pool].erase(record);
+
+	return;
+}
+
+void MemoryTrackerClass::SetBudget(MemoryPool pool, MemoryTag tag, unsigned long long bytes)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_usage[pool][tag].budget = bytes;
+	return;
+}
+
+bool MemoryTrackerClass::LoadBudgets(const char* filename)
+{
+	std::ifstream fin;
+	std::string line, poolName, tagName;
+	double megabytes;
+	int pool, tag;
+
+	fin.open(filename);
+	if (fin.fail())
+	{
+		return false;
+	}
+
+	while (std::getline(fin, line))
+	{
+		std::istringstream in(line);
+
+		// Empty lines and # comments are skipped.
+		if (!(in >> poolName) || poolName[0] == '#')
+		{
+			continue;
+		}
+
+		in >> tagName >> megabytes;
+		if (in.fail() || megabytes < 0.0)
+		{
+			return false;
+		}
+
+		for (pool = 0; pool < MEMORY_POOL_COUNT && poolName != GetPoolName(pool); pool++)
+		{
+		}
+
+		for (tag = 0; tag < MEMORY_TAG_COUNT && tagName != GetTagName(tag); tag++)
+		{
+		}
+
+		if (pool == MEMORY_POOL_COUNT || tag == MEMORY_TAG_COUNT)
+		{
+			return false;
+		}
+
+		SetBudget((MemoryPool)pool, (MemoryTag)tag, (unsigned long long)(megabytes * 1024.0 * 1024.0));
+	}
+
+	return true;
+}
+
+void MemoryTrackerClass::GetUsage(MemoryPool pool, MemoryTag tag, UsageType& usage)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	usage = s_usage[pool][tag];
+	return;
+}
+
+unsigned long long MemoryTrackerClass::GetTotal(MemoryPool pool)
+{
+	unsigned long long bytes;
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	bytes = 0;
+	for (auto tag = 0; tag < MEMORY_TAG_COUNT; tag++)
+	{
+		bytes += s_usage[pool][tag].bytes;
+	}
+
+	return bytes;
+}
+
+/*
+WriteSnapshot writes a row per pool and tag, with * for the asset, followed by a row per asset of that tag. Only the tag rows have a
+peak and a budget. Tags and assets with nothing in use and no budget are left out, so the rows only change when the usage does, and
+allocations made outside of any asset are listed as -.
+*/
+
+void MemoryTrackerClass::WriteSnapshot(std::ostream& out)
+{
+	std::map<std::string, std::pair<unsigned long long, unsigned long long>> assets[MEMORY_TAG_COUNT];
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	out << "pool,tag,asset,count,bytes,peak,budget" << std::endl;
+
+	for (auto pool = 0; pool < MEMORY_POOL_COUNT; pool++)
+	{
+		for (auto tag = 0; tag < MEMORY_TAG_COUNT; tag++)
+		{
+			assets[tag].clear();
+		}
+
+		for (auto& record : s_records[pool])
+		{
+			auto& asset = assets[record.second.tag][record.second.asset];
+			asset.first++;
+			asset.second += record.second.bytes;
+		}
+
+		for (auto tag = 0; tag < MEMORY_TAG_COUNT; tag++)
+		{
+			const UsageType& usage = s_usage[pool][tag];
+
+			if (usage.count == 0 && usage.peak == 0 && usage.budget == 0)
+			{
+				continue;
+			}
+
+			out << GetPoolName(pool) << "," << GetTagName(tag) << ",*," << usage.count << "," << usage.bytes << "," << usage.peak << ","
+				<< usage.budget << std::endl;
+
+			for (auto& asset : assets[tag])
+			{
+				out << GetPoolName(pool) << "," << GetTagName(tag) << "," << (asset.first.empty() ? "-" : asset.first) << "," << asset.second.first << ","
+					<< asset.second.second << ",," << std::endl;
+			}
+		}
+	}
+
+	return;
+}
+
+//DiffSnapshots writes the rows whose count or bytes differ between the two snapshots, a row missing from one of them counts as zero.
+
+bool MemoryTrackerClass::DiffSnapshots(std::istream& before, std::istream& after, std::ostream& out)
+{
+	std::map<std::string, std::pair<unsigned long long, unsigned long long>> rows[2];
+	std::istream* in[2] = { &before, &after };
+	std::string line, field;
+	std::vector<std::string> fields;
+	long long change;
+
+	for (auto snapshot = 0; snapshot < 2; snapshot++)
+	{
+		if (!std::getline(*in[snapshot], line) || line.compare(0, 15, "pool,tag,asset,") != 0)
+		{
+			return false;
+		}
+
+		while (std::getline(*in[snapshot], line))
+		{
+			std::istringstream row(line);
+
+			fields.clear();
+			while (std::getline(row, field, ','))
+			{
+				fields.push_back(field);
+			}
+
+			if (fields.size() < 5)
+			{
+				continue;
+			}
+
+			rows[snapshot][fields[0] + "," + fields[1] + "," + fields[2]] = std::make_pair(std::stoull(fields[3]), std::stoull(fields[4]));
+		}
+	}
+
+	// Every row of the second snapshot, and the ones of the first that are gone from it.
+	for (auto& row : rows[0])
+	{
+		rows[1].insert(std::make_pair(row.first, std::make_pair(0ull, 0ull)));
+	}
+
+	out << "pool,tag,asset,count before,count after,bytes before,bytes after,bytes change" << std::endl;
+	for (auto& row : rows[1])
+	{
+		auto old = rows[0].find(row.first);
+		std::pair<unsigned long long, unsigned long long> was = old != rows[0].end() ? old->second : std::make_pair(0ull, 0ull);
+
+		if (was == row.second)
+		{
+			continue;
+		}
+
+		change = (long long)row.second.second - (long long)was.second;
+		out << row.first << "," << was.first << "," << row.second.first << "," << was.second << "," << row.second.second << ","
+			<< (change > 0 ? "+" : "") << change << std::endl;
+	}
+
+	return true;
+}
+
+int MemoryTrackerClass::WriteLeakReport(std::ostream& out)
+{
+	std::vector<std::pair<int, MemoryRecordType>> leaks;
+	unsigned long long bytes;
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	bytes = 0;
+	for (auto pool = 0; pool < MEMORY_POOL_COUNT; pool++)
+	{
+		for (auto& record : s_records[pool])
+		{
+			leaks.push_back(std::make_pair(pool, record.second));
+			bytes += record.second.bytes;
+		}
+	}
+
+	std::sort(leaks.begin(), leaks.end(), [](const std::pair<int, MemoryRecordType>& a, const std::pair<int, MemoryRecordType>& b)
+	{
+		if (a.first != b.first)
+		{
+			return a.first < b.first;
+		}
+		if (a.second.tag != b.second.tag)
+		{
+			return a.second.tag < b.second.tag;
+		}
+		if (strcmp(a.second.asset, b.second.asset) != 0)
+		{
+			return strcmp(a.second.asset, b.second.asset) < 0;
+		}
+		return a.second.bytes > b.second.bytes;
+	});
+
+	out << leaks.size() << " allocations still around, " << bytes << " bytes" << std::endl;
+	for (auto& leak : leaks)
+	{
+		out << GetPoolName(leak.first) << " " << GetTagName(leak.second.tag) << " " << (leak.second.asset[0] ? leak.second.asset : "-") << " "
+			<< leak.second.bytes << " bytes" << std::endl;
+	}
+
+	return (int)leaks.size();
+}
+
+int MemoryTrackerClass::WriteLeakFile(const char* filename)
+{
+	std::ostringstream report;
+	std::ofstream fout;
+	int leaks;
+
+	leaks = WriteLeakReport(report);
+	if (leaks == 0)
+	{
+		return 0;
+	}
+
+	fout.open(filename);
+	fout << report.str();
+	fout.close();
+
+	return leaks;
+}
+
+const char* MemoryTrackerClass::GetPoolName(int pool)
+{
+	static const char* names[MEMORY_POOL_COUNT] = { "cpu", "gpu" };
+
+	return pool >= 0 && pool < MEMORY_POOL_COUNT ? names[pool] : "";
+}
+
+const char* MemoryTrackerClass::GetTagName(int tag)
+{
+	static const char* names[MEMORY_TAG_COUNT] = { "model", "texture", "shader", "geometry", "renderer", "ui", "other" };
+
+	return tag >= 0 && tag < MEMORY_TAG_COUNT ? names[tag] : "";
+}
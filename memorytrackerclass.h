@@ -0,0 +1,209 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: memorytrackerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MEMORYTRACKERCLASS_H_
+#define _MEMORYTRACKERCLASS_H_
+
+/*
+The MemoryTrackerClass keeps track of what memory the engine holds and what for. Every tracked allocation belongs to a pool, CPU or
+GPU memory, a tag for the subsystem it was made for and an asset, the file or object it was made for. The tag and asset come from the
+innermost MEMORY_SCOPE(tag, asset) of the thread making the allocation, so a texture loaded while a model loads is counted as the
+texture's even though the model asked for it. Outside of any scope allocations go to MEMORY_OTHER.
+
+CPU memory is tracked by allocating it through the tracker: NewArray for arrays, TaggedAllocatorType for containers, or Allocate and
+Free. GPU memory is tracked by a GpuMemoryClass in front of the render device, which works out the size of every buffer and texture
+from its description. Other code that holds on to memory it did not get from the tracker, like the D3D11 device's shader bytecode, can
+Track and Untrack it by a key of its own.
+
+For every pool and tag the tracker keeps the bytes in use, the most there ever were and how many allocations they are, against a budget
+that LoadBudgets reads from a text file or SetBudget sets (0 is no budget). Going over a budget is counted, not refused. WriteSnapshot
+writes the usage per tag and per asset as a CSV sorted by pool, tag and asset, so the snapshots of two builds can be put side by side
+with DiffSnapshots or any diff tool. WriteLeakReport lists every allocation still around, at shutdown that is everything that leaked.
+
+The tracker is for memory that lives a while, models, textures and buffers, not for memory that comes and goes every frame: tracking an
+allocation takes a lock and a hash map insert. Everything is static, there is one tracker for the process.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <ostream>
+#include <istream>
+
+#define MEMORY_CONCAT_(a, b) a##b
+#define MEMORY_CONCAT(a, b) MEMORY_CONCAT_(a, b)
+#define MEMORY_SCOPE(tag, asset) MemoryTrackerClass::ScopeType MEMORY_CONCAT(memoryScope, __LINE__)(tag, asset)
+
+enum MemoryPool
+{
+	MEMORY_CPU,
+	MEMORY_GPU,
+	MEMORY_POOL_COUNT
+};
+
+enum MemoryTag
+{
+	MEMORY_MODEL,
+	MEMORY_TEXTURE,
+	MEMORY_SHADER,
+	MEMORY_GEOMETRY,
+	MEMORY_RENDERER,
+	MEMORY_UI,
+	MEMORY_OTHER,
+	MEMORY_TAG_COUNT
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MemoryTrackerClass
+////////////////////////////////////////////////////////////////////////////////
+class MemoryTrackerClass
+{
+public:
+	//sets the tag and asset of the thread's allocations from its construction to its destruction, use MEMORY_SCOPE instead of making one
+	class ScopeType
+	{
+	public:
+		ScopeType(MemoryTag, const char*);
+		~ScopeType();
+
+	private:
+		ScopeType(const ScopeType&);
+		ScopeType& operator=(const ScopeType&);
+
+	private:
+		MemoryTag m_previousTag;
+		const char* m_previousAsset;
+	};
+
+	//deletes what NewArray made, it has to know how many elements to destroy
+	template <typename T>
+	struct ArrayDeleterType
+	{
+		size_t count = 0;
+
+		void operator()(T* pointer) const
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				pointer[i].~T();
+			}
+			MemoryTrackerClass::Free(pointer);
+		}
+	};
+
+	template <typename T>
+	using ArrayType = std::unique_ptr<T[], ArrayDeleterType<T>>;
+
+	struct UsageType
+	{
+		unsigned long long bytes;
+		unsigned long long peak;
+		unsigned long long count;
+		unsigned long long budget;
+		unsigned long long overBudget;
+	};
+
+public:
+	//CPU memory tracked under the thread's scope, Allocate returns nullptr when there is no memory left
+	static void* Allocate(size_t);
+	static void Free(void*);
+
+	//an array of count value initialized elements, empty when there is no memory left
+	template <typename T>
+	static ArrayType<T> NewArray(size_t count)
+	{
+		ArrayDeleterType<T> deleter = { count };
+		T* pointer = (T*)Allocate(count * sizeof(T));
+
+		if (!pointer)
+		{
+			return ArrayType<T>(nullptr, deleter);
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			new (&pointer[i]) T();
+		}
+
+		return ArrayType<T>(pointer, deleter);
+	}
+
+	//memory that was allocated some other way, under the thread's scope, by a key unique within its pool
+	static void Track(MemoryPool, unsigned long long, unsigned long long);
+	static void Untrack(MemoryPool, unsigned long long);
+
+	//the budgets in bytes, LoadBudgets reads lines of pool, tag and megabytes, like "gpu texture 64", and skips # comments
+	static void SetBudget(MemoryPool, MemoryTag, unsigned long long);
+	static bool LoadBudgets(const char*);
+
+	static void GetUsage(MemoryPool, MemoryTag, UsageType&);
+	static unsigned long long GetTotal(MemoryPool);
+
+	//the usage as a CSV, and the rows that changed between two of them
+	static void WriteSnapshot(std::ostream&);
+	static bool DiffSnapshots(std::istream&, std::istream&, std::ostream&);
+
+	//lists the allocations still around and returns how many there are, the file is only written when there are any
+	static int WriteLeakReport(std::ostream&);
+	static int WriteLeakFile(const char*);
+
+	static const char* GetPoolName(int);
+	static const char* GetTagName(int);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TaggedAllocatorType
+////////////////////////////////////////////////////////////////////////////////
+
+//a standard library allocator that tracks what the container allocates under the scope it allocates in
+template <typename T>
+class TaggedAllocatorType
+{
+public:
+	typedef T value_type;
+
+	TaggedAllocatorType()
+	{
+	}
+
+	template <typename U>
+	TaggedAllocatorType(const TaggedAllocatorType<U>&)
+	{
+	}
+
+	T* allocate(size_t count)
+	{
+		T* pointer = (T*)MemoryTrackerClass::Allocate(count * sizeof(T));
+
+		if (!pointer)
+		{
+			throw std::bad_alloc();
+		}
+
+		return pointer;
+	}
+
+	void deallocate(T* pointer, size_t)
+	{
+		MemoryTrackerClass::Free(pointer);
+	}
+
+	template <typename U>
+	bool operator==(const TaggedAllocatorType<U>&) const
+	{
+		return true;
+	}
+
+	template <typename U>
+	bool operator!=(const TaggedAllocatorType<U>&) const
+	{
+		return false;
+	}
+};
+
+#endif
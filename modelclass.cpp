@@ -1,4 +1,6 @@
 #include "modelclass.h"
+#include "profilerclass.h"
+#include "hitchdetectorclass.h"
 
 template< typename T >
 struct array_deleter
@@ -10,8 +12,11 @@ struct array_deleter
 };
 
 ModelClass::ModelClass()
-	: m_vertexBuffer(nullptr)
-	, m_indexBuffer(nullptr)
+	: m_device(nullptr)
+	, m_vertexBuffer(RENDER_NULL_HANDLE)
+	, m_indexBuffer(RENDER_NULL_HANDLE)
+	, m_pool(nullptr)
+	, m_mesh(-1)
 	, m_Texture(nullptr)
 {
 
@@ -27,19 +32,103 @@ ModelClass::~ModelClass()
 }
 
 //The Initialize function will call the initialization functions for the vertex and index buffers.
-//Initialize now takes as input the file name of the texture that the model will be using as well as the device context.
+//Initialize now takes as input the file name of the texture that the model will be using as well as the render device.
 
-bool ModelClass::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, char* textureFilename, char* modelFilename)
+bool ModelClass::Initialize(RenderDeviceClass* device, const char* textureFilename, const char* modelFilename)
+{
+	return Initialize(device, nullptr, textureFilename, modelFilename);
+}
+
+bool ModelClass::Initialize(RenderDeviceClass* device, GeometryPoolClass* pool, const char* textureFilename, const char* modelFilename)
+{
+	auto result = false;
+
+	//load in the model and texture data
+	result = InitializeSoftware(textureFilename, modelFilename);
+	if (!result)
+	{
+		return false;
+	}
+
+	//init the vertex and index buffer that will hold the geo and the texture
+	return InitializeDevice(device, pool);
+}
+
+//InitializeSoftware loads the same model and texture files as Initialize but stops short of creating the vertex and index buffers
+//and the texture on the device, the SoftwareRasterizerClass reads the data straight from m_model and the texture's targa data.
+//It touches nothing but the model itself, so it can run on any thread.
+
+bool ModelClass::InitializeSoftware(const char* textureFilename, const char* modelFilename)
 {
 	auto result = false;
 
 	//load in the model data
-	result = LoadModel(modelFilename);
+	result = LoadModelData(modelFilename);
+	if (!result)
+	{
+		return false;
+	}
+
+	// Load the texture data for this model.
+	return LoadTextureData(textureFilename);
+}
+
+//LoadModelData parses the model file and LoadTextureData decodes the texture. They touch different members, so the startup runs them
+//as two tasks side by side.
+
+bool ModelClass::LoadModelData(const char* modelFilename)
+{
+	//everything the model creates is the model file's memory
+	MEMORY_SCOPE(MEMORY_MODEL, modelFilename);
+
+	m_modelFilename = modelFilename;
+
+	//load in the model data
+	return LoadModel(modelFilename);
+}
+
+bool ModelClass::LoadTextureData(const char* textureFilename)
+{
+	auto result = false;
+
+	//the texture is its own file's memory
+	MEMORY_SCOPE(MEMORY_TEXTURE, textureFilename);
+
+	// Create the texture object.
+	m_Texture.reset(new TextureClass());
+	if (!m_Texture)
+	{
+		return false;
+	}
+
+	// Load the texture data for this model.
+	result = m_Texture->InitializeSoftware(textureFilename);
 	if (!result)
 	{
 		return false;
 	}
 
+	return true;
+}
+
+//InitializeDevice creates the buffers, or adds the geometry to the pool, and the texture from what InitializeSoftware loaded.
+
+bool ModelClass::InitializeDevice(RenderDeviceClass* device, GeometryPoolClass* pool)
+{
+	auto result = false;
+
+	if (!m_Texture)
+	{
+		return false;
+	}
+
+	MEMORY_SCOPE(MEMORY_MODEL, m_modelFilename.c_str());
+
+	m_pool = pool;
+
+	//remember the device, the buffers are released through it on shutdown
+	m_device = device;
+
 	//init the vertex and index buffer that will hold the geo for the triangle
 	result = this->InitializeBuffers(device);
 	if (!result)
@@ -47,8 +136,8 @@ bool ModelClass::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceCon
 		return false;
 	}
 
-	// Load the texture for this model.
-	result = LoadTexture(device, deviceContext, textureFilename);
+	// Create the texture for this model on the device.
+	result = m_Texture->InitializeDevice(device);
 	if (!result)
 	{
 		return false;
@@ -65,15 +154,18 @@ void ModelClass::Shutdown()
 	// Release the vertex and index buffers.
 	ShutdownBuffers();
 
+	// Release the model data.
+	ReleaseModel();
+
 	return;
 }
 
 //render is called from the Graphics Class render function. This function calls RenderBuffers() to put the vertex 
 // and index buffers on the graphics pipeline so the color shader will be able to redner them
 
-void ModelClass::Render(ID3D11DeviceContext* deviceContext)
+void ModelClass::Render(RenderContextClass* context)
 {
-	this->RenderBuffers(deviceContext);
+	this->RenderBuffers(context);
 
 	return;
 }
@@ -85,22 +177,62 @@ int ModelClass::GetIndexCount()
 	return m_indexCount;
 }
 
-ID3D11ShaderResourceView* ModelClass::GetTexture()
+RenderHandle ModelClass::GetTexture()
 {
 	return m_Texture->GetTexture();
 }
+
+int ModelClass::GetStartIndex()
+{
+	GeometryPoolClass::MeshType mesh;
+
+	// The pool may have moved the mesh since the last frame, so always ask it.
+	if (!m_pool || !m_pool->GetMesh(m_mesh, mesh))
+	{
+		return 0;
+	}
+
+	return mesh.startIndex;
+}
+
+int ModelClass::GetBaseVertex()
+{
+	GeometryPoolClass::MeshType mesh;
+
+	if (!m_pool || !m_pool->GetMesh(m_mesh, mesh))
+	{
+		return 0;
+	}
+
+	return mesh.baseVertex;
+}
+
+const void* ModelClass::GetVertexData()
+{
+	return m_model.data();
+}
+
+int ModelClass::GetVertexStride()
+{
+	return sizeof(ModelType);
+}
+
+unsigned char* ModelClass::GetTextureData(int& width, int& height)
+{
+	width = m_Texture->GetWidth();
+	height = m_Texture->GetHeight();
+	return m_Texture->GetTargaData();
+}
 /*
 The InitializeBuffers function is where we handle creating the vertex and index buffers. Usually you would read in a model and create the buffers from that data file. 
 For this tutorial we will just set the points in the vertex and index buffer manually since it is only a single triangle.
 */
 
-bool ModelClass::InitializeBuffers(ID3D11Device* device)
+bool ModelClass::InitializeBuffers(RenderDeviceClass* device)
 {
-	std::unique_ptr<VertexType[]> vertices(nullptr);
-	std::unique_ptr<ULONG[]> indices(nullptr);
-	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
-	D3D11_SUBRESOURCE_DATA vertexData, indexData;
-	HRESULT result;
+	MemoryTrackerClass::ArrayType<VertexType> vertices;
+	MemoryTrackerClass::ArrayType<unsigned int> indices;
+	RenderBufferDesc vertexBufferDesc, indexBufferDesc;
 
 	/*
 	well no longer manually set the vertex and index count here - we'll read it from the file
@@ -109,14 +241,14 @@ bool ModelClass::InitializeBuffers(ID3D11Device* device)
 	*/
 
 	//create the vertex array
-	vertices.reset(new VertexType[m_vertexCount]);
+	vertices = MemoryTrackerClass::NewArray<VertexType>(m_vertexCount);
 	if (!vertices)
 	{
 		return false;
 	}
 
 	//create th indices array
-	indices.reset(new ULONG[m_indexCount]);
+	indices = MemoryTrackerClass::NewArray<unsigned int>(m_indexCount);
 	if (!indices)
 	{
 		return false;
@@ -138,47 +270,39 @@ bool ModelClass::InitializeBuffers(ID3D11Device* device)
 	
 	/*
 	With the vertex array and index array filled out we can now use those to create the vertex buffer and index buffer.
-	Creating both buffers is done in the same fashion.First fill out a description of the buffer.In the description the ByteWidth(size of the buffer) and the BindFlags(type of buffer) 
-	are what you need to ensure are filled out correctly.After the description is filled out you need to also fill out a subresource pointer which will point to either your 
-	vertex or index array you previously created.With the description and subresource pointer you can call CreateBuffer using the D3D device and it will return a pointer to your new buffer.
+	Creating both buffers is done in the same fashion. First fill out a description of the buffer. In the description the byteWidth (size of the buffer) and the bindType 
+	(type of buffer) are what you need to ensure are filled out correctly. With the description and a pointer to your vertex or index array you can call CreateBuffer
+	on the render device and it will return a handle to your new buffer. The device copies the data so the arrays are freed when we return,
+	they are tracked so the leak report at shutdown would show them if they were not.
 	*/
 
+	//a pooled model copies its geometry into the pool's shared buffers, Upload on the pool sends it to the device
+	if (m_pool)
+	{
+		m_mesh = m_pool->AddMesh(vertices.get(), m_vertexCount, indices.get(), m_indexCount);
+		return m_mesh >= 0;
+	}
+
 	//setup the description of the static vertex buffer
-	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	vertexBufferDesc.ByteWidth = sizeof(VertexType)* m_vertexCount;
-	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vertexBufferDesc.CPUAccessFlags = 0;
-	vertexBufferDesc.MiscFlags = 0;
-	vertexBufferDesc.StructureByteStride = 0;
-
-	//give the subresource structure a pointer to the vertex data (transfer ownership)
-	vertexData.pSysMem = vertices.release();
-	vertexData.SysMemPitch = 0;
-	vertexData.SysMemSlicePitch = 0;
+	vertexBufferDesc.usage = RENDER_USAGE_DEFAULT;
+	vertexBufferDesc.byteWidth = sizeof(VertexType)* m_vertexCount;
+	vertexBufferDesc.bindType = RENDER_BIND_VERTEX_BUFFER;
 
 	//now create the vertex buffer
-	result = device->CreateBuffer(&vertexBufferDesc, &vertexData, (ID3D11Buffer**)&m_vertexBuffer);
-	if (FAILED(result))
+	m_vertexBuffer = device->CreateBuffer(vertexBufferDesc, vertices.get());
+	if (m_vertexBuffer == RENDER_NULL_HANDLE)
 	{
 		return false;
 	}
 
 	// Set up the description of the static index buffer.
-	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	indexBufferDesc.ByteWidth = sizeof(ULONG) * m_indexCount;
-	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	indexBufferDesc.CPUAccessFlags = 0;
-	indexBufferDesc.MiscFlags = 0;
-	indexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the index data.
-	indexData.pSysMem = indices.release();
-	indexData.SysMemPitch = 0;
-	indexData.SysMemSlicePitch = 0;
+	indexBufferDesc.usage = RENDER_USAGE_DEFAULT;
+	indexBufferDesc.byteWidth = sizeof(unsigned int) * m_indexCount;
+	indexBufferDesc.bindType = RENDER_BIND_INDEX_BUFFER;
 
 	//create the index buffer
-	result = device->CreateBuffer(&indexBufferDesc, &indexData, (ID3D11Buffer**)&m_indexBuffer);
-	if (FAILED(result))
+	m_indexBuffer = device->CreateBuffer(indexBufferDesc, indices.get());
+	if (m_indexBuffer == RENDER_NULL_HANDLE)
 	{
 		return false;
 	}
@@ -189,18 +313,27 @@ bool ModelClass::InitializeBuffers(ID3D11Device* device)
 
 void ModelClass::ShutdownBuffers()
 {
-	// Release the index buffer.
-	if (m_indexBuffer)
+	if (m_pool)
 	{
-		m_indexBuffer->Release();
+		m_pool->RemoveMesh(m_mesh);
+		m_mesh = -1;
+		m_pool = nullptr;
+		return;
 	}
 
-	// Release the vertex buffer.
-	if (m_vertexBuffer)
+	if (!m_device)
 	{
-		m_vertexBuffer->Release();
+		return;
 	}
 
+	// Release the index buffer.
+	m_device->ReleaseResource(m_indexBuffer);
+	m_indexBuffer = RENDER_NULL_HANDLE;
+
+	// Release the vertex buffer.
+	m_device->ReleaseResource(m_vertexBuffer);
+	m_vertexBuffer = RENDER_NULL_HANDLE;
+
 	return;
 }
 /*
@@ -208,52 +341,36 @@ RenderBuffers is called from the render function. This sets the vertex buffer an
 Once the GPU has an active vertex buffer it can then use the shader to render that buffer. This function also defines how those buffers should
 be drawn such as triangles, lines, fans and so forth. 
 */
-void ModelClass::RenderBuffers(ID3D11DeviceContext* deviceContext)
+void ModelClass::RenderBuffers(RenderContextClass* context)
 {
-	UINT stride;
-	UINT offset;
+	unsigned int stride;
+	unsigned int offset;
+
+	//a pooled model draws from the pool's buffers, DrawIndexed then needs GetStartIndex and GetBaseVertex
+	if (m_pool)
+	{
+		m_pool->Bind(context);
+		context->SetPrimitiveTopology(RENDER_TOPOLOGY_TRIANGLELIST);
+		return;
+	}
 
 	//set the vertex buffer stride and offset
 	stride = sizeof(VertexType);
 	offset = 0;
 
 	// Set the vertex buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetVertexBuffers(0, 1, (ID3D11Buffer**)&m_vertexBuffer, &stride, &offset);
+	context->SetVertexBuffer(0, m_vertexBuffer, stride, offset);
 
 	// Set the index buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetIndexBuffer(m_indexBuffer.get(), DXGI_FORMAT_R32_UINT, 0);
+	context->SetIndexBuffer(m_indexBuffer, RENDER_FORMAT_R32_UINT, 0);
 
 	// Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	context->SetPrimitiveTopology(RENDER_TOPOLOGY_TRIANGLELIST);
 
 	return;
 }
 
-//LoadTexture is a new private function that will create the texture object and then initialize it with the input file name provided.This function is called during initialization.
-
-bool ModelClass::LoadTexture(ID3D11Device* device, ID3D11DeviceContext* deviceContext, char* filename)
-{
-	bool result;
-
-
-	// Create the texture object.
-	m_Texture.reset(new TextureClass());
-	if (!m_Texture)
-	{
-		return false;
-	}
-
-	// Initialize the texture object.
-	result = m_Texture->Initialize(device, deviceContext, filename);
-	if (!result)
-	{
-		return false;
-	}
-
-	return true;
-}
-
-//The ReleaseTexture function will release the texture object that was created and loaded during the LoadTexture function.
+//The ReleaseTexture function will release the texture object that was created and loaded during InitializeSoftware.
 
 void ModelClass::ReleaseTexture()
 {
@@ -267,10 +384,13 @@ void ModelClass::ReleaseTexture()
 }
 
 //model loading function
-bool ModelClass::LoadModel(char* filename)
+bool ModelClass::LoadModel(const char* filename)
 {
 	std::ifstream fin;
 	char input;
+
+	PROFILE_SCOPE("ModelClass::LoadModel");
+	TRACK_ACTIVITY("loading", filename);
 	
 	//open the file
 	fin.open(filename);
@@ -326,6 +446,7 @@ bool ModelClass::LoadModel(char* filename)
 void ModelClass::ReleaseModel()
 {
 
-	m_model.clear();
+	//clear keeps the capacity, the swap gives the memory back
+	std::vector<ModelType, TaggedAllocatorType<ModelType>>().swap(m_model);
 	return;
 }
\ No newline at end of file
@@ -8,12 +8,15 @@
 
 //As stated previously the ModelClass is responsible for encapsulating the geometry for 3D models
 
-#include <d3d11.h>
 #include <DirectXMath.h>
+#include "renderdeviceclass.h"
 #include "textureclass.h"
+#include "geometrypoolclass.h"
+#include "memorytrackerclass.h"
 #include <memory>
 #include <vector>
 #include <fstream>
+#include <string>
 
 using namespace DirectX;
 
@@ -47,33 +50,53 @@ public:
 
 //The functions here handle initializing and shutdown of the model's vertex and index buffers. The Render function puts the model geometry on the video card to prepare it for drawing by the color shader.
 
-	bool Initialize(ID3D11Device*, ID3D11DeviceContext*, char*, char*); //adding filename for model to be loaded
+	bool Initialize(RenderDeviceClass*, const char*, const char*); //adding filename for model to be loaded
+	bool Initialize(RenderDeviceClass*, GeometryPoolClass*, const char*, const char*); //the geometry goes into the pool instead of buffers of its own
+	bool InitializeSoftware(const char*, const char*); //loads the model and texture data without creating any GPU resources
+	bool LoadModelData(const char*); //the model half of InitializeSoftware, can run on another thread at the same time as LoadTextureData
+	bool LoadTextureData(const char*); //the texture half of InitializeSoftware
+	bool InitializeDevice(RenderDeviceClass*, GeometryPoolClass*); //creates the GPU resources from the loaded data, the pool may be nullptr
 	void Shutdown();
-	void Render(ID3D11DeviceContext*);
+	void Render(RenderContextClass*);
 
 	int GetIndexCount();
-	ID3D11ShaderResourceView* GetTexture();
+	RenderHandle GetTexture();
+
+	//where the model sits in its geometry pool, both 0 when it has buffers of its own
+	int GetStartIndex();
+	int GetBaseVertex();
+
+	//CPU side copies of the geometry and texture for the software rasterizer. The model data has the same layout as VertexType.
+	const void* GetVertexData();
+	int GetVertexStride();
+	unsigned char* GetTextureData(int&, int&);
 
 private:
-	bool InitializeBuffers(ID3D11Device*);
+	bool InitializeBuffers(RenderDeviceClass*);
 	void ShutdownBuffers();
-	void RenderBuffers(ID3D11DeviceContext*);
+	void RenderBuffers(RenderContextClass*);
 
-	bool LoadTexture(ID3D11Device*, ID3D11DeviceContext*, char*);
 	void ReleaseTexture();
 
 	//model loading/unloading from text file
-	bool LoadModel(char*);
+	bool LoadModel(const char*);
 	void ReleaseModel();
 
 private:
-	std::shared_ptr<ID3D11Buffer> m_vertexBuffer;
-	std::shared_ptr<ID3D11Buffer> m_indexBuffer;
+	RenderDeviceClass* m_device;
+	RenderHandle m_vertexBuffer;
+	RenderHandle m_indexBuffer;
 	int m_vertexCount;
 	int m_indexCount;
 
+	//set when the model lives in a geometry pool, m_vertexBuffer and m_indexBuffer stay null then
+	GeometryPoolClass* m_pool;
+	int m_mesh;
+
 	std::shared_ptr<TextureClass> m_Texture;
-	std::vector<ModelType> m_model;
+	//the model data is tracked as the model file's CPU memory
+	std::vector<ModelType, TaggedAllocatorType<ModelType>> m_model;
+	std::string m_modelFilename;
 
 
 
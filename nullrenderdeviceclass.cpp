@@ -0,0 +1,364 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: nullrenderdeviceclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "nullrenderdeviceclass.h"
+#include <cstring>
+
+NullRenderDeviceClass::NullRenderDeviceClass()
+	: m_topology(RENDER_TOPOLOGY_TRIANGLELIST)
+	, m_frame(0)
+{
+	memset(&m_counters, 0, sizeof(m_counters));
+}
+
+NullRenderDeviceClass::NullRenderDeviceClass(const NullRenderDeviceClass& other)
+{
+}
+
+
+NullRenderDeviceClass::~NullRenderDeviceClass()
+{
+}
+
+bool NullRenderDeviceClass::Initialize()
+{
+	ResetCounters();
+	m_topology = RENDER_TOPOLOGY_TRIANGLELIST;
+	m_frame = 0;
+	m_resources.Initialize(0);
+
+	return true;
+}
+
+void NullRenderDeviceClass::Shutdown()
+{
+	m_resources.Clear([this](unsigned int&) { m_counters.resourcesDestroyed++; });
+	m_deferredContexts.clear();
+
+	return;
+}
+
+const NullRenderDeviceClass::CountersType& NullRenderDeviceClass::GetCounters()
+{
+	return m_counters;
+}
+
+void NullRenderDeviceClass::ResetCounters()
+{
+	memset(&m_counters, 0, sizeof(m_counters));
+	return;
+}
+
+//AddResource records a new resource of the given size and counts its initial data as uploaded.
+
+RenderHandle NullRenderDeviceClass::AddResource(unsigned int size, const void* initialData)
+{
+	RenderHandle handle;
+
+	if (size > 0 && initialData)
+	{
+		m_counters.bytesUploaded += size;
+	}
+
+	handle = m_resources.Add(size);
+	if (handle == RENDER_NULL_HANDLE)
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	m_counters.resourcesCreated++;
+
+	return handle;
+}
+
+RenderHandle NullRenderDeviceClass::CreateBuffer(const RenderBufferDesc& desc, const void* initialData)
+{
+	if (desc.byteWidth == 0 || (desc.bindType == RENDER_BIND_SHADER_RESOURCE && desc.structureByteStride == 0))
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	return AddResource(desc.byteWidth, initialData);
+}
+
+RenderHandle NullRenderDeviceClass::CreateTexture2D(const RenderTextureDesc& desc, const void* data, unsigned int rowPitch)
+{
+	if (desc.width == 0 || desc.height == 0)
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	return AddResource(rowPitch * desc.height, data);
+}
+
+RenderHandle NullRenderDeviceClass::CreateVertexShader(const wchar_t* filename, const char* entryPoint)
+{
+	return AddResource(0, nullptr);
+}
+
+RenderHandle NullRenderDeviceClass::CreatePixelShader(const wchar_t* filename, const char* entryPoint)
+{
+	return AddResource(0, nullptr);
+}
+
+RenderHandle NullRenderDeviceClass::CreateInputLayout(const RenderInputElementDesc* elements, unsigned int elementCount, RenderHandle vertexShader)
+{
+	return AddResource(0, nullptr);
+}
+
+RenderHandle NullRenderDeviceClass::CreateSamplerState(const RenderSamplerDesc& desc)
+{
+	return AddResource(0, nullptr);
+}
+
+RenderHandle NullRenderDeviceClass::CreateRasterizerState(const RenderRasterizerDesc& desc)
+{
+	return AddResource(0, nullptr);
+}
+
+RenderHandle NullRenderDeviceClass::CreateDepthStencilState(const RenderDepthStencilDesc& desc)
+{
+	return AddResource(0, nullptr);
+}
+
+RenderHandle NullRenderDeviceClass::CreateBlendState(const RenderBlendDesc& desc)
+{
+	return AddResource(0, nullptr);
+}
+
+void NullRenderDeviceClass::ReleaseResource(RenderHandle handle)
+{
+	if (!m_resources.Release(handle, m_frame + RENDER_RELEASE_LATENCY))
+	{
+		return;
+	}
+
+	m_counters.resourcesReleased++;
+
+	return;
+}
+
+//the null device is its own immediate context
+
+RenderContextClass* NullRenderDeviceClass::GetImmediateContext()
+{
+	return this;
+}
+
+RenderContextClass* NullRenderDeviceClass::CreateDeferredContext()
+{
+	m_deferredContexts.push_back(std::unique_ptr<CommandBufferClass>(new CommandBufferClass()));
+	return m_deferredContexts.back().get();
+}
+
+void NullRenderDeviceClass::ExecuteDeferredContext(RenderContextClass* context)
+{
+	CommandBufferClass* commandBuffer = (CommandBufferClass*)context;
+
+	commandBuffer->Execute(this);
+	commandBuffer->Reset();
+
+	return;
+}
+
+void NullRenderDeviceClass::ReleaseDeferredContext(RenderContextClass* context)
+{
+	for (size_t i = 0; i < m_deferredContexts.size(); i++)
+	{
+		if (m_deferredContexts[i].get() == context)
+		{
+			m_deferredContexts.erase(m_deferredContexts.begin() + i);
+			break;
+		}
+	}
+
+	return;
+}
+
+void NullRenderDeviceClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	return;
+}
+
+void NullRenderDeviceClass::EndScene()
+{
+	m_counters.frames++;
+	m_frame++;
+	m_resources.Retire(m_frame, [this](unsigned int&) { m_counters.resourcesDestroyed++; });
+	return;
+}
+
+bool NullRenderDeviceClass::UpdateBuffer(RenderHandle buffer, const void* data, unsigned int size)
+{
+	if (buffer == RENDER_NULL_HANDLE || !data)
+	{
+		return false;
+	}
+
+	if (!m_resources.Get(buffer))
+	{
+		m_counters.staleHandles++;
+		return false;
+	}
+
+	m_counters.bytesUploaded += size;
+
+	return true;
+}
+
+bool NullRenderDeviceClass::UpdateBufferRegion(RenderHandle buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	unsigned int* bufferSize;
+
+	if (buffer == RENDER_NULL_HANDLE || !data)
+	{
+		return false;
+	}
+
+	bufferSize = m_resources.Get(buffer);
+	if (!bufferSize)
+	{
+		m_counters.staleHandles++;
+		return false;
+	}
+
+	if (offset + size > *bufferSize)
+	{
+		return false;
+	}
+
+	m_counters.bytesUploaded += size;
+
+	return true;
+}
+
+bool NullRenderDeviceClass::WriteBuffer(RenderHandle buffer, unsigned int offset, const void* data, unsigned int size, RenderMap map)
+{
+	return UpdateBufferRegion(buffer, offset, data, size);
+}
+
+void NullRenderDeviceClass::SetInputLayout(RenderHandle layout)
+{
+	Bind(layout);
+	return;
+}
+
+void NullRenderDeviceClass::SetVertexBuffer(unsigned int slot, RenderHandle buffer, unsigned int stride, unsigned int offset)
+{
+	Bind(buffer);
+	return;
+}
+
+void NullRenderDeviceClass::SetIndexBuffer(RenderHandle buffer, RenderFormat format, unsigned int offset)
+{
+	Bind(buffer);
+	return;
+}
+
+void NullRenderDeviceClass::SetPrimitiveTopology(RenderTopology topology)
+{
+	m_topology = topology;
+	m_counters.binds++;
+	return;
+}
+
+void NullRenderDeviceClass::SetVertexShader(RenderHandle shader)
+{
+	Bind(shader);
+	return;
+}
+
+void NullRenderDeviceClass::SetVSConstantBuffer(unsigned int slot, RenderHandle buffer)
+{
+	Bind(buffer);
+	return;
+}
+
+void NullRenderDeviceClass::SetPixelShader(RenderHandle shader)
+{
+	Bind(shader);
+	return;
+}
+
+void NullRenderDeviceClass::SetPSConstantBuffer(unsigned int slot, RenderHandle buffer)
+{
+	Bind(buffer);
+	return;
+}
+
+void NullRenderDeviceClass::SetPSTexture(unsigned int slot, RenderHandle texture)
+{
+	Bind(texture);
+	return;
+}
+
+void NullRenderDeviceClass::SetPSSampler(unsigned int slot, RenderHandle sampler)
+{
+	Bind(sampler);
+	return;
+}
+
+void NullRenderDeviceClass::SetRasterizerState(RenderHandle state)
+{
+	Bind(state);
+	return;
+}
+
+void NullRenderDeviceClass::SetDepthStencilState(RenderHandle state, unsigned int stencilRef)
+{
+	Bind(state);
+	return;
+}
+
+void NullRenderDeviceClass::SetBlendState(RenderHandle state)
+{
+	Bind(state);
+	return;
+}
+
+void NullRenderDeviceClass::Draw(unsigned int vertexCount, unsigned int startVertex)
+{
+	m_counters.draws++;
+	CountPrimitives(vertexCount);
+	return;
+}
+
+void NullRenderDeviceClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	m_counters.draws++;
+	CountPrimitives(indexCount);
+	return;
+}
+
+//Bind counts a bind and looks the handle up the way a real device would, binding RENDER_NULL_HANDLE is fine and unbinds the slot.
+
+void NullRenderDeviceClass::Bind(RenderHandle handle)
+{
+	m_counters.binds++;
+
+	if (handle != RENDER_NULL_HANDLE && !m_resources.Get(handle))
+	{
+		m_counters.staleHandles++;
+	}
+
+	return;
+}
+
+//CountPrimitives turns a vertex or index count into a triangle count for the current topology.
+
+void NullRenderDeviceClass::CountPrimitives(unsigned int count)
+{
+	switch (m_topology)
+	{
+	case RENDER_TOPOLOGY_TRIANGLELIST:
+		m_counters.triangles += count / 3;
+		break;
+	case RENDER_TOPOLOGY_TRIANGLESTRIP:
+		m_counters.triangles += count > 2 ? count - 2 : 0;
+		break;
+	default:
+		break;
+	}
+
+	return;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: nullrenderdeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _NULLRENDERDEVICECLASS_H_
+#define _NULLRENDERDEVICECLASS_H_
+
+//The NullRenderDeviceClass is a render device without a GPU behind it. It hands out handles for everything that is created and accepts
+//every state change and draw, but all it does with them is count. Running the frame loop on it measures the CPU cost of the renderer
+//on its own, and the counters tell us how much work the frame would have sent to a real device.
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+#include "commandbufferclass.h"
+#include "resourcepoolclass.h"
+#include <vector>
+#include <memory>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: NullRenderDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+class NullRenderDeviceClass : public RenderDeviceClass, public RenderContextClass
+{
+public:
+	struct CountersType
+	{
+		unsigned long long frames;
+		unsigned long long draws;
+		unsigned long long triangles;
+		unsigned long long binds;
+		unsigned long long bytesUploaded;
+		unsigned long long resourcesCreated;
+		unsigned long long resourcesReleased;
+		unsigned long long resourcesDestroyed;
+		unsigned long long staleHandles;
+	};
+
+public:
+	NullRenderDeviceClass();
+	NullRenderDeviceClass(const NullRenderDeviceClass&);
+	~NullRenderDeviceClass();
+
+	bool Initialize();
+	void Shutdown();
+
+	const CountersType& GetCounters();
+	void ResetCounters();
+
+	//RenderDeviceClass
+	RenderHandle CreateBuffer(const RenderBufferDesc&, const void*);
+	RenderHandle CreateTexture2D(const RenderTextureDesc&, const void*, unsigned int);
+	RenderHandle CreateVertexShader(const wchar_t*, const char*);
+	RenderHandle CreatePixelShader(const wchar_t*, const char*);
+	RenderHandle CreateInputLayout(const RenderInputElementDesc*, unsigned int, RenderHandle);
+	RenderHandle CreateSamplerState(const RenderSamplerDesc&);
+	RenderHandle CreateRasterizerState(const RenderRasterizerDesc&);
+	RenderHandle CreateDepthStencilState(const RenderDepthStencilDesc&);
+	RenderHandle CreateBlendState(const RenderBlendDesc&);
+	void ReleaseResource(RenderHandle);
+
+	RenderContextClass* GetImmediateContext();
+	RenderContextClass* CreateDeferredContext();
+	void ExecuteDeferredContext(RenderContextClass*);
+	void ReleaseDeferredContext(RenderContextClass*);
+	void BeginScene(float, float, float, float);
+	void EndScene();
+
+	//RenderContextClass
+	bool UpdateBuffer(RenderHandle, const void*, unsigned int);
+	bool UpdateBufferRegion(RenderHandle, unsigned int, const void*, unsigned int);
+	bool WriteBuffer(RenderHandle, unsigned int, const void*, unsigned int, RenderMap);
+	void SetInputLayout(RenderHandle);
+	void SetVertexBuffer(unsigned int, RenderHandle, unsigned int, unsigned int);
+	void SetIndexBuffer(RenderHandle, RenderFormat, unsigned int);
+	void SetPrimitiveTopology(RenderTopology);
+	void SetVertexShader(RenderHandle);
+	void SetVSConstantBuffer(unsigned int, RenderHandle);
+	void SetPixelShader(RenderHandle);
+	void SetPSConstantBuffer(unsigned int, RenderHandle);
+	void SetPSTexture(unsigned int, RenderHandle);
+	void SetPSSampler(unsigned int, RenderHandle);
+	void SetRasterizerState(RenderHandle);
+	void SetDepthStencilState(RenderHandle, unsigned int);
+	void SetBlendState(RenderHandle);
+	void Draw(unsigned int, unsigned int);
+	void DrawIndexed(unsigned int, unsigned int, int);
+
+private:
+	RenderHandle AddResource(unsigned int, const void*);
+	void Bind(RenderHandle);
+	void CountPrimitives(unsigned int);
+
+private:
+	CountersType m_counters;
+	RenderTopology m_topology;
+
+	//the size of every live resource. Every bind looks its handle up so stale handles are caught here just like on a real device.
+	ResourcePoolClass<unsigned int> m_resources;
+	unsigned long long m_frame;
+
+	//deferred contexts are command buffers that are played back on the device itself, so everything is counted on the submitting thread
+	std::vector<std::unique_ptr<CommandBufferClass>> m_deferredContexts;
+};
+
+#endif
@@ -0,0 +1,483 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: offsetallocatorclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "offsetallocatorclass.h"
+#include <cstring>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+OffsetAllocatorClass::OffsetAllocatorClass()
+	: m_size(0)
+	, m_maxAllocations(0)
+	, m_freeStorage(0)
+	, m_allocationCount(0)
+	, m_freeRegionCount(0)
+	, m_usedBinsTop(0)
+{
+}
+
+OffsetAllocatorClass::OffsetAllocatorClass(const OffsetAllocatorClass& other)
+{
+}
+
+
+OffsetAllocatorClass::~OffsetAllocatorClass()
+{
+}
+
+bool OffsetAllocatorClass::Initialize(unsigned int size, unsigned int maxAllocations)
+{
+	if (size == 0 || maxAllocations < 2)
+	{
+		return false;
+	}
+
+	m_size = size;
+	m_maxAllocations = maxAllocations;
+
+	m_nodes.resize(maxAllocations);
+	m_freeNodes.resize(maxAllocations);
+
+	Reset();
+
+	return true;
+}
+
+void OffsetAllocatorClass::Shutdown()
+{
+	m_nodes.clear();
+	m_freeNodes.clear();
+	m_size = 0;
+	m_maxAllocations = 0;
+	m_freeStorage = 0;
+	m_allocationCount = 0;
+	m_freeRegionCount = 0;
+
+	return;
+}
+
+//Reset puts every node back on the free stack and the whole space into one free range.
+
+void OffsetAllocatorClass::Reset()
+{
+	m_freeStorage = 0;
+	m_allocationCount = 0;
+	m_freeRegionCount = 0;
+	m_usedBinsTop = 0;
+	memset(m_usedBins, 0, sizeof(m_usedBins));
+
+	for (auto i = 0u; i < LEAF_BIN_COUNT; i++)
+	{
+		m_binIndices[i] = UNUSED;
+	}
+
+	// The free stack is popped from the back, so node 0 comes out first.
+	m_freeNodes.resize(m_maxAllocations);
+	for (auto i = 0u; i < m_maxAllocations; i++)
+	{
+		m_freeNodes[i] = m_maxAllocations - i - 1;
+	}
+
+	if (m_size > 0)
+	{
+		InsertNodeIntoBin(m_size, 0);
+	}
+
+	return;
+}
+
+/*
+Allocate rounds the size up to a bin so that every range in that bin or any bin above it is big enough, then finds the first such bin
+that is not empty: first among the leaf bins of the same exponent, then in the lowest exponent above that has any. The first range of
+the bin gets the allocation, and whatever is left of it behind the allocation goes back in as a new free range.
+*/
+
+OffsetAllocatorClass::AllocationType OffsetAllocatorClass::Allocate(unsigned int size)
+{
+	AllocationType allocation;
+	unsigned int minBinIndex, minTopBinIndex, minLeafBinIndex, topBinIndex, leafBinIndex, binIndex, nodeIndex, nodeTotalSize, remainder;
+	unsigned int newNodeIndex;
+
+	allocation.offset = NO_SPACE;
+	allocation.metadata = UNUSED;
+
+	// Splitting off the rest of the range takes a node, so keep one in reserve.
+	if (size == 0 || m_freeNodes.size() < 1 || size > m_freeStorage)
+	{
+		return allocation;
+	}
+
+	minBinIndex = SizeToBinRoundUp(size);
+	minTopBinIndex = minBinIndex >> MANTISSA_BITS;
+	minLeafBinIndex = minBinIndex & (BINS_PER_LEAF - 1);
+
+	if (minTopBinIndex >= TOP_BIN_COUNT)
+	{
+		return allocation;
+	}
+
+	topBinIndex = minTopBinIndex;
+	leafBinIndex = NO_SPACE;
+
+	if (m_usedBinsTop & (1u << topBinIndex))
+	{
+		leafBinIndex = FindLowestSetBitAfter(m_usedBins[topBinIndex], minLeafBinIndex);
+	}
+
+	if (leafBinIndex == NO_SPACE)
+	{
+		topBinIndex = FindLowestSetBitAfter(m_usedBinsTop, minTopBinIndex + 1);
+		if (topBinIndex == NO_SPACE)
+		{
+			return allocation;
+		}
+
+		// Any leaf bin of a higher exponent is big enough.
+		leafBinIndex = FindLowestSetBit(m_usedBins[topBinIndex]);
+	}
+
+	binIndex = (topBinIndex << MANTISSA_BITS) | leafBinIndex;
+
+	// Take the first node of the bin's list.
+	nodeIndex = m_binIndices[binIndex];
+	NodeType& node = m_nodes[nodeIndex];
+	nodeTotalSize = node.dataSize;
+	node.dataSize = size;
+	node.used = true;
+	m_binIndices[binIndex] = node.binListNext;
+	if (node.binListNext != UNUSED)
+	{
+		m_nodes[node.binListNext].binListPrev = UNUSED;
+	}
+	m_freeStorage -= nodeTotalSize;
+	m_freeRegionCount--;
+
+	if (m_binIndices[binIndex] == UNUSED)
+	{
+		m_usedBins[topBinIndex] &= ~(1u << leafBinIndex);
+		if (m_usedBins[topBinIndex] == 0)
+		{
+			m_usedBinsTop &= ~(1u << topBinIndex);
+		}
+	}
+
+	remainder = nodeTotalSize - size;
+	if (remainder > 0)
+	{
+		newNodeIndex = InsertNodeIntoBin(remainder, m_nodes[nodeIndex].dataOffset + size);
+
+		// The new free range sits between the allocation and its old next neighbour.
+		if (m_nodes[nodeIndex].neighborNext != UNUSED)
+		{
+			m_nodes[m_nodes[nodeIndex].neighborNext].neighborPrev = newNodeIndex;
+		}
+		m_nodes[newNodeIndex].neighborPrev = nodeIndex;
+		m_nodes[newNodeIndex].neighborNext = m_nodes[nodeIndex].neighborNext;
+		m_nodes[nodeIndex].neighborNext = newNodeIndex;
+	}
+
+	m_allocationCount++;
+
+	allocation.offset = m_nodes[nodeIndex].dataOffset;
+	allocation.metadata = nodeIndex;
+
+	return allocation;
+}
+
+//Free merges the range with the free ranges right before and after it and puts the merged range back into its bin.
+
+void OffsetAllocatorClass::Free(AllocationType allocation)
+{
+	unsigned int nodeIndex, offset, size, neighborPrev, neighborNext, combinedNodeIndex;
+
+	nodeIndex = allocation.metadata;
+	if (allocation.offset == NO_SPACE || nodeIndex >= m_maxAllocations || !m_nodes[nodeIndex].used)
+	{
+		return;
+	}
+
+	NodeType& node = m_nodes[nodeIndex];
+	offset = node.dataOffset;
+	size = node.dataSize;
+
+	if (node.neighborPrev != UNUSED && !m_nodes[node.neighborPrev].used)
+	{
+		NodeType& prevNode = m_nodes[node.neighborPrev];
+		offset = prevNode.dataOffset;
+		size += prevNode.dataSize;
+
+		RemoveNodeFromBin(node.neighborPrev);
+		node.neighborPrev = prevNode.neighborPrev;
+	}
+
+	if (node.neighborNext != UNUSED && !m_nodes[node.neighborNext].used)
+	{
+		NodeType& nextNode = m_nodes[node.neighborNext];
+		size += nextNode.dataSize;
+
+		RemoveNodeFromBin(node.neighborNext);
+		node.neighborNext = nextNode.neighborNext;
+	}
+
+	neighborNext = node.neighborNext;
+	neighborPrev = node.neighborPrev;
+	node.used = false;
+
+	// The node goes back on the free stack and InsertNodeIntoBin takes it straight off again for the merged range.
+	m_freeNodes.push_back(nodeIndex);
+	m_allocationCount--;
+
+	combinedNodeIndex = InsertNodeIntoBin(size, offset);
+
+	if (neighborNext != UNUSED)
+	{
+		m_nodes[combinedNodeIndex].neighborNext = neighborNext;
+		m_nodes[neighborNext].neighborPrev = combinedNodeIndex;
+	}
+
+	if (neighborPrev != UNUSED)
+	{
+		m_nodes[combinedNodeIndex].neighborPrev = neighborPrev;
+		m_nodes[neighborPrev].neighborNext = combinedNodeIndex;
+	}
+
+	return;
+}
+
+unsigned int OffsetAllocatorClass::GetAllocationSize(AllocationType allocation)
+{
+	if (allocation.offset == NO_SPACE || allocation.metadata >= m_maxAllocations)
+	{
+		return 0;
+	}
+
+	return m_nodes[allocation.metadata].dataSize;
+}
+
+unsigned int OffsetAllocatorClass::GetSize()
+{
+	return m_size;
+}
+
+unsigned int OffsetAllocatorClass::GetFreeSpace()
+{
+	return m_freeStorage;
+}
+
+int OffsetAllocatorClass::GetAllocationCount()
+{
+	return m_allocationCount;
+}
+
+unsigned int OffsetAllocatorClass::GetLargestFreeRegion()
+{
+	unsigned int topBinIndex, leafBinIndex;
+
+	if (m_usedBinsTop == 0)
+	{
+		return 0;
+	}
+
+	topBinIndex = FindHighestSetBit(m_usedBinsTop);
+	leafBinIndex = FindHighestSetBit(m_usedBins[topBinIndex]);
+
+	return BinToSize((topBinIndex << MANTISSA_BITS) | leafBinIndex);
+}
+
+int OffsetAllocatorClass::GetFreeRegionCount()
+{
+	return m_freeRegionCount;
+}
+
+//InsertNodeIntoBin takes a node off the free stack for a free range and puts it at the front of the bin its size rounds down to.
+
+unsigned int OffsetAllocatorClass::InsertNodeIntoBin(unsigned int size, unsigned int dataOffset)
+{
+	unsigned int binIndex, topBinIndex, leafBinIndex, topNodeIndex, nodeIndex;
+
+	binIndex = SizeToBinRoundDown(size);
+	topBinIndex = binIndex >> MANTISSA_BITS;
+	leafBinIndex = binIndex & (BINS_PER_LEAF - 1);
+
+	if (m_binIndices[binIndex] == UNUSED)
+	{
+		m_usedBins[topBinIndex] |= 1u << leafBinIndex;
+		m_usedBinsTop |= 1u << topBinIndex;
+	}
+
+	topNodeIndex = m_binIndices[binIndex];
+	nodeIndex = m_freeNodes.back();
+	m_freeNodes.pop_back();
+
+	NodeType& node = m_nodes[nodeIndex];
+	node.dataOffset = dataOffset;
+	node.dataSize = size;
+	node.binListPrev = UNUSED;
+	node.binListNext = topNodeIndex;
+	node.neighborPrev = UNUSED;
+	node.neighborNext = UNUSED;
+	node.used = false;
+
+	if (topNodeIndex != UNUSED)
+	{
+		m_nodes[topNodeIndex].binListPrev = nodeIndex;
+	}
+	m_binIndices[binIndex] = nodeIndex;
+
+	m_freeStorage += size;
+	m_freeRegionCount++;
+
+	return nodeIndex;
+}
+
+void OffsetAllocatorClass::RemoveNodeFromBin(unsigned int nodeIndex)
+{
+	unsigned int binIndex, topBinIndex, leafBinIndex;
+	NodeType& node = m_nodes[nodeIndex];
+
+	if (node.binListPrev != UNUSED)
+	{
+		// Somewhere in the middle or at the end of the list, the bin stays non empty.
+		m_nodes[node.binListPrev].binListNext = node.binListNext;
+		if (node.binListNext != UNUSED)
+		{
+			m_nodes[node.binListNext].binListPrev = node.binListPrev;
+		}
+	}
+	else
+	{
+		// The first node of the list, the bin may become empty.
+		binIndex = SizeToBinRoundDown(node.dataSize);
+		topBinIndex = binIndex >> MANTISSA_BITS;
+		leafBinIndex = binIndex & (BINS_PER_LEAF - 1);
+
+		m_binIndices[binIndex] = node.binListNext;
+		if (node.binListNext != UNUSED)
+		{
+			m_nodes[node.binListNext].binListPrev = UNUSED;
+		}
+
+		if (m_binIndices[binIndex] == UNUSED)
+		{
+			m_usedBins[topBinIndex] &= ~(1u << leafBinIndex);
+			if (m_usedBins[topBinIndex] == 0)
+			{
+				m_usedBinsTop &= ~(1u << topBinIndex);
+			}
+		}
+	}
+
+	m_freeNodes.push_back(nodeIndex);
+	m_freeStorage -= node.dataSize;
+	m_freeRegionCount--;
+
+	return;
+}
+
+/*
+The bin of a size is the size as a float with 3 mantissa bits. Sizes below 8 are their own bin, above that the exponent is the position
+of the highest set bit and the mantissa the 3 bits below it. Rounding up bumps the mantissa when any lower bit is set, a mantissa
+overflow carries into the exponent just like it should.
+*/
+
+unsigned int OffsetAllocatorClass::SizeToBinRoundUp(unsigned int size)
+{
+	unsigned int exponent, mantissa, highestSetBit, mantissaStartBit;
+
+	if (size < BINS_PER_LEAF)
+	{
+		return size;
+	}
+
+	highestSetBit = FindHighestSetBit(size);
+	mantissaStartBit = highestSetBit - MANTISSA_BITS;
+	exponent = mantissaStartBit + 1;
+	mantissa = (size >> mantissaStartBit) & (BINS_PER_LEAF - 1);
+
+	if (size & ((1u << mantissaStartBit) - 1))
+	{
+		mantissa++;
+	}
+
+	return (exponent << MANTISSA_BITS) + mantissa;
+}
+
+unsigned int OffsetAllocatorClass::SizeToBinRoundDown(unsigned int size)
+{
+	unsigned int exponent, mantissa, highestSetBit, mantissaStartBit;
+
+	if (size < BINS_PER_LEAF)
+	{
+		return size;
+	}
+
+	highestSetBit = FindHighestSetBit(size);
+	mantissaStartBit = highestSetBit - MANTISSA_BITS;
+	exponent = mantissaStartBit + 1;
+	mantissa = (size >> mantissaStartBit) & (BINS_PER_LEAF - 1);
+
+	return (exponent << MANTISSA_BITS) | mantissa;
+}
+
+unsigned int OffsetAllocatorClass::BinToSize(unsigned int bin)
+{
+	unsigned int exponent, mantissa;
+
+	exponent = bin >> MANTISSA_BITS;
+	mantissa = bin & (BINS_PER_LEAF - 1);
+
+	if (exponent == 0)
+	{
+		return mantissa;
+	}
+
+	return (mantissa | BINS_PER_LEAF) << (exponent - 1);
+}
+
+unsigned int OffsetAllocatorClass::FindLowestSetBitAfter(unsigned int bitMask, unsigned int startBitIndex)
+{
+	unsigned int maskBeforeStartIndex, maskAfterStartIndex;
+
+	if (startBitIndex >= 32)
+	{
+		return NO_SPACE;
+	}
+
+	maskBeforeStartIndex = (1u << startBitIndex) - 1;
+	maskAfterStartIndex = ~maskBeforeStartIndex;
+
+	return FindLowestSetBit(bitMask & maskAfterStartIndex);
+}
+
+unsigned int OffsetAllocatorClass::FindLowestSetBit(unsigned int bitMask)
+{
+	if (bitMask == 0)
+	{
+		return NO_SPACE;
+	}
+
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, bitMask);
+	return index;
+#else
+	return (unsigned int)__builtin_ctz(bitMask);
+#endif
+}
+
+unsigned int OffsetAllocatorClass::FindHighestSetBit(unsigned int bitMask)
+{
+	if (bitMask == 0)
+	{
+		return NO_SPACE;
+	}
+
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse(&index, bitMask);
+	return index;
+#else
+	return 31u - (unsigned int)__builtin_clz(bitMask);
+#endif
+}
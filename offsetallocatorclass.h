@@ -0,0 +1,112 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: offsetallocatorclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _OFFSETALLOCATORCLASS_H_
+#define _OFFSETALLOCATORCLASS_H_
+
+/*
+The OffsetAllocatorClass hands out ranges of a fixed size space, [0, size), without owning any memory itself. It is used to carve up
+big GPU buffers but only ever deals in offsets and sizes, so it runs and can be tested without a device.
+
+It works the way TLSF does. Free ranges are kept in 256 bins by size, the bin number being the size as a tiny float: 5 bits of exponent
+and 3 bits of mantissa, so every bin covers sizes within 12.5% of each other. A 32 bit mask tells which of the 32 exponents have a free
+range at all and one 8 bit mask per exponent tells which of its bins do. Allocate rounds the size up to a bin and takes the first range
+of the lowest non empty bin at or above it from the masks, Free merges the range with its free neighbours and puts it back into the bin
+its size rounds down to. Both are a handful of bit scans and list updates however many ranges there are.
+
+An allocation has to be freed with the AllocationType Allocate returned, the metadata in it is the allocator's own record of the range.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: OffsetAllocatorClass
+////////////////////////////////////////////////////////////////////////////////
+class OffsetAllocatorClass
+{
+public:
+	static const unsigned int NO_SPACE = 0xffffffff;
+
+	//offset is NO_SPACE when the allocation failed
+	struct AllocationType
+	{
+		unsigned int offset;
+		unsigned int metadata;
+	};
+
+private:
+	static const unsigned int TOP_BIN_COUNT = 32;
+	static const unsigned int BINS_PER_LEAF = 8;
+	static const unsigned int LEAF_BIN_COUNT = TOP_BIN_COUNT * BINS_PER_LEAF;
+	static const unsigned int MANTISSA_BITS = 3;
+	static const unsigned int UNUSED = 0xffffffff;
+
+	//a range of the space, either allocated or free. Free ranges are linked into their bin's list, all ranges into the list of
+	//neighbours in offset order so Free can find the ranges on either side.
+	struct NodeType
+	{
+		unsigned int dataOffset;
+		unsigned int dataSize;
+		unsigned int binListPrev;
+		unsigned int binListNext;
+		unsigned int neighborPrev;
+		unsigned int neighborNext;
+		bool used;
+	};
+
+public:
+	OffsetAllocatorClass();
+	OffsetAllocatorClass(const OffsetAllocatorClass&);
+	~OffsetAllocatorClass();
+
+	//size is the space to hand out, maxAllocations how many ranges (allocated or free) there can be at once
+	bool Initialize(unsigned int, unsigned int);
+	void Shutdown();
+
+	//frees everything at once
+	void Reset();
+
+	AllocationType Allocate(unsigned int);
+	void Free(AllocationType);
+	unsigned int GetAllocationSize(AllocationType);
+
+	unsigned int GetSize();
+	unsigned int GetFreeSpace();
+	int GetAllocationCount();
+
+	//a lower bound of the largest allocation that is sure to succeed, and the number of separate free ranges
+	unsigned int GetLargestFreeRegion();
+	int GetFreeRegionCount();
+
+private:
+	unsigned int InsertNodeIntoBin(unsigned int, unsigned int);
+	void RemoveNodeFromBin(unsigned int);
+
+	static unsigned int SizeToBinRoundUp(unsigned int);
+	static unsigned int SizeToBinRoundDown(unsigned int);
+	static unsigned int BinToSize(unsigned int);
+	static unsigned int FindLowestSetBitAfter(unsigned int, unsigned int);
+	static unsigned int FindLowestSetBit(unsigned int);
+	static unsigned int FindHighestSetBit(unsigned int);
+
+private:
+	unsigned int m_size;
+	unsigned int m_maxAllocations;
+	unsigned int m_freeStorage;
+	int m_allocationCount;
+	int m_freeRegionCount;
+
+	unsigned int m_usedBinsTop;
+	unsigned char m_usedBins[TOP_BIN_COUNT];
+	unsigned int m_binIndices[LEAF_BIN_COUNT];
+
+	std::vector<NodeType> m_nodes;
+	std::vector<unsigned int> m_freeNodes;
+};
+
+#endif
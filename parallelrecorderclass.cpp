@@ -0,0 +1,226 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: parallelrecorderclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "parallelrecorderclass.h"
+#include <chrono>
+
+ParallelRecorderClass::ParallelRecorderClass()
+	: m_device(nullptr)
+	, m_jobs(nullptr)
+	, m_minimumSliceSize(1)
+	, m_record(nullptr)
+	, m_itemCount(0)
+	, m_sliceCount(0)
+	, m_recordTime(0.0f)
+	, m_executeTime(0.0f)
+{
+}
+
+ParallelRecorderClass::ParallelRecorderClass(const ParallelRecorderClass& other)
+{
+}
+
+
+ParallelRecorderClass::~ParallelRecorderClass()
+{
+}
+
+//Initialize creates a deferred context for every thread of the job system but the caller's. minimumSliceSize is the smallest number of
+//draws that is worth handing to another thread.
+
+bool ParallelRecorderClass::Initialize(RenderDeviceClass* device, JobSystemClass* jobs, int minimumSliceSize)
+{
+	int threadCount;
+
+	if (!device)
+	{
+		return false;
+	}
+
+	m_device = device;
+	m_jobs = jobs;
+	m_minimumSliceSize = minimumSliceSize > 0 ? minimumSliceSize : 1;
+	threadCount = m_jobs ? m_jobs->GetThreadCount() : 1;
+
+	m_contexts.resize(threadCount, nullptr);
+	for (auto i = 1; i < threadCount; i++)
+	{
+		m_contexts[i] = m_device->CreateDeferredContext();
+		if (!m_contexts[i])
+		{
+			return false;
+		}
+	}
+
+	// Slice 0 records on the immediate context, the others on their deferred contexts.
+	m_filters.clear();
+	for (auto i = 0; i < threadCount; i++)
+	{
+		m_filters.push_back(std::unique_ptr<StateFilterContextClass>(new StateFilterContextClass()));
+		m_filters[i]->Initialize(i == 0 ? m_device->GetImmediateContext() : m_contexts[i]);
+	}
+
+	return true;
+}
+
+void ParallelRecorderClass::Shutdown()
+{
+	if (m_device)
+	{
+		for (auto context : m_contexts)
+		{
+			if (context)
+			{
+				m_device->ReleaseDeferredContext(context);
+			}
+		}
+	}
+	m_contexts.clear();
+	m_filters.clear();
+	m_device = nullptr;
+	m_jobs = nullptr;
+
+	return;
+}
+
+//Record records itemCount draws through the record function and has them executed on the immediate context when it returns.
+
+void ParallelRecorderClass::Record(int itemCount, const RecordFunctionType& record)
+{
+	JobSystemClass::CounterType counter;
+	int sliceCount;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Only split the list as far as every slice still gets at least m_minimumSliceSize draws.
+	sliceCount = itemCount / m_minimumSliceSize;
+	if (sliceCount > (int)m_contexts.size())
+	{
+		sliceCount = (int)m_contexts.size();
+	}
+	if (sliceCount < 1)
+	{
+		sliceCount = 1;
+	}
+
+	m_record = &record;
+	m_itemCount = itemCount;
+	m_sliceCount = sliceCount;
+
+	// The first slice goes straight onto the immediate context while jobs record the rest, the immediate context is only ever used
+	// on this thread.
+	if (sliceCount > 1)
+	{
+		m_jobs->ParallelFor(sliceCount - 1, 1, [](void* data, int begin, int end)
+		{
+			for (auto i = begin; i < end; i++)
+			{
+				((ParallelRecorderClass*)data)->RecordSlice(i + 1);
+			}
+		}, this, &counter);
+	}
+
+	RecordSlice(0);
+
+	if (sliceCount > 1)
+	{
+		m_jobs->Wait(&counter);
+	}
+
+	auto recorded = std::chrono::high_resolution_clock::now();
+
+	// Play the other slices back behind the first one, in order.
+	for (auto i = 1; i < sliceCount; i++)
+	{
+		m_device->ExecuteDeferredContext(m_contexts[i]);
+	}
+
+	// Whatever the slices bound is now on the immediate context too.
+	if (sliceCount > 1)
+	{
+		m_filters[0]->Invalidate();
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	m_recordTime = std::chrono::duration<float, std::milli>(recorded - start).count();
+	m_executeTime = std::chrono::duration<float, std::milli>(end - recorded).count();
+	m_record = nullptr;
+
+	return;
+}
+
+int ParallelRecorderClass::GetThreadCount()
+{
+	return (int)m_contexts.size();
+}
+
+//GetSliceCount returns how many threads the last Record call used.
+
+int ParallelRecorderClass::GetSliceCount()
+{
+	return m_sliceCount;
+}
+
+//GetRecordTime and GetExecuteTime return how many milliseconds the last Record call spent recording and playing back the slices.
+
+float ParallelRecorderClass::GetRecordTime()
+{
+	return m_recordTime;
+}
+
+float ParallelRecorderClass::GetExecuteTime()
+{
+	return m_executeTime;
+}
+
+RenderContextClass* ParallelRecorderClass::GetImmediateContext()
+{
+	return m_filters.empty() ? nullptr : m_filters[0].get();
+}
+
+void ParallelRecorderClass::GetFilterStats(StateFilterContextClass::StatsType& stats)
+{
+	stats.issued = 0;
+	stats.filtered = 0;
+	for (auto& filter : m_filters)
+	{
+		stats.issued += filter->GetStats().issued;
+		stats.filtered += filter->GetStats().filtered;
+	}
+
+	return;
+}
+
+void ParallelRecorderClass::ResetFilterStats()
+{
+	for (auto& filter : m_filters)
+	{
+		filter->ResetStats();
+	}
+
+	return;
+}
+
+void ParallelRecorderClass::RecordSlice(int slice)
+{
+	StateFilterContextClass* context;
+	int first, last;
+
+	if (slice >= m_sliceCount)
+	{
+		return;
+	}
+
+	first = (int)((long long)m_itemCount * slice / m_sliceCount);
+	last = (int)((long long)m_itemCount * (slice + 1) / m_sliceCount);
+
+	// A deferred context starts out from the default state and the immediate one may have been used without the filter since the last
+	// Record, so the filter cannot assume anything is still bound.
+	context = m_filters[slice].get();
+	context->Invalidate();
+
+	(*m_record)(context, first, last);
+
+	return;
+}
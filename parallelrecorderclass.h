@@ -0,0 +1,82 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: parallelrecorderclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _PARALLELRECORDERCLASS_H_
+#define _PARALLELRECORDERCLASS_H_
+
+/*
+The ParallelRecorderClass records a frame's draw list on several threads at once. The list is cut into contiguous slices, the calling
+thread records the first slice straight onto the immediate context while the others run as jobs on the JobSystemClass, each recording
+into its own deferred context. Once everyone is done the deferred contexts are executed in slice order, so the GPU sees the draws in exactly the order they
+had in the list. Lists that are too short to be worth splitting are recorded on the immediate context alone.
+
+Every slice records through a StateFilterContextClass in front of its context, so the binds that would not change anything never reach
+the context. The filters forget what they know at the start of every slice.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+#include "statefiltercontextclass.h"
+#include <functional>
+#include <memory>
+#include <vector>
+#include "jobsystemclass.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ParallelRecorderClass
+////////////////////////////////////////////////////////////////////////////////
+class ParallelRecorderClass
+{
+public:
+	//records the items [first, last) of the draw list on the given context. Called on several threads at once with disjoint ranges.
+	typedef std::function<void(RenderContextClass*, int, int)> RecordFunctionType;
+
+public:
+	ParallelRecorderClass();
+	ParallelRecorderClass(const ParallelRecorderClass&);
+	~ParallelRecorderClass();
+
+	//jobs may be nullptr to record everything on the calling thread
+	bool Initialize(RenderDeviceClass*, JobSystemClass*, int);
+	void Shutdown();
+
+	void Record(int, const RecordFunctionType&);
+
+	int GetThreadCount();
+	int GetSliceCount();
+	float GetRecordTime();
+	float GetExecuteTime();
+
+	//the immediate context behind the first slice's filter, for drawing more after Record without binding everything again
+	RenderContextClass* GetImmediateContext();
+
+	//binds passed on and dropped by all the filters since the last reset
+	void GetFilterStats(StateFilterContextClass::StatsType&);
+	void ResetFilterStats();
+
+private:
+	void RecordSlice(int);
+
+private:
+	RenderDeviceClass* m_device;
+	JobSystemClass* m_jobs;
+	int m_minimumSliceSize;
+
+	//one deferred context per job system thread, index 0 is unused since the calling thread records on the immediate context
+	std::vector<RenderContextClass*> m_contexts;
+	std::vector<std::unique_ptr<StateFilterContextClass>> m_filters;
+
+	//the job of the current Record call
+	const RecordFunctionType* m_record;
+	int m_itemCount;
+	int m_sliceCount;
+
+	float m_recordTime;
+	float m_executeTime;
+};
+
+#endif
@@ -0,0 +1,270 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: perfhudclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "perfhudclass.h"
+#include <cstdio>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#endif
+
+using namespace DirectX;
+
+//the layout of the panel in pixels, text is the font at TEXT_SCALE
+static const float TEXT_SCALE = 2.0f;
+static const float PADDING = 8.0f;
+static const float LINE_HEIGHT = 20.0f;
+static const float GRAPH_HEIGHT = 60.0f;
+static const float BAR_WIDTH = 2.0f;
+static const int LINE_CHARACTERS = 28;
+
+static const XMFLOAT4 PANEL_COLOR(0.0f, 0.0f, 0.0f, 0.6f);
+static const XMFLOAT4 GRAPH_COLOR(0.15f, 0.15f, 0.15f, 0.8f);
+static const XMFLOAT4 TARGET_COLOR(1.0f, 1.0f, 1.0f, 0.5f);
+static const XMFLOAT4 TEXT_COLOR(1.0f, 1.0f, 1.0f, 1.0f);
+static const XMFLOAT4 LABEL_COLOR(0.6f, 0.8f, 1.0f, 1.0f);
+static const XMFLOAT4 GOOD_COLOR(0.2f, 0.9f, 0.2f, 1.0f);
+static const XMFLOAT4 SLOW_COLOR(0.95f, 0.85f, 0.1f, 1.0f);
+static const XMFLOAT4 BAD_COLOR(0.95f, 0.2f, 0.2f, 1.0f);
+
+PerfHudClass::PerfHudClass()
+	: m_nextFrame(0)
+	, m_frameCount(0)
+	, m_targetMs(0.0f)
+	, m_memory(0)
+	, m_width(0.0f)
+	, m_height(0.0f)
+{
+}
+
+PerfHudClass::PerfHudClass(const PerfHudClass& other)
+{
+}
+
+
+PerfHudClass::~PerfHudClass()
+{
+}
+
+bool PerfHudClass::Initialize(int graphFrames, float targetMs)
+{
+	if (graphFrames <= 0 || targetMs <= 0.0f)
+	{
+		return false;
+	}
+
+	m_frameTimes.assign(graphFrames, 0.0f);
+	m_nextFrame = 0;
+	m_frameCount = 0;
+	m_targetMs = targetMs;
+
+	m_stages.clear();
+	m_counters.clear();
+	m_stages.reserve(MAX_LINES);
+	m_counters.reserve(MAX_LINES);
+	m_memory = 0;
+
+	return true;
+}
+
+void PerfHudClass::Shutdown()
+{
+	m_frameTimes.clear();
+	m_stages.clear();
+	m_counters.clear();
+	m_frameCount = 0;
+
+	return;
+}
+
+void PerfHudClass::AddFrameTime(float ms)
+{
+	if (m_frameTimes.empty())
+	{
+		return;
+	}
+
+	m_frameTimes[m_nextFrame] = ms;
+	m_nextFrame = (m_nextFrame + 1) % (int)m_frameTimes.size();
+	if (m_frameCount < (int)m_frameTimes.size())
+	{
+		m_frameCount++;
+	}
+
+	return;
+}
+
+bool PerfHudClass::SetStageTime(const char* name, float ms)
+{
+	return SetLine(m_stages, name, ms);
+}
+
+bool PerfHudClass::SetCounter(const char* name, double value)
+{
+	return SetLine(m_counters, name, value);
+}
+
+void PerfHudClass::SetMemory(unsigned long long bytes)
+{
+	m_memory = bytes;
+	return;
+}
+
+/*
+Build lays the panel out from the top down: the header with the average and worst frame of the graph, the graph, the stages, the
+counters and the memory. The panel's background goes first so everything else is blended over it. The lines are formatted into a
+buffer on the stack, so a frame of HUD does not allocate once the names are known.
+*/
+
+void PerfHudClass::Build(SpriteBatchClass* batch, float x, float y)
+{
+	char text[64];
+	float width, height, graphWidth, left, top, ms, sum, worst, average, barHeight;
+	int frame;
+
+	graphWidth = (float)m_frameTimes.size() * BAR_WIDTH;
+	width = (float)LINE_CHARACTERS * (float)SpriteBatchClass::GLYPH_ADVANCE * TEXT_SCALE;
+	if (graphWidth > width)
+	{
+		width = graphWidth;
+	}
+	width += 2.0f * PADDING;
+
+	height = 2.0f * PADDING + LINE_HEIGHT + GRAPH_HEIGHT + PADDING + (float)(m_stages.size() + m_counters.size() + 1) * LINE_HEIGHT;
+
+	m_width = width;
+	m_height = height;
+
+	batch->AddRect(x, y, width, height, PANEL_COLOR);
+
+	left = x + PADDING;
+	top = y + PADDING;
+
+	// The header, over the frames the graph shows.
+	sum = 0.0f;
+	worst = 0.0f;
+	for (frame = 0; frame < m_frameCount; frame++)
+	{
+		ms = m_frameTimes[frame];
+		sum += ms;
+		if (ms > worst)
+		{
+			worst = ms;
+		}
+	}
+	average = m_frameCount > 0 ? sum / (float)m_frameCount : 0.0f;
+
+	snprintf(text, sizeof(text), "%6.2f MS %4.0f FPS MAX%6.1f", average, average > 0.0f ? 1000.0f / average : 0.0f, worst);
+	batch->AddText(left, top, text, TEXT_COLOR, TEXT_SCALE);
+	top += LINE_HEIGHT;
+
+	// The graph, the target is halfway up and anything over twice the target is cut off at the top.
+	batch->AddRect(left, top, graphWidth, GRAPH_HEIGHT, GRAPH_COLOR);
+
+	for (frame = 0; frame < m_frameCount; frame++)
+	{
+		ms = m_frameTimes[(m_nextFrame - m_frameCount + frame + (int)m_frameTimes.size()) % (int)m_frameTimes.size()];
+
+		barHeight = ms / (2.0f * m_targetMs);
+		if (barHeight > 1.0f)
+		{
+			barHeight = 1.0f;
+		}
+		barHeight *= GRAPH_HEIGHT;
+
+		batch->AddRect(left + (float)frame * BAR_WIDTH, top + GRAPH_HEIGHT - barHeight, BAR_WIDTH, barHeight,
+			ms <= m_targetMs ? GOOD_COLOR : (ms <= 1.5f * m_targetMs ? SLOW_COLOR : BAD_COLOR));
+	}
+
+	batch->AddRect(left, top + 0.5f * GRAPH_HEIGHT, graphWidth, 1.0f, TARGET_COLOR);
+	top += GRAPH_HEIGHT + PADDING;
+
+	for (auto& stage : m_stages)
+	{
+		snprintf(text, sizeof(text), "%-14.14s%7.3f MS", stage.name.c_str(), stage.value);
+		batch->AddText(left, top, text, LABEL_COLOR, TEXT_SCALE);
+		top += LINE_HEIGHT;
+	}
+
+	for (auto& counter : m_counters)
+	{
+		snprintf(text, sizeof(text), "%-14.14s%10.0f", counter.name.c_str(), counter.value);
+		batch->AddText(left, top, text, TEXT_COLOR, TEXT_SCALE);
+		top += LINE_HEIGHT;
+	}
+
+	snprintf(text, sizeof(text), "%-14.14s%7.1f MB", "memory", (double)m_memory / (1024.0 * 1024.0));
+	batch->AddText(left, top, text, TEXT_COLOR, TEXT_SCALE);
+
+	return;
+}
+
+float PerfHudClass::GetWidth()
+{
+	return m_width;
+}
+
+float PerfHudClass::GetHeight()
+{
+	return m_height;
+}
+
+unsigned long long PerfHudClass::GetProcessMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0;
+	}
+
+	return (unsigned long long)counters.WorkingSetSize;
+#else
+	unsigned long long pages, resident;
+	FILE* file;
+
+	//statm is in pages, the second number is the resident set
+	file = fopen("/proc/self/statm", "r");
+	if (!file)
+	{
+		return 0;
+	}
+
+	if (fscanf(file, "%llu %llu", &pages, &resident) != 2)
+	{
+		resident = 0;
+	}
+	fclose(file);
+
+	return resident * (unsigned long long)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+bool PerfHudClass::SetLine(std::vector<LineType>& lines, const char* name, double value)
+{
+	LineType line;
+
+	for (auto& existing : lines)
+	{
+		if (existing.name == name)
+		{
+			existing.value = value;
+			return true;
+		}
+	}
+
+	if ((int)lines.size() >= MAX_LINES)
+	{
+		return false;
+	}
+
+	line.name = name;
+	line.value = value;
+	lines.push_back(line);
+
+	return true;
+}
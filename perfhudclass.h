@@ -0,0 +1,82 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: perfhudclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _PERFHUDCLASS_H_
+#define _PERFHUDCLASS_H_
+
+/*
+The PerfHudClass is the performance overlay: a panel in a corner of the screen with the frame time, a graph of the last frames, the
+time every stage took, any counters the renderer wants to show and how much memory the process uses. It only keeps the numbers, the
+caller feeds it once a frame with AddFrameTime, SetStageTime, SetCounter and SetMemory, and Build turns the lot into quads and text on
+a SpriteBatchClass. Everything goes into the batch's font atlas, so the whole panel is one draw.
+
+The graph has one bar per frame, oldest on the left, scaled so the target frame time is halfway up. Bars are green up to the target,
+yellow up to half as much again and red above that. Stage and counter lines are shown in the order they were first set, there is
+room for MAX_LINES of each. Build does not draw anything itself, so the layout can be looked at on the null device.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "spritebatchclass.h"
+#include <vector>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: PerfHudClass
+////////////////////////////////////////////////////////////////////////////////
+class PerfHudClass
+{
+private:
+	static const int MAX_LINES = 16;
+
+	struct LineType
+	{
+		std::string name;
+		double value;
+	};
+
+public:
+	PerfHudClass();
+	PerfHudClass(const PerfHudClass&);
+	~PerfHudClass();
+
+	//how many frames the graph shows and the frame time the graph is scaled to, in milliseconds
+	bool Initialize(int, float);
+	void Shutdown();
+
+	void AddFrameTime(float);
+	bool SetStageTime(const char*, float);
+	bool SetCounter(const char*, double);
+	void SetMemory(unsigned long long);
+
+	//adds the panel with its top left corner at x, y to the batch
+	void Build(SpriteBatchClass*, float, float);
+
+	//the size of the panel the last Build added
+	float GetWidth();
+	float GetHeight();
+
+	//the memory the process uses right now, in bytes: the working set on Windows, the resident set elsewhere
+	static unsigned long long GetProcessMemory();
+
+private:
+	bool SetLine(std::vector<LineType>&, const char*, double);
+
+private:
+	std::vector<float> m_frameTimes;
+	int m_nextFrame;
+	int m_frameCount;
+	float m_targetMs;
+
+	std::vector<LineType> m_stages;
+	std::vector<LineType> m_counters;
+	unsigned long long m_memory;
+
+	float m_width;
+	float m_height;
+};
+
+#endif
@@ -0,0 +1,235 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: profilerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "profilerclass.h"
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+static const unsigned long long RING_EVENTS = 65536;
+
+//the fields are only ever written by the ring's own thread, they are atomics so WriteTrace may read them at the same time
+struct ProfilerEventType
+{
+	std::atomic<const char*> name;
+	std::atomic<unsigned long long> start;
+	std::atomic<unsigned long long> end;
+};
+
+struct ProfilerRingType
+{
+	std::unique_ptr<ProfilerEventType[]> events;
+	std::atomic<unsigned long long> head;
+	int thread;
+	std::string name;
+};
+
+static std::mutex s_mutex;
+static std::vector<std::unique_ptr<ProfilerRingType>> s_rings;
+static std::atomic<unsigned long long> s_startTicks(ProfilerClass::GetTicks());
+static std::chrono::steady_clock::time_point s_startTime(std::chrono::steady_clock::now());
+static thread_local ProfilerRingType* t_ring = nullptr;
+
+//GetRing returns the calling thread's ring, the first call on a thread makes it
+
+static ProfilerRingType* GetRing()
+{
+	ProfilerRingType* ring;
+
+	if (t_ring)
+	{
+		return t_ring;
+	}
+
+	ring = new ProfilerRingType();
+	// Zeroing the ring touches all of its pages now instead of on the first pass through it.
+	ring->events.reset(new ProfilerEventType[RING_EVENTS]());
+	ring->head = 0;
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	ring->thread = (int)s_rings.size();
+	ring->name = "thread " + std::to_string(ring->thread);
+	s_rings.push_back(std::unique_ptr<ProfilerRingType>(ring));
+
+	t_ring = ring;
+
+	return ring;
+}
+
+void ProfilerClass::Initialize()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	s_startTicks = GetTicks();
+	s_startTime = std::chrono::steady_clock::now();
+
+	return;
+}
+
+void ProfilerClass::SetThreadName(const char* name)
+{
+	ProfilerRingType* ring = GetRing();
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	ring->name = name;
+
+	return;
+}
+
+void ProfilerClass::Record(const char* name, unsigned long long start, unsigned long long end)
+{
+	ProfilerRingType* ring;
+	unsigned long long head;
+
+	ring = t_ring ? t_ring : GetRing();
+	head = ring->head.load(std::memory_order_relaxed);
+
+	// Whoever sees any of the event's fields also sees the head from before it, see WriteTrace.
+	std::atomic_thread_fence(std::memory_order_release);
+
+	ProfilerEventType& event = ring->events[head & (RING_EVENTS - 1)];
+	event.name.store(name, std::memory_order_relaxed);
+	event.start.store(start, std::memory_order_relaxed);
+	event.end.store(end, std::memory_order_relaxed);
+
+	ring->head.store(head + 1, std::memory_order_release);
+
+	return;
+}
+
+void ProfilerClass::WriteTrace(std::ostream& out)
+{
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+	out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"DXEngine\"}}";
+	WriteEvents(out, 0);
+	out << std::endl << "]}" << std::endl;
+
+	return;
+}
+
+/*
+WriteEvents writes a metadata event naming each thread and one complete event per scope. The events of a ring are copied from its
+oldest to its newest, then the write position is read again: the writer may have overwritten the oldest ones in the meantime, and may
+be halfway through the one after the new position, so only the events newer than that are kept.
+*/
+
+void ProfilerClass::WriteEvents(std::ostream& out, unsigned long long sinceTicks)
+{
+	struct CopyType
+	{
+		const char* name;
+		unsigned long long start;
+		unsigned long long end;
+	};
+
+	std::vector<CopyType> copies;
+	unsigned long long head, oldest, first, last, startTicks;
+	double ticksPerMicrosecond;
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	ticksPerMicrosecond = GetTicksPerMicrosecond();
+	startTicks = s_startTicks;
+	sinceTicks = std::max(sinceTicks, startTicks);
+
+	for (auto& ring : s_rings)
+	{
+		out << "," << std::endl << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->thread
+			<< ",\"args\":{\"name\":\"" << ring->name << "\"}}";
+
+		head = ring->head.load(std::memory_order_acquire);
+		oldest = head > RING_EVENTS ? head - RING_EVENTS : 0;
+
+		copies.resize((size_t)(head - oldest));
+		for (auto i = oldest; i < head; i++)
+		{
+			ProfilerEventType& event = ring->events[i & (RING_EVENTS - 1)];
+			copies[(size_t)(i - oldest)].name = event.name.load(std::memory_order_relaxed);
+			copies[(size_t)(i - oldest)].start = event.start.load(std::memory_order_relaxed);
+			copies[(size_t)(i - oldest)].end = event.end.load(std::memory_order_relaxed);
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		last = ring->head.load(std::memory_order_relaxed);
+		first = last + 1 > oldest + RING_EVENTS ? std::min(last + 1 - RING_EVENTS, head) : oldest;
+
+		for (auto i = first; i < head; i++)
+		{
+			CopyType& copy = copies[(size_t)(i - oldest)];
+
+			// Scopes that ended before the trace started are left out.
+			if (copy.end < sinceTicks)
+			{
+				continue;
+			}
+
+			out << "," << std::endl << "{\"name\":\"" << copy.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->thread << ",\"ts\":"
+				<< (double)(long long)(copy.start - startTicks) / ticksPerMicrosecond << ",\"dur\":"
+				<< (double)(copy.end - copy.start) / ticksPerMicrosecond << "}";
+		}
+	}
+
+	return;
+}
+
+bool ProfilerClass::WriteTraceFile(const char* filename)
+{
+	std::ofstream fout;
+
+	fout.open(filename);
+	if (fout.fail())
+	{
+		return false;
+	}
+
+	WriteTrace(fout);
+	fout.close();
+
+	return !fout.fail();
+}
+
+double ProfilerClass::GetTraceTime(unsigned long long ticks)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	return (double)(long long)(ticks - s_startTicks) / GetTicksPerMicrosecond();
+}
+
+unsigned long long ProfilerClass::GetEventCount()
+{
+	unsigned long long count, head;
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	count = 0;
+	for (auto& ring : s_rings)
+	{
+		head = ring->head.load(std::memory_order_acquire);
+		count += std::min(head, RING_EVENTS - 1);
+	}
+
+	return count;
+}
+
+//GetTicksPerMicrosecond measures the counter against the steady clock over the time since Initialize, or says so when both are the same
+
+double ProfilerClass::GetTicksPerMicrosecond()
+{
+#ifdef PROFILER_RDTSC
+	double microseconds;
+
+	microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - s_startTime).count();
+	if (microseconds <= 0.0)
+	{
+		return 1.0;
+	}
+
+	return (double)(GetTicks() - s_startTicks) / microseconds;
+#else
+	return (double)std::chrono::steady_clock::period::den / ((double)std::chrono::steady_clock::period::num * 1000000.0);
+#endif
+}
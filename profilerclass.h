@@ -0,0 +1,122 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: profilerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _PROFILERCLASS_H_
+#define _PROFILERCLASS_H_
+
+/*
+The ProfilerClass records how long marked scopes of code take, on every thread, and writes them out as a Chrome trace that
+chrome://tracing and Perfetto open as a timeline. A scope is marked with PROFILE_SCOPE("name") at its top, or PROFILE_FUNCTION() for the
+whole function; the name has to stay valid for as long as the program runs, a string literal in practice. Builds that define
+PROFILER_DISABLED compile the markers out completely.
+
+A marker reads the time stamp counter when the scope starts and again when it ends, and then writes the name and the two stamps into its
+thread's ring buffer. Every thread has its own ring, only that thread ever writes to it, so recording takes no lock and no atomic read
+modify write: the write position is published with a release store after the event is in place. A thread gets its ring the first time
+it records something, which takes a lock once, and the rings stay around after their threads are gone so nothing recorded is lost. A
+ring holds the last 65535 scopes of its thread, older ones are overwritten; it has room for one more, the one being written while
+WriteTrace reads.
+
+WriteTrace can run while other threads go on recording. It copies each ring and then drops whatever the writer may have overwritten
+while it was copying. The counter stamps are turned into microseconds with the counter rate measured between Initialize and WriteTrace
+against the steady clock; where there is no time stamp counter the stamps are steady clock ticks to begin with.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <chrono>
+#include <ostream>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define PROFILER_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_RDTSC
+#endif
+
+#if !defined(PROFILER_DISABLED) && !defined(PROFILER_ENABLED)
+#define PROFILER_ENABLED
+#endif
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+
+#ifdef PROFILER_ENABLED
+#define PROFILE_SCOPE(name) ProfilerClass::ScopeType PROFILER_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_THREAD_NAME(name) ProfilerClass::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD_NAME(name)
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ProfilerClass
+////////////////////////////////////////////////////////////////////////////////
+class ProfilerClass
+{
+public:
+	//marks a scope from its construction to its destruction, use PROFILE_SCOPE instead of making one
+	class ScopeType
+	{
+	public:
+		explicit ScopeType(const char* name)
+			: m_name(name)
+			, m_start(ProfilerClass::GetTicks())
+		{
+		}
+
+		~ScopeType()
+		{
+			ProfilerClass::Record(m_name, m_start, ProfilerClass::GetTicks());
+		}
+
+	private:
+		ScopeType(const ScopeType&);
+		ScopeType& operator=(const ScopeType&);
+
+	private:
+		const char* m_name;
+		unsigned long long m_start;
+	};
+
+public:
+	//restarts the clock the trace is measured from, which otherwise starts with the program. Scopes that ended before are left out.
+	static void Initialize();
+
+	//names the calling thread in the trace
+	static void SetThreadName(const char*);
+
+	static void Record(const char*, unsigned long long, unsigned long long);
+
+	//writes every scope still in the rings as a Chrome trace, WriteTraceFile the same to a file
+	static void WriteTrace(std::ostream&);
+	static bool WriteTraceFile(const char*);
+
+	//writes the thread names and the scopes that ended at or after the given counter value as trace events, each one after a comma,
+	//for traces put together elsewhere. GetTraceTime turns a counter value into the trace's microseconds.
+	static void WriteEvents(std::ostream&, unsigned long long);
+	static double GetTraceTime(unsigned long long);
+
+	//how many scopes the rings hold right now
+	static unsigned long long GetEventCount();
+
+	static unsigned long long GetTicks()
+	{
+#ifdef PROFILER_RDTSC
+		return __rdtsc();
+#else
+		return (unsigned long long)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+
+private:
+	static double GetTicksPerMicrosecond();
+};
+
+#endif
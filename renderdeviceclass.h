@@ -0,0 +1,318 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderdeviceclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RENDERDEVICECLASS_H_
+#define _RENDERDEVICECLASS_H_
+
+/*
+The RenderDeviceClass and RenderContextClass are the thin layer between the engine and the graphics API. The device creates resources and
+the context records the state changes and draws, the same split Direct3D 11 has between ID3D11Device and ID3D11DeviceContext.
+Resources are referred to by RenderHandle instead of COM pointers and all the descriptions below are plain structs, so nothing here
+depends on the Windows or Direct3D headers. D3D11RenderDeviceClass is the real backend, NullRenderDeviceClass accepts everything and
+only counts it so the CPU side of the renderer can be run and profiled without a GPU.
+*/
+
+//handles are generational, see ResourcePoolClass. A handle whose resource was destroyed never refers to anything again.
+typedef unsigned int RenderHandle;
+
+const RenderHandle RENDER_NULL_HANDLE = 0;
+
+//ReleaseResource only destroys a resource after this many more EndScenes, once the frames that may still use it are off the GPU
+const unsigned int RENDER_RELEASE_LATENCY = 3;
+const unsigned int RENDER_APPEND_ALIGNED_ELEMENT = 0xffffffff;
+const float RENDER_FLOAT32_MAX = 3.402823466e+38f;
+
+enum RenderBindType
+{
+	RENDER_BIND_VERTEX_BUFFER,
+	RENDER_BIND_INDEX_BUFFER,
+	RENDER_BIND_CONSTANT_BUFFER,
+	RENDER_BIND_SHADER_RESOURCE
+};
+
+enum RenderUsage
+{
+	RENDER_USAGE_DEFAULT,
+	RENDER_USAGE_IMMUTABLE,
+	RENDER_USAGE_DYNAMIC
+};
+
+//how WriteBuffer maps a dynamic buffer, same as D3D11_MAP_WRITE_DISCARD and D3D11_MAP_WRITE_NO_OVERWRITE
+enum RenderMap
+{
+	RENDER_MAP_WRITE_DISCARD,
+	RENDER_MAP_WRITE_NO_OVERWRITE
+};
+
+enum RenderFormat
+{
+	RENDER_FORMAT_UNKNOWN,
+	RENDER_FORMAT_R32G32_FLOAT,
+	RENDER_FORMAT_R32G32B32_FLOAT,
+	RENDER_FORMAT_R32G32B32A32_FLOAT,
+	RENDER_FORMAT_R8G8B8A8_UNORM,
+	RENDER_FORMAT_R16_UINT,
+	RENDER_FORMAT_R32_UINT
+};
+
+enum RenderTopology
+{
+	RENDER_TOPOLOGY_TRIANGLELIST,
+	RENDER_TOPOLOGY_TRIANGLESTRIP,
+	RENDER_TOPOLOGY_LINELIST,
+	RENDER_TOPOLOGY_POINTLIST
+};
+
+enum RenderFilter
+{
+	RENDER_FILTER_MIN_MAG_MIP_POINT,
+	RENDER_FILTER_MIN_MAG_MIP_LINEAR,
+	RENDER_FILTER_ANISOTROPIC
+};
+
+enum RenderTextureAddress
+{
+	RENDER_TEXTURE_ADDRESS_WRAP,
+	RENDER_TEXTURE_ADDRESS_MIRROR,
+	RENDER_TEXTURE_ADDRESS_CLAMP,
+	RENDER_TEXTURE_ADDRESS_BORDER
+};
+
+enum RenderComparison
+{
+	RENDER_COMPARISON_NEVER,
+	RENDER_COMPARISON_LESS,
+	RENDER_COMPARISON_EQUAL,
+	RENDER_COMPARISON_LESS_EQUAL,
+	RENDER_COMPARISON_GREATER,
+	RENDER_COMPARISON_NOT_EQUAL,
+	RENDER_COMPARISON_GREATER_EQUAL,
+	RENDER_COMPARISON_ALWAYS
+};
+
+enum RenderFillMode
+{
+	RENDER_FILL_SOLID,
+	RENDER_FILL_WIREFRAME
+};
+
+enum RenderCullMode
+{
+	RENDER_CULL_NONE,
+	RENDER_CULL_FRONT,
+	RENDER_CULL_BACK
+};
+
+enum RenderBlend
+{
+	RENDER_BLEND_ZERO,
+	RENDER_BLEND_ONE,
+	RENDER_BLEND_SRC_COLOR,
+	RENDER_BLEND_INV_SRC_COLOR,
+	RENDER_BLEND_SRC_ALPHA,
+	RENDER_BLEND_INV_SRC_ALPHA,
+	RENDER_BLEND_DEST_ALPHA,
+	RENDER_BLEND_INV_DEST_ALPHA,
+	RENDER_BLEND_DEST_COLOR,
+	RENDER_BLEND_INV_DEST_COLOR
+};
+
+enum RenderBlendOp
+{
+	RENDER_BLEND_OP_ADD,
+	RENDER_BLEND_OP_SUBTRACT,
+	RENDER_BLEND_OP_REV_SUBTRACT,
+	RENDER_BLEND_OP_MIN,
+	RENDER_BLEND_OP_MAX
+};
+
+enum RenderStencilOp
+{
+	RENDER_STENCIL_OP_KEEP,
+	RENDER_STENCIL_OP_ZERO,
+	RENDER_STENCIL_OP_REPLACE,
+	RENDER_STENCIL_OP_INCR_SAT,
+	RENDER_STENCIL_OP_DECR_SAT,
+	RENDER_STENCIL_OP_INVERT,
+	RENDER_STENCIL_OP_INCR,
+	RENDER_STENCIL_OP_DECR
+};
+
+//the descriptions mirror their D3D11_*_DESC counterparts. Zero them (memset) before filling them in, like the D3D ones.
+
+//shader resource buffers are StructuredBuffers with elements of structureByteStride bytes, the other bind types ignore it
+struct RenderBufferDesc
+{
+	unsigned int byteWidth;
+	RenderUsage usage;
+	RenderBindType bindType;
+	unsigned int structureByteStride;
+};
+
+struct RenderTextureDesc
+{
+	unsigned int width;
+	unsigned int height;
+	RenderFormat format;
+	bool generateMips;
+};
+
+struct RenderInputElementDesc
+{
+	const char* semanticName;
+	unsigned int semanticIndex;
+	RenderFormat format;
+	unsigned int inputSlot;
+	unsigned int alignedByteOffset;
+};
+
+struct RenderSamplerDesc
+{
+	RenderFilter filter;
+	RenderTextureAddress addressU;
+	RenderTextureAddress addressV;
+	RenderTextureAddress addressW;
+	float mipLODBias;
+	unsigned int maxAnisotropy;
+	RenderComparison comparisonFunc;
+	float borderColor[4];
+	float minLOD;
+	float maxLOD;
+};
+
+struct RenderRasterizerDesc
+{
+	RenderFillMode fillMode;
+	RenderCullMode cullMode;
+	bool frontCounterClockwise;
+	int depthBias;
+	float depthBiasClamp;
+	float slopeScaledDepthBias;
+	bool depthClipEnable;
+	bool scissorEnable;
+	bool multisampleEnable;
+	bool antialiasedLineEnable;
+};
+
+struct RenderStencilOpDesc
+{
+	RenderStencilOp stencilFailOp;
+	RenderStencilOp stencilDepthFailOp;
+	RenderStencilOp stencilPassOp;
+	RenderComparison stencilFunc;
+};
+
+struct RenderDepthStencilDesc
+{
+	bool depthEnable;
+	bool depthWriteEnable;
+	RenderComparison depthFunc;
+	bool stencilEnable;
+	unsigned char stencilReadMask;
+	unsigned char stencilWriteMask;
+	RenderStencilOpDesc frontFace;
+	RenderStencilOpDesc backFace;
+};
+
+//there is only ever one render target, so the blend description is the one of render target 0. writeMask is D3D11_COLOR_WRITE_ENABLE.
+struct RenderBlendDesc
+{
+	bool alphaToCoverageEnable;
+	bool blendEnable;
+	RenderBlend srcBlend;
+	RenderBlend destBlend;
+	RenderBlendOp blendOp;
+	RenderBlend srcBlendAlpha;
+	RenderBlend destBlendAlpha;
+	RenderBlendOp blendOpAlpha;
+	unsigned char writeMask;
+};
+
+//one entry point of an HLSL file that a class creates a shader from, listed so the startup can compile it before the device exists
+struct RenderShaderDesc
+{
+	const wchar_t* filename;
+	const char* entryPoint;
+	bool pixelShader;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderContextClass
+////////////////////////////////////////////////////////////////////////////////
+class RenderContextClass
+{
+public:
+	virtual ~RenderContextClass() {}
+
+	//UpdateBuffer replaces the whole contents of a buffer: Map with WRITE_DISCARD for dynamic buffers, UpdateSubresource otherwise
+	virtual bool UpdateBuffer(RenderHandle, const void*, unsigned int) = 0;
+
+	//UpdateBufferRegion writes size bytes at a byte offset into a default usage buffer and leaves the rest of it alone
+	virtual bool UpdateBufferRegion(RenderHandle, unsigned int, const void*, unsigned int) = 0;
+
+	//WriteBuffer writes size bytes at a byte offset into a dynamic buffer. RENDER_MAP_WRITE_NO_OVERWRITE promises that nothing already
+	//submitted reads that range so the GPU does not have to be waited for, RENDER_MAP_WRITE_DISCARD gives the buffer fresh memory first.
+	virtual bool WriteBuffer(RenderHandle, unsigned int, const void*, unsigned int, RenderMap) = 0;
+
+	virtual void SetInputLayout(RenderHandle) = 0;
+	virtual void SetVertexBuffer(unsigned int, RenderHandle, unsigned int, unsigned int) = 0;
+	virtual void SetIndexBuffer(RenderHandle, RenderFormat, unsigned int) = 0;
+	virtual void SetPrimitiveTopology(RenderTopology) = 0;
+
+	virtual void SetVertexShader(RenderHandle) = 0;
+	virtual void SetVSConstantBuffer(unsigned int, RenderHandle) = 0;
+
+	virtual void SetPixelShader(RenderHandle) = 0;
+	virtual void SetPSConstantBuffer(unsigned int, RenderHandle) = 0;
+	//binds a texture or a RENDER_BIND_SHADER_RESOURCE buffer to a pixel shader t register
+	virtual void SetPSTexture(unsigned int, RenderHandle) = 0;
+	virtual void SetPSSampler(unsigned int, RenderHandle) = 0;
+
+	virtual void SetRasterizerState(RenderHandle) = 0;
+	virtual void SetDepthStencilState(RenderHandle, unsigned int) = 0;
+	virtual void SetBlendState(RenderHandle) = 0;
+
+	virtual void Draw(unsigned int, unsigned int) = 0;
+	virtual void DrawIndexed(unsigned int, unsigned int, int) = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderDeviceClass
+////////////////////////////////////////////////////////////////////////////////
+class RenderDeviceClass
+{
+public:
+	virtual ~RenderDeviceClass() {}
+
+	//every Create function returns RENDER_NULL_HANDLE on failure. ReleaseResource is deferred by RENDER_RELEASE_LATENCY frames, the
+	//handle keeps working until then but must not be used for new work. Shutdown destroys everything right away.
+	virtual RenderHandle CreateBuffer(const RenderBufferDesc&, const void*) = 0;
+	virtual RenderHandle CreateTexture2D(const RenderTextureDesc&, const void*, unsigned int) = 0;
+	virtual RenderHandle CreateVertexShader(const wchar_t*, const char*) = 0;
+	virtual RenderHandle CreatePixelShader(const wchar_t*, const char*) = 0;
+	virtual RenderHandle CreateInputLayout(const RenderInputElementDesc*, unsigned int, RenderHandle) = 0;
+	virtual RenderHandle CreateSamplerState(const RenderSamplerDesc&) = 0;
+	virtual RenderHandle CreateRasterizerState(const RenderRasterizerDesc&) = 0;
+	virtual RenderHandle CreateDepthStencilState(const RenderDepthStencilDesc&) = 0;
+	virtual RenderHandle CreateBlendState(const RenderBlendDesc&) = 0;
+	virtual void ReleaseResource(RenderHandle) = 0;
+
+	virtual RenderContextClass* GetImmediateContext() = 0;
+
+	/*
+	Deferred contexts record state changes and draws on any thread, one thread per context at a time. ExecuteDeferredContext plays
+	everything recorded so far back on the immediate context and leaves the deferred context empty and ready to record again, it has
+	to be called from the thread that uses the immediate context. No resources may be created or released while other threads record.
+	*/
+	virtual RenderContextClass* CreateDeferredContext() = 0;
+	virtual void ExecuteDeferredContext(RenderContextClass*) = 0;
+	virtual void ReleaseDeferredContext(RenderContextClass*) = 0;
+
+	//clear the back and depth buffers / present the back buffer
+	virtual void BeginScene(float, float, float, float) = 0;
+	virtual void EndScene() = 0;
+};
+
+#endif
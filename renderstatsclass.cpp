@@ -0,0 +1,597 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderstatsclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "renderstatsclass.h"
+#include <cstring>
+
+RenderStatsClass::RenderStatsClass()
+	: m_device(nullptr)
+	, m_immediateContext(nullptr)
+{
+	memset(&m_current, 0, sizeof(m_current));
+	memset(&m_lastFrame, 0, sizeof(m_lastFrame));
+	memset(&m_total, 0, sizeof(m_total));
+}
+
+RenderStatsClass::RenderStatsClass(const RenderStatsClass& other)
+{
+}
+
+
+RenderStatsClass::~RenderStatsClass()
+{
+}
+
+bool RenderStatsClass::Initialize(RenderDeviceClass* device)
+{
+	if (!device || !device->GetImmediateContext())
+	{
+		return false;
+	}
+
+	m_device = device;
+
+	m_immediateContext.reset(new RenderStatsContextClass());
+	if (!m_immediateContext)
+	{
+		return false;
+	}
+
+	m_immediateContext->Initialize(this, m_device->GetImmediateContext());
+
+	m_constantBuffers.clear();
+	memset(&m_current, 0, sizeof(m_current));
+	memset(&m_lastFrame, 0, sizeof(m_lastFrame));
+	memset(&m_total, 0, sizeof(m_total));
+
+	return true;
+}
+
+void RenderStatsClass::Shutdown()
+{
+	CloseLog();
+
+	// The deferred contexts still around go back to the device they came from.
+	for (auto& context : m_deferredContexts)
+	{
+		m_device->ReleaseDeferredContext(context->GetTarget());
+	}
+	m_deferredContexts.clear();
+
+	m_immediateContext.reset();
+	m_constantBuffers.clear();
+	m_device = nullptr;
+
+	return;
+}
+
+void RenderStatsClass::GetFrameStats(StatsType& stats)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	stats = m_lastFrame;
+	return;
+}
+
+void RenderStatsClass::GetTotalStats(StatsType& stats)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	stats = m_total;
+	return;
+}
+
+void RenderStatsClass::CountObjects(unsigned int visible, unsigned int culled)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_current.visibleObjects += visible;
+	m_current.culledObjects += culled;
+	return;
+}
+
+bool RenderStatsClass::OpenLog(const char* filename)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_log.is_open())
+	{
+		m_log.close();
+	}
+
+	m_log.open(filename);
+	if (m_log.fail())
+	{
+		return false;
+	}
+
+	WriteCSVHeader(m_log);
+
+	return true;
+}
+
+void RenderStatsClass::CloseLog()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_log.is_open())
+	{
+		m_log.close();
+	}
+
+	return;
+}
+
+void RenderStatsClass::WriteCSVHeader(std::ostream& out)
+{
+	out << "frame,draws,instances,triangles";
+	for (auto kind = 0; kind < STATE_KIND_COUNT; kind++)
+	{
+		out << "," << GetStateName(kind) << " changes";
+	}
+	out << ",constant buffer bytes,buffer bytes,texture bytes,created,released,visible,culled" << std::endl;
+
+	return;
+}
+
+void RenderStatsClass::WriteCSVLine(std::ostream& out, unsigned long long frame, const StatsType& stats)
+{
+	out << frame << "," << stats.draws << "," << stats.instances << "," << stats.triangles;
+	for (auto kind = 0; kind < STATE_KIND_COUNT; kind++)
+	{
+		out << "," << stats.stateChanges[kind];
+	}
+	out << "," << stats.constantBufferBytes << "," << stats.bufferBytes << "," << stats.textureBytes << "," << stats.resourcesCreated << ","
+		<< stats.resourcesReleased << "," << stats.visibleObjects << "," << stats.culledObjects << std::endl;
+
+	return;
+}
+
+const char* RenderStatsClass::GetStateName(int kind)
+{
+	static const char* names[STATE_KIND_COUNT] =
+	{
+		"input layout", "vertex buffer", "index buffer", "topology", "vertex shader", "pixel shader", "constant buffer", "texture",
+		"sampler", "rasterizer", "depth stencil", "blend"
+	};
+
+	return kind >= 0 && kind < STATE_KIND_COUNT ? names[kind] : "";
+}
+
+//CreateBuffer counts the initial data as uploaded and remembers the constant buffers, their writes are counted on their own
+
+RenderHandle RenderStatsClass::CreateBuffer(const RenderBufferDesc& desc, const void* initialData)
+{
+	RenderHandle handle;
+
+	handle = m_device->CreateBuffer(desc, initialData);
+	if (handle == RENDER_NULL_HANDLE)
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (desc.bindType == RENDER_BIND_CONSTANT_BUFFER)
+	{
+		m_constantBuffers.insert(handle);
+		m_current.constantBufferBytes += initialData ? desc.byteWidth : 0;
+	}
+	else
+	{
+		m_current.bufferBytes += initialData ? desc.byteWidth : 0;
+	}
+	m_current.resourcesCreated++;
+
+	return handle;
+}
+
+RenderHandle RenderStatsClass::CreateTexture2D(const RenderTextureDesc& desc, const void* data, unsigned int rowPitch)
+{
+	RenderHandle handle;
+
+	handle = m_device->CreateTexture2D(desc, data, rowPitch);
+	if (handle == RENDER_NULL_HANDLE)
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_current.textureBytes += data ? (unsigned long long)rowPitch * desc.height : 0;
+	m_current.resourcesCreated++;
+
+	return handle;
+}
+
+RenderHandle RenderStatsClass::CreateVertexShader(const wchar_t* filename, const char* entryPoint)
+{
+	return CountCreated(m_device->CreateVertexShader(filename, entryPoint));
+}
+
+RenderHandle RenderStatsClass::CreatePixelShader(const wchar_t* filename, const char* entryPoint)
+{
+	return CountCreated(m_device->CreatePixelShader(filename, entryPoint));
+}
+
+RenderHandle RenderStatsClass::CreateInputLayout(const RenderInputElementDesc* elements, unsigned int elementCount, RenderHandle vertexShader)
+{
+	return CountCreated(m_device->CreateInputLayout(elements, elementCount, vertexShader));
+}
+
+RenderHandle RenderStatsClass::CreateSamplerState(const RenderSamplerDesc& desc)
+{
+	return CountCreated(m_device->CreateSamplerState(desc));
+}
+
+RenderHandle RenderStatsClass::CreateRasterizerState(const RenderRasterizerDesc& desc)
+{
+	return CountCreated(m_device->CreateRasterizerState(desc));
+}
+
+RenderHandle RenderStatsClass::CreateDepthStencilState(const RenderDepthStencilDesc& desc)
+{
+	return CountCreated(m_device->CreateDepthStencilState(desc));
+}
+
+RenderHandle RenderStatsClass::CreateBlendState(const RenderBlendDesc& desc)
+{
+	return CountCreated(m_device->CreateBlendState(desc));
+}
+
+void RenderStatsClass::ReleaseResource(RenderHandle handle)
+{
+	if (handle == RENDER_NULL_HANDLE)
+	{
+		return;
+	}
+
+	m_device->ReleaseResource(handle);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_constantBuffers.erase(handle);
+	m_current.resourcesReleased++;
+
+	return;
+}
+
+RenderContextClass* RenderStatsClass::GetImmediateContext()
+{
+	return m_immediateContext.get();
+}
+
+RenderContextClass* RenderStatsClass::CreateDeferredContext()
+{
+	RenderContextClass* target;
+
+	target = m_device->CreateDeferredContext();
+	if (!target)
+	{
+		return nullptr;
+	}
+
+	m_deferredContexts.push_back(std::unique_ptr<RenderStatsContextClass>(new RenderStatsContextClass()));
+	m_deferredContexts.back()->Initialize(this, target);
+
+	return m_deferredContexts.back().get();
+}
+
+//ExecuteDeferredContext plays the context back on the device and adds what was recorded on it to the frame
+
+void RenderStatsClass::ExecuteDeferredContext(RenderContextClass* context)
+{
+	RenderStatsContextClass* statsContext = (RenderStatsContextClass*)context;
+
+	m_device->ExecuteDeferredContext(statsContext->GetTarget());
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	statsContext->TakeStats(m_current);
+
+	return;
+}
+
+void RenderStatsClass::ReleaseDeferredContext(RenderContextClass* context)
+{
+	for (size_t i = 0; i < m_deferredContexts.size(); i++)
+	{
+		if (m_deferredContexts[i].get() == context)
+		{
+			m_device->ReleaseDeferredContext(m_deferredContexts[i]->GetTarget());
+			m_deferredContexts.erase(m_deferredContexts.begin() + i);
+			break;
+		}
+	}
+
+	return;
+}
+
+void RenderStatsClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	m_device->BeginScene(red, green, blue, alpha);
+	return;
+}
+
+//EndScene closes the frame: the immediate context's counts join the frame's, which become the last frame and go into the totals
+
+void RenderStatsClass::EndScene()
+{
+	m_device->EndScene();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_immediateContext->TakeStats(m_current);
+	m_current.frames = 1;
+
+	m_lastFrame = m_current;
+	AddStats(m_total, m_current);
+	if (m_log.is_open())
+	{
+		WriteCSVLine(m_log, m_total.frames, m_current);
+	}
+
+	memset(&m_current, 0, sizeof(m_current));
+
+	return;
+}
+
+bool RenderStatsClass::IsConstantBuffer(RenderHandle buffer)
+{
+	return m_constantBuffers.find(buffer) != m_constantBuffers.end();
+}
+
+RenderHandle RenderStatsClass::CountCreated(RenderHandle handle)
+{
+	if (handle != RENDER_NULL_HANDLE)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_current.resourcesCreated++;
+	}
+
+	return handle;
+}
+
+void RenderStatsClass::AddStats(StatsType& stats, const StatsType& add)
+{
+	stats.frames += add.frames;
+	stats.draws += add.draws;
+	stats.instances += add.instances;
+	stats.triangles += add.triangles;
+	for (auto kind = 0; kind < STATE_KIND_COUNT; kind++)
+	{
+		stats.stateChanges[kind] += add.stateChanges[kind];
+	}
+	stats.constantBufferBytes += add.constantBufferBytes;
+	stats.bufferBytes += add.bufferBytes;
+	stats.textureBytes += add.textureBytes;
+	stats.resourcesCreated += add.resourcesCreated;
+	stats.resourcesReleased += add.resourcesReleased;
+	stats.visibleObjects += add.visibleObjects;
+	stats.culledObjects += add.culledObjects;
+
+	return;
+}
+
+//a context starts out with triangle lists, which is what every draw in the engine uses until it sets something else
+
+RenderStatsContextClass::RenderStatsContextClass()
+	: m_stats(nullptr)
+	, m_target(nullptr)
+	, m_topology(RENDER_TOPOLOGY_TRIANGLELIST)
+{
+	memset(&m_counts, 0, sizeof(m_counts));
+}
+
+RenderStatsContextClass::RenderStatsContextClass(const RenderStatsContextClass& other)
+{
+}
+
+
+RenderStatsContextClass::~RenderStatsContextClass()
+{
+}
+
+void RenderStatsContextClass::Initialize(RenderStatsClass* stats, RenderContextClass* target)
+{
+	m_stats = stats;
+	m_target = target;
+	m_topology = RENDER_TOPOLOGY_TRIANGLELIST;
+	memset(&m_counts, 0, sizeof(m_counts));
+
+	return;
+}
+
+RenderContextClass* RenderStatsContextClass::GetTarget()
+{
+	return m_target;
+}
+
+void RenderStatsContextClass::TakeStats(RenderStatsClass::StatsType& stats)
+{
+	stats.draws += m_counts.draws;
+	stats.instances += m_counts.instances;
+	stats.triangles += m_counts.triangles;
+	for (auto kind = 0; kind < RenderStatsClass::STATE_KIND_COUNT; kind++)
+	{
+		stats.stateChanges[kind] += m_counts.stateChanges[kind];
+	}
+	stats.constantBufferBytes += m_counts.constantBufferBytes;
+	stats.bufferBytes += m_counts.bufferBytes;
+
+	memset(&m_counts, 0, sizeof(m_counts));
+
+	return;
+}
+
+bool RenderStatsContextClass::UpdateBuffer(RenderHandle buffer, const void* data, unsigned int size)
+{
+	if (!m_target->UpdateBuffer(buffer, data, size))
+	{
+		return false;
+	}
+
+	CountWrite(buffer, size);
+
+	return true;
+}
+
+bool RenderStatsContextClass::UpdateBufferRegion(RenderHandle buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	if (!m_target->UpdateBufferRegion(buffer, offset, data, size))
+	{
+		return false;
+	}
+
+	CountWrite(buffer, size);
+
+	return true;
+}
+
+bool RenderStatsContextClass::WriteBuffer(RenderHandle buffer, unsigned int offset, const void* data, unsigned int size, RenderMap map)
+{
+	if (!m_target->WriteBuffer(buffer, offset, data, size, map))
+	{
+		return false;
+	}
+
+	CountWrite(buffer, size);
+
+	return true;
+}
+
+void RenderStatsContextClass::SetInputLayout(RenderHandle layout)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_INPUT_LAYOUT]++;
+	m_target->SetInputLayout(layout);
+	return;
+}
+
+void RenderStatsContextClass::SetVertexBuffer(unsigned int slot, RenderHandle buffer, unsigned int stride, unsigned int offset)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_VERTEX_BUFFER]++;
+	m_target->SetVertexBuffer(slot, buffer, stride, offset);
+	return;
+}
+
+void RenderStatsContextClass::SetIndexBuffer(RenderHandle buffer, RenderFormat format, unsigned int offset)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_INDEX_BUFFER]++;
+	m_target->SetIndexBuffer(buffer, format, offset);
+	return;
+}
+
+void RenderStatsContextClass::SetPrimitiveTopology(RenderTopology topology)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_TOPOLOGY]++;
+	m_topology = topology;
+	m_target->SetPrimitiveTopology(topology);
+	return;
+}
+
+void RenderStatsContextClass::SetVertexShader(RenderHandle shader)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_VERTEX_SHADER]++;
+	m_target->SetVertexShader(shader);
+	return;
+}
+
+void RenderStatsContextClass::SetVSConstantBuffer(unsigned int slot, RenderHandle buffer)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_CONSTANT_BUFFER]++;
+	m_target->SetVSConstantBuffer(slot, buffer);
+	return;
+}
+
+void RenderStatsContextClass::SetPixelShader(RenderHandle shader)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_PIXEL_SHADER]++;
+	m_target->SetPixelShader(shader);
+	return;
+}
+
+void RenderStatsContextClass::SetPSConstantBuffer(unsigned int slot, RenderHandle buffer)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_CONSTANT_BUFFER]++;
+	m_target->SetPSConstantBuffer(slot, buffer);
+	return;
+}
+
+void RenderStatsContextClass::SetPSTexture(unsigned int slot, RenderHandle texture)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_TEXTURE]++;
+	m_target->SetPSTexture(slot, texture);
+	return;
+}
+
+void RenderStatsContextClass::SetPSSampler(unsigned int slot, RenderHandle sampler)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_SAMPLER]++;
+	m_target->SetPSSampler(slot, sampler);
+	return;
+}
+
+void RenderStatsContextClass::SetRasterizerState(RenderHandle state)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_RASTERIZER]++;
+	m_target->SetRasterizerState(state);
+	return;
+}
+
+void RenderStatsContextClass::SetDepthStencilState(RenderHandle state, unsigned int stencilRef)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_DEPTH_STENCIL]++;
+	m_target->SetDepthStencilState(state, stencilRef);
+	return;
+}
+
+void RenderStatsContextClass::SetBlendState(RenderHandle state)
+{
+	m_counts.stateChanges[RenderStatsClass::STATE_BLEND]++;
+	m_target->SetBlendState(state);
+	return;
+}
+
+void RenderStatsContextClass::Draw(unsigned int vertexCount, unsigned int startVertex)
+{
+	CountDraw(vertexCount);
+	m_target->Draw(vertexCount, startVertex);
+	return;
+}
+
+void RenderStatsContextClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	CountDraw(indexCount);
+	m_target->DrawIndexed(indexCount, startIndex, baseVertex);
+	return;
+}
+
+void RenderStatsContextClass::CountWrite(RenderHandle buffer, unsigned int size)
+{
+	if (m_stats->IsConstantBuffer(buffer))
+	{
+		m_counts.constantBufferBytes += size;
+	}
+	else
+	{
+		m_counts.bufferBytes += size;
+	}
+
+	return;
+}
+
+//CountDraw counts the triangles the way the topology makes them out of the vertices, lines and points make none
+
+void RenderStatsContextClass::CountDraw(unsigned int count)
+{
+	m_counts.draws++;
+	m_counts.instances++;
+
+	switch (m_topology)
+	{
+	case RENDER_TOPOLOGY_TRIANGLELIST:
+		m_counts.triangles += count / 3;
+		break;
+	case RENDER_TOPOLOGY_TRIANGLESTRIP:
+		m_counts.triangles += count > 2 ? count - 2 : 0;
+		break;
+	default:
+		break;
+	}
+
+	return;
+}
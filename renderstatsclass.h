@@ -0,0 +1,196 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderstatsclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RENDERSTATSCLASS_H_
+#define _RENDERSTATSCLASS_H_
+
+/*
+The RenderStatsClass counts what the renderer sends to the device, every frame. It is a render device in front of the real one: every
+call is passed on unchanged, and on the way it counts the draws, instances and triangles, the state changes of every kind, the bytes
+written to constant buffers, other buffers and textures, and the resources created and released. GraphicsClass adds how many objects
+were visible and how many were culled. So the model's buffers, the light shader's parameters and the textures are all counted without
+any of them knowing, and on every backend the same way.
+
+Each context counts into its own plain counters, only the thread recording on it touches them, so a counted call costs an increment
+and the extra virtual call. A deferred context's counts are added to the frame when it is executed and the immediate context's at
+EndScene, which closes the frame: its counts become the last frame's stats and are added to the totals. GetFrameStats and GetTotalStats
+copy them out under a lock, so any thread can ask for them, and with a log open every frame is also written to it as a CSV line.
+
+State changes are counted behind the state filters, so they are the ones that really reach the device. The interface has no instanced
+draws yet, every draw is one instance. Released resources are destroyed RENDER_RELEASE_LATENCY frames later by the device.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <ostream>
+#include <unordered_set>
+
+class RenderStatsContextClass;
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderStatsClass
+////////////////////////////////////////////////////////////////////////////////
+class RenderStatsClass : public RenderDeviceClass
+{
+public:
+	//the kinds of state changes, also the order of their CSV columns
+	enum StateKind
+	{
+		STATE_INPUT_LAYOUT,
+		STATE_VERTEX_BUFFER,
+		STATE_INDEX_BUFFER,
+		STATE_TOPOLOGY,
+		STATE_VERTEX_SHADER,
+		STATE_PIXEL_SHADER,
+		STATE_CONSTANT_BUFFER,
+		STATE_TEXTURE,
+		STATE_SAMPLER,
+		STATE_RASTERIZER,
+		STATE_DEPTH_STENCIL,
+		STATE_BLEND,
+		STATE_KIND_COUNT
+	};
+
+	struct StatsType
+	{
+		unsigned long long frames;
+		unsigned long long draws;
+		unsigned long long instances;
+		unsigned long long triangles;
+		unsigned long long stateChanges[STATE_KIND_COUNT];
+		unsigned long long constantBufferBytes;
+		unsigned long long bufferBytes;
+		unsigned long long textureBytes;
+		unsigned long long resourcesCreated;
+		unsigned long long resourcesReleased;
+		unsigned long long visibleObjects;
+		unsigned long long culledObjects;
+	};
+
+public:
+	RenderStatsClass();
+	RenderStatsClass(const RenderStatsClass&);
+	~RenderStatsClass();
+
+	//the device the calls are passed on to, it has to outlive this one
+	bool Initialize(RenderDeviceClass*);
+	void Shutdown();
+
+	//the last finished frame and everything since Initialize, frames says how many frames that is
+	void GetFrameStats(StatsType&);
+	void GetTotalStats(StatsType&);
+
+	//adds the objects the frame going on drew and culled
+	void CountObjects(unsigned int, unsigned int);
+
+	//writes every frame from the next EndScene on to a CSV file, until CloseLog or Shutdown
+	bool OpenLog(const char*);
+	void CloseLog();
+
+	//the CSV header and one line of it, the first column is the frame number
+	static void WriteCSVHeader(std::ostream&);
+	static void WriteCSVLine(std::ostream&, unsigned long long, const StatsType&);
+	static const char* GetStateName(int);
+
+	//RenderDeviceClass
+	RenderHandle CreateBuffer(const RenderBufferDesc&, const void*);
+	RenderHandle CreateTexture2D(const RenderTextureDesc&, const void*, unsigned int);
+	RenderHandle CreateVertexShader(const wchar_t*, const char*);
+	RenderHandle CreatePixelShader(const wchar_t*, const char*);
+	RenderHandle CreateInputLayout(const RenderInputElementDesc*, unsigned int, RenderHandle);
+	RenderHandle CreateSamplerState(const RenderSamplerDesc&);
+	RenderHandle CreateRasterizerState(const RenderRasterizerDesc&);
+	RenderHandle CreateDepthStencilState(const RenderDepthStencilDesc&);
+	RenderHandle CreateBlendState(const RenderBlendDesc&);
+	void ReleaseResource(RenderHandle);
+
+	RenderContextClass* GetImmediateContext();
+	RenderContextClass* CreateDeferredContext();
+	void ExecuteDeferredContext(RenderContextClass*);
+	void ReleaseDeferredContext(RenderContextClass*);
+	void BeginScene(float, float, float, float);
+	void EndScene();
+
+	//used by the contexts to tell constant buffer writes from other buffer writes
+	bool IsConstantBuffer(RenderHandle);
+
+private:
+	RenderHandle CountCreated(RenderHandle);
+	static void AddStats(StatsType&, const StatsType&);
+
+private:
+	RenderDeviceClass* m_device;
+	std::unique_ptr<RenderStatsContextClass> m_immediateContext;
+	std::vector<std::unique_ptr<RenderStatsContextClass>> m_deferredContexts;
+
+	//only written while nothing records, see RenderDeviceClass::CreateDeferredContext, so the contexts read it without the lock
+	std::unordered_set<RenderHandle> m_constantBuffers;
+
+	//m_mutex guards everything below, the device calls count into m_current until EndScene
+	std::mutex m_mutex;
+	StatsType m_current;
+	StatsType m_lastFrame;
+	StatsType m_total;
+	std::ofstream m_log;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderStatsContextClass
+////////////////////////////////////////////////////////////////////////////////
+class RenderStatsContextClass : public RenderContextClass
+{
+public:
+	RenderStatsContextClass();
+	RenderStatsContextClass(const RenderStatsContextClass&);
+	~RenderStatsContextClass();
+
+	void Initialize(RenderStatsClass*, RenderContextClass*);
+	RenderContextClass* GetTarget();
+
+	//adds what was counted since the last call to the given stats and starts over
+	void TakeStats(RenderStatsClass::StatsType&);
+
+	bool UpdateBuffer(RenderHandle, const void*, unsigned int);
+	bool UpdateBufferRegion(RenderHandle, unsigned int, const void*, unsigned int);
+	bool WriteBuffer(RenderHandle, unsigned int, const void*, unsigned int, RenderMap);
+
+	void SetInputLayout(RenderHandle);
+	void SetVertexBuffer(unsigned int, RenderHandle, unsigned int, unsigned int);
+	void SetIndexBuffer(RenderHandle, RenderFormat, unsigned int);
+	void SetPrimitiveTopology(RenderTopology);
+
+	void SetVertexShader(RenderHandle);
+	void SetVSConstantBuffer(unsigned int, RenderHandle);
+
+	void SetPixelShader(RenderHandle);
+	void SetPSConstantBuffer(unsigned int, RenderHandle);
+	void SetPSTexture(unsigned int, RenderHandle);
+	void SetPSSampler(unsigned int, RenderHandle);
+
+	void SetRasterizerState(RenderHandle);
+	void SetDepthStencilState(RenderHandle, unsigned int);
+	void SetBlendState(RenderHandle);
+
+	void Draw(unsigned int, unsigned int);
+	void DrawIndexed(unsigned int, unsigned int, int);
+
+private:
+	void CountWrite(RenderHandle, unsigned int);
+	void CountDraw(unsigned int);
+
+private:
+	RenderStatsClass* m_stats;
+	RenderContextClass* m_target;
+	RenderTopology m_topology;
+	RenderStatsClass::StatsType m_counts;
+};
+
+#endif
@@ -0,0 +1,298 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: resourcepoolclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RESOURCEPOOLCLASS_H_
+#define _RESOURCEPOOLCLASS_H_
+
+/*
+The ResourcePoolClass keeps the objects of one resource type in one dense array and hands out RenderHandles for them. A handle is the
+slot index plus one in the low 16 bits, the slot's generation in the next 12 and the pool's type in the top 4, so a device with one pool
+per resource type can tell from the handle alone which pool to look in. Looking a handle up is two indexes and two compares, there is no
+reference count to touch, so it can be done for every bind of every draw.
+
+The objects live in chunks of CHUNK_SIZE slots that are allocated as the pool grows and never move, so Get and IsValid can be called
+from any thread, like the deferred contexts recording on the job system, while another thread adds to the pool. Add, Release, Retire
+and Clear change the bookkeeping and must only be called from one thread at a time.
+
+Releasing does not destroy anything straight away. The object stays where it is and its handle keeps working until Retire is called
+with the frame the release was meant for, because frames that were already submitted may still be using it. Retire destroys it, frees
+the slot and moves the slot's generation on, so the old handle no longer matches and a new object in the same slot gets a new handle.
+
+Get returns nullptr for a handle that is stale (its object was destroyed) or comes from another pool, and counts it. With
+RESOURCEPOOL_VALIDATE defined, which debug builds do, it also asserts, so code holding on to a handle after releasing it is caught at
+the first use instead of drawing with whatever was created in the slot later. IsValid checks a handle without asserting.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <cassert>
+
+#if defined(_DEBUG) && !defined(RESOURCEPOOL_VALIDATE)
+#define RESOURCEPOOL_VALIDATE
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ResourcePoolClass
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class ResourcePoolClass
+{
+private:
+	static const unsigned int INDEX_BITS = 16;
+	static const unsigned int GENERATION_BITS = 12;
+	static const unsigned int INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const unsigned int GENERATION_MASK = (1u << GENERATION_BITS) - 1;
+	static const unsigned int TYPE_SHIFT = INDEX_BITS + GENERATION_BITS;
+
+	//CHUNK_COUNT chunks of CHUNK_SIZE slots cover every index a handle can hold
+	static const unsigned int CHUNK_BITS = 10;
+	static const unsigned int CHUNK_SIZE = 1u << CHUNK_BITS;
+	static const unsigned int CHUNK_COUNT = (INDEX_MASK + 1) / CHUNK_SIZE;
+
+	//live is set from Add until Retire destroys the object, retireFrame is only meaningful while released is set
+	struct SlotType
+	{
+		unsigned int generation;
+		bool live;
+		bool released;
+		unsigned long long retireFrame;
+	};
+
+	struct ChunkType
+	{
+		T items[CHUNK_SIZE];
+		SlotType slots[CHUNK_SIZE];
+	};
+
+public:
+	//type is the pool's number in the top bits of its handles, 0 to 15
+	static const unsigned int MAX_TYPES = 16;
+
+	//the type of the pool a handle came from
+	static unsigned int GetType(RenderHandle handle)
+	{
+		return handle >> TYPE_SHIFT;
+	}
+
+	ResourcePoolClass()
+		: m_type(0)
+		, m_slotCount(0)
+		, m_count(0)
+		, m_staleCount(0)
+	{
+	}
+
+	void Initialize(unsigned int type)
+	{
+		m_type = type & (MAX_TYPES - 1);
+		for (auto& chunk : m_chunks)
+		{
+			chunk.reset();
+		}
+		m_slotCount = 0;
+		m_freeSlots.clear();
+		m_released.clear();
+		m_count = 0;
+		m_staleCount = 0;
+		return;
+	}
+
+	//returns RENDER_NULL_HANDLE once every slot is in use
+	RenderHandle Add(const T& item)
+	{
+		unsigned int index;
+
+		if (!m_freeSlots.empty())
+		{
+			index = m_freeSlots.back();
+			m_freeSlots.pop_back();
+		}
+		else
+		{
+			if (m_slotCount >= INDEX_MASK)
+			{
+				return RENDER_NULL_HANDLE;
+			}
+
+			// Slots already handed out never move, a full pool gets another chunk next to the others.
+			index = m_slotCount;
+			if (!m_chunks[index >> CHUNK_BITS])
+			{
+				m_chunks[index >> CHUNK_BITS].reset(new ChunkType());
+			}
+			Slot(index).generation = 0;
+			m_slotCount++;
+		}
+
+		Item(index) = item;
+		Slot(index).live = true;
+		Slot(index).released = false;
+		Slot(index).retireFrame = 0;
+		m_count++;
+
+		return MakeHandle(index);
+	}
+
+	T* Get(RenderHandle handle)
+	{
+		unsigned int index;
+
+		if (handle == RENDER_NULL_HANDLE)
+		{
+			return nullptr;
+		}
+
+		index = (handle & INDEX_MASK) - 1;
+		if (!IsValid(handle))
+		{
+			m_staleCount.fetch_add(1, std::memory_order_relaxed);
+#ifdef RESOURCEPOOL_VALIDATE
+			assert(!"stale or foreign resource handle");
+#endif
+			return nullptr;
+		}
+
+		return &Item(index);
+	}
+
+	//a handle only gets here after the Add that made its chunk, so reading the chunk pointer does not race with Add
+	bool IsValid(RenderHandle handle)
+	{
+		unsigned int index;
+
+		index = (handle & INDEX_MASK) - 1;
+
+		return handle != RENDER_NULL_HANDLE && (handle >> TYPE_SHIFT) == m_type && index < INDEX_MASK && m_chunks[index >> CHUNK_BITS] &&
+			Slot(index).live && Slot(index).generation == ((handle >> INDEX_BITS) & GENERATION_MASK);
+	}
+
+	//the object is destroyed by the first Retire for retireFrame or later, releasing twice or a stale handle does nothing
+	bool Release(RenderHandle handle, unsigned long long retireFrame)
+	{
+		unsigned int index;
+
+		if (!IsValid(handle))
+		{
+			return false;
+		}
+
+		index = (handle & INDEX_MASK) - 1;
+		if (Slot(index).released)
+		{
+			return false;
+		}
+
+		Slot(index).released = true;
+		Slot(index).retireFrame = retireFrame;
+		m_released.push_back(index);
+
+		return true;
+	}
+
+	//calls destroy on every released object whose frame has come and frees its slot
+	template <typename F>
+	void Retire(unsigned long long frame, F destroy)
+	{
+		size_t kept;
+
+		kept = 0;
+		for (size_t i = 0; i < m_released.size(); i++)
+		{
+			if (Slot(m_released[i]).retireFrame <= frame)
+			{
+				Destroy(m_released[i], destroy);
+			}
+			else
+			{
+				m_released[kept++] = m_released[i];
+			}
+		}
+		m_released.resize(kept);
+
+		return;
+	}
+
+	//destroys everything still in the pool, released or not
+	template <typename F>
+	void Clear(F destroy)
+	{
+		for (unsigned int i = 0; i < m_slotCount; i++)
+		{
+			if (Slot(i).live)
+			{
+				Destroy(i, destroy);
+			}
+		}
+		m_released.clear();
+
+		return;
+	}
+
+	//live objects, including released ones waiting for Retire
+	int GetCount()
+	{
+		return m_count;
+	}
+
+	int GetReleasedCount()
+	{
+		return (int)m_released.size();
+	}
+
+	unsigned int GetStaleCount()
+	{
+		return m_staleCount.load(std::memory_order_relaxed);
+	}
+
+private:
+	T& Item(unsigned int index)
+	{
+		return m_chunks[index >> CHUNK_BITS]->items[index & (CHUNK_SIZE - 1)];
+	}
+
+	SlotType& Slot(unsigned int index)
+	{
+		return m_chunks[index >> CHUNK_BITS]->slots[index & (CHUNK_SIZE - 1)];
+	}
+
+	RenderHandle MakeHandle(unsigned int index)
+	{
+		return (m_type << TYPE_SHIFT) | (Slot(index).generation << INDEX_BITS) | (index + 1);
+	}
+
+	template <typename F>
+	void Destroy(unsigned int index, F& destroy)
+	{
+		destroy(Item(index));
+		Item(index) = T();
+
+		Slot(index).live = false;
+		Slot(index).released = false;
+		Slot(index).generation = (Slot(index).generation + 1) & GENERATION_MASK;
+		m_freeSlots.push_back(index);
+		m_count--;
+
+		return;
+	}
+
+private:
+	unsigned int m_type;
+	std::unique_ptr<ChunkType> m_chunks[CHUNK_COUNT];
+	unsigned int m_slotCount;
+	std::vector<unsigned int> m_freeSlots;
+	std::vector<unsigned int> m_released;
+	int m_count;
+
+	//Get counts from any thread
+	std::atomic<uint32_t> m_staleCount;
+};
+
+#endif
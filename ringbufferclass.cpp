@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ringbufferclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "ringbufferclass.h"
+#include <cstring>
+
+RingBufferClass::RingBufferClass()
+	: m_device(nullptr)
+	, m_buffer(RENDER_NULL_HANDLE)
+	, m_size(0)
+	, m_position(0)
+	, m_frame(0)
+	, m_discard(true)
+{
+	memset(m_fences, 0, sizeof(m_fences));
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+RingBufferClass::RingBufferClass(const RingBufferClass& other)
+{
+}
+
+
+RingBufferClass::~RingBufferClass()
+{
+}
+
+bool RingBufferClass::Initialize(RenderDeviceClass* device, RenderBindType bindType, unsigned int size)
+{
+	RenderBufferDesc bufferDesc;
+
+	if (!device || size == 0)
+	{
+		return false;
+	}
+
+	m_device = device;
+	m_size = size;
+
+	memset(&bufferDesc, 0, sizeof(bufferDesc));
+	bufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	bufferDesc.byteWidth = size;
+	bufferDesc.bindType = bindType;
+
+	m_buffer = m_device->CreateBuffer(bufferDesc, nullptr);
+	if (m_buffer == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	m_position = 0;
+	m_frame = 0;
+	m_discard = true;
+	memset(m_fences, 0, sizeof(m_fences));
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	return true;
+}
+
+void RingBufferClass::Shutdown()
+{
+	if (m_device)
+	{
+		m_device->ReleaseResource(m_buffer);
+	}
+
+	m_buffer = RENDER_NULL_HANDLE;
+	m_device = nullptr;
+	m_size = 0;
+
+	return;
+}
+
+/*
+Write finds the next aligned offset and wraps to 0 when the data does not fit before the end, skipping the rest of the buffer. The range
+written at position p overwrites what was written at p - m_size, which is safe once the frame that wrote it is done: the fence of the
+frame RENDER_RELEASE_LATENCY frames back says how far that is.
+*/
+
+bool RingBufferClass::Write(RenderContextClass* context, const void* data, unsigned int size, unsigned int alignment, unsigned int& offset)
+{
+	unsigned int current;
+	RenderMap map;
+	bool result;
+
+	if (m_buffer == RENDER_NULL_HANDLE || !data || size == 0)
+	{
+		return false;
+	}
+
+	if (size > m_size)
+	{
+		m_stats.overflows++;
+		return false;
+	}
+
+	alignment = alignment > 0 ? alignment : 1;
+	current = (unsigned int)(m_position % m_size);
+	offset = (current + alignment - 1) / alignment * alignment;
+	map = m_discard ? RENDER_MAP_WRITE_DISCARD : RENDER_MAP_WRITE_NO_OVERWRITE;
+
+	if (offset + size > m_size)
+	{
+		m_position += m_size - current;
+		current = 0;
+		offset = 0;
+		map = RENDER_MAP_WRITE_DISCARD;
+		m_stats.wraps++;
+	}
+
+	// The oldest frame that may still be in flight wrote everything after its predecessor's fence.
+	if (m_position + (offset - current) + size > m_fences[m_frame % RENDER_RELEASE_LATENCY] + m_size)
+	{
+		m_stats.wrapStalls++;
+	}
+
+	result = context->WriteBuffer(m_buffer, offset, data, size, map);
+	if (!result)
+	{
+		return false;
+	}
+
+	m_position += (offset - current) + size;
+	m_discard = false;
+
+	m_stats.bytesStreamed += size;
+	m_stats.writes++;
+
+	return true;
+}
+
+//EndFrame keeps the ring position of the frame that just ended, it is the fence the frame RENDER_RELEASE_LATENCY frames from now checks.
+
+void RingBufferClass::EndFrame()
+{
+	m_fences[m_frame % RENDER_RELEASE_LATENCY] = m_position;
+	m_frame++;
+
+	return;
+}
+
+RenderHandle RingBufferClass::GetBuffer()
+{
+	return m_buffer;
+}
+
+unsigned int RingBufferClass::GetSize()
+{
+	return m_size;
+}
+
+const RingBufferClass::StatsType& RingBufferClass::GetStats()
+{
+	return m_stats;
+}
+
+void RingBufferClass::ResetStats()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	return;
+}
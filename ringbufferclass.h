@@ -0,0 +1,76 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ringbufferclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RINGBUFFERCLASS_H_
+#define _RINGBUFFERCLASS_H_
+
+/*
+The RingBufferClass streams data the CPU makes up every frame, such as debug lines, particles or UI, through one dynamic buffer. Every
+Write goes right after the previous one and maps the buffer with NO_OVERWRITE, which lets the driver skip waiting for the GPU because
+nothing submitted reads that range. When a write does not fit before the end the ring wraps: it starts again at offset 0 and maps with
+DISCARD, which gives the buffer fresh memory so the draws still in flight keep reading the old contents.
+
+EndFrame puts down a fence, the ring position at the end of the frame. A frame counts as done on the GPU RENDER_RELEASE_LATENCY frames
+later, the same latency the device releases resources with. A wrap that reuses a range one of the unfinished frames wrote is counted as
+a wrap stall: Direct3D 11 hands out new memory for the DISCARD instead of waiting, but an API with real fences would have to stall there,
+and either way it means the ring is smaller than the frames in flight need.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RingBufferClass
+////////////////////////////////////////////////////////////////////////////////
+class RingBufferClass
+{
+public:
+	struct StatsType
+	{
+		unsigned long long bytesStreamed;
+		unsigned long long writes;
+		unsigned long long wraps;
+		unsigned long long wrapStalls;
+		unsigned long long overflows;
+	};
+
+public:
+	RingBufferClass();
+	RingBufferClass(const RingBufferClass&);
+	~RingBufferClass();
+
+	//device, RENDER_BIND_VERTEX_BUFFER or RENDER_BIND_INDEX_BUFFER and the size in bytes
+	bool Initialize(RenderDeviceClass*, RenderBindType, unsigned int);
+	void Shutdown();
+
+	//writes size bytes at the next offset that is a multiple of alignment and returns the offset in the last argument. Fails for
+	//writes bigger than the ring. Only on the immediate context, see D3D11RenderContextClass::WriteBuffer.
+	bool Write(RenderContextClass*, const void*, unsigned int, unsigned int, unsigned int&);
+
+	//once per frame after its last Write
+	void EndFrame();
+
+	RenderHandle GetBuffer();
+	unsigned int GetSize();
+	const StatsType& GetStats();
+	void ResetStats();
+
+private:
+	RenderDeviceClass* m_device;
+	RenderHandle m_buffer;
+	unsigned int m_size;
+
+	//positions count every byte ever handed out, the offset in the buffer is the position modulo m_size
+	unsigned long long m_position;
+	unsigned long long m_fences[RENDER_RELEASE_LATENCY];
+	unsigned long long m_frame;
+	bool m_discard;
+
+	StatsType m_stats;
+};
+
+#endif
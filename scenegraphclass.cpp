@@ -0,0 +1,432 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: scenegraphclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "scenegraphclass.h"
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define SCENEGRAPH_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//the index of the lowest set bit, mask must not be 0
+static int LowestBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+SceneGraphClass::SceneGraphClass()
+	: m_structureChanged(false)
+	, m_updatedCount(0)
+	, m_updateTime(0.0f)
+	, m_parallelUpdated(0)
+	, m_jobs(nullptr)
+{
+}
+
+SceneGraphClass::SceneGraphClass(const SceneGraphClass& other)
+{
+}
+
+
+SceneGraphClass::~SceneGraphClass()
+{
+}
+
+//Initialize takes the job system the large levels are updated on, nullptr updates everything on the calling thread.
+
+bool SceneGraphClass::Initialize(JobSystemClass* jobs)
+{
+	m_jobs = jobs;
+
+	m_levelStart.clear();
+	m_levelStart.push_back(0);
+	m_structureChanged = false;
+
+	return true;
+}
+
+void SceneGraphClass::Shutdown()
+{
+	m_jobs = nullptr;
+
+	m_parent.clear();
+	m_firstChild.clear();
+	m_childCount.clear();
+	m_handle.clear();
+	m_dirty.clear();
+	m_local.clear();
+	m_world.clear();
+	m_levelStart.clear();
+	m_index.clear();
+	m_parentHandle.clear();
+	m_removed.clear();
+	m_freeHandles.clear();
+
+	return;
+}
+
+//AddNode appends the node at the end of the arrays, it gets moved to its proper place by the next Update.
+
+int SceneGraphClass::AddNode(int parentHandle)
+{
+	XMFLOAT4X4A identity;
+	int handle;
+
+	if (parentHandle >= (int)m_index.size() || (parentHandle >= 0 && m_index[parentHandle] < 0))
+	{
+		return -1;
+	}
+
+	if (!m_freeHandles.empty())
+	{
+		handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+	}
+	else
+	{
+		handle = (int)m_index.size();
+		m_index.push_back(-1);
+		m_parentHandle.push_back(-1);
+		m_removed.push_back(0);
+	}
+
+	XMStoreFloat4x4A(&identity, XMMatrixIdentity());
+
+	m_index[handle] = (int)m_handle.size();
+	m_parentHandle[handle] = parentHandle;
+	m_removed[handle] = 0;
+
+	m_parent.push_back(-1);
+	m_firstChild.push_back(0);
+	m_childCount.push_back(0);
+	m_handle.push_back(handle);
+	m_dirty.push_back(1);
+	m_local.push_back(identity);
+	m_world.push_back(identity);
+
+	m_structureChanged = true;
+
+	return handle;
+}
+
+//RemoveNode only marks the node, Rebuild drops it together with every node below it.
+
+void SceneGraphClass::RemoveNode(int handle)
+{
+	if (handle < 0 || handle >= (int)m_index.size() || m_index[handle] < 0)
+	{
+		return;
+	}
+
+	m_removed[handle] = 1;
+	m_structureChanged = true;
+
+	return;
+}
+
+void SceneGraphClass::Reserve(int nodeCount)
+{
+	m_parent.reserve(nodeCount);
+	m_firstChild.reserve(nodeCount);
+	m_childCount.reserve(nodeCount);
+	m_handle.reserve(nodeCount);
+	m_dirty.reserve(nodeCount);
+	m_local.reserve(nodeCount);
+	m_world.reserve(nodeCount);
+	m_index.reserve(nodeCount);
+	m_parentHandle.reserve(nodeCount);
+	m_removed.reserve(nodeCount);
+
+	return;
+}
+
+void SceneGraphClass::SetLocalTransform(int handle, FXMMATRIX local)
+{
+	int index = m_index[handle];
+
+	XMStoreFloat4x4A(&m_local[index], local);
+	m_dirty[index] = 1;
+
+	return;
+}
+
+void SceneGraphClass::GetLocalTransform(int handle, XMFLOAT4X4& local)
+{
+	XMStoreFloat4x4(&local, XMLoadFloat4x4A(&m_local[m_index[handle]]));
+	return;
+}
+
+void SceneGraphClass::GetWorldTransform(int handle, XMFLOAT4X4& world)
+{
+	XMStoreFloat4x4(&world, XMLoadFloat4x4A(&m_world[m_index[handle]]));
+	return;
+}
+
+//Update brings every world transform up to date. The levels have to go one after the other since a level needs the finished world
+//transforms of the one above it, but the nodes inside a level are independent.
+
+void SceneGraphClass::Update()
+{
+	int first, last;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	if (m_structureChanged)
+	{
+		Rebuild();
+	}
+
+	m_updatedCount = 0;
+
+	for (size_t level = 0; level + 1 < m_levelStart.size(); level++)
+	{
+		first = m_levelStart[level];
+		last = m_levelStart[level + 1];
+
+		if (!m_jobs || last - first < PARALLEL_LEVEL_SIZE)
+		{
+			m_updatedCount += UpdateRange(first, last);
+			continue;
+		}
+
+		m_parallelUpdated.store(0);
+		m_jobs->ParallelFor((last - first + BLOCK_SIZE - 1) / BLOCK_SIZE, 1, [this, first, last](int begin, int end)
+		{
+			m_parallelUpdated.fetch_add(UpdateRange(first + begin * BLOCK_SIZE, std::min(first + end * BLOCK_SIZE, last)));
+		});
+
+		m_updatedCount += m_parallelUpdated.load();
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	m_updateTime = std::chrono::duration<float, std::milli>(end - start).count();
+
+	return;
+}
+
+int SceneGraphClass::GetNodeCount()
+{
+	return (int)m_handle.size();
+}
+
+int SceneGraphClass::GetDepth()
+{
+	return (int)m_levelStart.size() - 1;
+}
+
+//GetUpdatedCount returns how many world transforms the last Update recomputed and GetUpdateTime how many milliseconds it took.
+
+int SceneGraphClass::GetUpdatedCount()
+{
+	return m_updatedCount;
+}
+
+float SceneGraphClass::GetUpdateTime()
+{
+	return m_updateTime;
+}
+
+/*
+Rebuild puts the arrays back into breadth first order after nodes were added or removed. The children of every node are gathered
+into one packed list (counting sort on the parent handle, which keeps them in their old relative order), then the levels are walked
+one by one starting from the roots. Removed nodes are never visited, so neither are the nodes below them, and everything that was
+not visited goes back to the free list. The dirty flags and transforms move along with their nodes.
+*/
+
+void SceneGraphClass::Rebuild()
+{
+	std::vector<int> childStart(m_index.size() + 1, 0);
+	std::vector<int> children(m_handle.size());
+	std::vector<int> order;
+	std::vector<int> parent, firstChild, childCount, handles;
+	std::vector<unsigned char> dirty;
+	std::vector<XMFLOAT4X4A> local, world;
+	int handle, parentHandle, levelEnd;
+
+	// Count the children of every handle and turn the counts into offsets.
+	for (auto i = 0; i < (int)m_handle.size(); i++)
+	{
+		parentHandle = m_parentHandle[m_handle[i]];
+		if (parentHandle >= 0)
+		{
+			childStart[parentHandle + 1]++;
+		}
+	}
+	for (size_t i = 1; i < childStart.size(); i++)
+	{
+		childStart[i] += childStart[i - 1];
+	}
+	{
+		std::vector<int> fill(childStart.begin(), childStart.end() - 1);
+		for (auto i = 0; i < (int)m_handle.size(); i++)
+		{
+			parentHandle = m_parentHandle[m_handle[i]];
+			if (parentHandle >= 0)
+			{
+				children[fill[parentHandle]++] = m_handle[i];
+			}
+		}
+	}
+
+	// The first level is every root that is still alive.
+	order.reserve(m_handle.size());
+	m_levelStart.clear();
+	m_levelStart.push_back(0);
+	for (auto i = 0; i < (int)m_handle.size(); i++)
+	{
+		handle = m_handle[i];
+		if (m_parentHandle[handle] < 0 && !m_removed[handle])
+		{
+			order.push_back(handle);
+		}
+	}
+
+	// Every following level is the children of the level before, in the order of their parents.
+	while ((int)order.size() > m_levelStart.back())
+	{
+		levelEnd = (int)order.size();
+		for (auto i = m_levelStart.back(); i < levelEnd; i++)
+		{
+			handle = order[i];
+			for (auto c = childStart[handle]; c < childStart[handle + 1]; c++)
+			{
+				if (!m_removed[children[c]])
+				{
+					order.push_back(children[c]);
+				}
+			}
+		}
+		m_levelStart.push_back(levelEnd);
+	}
+
+	// Move the nodes into their new places. The parents come first so their new index is known by the time we get to the children.
+	parent.resize(order.size());
+	firstChild.resize(order.size(), 0);
+	childCount.resize(order.size(), 0);
+	handles.resize(order.size());
+	dirty.resize(order.size());
+	local.resize(order.size());
+	world.resize(order.size());
+
+	std::vector<int> newIndex(m_index.size(), -1);
+	for (auto i = 0; i < (int)order.size(); i++)
+	{
+		handle = order[i];
+		newIndex[handle] = i;
+
+		handles[i] = handle;
+		dirty[i] = m_dirty[m_index[handle]];
+		local[i] = m_local[m_index[handle]];
+		world[i] = m_world[m_index[handle]];
+
+		parentHandle = m_parentHandle[handle];
+		if (parentHandle >= 0)
+		{
+			parent[i] = newIndex[parentHandle];
+			if (childCount[parent[i]] == 0)
+			{
+				firstChild[parent[i]] = i;
+			}
+			childCount[parent[i]]++;
+		}
+		else
+		{
+			parent[i] = -1;
+		}
+	}
+
+	// Everything that was removed or sat below a removed node gives its handle back.
+	for (auto i = 0; i < (int)m_handle.size(); i++)
+	{
+		handle = m_handle[i];
+		if (newIndex[handle] < 0)
+		{
+			m_removed[handle] = 0;
+			m_parentHandle[handle] = -1;
+			m_freeHandles.push_back(handle);
+		}
+	}
+
+	m_index.swap(newIndex);
+	m_parent.swap(parent);
+	m_firstChild.swap(firstChild);
+	m_childCount.swap(childCount);
+	m_handle.swap(handles);
+	m_dirty.swap(dirty);
+	m_local.swap(local);
+	m_world.swap(world);
+
+	m_structureChanged = false;
+
+	return;
+}
+
+//UpdateRange recomputes the dirty nodes in [first, last) and returns how many there were. Clean nodes are skipped 16 at a time.
+
+int SceneGraphClass::UpdateRange(int first, int last)
+{
+	unsigned int mask;
+	int count = 0;
+	int i = first;
+
+#ifdef SCENEGRAPH_SSE2
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; i + 16 <= last; i += 16)
+	{
+		// One bit for every flag that is not zero.
+		mask = ~(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&m_dirty[i]), zero)) & 0xFFFF;
+		while (mask)
+		{
+			UpdateNode(i + LowestBit(mask));
+			mask &= mask - 1;
+			count++;
+		}
+	}
+#endif
+
+	for (; i < last; i++)
+	{
+		if (m_dirty[i])
+		{
+			UpdateNode(i);
+			count++;
+		}
+	}
+
+	return count;
+}
+
+//UpdateNode recomputes one world transform and passes the change on to the node's children, which sit in the next level.
+
+void SceneGraphClass::UpdateNode(int index)
+{
+	XMMATRIX world = XMLoadFloat4x4A(&m_local[index]);
+
+	if (m_parent[index] >= 0)
+	{
+		world = XMMatrixMultiply(world, XMLoadFloat4x4A(&m_world[m_parent[index]]));
+	}
+	XMStoreFloat4x4A(&m_world[index], world);
+
+	m_dirty[index] = 0;
+	if (m_childCount[index] > 0)
+	{
+		memset(&m_dirty[m_firstChild[index]], 1, m_childCount[index]);
+	}
+
+	return;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: scenegraphclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SCENEGRAPHCLASS_H_
+#define _SCENEGRAPHCLASS_H_
+
+/*
+The SceneGraphClass holds the parent/child transform hierarchy. Every node has a local transform relative to its parent and a world
+transform that Update works out from the local transforms.
+
+Nodes are not stored as a tree of objects but in flat arrays (one array per attribute) sorted breadth first: all the roots, then all
+their children, then the grandchildren and so on. A parent always comes before its children, so one walk front to back sees every
+world matrix it needs already finished, and the children of a node sit next to each other in the following level. Every node has a
+dirty flag. Setting a local transform raises it, and when Update recomputes a node it raises the flags of the node's children and
+clears its own, so only the subtrees below changed nodes are touched. The flag arrays are scanned 16 at a time with SSE2 to skip over
+clean nodes quickly, and large levels are cut into blocks that run as jobs on the JobSystemClass in parallel since nodes of the same
+level never depend on each other.
+
+Callers refer to nodes by handle. The position of a node in the arrays changes whenever nodes are added or removed, which is done
+lazily on the next Update.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <DirectXMath.h>
+#include <vector>
+#include <atomic>
+#include "jobsystemclass.h"
+
+using namespace DirectX;
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: SceneGraphClass
+////////////////////////////////////////////////////////////////////////////////
+class SceneGraphClass
+{
+private:
+	//levels with at least PARALLEL_LEVEL_SIZE nodes are split into jobs of BLOCK_SIZE nodes
+	static const int PARALLEL_LEVEL_SIZE = 16384;
+	static const int BLOCK_SIZE = 2048;
+
+public:
+	SceneGraphClass();
+	SceneGraphClass(const SceneGraphClass&);
+	~SceneGraphClass();
+
+	bool Initialize(JobSystemClass*);
+	void Shutdown();
+
+	//AddNode returns the new node's handle, pass -1 as the parent for a root node. RemoveNode removes the node and everything below it.
+	int AddNode(int);
+	void RemoveNode(int);
+	void Reserve(int);
+
+	void SetLocalTransform(int, FXMMATRIX);
+	void GetLocalTransform(int, XMFLOAT4X4&);
+
+	//only valid after an Update that came after the node was added
+	void GetWorldTransform(int, XMFLOAT4X4&);
+
+	void Update();
+
+	int GetNodeCount();
+	int GetDepth();
+	int GetUpdatedCount();
+	float GetUpdateTime();
+
+private:
+	void Rebuild();
+	int UpdateRange(int, int);
+	void UpdateNode(int);
+
+private:
+	//the node arrays, in breadth first order
+	std::vector<int> m_parent;
+	std::vector<int> m_firstChild;
+	std::vector<int> m_childCount;
+	std::vector<int> m_handle;
+	std::vector<unsigned char> m_dirty;
+	std::vector<XMFLOAT4X4A> m_local;
+	std::vector<XMFLOAT4X4A> m_world;
+
+	//m_levelStart[d] is the index of the first node at depth d, the last entry is the node count
+	std::vector<int> m_levelStart;
+
+	//handle bookkeeping, m_index is -1 for free handles. m_parentHandle is what Rebuild sorts the nodes by.
+	std::vector<int> m_index;
+	std::vector<int> m_parentHandle;
+	std::vector<unsigned char> m_removed;
+	std::vector<int> m_freeHandles;
+	bool m_structureChanged;
+
+	int m_updatedCount;
+	float m_updateTime;
+
+	//the jobs of a level add the nodes they updated here
+	std::atomic<int> m_parallelUpdated;
+
+	//nullptr updates everything on the calling thread
+	JobSystemClass* m_jobs;
+};
+
+#endif
@@ -0,0 +1,195 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: snapshotexchangeclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SNAPSHOTEXCHANGECLASS_H_
+#define _SNAPSHOTEXCHANGECLASS_H_
+
+/*
+The SnapshotExchangeClass hands per frame snapshots from one producer thread (the simulation) to one consumer thread (the renderer)
+without locks. It is a triple buffer: the producer always owns one slot to write the next snapshot into, the consumer owns the slot it
+is rendering from and the third slot holds the newest finished snapshot. Publishing and acquiring are a single atomic exchange of the
+middle slot, so neither side ever waits for the other to finish copying. When the producer publishes twice before the consumer looks,
+the older snapshot is simply replaced - the renderer always gets the newest one.
+
+The pipeline depth bounds how far the producer may run ahead: WaitForConsumer blocks while there are depth or more published frames
+the consumer has not finished. A depth of 1 keeps the two threads in lock step, 2 lets the simulation build the next frame while the
+last one renders, and 0 removes the limit.
+
+A side that has to wait, the producer in WaitForConsumer or the consumer in WaitForSnapshot, sleeps on a condition variable instead of
+spinning, so a renderer with nothing to draw or a simulation held back by the pacer leaves the core alone. Publish and Complete wake
+it, which takes the lock for a moment once a frame. The waits also end when the stop flag they were given is raised, whoever raises it
+calls Notify afterwards.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: SnapshotExchangeClass
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class SnapshotExchangeClass
+{
+private:
+	//the middle slot index is stored together with a flag telling whether it holds a snapshot the consumer has not taken yet
+	static const unsigned int SLOT_MASK = 3;
+	static const unsigned int FRESH_FLAG = 4;
+
+public:
+	SnapshotExchangeClass()
+		: m_middle(1)
+		, m_writeSlot(0)
+		, m_readSlot(2)
+		, m_depth(2)
+		, m_published(0)
+		, m_completed(0)
+	{
+		m_frames[0] = m_frames[1] = m_frames[2] = 0;
+	}
+
+	void Initialize(int depth)
+	{
+		m_middle.store(1);
+		m_writeSlot = 0;
+		m_readSlot = 2;
+		m_frames[0] = m_frames[1] = m_frames[2] = 0;
+		m_depth = depth > 0 ? depth : 0;
+		m_published.store(0);
+		m_completed.store(0);
+		return;
+	}
+
+	//producer side: the slot to build the next snapshot in, it stays private to the producer until Publish
+	T& GetWriteSlot()
+	{
+		return m_slots[m_writeSlot];
+	}
+
+	//producer side: make the snapshot in the write slot the newest one. Frame numbers have to start at 1 and go up.
+	void Publish(unsigned long long frame)
+	{
+		m_frames[m_writeSlot] = frame;
+		m_writeSlot = m_middle.exchange(m_writeSlot | FRESH_FLAG, std::memory_order_acq_rel) & SLOT_MASK;
+		m_published.store(frame, std::memory_order_release);
+		Notify();
+		return;
+	}
+
+	//producer side: wait until the consumer is less than depth frames behind, returns false if stop was raised while waiting
+	bool WaitForConsumer(const std::atomic<bool>& stop)
+	{
+		if (m_depth == 0)
+		{
+			return true;
+		}
+
+		std::unique_lock<std::mutex> lock(m_waitMutex);
+
+		while (m_published.load(std::memory_order_acquire) - m_completed.load(std::memory_order_acquire) >= (unsigned long long)m_depth)
+		{
+			if (stop.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			m_waitCondition.wait(lock);
+		}
+
+		return true;
+	}
+
+	//consumer side: take the newest snapshot if one was published since the last call, otherwise returns nullptr
+	const T* Acquire()
+	{
+		if (!(m_middle.load(std::memory_order_acquire) & FRESH_FLAG))
+		{
+			return nullptr;
+		}
+
+		m_readSlot = m_middle.exchange(m_readSlot, std::memory_order_acq_rel) & SLOT_MASK;
+
+		return &m_slots[m_readSlot];
+	}
+
+	//consumer side: Acquire, but sleeps until a snapshot is published first, returns nullptr if stop was raised while waiting
+	const T* WaitForSnapshot(const std::atomic<bool>& stop)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_waitMutex);
+
+			while (!(m_middle.load(std::memory_order_acquire) & FRESH_FLAG))
+			{
+				if (stop.load(std::memory_order_acquire))
+				{
+					return nullptr;
+				}
+				m_waitCondition.wait(lock);
+			}
+		}
+
+		return Acquire();
+	}
+
+	//consumer side: the frame number of the snapshot returned by the last Acquire
+	unsigned long long GetAcquiredFrame()
+	{
+		return m_frames[m_readSlot];
+	}
+
+	//consumer side: done with the acquired snapshot, this is what lets a waiting producer go on
+	void Complete()
+	{
+		m_completed.store(m_frames[m_readSlot], std::memory_order_release);
+		Notify();
+		return;
+	}
+
+	//either side: wakes whoever waits, to be called after raising a stop flag one of the waits was given. The lock is taken so a side
+	//that just found nothing to do cannot miss the wake up on its way to sleep.
+	void Notify()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_waitMutex);
+		}
+		m_waitCondition.notify_all();
+		return;
+	}
+
+	unsigned long long GetPublishedFrame()
+	{
+		return m_published.load(std::memory_order_acquire);
+	}
+
+	unsigned long long GetCompletedFrame()
+	{
+		return m_completed.load(std::memory_order_acquire);
+	}
+
+	int GetDepth()
+	{
+		return m_depth;
+	}
+
+private:
+	T m_slots[3];
+	unsigned long long m_frames[3];
+	std::atomic<unsigned int> m_middle;
+	unsigned int m_writeSlot;
+	unsigned int m_readSlot;
+	int m_depth;
+
+	//the last frame published by the producer and the last frame the consumer finished with
+	std::atomic<unsigned long long> m_published;
+	std::atomic<unsigned long long> m_completed;
+
+	//only for sleeping, the exchange itself does not lock
+	std::mutex m_waitMutex;
+	std::condition_variable m_waitCondition;
+};
+
+#endif
@@ -0,0 +1,1058 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: softwarerasterizerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "softwarerasterizerclass.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+//tiles are 64x64 pixels, small enough to stay in cache and big enough to keep the binning cheap
+static const int TILE_SIZE = 64;
+
+//screen positions are snapped to 1/16th of a pixel. With 4 sub pixel bits a 2048 pixel target keeps every edge function value
+//inside a 32 bit integer which is what lets us evaluate four pixels at once in an SSE register
+static const int SUBPIXEL_BITS = 4;
+static const int SUBPIXEL_SCALE = 1 << SUBPIXEL_BITS;
+static const int MAX_TARGET_SIZE = 2048;
+
+//D24 depth, the largest value the 24 bit depth buffer can hold is what the buffer gets cleared to
+static const unsigned int DEPTH_MAX = 0xFFFFFF;
+
+SoftwareRasterizerClass::SoftwareRasterizerClass()
+	: m_screenWidth(0)
+	, m_screenHeight(0)
+	, m_tilesX(0)
+	, m_tilesY(0)
+	, m_cullMode(CULL_BACK)
+	, m_frontCounterClockwise(false)
+	, m_frameTime(0.0f)
+	, m_colorBuffer(nullptr)
+	, m_depthBuffer(nullptr)
+	, m_triangleCount(0)
+	, m_nextTile(0)
+	, m_jobs(nullptr)
+{
+	m_clearColor[0] = m_clearColor[1] = m_clearColor[2] = 0.0f;
+	m_clearColor[3] = 1.0f;
+}
+
+SoftwareRasterizerClass::SoftwareRasterizerClass(const SoftwareRasterizerClass& other)
+{
+}
+
+
+SoftwareRasterizerClass::~SoftwareRasterizerClass()
+{
+}
+
+//Initialize allocates the colour and depth buffers and the triangle lists and tile bins of one job per thread of the job system.
+
+bool SoftwareRasterizerClass::Initialize(int screenWidth, int screenHeight, JobSystemClass* jobs)
+{
+	int jobCount;
+
+	if (screenWidth <= 0 || screenHeight <= 0 || screenWidth > MAX_TARGET_SIZE || screenHeight > MAX_TARGET_SIZE)
+	{
+		return false;
+	}
+
+	m_screenWidth = screenWidth;
+	m_screenHeight = screenHeight;
+	m_tilesX = (screenWidth + TILE_SIZE - 1) / TILE_SIZE;
+	m_tilesY = (screenHeight + TILE_SIZE - 1) / TILE_SIZE;
+
+	// Create the R8G8B8A8 back buffer and the 24 bit depth buffer.
+	m_colorBuffer.reset(new unsigned char[screenWidth * screenHeight * 4]);
+	m_depthBuffer.reset(new unsigned int[screenWidth * screenHeight]);
+	if (!m_colorBuffer || !m_depthBuffer)
+	{
+		return false;
+	}
+
+	m_jobs = jobs;
+	jobCount = m_jobs ? m_jobs->GetThreadCount() : 1;
+
+	// Every job gets its own triangle list and its own set of tile bins.
+	m_triangles.resize(jobCount);
+	m_bins.resize(jobCount);
+	for (auto i = 0; i < jobCount; i++)
+	{
+		m_bins[i].resize(m_tilesX * m_tilesY);
+	}
+
+	return true;
+}
+
+void SoftwareRasterizerClass::Shutdown()
+{
+	m_jobs = nullptr;
+
+	m_textures.clear();
+	m_draws.clear();
+	m_triangles.clear();
+	m_bins.clear();
+
+	return;
+}
+
+//SetRasterizerState mirrors the CullMode and FrontCounterClockwise members of D3D11_RASTERIZER_DESC. D3DClass uses
+//CULL_BACK with clockwise front faces so that is also the default here.
+
+void SoftwareRasterizerClass::SetRasterizerState(CullMode cullMode, bool frontCounterClockwise)
+{
+	m_cullMode = cullMode;
+	m_frontCounterClockwise = frontCounterClockwise;
+	return;
+}
+
+/*
+CreateTexture is the software version of what TextureClass::Initialize does with CreateTexture2D and GenerateMips. The top level is copied
+from the R8G8B8A8 data and every following level is a 2x2 box filter of the one above it, all the way down to 1x1.
+The returned index is what gets passed into Draw.
+*/
+
+int SoftwareRasterizerClass::CreateTexture(const unsigned char* data, int width, int height)
+{
+	TextureType texture;
+	MipLevelType level;
+
+	if (!data || width <= 0 || height <= 0)
+	{
+		return -1;
+	}
+
+	// Copy the top level.
+	level.width = width;
+	level.height = height;
+	level.data.assign(data, data + width * height * 4);
+	texture.mips.push_back(level);
+
+	// Generate the rest of the mip chain.
+	while (level.width > 1 || level.height > 1)
+	{
+		const MipLevelType& parent = texture.mips.back();
+		MipLevelType child;
+
+		child.width = std::max(1, parent.width / 2);
+		child.height = std::max(1, parent.height / 2);
+		child.data.resize(child.width * child.height * 4);
+
+		for (auto y = 0; y < child.height; y++)
+		{
+			int y0 = std::min(y * 2, parent.height - 1);
+			int y1 = std::min(y * 2 + 1, parent.height - 1);
+
+			for (auto x = 0; x < child.width; x++)
+			{
+				int x0 = std::min(x * 2, parent.width - 1);
+				int x1 = std::min(x * 2 + 1, parent.width - 1);
+
+				for (auto c = 0; c < 4; c++)
+				{
+					int sum = parent.data[(y0 * parent.width + x0) * 4 + c] + parent.data[(y0 * parent.width + x1) * 4 + c] +
+						parent.data[(y1 * parent.width + x0) * 4 + c] + parent.data[(y1 * parent.width + x1) * 4 + c];
+					child.data[(y * child.width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+
+		level = child;
+		texture.mips.push_back(child);
+	}
+
+	m_textures.push_back(texture);
+
+	return (int)m_textures.size() - 1;
+}
+
+void SoftwareRasterizerClass::BeginScene(float red, float green, float blue, float alpha)
+{
+	// The buffers themselves are cleared tile by tile in the raster pass, here we just remember the colour.
+	m_clearColor[0] = red;
+	m_clearColor[1] = green;
+	m_clearColor[2] = blue;
+	m_clearColor[3] = alpha;
+
+	m_draws.clear();
+	m_triangleCount = 0;
+
+	return;
+}
+
+//Draw records a non indexed draw of vertexCount / 3 triangles. The vertex data is not copied, it must stay alive until EndScene.
+
+void SoftwareRasterizerClass::Draw(const void* vertices, int stride, int vertexCount, int texture, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
+	XMMATRIX projectionMatrix, XMFLOAT3 lightDirection, XMFLOAT4 diffuseColor)
+{
+	DrawIndexed(vertices, stride, nullptr, vertexCount, texture, worldMatrix, viewMatrix, projectionMatrix, lightDirection, diffuseColor);
+	return;
+}
+
+void SoftwareRasterizerClass::DrawIndexed(const void* vertices, int stride, const unsigned int* indices, int indexCount, int texture,
+	XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX projectionMatrix, XMFLOAT3 lightDirection, XMFLOAT4 diffuseColor)
+{
+	DrawType draw;
+
+	if (!vertices || indexCount < 3)
+	{
+		return;
+	}
+
+	draw.vertices = (const unsigned char*)vertices;
+	draw.stride = stride;
+	draw.indices = indices;
+	draw.triangleCount = indexCount / 3;
+	draw.triangleStart = m_triangleCount;
+	draw.texture = texture;
+	draw.lightDirection = lightDirection;
+	draw.diffuseColor = diffuseColor;
+
+	// The vertex shader multiplies by world, view and projection in turn, we can do that once per draw instead.
+	XMStoreFloat4x4(&draw.world, worldMatrix);
+	XMStoreFloat4x4(&draw.worldViewProjection, XMMatrixMultiply(XMMatrixMultiply(worldMatrix, viewMatrix), projectionMatrix));
+
+	m_draws.push_back(draw);
+	m_triangleCount += draw.triangleCount;
+
+	return;
+}
+
+/*
+EndScene runs the two parallel passes over everything that was drawn this frame. The geometry pass splits the triangles of all the draws
+into one contiguous range per job, the raster pass then hands out whole tiles to whichever job asks for the next one.
+*/
+
+void SoftwareRasterizerClass::EndScene()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Empty the bins from the last frame, the vectors keep their memory.
+	for (size_t i = 0; i < m_triangles.size(); i++)
+	{
+		m_triangles[i].clear();
+		for (auto& bin : m_bins[i])
+		{
+			bin.clear();
+		}
+	}
+
+	RunParallel(&SoftwareRasterizerClass::ProcessGeometry);
+
+	m_nextTile = 0;
+	RunParallel(&SoftwareRasterizerClass::RasterizeTiles);
+
+	auto end = std::chrono::high_resolution_clock::now();
+	m_frameTime = std::chrono::duration<float, std::milli>(end - start).count();
+
+	return;
+}
+
+//SaveTarga writes the back buffer as an uncompressed 32 bit targa, the same kind of file TextureClass::LoadTarga reads.
+
+bool SoftwareRasterizerClass::SaveTarga(const char* filename)
+{
+	std::ofstream fout;
+	unsigned char header[18];
+	std::vector<unsigned char> row(m_screenWidth * 4);
+
+	fout.open(filename, std::ios::binary);
+	if (fout.fail())
+	{
+		return false;
+	}
+
+	// Uncompressed true colour image with an 8 bit alpha channel, stored bottom row first.
+	memset(header, 0, sizeof(header));
+	header[2] = 2;
+	header[12] = (unsigned char)(m_screenWidth & 0xFF);
+	header[13] = (unsigned char)(m_screenWidth >> 8);
+	header[14] = (unsigned char)(m_screenHeight & 0xFF);
+	header[15] = (unsigned char)(m_screenHeight >> 8);
+	header[16] = 32;
+	header[17] = 8;
+	fout.write((const char*)header, sizeof(header));
+
+	// Targa is upside down and BGRA.
+	for (auto y = m_screenHeight - 1; y >= 0; y--)
+	{
+		const unsigned char* src = m_colorBuffer.get() + y * m_screenWidth * 4;
+		for (auto x = 0; x < m_screenWidth; x++)
+		{
+			row[x * 4 + 0] = src[x * 4 + 2];
+			row[x * 4 + 1] = src[x * 4 + 1];
+			row[x * 4 + 2] = src[x * 4 + 0];
+			row[x * 4 + 3] = src[x * 4 + 3];
+		}
+		fout.write((const char*)row.data(), row.size());
+	}
+
+	fout.close();
+
+	return !fout.fail();
+}
+
+/*
+SavePng writes the back buffer as an RGBA png. We don't have zlib available so the image data goes into uncompressed (stored) deflate blocks,
+which every png reader understands. The files are bigger than they need to be but they are exact and we don't need another library.
+*/
+
+static unsigned int PngCrc(const unsigned char* data, size_t length, unsigned int crc)
+{
+	static unsigned int table[256];
+	static bool tableBuilt = false;
+
+	if (!tableBuilt)
+	{
+		for (unsigned int n = 0; n < 256; n++)
+		{
+			unsigned int c = n;
+			for (auto k = 0; k < 8; k++)
+			{
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			table[n] = c;
+		}
+		tableBuilt = true;
+	}
+
+	for (size_t i = 0; i < length; i++)
+	{
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+
+	return crc;
+}
+
+static void PngWriteChunk(std::ofstream& fout, const char* type, const std::vector<unsigned char>& data)
+{
+	unsigned char length[4];
+	unsigned char crcBytes[4];
+	unsigned int crc;
+
+	length[0] = (unsigned char)(data.size() >> 24);
+	length[1] = (unsigned char)(data.size() >> 16);
+	length[2] = (unsigned char)(data.size() >> 8);
+	length[3] = (unsigned char)(data.size());
+
+	crc = PngCrc((const unsigned char*)type, 4, 0xFFFFFFFFu);
+	crc = PngCrc(data.data(), data.size(), crc) ^ 0xFFFFFFFFu;
+
+	crcBytes[0] = (unsigned char)(crc >> 24);
+	crcBytes[1] = (unsigned char)(crc >> 16);
+	crcBytes[2] = (unsigned char)(crc >> 8);
+	crcBytes[3] = (unsigned char)(crc);
+
+	fout.write((const char*)length, 4);
+	fout.write(type, 4);
+	fout.write((const char*)data.data(), data.size());
+	fout.write((const char*)crcBytes, 4);
+
+	return;
+}
+
+bool SoftwareRasterizerClass::SavePng(const char* filename)
+{
+	static const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	std::ofstream fout;
+	std::vector<unsigned char> header, raw, idat;
+	unsigned int adlerA, adlerB;
+	size_t offset;
+
+	fout.open(filename, std::ios::binary);
+	if (fout.fail())
+	{
+		return false;
+	}
+
+	fout.write((const char*)signature, sizeof(signature));
+
+	// IHDR: width, height, 8 bits per channel, colour type 6 (RGBA), deflate, no filter, no interlace.
+	header.resize(13, 0);
+	header[0] = (unsigned char)(m_screenWidth >> 24);
+	header[1] = (unsigned char)(m_screenWidth >> 16);
+	header[2] = (unsigned char)(m_screenWidth >> 8);
+	header[3] = (unsigned char)(m_screenWidth);
+	header[4] = (unsigned char)(m_screenHeight >> 24);
+	header[5] = (unsigned char)(m_screenHeight >> 16);
+	header[6] = (unsigned char)(m_screenHeight >> 8);
+	header[7] = (unsigned char)(m_screenHeight);
+	header[8] = 8;
+	header[9] = 6;
+	PngWriteChunk(fout, "IHDR", header);
+
+	// Every scanline starts with its filter type, we always use 0 (none).
+	raw.reserve((m_screenWidth * 4 + 1) * m_screenHeight);
+	for (auto y = 0; y < m_screenHeight; y++)
+	{
+		const unsigned char* src = m_colorBuffer.get() + y * m_screenWidth * 4;
+		raw.push_back(0);
+		raw.insert(raw.end(), src, src + m_screenWidth * 4);
+	}
+
+	// Wrap the scanlines in a zlib stream made of stored blocks of at most 65535 bytes.
+	idat.push_back(0x78);
+	idat.push_back(0x01);
+	offset = 0;
+	do
+	{
+		size_t blockSize = std::min(raw.size() - offset, (size_t)65535);
+		bool last = (offset + blockSize == raw.size());
+
+		idat.push_back(last ? 1 : 0);
+		idat.push_back((unsigned char)(blockSize & 0xFF));
+		idat.push_back((unsigned char)(blockSize >> 8));
+		idat.push_back((unsigned char)(~blockSize & 0xFF));
+		idat.push_back((unsigned char)((~blockSize >> 8) & 0xFF));
+		idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+
+		offset += blockSize;
+	} while (offset < raw.size());
+
+	// The zlib stream ends with the adler32 checksum of the uncompressed data.
+	adlerA = 1;
+	adlerB = 0;
+	for (size_t i = 0; i < raw.size(); i++)
+	{
+		adlerA = (adlerA + raw[i]) % 65521;
+		adlerB = (adlerB + adlerA) % 65521;
+	}
+	idat.push_back((unsigned char)(adlerB >> 8));
+	idat.push_back((unsigned char)(adlerB));
+	idat.push_back((unsigned char)(adlerA >> 8));
+	idat.push_back((unsigned char)(adlerA));
+
+	PngWriteChunk(fout, "IDAT", idat);
+	PngWriteChunk(fout, "IEND", std::vector<unsigned char>());
+
+	fout.close();
+
+	return !fout.fail();
+}
+
+const unsigned char* SoftwareRasterizerClass::GetColorBuffer()
+{
+	return m_colorBuffer.get();
+}
+
+const unsigned int* SoftwareRasterizerClass::GetDepthBuffer()
+{
+	return m_depthBuffer.get();
+}
+
+//GetFrameTime returns how long the last EndScene took in milliseconds.
+
+float SoftwareRasterizerClass::GetFrameTime()
+{
+	return m_frameTime;
+}
+
+int SoftwareRasterizerClass::GetThreadCount()
+{
+	return (int)m_triangles.size();
+}
+
+//RunParallel runs the task once for every job index as jobs and returns once all of them are done with it.
+
+void SoftwareRasterizerClass::RunParallel(void (SoftwareRasterizerClass::*task)(int))
+{
+	auto runTask = [this, task](int begin, int end)
+	{
+		for (auto i = begin; i < end; i++)
+		{
+			(this->*task)(i);
+		}
+	};
+
+	if (m_jobs)
+	{
+		m_jobs->ParallelFor((int)m_triangles.size(), 1, runTask);
+	}
+	else
+	{
+		runTask(0, (int)m_triangles.size());
+	}
+
+	return;
+}
+
+/*
+ProcessGeometry is the front end of the pipeline. Each job takes its own contiguous range of the frame's triangles, runs the three vertices
+through the vertex shader, clips the result against the view frustum and hands the surviving pieces to SetupTriangle for culling and binning.
+*/
+
+void SoftwareRasterizerClass::ProcessGeometry(int threadIndex)
+{
+	int threadCount, first, last, draw;
+	ClipVertexType vertices[3];
+
+	threadCount = (int)m_triangles.size();
+	first = (int)((long long)m_triangleCount * threadIndex / threadCount);
+	last = (int)((long long)m_triangleCount * (threadIndex + 1) / threadCount);
+
+	// Find the draw that our first triangle belongs to.
+	draw = 0;
+	while (draw < (int)m_draws.size() && m_draws[draw].triangleStart + m_draws[draw].triangleCount <= first)
+	{
+		draw++;
+	}
+
+	for (auto i = first; i < last; i++)
+	{
+		while (m_draws[draw].triangleStart + m_draws[draw].triangleCount <= i)
+		{
+			draw++;
+		}
+
+		const DrawType& drawData = m_draws[draw];
+		int triangle = i - drawData.triangleStart;
+
+		for (auto k = 0; k < 3; k++)
+		{
+			int index = drawData.indices ? (int)drawData.indices[triangle * 3 + k] : triangle * 3 + k;
+			ShadeVertex(drawData, index, vertices[k]);
+		}
+
+		ClipTriangle(drawData, vertices, threadIndex);
+	}
+
+	return;
+}
+
+//ShadeVertex does what LightVertexShader does: position into clip space and the normal into world space.
+
+void SoftwareRasterizerClass::ShadeVertex(const DrawType& draw, int index, ClipVertexType& output)
+{
+	const VertexType* input = (const VertexType*)(draw.vertices + index * draw.stride);
+	XMVECTOR position, normal;
+
+	position = XMVectorSet(input->position.x, input->position.y, input->position.z, 1.0f);
+	position = XMVector4Transform(position, XMLoadFloat4x4(&draw.worldViewProjection));
+	XMStoreFloat4(&output.position, position);
+
+	output.texture = input->texture;
+
+	normal = XMVector3TransformNormal(XMLoadFloat3(&input->normal), XMLoadFloat4x4(&draw.world));
+	normal = XMVector3Normalize(normal);
+	XMStoreFloat3(&output.normal, normal);
+
+	return;
+}
+
+/*
+ClipTriangle clips against the six planes of the D3D clip volume (-w <= x <= w, -w <= y <= w, 0 <= z <= w). Triangles that are completely
+inside go straight through, the rest are clipped with Sutherland-Hodgman and the resulting polygon is fanned back into triangles.
+Clipping the x and y planes as well as the depth planes keeps every snapped screen position inside the render target.
+*/
+
+static float ClipDistance(const XMFLOAT4& position, int plane)
+{
+	switch (plane)
+	{
+	case 0: return position.w + position.x;
+	case 1: return position.w - position.x;
+	case 2: return position.w + position.y;
+	case 3: return position.w - position.y;
+	case 4: return position.z;
+	default: return position.w - position.z;
+	}
+}
+
+void SoftwareRasterizerClass::ClipTriangle(const DrawType& draw, const ClipVertexType* vertices, int threadIndex)
+{
+	ClipVertexType polygonA[9], polygonB[9];
+	ClipVertexType* input;
+	ClipVertexType* output;
+	int inputCount, outputCount;
+	int outsideAll, outsideAny;
+
+	// Work out which planes each vertex is outside of.
+	outsideAll = 0x3F;
+	outsideAny = 0;
+	for (auto i = 0; i < 3; i++)
+	{
+		int outcode = 0;
+		for (auto plane = 0; plane < 6; plane++)
+		{
+			if (ClipDistance(vertices[i].position, plane) < 0.0f)
+			{
+				outcode |= 1 << plane;
+			}
+		}
+		outsideAll &= outcode;
+		outsideAny |= outcode;
+	}
+
+	// Completely outside one plane, nothing to draw.
+	if (outsideAll)
+	{
+		return;
+	}
+
+	// Completely inside, no clipping needed.
+	if (!outsideAny)
+	{
+		SetupTriangle(draw, vertices[0], vertices[1], vertices[2], threadIndex);
+		return;
+	}
+
+	input = polygonA;
+	output = polygonB;
+	inputCount = 3;
+	input[0] = vertices[0];
+	input[1] = vertices[1];
+	input[2] = vertices[2];
+
+	for (auto plane = 0; plane < 6; plane++)
+	{
+		if (!(outsideAny & (1 << plane)))
+		{
+			continue;
+		}
+
+		outputCount = 0;
+		for (auto i = 0; i < inputCount; i++)
+		{
+			const ClipVertexType& a = input[i];
+			const ClipVertexType& b = input[(i + 1) % inputCount];
+			float da = ClipDistance(a.position, plane);
+			float db = ClipDistance(b.position, plane);
+
+			if (da >= 0.0f)
+			{
+				output[outputCount++] = a;
+			}
+
+			// The edge crosses the plane, add the intersection point.
+			if ((da >= 0.0f) != (db >= 0.0f))
+			{
+				float t = da / (da - db);
+				ClipVertexType& v = output[outputCount++];
+
+				XMStoreFloat4(&v.position, XMVectorLerp(XMLoadFloat4(&a.position), XMLoadFloat4(&b.position), t));
+				v.texture.x = a.texture.x + (b.texture.x - a.texture.x) * t;
+				v.texture.y = a.texture.y + (b.texture.y - a.texture.y) * t;
+				XMStoreFloat3(&v.normal, XMVectorLerp(XMLoadFloat3(&a.normal), XMLoadFloat3(&b.normal), t));
+			}
+		}
+
+		std::swap(input, output);
+		inputCount = outputCount;
+		if (inputCount < 3)
+		{
+			return;
+		}
+	}
+
+	for (auto i = 1; i < inputCount - 1; i++)
+	{
+		SetupTriangle(draw, input[0], input[i], input[i + 1], threadIndex);
+	}
+
+	return;
+}
+
+/*
+SetupTriangle does the viewport transform, snaps the vertices to the sub pixel grid, culls by winding and builds the edge functions and
+attribute planes the rasterizer evaluates per pixel. The render target has y pointing down, so a positive signed area is a clockwise triangle,
+which with FrontCounterClockwise = false is a front face just like in D3D. Back facing (or front facing, if we are culling those) triangles
+are thrown away here and the survivors are added to the bin of every tile their bounding box touches.
+*/
+
+void SoftwareRasterizerClass::SetupTriangle(const DrawType& draw, const ClipVertexType& v0, const ClipVertexType& v1, const ClipVertexType& v2,
+	int threadIndex)
+{
+	const ClipVertexType* vertex[3] = { &v0, &v1, &v2 };
+	int x[3], y[3];
+	float screenX[3], screenY[3], attributes[3][PLANE_COUNT];
+	long long area;
+	bool frontFacing;
+	TriangleType triangle;
+
+	for (auto i = 0; i < 3; i++)
+	{
+		float invW = 1.0f / vertex[i]->position.w;
+		float sx = (vertex[i]->position.x * invW * 0.5f + 0.5f) * (float)m_screenWidth;
+		float sy = (0.5f - vertex[i]->position.y * invW * 0.5f) * (float)m_screenHeight;
+
+		// Snap to the sub pixel grid.
+		x[i] = (int)floorf(sx * SUBPIXEL_SCALE + 0.5f);
+		y[i] = (int)floorf(sy * SUBPIXEL_SCALE + 0.5f);
+		screenX[i] = (float)x[i] / SUBPIXEL_SCALE;
+		screenY[i] = (float)y[i] / SUBPIXEL_SCALE;
+
+		// Depth is linear in screen space, the rest is interpolated divided by w for perspective correction.
+		attributes[i][PLANE_DEPTH] = vertex[i]->position.z * invW;
+		attributes[i][PLANE_INVW] = invW;
+		attributes[i][PLANE_U] = vertex[i]->texture.x * invW;
+		attributes[i][PLANE_V] = vertex[i]->texture.y * invW;
+		attributes[i][PLANE_NX] = vertex[i]->normal.x * invW;
+		attributes[i][PLANE_NY] = vertex[i]->normal.y * invW;
+		attributes[i][PLANE_NZ] = vertex[i]->normal.z * invW;
+	}
+
+	area = (long long)(x[1] - x[0]) * (y[2] - y[0]) - (long long)(y[1] - y[0]) * (x[2] - x[0]);
+	if (area == 0)
+	{
+		return;
+	}
+
+	// Cull using the same rules as the rasterizer state.
+	frontFacing = m_frontCounterClockwise ? (area < 0) : (area > 0);
+	if ((m_cullMode == CULL_BACK && !frontFacing) || (m_cullMode == CULL_FRONT && frontFacing))
+	{
+		return;
+	}
+
+	// The edge functions below expect a clockwise triangle, so flip counter clockwise ones.
+	if (area < 0)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(screenX[1], screenX[2]);
+		std::swap(screenY[1], screenY[2]);
+		for (auto k = 0; k < PLANE_COUNT; k++)
+		{
+			std::swap(attributes[1][k], attributes[2][k]);
+		}
+	}
+
+	// Edge i runs from vertex i to vertex i + 1, E(p) = A * px + B * py + C is positive on the inside.
+	for (auto i = 0; i < 3; i++)
+	{
+		int j = (i + 1) % 3;
+		int dx = x[j] - x[i];
+		int dy = y[j] - y[i];
+
+		triangle.edgeA[i] = -dy;
+		triangle.edgeB[i] = dx;
+		triangle.edgeC[i] = (long long)dy * x[i] - (long long)dx * y[i];
+
+		// Top-left fill rule: pixels exactly on a top or left edge belong to this triangle, on any other edge they don't.
+		bool topLeft = (dy < 0) || (dy == 0 && dx > 0);
+		triangle.bias[i] = topLeft ? 0 : -1;
+	}
+
+	// Bounding box of the pixel centers covered by the triangle.
+	int minX = std::min(x[0], std::min(x[1], x[2]));
+	int maxX = std::max(x[0], std::max(x[1], x[2]));
+	int minY = std::min(y[0], std::min(y[1], y[2]));
+	int maxY = std::max(y[0], std::max(y[1], y[2]));
+
+	triangle.minX = std::max(0, (minX - SUBPIXEL_SCALE / 2 + SUBPIXEL_SCALE - 1) >> SUBPIXEL_BITS);
+	triangle.minY = std::max(0, (minY - SUBPIXEL_SCALE / 2 + SUBPIXEL_SCALE - 1) >> SUBPIXEL_BITS);
+	triangle.maxX = std::min(m_screenWidth - 1, (maxX - SUBPIXEL_SCALE / 2) >> SUBPIXEL_BITS);
+	triangle.maxY = std::min(m_screenHeight - 1, (maxY - SUBPIXEL_SCALE / 2) >> SUBPIXEL_BITS);
+
+	// Too small to cover any pixel center.
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+	{
+		return;
+	}
+
+	// Fit a plane f = a * x + b * y + c through each attribute.
+	float x1 = screenX[1] - screenX[0];
+	float y1 = screenY[1] - screenY[0];
+	float x2 = screenX[2] - screenX[0];
+	float y2 = screenY[2] - screenY[0];
+	float invDet = 1.0f / (x1 * y2 - x2 * y1);
+
+	for (auto k = 0; k < PLANE_COUNT; k++)
+	{
+		float f1 = attributes[1][k] - attributes[0][k];
+		float f2 = attributes[2][k] - attributes[0][k];
+		float a = (f1 * y2 - f2 * y1) * invDet;
+		float b = (f2 * x1 - f1 * x2) * invDet;
+
+		triangle.planes[k][0] = a;
+		triangle.planes[k][1] = b;
+		triangle.planes[k][2] = attributes[0][k] - a * screenX[0] - b * screenY[0];
+	}
+
+	triangle.draw = (int)(&draw - m_draws.data());
+
+	// Bin the triangle into every tile its bounding box overlaps.
+	std::vector<TriangleType>& triangles = m_triangles[threadIndex];
+	int index = (int)triangles.size();
+	triangles.push_back(triangle);
+
+	for (auto ty = triangle.minY / TILE_SIZE; ty <= triangle.maxY / TILE_SIZE; ty++)
+	{
+		for (auto tx = triangle.minX / TILE_SIZE; tx <= triangle.maxX / TILE_SIZE; tx++)
+		{
+			m_bins[threadIndex][ty * m_tilesX + tx].push_back(index);
+		}
+	}
+
+	return;
+}
+
+//RasterizeTiles is the back end. Jobs keep taking the next unfinished tile, clear it and draw every triangle binned into it.
+
+void SoftwareRasterizerClass::RasterizeTiles(int threadIndex)
+{
+	unsigned char clear[4];
+	int tileCount;
+
+	for (auto c = 0; c < 4; c++)
+	{
+		clear[c] = (unsigned char)(std::min(std::max(m_clearColor[c], 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+
+	tileCount = m_tilesX * m_tilesY;
+
+	while (true)
+	{
+		int tile = m_nextTile.fetch_add(1);
+		if (tile >= tileCount)
+		{
+			break;
+		}
+
+		int x0 = (tile % m_tilesX) * TILE_SIZE;
+		int y0 = (tile / m_tilesX) * TILE_SIZE;
+		int x1 = std::min(x0 + TILE_SIZE, m_screenWidth);
+		int y1 = std::min(y0 + TILE_SIZE, m_screenHeight);
+
+		// Clear the colour and depth of this tile.
+		for (auto y = y0; y < y1; y++)
+		{
+			unsigned char* color = m_colorBuffer.get() + (y * m_screenWidth + x0) * 4;
+			unsigned int* depth = m_depthBuffer.get() + y * m_screenWidth + x0;
+
+			for (auto x = x0; x < x1; x++)
+			{
+				memcpy(color, clear, 4);
+				color += 4;
+				*depth++ = DEPTH_MAX;
+			}
+		}
+
+		// Draw the binned triangles in submission order.
+		for (size_t t = 0; t < m_bins.size(); t++)
+		{
+			for (auto index : m_bins[t][tile])
+			{
+				RasterizeTriangle(m_triangles[t][index], x0, y0, x1, y1);
+			}
+		}
+	}
+
+	return;
+}
+
+/*
+RasterizeTriangle walks the part of the triangle's bounding box that lies in the tile four pixels at a time. The three edge functions
+for the four pixels live in one SSE register each, so the coverage test is two ORs and a movemask. Covered pixels get their depth from
+the depth plane and are tested against the depth buffer (D3D11_COMPARISON_LESS), and the ones that pass are shaded like LightPixelShader.
+*/
+
+void SoftwareRasterizerClass::RasterizeTriangle(const TriangleType& triangle, int tileX0, int tileY0, int tileX1, int tileY1)
+{
+	const DrawType& draw = m_draws[triangle.draw];
+	const TextureType* texture = (draw.texture >= 0 && draw.texture < (int)m_textures.size()) ? &m_textures[draw.texture] : nullptr;
+	int startX, endX, startY, endY;
+	__m128i laneStep[3], blockStep[3];
+	__m128 laneOffset, depthA, depthB, depthC, depthScale, zero, one;
+	float lightX, lightY, lightZ;
+
+	startX = std::max(triangle.minX, tileX0) & ~3;
+	endX = std::min(triangle.maxX, tileX1 - 1);
+	startY = std::max(triangle.minY, tileY0);
+	endY = std::min(triangle.maxY, tileY1 - 1);
+
+	for (auto i = 0; i < 3; i++)
+	{
+		int a = triangle.edgeA[i] * SUBPIXEL_SCALE;
+		laneStep[i] = _mm_setr_epi32(0, a, a * 2, a * 3);
+		blockStep[i] = _mm_set1_epi32(a * 4);
+	}
+
+	laneOffset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	depthA = _mm_set1_ps(triangle.planes[PLANE_DEPTH][0]);
+	depthB = _mm_set1_ps(triangle.planes[PLANE_DEPTH][1]);
+	depthC = _mm_set1_ps(triangle.planes[PLANE_DEPTH][2]);
+	depthScale = _mm_set1_ps((float)DEPTH_MAX);
+	zero = _mm_setzero_ps();
+	one = _mm_set1_ps(1.0f);
+
+	// The shader inverts the light direction.
+	lightX = -draw.lightDirection.x;
+	lightY = -draw.lightDirection.y;
+	lightZ = -draw.lightDirection.z;
+
+	for (auto y = startY; y <= endY; y++)
+	{
+		long long py = (long long)y * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2;
+		long long px = (long long)startX * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2;
+		__m128i edge[3];
+
+		// Evaluate the edge functions at the first block of the row, the rest is just adding the step.
+		for (auto i = 0; i < 3; i++)
+		{
+			long long value = triangle.edgeA[i] * px + triangle.edgeB[i] * py + triangle.edgeC[i] + triangle.bias[i];
+			edge[i] = _mm_add_epi32(_mm_set1_epi32((int)value), laneStep[i]);
+		}
+
+		float fy = (float)y + 0.5f;
+		__m128 rowDepth = _mm_add_ps(_mm_mul_ps(depthB, _mm_set1_ps(fy)), depthC);
+
+		for (auto x = startX; x <= endX; x += 4)
+		{
+			// A pixel is inside when none of the three edge functions is negative.
+			__m128i inside = _mm_or_si128(_mm_or_si128(edge[0], edge[1]), edge[2]);
+			int mask = ~_mm_movemask_ps(_mm_castsi128_ps(inside)) & 0xF;
+
+			// Mask off the lanes that run past the right edge of the render target.
+			if (x + 4 > m_screenWidth)
+			{
+				mask &= (1 << (m_screenWidth - x)) - 1;
+			}
+
+			if (mask)
+			{
+				__m128 fx = _mm_add_ps(_mm_set1_ps((float)x), laneOffset);
+				__m128 z = _mm_add_ps(_mm_mul_ps(depthA, fx), rowDepth);
+				z = _mm_min_ps(_mm_max_ps(z, zero), one);
+
+				alignas(16) int depth[4];
+				_mm_store_si128((__m128i*)depth, _mm_cvtps_epi32(_mm_mul_ps(z, depthScale)));
+
+				for (auto lane = 0; lane < 4; lane++)
+				{
+					if (!(mask & (1 << lane)))
+					{
+						continue;
+					}
+
+					int pixel = y * m_screenWidth + x + lane;
+					if ((unsigned int)depth[lane] >= m_depthBuffer[pixel])
+					{
+						continue;
+					}
+					m_depthBuffer[pixel] = (unsigned int)depth[lane];
+
+					// Perspective correct attributes.
+					float sx = (float)(x + lane) + 0.5f;
+					const float (*p)[3] = triangle.planes;
+					float q = p[PLANE_INVW][0] * sx + p[PLANE_INVW][1] * fy + p[PLANE_INVW][2];
+					float w = 1.0f / q;
+					float u = (p[PLANE_U][0] * sx + p[PLANE_U][1] * fy + p[PLANE_U][2]) * w;
+					float v = (p[PLANE_V][0] * sx + p[PLANE_V][1] * fy + p[PLANE_V][2]) * w;
+					float nx = (p[PLANE_NX][0] * sx + p[PLANE_NX][1] * fy + p[PLANE_NX][2]) * w;
+					float ny = (p[PLANE_NY][0] * sx + p[PLANE_NY][1] * fy + p[PLANE_NY][2]) * w;
+					float nz = (p[PLANE_NZ][0] * sx + p[PLANE_NZ][1] * fy + p[PLANE_NZ][2]) * w;
+
+					// Sample the pixel color from the texture, white if the draw has no texture.
+					float textureColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+					if (texture)
+					{
+						// The screen space derivatives of u and v pick the mip level.
+						float dudx = (p[PLANE_U][0] - u * p[PLANE_INVW][0]) * w;
+						float dudy = (p[PLANE_U][1] - u * p[PLANE_INVW][1]) * w;
+						float dvdx = (p[PLANE_V][0] - v * p[PLANE_INVW][0]) * w;
+						float dvdy = (p[PLANE_V][1] - v * p[PLANE_INVW][1]) * w;
+						float width = (float)texture->mips[0].width;
+						float height = (float)texture->mips[0].height;
+						float rx = dudx * dudx * width * width + dvdx * dvdx * height * height;
+						float ry = dudy * dudy * width * width + dvdy * dvdy * height * height;
+						float lod = 0.5f * log2f(std::max(std::max(rx, ry), 1e-8f));
+
+						SampleTexture(*texture, u, v, lod, textureColor);
+					}
+
+					// Calculate the amount of light on this pixel, then the final diffuse color.
+					float lightIntensity = std::min(std::max(nx * lightX + ny * lightY + nz * lightZ, 0.0f), 1.0f);
+					unsigned char* color = m_colorBuffer.get() + pixel * 4;
+					const float* diffuse = &draw.diffuseColor.x;
+
+					for (auto c = 0; c < 4; c++)
+					{
+						float value = std::min(std::max(diffuse[c] * lightIntensity, 0.0f), 1.0f) * textureColor[c];
+						color[c] = (unsigned char)(value * 255.0f + 0.5f);
+					}
+				}
+			}
+
+			for (auto i = 0; i < 3; i++)
+			{
+				edge[i] = _mm_add_epi32(edge[i], blockStep[i]);
+			}
+		}
+	}
+
+	return;
+}
+
+/*
+SampleTexture is D3D11_FILTER_MIN_MAG_MIP_LINEAR with wrap addressing: a bilinear sample from the two mip levels either side of the
+level of detail, blended together. The four texels of a bilinear footprint are widened to floats and blended in SSE registers.
+*/
+
+static __m128 LoadTexel(const unsigned char* texel)
+{
+	int value;
+	memcpy(&value, texel, 4);
+
+	__m128i bytes = _mm_cvtsi32_si128(value);
+	bytes = _mm_unpacklo_epi8(bytes, _mm_setzero_si128());
+	bytes = _mm_unpacklo_epi16(bytes, _mm_setzero_si128());
+
+	return _mm_cvtepi32_ps(bytes);
+}
+
+static __m128 SampleBilinear(const std::vector<unsigned char>& data, int width, int height, float u, float v)
+{
+	float x = u * (float)width - 0.5f;
+	float y = v * (float)height - 0.5f;
+	float fx = floorf(x);
+	float fy = floorf(y);
+	int x0 = (int)fx;
+	int y0 = (int)fy;
+	__m128 wx = _mm_set1_ps(x - fx);
+	__m128 wy = _mm_set1_ps(y - fy);
+
+	// Wrap addressing.
+	x0 = ((x0 % width) + width) % width;
+	y0 = ((y0 % height) + height) % height;
+	int x1 = (x0 + 1) % width;
+	int y1 = (y0 + 1) % height;
+
+	__m128 t00 = LoadTexel(&data[(y0 * width + x0) * 4]);
+	__m128 t10 = LoadTexel(&data[(y0 * width + x1) * 4]);
+	__m128 t01 = LoadTexel(&data[(y1 * width + x0) * 4]);
+	__m128 t11 = LoadTexel(&data[(y1 * width + x1) * 4]);
+
+	__m128 top = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(t10, t00), wx));
+	__m128 bottom = _mm_add_ps(t01, _mm_mul_ps(_mm_sub_ps(t11, t01), wx));
+
+	return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), wy));
+}
+
+void SoftwareRasterizerClass::SampleTexture(const TextureType& texture, float u, float v, float lod, float* output)
+{
+	int levelCount = (int)texture.mips.size();
+	int level;
+	float blend;
+	__m128 color;
+
+	lod = std::min(std::max(lod, 0.0f), (float)(levelCount - 1));
+	level = (int)lod;
+	blend = lod - (float)level;
+
+	const MipLevelType& fine = texture.mips[level];
+	color = SampleBilinear(fine.data, fine.width, fine.height, u, v);
+
+	if (blend > 0.0f && level + 1 < levelCount)
+	{
+		const MipLevelType& coarse = texture.mips[level + 1];
+		__m128 coarseColor = SampleBilinear(coarse.data, coarse.width, coarse.height, u, v);
+		color = _mm_add_ps(color, _mm_mul_ps(_mm_sub_ps(coarseColor, color), _mm_set1_ps(blend)));
+	}
+
+	_mm_storeu_ps(output, _mm_mul_ps(color, _mm_set1_ps(1.0f / 255.0f)));
+
+	return;
+}
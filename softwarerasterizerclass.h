@@ -0,0 +1,174 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: softwarerasterizerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SOFTWARERASTERIZERCLASS_H_
+#define _SOFTWARERASTERIZERCLASS_H_
+
+//The SoftwareRasterizerClass is a CPU implementation of the pipeline that the LightShaderClass drives on the GPU. It lets us render
+//and time the same scene on machines that have no video card at all (build agents etc). Draw calls are only recorded, the actual
+//work happens in EndScene: the triangles are transformed, clipped, culled and binned into screen tiles by one job per JobSystemClass
+//thread, then each job grabs whole tiles and rasterizes them with SSE edge functions, a D24 depth test and the N.L diffuse light model.
+
+//////////////
+// INCLUDES //
+//////////////
+#include <DirectXMath.h>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include "jobsystemclass.h"
+
+using namespace DirectX;
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: SoftwareRasterizerClass
+////////////////////////////////////////////////////////////////////////////////
+class SoftwareRasterizerClass
+{
+public:
+	//same meaning as D3D11_CULL_MODE in the rasterizer state description
+	enum CullMode
+	{
+		CULL_NONE,
+		CULL_FRONT,
+		CULL_BACK
+	};
+
+private:
+	//the vertex layout matches the input layout in the LightShaderClass: POSITION (12 bytes), TEXCOORD (8 bytes), NORMAL (12 bytes)
+	struct VertexType
+	{
+		XMFLOAT3 position;
+		XMFLOAT2 texture;
+		XMFLOAT3 normal;
+	};
+
+	//a vertex after the "vertex shader" - clip space position plus the attributes the pixel shader needs
+	struct ClipVertexType
+	{
+		XMFLOAT4 position;
+		XMFLOAT2 texture;
+		XMFLOAT3 normal;
+	};
+
+	//one level of a texture's mip chain, stored as RGBA8 like DXGI_FORMAT_R8G8B8A8_UNORM
+	struct MipLevelType
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> data;
+	};
+
+	struct TextureType
+	{
+		std::vector<MipLevelType> mips;
+	};
+
+	//the per draw state, this is what SetShaderParameters would put in the constant buffers
+	struct DrawType
+	{
+		const unsigned char* vertices;
+		int stride;
+		const unsigned int* indices;
+		int triangleCount;
+		int triangleStart;
+		int texture;
+		XMFLOAT4X4 world;
+		XMFLOAT4X4 worldViewProjection;
+		XMFLOAT3 lightDirection;
+		XMFLOAT4 diffuseColor;
+	};
+
+	//attribute planes that are set up once per triangle and then evaluated per pixel
+	enum
+	{
+		PLANE_DEPTH,
+		PLANE_INVW,
+		PLANE_U,
+		PLANE_V,
+		PLANE_NX,
+		PLANE_NY,
+		PLANE_NZ,
+		PLANE_COUNT
+	};
+
+	//a triangle after clipping, culling and the viewport transform, ready to be rasterized
+	struct TriangleType
+	{
+		int edgeA[3];
+		int edgeB[3];
+		long long edgeC[3];
+		int bias[3];
+		int minX, minY, maxX, maxY;
+		float planes[PLANE_COUNT][3];
+		int draw;
+	};
+
+public:
+	SoftwareRasterizerClass();
+	SoftwareRasterizerClass(const SoftwareRasterizerClass&);
+	~SoftwareRasterizerClass();
+
+	//jobs may be nullptr to render on the calling thread alone
+	bool Initialize(int, int, JobSystemClass*);
+	void Shutdown();
+
+	void SetRasterizerState(CullMode, bool);
+	int CreateTexture(const unsigned char*, int, int);
+
+	void BeginScene(float, float, float, float);
+	void Draw(const void*, int, int, int, XMMATRIX, XMMATRIX, XMMATRIX, XMFLOAT3, XMFLOAT4);
+	void DrawIndexed(const void*, int, const unsigned int*, int, int, XMMATRIX, XMMATRIX, XMMATRIX, XMFLOAT3, XMFLOAT4);
+	void EndScene();
+
+	bool SaveTarga(const char*);
+	bool SavePng(const char*);
+
+	const unsigned char* GetColorBuffer();
+	//24 bit depths, 0xFFFFFF where nothing was drawn
+	const unsigned int* GetDepthBuffer();
+	float GetFrameTime();
+	int GetThreadCount();
+
+private:
+	void RunParallel(void (SoftwareRasterizerClass::*)(int));
+
+	void ProcessGeometry(int);
+	void RasterizeTiles(int);
+
+	void ShadeVertex(const DrawType&, int, ClipVertexType&);
+	void ClipTriangle(const DrawType&, const ClipVertexType*, int);
+	void SetupTriangle(const DrawType&, const ClipVertexType&, const ClipVertexType&, const ClipVertexType&, int);
+	void RasterizeTriangle(const TriangleType&, int, int, int, int);
+	void SampleTexture(const TextureType&, float, float, float, float*);
+
+private:
+	int m_screenWidth;
+	int m_screenHeight;
+	int m_tilesX;
+	int m_tilesY;
+	CullMode m_cullMode;
+	bool m_frontCounterClockwise;
+	float m_clearColor[4];
+	float m_frameTime;
+
+	std::unique_ptr<unsigned char[]> m_colorBuffer;
+	std::unique_ptr<unsigned int[]> m_depthBuffer;
+
+	std::vector<TextureType> m_textures;
+	std::vector<DrawType> m_draws;
+	int m_triangleCount;
+
+	//every job writes its own triangles and its own tile bins so binning needs no locks. The raster pass walks the bins of
+	//job 0, 1, 2.. in turn which keeps the triangles in submission order since each job set up a contiguous range of them
+	std::vector<std::vector<TriangleType>> m_triangles;
+	std::vector<std::vector<std::vector<int>>> m_bins;
+	std::atomic<int> m_nextTile;
+
+	//both passes run one job per job system thread
+	JobSystemClass* m_jobs;
+};
+
+#endif
@@ -0,0 +1,1070 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: spatialindexclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "spatialindexclass.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+//the box helpers work on the corners as float[3] so an axis can be picked by index
+static const float* Corner(const SpatialIndexClass::BoundsType& bounds, int corner)
+{
+	return corner ? &bounds.maximum.x : &bounds.minimum.x;
+}
+
+static void Grow(SpatialIndexClass::BoundsType& bounds, const SpatialIndexClass::BoundsType& other)
+{
+	bounds.minimum.x = std::min(bounds.minimum.x, other.minimum.x);
+	bounds.minimum.y = std::min(bounds.minimum.y, other.minimum.y);
+	bounds.minimum.z = std::min(bounds.minimum.z, other.minimum.z);
+	bounds.maximum.x = std::max(bounds.maximum.x, other.maximum.x);
+	bounds.maximum.y = std::max(bounds.maximum.y, other.maximum.y);
+	bounds.maximum.z = std::max(bounds.maximum.z, other.maximum.z);
+	return;
+}
+
+static void MakeEmpty(SpatialIndexClass::BoundsType& bounds)
+{
+	bounds.minimum = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	bounds.maximum = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	return;
+}
+
+//half the surface area of a box, which is all the SAH needs to compare boxes
+static float HalfArea(const SpatialIndexClass::BoundsType& bounds)
+{
+	float x = bounds.maximum.x - bounds.minimum.x;
+	float y = bounds.maximum.y - bounds.minimum.y;
+	float z = bounds.maximum.z - bounds.minimum.z;
+
+	if (x < 0.0f || y < 0.0f || z < 0.0f)
+	{
+		return 0.0f;
+	}
+
+	return x * y + y * z + z * x;
+}
+
+static bool Contains(const SpatialIndexClass::BoundsType& outer, const SpatialIndexClass::BoundsType& inner)
+{
+	return inner.minimum.x >= outer.minimum.x && inner.minimum.y >= outer.minimum.y && inner.minimum.z >= outer.minimum.z
+		&& inner.maximum.x <= outer.maximum.x && inner.maximum.y <= outer.maximum.y && inner.maximum.z <= outer.maximum.z;
+}
+
+//The tests QueryTrees runs against every node and object. Classify may answer INSIDE only if every box inside the given one passes Test.
+
+struct FrustumTestType
+{
+	const SpatialIndexClass::FrustumType& frustum;
+
+	SpatialIndexClass::ClassifyType Classify(const SpatialIndexClass::BoundsType& bounds) const
+	{
+		return SpatialIndexClass::ClassifyFrustum(frustum, bounds);
+	}
+
+	bool Test(const SpatialIndexClass::BoundsType& bounds) const
+	{
+		return SpatialIndexClass::TestFrustum(frustum, bounds);
+	}
+};
+
+struct SphereTestType
+{
+	XMFLOAT3 center;
+	float radius;
+
+	SpatialIndexClass::ClassifyType Classify(const SpatialIndexClass::BoundsType& bounds) const
+	{
+		const float* c = &center.x;
+		const float* minimum = &bounds.minimum.x;
+		const float* maximum = &bounds.maximum.x;
+		float nearest = 0.0f, farthest = 0.0f, d;
+
+		for (auto axis = 0; axis < 3; axis++)
+		{
+			d = c[axis] < minimum[axis] ? minimum[axis] - c[axis] : (c[axis] > maximum[axis] ? c[axis] - maximum[axis] : 0.0f);
+			nearest += d * d;
+			d = std::max(c[axis] - minimum[axis], maximum[axis] - c[axis]);
+			farthest += d * d;
+		}
+
+		if (nearest > radius * radius)
+		{
+			return SpatialIndexClass::OUTSIDE;
+		}
+
+		return farthest <= radius * radius ? SpatialIndexClass::INSIDE : SpatialIndexClass::INTERSECTING;
+	}
+
+	bool Test(const SpatialIndexClass::BoundsType& bounds) const
+	{
+		return SpatialIndexClass::TestSphere(center, radius, bounds);
+	}
+};
+
+struct BoundsTestType
+{
+	const SpatialIndexClass::BoundsType& query;
+
+	SpatialIndexClass::ClassifyType Classify(const SpatialIndexClass::BoundsType& bounds) const
+	{
+		if (!SpatialIndexClass::TestBounds(query, bounds))
+		{
+			return SpatialIndexClass::OUTSIDE;
+		}
+
+		return Contains(query, bounds) ? SpatialIndexClass::INSIDE : SpatialIndexClass::INTERSECTING;
+	}
+
+	bool Test(const SpatialIndexClass::BoundsType& bounds) const
+	{
+		return SpatialIndexClass::TestBounds(query, bounds);
+	}
+};
+
+SpatialIndexClass::SpatialIndexClass()
+	: m_objectCount(0)
+	, m_bvhRebuild(false)
+	, m_bvhRefit(false)
+	, m_octreeNodeCount(0)
+	, m_maxDepth(0)
+{
+}
+
+SpatialIndexClass::SpatialIndexClass(const SpatialIndexClass& other)
+{
+}
+
+
+SpatialIndexClass::~SpatialIndexClass()
+{
+}
+
+bool SpatialIndexClass::Initialize(XMFLOAT3 center, float halfSize, int maxDepth)
+{
+	if (halfSize <= 0.0f || maxDepth < 0)
+	{
+		return false;
+	}
+
+	m_maxDepth = maxDepth;
+
+	// The root always exists, it holds everything that does not fit further down.
+	AllocateOctreeNode(-1, 0, center, halfSize);
+
+	return true;
+}
+
+void SpatialIndexClass::Shutdown()
+{
+	m_bounds.clear();
+	m_state.clear();
+	m_objectNode.clear();
+	m_objectNext.clear();
+	m_objectPrevious.clear();
+	m_freeHandles.clear();
+	m_objectCount = 0;
+
+	m_bvhNodes.clear();
+	m_bvhObjects.clear();
+	m_bvhBounds.clear();
+	m_bvhRebuild = false;
+	m_bvhRefit = false;
+
+	m_octreeNodes.clear();
+	m_freeOctreeNodes.clear();
+	m_octreeNodeCount = 0;
+	m_stack.clear();
+
+	return;
+}
+
+//Insert returns the new object's handle. Dynamic objects can be queried straight away, static ones after the next Update.
+
+int SpatialIndexClass::Insert(const BoundsType& bounds, bool isStatic)
+{
+	int handle;
+
+	if (!m_freeHandles.empty())
+	{
+		handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+	}
+	else
+	{
+		handle = (int)m_bounds.size();
+		m_bounds.push_back(bounds);
+		m_state.push_back(STATE_FREE);
+		m_objectNode.push_back(-1);
+		m_objectNext.push_back(-1);
+		m_objectPrevious.push_back(-1);
+	}
+
+	m_bounds[handle] = bounds;
+	m_objectNode[handle] = -1;
+	m_objectCount++;
+
+	if (isStatic)
+	{
+		m_state[handle] = STATE_STATIC_ADDED;
+		m_bvhRebuild = true;
+	}
+	else
+	{
+		m_state[handle] = STATE_DYNAMIC;
+		m_objectNode[handle] = FindOctreeNode(bounds, true);
+		LinkOctree(handle);
+	}
+
+	return handle;
+}
+
+//Remove takes the object out of the queries at once. A static object's handle is only reused after the BVH was rebuilt without it.
+
+void SpatialIndexClass::Remove(int handle)
+{
+	switch (m_state[handle])
+	{
+	case STATE_DYNAMIC:
+		UnlinkOctree(handle);
+		m_state[handle] = STATE_FREE;
+		m_freeHandles.push_back(handle);
+		break;
+
+	case STATE_STATIC:
+		m_state[handle] = STATE_STATIC_REMOVED;
+		m_bvhRebuild = true;
+		break;
+
+	case STATE_STATIC_ADDED:
+		m_state[handle] = STATE_FREE;
+		m_freeHandles.push_back(handle);
+		break;
+
+	default:
+		return;
+	}
+
+	m_objectCount--;
+
+	return;
+}
+
+void SpatialIndexClass::Move(int handle, const BoundsType& bounds)
+{
+	int node;
+
+	m_bounds[handle] = bounds;
+
+	if (m_state[handle] == STATE_STATIC)
+	{
+		m_bvhBounds[m_objectNode[handle]] = bounds;
+		m_bvhRefit = true;
+		return;
+	}
+
+	if (m_state[handle] != STATE_DYNAMIC)
+	{
+		return;
+	}
+
+	// Most moves stay in the same cell, then the new box is all there is to it.
+	node = FindOctreeNode(bounds, false);
+	if (node == m_objectNode[handle])
+	{
+		return;
+	}
+
+	UnlinkOctree(handle);
+	m_objectNode[handle] = FindOctreeNode(bounds, true);
+	LinkOctree(handle);
+
+	return;
+}
+
+void SpatialIndexClass::Update()
+{
+	if (m_bvhRebuild)
+	{
+		BuildBvh();
+	}
+	else if (m_bvhRefit)
+	{
+		RefitBvh();
+	}
+
+	m_bvhRebuild = false;
+	m_bvhRefit = false;
+
+	return;
+}
+
+//The queries clear the results and fill them with the handles of every object that passes the test, in no particular order.
+
+void SpatialIndexClass::QueryFrustum(const FrustumType& frustum, std::vector<int>& results)
+{
+	FrustumTestType test = { frustum };
+	QueryTrees(test, results);
+	return;
+}
+
+void SpatialIndexClass::QuerySphere(XMFLOAT3 center, float radius, std::vector<int>& results)
+{
+	SphereTestType test = { center, radius };
+	QueryTrees(test, results);
+	return;
+}
+
+void SpatialIndexClass::QueryBounds(const BoundsType& bounds, std::vector<int>& results)
+{
+	BoundsTestType test = { bounds };
+	QueryTrees(test, results);
+	return;
+}
+
+/*
+QueryRay walks both trees and skips every node the ray only enters beyond the nearest hit found so far. The BVH visits the nearer
+child first so the nearest hit tends to be found early. Ties go to the lower handle so the answer does not depend on the tree.
+*/
+
+int SpatialIndexClass::QueryRay(const RayType& ray, float& distance)
+{
+	int bestHandle = -1;
+	float bestDistance = FLT_MAX;
+	float t, leftT, rightT;
+	bool leftHit, rightHit;
+	int node, handle;
+
+	auto consider = [&](int candidate, const BoundsType& bounds)
+	{
+		if (TestRay(ray, bounds, t) && (t < bestDistance || (t == bestDistance && candidate < bestHandle)))
+		{
+			bestDistance = t;
+			bestHandle = candidate;
+		}
+	};
+
+	m_stack.clear();
+	if (!m_bvhNodes.empty() && TestRay(ray, m_bvhNodes[0].bounds, t))
+	{
+		m_stack.push_back(0);
+	}
+
+	while (!m_stack.empty())
+	{
+		node = m_stack.back();
+		m_stack.pop_back();
+
+		const BvhNodeType& bvhNode = m_bvhNodes[node];
+		if (!TestRay(ray, bvhNode.bounds, t) || t > bestDistance)
+		{
+			continue;
+		}
+
+		if (bvhNode.count > 0)
+		{
+			for (auto i = bvhNode.first; i < bvhNode.first + bvhNode.count; i++)
+			{
+				if (m_state[m_bvhObjects[i]] == STATE_STATIC)
+				{
+					consider(m_bvhObjects[i], m_bvhBounds[i]);
+				}
+			}
+			continue;
+		}
+
+		leftHit = TestRay(ray, m_bvhNodes[bvhNode.first].bounds, leftT);
+		rightHit = TestRay(ray, m_bvhNodes[bvhNode.first + 1].bounds, rightT);
+		if (leftHit && rightHit)
+		{
+			// Push the farther child first so the nearer one comes off the stack next.
+			m_stack.push_back(leftT <= rightT ? bvhNode.first + 1 : bvhNode.first);
+			m_stack.push_back(leftT <= rightT ? bvhNode.first : bvhNode.first + 1);
+		}
+		else if (leftHit || rightHit)
+		{
+			m_stack.push_back(leftHit ? bvhNode.first : bvhNode.first + 1);
+		}
+	}
+
+	// The octree, the root is always visited since objects in it may stick out of its box.
+	m_stack.push_back(0);
+	while (!m_stack.empty())
+	{
+		node = m_stack.back();
+		m_stack.pop_back();
+
+		const OctreeNodeType& octreeNode = m_octreeNodes[node];
+		if (node != 0 && (!TestRay(ray, octreeNode.looseBounds, t) || t > bestDistance))
+		{
+			continue;
+		}
+
+		for (handle = octreeNode.firstObject; handle >= 0; handle = m_objectNext[handle])
+		{
+			consider(handle, m_bounds[handle]);
+		}
+
+		for (auto i = 0; i < 8; i++)
+		{
+			if (octreeNode.children[i] >= 0)
+			{
+				m_stack.push_back(octreeNode.children[i]);
+			}
+		}
+	}
+
+	distance = bestDistance;
+
+	return bestHandle;
+}
+
+void SpatialIndexClass::GetBounds(int handle, BoundsType& bounds)
+{
+	bounds = m_bounds[handle];
+	return;
+}
+
+int SpatialIndexClass::GetObjectCount()
+{
+	return m_objectCount;
+}
+
+int SpatialIndexClass::GetBvhNodeCount()
+{
+	return (int)m_bvhNodes.size();
+}
+
+int SpatialIndexClass::GetOctreeNodeCount()
+{
+	return m_octreeNodeCount;
+}
+
+//ExtractFrustum pulls the planes out of a view * projection matrix (row vectors, depth from 0 to 1 like XMMatrixPerspectiveFovLH).
+//The planes are not normalized, the tests only look at which side a point is on.
+
+void SpatialIndexClass::ExtractFrustum(FXMMATRIX viewProjection, FrustumType& frustum)
+{
+	XMFLOAT4X4 m;
+
+	XMStoreFloat4x4(&m, viewProjection);
+
+	frustum.planes[0] = XMFLOAT4(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41);
+	frustum.planes[1] = XMFLOAT4(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41);
+	frustum.planes[2] = XMFLOAT4(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42);
+	frustum.planes[3] = XMFLOAT4(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42);
+	frustum.planes[4] = XMFLOAT4(m._13, m._23, m._33, m._43);
+	frustum.planes[5] = XMFLOAT4(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43);
+
+	for (auto i = 0; i < 6; i++)
+	{
+		frustum.farCorner[i][0] = frustum.planes[i].x >= 0.0f ? 1 : 0;
+		frustum.farCorner[i][1] = frustum.planes[i].y >= 0.0f ? 1 : 0;
+		frustum.farCorner[i][2] = frustum.planes[i].z >= 0.0f ? 1 : 0;
+	}
+
+	return;
+}
+
+void SpatialIndexClass::MakeRay(XMFLOAT3 origin, XMFLOAT3 direction, float maxDistance, RayType& ray)
+{
+	ray.origin = origin;
+	ray.inverseDirection = XMFLOAT3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	ray.maxDistance = maxDistance;
+	return;
+}
+
+//ClassifyFrustum tests the corner farthest along each plane's normal (if that is behind the plane the whole box is) and the nearest
+//one (if that is in front of every plane the whole box is inside).
+
+SpatialIndexClass::ClassifyType SpatialIndexClass::ClassifyFrustum(const FrustumType& frustum, const BoundsType& bounds)
+{
+	ClassifyType result = INSIDE;
+
+	for (auto i = 0; i < 6; i++)
+	{
+		const XMFLOAT4& plane = frustum.planes[i];
+		const int* corner = frustum.farCorner[i];
+
+		if (plane.x * Corner(bounds, corner[0])[0] + plane.y * Corner(bounds, corner[1])[1] + plane.z * Corner(bounds, corner[2])[2] + plane.w < 0.0f)
+		{
+			return OUTSIDE;
+		}
+
+		if (plane.x * Corner(bounds, 1 - corner[0])[0] + plane.y * Corner(bounds, 1 - corner[1])[1] + plane.z * Corner(bounds, 1 - corner[2])[2] + plane.w < 0.0f)
+		{
+			result = INTERSECTING;
+		}
+	}
+
+	return result;
+}
+
+bool SpatialIndexClass::TestFrustum(const FrustumType& frustum, const BoundsType& bounds)
+{
+	for (auto i = 0; i < 6; i++)
+	{
+		const XMFLOAT4& plane = frustum.planes[i];
+		const int* corner = frustum.farCorner[i];
+
+		if (plane.x * Corner(bounds, corner[0])[0] + plane.y * Corner(bounds, corner[1])[1] + plane.z * Corner(bounds, corner[2])[2] + plane.w < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool SpatialIndexClass::TestSphere(XMFLOAT3 center, float radius, const BoundsType& bounds)
+{
+	const float* c = &center.x;
+	const float* minimum = &bounds.minimum.x;
+	const float* maximum = &bounds.maximum.x;
+	float nearest = 0.0f, d;
+
+	for (auto axis = 0; axis < 3; axis++)
+	{
+		d = c[axis] < minimum[axis] ? minimum[axis] - c[axis] : (c[axis] > maximum[axis] ? c[axis] - maximum[axis] : 0.0f);
+		nearest += d * d;
+	}
+
+	return nearest <= radius * radius;
+}
+
+bool SpatialIndexClass::TestBounds(const BoundsType& a, const BoundsType& b)
+{
+	return a.minimum.x <= b.maximum.x && a.maximum.x >= b.minimum.x
+		&& a.minimum.y <= b.maximum.y && a.maximum.y >= b.minimum.y
+		&& a.minimum.z <= b.maximum.z && a.maximum.z >= b.minimum.z;
+}
+
+//TestRay is the slab test, distance is where the ray enters the box or 0 if it starts inside.
+
+bool SpatialIndexClass::TestRay(const RayType& ray, const BoundsType& bounds, float& distance)
+{
+	const float* origin = &ray.origin.x;
+	const float* inverse = &ray.inverseDirection.x;
+	const float* minimum = &bounds.minimum.x;
+	const float* maximum = &bounds.maximum.x;
+	float enter = 0.0f, leave = ray.maxDistance, t1, t2;
+
+	for (auto axis = 0; axis < 3; axis++)
+	{
+		t1 = (minimum[axis] - origin[axis]) * inverse[axis];
+		t2 = (maximum[axis] - origin[axis]) * inverse[axis];
+
+		// fmin and fmax drop the NaN of a ray lying exactly in a slab plane.
+		enter = fmaxf(enter, fminf(t1, t2));
+		leave = fminf(leave, fmaxf(t1, t2));
+	}
+
+	distance = enter;
+
+	return enter <= leave;
+}
+
+/*
+BuildBvh rebuilds the static tree from scratch. Handles of static objects removed since the last build are freed here since the old
+tree still pointed at them.
+*/
+
+void SpatialIndexClass::BuildBvh()
+{
+	m_bvhObjects.clear();
+	for (auto handle = 0; handle < (int)m_state.size(); handle++)
+	{
+		if (m_state[handle] == STATE_STATIC_REMOVED)
+		{
+			m_state[handle] = STATE_FREE;
+			m_freeHandles.push_back(handle);
+		}
+		else if (m_state[handle] == STATE_STATIC || m_state[handle] == STATE_STATIC_ADDED)
+		{
+			m_state[handle] = STATE_STATIC;
+			m_bvhObjects.push_back(handle);
+		}
+	}
+
+	m_bvhNodes.clear();
+	m_bvhBounds.clear();
+	if (m_bvhObjects.empty())
+	{
+		return;
+	}
+
+	// A binary tree with n leaves has 2n - 1 nodes, reserving them all keeps references into the pool valid while building.
+	m_bvhNodes.reserve(m_bvhObjects.size() * 2);
+	m_bvhNodes.resize(1);
+	BuildBvhNode(0, 0, (int)m_bvhObjects.size());
+
+	m_bvhBounds.resize(m_bvhObjects.size());
+	for (auto i = 0; i < (int)m_bvhObjects.size(); i++)
+	{
+		m_bvhBounds[i] = m_bounds[m_bvhObjects[i]];
+		m_objectNode[m_bvhObjects[i]] = i;
+	}
+
+	return;
+}
+
+/*
+BuildBvhNode sorts the objects [first, first + count) into bins by their center along each axis and evaluates the SAH cost of
+splitting between every pair of neighbouring bins: the objects on each side times the area of their box. The cheapest split wins
+unless keeping the node as a leaf is cheaper still (and the leaf is not too big).
+*/
+
+void SpatialIndexClass::BuildBvhNode(int nodeIndex, int first, int count)
+{
+	BinType bins[BIN_COUNT];
+	BoundsType bounds, centers, left, right;
+	float leftArea[BIN_COUNT], bestCost, cost, scale, extent;
+	int leftCount[BIN_COUNT], rightCount, bestAxis, bestSplit, bin, middle, child;
+
+	MakeEmpty(bounds);
+	MakeEmpty(centers);
+	for (auto i = first; i < first + count; i++)
+	{
+		const BoundsType& object = m_bounds[m_bvhObjects[i]];
+		BoundsType center;
+
+		Grow(bounds, object);
+		center.minimum = center.maximum = XMFLOAT3((object.minimum.x + object.maximum.x) * 0.5f, (object.minimum.y + object.maximum.y) * 0.5f, (object.minimum.z + object.maximum.z) * 0.5f);
+		Grow(centers, center);
+	}
+
+	BvhNodeType& node = m_bvhNodes[nodeIndex];
+	node.bounds = bounds;
+	node.first = first;
+	node.count = count;
+
+	if (count <= LEAF_SIZE)
+	{
+		return;
+	}
+
+	bestCost = FLT_MAX;
+	bestAxis = -1;
+	bestSplit = 0;
+	for (auto axis = 0; axis < 3; axis++)
+	{
+		extent = Corner(centers, 1)[axis] - Corner(centers, 0)[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+		scale = (float)BIN_COUNT / extent;
+
+		for (auto b = 0; b < BIN_COUNT; b++)
+		{
+			MakeEmpty(bins[b].bounds);
+			bins[b].count = 0;
+		}
+
+		for (auto i = first; i < first + count; i++)
+		{
+			const BoundsType& object = m_bounds[m_bvhObjects[i]];
+			bin = (int)(((Corner(object, 0)[axis] + Corner(object, 1)[axis]) * 0.5f - Corner(centers, 0)[axis]) * scale);
+			bin = std::min(std::max(bin, 0), BIN_COUNT - 1);
+			Grow(bins[bin].bounds, object);
+			bins[bin].count++;
+		}
+
+		// Sweep from the left to get the left side of every split, then from the right to finish the costs.
+		MakeEmpty(left);
+		for (auto b = 0; b < BIN_COUNT - 1; b++)
+		{
+			Grow(left, bins[b].bounds);
+			leftArea[b] = HalfArea(left);
+			leftCount[b] = (b > 0 ? leftCount[b - 1] : 0) + bins[b].count;
+		}
+
+		MakeEmpty(right);
+		rightCount = 0;
+		for (auto b = BIN_COUNT - 1; b > 0; b--)
+		{
+			Grow(right, bins[b].bounds);
+			rightCount += bins[b].count;
+
+			if (leftCount[b - 1] == 0 || rightCount == 0)
+			{
+				continue;
+			}
+
+			cost = (float)leftCount[b - 1] * leftArea[b - 1] + (float)rightCount * HalfArea(right);
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b;
+			}
+		}
+	}
+
+	// No split at all when every center is in the same spot, and no split worth the extra node when the leaf is small enough.
+	if (bestAxis < 0 || (count <= MAX_LEAF_SIZE && bestCost + HalfArea(bounds) >= (float)count * HalfArea(bounds)))
+	{
+		return;
+	}
+
+	extent = Corner(centers, 1)[bestAxis] - Corner(centers, 0)[bestAxis];
+	scale = (float)BIN_COUNT / extent;
+	auto split = std::partition(m_bvhObjects.begin() + first, m_bvhObjects.begin() + first + count, [&](int handle)
+	{
+		const BoundsType& object = m_bounds[handle];
+		int b = (int)(((Corner(object, 0)[bestAxis] + Corner(object, 1)[bestAxis]) * 0.5f - Corner(centers, 0)[bestAxis]) * scale);
+		return std::min(std::max(b, 0), BIN_COUNT - 1) < bestSplit;
+	});
+	middle = (int)(split - m_bvhObjects.begin());
+
+	child = (int)m_bvhNodes.size();
+	m_bvhNodes.resize(m_bvhNodes.size() + 2);
+
+	m_bvhNodes[nodeIndex].first = child;
+	m_bvhNodes[nodeIndex].count = 0;
+
+	BuildBvhNode(child, first, middle - first);
+	BuildBvhNode(child + 1, middle, first + count - middle);
+
+	return;
+}
+
+//RefitBvh recomputes every node's box from its children. Children always come after their parent in the pool, so going backwards
+//finishes the children before their parent.
+
+void SpatialIndexClass::RefitBvh()
+{
+	for (auto i = (int)m_bvhNodes.size() - 1; i >= 0; i--)
+	{
+		BvhNodeType& node = m_bvhNodes[i];
+
+		if (node.count > 0)
+		{
+			MakeEmpty(node.bounds);
+			for (auto j = node.first; j < node.first + node.count; j++)
+			{
+				Grow(node.bounds, m_bvhBounds[j]);
+			}
+		}
+		else
+		{
+			node.bounds = m_bvhNodes[node.first].bounds;
+			Grow(node.bounds, m_bvhNodes[node.first + 1].bounds);
+		}
+	}
+
+	return;
+}
+
+//CollectBvh and CollectOctree add everything below a node that was found to be completely inside the query.
+
+void SpatialIndexClass::CollectBvh(int nodeIndex, std::vector<int>& results)
+{
+	int first = nodeIndex, last = nodeIndex;
+
+	// The leaves below a node cover one contiguous range of m_bvhObjects, find its ends by walking down the outer edges.
+	while (m_bvhNodes[first].count == 0)
+	{
+		first = m_bvhNodes[first].first;
+	}
+	while (m_bvhNodes[last].count == 0)
+	{
+		last = m_bvhNodes[last].first + 1;
+	}
+
+	for (auto i = m_bvhNodes[first].first; i < m_bvhNodes[last].first + m_bvhNodes[last].count; i++)
+	{
+		if (m_state[m_bvhObjects[i]] == STATE_STATIC)
+		{
+			results.push_back(m_bvhObjects[i]);
+		}
+	}
+
+	return;
+}
+
+void SpatialIndexClass::CollectOctree(int nodeIndex, std::vector<int>& results)
+{
+	const OctreeNodeType& node = m_octreeNodes[nodeIndex];
+
+	for (auto handle = node.firstObject; handle >= 0; handle = m_objectNext[handle])
+	{
+		results.push_back(handle);
+	}
+
+	for (auto i = 0; i < 8; i++)
+	{
+		if (node.children[i] >= 0)
+		{
+			CollectOctree(node.children[i], results);
+		}
+	}
+
+	return;
+}
+
+int SpatialIndexClass::AllocateOctreeNode(int parent, int depth, XMFLOAT3 center, float halfSize)
+{
+	int index;
+
+	if (!m_freeOctreeNodes.empty())
+	{
+		index = m_freeOctreeNodes.back();
+		m_freeOctreeNodes.pop_back();
+	}
+	else
+	{
+		index = (int)m_octreeNodes.size();
+		m_octreeNodes.resize(m_octreeNodes.size() + 1);
+	}
+
+	OctreeNodeType& node = m_octreeNodes[index];
+	node.center = center;
+	node.halfSize = halfSize;
+	node.looseBounds.minimum = XMFLOAT3(center.x - 2.0f * halfSize, center.y - 2.0f * halfSize, center.z - 2.0f * halfSize);
+	node.looseBounds.maximum = XMFLOAT3(center.x + 2.0f * halfSize, center.y + 2.0f * halfSize, center.z + 2.0f * halfSize);
+	node.parent = parent;
+	node.depth = depth;
+	for (auto i = 0; i < 8; i++)
+	{
+		node.children[i] = -1;
+	}
+	node.firstObject = -1;
+	node.objectCount = 0;
+	node.subtreeCount = 0;
+
+	m_octreeNodeCount++;
+
+	return index;
+}
+
+void SpatialIndexClass::ReleaseOctreeNode(int index)
+{
+	OctreeNodeType& parent = m_octreeNodes[m_octreeNodes[index].parent];
+
+	for (auto i = 0; i < 8; i++)
+	{
+		if (parent.children[i] == index)
+		{
+			parent.children[i] = -1;
+		}
+	}
+
+	m_freeOctreeNodes.push_back(index);
+	m_octreeNodeCount--;
+
+	return;
+}
+
+void SpatialIndexClass::LinkOctree(int handle)
+{
+	int node = m_objectNode[handle];
+
+	m_objectPrevious[handle] = -1;
+	m_objectNext[handle] = m_octreeNodes[node].firstObject;
+	if (m_octreeNodes[node].firstObject >= 0)
+	{
+		m_objectPrevious[m_octreeNodes[node].firstObject] = handle;
+	}
+	m_octreeNodes[node].firstObject = handle;
+	m_octreeNodes[node].objectCount++;
+
+	for (; node >= 0; node = m_octreeNodes[node].parent)
+	{
+		m_octreeNodes[node].subtreeCount++;
+	}
+
+	return;
+}
+
+//UnlinkOctree takes the object out of its node and gives every node that is left empty back to the pool.
+
+void SpatialIndexClass::UnlinkOctree(int handle)
+{
+	int node = m_objectNode[handle];
+	int parent;
+
+	if (m_objectPrevious[handle] >= 0)
+	{
+		m_objectNext[m_objectPrevious[handle]] = m_objectNext[handle];
+	}
+	else
+	{
+		m_octreeNodes[node].firstObject = m_objectNext[handle];
+	}
+	if (m_objectNext[handle] >= 0)
+	{
+		m_objectPrevious[m_objectNext[handle]] = m_objectPrevious[handle];
+	}
+	m_octreeNodes[node].objectCount--;
+
+	for (; node >= 0; node = parent)
+	{
+		parent = m_octreeNodes[node].parent;
+		m_octreeNodes[node].subtreeCount--;
+		if (m_octreeNodes[node].subtreeCount == 0 && parent >= 0)
+		{
+			ReleaseOctreeNode(node);
+		}
+	}
+
+	m_objectNode[handle] = -1;
+
+	return;
+}
+
+/*
+FindOctreeNode walks down from the root to the deepest cell the box fits in: its center has to be in the cell and it can be at most as
+large as the cell, then it is inside the cell's loose box. The containment is checked on the actual floats as well so a query that
+rejects a loose box can never miss an object inside it. Missing cells are created when allocate is set, otherwise the walk stops at
+the deepest existing one.
+*/
+
+int SpatialIndexClass::FindOctreeNode(const BoundsType& bounds, bool allocate)
+{
+	XMFLOAT3 center, childCenter;
+	float halfExtent, childHalf;
+	int node = 0, child, slot;
+
+	center = XMFLOAT3((bounds.minimum.x + bounds.maximum.x) * 0.5f, (bounds.minimum.y + bounds.maximum.y) * 0.5f, (bounds.minimum.z + bounds.maximum.z) * 0.5f);
+	halfExtent = std::max(std::max(bounds.maximum.x - bounds.minimum.x, bounds.maximum.y - bounds.minimum.y), bounds.maximum.z - bounds.minimum.z) * 0.5f;
+
+	const OctreeNodeType& root = m_octreeNodes[0];
+	if (fabsf(center.x - root.center.x) > root.halfSize || fabsf(center.y - root.center.y) > root.halfSize || fabsf(center.z - root.center.z) > root.halfSize)
+	{
+		return 0;
+	}
+
+	while (m_octreeNodes[node].depth < m_maxDepth)
+	{
+		const OctreeNodeType& current = m_octreeNodes[node];
+
+		childHalf = current.halfSize * 0.5f;
+		if (halfExtent > childHalf)
+		{
+			break;
+		}
+
+		slot = (center.x >= current.center.x ? 1 : 0) | (center.y >= current.center.y ? 2 : 0) | (center.z >= current.center.z ? 4 : 0);
+		childCenter = XMFLOAT3(current.center.x + ((slot & 1) ? childHalf : -childHalf), current.center.y + ((slot & 2) ? childHalf : -childHalf),
+			current.center.z + ((slot & 4) ? childHalf : -childHalf));
+
+		child = current.children[slot];
+		if (child < 0)
+		{
+			BoundsType loose;
+			loose.minimum = XMFLOAT3(childCenter.x - 2.0f * childHalf, childCenter.y - 2.0f * childHalf, childCenter.z - 2.0f * childHalf);
+			loose.maximum = XMFLOAT3(childCenter.x + 2.0f * childHalf, childCenter.y + 2.0f * childHalf, childCenter.z + 2.0f * childHalf);
+			if (!Contains(loose, bounds))
+			{
+				break;
+			}
+
+			if (!allocate)
+			{
+				return -1;
+			}
+
+			child = AllocateOctreeNode(node, current.depth + 1, childCenter, childHalf);
+			m_octreeNodes[node].children[slot] = child;
+		}
+		else if (!Contains(m_octreeNodes[child].looseBounds, bounds))
+		{
+			break;
+		}
+
+		node = child;
+	}
+
+	return node;
+}
+
+/*
+QueryTrees runs one query over both trees with an explicit stack. A node that is OUTSIDE is skipped with everything below it, one that
+is INSIDE is taken with everything below it untested, and for the rest the objects are tested one by one.
+*/
+
+template <typename TestType>
+void SpatialIndexClass::QueryTrees(const TestType& test, std::vector<int>& results)
+{
+	ClassifyType classify;
+	int node;
+
+	results.clear();
+
+	m_stack.clear();
+	if (!m_bvhNodes.empty())
+	{
+		m_stack.push_back(0);
+	}
+
+	while (!m_stack.empty())
+	{
+		node = m_stack.back();
+		m_stack.pop_back();
+
+		const BvhNodeType& bvhNode = m_bvhNodes[node];
+		classify = test.Classify(bvhNode.bounds);
+		if (classify == OUTSIDE)
+		{
+			continue;
+		}
+		if (classify == INSIDE)
+		{
+			CollectBvh(node, results);
+			continue;
+		}
+
+		if (bvhNode.count > 0)
+		{
+			for (auto i = bvhNode.first; i < bvhNode.first + bvhNode.count; i++)
+			{
+				if (m_state[m_bvhObjects[i]] == STATE_STATIC && test.Test(m_bvhBounds[i]))
+				{
+					results.push_back(m_bvhObjects[i]);
+				}
+			}
+			continue;
+		}
+
+		m_stack.push_back(bvhNode.first + 1);
+		m_stack.push_back(bvhNode.first);
+	}
+
+	m_stack.push_back(0);
+	while (!m_stack.empty())
+	{
+		node = m_stack.back();
+		m_stack.pop_back();
+
+		const OctreeNodeType& octreeNode = m_octreeNodes[node];
+		classify = node == 0 ? INTERSECTING : test.Classify(octreeNode.looseBounds);
+		if (classify == OUTSIDE)
+		{
+			continue;
+		}
+		if (classify == INSIDE)
+		{
+			CollectOctree(node, results);
+			continue;
+		}
+
+		for (auto handle = octreeNode.firstObject; handle >= 0; handle = m_objectNext[handle])
+		{
+			if (test.Test(m_bounds[handle]))
+			{
+				results.push_back(handle);
+			}
+		}
+
+		for (auto i = 0; i < 8; i++)
+		{
+			if (octreeNode.children[i] >= 0)
+			{
+				m_stack.push_back(octreeNode.children[i]);
+			}
+		}
+	}
+
+	return;
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: spatialindexclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SPATIALINDEXCLASS_H_
+#define _SPATIALINDEXCLASS_H_
+
+/*
+The SpatialIndexClass answers "which objects are in here" questions for culling, picking and streaming without looking at every
+object. Objects are axis aligned boxes known by a handle, and they live in one of two structures depending on how they were inserted:
+
+Static objects go into a bounding volume hierarchy built with the surface area heuristic, the split that minimises the expected cost
+of a query is picked from 12 bins on each axis. Building is not cheap so it only happens in Update after static objects were added or
+removed. Moving a static object just refits the boxes of the nodes above it, which keeps the tree valid but slowly makes it worse.
+
+Dynamic objects go into a loose octree. Every cell's box is twice the size of the cell, so an object only has to have its center in a
+cell and be no larger than the cell to fit, which means an object can be put straight into its final cell by its size and position
+and moving it is usually just a box update. Objects that do not fit anywhere below stay in the root.
+
+Both trees keep their nodes in contiguous pools (std::vector plus a free list for the octree) and refer to each other by index.
+Frustum queries classify nodes as outside, inside or intersecting and take everything below a node that is fully inside without
+testing it any further. The box tests work on the min/max corners directly so a node and the objects in it always agree.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <DirectXMath.h>
+#include <vector>
+
+using namespace DirectX;
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: SpatialIndexClass
+////////////////////////////////////////////////////////////////////////////////
+class SpatialIndexClass
+{
+public:
+	struct BoundsType
+	{
+		XMFLOAT3 minimum;
+		XMFLOAT3 maximum;
+	};
+
+	//the six planes of a view frustum pointing inwards, plus which corner of a box is farthest along each plane's normal
+	struct FrustumType
+	{
+		XMFLOAT4 planes[6];
+		int farCorner[6][3];
+	};
+
+	struct RayType
+	{
+		XMFLOAT3 origin;
+		XMFLOAT3 inverseDirection;
+		float maxDistance;
+	};
+
+	enum ClassifyType
+	{
+		OUTSIDE,
+		INTERSECTING,
+		INSIDE
+	};
+
+private:
+	static const int LEAF_SIZE = 4;
+	static const int MAX_LEAF_SIZE = 16;
+	static const int BIN_COUNT = 12;
+
+	enum StateType
+	{
+		STATE_FREE,
+		STATE_DYNAMIC,
+		STATE_STATIC,
+		STATE_STATIC_ADDED,
+		STATE_STATIC_REMOVED
+	};
+
+	//a BVH node is a leaf when count is above 0, then first is its first entry in m_bvhObjects, otherwise first is its left child
+	//and the right child follows it
+	struct BvhNodeType
+	{
+		BoundsType bounds;
+		int first;
+		int count;
+	};
+
+	struct OctreeNodeType
+	{
+		XMFLOAT3 center;
+		float halfSize;
+		BoundsType looseBounds;
+		int parent;
+		int depth;
+		int children[8];
+		int firstObject;
+		int objectCount;
+		int subtreeCount;
+	};
+
+	struct BinType
+	{
+		BoundsType bounds;
+		int count;
+	};
+
+public:
+	SpatialIndexClass();
+	SpatialIndexClass(const SpatialIndexClass&);
+	~SpatialIndexClass();
+
+	//the octree covers a cube around center with the given half size, split into at most maxDepth levels
+	bool Initialize(XMFLOAT3, float, int);
+	void Shutdown();
+
+	int Insert(const BoundsType&, bool);
+	void Remove(int);
+	void Move(int, const BoundsType&);
+
+	//rebuilds or refits the static BVH, queries only see static changes after this
+	void Update();
+
+	void QueryFrustum(const FrustumType&, std::vector<int>&);
+	void QuerySphere(XMFLOAT3, float, std::vector<int>&);
+	void QueryBounds(const BoundsType&, std::vector<int>&);
+
+	//returns the handle of the nearest object the ray hits within its max distance, or -1
+	int QueryRay(const RayType&, float&);
+
+	void GetBounds(int, BoundsType&);
+	int GetObjectCount();
+	int GetBvhNodeCount();
+	int GetOctreeNodeCount();
+
+	//the tests the queries use, public so brute force code can give exactly the same answers
+	static void ExtractFrustum(FXMMATRIX, FrustumType&);
+	static void MakeRay(XMFLOAT3, XMFLOAT3, float, RayType&);
+	static ClassifyType ClassifyFrustum(const FrustumType&, const BoundsType&);
+	static bool TestFrustum(const FrustumType&, const BoundsType&);
+	static bool TestSphere(XMFLOAT3, float, const BoundsType&);
+	static bool TestBounds(const BoundsType&, const BoundsType&);
+	static bool TestRay(const RayType&, const BoundsType&, float&);
+
+private:
+	void BuildBvh();
+	void BuildBvhNode(int, int, int);
+	void RefitBvh();
+	void CollectBvh(int, std::vector<int>&);
+	void CollectOctree(int, std::vector<int>&);
+
+	int AllocateOctreeNode(int, int, XMFLOAT3, float);
+	void ReleaseOctreeNode(int);
+	void LinkOctree(int);
+	void UnlinkOctree(int);
+	int FindOctreeNode(const BoundsType&, bool);
+
+	template <typename TestType>
+	void QueryTrees(const TestType&, std::vector<int>&);
+
+private:
+	//per handle state, m_objectNode is the octree node of a dynamic object or the m_bvhObjects slot of a static one
+	std::vector<BoundsType> m_bounds;
+	std::vector<unsigned char> m_state;
+	std::vector<int> m_objectNode;
+	std::vector<int> m_objectNext;
+	std::vector<int> m_objectPrevious;
+	std::vector<int> m_freeHandles;
+	int m_objectCount;
+
+	//the static BVH, m_bvhBounds is a copy of the object boxes in leaf order so the leaves read them front to back
+	std::vector<BvhNodeType> m_bvhNodes;
+	std::vector<int> m_bvhObjects;
+	std::vector<BoundsType> m_bvhBounds;
+	bool m_bvhRebuild;
+	bool m_bvhRefit;
+
+	//the dynamic loose octree
+	std::vector<OctreeNodeType> m_octreeNodes;
+	std::vector<int> m_freeOctreeNodes;
+	int m_octreeNodeCount;
+	int m_maxDepth;
+
+	//traversal stack shared by the queries
+	std::vector<int> m_stack;
+};
+
+#endif
@@ -0,0 +1,588 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: spritebatchclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "spritebatchclass.h"
+#include <cstring>
+#include <cctype>
+
+using namespace DirectX;
+
+//one character of the built in font, a row is five bits with the leftmost pixel in bit 4
+struct GlyphType
+{
+	char character;
+	unsigned char rows[SpriteBatchClass::GLYPH_HEIGHT];
+};
+
+static const GlyphType FONT_GLYPHS[] =
+{
+	{ '!', { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 } },
+	{ '%', { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 } },
+	{ '(', { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 } },
+	{ ')', { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 } },
+	{ '+', { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 } },
+	{ ',', { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 } },
+	{ '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+	{ '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+	{ '/', { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 } },
+	{ '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+	{ '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+	{ '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+	{ '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+	{ '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+	{ '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+	{ '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+	{ '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+	{ '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+	{ '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+	{ ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+	{ '=', { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 } },
+	{ 'A', { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 } },
+	{ 'B', { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E } },
+	{ 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+	{ 'D', { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C } },
+	{ 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+	{ 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+	{ 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+	{ 'H', { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+	{ 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+	{ 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+	{ 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+	{ 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+	{ 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+	{ 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+	{ 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+	{ 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+	{ 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+	{ 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+	{ 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+	{ 'T', { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+	{ 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+	{ 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+	{ 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A } },
+	{ 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+	{ 'Y', { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 } },
+	{ 'Z', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F } },
+	{ '_', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F } }
+};
+
+//the vertex and pixel shader Initialize creates
+static const RenderShaderDesc s_shaders[] =
+{
+	{ L"HudVS.hlsl", "HudVertexShader", false },
+	{ L"HudPS.hlsl", "HudPixelShader", true },
+};
+
+SpriteBatchClass::SpriteBatchClass()
+	: m_device(nullptr)
+	, m_vertexShader(RENDER_NULL_HANDLE)
+	, m_pixelShader(RENDER_NULL_HANDLE)
+	, m_layout(RENDER_NULL_HANDLE)
+	, m_matrixBuffer(RENDER_NULL_HANDLE)
+	, m_vertexBuffer(RENDER_NULL_HANDLE)
+	, m_indexBuffer(RENDER_NULL_HANDLE)
+	, m_sampleState(RENDER_NULL_HANDLE)
+	, m_rasterizerState(RENDER_NULL_HANDLE)
+	, m_depthStencilState(RENDER_NULL_HANDLE)
+	, m_blendState(RENDER_NULL_HANDLE)
+	, m_screenWidth(0)
+	, m_screenHeight(0)
+	, m_maxQuads(0)
+	, m_quadCount(0)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+SpriteBatchClass::SpriteBatchClass(const SpriteBatchClass& other)
+{
+}
+
+
+SpriteBatchClass::~SpriteBatchClass()
+{
+}
+
+bool SpriteBatchClass::Initialize(RenderDeviceClass* device, StateCacheClass* states, int screenWidth, int screenHeight, int maxQuads)
+{
+	RenderInputElementDesc polygonLayout[3];
+	RenderBufferDesc bufferDesc;
+	RenderSamplerDesc samplerDesc;
+	RenderRasterizerDesc rasterizerDesc;
+	RenderDepthStencilDesc depthStencilDesc;
+	RenderBlendDesc blendDesc;
+	std::vector<unsigned int> indices;
+
+	if (!device || !states || screenWidth <= 0 || screenHeight <= 0 || maxQuads <= 0)
+	{
+		return false;
+	}
+
+	m_device = device;
+	m_screenWidth = screenWidth;
+	m_screenHeight = screenHeight;
+	m_maxQuads = maxQuads;
+	m_quadCount = 0;
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	m_vertexShader = device->CreateVertexShader(s_shaders[0].filename, s_shaders[0].entryPoint);
+	if (m_vertexShader == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	m_pixelShader = device->CreatePixelShader(s_shaders[1].filename, s_shaders[1].entryPoint);
+	if (m_pixelShader == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	//position, texture coordinates and color, the same as VertexType
+	polygonLayout[0].semanticName = "POSITION";
+	polygonLayout[0].semanticIndex = 0;
+	polygonLayout[0].format = RENDER_FORMAT_R32G32_FLOAT;
+	polygonLayout[0].inputSlot = 0;
+	polygonLayout[0].alignedByteOffset = 0;
+
+	polygonLayout[1].semanticName = "TEXCOORD";
+	polygonLayout[1].semanticIndex = 0;
+	polygonLayout[1].format = RENDER_FORMAT_R32G32_FLOAT;
+	polygonLayout[1].inputSlot = 0;
+	polygonLayout[1].alignedByteOffset = RENDER_APPEND_ALIGNED_ELEMENT;
+
+	polygonLayout[2].semanticName = "COLOR";
+	polygonLayout[2].semanticIndex = 0;
+	polygonLayout[2].format = RENDER_FORMAT_R32G32B32A32_FLOAT;
+	polygonLayout[2].inputSlot = 0;
+	polygonLayout[2].alignedByteOffset = RENDER_APPEND_ALIGNED_ELEMENT;
+
+	m_layout = states->GetInputLayout(polygonLayout, 3, m_vertexShader);
+	if (m_layout == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	//point sampling keeps the font sharp at whole number scales
+	memset(&samplerDesc, 0, sizeof(samplerDesc));
+	samplerDesc.filter = RENDER_FILTER_MIN_MAG_MIP_POINT;
+	samplerDesc.addressU = RENDER_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.addressV = RENDER_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.addressW = RENDER_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.maxAnisotropy = 1;
+	samplerDesc.comparisonFunc = RENDER_COMPARISON_ALWAYS;
+	samplerDesc.maxLOD = RENDER_FLOAT32_MAX;
+
+	m_sampleState = states->GetSamplerState(samplerDesc);
+	if (m_sampleState == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	memset(&rasterizerDesc, 0, sizeof(rasterizerDesc));
+	rasterizerDesc.fillMode = RENDER_FILL_SOLID;
+	rasterizerDesc.cullMode = RENDER_CULL_NONE;
+	rasterizerDesc.depthClipEnable = true;
+
+	m_rasterizerState = states->GetRasterizerState(rasterizerDesc);
+	if (m_rasterizerState == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	//the overlay goes over everything, no depth test and no depth written
+	memset(&depthStencilDesc, 0, sizeof(depthStencilDesc));
+	depthStencilDesc.depthEnable = false;
+	depthStencilDesc.depthWriteEnable = false;
+	depthStencilDesc.depthFunc = RENDER_COMPARISON_ALWAYS;
+	depthStencilDesc.frontFace.stencilFunc = RENDER_COMPARISON_ALWAYS;
+	depthStencilDesc.backFace.stencilFunc = RENDER_COMPARISON_ALWAYS;
+
+	m_depthStencilState = states->GetDepthStencilState(depthStencilDesc);
+	if (m_depthStencilState == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	memset(&blendDesc, 0, sizeof(blendDesc));
+	blendDesc.blendEnable = true;
+	blendDesc.srcBlend = RENDER_BLEND_SRC_ALPHA;
+	blendDesc.destBlend = RENDER_BLEND_INV_SRC_ALPHA;
+	blendDesc.blendOp = RENDER_BLEND_OP_ADD;
+	blendDesc.srcBlendAlpha = RENDER_BLEND_ONE;
+	blendDesc.destBlendAlpha = RENDER_BLEND_INV_SRC_ALPHA;
+	blendDesc.blendOpAlpha = RENDER_BLEND_OP_ADD;
+	blendDesc.writeMask = 0x0F;
+
+	m_blendState = states->GetBlendState(blendDesc);
+	if (m_blendState == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	memset(&bufferDesc, 0, sizeof(bufferDesc));
+	bufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	bufferDesc.byteWidth = sizeof(MatrixBufferType);
+	bufferDesc.bindType = RENDER_BIND_CONSTANT_BUFFER;
+
+	m_matrixBuffer = device->CreateBuffer(bufferDesc, nullptr);
+	if (m_matrixBuffer == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	//the one dynamic vertex buffer every atlas is written into
+	bufferDesc.usage = RENDER_USAGE_DYNAMIC;
+	bufferDesc.byteWidth = (unsigned int)(maxQuads * 4 * sizeof(VertexType));
+	bufferDesc.bindType = RENDER_BIND_VERTEX_BUFFER;
+
+	m_vertexBuffer = device->CreateBuffer(bufferDesc, nullptr);
+	if (m_vertexBuffer == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	// Every quad is two triangles out of its four vertices: top left, top right, bottom left, bottom right.
+	indices.resize((size_t)maxQuads * 6);
+	for (auto quad = 0; quad < maxQuads; quad++)
+	{
+		indices[quad * 6 + 0] = quad * 4 + 0;
+		indices[quad * 6 + 1] = quad * 4 + 1;
+		indices[quad * 6 + 2] = quad * 4 + 2;
+		indices[quad * 6 + 3] = quad * 4 + 2;
+		indices[quad * 6 + 4] = quad * 4 + 1;
+		indices[quad * 6 + 5] = quad * 4 + 3;
+	}
+
+	bufferDesc.usage = RENDER_USAGE_IMMUTABLE;
+	bufferDesc.byteWidth = (unsigned int)(indices.size() * sizeof(unsigned int));
+	bufferDesc.bindType = RENDER_BIND_INDEX_BUFFER;
+
+	m_indexBuffer = device->CreateBuffer(bufferDesc, indices.data());
+	if (m_indexBuffer == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	m_staging.reserve((size_t)maxQuads * 4);
+
+	return InitializeFont();
+}
+
+const RenderShaderDesc* SpriteBatchClass::GetShaders(int& count)
+{
+	count = sizeof(s_shaders) / sizeof(s_shaders[0]);
+	return s_shaders;
+}
+
+void SpriteBatchClass::Shutdown()
+{
+	if (!m_device)
+	{
+		return;
+	}
+
+	for (auto& atlas : m_atlases)
+	{
+		if (atlas.owned)
+		{
+			m_device->ReleaseResource(atlas.texture);
+		}
+	}
+	m_atlases.clear();
+	m_staging.clear();
+
+	m_device->ReleaseResource(m_indexBuffer);
+	m_indexBuffer = RENDER_NULL_HANDLE;
+
+	m_device->ReleaseResource(m_vertexBuffer);
+	m_vertexBuffer = RENDER_NULL_HANDLE;
+
+	m_device->ReleaseResource(m_matrixBuffer);
+	m_matrixBuffer = RENDER_NULL_HANDLE;
+
+	//the layout, sampler and pipeline states belong to the state cache
+	m_layout = RENDER_NULL_HANDLE;
+	m_sampleState = RENDER_NULL_HANDLE;
+	m_rasterizerState = RENDER_NULL_HANDLE;
+	m_depthStencilState = RENDER_NULL_HANDLE;
+	m_blendState = RENDER_NULL_HANDLE;
+
+	m_device->ReleaseResource(m_pixelShader);
+	m_pixelShader = RENDER_NULL_HANDLE;
+
+	m_device->ReleaseResource(m_vertexShader);
+	m_vertexShader = RENDER_NULL_HANDLE;
+
+	m_device = nullptr;
+
+	return;
+}
+
+int SpriteBatchClass::AddAtlas(RenderHandle texture)
+{
+	AtlasType atlas;
+
+	if (texture == RENDER_NULL_HANDLE)
+	{
+		return -1;
+	}
+
+	atlas.texture = texture;
+	atlas.owned = false;
+	m_atlases.push_back(atlas);
+
+	return (int)m_atlases.size() - 1;
+}
+
+bool SpriteBatchClass::AddQuad(int atlas, float x, float y, float width, float height, const XMFLOAT4& tex, const XMFLOAT4& color)
+{
+	VertexType vertex;
+
+	if (atlas < 0 || atlas >= (int)m_atlases.size() || m_quadCount >= m_maxQuads)
+	{
+		m_stats.dropped++;
+		return false;
+	}
+
+	std::vector<VertexType>& vertices = m_atlases[atlas].vertices;
+	vertex.color = color;
+
+	vertex.position = XMFLOAT2(x, y);
+	vertex.tex = XMFLOAT2(tex.x, tex.y);
+	vertices.push_back(vertex);
+
+	vertex.position = XMFLOAT2(x + width, y);
+	vertex.tex = XMFLOAT2(tex.z, tex.y);
+	vertices.push_back(vertex);
+
+	vertex.position = XMFLOAT2(x, y + height);
+	vertex.tex = XMFLOAT2(tex.x, tex.w);
+	vertices.push_back(vertex);
+
+	vertex.position = XMFLOAT2(x + width, y + height);
+	vertex.tex = XMFLOAT2(tex.z, tex.w);
+	vertices.push_back(vertex);
+
+	m_quadCount++;
+
+	return true;
+}
+
+//AddRect samples the middle of the font's solid cell, so the whole rectangle is the color
+
+bool SpriteBatchClass::AddRect(float x, float y, float width, float height, const XMFLOAT4& color)
+{
+	float u, v;
+
+	u = ((float)(SOLID_CHARACTER % FONT_COLUMNS) + 0.5f) / (float)FONT_COLUMNS;
+	v = ((float)(SOLID_CHARACTER / FONT_COLUMNS) + 0.5f) / (float)FONT_ROWS;
+
+	return AddQuad(FONT_ATLAS, x, y, width, height, XMFLOAT4(u, v, u, v), color);
+}
+
+float SpriteBatchClass::AddText(float x, float y, const char* text, const XMFLOAT4& color, float scale)
+{
+	const float cellU = 1.0f / (float)FONT_COLUMNS;
+	const float cellV = 1.0f / (float)FONT_ROWS;
+	XMFLOAT4 tex;
+	int character;
+
+	for (; text && *text; text++)
+	{
+		character = toupper((unsigned char)*text);
+
+		// Spaces and characters outside the font take up room but need no quad.
+		if (character > ' ' && character < SOLID_CHARACTER)
+		{
+			tex.x = (float)(character % FONT_COLUMNS) * cellU;
+			tex.y = (float)(character / FONT_COLUMNS) * cellV;
+			tex.z = tex.x + (float)GLYPH_WIDTH / (float)(FONT_COLUMNS * FONT_CELL);
+			tex.w = tex.y + (float)GLYPH_HEIGHT / (float)(FONT_ROWS * FONT_CELL);
+
+			AddQuad(FONT_ATLAS, x, y, (float)GLYPH_WIDTH * scale, (float)GLYPH_HEIGHT * scale, tex, color);
+		}
+
+		x += (float)GLYPH_ADVANCE * scale;
+	}
+
+	return x;
+}
+
+float SpriteBatchClass::MeasureText(const char* text, float scale)
+{
+	return text ? (float)strlen(text) * (float)GLYPH_ADVANCE * scale : 0.0f;
+}
+
+/*
+Render copies the vertex lists of all atlases one after the other into the vertex buffer with one DISCARD write, then draws each atlas
+with the base vertex where its list starts. Every quad's indices are the same six, only moved by its first vertex, so they all come out
+of the static index buffer from its start. The view matrix puts pixel 0, 0 in the top left corner of the ortho projection with y down.
+*/
+
+bool SpriteBatchClass::Render(RenderContextClass* context, XMMATRIX orthoMatrix)
+{
+	MatrixBufferType matrixData;
+	unsigned int baseVertex;
+	bool result;
+
+	if (m_quadCount == 0)
+	{
+		return true;
+	}
+
+	m_staging.clear();
+	for (auto& atlas : m_atlases)
+	{
+		m_staging.insert(m_staging.end(), atlas.vertices.begin(), atlas.vertices.end());
+	}
+
+	result = context->WriteBuffer(m_vertexBuffer, 0, m_staging.data(), (unsigned int)(m_staging.size() * sizeof(VertexType)), RENDER_MAP_WRITE_DISCARD);
+	if (!result)
+	{
+		Clear();
+		return false;
+	}
+
+	matrixData.world = XMMatrixIdentity();
+	matrixData.view = XMMatrixTranspose(XMMatrixMultiply(XMMatrixTranslation(-0.5f * (float)m_screenWidth, -0.5f * (float)m_screenHeight, 0.0f),
+		XMMatrixScaling(1.0f, -1.0f, 1.0f)));
+	matrixData.projection = XMMatrixTranspose(orthoMatrix);
+
+	result = context->WriteBuffer(m_matrixBuffer, 0, &matrixData, sizeof(matrixData), RENDER_MAP_WRITE_DISCARD);
+	if (!result)
+	{
+		Clear();
+		return false;
+	}
+
+	context->SetVSConstantBuffer(0, m_matrixBuffer);
+	context->SetInputLayout(m_layout);
+	context->SetVertexShader(m_vertexShader);
+	context->SetPixelShader(m_pixelShader);
+	context->SetPSSampler(0, m_sampleState);
+	context->SetRasterizerState(m_rasterizerState);
+	context->SetDepthStencilState(m_depthStencilState, 0);
+	context->SetBlendState(m_blendState);
+	context->SetVertexBuffer(0, m_vertexBuffer, sizeof(VertexType), 0);
+	context->SetIndexBuffer(m_indexBuffer, RENDER_FORMAT_R32_UINT, 0);
+	context->SetPrimitiveTopology(RENDER_TOPOLOGY_TRIANGLELIST);
+
+	baseVertex = 0;
+	for (auto& atlas : m_atlases)
+	{
+		if (atlas.vertices.empty())
+		{
+			continue;
+		}
+
+		context->SetPSTexture(0, atlas.texture);
+		context->DrawIndexed((unsigned int)(atlas.vertices.size() / 4 * 6), 0, (int)baseVertex);
+		baseVertex += (unsigned int)atlas.vertices.size();
+		m_stats.draws++;
+	}
+
+	m_stats.quads += m_quadCount;
+	Clear();
+
+	return true;
+}
+
+void SpriteBatchClass::Clear()
+{
+	for (auto& atlas : m_atlases)
+	{
+		atlas.vertices.clear();
+	}
+	m_quadCount = 0;
+
+	return;
+}
+
+int SpriteBatchClass::GetAtlasCount()
+{
+	return (int)m_atlases.size();
+}
+
+const std::vector<SpriteBatchClass::VertexType>& SpriteBatchClass::GetVertices(int atlas)
+{
+	return m_atlases[atlas].vertices;
+}
+
+int SpriteBatchClass::GetQuadCount()
+{
+	return m_quadCount;
+}
+
+void SpriteBatchClass::GetStats(StatsType& stats)
+{
+	stats = m_stats;
+	return;
+}
+
+void SpriteBatchClass::ResetStats()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	return;
+}
+
+//InitializeFont draws the glyphs into their cells, white with the glyph in the alpha, fills the solid cell and makes it atlas FONT_ATLAS.
+
+bool SpriteBatchClass::InitializeFont()
+{
+	const int width = FONT_COLUMNS * FONT_CELL;
+	const int height = FONT_ROWS * FONT_CELL;
+	std::vector<unsigned char> pixels((size_t)width * height * 4, 0);
+	RenderTextureDesc textureDesc;
+	AtlasType atlas;
+	int left, top;
+
+	auto setPixel = [&](int x, int y)
+	{
+		unsigned char* pixel = &pixels[((size_t)y * width + x) * 4];
+		pixel[0] = pixel[1] = pixel[2] = pixel[3] = 255;
+	};
+
+	for (auto& glyph : FONT_GLYPHS)
+	{
+		left = (glyph.character % FONT_COLUMNS) * FONT_CELL;
+		top = (glyph.character / FONT_COLUMNS) * FONT_CELL;
+
+		for (auto row = 0; row < GLYPH_HEIGHT; row++)
+		{
+			for (auto column = 0; column < GLYPH_WIDTH; column++)
+			{
+				if (glyph.rows[row] & (0x10 >> column))
+				{
+					setPixel(left + column, top + row);
+				}
+			}
+		}
+	}
+
+	left = (SOLID_CHARACTER % FONT_COLUMNS) * FONT_CELL;
+	top = (SOLID_CHARACTER / FONT_COLUMNS) * FONT_CELL;
+	for (auto y = 0; y < FONT_CELL; y++)
+	{
+		for (auto x = 0; x < FONT_CELL; x++)
+		{
+			setPixel(left + x, top + y);
+		}
+	}
+
+	memset(&textureDesc, 0, sizeof(textureDesc));
+	textureDesc.width = width;
+	textureDesc.height = height;
+	textureDesc.format = RENDER_FORMAT_R8G8B8A8_UNORM;
+	textureDesc.generateMips = false;
+
+	atlas.texture = m_device->CreateTexture2D(textureDesc, pixels.data(), width * 4);
+	if (atlas.texture == RENDER_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	atlas.owned = true;
+	m_atlases.clear();
+	m_atlases.push_back(atlas);
+
+	return true;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: spritebatchclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _SPRITEBATCHCLASS_H_
+#define _SPRITEBATCHCLASS_H_
+
+/*
+The SpriteBatchClass draws screen space quads and text, for overlays like the performance HUD. The Add functions only append four
+vertices to the list of the quad's atlas, a texture the quad takes its texels from. Render writes the lists of every atlas one after
+the other into one dynamic vertex buffer with a single DISCARD write and draws each atlas with one DrawIndexed out of a static index
+buffer of quads, so a frame of overlay takes one draw per atlas used however many quads it was added in.
+
+Atlas FONT_ATLAS is made by Initialize: a built in 5x7 pixel font of the digits, upper case letters and some punctuation (lower case
+is drawn upper case) and a solid white cell that AddRect uses, so text and flat rectangles go in the same draw. Positions are pixels
+from the top left corner of the screen. The quads are drawn in the order they were added within their atlas, alpha blended over the
+scene without depth testing, through the ortho matrix given to Render (D3DClass::GetOrthoMatrix). HudVS.hlsl and HudPS.hlsl multiply
+the atlas by the vertex color.
+
+The vertex lists can be read back before Render, so the layout of an overlay can be checked on the null device without drawing it.
+At most maxQuads quads fit in a frame, the ones after that are dropped. The Add functions are not thread safe, Render has to run on the
+immediate context once per frame.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <DirectXMath.h>
+#include "renderdeviceclass.h"
+#include "statecacheclass.h"
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: SpriteBatchClass
+////////////////////////////////////////////////////////////////////////////////
+class SpriteBatchClass
+{
+public:
+	struct VertexType
+	{
+		DirectX::XMFLOAT2 position;
+		DirectX::XMFLOAT2 tex;
+		DirectX::XMFLOAT4 color;
+	};
+
+	struct StatsType
+	{
+		unsigned long long quads;
+		unsigned long long draws;
+		unsigned long long dropped;
+	};
+
+	static const int FONT_ATLAS = 0;
+
+	//a character of the built in font is GLYPH_WIDTH by GLYPH_HEIGHT pixels and the next one starts GLYPH_ADVANCE pixels on, times the scale
+	static const int GLYPH_WIDTH = 5;
+	static const int GLYPH_HEIGHT = 7;
+	static const int GLYPH_ADVANCE = 6;
+
+private:
+	//the font texture is a grid of 16 by 8 cells of 8 pixels, one per ASCII code, the glyph in the top left of its cell
+	static const int FONT_CELL = 8;
+	static const int FONT_COLUMNS = 16;
+	static const int FONT_ROWS = 8;
+	static const int SOLID_CHARACTER = 127;
+
+	struct MatrixBufferType
+	{
+		DirectX::XMMATRIX world;
+		DirectX::XMMATRIX view;
+		DirectX::XMMATRIX projection;
+	};
+
+	//owned atlases are released with the batch, the font is the only one so far
+	struct AtlasType
+	{
+		RenderHandle texture;
+		bool owned;
+		std::vector<VertexType> vertices;
+	};
+
+public:
+	SpriteBatchClass();
+	SpriteBatchClass(const SpriteBatchClass&);
+	~SpriteBatchClass();
+
+	//device, the state cache the input layout and pipeline states come from, the screen size in pixels and the most quads a frame
+	bool Initialize(RenderDeviceClass*, StateCacheClass*, int, int, int);
+	void Shutdown();
+
+	//the shaders Initialize creates, so they can be compiled before the device is there
+	static const RenderShaderDesc* GetShaders(int&);
+
+	//adds a texture as an atlas and returns its number, -1 on failure. The texture stays the caller's.
+	int AddAtlas(RenderHandle);
+
+	//a quad at x, y of the given width and height, the texture coordinates are left, top, right, bottom
+	bool AddQuad(int, float, float, float, float, const DirectX::XMFLOAT4&, const DirectX::XMFLOAT4&);
+	bool AddRect(float, float, float, float, const DirectX::XMFLOAT4&);
+
+	//text with its top left corner at x, y in the font at the given whole number scale, returns where the next character would go
+	float AddText(float, float, const char*, const DirectX::XMFLOAT4&, float);
+	static float MeasureText(const char*, float);
+
+	//draws everything added since the last Render, or Clear
+	bool Render(RenderContextClass*, DirectX::XMMATRIX);
+	void Clear();
+
+	//what has been added so far
+	int GetAtlasCount();
+	const std::vector<VertexType>& GetVertices(int);
+	int GetQuadCount();
+
+	void GetStats(StatsType&);
+	void ResetStats();
+
+private:
+	bool InitializeFont();
+
+private:
+	RenderDeviceClass* m_device;
+	RenderHandle m_vertexShader;
+	RenderHandle m_pixelShader;
+	RenderHandle m_layout;
+	RenderHandle m_matrixBuffer;
+	RenderHandle m_vertexBuffer;
+	RenderHandle m_indexBuffer;
+	RenderHandle m_sampleState;
+	RenderHandle m_rasterizerState;
+	RenderHandle m_depthStencilState;
+	RenderHandle m_blendState;
+
+	int m_screenWidth;
+	int m_screenHeight;
+	int m_maxQuads;
+	int m_quadCount;
+
+	std::vector<AtlasType> m_atlases;
+	std::vector<VertexType> m_staging;
+	StatsType m_stats;
+};
+
+#endif
@@ -0,0 +1,337 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: startupschedulerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "startupschedulerclass.h"
+#include "profilerclass.h"
+#include <iomanip>
+
+StartupSchedulerClass::StartupSchedulerClass()
+	: m_jobs(nullptr)
+	, m_failedTask(-1)
+	, m_refused(false)
+	, m_totalTime(0.0f)
+{
+}
+
+StartupSchedulerClass::StartupSchedulerClass(const StartupSchedulerClass& other)
+{
+}
+
+
+StartupSchedulerClass::~StartupSchedulerClass()
+{
+}
+
+bool StartupSchedulerClass::Initialize(JobSystemClass* jobs)
+{
+	if (!jobs)
+	{
+		return false;
+	}
+
+	m_jobs = jobs;
+	m_tasks.clear();
+	m_failedTask = -1;
+	m_refused = false;
+	m_totalTime = 0.0f;
+
+	return true;
+}
+
+//Shutdown lets go of the task functions and whatever they hold on to, the timings are gone with them.
+
+void StartupSchedulerClass::Shutdown()
+{
+	m_tasks.clear();
+	m_runs.reset();
+	m_threads.clear();
+	m_failedTask = -1;
+	m_refused = false;
+	m_jobs = nullptr;
+
+	return;
+}
+
+int StartupSchedulerClass::AddTask(const char* name, LaneType lane, const TaskFunctionType& function, const std::vector<int>& dependencies)
+{
+	TaskType task;
+	int index;
+
+	index = (int)m_tasks.size();
+	for (auto dependency : dependencies)
+	{
+		if (dependency < 0 || dependency >= index)
+		{
+			m_refused = true;
+			return -1;
+		}
+	}
+
+	task.name = name;
+	task.lane = lane;
+	task.function = function;
+	task.dependencies = dependencies;
+	task.state = TASK_WAITING;
+	task.thread = -1;
+	task.start = 0.0f;
+	task.end = 0.0f;
+
+	for (auto dependency : dependencies)
+	{
+		m_tasks[dependency].successors.push_back(index);
+	}
+
+	m_tasks.push_back(task);
+
+	return index;
+}
+
+/*
+Run starts every CPU task as a job after its own counter, then runs the device tasks in order, each once its counter is down to zero.
+Waiting for a counter runs jobs, so this thread does CPU tasks in between. Last it waits for the CPU tasks nothing on the device lane
+waits for.
+*/
+
+bool StartupSchedulerClass::Run()
+{
+	if (m_refused || !m_jobs)
+	{
+		return false;
+	}
+
+	for (auto& task : m_tasks)
+	{
+		task.state = TASK_WAITING;
+		task.thread = -1;
+		task.start = 0.0f;
+		task.end = 0.0f;
+	}
+	m_failedTask = -1;
+	m_threads.assign(1, std::this_thread::get_id());
+
+	// Every counter is set before the first job starts, a task that finishes early cannot count down one that is not set yet.
+	m_runs.reset(new RunType[m_tasks.size()]);
+	for (auto i = 0; i < (int)m_tasks.size(); i++)
+	{
+		m_runs[i].scheduler = this;
+		m_runs[i].task = i;
+		m_jobs->Increment(&m_runs[i].pending, (int)m_tasks[i].dependencies.size());
+	}
+
+	m_start = std::chrono::high_resolution_clock::now();
+
+	for (auto i = 0; i < (int)m_tasks.size(); i++)
+	{
+		if (m_tasks[i].lane == LANE_CPU)
+		{
+			m_jobs->Run(TaskJob, &m_runs[i], &m_cpuCounter, &m_runs[i].pending);
+		}
+	}
+
+	for (auto i = 0; i < (int)m_tasks.size(); i++)
+	{
+		if (m_tasks[i].lane == LANE_DEVICE)
+		{
+			m_jobs->Wait(&m_runs[i].pending);
+			RunTask(i);
+		}
+	}
+
+	m_jobs->Wait(&m_cpuCounter);
+
+	m_totalTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - m_start).count();
+
+	return m_failedTask < 0;
+}
+
+int StartupSchedulerClass::GetTaskCount()
+{
+	return (int)m_tasks.size();
+}
+
+const char* StartupSchedulerClass::GetTaskName(int task)
+{
+	return task >= 0 && task < (int)m_tasks.size() ? m_tasks[task].name : "";
+}
+
+int StartupSchedulerClass::GetThreadCount()
+{
+	return m_jobs ? m_jobs->GetThreadCount() : 1;
+}
+
+const char* StartupSchedulerClass::GetFailedTask()
+{
+	return m_failedTask >= 0 ? m_tasks[m_failedTask].name : nullptr;
+}
+
+float StartupSchedulerClass::GetTotalTime()
+{
+	return m_totalTime;
+}
+
+float StartupSchedulerClass::GetSerialTime()
+{
+	float time;
+
+	time = 0.0f;
+	for (auto& task : m_tasks)
+	{
+		time += task.end - task.start;
+	}
+
+	return time;
+}
+
+//GetCriticalPath works like the task graph's: tasks only depend on tasks added before them, so one pass in order finds the longest chain.
+
+float StartupSchedulerClass::GetCriticalPath(std::vector<int>& path)
+{
+	std::vector<float> finish(m_tasks.size());
+	std::vector<int> previous(m_tasks.size());
+	int last;
+
+	path.clear();
+	if (m_tasks.empty())
+	{
+		return 0.0f;
+	}
+
+	last = 0;
+	for (auto i = 0; i < (int)m_tasks.size(); i++)
+	{
+		previous[i] = -1;
+		for (auto dependency : m_tasks[i].dependencies)
+		{
+			if (previous[i] < 0 || finish[dependency] > finish[previous[i]])
+			{
+				previous[i] = dependency;
+			}
+		}
+
+		finish[i] = (previous[i] >= 0 ? finish[previous[i]] : 0.0f) + m_tasks[i].end - m_tasks[i].start;
+		if (finish[i] > finish[last])
+		{
+			last = i;
+		}
+	}
+
+	for (auto task = last; task >= 0; task = previous[task])
+	{
+		path.insert(path.begin(), task);
+	}
+
+	return finish[last];
+}
+
+void StartupSchedulerClass::WriteTimeline(std::ostream& out)
+{
+	const char* STATES[] = { "waiting", "running", "done", "failed", "skipped" };
+	std::vector<int> path;
+	std::vector<bool> critical(m_tasks.size(), false);
+	float length;
+
+	length = GetCriticalPath(path);
+	for (auto task : path)
+	{
+		critical[task] = true;
+	}
+
+	out << "task,lane,thread,start ms,end ms,ms,state,critical" << std::endl;
+	out << std::fixed << std::setprecision(3);
+	for (auto i = 0; i < (int)m_tasks.size(); i++)
+	{
+		const TaskType& task = m_tasks[i];
+
+		out << task.name << "," << (task.lane == LANE_DEVICE ? "device" : "cpu") << "," << task.thread << "," << task.start << "," << task.end
+			<< "," << task.end - task.start << "," << STATES[task.state] << "," << (critical[i] ? 1 : 0) << std::endl;
+	}
+	out << "total,,," << 0.0f << "," << m_totalTime << "," << m_totalTime << ",," << std::endl;
+	out << "serial,,,,," << GetSerialTime() << ",," << std::endl;
+	out << "critical path,,,,," << length << ",," << std::endl;
+
+	return;
+}
+
+/*
+RunTask runs one task, or skips it when a task it depends on failed or was skipped itself, and then counts it off the tasks waiting for
+it, which starts the CPU ones whose counter drops to zero.
+*/
+
+void StartupSchedulerClass::RunTask(int index)
+{
+	std::chrono::high_resolution_clock::time_point start, end;
+	TaskType& task = m_tasks[index];
+	bool ready, result;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		ready = true;
+		for (auto dependency : task.dependencies)
+		{
+			if (m_tasks[dependency].state != TASK_DONE)
+			{
+				ready = false;
+			}
+		}
+
+		task.state = ready ? TASK_RUNNING : TASK_SKIPPED;
+		task.thread = ready ? GetThreadIndex() : -1;
+	}
+
+	if (ready)
+	{
+		start = std::chrono::high_resolution_clock::now();
+		{
+			PROFILE_SCOPE(task.name);
+			result = task.function();
+		}
+		end = std::chrono::high_resolution_clock::now();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		task.start = std::chrono::duration<float, std::milli>(start - m_start).count();
+		task.end = std::chrono::duration<float, std::milli>(end - m_start).count();
+		task.state = result ? TASK_DONE : TASK_FAILED;
+
+		if (!result && (m_failedTask < 0 || index < m_failedTask))
+		{
+			m_failedTask = index;
+		}
+	}
+
+	for (auto successor : task.successors)
+	{
+		m_jobs->Decrement(&m_runs[successor].pending);
+	}
+
+	return;
+}
+
+//GetThreadIndex numbers the threads in the order they first ran a task, the one that called Run is 0. Only call it under m_mutex.
+
+int StartupSchedulerClass::GetThreadIndex()
+{
+	std::thread::id thread = std::this_thread::get_id();
+
+	for (auto i = 0; i < (int)m_threads.size(); i++)
+	{
+		if (m_threads[i] == thread)
+		{
+			return i;
+		}
+	}
+
+	m_threads.push_back(thread);
+
+	return (int)m_threads.size() - 1;
+}
+
+void StartupSchedulerClass::TaskJob(void* data, int begin, int end)
+{
+	RunType* run = (RunType*)data;
+
+	run->scheduler->RunTask(run->task);
+
+	return;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: startupschedulerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _STARTUPSCHEDULERCLASS_H_
+#define _STARTUPSCHEDULERCLASS_H_
+
+/*
+The StartupSchedulerClass runs the engine's initialization as a set of tasks with dependencies between them, so loading a model,
+decoding its texture and compiling shaders no longer wait for each other or for the device. A task starts once every task it depends
+on has finished, Run returns when all of them have.
+
+Tasks are on one of two lanes. CPU tasks only touch their own data and run on any thread, as many at the same time as there are
+threads. Device tasks create things on the render device, which is not safe to use from two threads at once and on D3D11 belongs to
+the window's thread, so they only ever run on the thread that called Run, one after the other in the order they were added. While that
+thread waits for the next device task's dependencies it runs CPU tasks like any other worker.
+
+CPU tasks are jobs on the same JobSystemClass the frames run on, so loading never has more busy threads than cores and adds no threads
+of its own. Every task has a counter of the tasks it still waits for: a CPU task's job is started after its counter, and each task
+counts down the counters of the tasks waiting for it as it finishes. Run has to be called on the job system's main thread, which is
+where the device tasks run. A task that returns false fails Run, the tasks that depend on it are skipped and everything else still
+runs, so every failure gets reported.
+
+Every task is timed. WriteTimeline writes when each one ran and on which thread, together with the sum of all tasks, which is how long
+a serial startup would take, and the critical path, the longest chain of dependent tasks that bounds the startup however many threads
+run it.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <ostream>
+#include "jobsystemclass.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: StartupSchedulerClass
+////////////////////////////////////////////////////////////////////////////////
+class StartupSchedulerClass
+{
+public:
+	//a task returns false when it failed
+	typedef std::function<bool()> TaskFunctionType;
+
+	enum LaneType
+	{
+		LANE_CPU,
+		LANE_DEVICE
+	};
+
+private:
+	enum StateType
+	{
+		TASK_WAITING,
+		TASK_RUNNING,
+		TASK_DONE,
+		TASK_FAILED,
+		TASK_SKIPPED
+	};
+
+	//the state is only touched under m_mutex
+	struct TaskType
+	{
+		const char* name;
+		LaneType lane;
+		TaskFunctionType function;
+		std::vector<int> dependencies;
+		std::vector<int> successors;
+		StateType state;
+		int thread;
+		float start;
+		float end;
+	};
+
+	//a task's job data, made fresh for every Run. pending counts the tasks it still waits for.
+	struct RunType
+	{
+		StartupSchedulerClass* scheduler;
+		int task;
+		JobSystemClass::CounterType pending;
+	};
+
+public:
+	StartupSchedulerClass();
+	StartupSchedulerClass(const StartupSchedulerClass&);
+	~StartupSchedulerClass();
+
+	//the CPU tasks run as jobs on the given job system, with one thread all of them run on the calling thread
+	bool Initialize(JobSystemClass*);
+	void Shutdown();
+
+	//the name is a profiler scope as well and has to stay valid as long as the program runs. A task may only depend on tasks added
+	//before it, AddTask refuses any other with -1 and Run then fails straight away.
+	int AddTask(const char*, LaneType, const TaskFunctionType&, const std::vector<int>& = {});
+
+	//runs every task, false when one of them failed
+	bool Run();
+
+	int GetTaskCount();
+	const char* GetTaskName(int);
+	int GetThreadCount();
+
+	//the first task in the order they were added that failed, nullptr when none did
+	const char* GetFailedTask();
+
+	//milliseconds from the start of Run: when it returned, all tasks added up and the longest chain of dependent tasks
+	float GetTotalTime();
+	float GetSerialTime();
+	float GetCriticalPath(std::vector<int>&);
+
+	//writes one line per task: name, lane, thread, start and end ms, ms, how it ended and whether it is on the critical path
+	void WriteTimeline(std::ostream&);
+
+private:
+	void RunTask(int);
+	int GetThreadIndex();
+	static void TaskJob(void*, int, int);
+
+private:
+	JobSystemClass* m_jobs;
+	std::vector<TaskType> m_tasks;
+	std::unique_ptr<RunType[]> m_runs;
+	JobSystemClass::CounterType m_cpuCounter;
+	int m_failedTask;
+	bool m_refused;
+	float m_totalTime;
+	std::chrono::high_resolution_clock::time_point m_start;
+	std::mutex m_mutex;
+
+	//the threads that ran a task, the calling thread first, so the timeline can number them
+	std::vector<std::thread::id> m_threads;
+};
+
+#endif
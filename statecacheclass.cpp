@@ -0,0 +1,540 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: statecacheclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "statecacheclass.h"
+#include "hitchdetectorclass.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+const char* const StateCacheClass::KIND_NAMES[STATE_KIND_COUNT] = { "rasterizer", "depthstencil", "blend", "sampler", "inputlayout" };
+
+static const unsigned long long FNV_OFFSET = 14695981039346656037ull;
+static const unsigned long long FNV_PRIME = 1099511628211ull;
+
+StateCacheClass::StateCacheClass()
+	: m_device(nullptr)
+{
+	memset(m_stats, 0, sizeof(m_stats));
+}
+
+StateCacheClass::StateCacheClass(const StateCacheClass& other)
+{
+}
+
+
+StateCacheClass::~StateCacheClass()
+{
+}
+
+bool StateCacheClass::Initialize(RenderDeviceClass* device)
+{
+	if (!device)
+	{
+		return false;
+	}
+
+	m_device = device;
+	memset(m_stats, 0, sizeof(m_stats));
+
+	return true;
+}
+
+void StateCacheClass::Shutdown()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (auto& states : m_states)
+	{
+		for (auto& state : states)
+		{
+			if (m_device)
+			{
+				m_device->ReleaseResource(state.second);
+			}
+		}
+		states.clear();
+	}
+
+	for (auto& layout : m_layouts)
+	{
+		if (m_device)
+		{
+			m_device->ReleaseResource(layout.second);
+		}
+	}
+	m_layouts.clear();
+
+	m_device = nullptr;
+
+	return;
+}
+
+/*
+Get creates the state with the lock held, so two threads asking for the same new description at once still get one object. A failed
+creation is not cached, the next Get tries again.
+*/
+
+template <typename MapType, typename CreateType>
+RenderHandle StateCacheClass::Get(StateKind kind, MapType& states, const typename MapType::key_type& key, CreateType create)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	RenderHandle state;
+
+	if (!m_device)
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	m_stats[kind].requests++;
+
+	auto found = states.find(key);
+	if (found != states.end())
+	{
+		m_stats[kind].hits++;
+		return found->second;
+	}
+
+	// A miss while the frames are running is a likely hitch, so it is tracked as an activity.
+	{
+		TRACK_ACTIVITY("creating state", KIND_NAMES[kind]);
+		state = create();
+	}
+	if (state == RENDER_NULL_HANDLE)
+	{
+		m_stats[kind].failures++;
+		return RENDER_NULL_HANDLE;
+	}
+
+	states.emplace(key, state);
+	m_stats[kind].creations++;
+
+	return state;
+}
+
+RenderHandle StateCacheClass::GetRasterizerState(const RenderRasterizerDesc& desc)
+{
+	KeyType key;
+
+	MakeKey(desc, key);
+	return Get(STATE_RASTERIZER, m_states[STATE_RASTERIZER], key, [&]() { return m_device->CreateRasterizerState(desc); });
+}
+
+RenderHandle StateCacheClass::GetDepthStencilState(const RenderDepthStencilDesc& desc)
+{
+	KeyType key;
+
+	MakeKey(desc, key);
+	return Get(STATE_DEPTH_STENCIL, m_states[STATE_DEPTH_STENCIL], key, [&]() { return m_device->CreateDepthStencilState(desc); });
+}
+
+RenderHandle StateCacheClass::GetBlendState(const RenderBlendDesc& desc)
+{
+	KeyType key;
+
+	MakeKey(desc, key);
+	return Get(STATE_BLEND, m_states[STATE_BLEND], key, [&]() { return m_device->CreateBlendState(desc); });
+}
+
+RenderHandle StateCacheClass::GetSamplerState(const RenderSamplerDesc& desc)
+{
+	KeyType key;
+
+	MakeKey(desc, key);
+	return Get(STATE_SAMPLER, m_states[STATE_SAMPLER], key, [&]() { return m_device->CreateSamplerState(desc); });
+}
+
+//the semantic names go into the key by their text, two layouts built from different copies of "POSITION" are still the same. Layout keys
+//never go into a manifest so they do not need to be written out.
+
+RenderHandle StateCacheClass::GetInputLayout(const RenderInputElementDesc* elements, unsigned int elementCount, RenderHandle vertexShader)
+{
+	std::string key;
+
+	if (!elements || elementCount == 0)
+	{
+		return RENDER_NULL_HANDLE;
+	}
+
+	AppendField(key, (int)elementCount);
+	for (auto i = 0u; i < elementCount; i++)
+	{
+		key += elements[i].semanticName ? elements[i].semanticName : "";
+		key += '\0';
+		AppendField(key, (int)elements[i].semanticIndex);
+		AppendField(key, (int)elements[i].format);
+		AppendField(key, (int)elements[i].inputSlot);
+		AppendField(key, (int)elements[i].alignedByteOffset);
+	}
+
+	return Get(STATE_INPUT_LAYOUT, m_layouts, key, [&]() { return m_device->CreateInputLayout(elements, elementCount, vertexShader); });
+}
+
+bool StateCacheClass::LoadManifest(const char* filename)
+{
+	std::ifstream fin;
+	std::string line, name;
+	std::vector<double> fields;
+	double field;
+	int kind;
+	bool result;
+
+	fin.open(filename);
+	if (fin.fail())
+	{
+		return false;
+	}
+
+	while (std::getline(fin, line))
+	{
+		std::istringstream in(line);
+
+		// Empty lines and # comments are skipped.
+		if (!(in >> name) || name[0] == '#')
+		{
+			continue;
+		}
+
+		for (kind = 0; kind < STATE_INPUT_LAYOUT; kind++)
+		{
+			if (name == KIND_NAMES[kind])
+			{
+				break;
+			}
+		}
+
+		fields.clear();
+		while (in >> field)
+		{
+			fields.push_back(field);
+		}
+
+		if (kind == STATE_INPUT_LAYOUT || !in.eof())
+		{
+			return false;
+		}
+
+		result = LoadState((StateKind)kind, fields.data(), (int)fields.size());
+		if (!result)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool StateCacheClass::SaveManifest(const char* filename)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::ofstream fout;
+
+	fout.open(filename);
+	if (fout.fail())
+	{
+		return false;
+	}
+
+	fout << "# state manifest, see statecacheclass.h" << std::endl;
+	for (auto kind = 0; kind < STATE_INPUT_LAYOUT; kind++)
+	{
+		for (auto& state : m_states[kind])
+		{
+			fout << KIND_NAMES[kind];
+			WriteKey(fout, state.first);
+			fout << std::endl;
+		}
+	}
+
+	return !fout.fail();
+}
+
+int StateCacheClass::GetStateCount(StateKind kind)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (int)(kind == STATE_INPUT_LAYOUT ? m_layouts.size() : m_states[kind].size());
+}
+
+void StateCacheClass::GetStats(StateKind kind, StatsType& stats)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	stats = m_stats[kind];
+
+	return;
+}
+
+void StateCacheClass::ResetStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	memset(m_stats, 0, sizeof(m_stats));
+
+	return;
+}
+
+void StateCacheClass::WriteStats(std::ostream& out)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	StatsType total;
+
+	memset(&total, 0, sizeof(total));
+
+	out << "state,requests,hits,created,failed,cached,hit rate" << std::endl;
+	out << std::fixed << std::setprecision(3);
+	for (auto kind = 0; kind < STATE_KIND_COUNT; kind++)
+	{
+		const StatsType& stats = m_stats[kind];
+
+		out << KIND_NAMES[kind] << "," << stats.requests << "," << stats.hits << "," << stats.creations << "," << stats.failures << ","
+			<< (kind == STATE_INPUT_LAYOUT ? m_layouts.size() : m_states[kind].size()) << "," << (stats.requests > 0 ? (double)stats.hits / stats.requests : 0.0) << std::endl;
+
+		total.requests += stats.requests;
+		total.hits += stats.hits;
+		total.creations += stats.creations;
+		total.failures += stats.failures;
+	}
+	out << "total," << total.requests << "," << total.hits << "," << total.creations << "," << total.failures << ",,"
+		<< (total.requests > 0 ? (double)total.hits / total.requests : 0.0) << std::endl;
+
+	return;
+}
+
+void StateCacheClass::MakeKey(const RenderRasterizerDesc& desc, KeyType& key)
+{
+	ClearKey(key);
+	AppendField(key, (int)desc.fillMode);
+	AppendField(key, (int)desc.cullMode);
+	AppendField(key, (int)desc.frontCounterClockwise);
+	AppendField(key, desc.depthBias);
+	AppendField(key, desc.depthBiasClamp);
+	AppendField(key, desc.slopeScaledDepthBias);
+	AppendField(key, (int)desc.depthClipEnable);
+	AppendField(key, (int)desc.scissorEnable);
+	AppendField(key, (int)desc.multisampleEnable);
+	AppendField(key, (int)desc.antialiasedLineEnable);
+
+	return;
+}
+
+void StateCacheClass::MakeKey(const RenderDepthStencilDesc& desc, KeyType& key)
+{
+	const RenderStencilOpDesc* faces[2] = { &desc.frontFace, &desc.backFace };
+
+	ClearKey(key);
+	AppendField(key, (int)desc.depthEnable);
+	AppendField(key, (int)desc.depthWriteEnable);
+	AppendField(key, (int)desc.depthFunc);
+	AppendField(key, (int)desc.stencilEnable);
+	AppendField(key, (int)desc.stencilReadMask);
+	AppendField(key, (int)desc.stencilWriteMask);
+	for (auto face : faces)
+	{
+		AppendField(key, (int)face->stencilFailOp);
+		AppendField(key, (int)face->stencilDepthFailOp);
+		AppendField(key, (int)face->stencilPassOp);
+		AppendField(key, (int)face->stencilFunc);
+	}
+
+	return;
+}
+
+void StateCacheClass::MakeKey(const RenderBlendDesc& desc, KeyType& key)
+{
+	ClearKey(key);
+	AppendField(key, (int)desc.alphaToCoverageEnable);
+	AppendField(key, (int)desc.blendEnable);
+	AppendField(key, (int)desc.srcBlend);
+	AppendField(key, (int)desc.destBlend);
+	AppendField(key, (int)desc.blendOp);
+	AppendField(key, (int)desc.srcBlendAlpha);
+	AppendField(key, (int)desc.destBlendAlpha);
+	AppendField(key, (int)desc.blendOpAlpha);
+	AppendField(key, (int)desc.writeMask);
+
+	return;
+}
+
+void StateCacheClass::MakeKey(const RenderSamplerDesc& desc, KeyType& key)
+{
+	ClearKey(key);
+	AppendField(key, (int)desc.filter);
+	AppendField(key, (int)desc.addressU);
+	AppendField(key, (int)desc.addressV);
+	AppendField(key, (int)desc.addressW);
+	AppendField(key, desc.mipLODBias);
+	AppendField(key, (int)desc.maxAnisotropy);
+	AppendField(key, (int)desc.comparisonFunc);
+	for (auto color : desc.borderColor)
+	{
+		AppendField(key, color);
+	}
+	AppendField(key, desc.minLOD);
+	AppendField(key, desc.maxLOD);
+
+	return;
+}
+
+void StateCacheClass::ClearKey(KeyType& key)
+{
+	memset(&key, 0, sizeof(key));
+	key.hash = FNV_OFFSET;
+
+	return;
+}
+
+void StateCacheClass::AppendField(KeyType& key, int value)
+{
+	key.fields[key.fieldCount++] = (unsigned int)value;
+	key.hash = (key.hash ^ (unsigned int)value) * FNV_PRIME;
+
+	return;
+}
+
+void StateCacheClass::AppendField(KeyType& key, float value)
+{
+	unsigned int bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+	key.floatFields |= 1u << key.fieldCount;
+	key.fields[key.fieldCount++] = bits;
+	key.hash = (key.hash ^ bits) * FNV_PRIME;
+
+	return;
+}
+
+void StateCacheClass::AppendField(std::string& key, int value)
+{
+	key += 'i';
+	key.append((const char*)&value, sizeof(value));
+
+	return;
+}
+
+//9 significant digits are enough to read any float back exactly, so a manifest recreates the same key
+
+void StateCacheClass::WriteKey(std::ostream& out, const KeyType& key)
+{
+	char text[32];
+	float floatValue;
+
+	for (auto i = 0; i < key.fieldCount; i++)
+	{
+		if (key.floatFields & (1u << i))
+		{
+			memcpy(&floatValue, &key.fields[i], sizeof(floatValue));
+			snprintf(text, sizeof(text), " %.9g", floatValue);
+		}
+		else
+		{
+			snprintf(text, sizeof(text), " %d", (int)key.fields[i]);
+		}
+		out << text;
+	}
+
+	return;
+}
+
+bool StateCacheClass::LoadState(StateKind kind, const double* fields, int fieldCount)
+{
+	RenderRasterizerDesc rasterizerDesc;
+	RenderDepthStencilDesc depthStencilDesc;
+	RenderBlendDesc blendDesc;
+	RenderSamplerDesc samplerDesc;
+	RenderStencilOpDesc* faces[2] = { &depthStencilDesc.frontFace, &depthStencilDesc.backFace };
+	RenderHandle state;
+	int i;
+
+	i = 0;
+	switch (kind)
+	{
+	case STATE_RASTERIZER:
+		if (fieldCount != 10)
+		{
+			return false;
+		}
+		memset(&rasterizerDesc, 0, sizeof(rasterizerDesc));
+		rasterizerDesc.fillMode = (RenderFillMode)(int)fields[i++];
+		rasterizerDesc.cullMode = (RenderCullMode)(int)fields[i++];
+		rasterizerDesc.frontCounterClockwise = fields[i++] != 0;
+		rasterizerDesc.depthBias = (int)fields[i++];
+		rasterizerDesc.depthBiasClamp = (float)fields[i++];
+		rasterizerDesc.slopeScaledDepthBias = (float)fields[i++];
+		rasterizerDesc.depthClipEnable = fields[i++] != 0;
+		rasterizerDesc.scissorEnable = fields[i++] != 0;
+		rasterizerDesc.multisampleEnable = fields[i++] != 0;
+		rasterizerDesc.antialiasedLineEnable = fields[i++] != 0;
+		state = GetRasterizerState(rasterizerDesc);
+		break;
+
+	case STATE_DEPTH_STENCIL:
+		if (fieldCount != 14)
+		{
+			return false;
+		}
+		memset(&depthStencilDesc, 0, sizeof(depthStencilDesc));
+		depthStencilDesc.depthEnable = fields[i++] != 0;
+		depthStencilDesc.depthWriteEnable = fields[i++] != 0;
+		depthStencilDesc.depthFunc = (RenderComparison)(int)fields[i++];
+		depthStencilDesc.stencilEnable = fields[i++] != 0;
+		depthStencilDesc.stencilReadMask = (unsigned char)fields[i++];
+		depthStencilDesc.stencilWriteMask = (unsigned char)fields[i++];
+		for (auto face : faces)
+		{
+			face->stencilFailOp = (RenderStencilOp)(int)fields[i++];
+			face->stencilDepthFailOp = (RenderStencilOp)(int)fields[i++];
+			face->stencilPassOp = (RenderStencilOp)(int)fields[i++];
+			face->stencilFunc = (RenderComparison)(int)fields[i++];
+		}
+		state = GetDepthStencilState(depthStencilDesc);
+		break;
+
+	case STATE_BLEND:
+		if (fieldCount != 9)
+		{
+			return false;
+		}
+		memset(&blendDesc, 0, sizeof(blendDesc));
+		blendDesc.alphaToCoverageEnable = fields[i++] != 0;
+		blendDesc.blendEnable = fields[i++] != 0;
+		blendDesc.srcBlend = (RenderBlend)(int)fields[i++];
+		blendDesc.destBlend = (RenderBlend)(int)fields[i++];
+		blendDesc.blendOp = (RenderBlendOp)(int)fields[i++];
+		blendDesc.srcBlendAlpha = (RenderBlend)(int)fields[i++];
+		blendDesc.destBlendAlpha = (RenderBlend)(int)fields[i++];
+		blendDesc.blendOpAlpha = (RenderBlendOp)(int)fields[i++];
+		blendDesc.writeMask = (unsigned char)fields[i++];
+		state = GetBlendState(blendDesc);
+		break;
+
+	case STATE_SAMPLER:
+		if (fieldCount != 13)
+		{
+			return false;
+		}
+		memset(&samplerDesc, 0, sizeof(samplerDesc));
+		samplerDesc.filter = (RenderFilter)(int)fields[i++];
+		samplerDesc.addressU = (RenderTextureAddress)(int)fields[i++];
+		samplerDesc.addressV = (RenderTextureAddress)(int)fields[i++];
+		samplerDesc.addressW = (RenderTextureAddress)(int)fields[i++];
+		samplerDesc.mipLODBias = (float)fields[i++];
+		samplerDesc.maxAnisotropy = (unsigned int)fields[i++];
+		samplerDesc.comparisonFunc = (RenderComparison)(int)fields[i++];
+		for (auto& color : samplerDesc.borderColor)
+		{
+			color = (float)fields[i++];
+		}
+		samplerDesc.minLOD = (float)fields[i++];
+		samplerDesc.maxLOD = (float)fields[i++];
+		state = GetSamplerState(samplerDesc);
+		break;
+
+	default:
+		return false;
+	}
+
+	return state != RENDER_NULL_HANDLE;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: statecacheclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _STATECACHECLASS_H_
+#define _STATECACHECLASS_H_
+
+/*
+The StateCacheClass hands out the immutable state objects: rasterizer, depth stencil, blend and sampler states and input layouts. Every
+description is turned into a key made of its fields, one after the other, and looked up in a hash map per kind of state, so asking twice
+for the same description gets the same handle back and the device only ever creates one object for it. The fields are copied in one by
+one rather than hashing the description's bytes, so the padding between them does not matter. A key is a fixed size block of 32 bit
+fields, zero padded past the last one, that hashes itself as the fields go in and compares with one memcmp, so a lookup allocates
+nothing. The cache owns everything it hands out, the callers must not release the handles, Shutdown releases them all.
+
+SaveManifest writes a line per cached state, the name of the kind of state followed by its fields, and LoadManifest creates everything
+in a manifest, so loading the one the last run saved at startup creates every state before the first frame asks for it. The fields of
+each kind are in the order of its Render*Desc, bools and enums as numbers, floats with enough digits to read back the same:
+
+	rasterizer fillMode cullMode frontCounterClockwise depthBias depthBiasClamp slopeScaledDepthBias depthClipEnable scissorEnable
+		multisampleEnable antialiasedLineEnable
+	depthstencil depthEnable depthWriteEnable depthFunc stencilEnable stencilReadMask stencilWriteMask, then the four fields of
+		frontFace and of backFace
+	blend alphaToCoverageEnable blendEnable srcBlend destBlend blendOp srcBlendAlpha destBlendAlpha blendOpAlpha writeMask
+	sampler filter addressU addressV addressW mipLODBias maxAnisotropy comparisonFunc borderColor[0..3] minLOD maxLOD
+
+Input layouts are keyed by their elements alone, the first vertex shader that asks for one is the one it is validated against, so
+shaders sharing a layout have to take the same inputs. Their keys have the semantic names in them, so they are strings, and they stay out
+of the manifest since they need a shader to be created.
+
+Lookups take a lock, but a hit is cheap enough to ask for a state whenever one is needed instead of keeping the handle around.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+#include <unordered_map>
+#include <string>
+#include <mutex>
+#include <ostream>
+#include <cstring>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: StateCacheClass
+////////////////////////////////////////////////////////////////////////////////
+class StateCacheClass
+{
+public:
+	enum StateKind
+	{
+		STATE_RASTERIZER,
+		STATE_DEPTH_STENCIL,
+		STATE_BLEND,
+		STATE_SAMPLER,
+		STATE_INPUT_LAYOUT,
+		STATE_KIND_COUNT
+	};
+
+	//requests counts every Get, hits the ones that found the state already there, creations the ones that created it
+	struct StatsType
+	{
+		unsigned long long requests;
+		unsigned long long hits;
+		unsigned long long creations;
+		unsigned long long failures;
+	};
+
+public:
+	StateCacheClass();
+	StateCacheClass(const StateCacheClass&);
+	~StateCacheClass();
+
+	bool Initialize(RenderDeviceClass*);
+	void Shutdown();
+
+	//every Get returns RENDER_NULL_HANDLE when the device fails to create the state
+	RenderHandle GetRasterizerState(const RenderRasterizerDesc&);
+	RenderHandle GetDepthStencilState(const RenderDepthStencilDesc&);
+	RenderHandle GetBlendState(const RenderBlendDesc&);
+	RenderHandle GetSamplerState(const RenderSamplerDesc&);
+	//the elements, their count and the vertex shader to validate them against
+	RenderHandle GetInputLayout(const RenderInputElementDesc*, unsigned int, RenderHandle);
+
+	//LoadManifest fails when the file cannot be read or a line is not a state, the lines before it are still created
+	bool LoadManifest(const char*);
+	bool SaveManifest(const char*);
+
+	int GetStateCount(StateKind);
+	void GetStats(StateKind, StatsType&);
+	void ResetStats();
+	void WriteStats(std::ostream&);
+
+private:
+	//the depth stencil description has the most fields
+	static const int MAX_KEY_FIELDS = 14;
+
+	//the fields as 32 bit words, with a bit set in floatFields for every float, and the FNV-1a hash of the words so far
+	struct KeyType
+	{
+		unsigned long long hash;
+		unsigned int floatFields;
+		int fieldCount;
+		unsigned int fields[MAX_KEY_FIELDS];
+	};
+
+	struct KeyHashType
+	{
+		size_t operator()(const KeyType& key) const { return (size_t)key.hash; }
+	};
+
+	//everything past the last field is zero, so the whole key can be compared at once
+	struct KeyEqualType
+	{
+		bool operator()(const KeyType& left, const KeyType& right) const { return memcmp(&left, &right, sizeof(KeyType)) == 0; }
+	};
+
+private:
+	//looks the key up in the map of the kind and calls create when it is not there yet
+	template <typename MapType, typename CreateType>
+	RenderHandle Get(StateKind, MapType&, const typename MapType::key_type&, CreateType);
+
+	static void MakeKey(const RenderRasterizerDesc&, KeyType&);
+	static void MakeKey(const RenderDepthStencilDesc&, KeyType&);
+	static void MakeKey(const RenderBlendDesc&, KeyType&);
+	static void MakeKey(const RenderSamplerDesc&, KeyType&);
+	static void ClearKey(KeyType&);
+	static void AppendField(KeyType&, int);
+	static void AppendField(KeyType&, float);
+	//a layout key is a type byte and the field's 4 bytes per field, with the semantic names in between
+	static void AppendField(std::string&, int);
+	//writes a key out as manifest text
+	static void WriteKey(std::ostream&, const KeyType&);
+
+	//creates the state on one manifest line from the fields after its name
+	bool LoadState(StateKind, const double*, int);
+
+private:
+	static const char* const KIND_NAMES[STATE_KIND_COUNT];
+
+	RenderDeviceClass* m_device;
+	std::mutex m_mutex;
+	std::unordered_map<KeyType, RenderHandle, KeyHashType, KeyEqualType> m_states[STATE_INPUT_LAYOUT];
+	std::unordered_map<std::string, RenderHandle> m_layouts;
+	StatsType m_stats[STATE_KIND_COUNT];
+};
+
+#endif
@@ -0,0 +1,264 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: statefiltercontextclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "statefiltercontextclass.h"
+#include <cstring>
+
+StateFilterContextClass::StateFilterContextClass()
+	: m_target(nullptr)
+{
+	Invalidate();
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+StateFilterContextClass::StateFilterContextClass(const StateFilterContextClass& other)
+{
+}
+
+
+StateFilterContextClass::~StateFilterContextClass()
+{
+}
+
+void StateFilterContextClass::Initialize(RenderContextClass* target)
+{
+	m_target = target;
+	Invalidate();
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	return;
+}
+
+//every binding is plain data, clearing them all leaves known false everywhere
+
+void StateFilterContextClass::Invalidate()
+{
+	memset(&m_inputLayout, 0, sizeof(m_inputLayout));
+	memset(m_vertexBuffers, 0, sizeof(m_vertexBuffers));
+	memset(&m_indexBuffer, 0, sizeof(m_indexBuffer));
+	memset(&m_topology, 0, sizeof(m_topology));
+	memset(&m_vertexShader, 0, sizeof(m_vertexShader));
+	memset(m_vsConstantBuffers, 0, sizeof(m_vsConstantBuffers));
+	memset(&m_pixelShader, 0, sizeof(m_pixelShader));
+	memset(m_psConstantBuffers, 0, sizeof(m_psConstantBuffers));
+	memset(m_psTextures, 0, sizeof(m_psTextures));
+	memset(m_psSamplers, 0, sizeof(m_psSamplers));
+	memset(&m_rasterizerState, 0, sizeof(m_rasterizerState));
+	memset(&m_depthStencilState, 0, sizeof(m_depthStencilState));
+	memset(&m_blendState, 0, sizeof(m_blendState));
+
+	return;
+}
+
+RenderContextClass* StateFilterContextClass::GetTarget()
+{
+	return m_target;
+}
+
+const StateFilterContextClass::StatsType& StateFilterContextClass::GetStats()
+{
+	return m_stats;
+}
+
+void StateFilterContextClass::ResetStats()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	return;
+}
+
+bool StateFilterContextClass::UpdateBuffer(RenderHandle buffer, const void* data, unsigned int size)
+{
+	return m_target->UpdateBuffer(buffer, data, size);
+}
+
+bool StateFilterContextClass::UpdateBufferRegion(RenderHandle buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	return m_target->UpdateBufferRegion(buffer, offset, data, size);
+}
+
+bool StateFilterContextClass::WriteBuffer(RenderHandle buffer, unsigned int offset, const void* data, unsigned int size, RenderMap map)
+{
+	return m_target->WriteBuffer(buffer, offset, data, size, map);
+}
+
+void StateFilterContextClass::SetInputLayout(RenderHandle layout)
+{
+	if (!IsBound(m_inputLayout, layout, 0, 0))
+	{
+		m_target->SetInputLayout(layout);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetVertexBuffer(unsigned int slot, RenderHandle buffer, unsigned int stride, unsigned int offset)
+{
+	BindingType* binding = GetSlot(m_vertexBuffers, slot);
+
+	if (!binding || !IsBound(*binding, buffer, stride, offset))
+	{
+		m_target->SetVertexBuffer(slot, buffer, stride, offset);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetIndexBuffer(RenderHandle buffer, RenderFormat format, unsigned int offset)
+{
+	if (!IsBound(m_indexBuffer, buffer, (unsigned int)format, offset))
+	{
+		m_target->SetIndexBuffer(buffer, format, offset);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetPrimitiveTopology(RenderTopology topology)
+{
+	if (!IsBound(m_topology, RENDER_NULL_HANDLE, (unsigned int)topology, 0))
+	{
+		m_target->SetPrimitiveTopology(topology);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetVertexShader(RenderHandle shader)
+{
+	if (!IsBound(m_vertexShader, shader, 0, 0))
+	{
+		m_target->SetVertexShader(shader);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetVSConstantBuffer(unsigned int slot, RenderHandle buffer)
+{
+	BindingType* binding = GetSlot(m_vsConstantBuffers, slot);
+
+	if (!binding || !IsBound(*binding, buffer, 0, 0))
+	{
+		m_target->SetVSConstantBuffer(slot, buffer);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetPixelShader(RenderHandle shader)
+{
+	if (!IsBound(m_pixelShader, shader, 0, 0))
+	{
+		m_target->SetPixelShader(shader);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetPSConstantBuffer(unsigned int slot, RenderHandle buffer)
+{
+	BindingType* binding = GetSlot(m_psConstantBuffers, slot);
+
+	if (!binding || !IsBound(*binding, buffer, 0, 0))
+	{
+		m_target->SetPSConstantBuffer(slot, buffer);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetPSTexture(unsigned int slot, RenderHandle texture)
+{
+	BindingType* binding = GetSlot(m_psTextures, slot);
+
+	if (!binding || !IsBound(*binding, texture, 0, 0))
+	{
+		m_target->SetPSTexture(slot, texture);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetPSSampler(unsigned int slot, RenderHandle sampler)
+{
+	BindingType* binding = GetSlot(m_psSamplers, slot);
+
+	if (!binding || !IsBound(*binding, sampler, 0, 0))
+	{
+		m_target->SetPSSampler(slot, sampler);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetRasterizerState(RenderHandle state)
+{
+	if (!IsBound(m_rasterizerState, state, 0, 0))
+	{
+		m_target->SetRasterizerState(state);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetDepthStencilState(RenderHandle state, unsigned int stencilRef)
+{
+	if (!IsBound(m_depthStencilState, state, stencilRef, 0))
+	{
+		m_target->SetDepthStencilState(state, stencilRef);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::SetBlendState(RenderHandle state)
+{
+	if (!IsBound(m_blendState, state, 0, 0))
+	{
+		m_target->SetBlendState(state);
+	}
+
+	return;
+}
+
+void StateFilterContextClass::Draw(unsigned int vertexCount, unsigned int startVertex)
+{
+	m_target->Draw(vertexCount, startVertex);
+	return;
+}
+
+void StateFilterContextClass::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	m_target->DrawIndexed(indexCount, startIndex, baseVertex);
+	return;
+}
+
+bool StateFilterContextClass::IsBound(BindingType& binding, RenderHandle handle, unsigned int first, unsigned int second)
+{
+	if (binding.known && binding.handle == handle && binding.first == first && binding.second == second)
+	{
+		m_stats.filtered++;
+		return true;
+	}
+
+	binding.known = true;
+	binding.handle = handle;
+	binding.first = first;
+	binding.second = second;
+	m_stats.issued++;
+
+	return false;
+}
+
+//GetSlot returns nullptr for the slots that are not shadowed, those calls are counted as issued and passed on
+
+StateFilterContextClass::BindingType* StateFilterContextClass::GetSlot(BindingType* slots, unsigned int slot)
+{
+	if (slot >= SLOT_COUNT)
+	{
+		m_stats.issued++;
+		return nullptr;
+	}
+
+	return &slots[slot];
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: statefiltercontextclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _STATEFILTERCONTEXTCLASS_H_
+#define _STATEFILTERCONTEXTCLASS_H_
+
+/*
+The StateFilterContextClass sits in front of another render context and drops the state changes that would not change anything. It
+keeps a shadow copy of everything bound to the input assembler, the shaders and their constant buffers, textures and samplers, and the
+rasterizer, depth stencil and blend states, and only passes a Set call on when it binds something else than the shadow says is bound.
+Buffer updates and draws always go through. So a shader can go on setting its layout, shaders and sampler for every draw and only the
+first draw of a run pays for them.
+
+The shadow only knows what went through the filter. Invalidate forgets all of it, which has to be done whenever the context's state may
+have changed behind the filter's back: at the start of recording on a deferred context, which always starts out from the default state,
+and after other code used the context directly. Slots past SLOT_COUNT are not shadowed and always passed on.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "renderdeviceclass.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: StateFilterContextClass
+////////////////////////////////////////////////////////////////////////////////
+class StateFilterContextClass : public RenderContextClass
+{
+public:
+	//issued counts the Set calls passed on to the context, filtered the ones dropped
+	struct StatsType
+	{
+		unsigned long long issued;
+		unsigned long long filtered;
+	};
+
+private:
+	static const unsigned int SLOT_COUNT = 16;
+
+	//what one Set call bound, the meaning of the two values depends on the call: stride and offset, format and offset, stencil reference
+	struct BindingType
+	{
+		bool known;
+		RenderHandle handle;
+		unsigned int first;
+		unsigned int second;
+	};
+
+public:
+	StateFilterContextClass();
+	StateFilterContextClass(const StateFilterContextClass&);
+	~StateFilterContextClass();
+
+	//the context the calls are passed on to, starts out with an empty shadow
+	void Initialize(RenderContextClass*);
+	void Invalidate();
+
+	RenderContextClass* GetTarget();
+	const StatsType& GetStats();
+	void ResetStats();
+
+	bool UpdateBuffer(RenderHandle, const void*, unsigned int);
+	bool UpdateBufferRegion(RenderHandle, unsigned int, const void*, unsigned int);
+	bool WriteBuffer(RenderHandle, unsigned int, const void*, unsigned int, RenderMap);
+
+	void SetInputLayout(RenderHandle);
+	void SetVertexBuffer(unsigned int, RenderHandle, unsigned int, unsigned int);
+	void SetIndexBuffer(RenderHandle, RenderFormat, unsigned int);
+	void SetPrimitiveTopology(RenderTopology);
+
+	void SetVertexShader(RenderHandle);
+	void SetVSConstantBuffer(unsigned int, RenderHandle);
+
+	void SetPixelShader(RenderHandle);
+	void SetPSConstantBuffer(unsigned int, RenderHandle);
+	void SetPSTexture(unsigned int, RenderHandle);
+	void SetPSSampler(unsigned int, RenderHandle);
+
+	void SetRasterizerState(RenderHandle);
+	void SetDepthStencilState(RenderHandle, unsigned int);
+	void SetBlendState(RenderHandle);
+
+	void Draw(unsigned int, unsigned int);
+	void DrawIndexed(unsigned int, unsigned int, int);
+
+private:
+	//true when the binding already holds these values, otherwise it takes them and the call has to be passed on
+	bool IsBound(BindingType&, RenderHandle, unsigned int, unsigned int);
+	BindingType* GetSlot(BindingType*, unsigned int);
+
+private:
+	RenderContextClass* m_target;
+
+	BindingType m_inputLayout;
+	BindingType m_vertexBuffers[SLOT_COUNT];
+	BindingType m_indexBuffer;
+	BindingType m_topology;
+	BindingType m_vertexShader;
+	BindingType m_vsConstantBuffers[SLOT_COUNT];
+	BindingType m_pixelShader;
+	BindingType m_psConstantBuffers[SLOT_COUNT];
+	BindingType m_psTextures[SLOT_COUNT];
+	BindingType m_psSamplers[SLOT_COUNT];
+	BindingType m_rasterizerState;
+	BindingType m_depthStencilState;
+	BindingType m_blendState;
+
+	StatsType m_stats;
+};
+
+#endif
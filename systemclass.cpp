@@ -1,9 +1,16 @@
 #include "systemclass.h"
+#include "profilerclass.h"
+#include "memorytrackerclass.h"
+#include <fstream>
 #define BACKWARD 0x73
 
 SystemClass::SystemClass()
 	: m_Input(nullptr)
 	, m_Graphics(nullptr)
+	, m_Pacer(nullptr)
+	, m_Hitches(nullptr)
+	, m_stopRendering(false)
+	, m_renderFailed(false)
 {
 	
 }
@@ -20,6 +27,7 @@ SystemClass::~SystemClass()
 bool SystemClass::Initialize()
 {
 	int screenWidth, screenHeight;
+	std::ofstream fout;
 	auto result = false;
 
 
@@ -27,6 +35,13 @@ bool SystemClass::Initialize()
 	screenWidth = 0;
 	screenHeight = 0;
 
+	// Start the profiler's clock and name this thread in the trace.
+	ProfilerClass::Initialize();
+	PROFILE_THREAD_NAME("main thread");
+
+	// Set the memory budgets, without the file nothing has one.
+	MemoryTrackerClass::LoadBudgets(MEMORY_BUDGET_FILE);
+
 	// Initialize the windows api.
 	InitializeWindows(screenWidth, screenHeight);
 
@@ -49,23 +64,89 @@ bool SystemClass::Initialize()
 
 	// Initialize the graphics object.
 	result = m_Graphics->Initialize(screenWidth, screenHeight, m_hwnd);
+
+	// When every startup task ran, written whether or not it worked so a failed startup shows which task failed and what it held up.
+	if (m_Graphics->GetStartup())
+	{
+		fout.open(STARTUP_TIMELINE_FILE);
+		m_Graphics->GetStartup()->WriteTimeline(fout);
+		fout.close();
+	}
+
+	if (!result)
+	{
+		return false;
+	}
+
+	// Create the frame pacer, it runs the simulation in fixed steps however fast the frames come.
+	m_Pacer.reset(new FramePacerClass());
+	if (!m_Pacer)
+	{
+		return false;
+	}
+
+	result = m_Pacer->Initialize(SIMULATION_STEP, FRAME_RATE_LIMIT, MAX_SIMULATION_STEPS);
 	if (!result)
 	{
 		return false;
 	}
 
+	// Create the hitch detector, it watches the frame times from here on.
+	if (HITCH_DETECTION_ENABLED)
+	{
+		m_Hitches.reset(new HitchDetectorClass());
+		if (!m_Hitches)
+		{
+			return false;
+		}
+
+		result = m_Hitches->Initialize(HITCH_WINDOW_SECONDS, HITCH_THRESHOLD_RATIO, HITCH_THRESHOLD_MS, HITCH_DUMP_PREFIX);
+		if (!result)
+		{
+			return false;
+		}
+	}
+
 	return true;
 }
 
 void SystemClass::Shutdown()
 {
+	std::ofstream fout;
+
+	if (m_Hitches)
+	{
+		m_Hitches->Shutdown();
+	}
+
+	if (m_Pacer)
+	{
+		m_Pacer->Shutdown();
+	}
+
 	if (m_Graphics)
 	{
+		// The latency percentiles of the whole run, before the graphics object lets go of them.
+		if (m_Graphics->GetLatency())
+		{
+			fout.open(LATENCY_FILE);
+			m_Graphics->GetLatency()->WriteCSV(fout);
+			fout.close();
+		}
+
 		m_Graphics->Shutdown();
 	}
 
 	ShutdownWindows();
 
+	// Everything was shut down, whatever is still tracked leaked.
+	MemoryTrackerClass::WriteLeakFile(MEMORY_LEAK_FILE);
+
+#ifdef PROFILER_ENABLED
+	// Everything the profiler still holds goes to the trace file.
+	ProfilerClass::WriteTraceFile(PROFILE_TRACE_FILE);
+#endif
+
 	return;
 }
 
@@ -77,15 +158,30 @@ void SystemClass::Run()
 	//init the message structure
 	ZeroMemory(&msg, sizeof(MSG));
 
+	//start the render thread, from here on this thread only runs the message pump and the simulation. The render thread waits for the
+	//frame graph's jobs from now on, so it takes this thread's place in the job system before the first snapshot is published.
+	if (RENDER_THREAD_ENABLED)
+	{
+		m_Snapshots.Initialize(FRAME_PIPELINE_DEPTH);
+		m_stopRendering = false;
+		m_renderFailed = false;
+		m_renderThread = std::thread(&SystemClass::RenderThread, this);
+		m_Graphics->SetRenderThread(m_renderThread.get_id());
+	}
+
 	//loop until there is a quit message from the user or window
 	done = false;
 	while (!done) 
 	{
-		//handle the window messages
-		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+		//handle all the window messages that came in since the last frame, the pacer keeps the loop from spinning between frames
+		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 		{
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
+			if (msg.message == WM_QUIT)
+			{
+				break;
+			}
 		}
 
 		// If windows signals to end the application then exit out.
@@ -105,13 +201,63 @@ void SystemClass::Run()
 
 	}
 
+	// Let the render thread finish the frame it is on and wait for it to leave, it may be asleep waiting for a snapshot.
+	if (m_renderThread.joinable())
+	{
+		m_stopRendering = true;
+		m_Snapshots.Notify();
+		m_renderThread.join();
+	}
+
+	return;
+}
+
+//RenderThread renders the newest snapshot the simulation published, over and over until Run tells it to stop. In between it sleeps
+//until the simulation publishes the next one.
+
+void SystemClass::RenderThread()
+{
+	const GraphicsClass::SnapshotType* snapshot;
+	bool result;
+
+	PROFILE_THREAD_NAME("render thread");
+
+	while (!m_stopRendering)
+	{
+		snapshot = m_Snapshots.WaitForSnapshot(m_stopRendering);
+		if (!snapshot)
+		{
+			// Run stopped the thread while it waited.
+			continue;
+		}
+
+		result = m_Graphics->Render(*snapshot);
+		m_Snapshots.Complete();
+
+		if (!result)
+		{
+			// The simulation may be waiting for this frame to complete, wake it so it sees the failure.
+			m_renderFailed = true;
+			m_Snapshots.Notify();
+			break;
+		}
+	}
+
 	return;
 }
 
 bool SystemClass::Frame()
 {
 	auto result = false;
+	int steps;
+	float alpha;
+
+	PROFILE_SCOPE("SystemClass::Frame");
 
+	// Take the key events queued since the last frame, the frame started now acts on all of them and carries the newest one's time
+	// to its present.
+	m_Input->Frame();
+	m_Graphics->SetInputTime(m_Input->GetLastEventTime());
 
 	// Check if the user pressed escape and wants to exit the application.
 	if (m_Input->IsKeyDown(VK_ESCAPE))
@@ -126,13 +272,52 @@ bool SystemClass::Frame()
 		lcam->SetPosition(temp.x, temp.y, temp.z - 10);
 	}
 
-	// Do the frame processing for the graphics object.
-	result = m_Graphics->Frame();
-	if (!result)
+	// Show or hide the performance overlay every time F3 goes down.
+	if (m_Input->GetPressCount(VK_F3) % 2 == 1)
+	{
+		m_Graphics->SetHudVisible(!m_Graphics->IsHudVisible());
+	}
+
+	// Take the simulation steps for the time that passed since the last frame.
+	steps = m_Pacer->BeginFrame();
+	alpha = m_Pacer->GetAlpha();
+
+	// The last frame ended here, the hitch detector measures from one BeginFrame to the next.
+	if (m_Hitches)
+	{
+		m_Hitches->Frame();
+		m_Hitches->SetFrameStat("simulation steps", (float)steps);
+	}
+
+	// Without a render thread the graphics object runs the whole frame, simulation included, as a task graph on its job system.
+	if (!RENDER_THREAD_ENABLED)
+	{
+		result = m_Graphics->Frame(steps, alpha);
+		if (!result)
+		{
+			return false;
+		}
+
+		m_Pacer->EndFrame();
+
+		return true;
+	}
+
+	// Stop if the render thread ran into an error, otherwise wait until it is close enough behind to start a new frame.
+	result = m_Snapshots.WaitForConsumer(m_renderFailed);
+	if (!result || m_renderFailed)
 	{
 		return false;
 	}
 
+	// Simulate the next frame into the snapshot slot the render thread is not using and hand it over.
+	GraphicsClass::SnapshotType& snapshot = m_Snapshots.GetWriteSlot();
+	m_Graphics->Update(snapshot, steps, alpha);
+	m_Snapshots.Publish(snapshot.frame);
+
+	// Wait out the rest of the frame.
+	m_Pacer->EndFrame();
+
 	return true;
 }
 
@@ -144,7 +329,7 @@ LRESULT CALLBACK SystemClass::MessageHandler(HWND hwnd, UINT umsg, WPARAM wparam
 	case WM_KEYDOWN:
 	{
 		// If a key is pressed send it to the input object so it can record that state.
-		m_Input->KeyDown((unsigned int)wparam);
+		m_Input->KeyDown((unsigned int)wparam, LatencyTrackerClass::GetTime());
 		return 0;
 	}
 
@@ -152,7 +337,7 @@ LRESULT CALLBACK SystemClass::MessageHandler(HWND hwnd, UINT umsg, WPARAM wparam
 	case WM_KEYUP:
 	{
 		// If a key is released then send it to the input object so it can unset the state for that key.
-		m_Input->KeyUp((unsigned int)wparam);
+		m_Input->KeyUp((unsigned int)wparam, LatencyTrackerClass::GetTime());
 		return 0;
 	}
 
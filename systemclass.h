@@ -16,9 +16,14 @@
 //////////////
 #include <windows.h>
 #include <memory>
+#include <thread>
+#include <atomic>
 
 #include "inputclass.h"
 #include "graphicsclass.h"
+#include "snapshotexchangeclass.h"
+#include "framepacerclass.h"
+#include "hitchdetectorclass.h"
 
 
 class SystemClass {
@@ -35,6 +40,7 @@ public:
 
 private:
 	bool Frame();
+	void RenderThread();
 	void InitializeWindows(int&, int&);
 	void ShutdownWindows();
 
@@ -46,6 +52,18 @@ private:
 	std::unique_ptr<InputClass> m_Input;
 	std::unique_ptr<GraphicsClass> m_Graphics;
 
+	//hands out the fixed simulation steps and holds the loop to FRAME_RATE_LIMIT, see graphicsclass.h
+	std::unique_ptr<FramePacerClass> m_Pacer;
+
+	//dumps the last few seconds when a frame takes far longer than the ones before, null when HITCH_DETECTION_ENABLED is off
+	std::unique_ptr<HitchDetectorClass> m_Hitches;
+
+	//the render thread draws the snapshots Frame publishes, see RENDER_THREAD_ENABLED and FRAME_PIPELINE_DEPTH in graphicsclass.h
+	std::thread m_renderThread;
+	SnapshotExchangeClass<GraphicsClass::SnapshotType> m_Snapshots;
+	std::atomic<bool> m_stopRendering;
+	std::atomic<bool> m_renderFailed;
+
 
 };
 
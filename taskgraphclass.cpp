@@ -0,0 +1,469 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: taskgraphclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "taskgraphclass.h"
+#include "profilerclass.h"
+#include <iomanip>
+
+TaskGraphClass::TaskGraphClass()
+	: m_jobs(nullptr)
+	, m_frames(nullptr)
+	, m_framesInFlight(1)
+	, m_nextFrame(1)
+	, m_collectedFrames(0)
+{
+}
+
+TaskGraphClass::TaskGraphClass(const TaskGraphClass& other)
+{
+}
+
+
+TaskGraphClass::~TaskGraphClass()
+{
+}
+
+//Initialize takes the job system the stages run on and how many frames may be in flight at once, 1 runs the frames one after another.
+
+bool TaskGraphClass::Initialize(JobSystemClass* jobs, int framesInFlight)
+{
+	if (!jobs)
+	{
+		return false;
+	}
+
+	m_jobs = jobs;
+	m_framesInFlight = framesInFlight > 0 ? framesInFlight : 1;
+	m_nextFrame = 1;
+	m_collectedFrames = 0;
+
+	return true;
+}
+
+void TaskGraphClass::Shutdown()
+{
+	Flush();
+
+	m_frames.reset();
+	m_stages.clear();
+	m_jobs = nullptr;
+
+	return;
+}
+
+int TaskGraphClass::AddStage(const char* name, const StageFunctionType& function)
+{
+	StageType stage;
+
+	if (m_frames)
+	{
+		return -1;
+	}
+
+	stage.name = name;
+	stage.function = function;
+	stage.totalTime = 0.0f;
+	stage.lastStart = 0.0f;
+	stage.lastEnd = 0.0f;
+
+	// Every stage waits for its own run of the previous frame.
+	stage.frameSuccessors.push_back((int)m_stages.size());
+
+	m_stages.push_back(stage);
+
+	return (int)m_stages.size() - 1;
+}
+
+bool TaskGraphClass::AddDependency(int stage, int dependency)
+{
+	if (m_frames || stage < 0 || stage >= (int)m_stages.size() || dependency < 0 || dependency >= stage)
+	{
+		return false;
+	}
+
+	m_stages[stage].dependencies.push_back(dependency);
+	m_stages[dependency].successors.push_back(stage);
+
+	return true;
+}
+
+bool TaskGraphClass::AddFrameDependency(int stage, int dependency)
+{
+	if (m_frames || stage < 0 || stage >= (int)m_stages.size() || dependency < 0 || dependency >= (int)m_stages.size() || dependency == stage)
+	{
+		return false;
+	}
+
+	m_stages[stage].frameDependencies.push_back(dependency);
+	m_stages[dependency].frameSuccessors.push_back(stage);
+
+	return true;
+}
+
+/*
+BeginFrame works out how many stages every stage of the new frame waits for: its dependencies within the frame, plus its own and its
+frame dependencies' runs of the previous frame that are not done yet. This happens under m_mutex, the same lock the stages of the
+previous frame take when they finish and count themselves off the new frame, so each of them is counted exactly once.
+*/
+
+int TaskGraphClass::BeginFrame()
+{
+	std::vector<int> ready;
+	int slot, previous, stageCount;
+	bool result;
+
+	if (!m_frames)
+	{
+		result = CreateFrames();
+		if (!result)
+		{
+			return -1;
+		}
+	}
+
+	stageCount = (int)m_stages.size();
+	slot = (int)(m_nextFrame % (unsigned long long)m_framesInFlight);
+	previous = (int)((m_nextFrame - 1) % (unsigned long long)m_framesInFlight);
+	FrameType& frame = m_frames[slot];
+
+	// The slot is only free once the frame that used it before is done.
+	if (frame.frame != 0)
+	{
+		WaitFrame(slot);
+	}
+
+	frame.start = std::chrono::high_resolution_clock::now();
+	frame.collected = false;
+	m_jobs->Increment(&frame.counter, stageCount);
+	for (auto i = 0; i < stageCount; i++)
+	{
+		frame.instances[i].done = false;
+		m_jobs->Increment(&frame.instances[i].counter, 1);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		frame.frame = m_nextFrame;
+
+		for (auto i = 0; i < stageCount; i++)
+		{
+			InstanceType& instance = frame.instances[i];
+
+			instance.pending = (int)m_stages[i].dependencies.size();
+
+			// With a single slot the previous frame was waited for above.
+			if (previous != slot && m_frames[previous].frame == m_nextFrame - 1)
+			{
+				if (!m_frames[previous].instances[i].done)
+				{
+					instance.pending++;
+				}
+
+				for (auto dependency : m_stages[i].frameDependencies)
+				{
+					if (!m_frames[previous].instances[dependency].done)
+					{
+						instance.pending++;
+					}
+				}
+			}
+
+			if (instance.pending == 0)
+			{
+				ready.push_back(i);
+			}
+		}
+	}
+
+	m_nextFrame++;
+
+	for (auto stage : ready)
+	{
+		Launch(slot, stage);
+	}
+
+	return slot;
+}
+
+int TaskGraphClass::GetNextSlot()
+{
+	return (int)(m_nextFrame % (unsigned long long)m_framesInFlight);
+}
+
+//WaitStage and WaitFrame run jobs on the calling thread until the stage or the whole frame in the slot is done.
+
+void TaskGraphClass::WaitStage(int slot, int stage)
+{
+	if (!m_frames || slot < 0 || slot >= m_framesInFlight || stage < 0 || stage >= (int)m_stages.size())
+	{
+		return;
+	}
+
+	m_jobs->Wait(&m_frames[slot].instances[stage].counter);
+
+	return;
+}
+
+void TaskGraphClass::WaitFrame(int slot)
+{
+	if (!m_frames || slot < 0 || slot >= m_framesInFlight)
+	{
+		return;
+	}
+
+	m_jobs->Wait(&m_frames[slot].counter);
+	CollectTimings(slot);
+
+	return;
+}
+
+//Flush waits for every frame in flight, oldest first so the timings of the newest frame end up as the last frame's.
+
+void TaskGraphClass::Flush()
+{
+	unsigned long long first;
+
+	if (!m_frames)
+	{
+		return;
+	}
+
+	first = m_nextFrame > (unsigned long long)m_framesInFlight ? m_nextFrame - m_framesInFlight : 1;
+	for (auto frame = first; frame < m_nextFrame; frame++)
+	{
+		WaitFrame((int)(frame % (unsigned long long)m_framesInFlight));
+	}
+
+	return;
+}
+
+int TaskGraphClass::GetStageCount()
+{
+	return (int)m_stages.size();
+}
+
+const char* TaskGraphClass::GetStageName(int stage)
+{
+	return m_stages[stage].name;
+}
+
+unsigned long long TaskGraphClass::GetFrameCount()
+{
+	return m_nextFrame - 1;
+}
+
+float TaskGraphClass::GetStageTime(int stage)
+{
+	return m_collectedFrames > 0 ? m_stages[stage].totalTime / (float)m_collectedFrames : 0.0f;
+}
+
+float TaskGraphClass::GetLastStageTime(int stage)
+{
+	return m_stages[stage].lastEnd - m_stages[stage].lastStart;
+}
+
+/*
+GetCriticalPath finds the chain of dependent stages with the largest total average time. Stages only depend on stages added before
+them, so one pass in order works out the longest chain ending at every stage.
+*/
+
+float TaskGraphClass::GetCriticalPath(std::vector<int>& path)
+{
+	std::vector<float> finish(m_stages.size());
+	std::vector<int> previous(m_stages.size());
+	int last;
+
+	path.clear();
+	if (m_stages.empty())
+	{
+		return 0.0f;
+	}
+
+	last = 0;
+	for (auto i = 0; i < (int)m_stages.size(); i++)
+	{
+		previous[i] = -1;
+		finish[i] = 0.0f;
+		for (auto dependency : m_stages[i].dependencies)
+		{
+			if (previous[i] < 0 || finish[dependency] > finish[previous[i]])
+			{
+				previous[i] = dependency;
+			}
+		}
+
+		finish[i] = (previous[i] >= 0 ? finish[previous[i]] : 0.0f) + GetStageTime(i);
+		if (finish[i] > finish[last])
+		{
+			last = i;
+		}
+	}
+
+	for (auto stage = last; stage >= 0; stage = previous[stage])
+	{
+		path.insert(path.begin(), stage);
+	}
+
+	return finish[last];
+}
+
+void TaskGraphClass::WriteTimings(std::ostream& out)
+{
+	std::vector<int> path;
+	std::vector<bool> critical(m_stages.size(), false);
+	float length;
+
+	length = GetCriticalPath(path);
+	for (auto stage : path)
+	{
+		critical[stage] = true;
+	}
+
+	out << "stage,average ms,last start ms,last end ms,critical" << std::endl;
+	out << std::fixed << std::setprecision(3);
+	for (auto i = 0; i < (int)m_stages.size(); i++)
+	{
+		out << m_stages[i].name << "," << GetStageTime(i) << "," << m_stages[i].lastStart << "," << m_stages[i].lastEnd << ","
+			<< (critical[i] ? 1 : 0) << std::endl;
+	}
+	out << "critical path," << length << ",,," << std::endl;
+
+	return;
+}
+
+bool TaskGraphClass::CreateFrames()
+{
+	if (!m_jobs || m_stages.empty())
+	{
+		return false;
+	}
+
+	m_frames.reset(new FrameType[m_framesInFlight]);
+	for (auto i = 0; i < m_framesInFlight; i++)
+	{
+		m_frames[i].frame = 0;
+		m_frames[i].collected = true;
+		m_frames[i].instances.reset(new InstanceType[m_stages.size()]);
+
+		for (auto j = 0; j < (int)m_stages.size(); j++)
+		{
+			InstanceType& instance = m_frames[i].instances[j];
+
+			instance.graph = this;
+			instance.slot = i;
+			instance.stage = j;
+			instance.pending = 0;
+			instance.done = true;
+			instance.start = 0.0f;
+			instance.end = 0.0f;
+		}
+	}
+
+	return true;
+}
+
+void TaskGraphClass::Launch(int slot, int stage)
+{
+	m_jobs->Run(StageJob, &m_frames[slot].instances[stage], nullptr);
+	return;
+}
+
+/*
+RunStage runs one stage of one frame and then counts it off the stages waiting for it: its successors in the same frame and, if the next
+frame has already begun, its frame successors there. Whatever drops to zero is started right away on this worker.
+*/
+
+void TaskGraphClass::RunStage(int slot, int stage)
+{
+	std::chrono::high_resolution_clock::time_point start, end;
+	std::vector<int> ready, readyNext;
+	FrameType& frame = m_frames[slot];
+	InstanceType& instance = frame.instances[stage];
+	int next;
+
+	start = std::chrono::high_resolution_clock::now();
+	{
+		PROFILE_SCOPE(m_stages[stage].name);
+		m_stages[stage].function(slot);
+	}
+	end = std::chrono::high_resolution_clock::now();
+
+	instance.start = std::chrono::duration<float, std::milli>(start - frame.start).count();
+	instance.end = std::chrono::duration<float, std::milli>(end - frame.start).count();
+
+	next = (slot + 1) % m_framesInFlight;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		instance.done = true;
+
+		for (auto successor : m_stages[stage].successors)
+		{
+			if (--frame.instances[successor].pending == 0)
+			{
+				ready.push_back(successor);
+			}
+		}
+
+		if (next != slot && m_frames[next].frame == frame.frame + 1)
+		{
+			for (auto successor : m_stages[stage].frameSuccessors)
+			{
+				if (--m_frames[next].instances[successor].pending == 0)
+				{
+					readyNext.push_back(successor);
+				}
+			}
+		}
+	}
+
+	for (auto successor : ready)
+	{
+		Launch(slot, successor);
+	}
+
+	for (auto successor : readyNext)
+	{
+		Launch(next, successor);
+	}
+
+	m_jobs->Decrement(&instance.counter);
+	m_jobs->Decrement(&frame.counter);
+
+	return;
+}
+
+//CollectTimings adds a finished frame's stage times to the averages, once per frame.
+
+void TaskGraphClass::CollectTimings(int slot)
+{
+	FrameType& frame = m_frames[slot];
+
+	if (frame.collected || frame.frame == 0)
+	{
+		return;
+	}
+
+	for (auto i = 0; i < (int)m_stages.size(); i++)
+	{
+		m_stages[i].totalTime += frame.instances[i].end - frame.instances[i].start;
+		m_stages[i].lastStart = frame.instances[i].start;
+		m_stages[i].lastEnd = frame.instances[i].end;
+	}
+
+	frame.collected = true;
+	m_collectedFrames++;
+
+	return;
+}
+
+void TaskGraphClass::StageJob(void* data, int begin, int end)
+{
+	InstanceType* instance = (InstanceType*)data;
+
+	instance->graph->RunStage(instance->slot, instance->stage);
+
+	return;
+}
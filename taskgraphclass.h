@@ -0,0 +1,133 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Filename: taskgraphclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TASKGRAPHCLASS_H_
+#define _TASKGRAPHCLASS_H_
+
+/*
+The TaskGraphClass runs a frame as a set of stages with dependencies between them instead of one fixed sequence. Every stage is a job
+on the JobSystemClass, it starts as soon as the stages it depends on are finished, so stages that do not depend on each other run at
+the same time on different cores.
+
+Several frames can be in flight at once. Each frame gets a slot (0 to framesInFlight - 1) that the stage functions are called with, so
+every frame can keep its data apart from the others. A stage never overlaps its own run of the previous frame, but it does not wait for
+anything else of the previous frame unless told to with AddFrameDependency. That way the first stages of the next frame can already
+run while the last stages of this one are still busy. BeginFrame starts a frame, waiting first for the frame that used the slot before.
+
+Every stage run is timed. Once a frame is finished its timings are added to the per stage averages, and WriteTimings writes them out
+together with the longest chain of dependent stages, the critical path that bounds how short a frame can be however many cores run it.
+*/
+
+//////////////
+// INCLUDES //
+//////////////
+#include "jobsystemclass.h"
+#include <vector>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TaskGraphClass
+////////////////////////////////////////////////////////////////////////////////
+class TaskGraphClass
+{
+public:
+	//a stage gets the slot of the frame it runs for
+	typedef std::function<void(int)> StageFunctionType;
+
+private:
+	struct StageType
+	{
+		const char* name;
+		StageFunctionType function;
+		std::vector<int> dependencies;
+		std::vector<int> successors;
+		std::vector<int> frameSuccessors;
+		std::vector<int> frameDependencies;
+		float totalTime;
+		float lastStart;
+		float lastEnd;
+	};
+
+	//one stage of one frame. pending counts the stages it still waits for and is only touched under m_mutex.
+	struct InstanceType
+	{
+		TaskGraphClass* graph;
+		int slot;
+		int stage;
+		int pending;
+		bool done;
+		float start;
+		float end;
+		JobSystemClass::CounterType counter;
+	};
+
+	struct FrameType
+	{
+		unsigned long long frame;
+		bool collected;
+		std::chrono::high_resolution_clock::time_point start;
+		std::unique_ptr<InstanceType[]> instances;
+		JobSystemClass::CounterType counter;
+	};
+
+public:
+	TaskGraphClass();
+	TaskGraphClass(const TaskGraphClass&);
+	~TaskGraphClass();
+
+	bool Initialize(JobSystemClass*, int);
+	void Shutdown();
+
+	//stages can only be added before the first frame, a stage may only depend on stages added before it. The name is a profiler scope
+	//as well, the profiler keeps it after the graph is gone, so it has to stay valid as long as the program runs.
+	int AddStage(const char*, const StageFunctionType&);
+	bool AddDependency(int, int);
+
+	//the stage waits for the other stage of the previous frame as well, on top of its own run of the previous frame
+	bool AddFrameDependency(int, int);
+
+	//starts the next frame and returns its slot, GetNextSlot tells which slot that is going to be
+	int BeginFrame();
+	int GetNextSlot();
+	void WaitStage(int, int);
+	void WaitFrame(int);
+	void Flush();
+
+	int GetStageCount();
+	const char* GetStageName(int);
+	unsigned long long GetFrameCount();
+
+	//average milliseconds of a stage and the stages of the critical path, over every frame finished so far
+	float GetStageTime(int);
+	float GetCriticalPath(std::vector<int>&);
+
+	//milliseconds a stage took in the last finished frame
+	float GetLastStageTime(int);
+
+	//writes one line per stage: name, average ms, start and end ms within the last finished frame and whether it is on the critical path
+	void WriteTimings(std::ostream&);
+
+private:
+	bool CreateFrames();
+	void Launch(int, int);
+	void RunStage(int, int);
+	void CollectTimings(int);
+	static void StageJob(void*, int, int);
+
+private:
+	JobSystemClass* m_jobs;
+	std::vector<StageType> m_stages;
+	std::unique_ptr<FrameType[]> m_frames;
+	int m_framesInFlight;
+	unsigned long long m_nextFrame;
+	unsigned long long m_collectedFrames;
+	std::mutex m_mutex;
+};
+
+#endif
@@ -2,11 +2,16 @@
 // Filename: textureclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "textureclass.h"
+#include "profilerclass.h"
+#include "hitchdetectorclass.h"
+#include <cstring>
 
 TextureClass::TextureClass()
 	: m_targaData(nullptr)
-	, m_texture(nullptr)
-	, m_textureView(nullptr)
+	, m_device(nullptr)
+	, m_texture(RENDER_NULL_HANDLE)
+	, m_width(0)
+	, m_height(0)
 {
 
 }
@@ -21,22 +26,36 @@ TextureClass::~TextureClass()
 }
 
 /*
-The Initialize functions take as input the Direct3D device and the name of the targa image file. 
-It will first load the targa data into an array. Then it will create a texture and load the targa data into it in the correct format (targa images are upside by default and need to be reversed). 
-Then once the texture is loaded it will create a resource view of the texture for the shader to use for drawing.
+The Initialize functions take as input the render device and the name of the targa image file. 
+It will first load the targa data into an array. Then it will have the device create a texture and load the targa data into it in the correct format (targa images are upside by default and need to be reversed). 
+The device also creates the resource view of the texture that the shader uses for drawing.
+The two halves are InitializeSoftware and InitializeDevice, so the targa can be decoded on any thread while the device is still busy.
 */
 
-bool TextureClass::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, char* filename)
+bool TextureClass::Initialize(RenderDeviceClass* device, const char* filename)
 {
 	bool result;
-	int height, width;
-	D3D11_TEXTURE2D_DESC textureDesc;
-	HRESULT hResult;
-	UINT rowPitch;
-	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
 
 	//first we call the TextureClass::LOadTarga to load the file data into the m_targaData array. This will also pass us
 	//back the height and width of the texture
+	result = InitializeSoftware(filename);
+	if (!result)
+	{
+		return false;
+	}
+
+	return InitializeDevice(device);
+}
+
+//InitializeSoftware only loads the targa data, there is no device to create a texture on when we render with the SoftwareRasterizerClass.
+
+bool TextureClass::InitializeSoftware(const char* filename)
+{
+	bool result;
+	int height, width;
+
+	//the targa data and the texture are the texture file's memory
+	MEMORY_SCOPE(MEMORY_TEXTURE, filename);
 
 	//load the targa image data into memory
 	result = this->LoadTarga(filename, height, width);
@@ -45,94 +64,98 @@ bool TextureClass::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceC
 		return false;
 	}
 
-	/*
-	Next we need to setup our description of the DX texture that we'll load the targa data into. We use the H & W from the data and
-	set the format to be 32 bit RGBA texsture.  finally we set the MipLevels, BindFlags, and MiscFlags to the settings required for Mipmaped textures.
-	Once the description is complete we call CreateTexture2D to create an empty texture for us. The next step will be to copy the targa data into that empty texture
-	*/
+	m_width = width;
+	m_height = height;
+	m_filename = filename;
 
-	// Setup the description of the texture.
-	textureDesc.Height = height;
-	textureDesc.Width = width;
-	textureDesc.MipLevels = 0;
-	textureDesc.ArraySize = 1;
-	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	textureDesc.SampleDesc.Count = 1;
-	textureDesc.SampleDesc.Quality = 0;
-	textureDesc.Usage = D3D11_USAGE_DEFAULT;
-	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
-	textureDesc.CPUAccessFlags = 0;
-	textureDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
-
-	//create the empty texture
-	hResult = device->CreateTexture2D(&textureDesc, NULL, (ID3D11Texture2D**)&m_texture);
-	if (FAILED(hResult))
+	return true;
+}
+
+bool TextureClass::InitializeDevice(RenderDeviceClass* device)
+{
+	RenderTextureDesc textureDesc;
+	unsigned int rowPitch;
+
+	if (!m_targaData)
 	{
 		return false;
 	}
 
+	MEMORY_SCOPE(MEMORY_TEXTURE, m_filename.c_str());
+
+	/*
+	Next we need to setup our description of the texture that we'll load the targa data into. We use the H & W from the data and
+	set the format to be 32 bit RGBA texsture. generateMips asks the device for the full mip chain, on D3D11 that is the MipLevels, BindFlags
+	and MiscFlags settings required for Mipmaped textures followed by a GenerateMips call once the data is in.
+	*/
+
+	// Setup the description of the texture.
+	memset(&textureDesc, 0, sizeof(textureDesc));
+	textureDesc.width = m_width;
+	textureDesc.height = m_height;
+	textureDesc.format = RENDER_FORMAT_R8G8B8A8_UNORM;
+	textureDesc.generateMips = true;
+
 	// Set the row pitch of the targa image data.
-	rowPitch = (width * 4) * sizeof(UCHAR);
+	rowPitch = (m_width * 4) * sizeof(unsigned char);
 
 	/*
-	Here we use UpdateSubresource to actually do the copying of the targa data array into the DirectX texture
+	The device copies the targa data array into the texture with UpdateSubresource.
 	using Map and Unmap is generally a lot quicker than using UpdateSubresource, however both loading methods have specific purposes and you need to choose correctly which one to use for performance reasons.
 	The recommendation is that you use Map and Unmap for data that is going to be reloaded each frame or on a very regular basis. And you should use UpdateSubresource for something that will be loaded once 
 	or that gets loaded rarely during loading sequences. The reason being is that UpdateSubresource puts the data into higher speed memory that gets cache retention preference since it knows you aren't 
 	going to remove or reload it anytime soon
 	*/
 
-	// Copy the targa image data into the texture.
-
-	deviceContext->UpdateSubresource(m_texture.get(), 0, NULL, m_targaData.get(), rowPitch, 0);
-
-	//after the texture is loaded we create a shader resource view which allows us to have a pointer to set the texture in shaders
-	//In the desciption we also set 2 important mipmap variables which will give us the full range of mipmap levels for HQ texture rendering at
-	//any distance. Once the SRV is created we call GenerateMips and it creates the maps 
-
-	// Setup the shader resource view description.
-	srvDesc.Format = textureDesc.Format;
-	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	srvDesc.Texture2D.MipLevels = -1;
-
-	// Create the shader resource view for the texture.
-	hResult = device->CreateShaderResourceView(m_texture.get(), &srvDesc, (ID3D11ShaderResourceView**)&m_textureView);
-	if (FAILED(hResult))
+	//create the texture, its shader resource view and its mipmaps
+	m_texture = device->CreateTexture2D(textureDesc, m_targaData.get(), rowPitch);
+	if (m_texture == RENDER_NULL_HANDLE)
 	{
 		return false;
 	}
 
-	// Generate mipmaps for this texture.
-	deviceContext->GenerateMips(m_textureView.get());
+	m_device = device;
 
-	// Release the targa image data now that the image data has been loaded into the texture.
 	return true;
 }
 
 void TextureClass::Shutdown()
 {
-	// Release the texture view resource.
-	if (m_textureView)
+	// Release the texture and its view.
+	if (m_device)
 	{
-		m_textureView->Release();
+		m_device->ReleaseResource(m_texture);
+		m_texture = RENDER_NULL_HANDLE;
+		m_device = nullptr;
 	}
 
-	// Release the texture.
-	if (m_texture)
-	{
-		m_texture->Release();
-	}
+	// Release the targa data.
+	m_targaData.reset();
 
 
 	return;
 }
 
-//GetTexture is a helper function to provide easy access to the texture view for any shaders that require it for rendering.
+//GetTexture is a helper function to provide easy access to the texture for any shaders that require it for rendering.
+
+RenderHandle TextureClass::GetTexture()
+{
+	return m_texture;
+}
+
+unsigned char* TextureClass::GetTargaData()
+{
+	return m_targaData.get();
+}
+
+int TextureClass::GetWidth()
+{
+	return m_width;
+}
 
-ID3D11ShaderResourceView* TextureClass::GetTexture()
+int TextureClass::GetHeight()
 {
-	return m_textureView.get();
+	return m_height;
 }
 
 /*
@@ -141,24 +164,26 @@ So here we will open the file, read it into an array, and then take that array d
 Note we are purposely only dealing with 32 bit targa files that have alpha channels, this function will reject targa's that are saved as 24 bit.
 */
 
-bool TextureClass::LoadTarga(char* filename, int& height, int& width)
+bool TextureClass::LoadTarga(const char* filename, int& height, int& width)
 {
-	int error, bpp, imageSize, index, i, j, k;
-	FILE* filePtr;
-	unsigned int count;
+	int bpp, imageSize, index, i, j, k;
+	std::ifstream fin;
 	TargaHeader targaFileHeader;
-	unsigned char* targaImage;
+	MemoryTrackerClass::ArrayType<unsigned char> targaImage;
+
+	PROFILE_SCOPE("TextureClass::LoadTarga");
+	TRACK_ACTIVITY("loading", filename);
 
 	// Open the targa file for reading in binary.
-	error = fopen_s(&filePtr, filename, "rb");
-	if (error != 0)
+	fin.open(filename, std::ios::binary);
+	if (fin.fail())
 	{
 		return false;
 	}
 
 	// Read in the file header.
-	count = (unsigned int)fread(&targaFileHeader, sizeof(TargaHeader), 1, filePtr);
-	if (count != 1)
+	fin.read((char*)&targaFileHeader, sizeof(TargaHeader));
+	if (fin.gcount() != sizeof(TargaHeader))
 	{
 		return false;
 	}
@@ -178,28 +203,24 @@ bool TextureClass::LoadTarga(char* filename, int& height, int& width)
 	imageSize = width * height * 4;
 
 	// Allocate memory for the targa image data.
-	targaImage = new unsigned char[imageSize];
+	targaImage = MemoryTrackerClass::NewArray<unsigned char>(imageSize);
 	if (!targaImage)
 	{
 		return false;
 	}
 
 	// Read in the targa image data.
-	count = (unsigned int)fread(targaImage, 1, imageSize, filePtr);
-	if (count != imageSize)
+	fin.read((char*)targaImage.get(), imageSize);
+	if (fin.gcount() != imageSize)
 	{
 		return false;
 	}
 
 	// Close the file.
-	error = fclose(filePtr);
-	if (error != 0)
-	{
-		return false;
-	}
+	fin.close();
 
 	// Allocate memory for the targa destination data.
-	m_targaData.reset(new UCHAR[imageSize]);
+	m_targaData = MemoryTrackerClass::NewArray<unsigned char>(imageSize);
 	if (!m_targaData)
 	{
 		return false;
@@ -231,10 +252,6 @@ bool TextureClass::LoadTarga(char* filename, int& height, int& width)
 		k -= (width * 8);
 	}
 
-	//release the targa image data memory
-	delete[] targaImage;
-	targaImage = nullptr;
-
 	return true;
 
 }
\ No newline at end of file
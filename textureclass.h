@@ -14,9 +14,11 @@
 //////////////
 // INCLUDES //
 //////////////
-#include <d3d11.h>
-#include <stdio.h>
+#include "renderdeviceclass.h"
+#include "memorytrackerclass.h"
+#include <fstream>
 #include <memory>
+#include <string>
 
 class TextureClass
 {
@@ -26,11 +28,11 @@ private:
 
 	struct TargaHeader
 	{
-		UCHAR data1[12];
-		USHORT width;
-		USHORT height;
-		UCHAR bpp;
-		UCHAR data2;
+		unsigned char data1[12];
+		unsigned short width;
+		unsigned short height;
+		unsigned char bpp;
+		unsigned char data2;
 	};
 
 public:
@@ -38,26 +40,39 @@ public:
 	TextureClass(const TextureClass&);
 	~TextureClass();
 
-	bool Initialize(ID3D11Device*, ID3D11DeviceContext*, char*);
+	bool Initialize(RenderDeviceClass*, const char*);
+	bool InitializeSoftware(const char*);
+
+	//creates the texture on the device from the data InitializeSoftware loaded, Initialize is the two in one go
+	bool InitializeDevice(RenderDeviceClass*);
 	void Shutdown();
 
-	ID3D11ShaderResourceView* GetTexture();
+	RenderHandle GetTexture();
+
+	//the software rasterizer has no use for a resource view, it samples the targa data we keep around directly
+	unsigned char* GetTargaData();
+	int GetWidth();
+	int GetHeight();
 
 private:
 	//Here we have our targa reading function.If you wanted to support more formats you would add reading functions here.
 
-	bool LoadTarga(char*, int&, int&);
+	bool LoadTarga(const char*, int&, int&);
 
 private:
 	/*
-	This class has three member variables. The first one holds the raw targa data read straight in from the file. 
-	The second variable called m_texture will hold the structured texture data that DirectX will use for rendering. 
-	And the third variable is the resource view that the shader uses to access the texture data when drawing.
+	The first member variable holds the raw targa data read straight in from the file, tracked as the texture's CPU memory. 
+	m_texture is the handle of the texture the render device created from it, the device keeps the resource view that the shader
+	uses to access the texture data next to the texture itself. m_device is the device it was created on so Shutdown can release it.
+	m_filename is the file the data came from, the texture on the device is counted as that file's memory.
 	*/
 
-	std::unique_ptr<UCHAR[]> m_targaData;
-	std::shared_ptr<ID3D11Texture2D> m_texture;
-	std::shared_ptr<ID3D11ShaderResourceView> m_textureView;
+	MemoryTrackerClass::ArrayType<unsigned char> m_targaData;
+	std::string m_filename;
+	RenderDeviceClass* m_device;
+	RenderHandle m_texture;
+	int m_width;
+	int m_height;
 
 };
 
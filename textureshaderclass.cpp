@@ -2,6 +2,7 @@
 // Filename: textureshaderclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "textureshaderclass.h"
+#include "profilerclass.h"
 
 
 TextureShaderClass::TextureShaderClass()
@@ -81,27 +82,34 @@ bool TextureShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 {
 	HRESULT result;
 
-	std::shared_ptr<ID3D10Blob> errorMessage(nullptr);
-	std::shared_ptr<ID3D10Blob> vertexShaderBuffer(nullptr);
-	std::shared_ptr<ID3D10Blob> pixelShaderBuffer(nullptr);
+	ID3D10Blob* errorMessage;
+	ID3D10Blob* vertexShaderBuffer;
+	ID3D10Blob* pixelShaderBuffer;
 	D3D11_INPUT_ELEMENT_DESC polygonLayout[2];
 	UINT numElements;
 	D3D11_BUFFER_DESC matrixBufferDesc;
 
 	D3D11_SAMPLER_DESC samplerDesc;
 
+	PROFILE_SCOPE("TextureShaderClass::InitializeShader");
+
+	// Initialize the pointers this function will use to null.
+	errorMessage = nullptr;
+	vertexShaderBuffer = nullptr;
+	pixelShaderBuffer = nullptr;
+
 	//here is where we compile the shader programs into buffers. We pass it the name of the file, the name of the shader, the shader version (5.0 in 11) and the buffer
 	//to compile the shader into. If it fails, we'll get an error in the error message string. 
 
 	//COMPILE THE VERTEX SHADER
-	result = D3DCompileFromFile(vsFilename, NULL, NULL, "TextureVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, (ID3D10Blob**)&vertexShaderBuffer, (ID3D10Blob**)&errorMessage);
+	result = D3DCompileFromFile(vsFilename, NULL, NULL, "TextureVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
 
 	if (FAILED(result))
 	{
 		// If the shader failed to compile it should have written something to the error message.
 		if (errorMessage)
 		{
-			OutputShaderErrorMessage(errorMessage.get(), hwnd, vsFilename);
+			OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
 		}
 		// If there was nothing in the error message then it simply could not find the shader file itself.
 		else
@@ -113,14 +121,14 @@ bool TextureShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	}
 
 	//COMPILE THE PIXEL SHADER
-	result = D3DCompileFromFile(psFilename, NULL, NULL, "TexturePixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, (ID3D10Blob**)&pixelShaderBuffer, (ID3D10Blob**)&errorMessage);
+	result = D3DCompileFromFile(psFilename, NULL, NULL, "TexturePixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &pixelShaderBuffer, &errorMessage);
 
 	if (FAILED(result))
 	{
 		// If the shader failed to compile it should have written something to the error message.
 		if (errorMessage)
 		{
-			OutputShaderErrorMessage(errorMessage.get(), hwnd, psFilename);
+			OutputShaderErrorMessage(errorMessage, hwnd, psFilename);
 		}
 		// If there was nothing in the error message then it simply could not find the shader file itself.
 		else
@@ -135,14 +143,14 @@ bool TextureShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	//We will use these pointers to interface with the vertex and pixel shader from this point forward.
 
 	//create the vertex shader from the buffer
-	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, (ID3D11VertexShader**)&m_vertexShader);
+	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &m_vertexShader);
 	if (FAILED(result))
 	{
 		return false;
 	}
 
 	// Create the pixel shader from the buffer.
-	result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, (ID3D11PixelShader**)&m_pixelShader);
+	result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &m_pixelShader);
 	if (FAILED(result))
 	{
 		return false;
@@ -176,7 +184,7 @@ bool TextureShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
 
 	//create the vertex input layout
-	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), (ID3D11InputLayout**)&m_layout);
+	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &m_layout);
 
 	if (FAILED(result))
 	{
@@ -200,7 +208,7 @@ bool TextureShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	matrixBufferDesc.StructureByteStride = 0;
 
 	//create the constant buffer pointer so we can access the vertex shader constant buffer from within this class
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, (ID3D11Buffer**)&m_matrixBuffer);
+	result = device->CreateBuffer(&matrixBufferDesc, NULL, &m_matrixBuffer);
 	if (FAILED(result))
 	{
 		return false;
@@ -230,7 +238,7 @@ bool TextureShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
 
 	// Create the texture sampler state.
-	result = device->CreateSamplerState(&samplerDesc, (ID3D11SamplerState**)&m_sampleState);
+	result = device->CreateSamplerState(&samplerDesc, &m_sampleState);
 
 	if (FAILED(result))
 	{
@@ -283,6 +291,8 @@ bool TextureShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext,
 	MatrixBufferType* dataPtr;
 	UINT bufferNumber;
 
+	PROFILE_SCOPE("TextureShaderClass::SetShaderParameters");
+
 	//Make sure to transpose matrices before sending them into the shader, this is a requirement for DirectX 11.
 	worldMatrix = XMMatrixTranspose(worldMatrix);
 	viewMatrix = XMMatrixTranspose(viewMatrix);
@@ -290,7 +300,7 @@ bool TextureShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext,
 
 	//Lock the m_matrixBuffer, set the new matrices inside it, and then unlock it.
 
-	result = deviceContext->Map(m_matrixBuffer.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	result = deviceContext->Map(m_matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 	if (FAILED(result))
 	{
 		return false;
@@ -306,7 +316,7 @@ bool TextureShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext,
 	dataPtr->projection = projectionMatrix;
 
 	//unlock the cbuffer
-	deviceContext->Unmap(m_matrixBuffer.get(), 0);
+	deviceContext->Unmap(m_matrixBuffer, 0);
 
 	//now set the updated matrix in the HLSL vertex shader
 
@@ -314,7 +324,7 @@ bool TextureShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext,
 	bufferNumber = 0;
 
 	//finally set the cbuffer in the vertex shader with updated values
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, (ID3D11Buffer**)&m_matrixBuffer);
+	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_matrixBuffer);
 
 	// Set shader texture resource in the pixel shader.
 	deviceContext->PSSetShaderResources(0, 1, &texture);
@@ -335,14 +345,14 @@ Once the shaders are set we render the triangle by calling the DrawIndexed Direc
 void TextureShaderClass::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(m_layout.get());
+	deviceContext->IASetInputLayout(m_layout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(m_vertexShader.get(), NULL, 0);
-	deviceContext->PSSetShader(m_pixelShader.get(), NULL, 0);
+	deviceContext->VSSetShader(m_vertexShader, NULL, 0);
+	deviceContext->PSSetShader(m_pixelShader, NULL, 0);
 
 	//The RenderShader function has been changed to include setting the sample state in the pixel shader before rendering.
-	deviceContext->PSSetSamplers(0, 1, (ID3D11SamplerState**)&m_sampleState);
+	deviceContext->PSSetSamplers(0, 1, &m_sampleState);
 
 	//draw tri
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -53,12 +53,12 @@ private:
 	void ConvertMatrixType(const DirectX::XMFLOAT4X4&, DirectX::XMMATRIX&);
 
 private:
-	std::shared_ptr<ID3D11VertexShader> m_vertexShader;
-	std::shared_ptr<ID3D11PixelShader> m_pixelShader;
-	std::shared_ptr<ID3D11InputLayout> m_layout;
-	std::shared_ptr<ID3D11Buffer> m_matrixBuffer;
+	ID3D11VertexShader* m_vertexShader;
+	ID3D11PixelShader* m_pixelShader;
+	ID3D11InputLayout* m_layout;
+	ID3D11Buffer* m_matrixBuffer;
 
-	std::shared_ptr<ID3D11SamplerState> m_sampleState;
+	ID3D11SamplerState* m_sampleState;
 
 };
 